@@ -23,6 +23,8 @@ void            gdk_window_thaw_toplevel_updates        (GdkWindow *window);
 
 gboolean        gdk_window_supports_edge_constraints    (GdkWindow *window);
 
+cairo_region_t *gdk_window_get_expose_area              (GdkWindow *window);
+
 GdkRenderingMode gdk_display_get_rendering_mode (GdkDisplay       *display);
 void             gdk_display_set_rendering_mode (GdkDisplay       *display,
                                                  GdkRenderingMode  mode);
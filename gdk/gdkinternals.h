@@ -220,6 +220,10 @@ struct _GdkWindow
      started. It may be smaller than the expose area if we'e painting
      more than we have to, but it represents the "true" damage. */
   cairo_region_t *active_update_area;
+  /* The part of the update area that was exposed by the native window
+     system, as opposed to being invalidated by the application. */
+  cairo_region_t *expose_area;
+  cairo_region_t *active_expose_area;
   /* We store the old expose areas to support buffer-age optimizations */
   cairo_region_t *old_updated_area[2];
 
@@ -2781,6 +2781,8 @@ gdk_window_process_updates_internal (GdkWindow *window)
 
       window->active_update_area = window->update_area;
       window->update_area = NULL;
+      window->active_expose_area = window->expose_area;
+      window->expose_area = NULL;
 
       if (gdk_window_is_viewable (window))
 	{
@@ -2805,6 +2807,7 @@ gdk_window_process_updates_internal (GdkWindow *window)
 
       cairo_region_destroy (window->active_update_area);
       window->active_update_area = NULL;
+      g_clear_pointer (&window->active_expose_area, cairo_region_destroy);
     }
 
   window->in_update = FALSE;
@@ -3051,11 +3054,49 @@ void
 _gdk_window_invalidate_for_expose (GdkWindow       *window,
 				   cairo_region_t       *region)
 {
+  GdkWindow *impl_window = gdk_window_get_impl_window (window);
+  cairo_region_t *expose_region;
+
+  expose_region = cairo_region_copy (region);
+  cairo_region_translate (expose_region,
+                          window->abs_x - impl_window->abs_x,
+                          window->abs_y - impl_window->abs_y);
+  if (impl_window->expose_area)
+    {
+      cairo_region_union (impl_window->expose_area, expose_region);
+      cairo_region_destroy (expose_region);
+    }
+  else
+    impl_window->expose_area = expose_region;
+
   gdk_window_invalidate_maybe_recurse_full (window, region,
 					    (gboolean (*) (GdkWindow *, gpointer))gdk_window_has_no_impl,
 					    NULL);
 }
 
+/*< private >
+ * gdk_window_get_expose_area:
+ * @window: a native #GdkWindow
+ *
+ * Gets the part of the update area that is currently being processed
+ * which was exposed by the native window system, rather than being
+ * invalidated with gdk_window_invalidate_region().
+ *
+ * The native window system does not keep the contents of that area,
+ * so it must always be repainted, even if nothing in it changed.
+ *
+ * This is only valid while an update is being processed.
+ *
+ * Returns: (transfer none) (nullable): the exposed area or %NULL
+ **/
+cairo_region_t *
+gdk_window_get_expose_area (GdkWindow *window)
+{
+  g_return_val_if_fail (GDK_IS_WINDOW (window), NULL);
+
+  return gdk_window_get_impl_window (window)->active_expose_area;
+}
+
 
 /**
  * gdk_window_get_update_area:
@@ -3144,6 +3185,8 @@ _gdk_window_clear_update_area (GdkWindow *window)
       cairo_region_destroy (window->update_area);
       window->update_area = NULL;
     }
+
+  g_clear_pointer (&window->expose_area, cairo_region_destroy);
 }
 
 /**
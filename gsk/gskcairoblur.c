@@ -185,6 +185,530 @@ flip_buffer (guchar *dst_buffer,
 #undef BLOCK_SIZE
 }
 
+/* Blurring whole lines at once
+ *
+ * The functions above blur one line at a time, which leaves a single
+ * running sum per line and a division per pixel. The code below instead
+ * runs the sliding window over many lines ("lanes") in parallel, so the
+ * sums of neighbouring lines sit next to each other in memory and can be
+ * updated with vector instructions.
+ *
+ * For the vertical pass, the lines are the columns of the image, which
+ * are interleaved in memory already. For the horizontal pass, a strip of
+ * rows is transposed into a temporary buffer first, blurred the same way
+ * and transposed back. Only a strip at a time is flipped, so it stays in
+ * the cache.
+ *
+ * The divisions are done as multiplications with a fixed point reciprocal,
+ * (x * ceil (2^32 / d)) >> 32. This is exact for all x < 2^32 / d, and
+ * x is at most 256 * d, so it works for d < 4096; larger filters use the
+ * code above. The results are identical to those of blur_rows().
+ */
+
+#define BOX_BLUR_MAX_D 4096
+
+#if (defined (__x86_64__) || defined (__i386__)) && \
+    (defined (__clang__) || (defined (__GNUC__) && __GNUC__ >= 5))
+#define HAVE_X86_BLUR_KERNELS 1
+#include <immintrin.h>
+#endif
+
+typedef void (* BlurLinesFunc) (guchar       *dst,
+                                const guchar *src,
+                                int           length,
+                                int           lanes,
+                                int           stride,
+                                int           d,
+                                int           offset,
+                                guint32      *sums);
+typedef void (* TransposeFunc) (guchar       *dst,
+                                int           dst_stride,
+                                const guchar *src,
+                                int           src_stride,
+                                int           n_rows,
+                                int           n_cols);
+
+typedef struct {
+  const char *name;
+  /* number of rows blurred together in the horizontal pass */
+  int strip_height;
+  gboolean (* supported) (void);
+  BlurLinesFunc blur_lines;
+  TransposeFunc transpose;
+} BlurKernels;
+
+static inline void
+blur_step_portable (guint32      *sums,
+                    const guchar *add,
+                    const guchar *sub,
+                    guchar       *store,
+                    int           lanes,
+                    guint32       half,
+                    guint32       multiplier)
+{
+  int l;
+
+  if (add)
+    for (l = 0; l < lanes; l++)
+      sums[l] += add[l];
+
+  if (sub)
+    for (l = 0; l < lanes; l++)
+      sums[l] -= sub[l];
+
+  if (store)
+    for (l = 0; l < lanes; l++)
+      store[l] = ((guint64) (sums[l] + half) * multiplier) >> 32;
+}
+
+/* One box blur pass over @lanes lines of @length pixels each, where pixel
+ * i of line l is at src[i * stride + l]. This does the same as
+ * blur_xspan() for every line.
+ */
+#define DEFINE_BLUR_LINES(name, step, attributes) \
+attributes static void \
+name (guchar       *dst, \
+      const guchar *src, \
+      int           length, \
+      int           lanes, \
+      int           stride, \
+      int           d, \
+      int           offset, \
+      guint32      *sums) \
+{ \
+  guint32 multiplier = ((G_GUINT64_CONSTANT (1) << 32) + d - 1) / d; \
+  int i; \
+\
+  memset (sums, 0, lanes * sizeof (guint32)); \
+\
+  for (i = 0; i < length + offset; i++) \
+    { \
+      step (sums, \
+            i < length ? src + i * stride : NULL, \
+            i >= d ? src + (i - d) * stride : NULL, \
+            i >= offset ? dst + (i - offset) * stride : NULL, \
+            lanes, d / 2, multiplier); \
+    } \
+}
+
+DEFINE_BLUR_LINES (blur_lines_portable, blur_step_portable, )
+
+static void
+transpose_portable (guchar       *dst,
+                    int           dst_stride,
+                    const guchar *src,
+                    int           src_stride,
+                    int           n_rows,
+                    int           n_cols)
+{
+  /* Same blocking as flip_buffer() */
+#define BLOCK_SIZE 16
+  int r0, c0, r, c;
+
+  for (r0 = 0; r0 < n_rows; r0 += BLOCK_SIZE)
+    for (c0 = 0; c0 < n_cols; c0 += BLOCK_SIZE)
+      {
+        int max_r = MIN (r0 + BLOCK_SIZE, n_rows);
+        int max_c = MIN (c0 + BLOCK_SIZE, n_cols);
+
+        for (r = r0; r < max_r; r++)
+          for (c = c0; c < max_c; c++)
+            dst[c * dst_stride + r] = src[r * src_stride + c];
+      }
+#undef BLOCK_SIZE
+}
+
+static gboolean
+portable_supported (void)
+{
+  return TRUE;
+}
+
+#ifdef HAVE_X86_BLUR_KERNELS
+
+#define SSE2_ATTRIBUTES __attribute__((target ("sse2")))
+#define AVX2_ATTRIBUTES __attribute__((target ("avx2")))
+
+/* Divides the 4 sums in @x by d, see above */
+SSE2_ATTRIBUTES static inline __m128i
+divide_sse2 (__m128i x,
+             __m128i multiplier)
+{
+  __m128i even, odd;
+
+  even = _mm_srli_epi64 (_mm_mul_epu32 (x, multiplier), 32);
+  odd = _mm_mul_epu32 (_mm_srli_epi64 (x, 32), multiplier);
+
+  return _mm_or_si128 (even, _mm_and_si128 (odd, _mm_set_epi32 (-1, 0, -1, 0)));
+}
+
+SSE2_ATTRIBUTES static inline void
+blur_step_sse2 (guint32      *sums,
+                const guchar *add,
+                const guchar *sub,
+                guchar       *store,
+                int           lanes,
+                guint32       half,
+                guint32       multiplier)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i vhalf = _mm_set1_epi32 (half);
+  const __m128i vmultiplier = _mm_set1_epi32 (multiplier);
+  int l;
+
+  for (l = 0; l + 16 <= lanes; l += 16)
+    {
+      __m128i s0, s1, s2, s3, lo, hi;
+
+      s0 = _mm_loadu_si128 ((const __m128i *) (sums + l));
+      s1 = _mm_loadu_si128 ((const __m128i *) (sums + l + 4));
+      s2 = _mm_loadu_si128 ((const __m128i *) (sums + l + 8));
+      s3 = _mm_loadu_si128 ((const __m128i *) (sums + l + 12));
+
+      if (add)
+        {
+          __m128i a = _mm_loadu_si128 ((const __m128i *) (add + l));
+
+          lo = _mm_unpacklo_epi8 (a, zero);
+          hi = _mm_unpackhi_epi8 (a, zero);
+          s0 = _mm_add_epi32 (s0, _mm_unpacklo_epi16 (lo, zero));
+          s1 = _mm_add_epi32 (s1, _mm_unpackhi_epi16 (lo, zero));
+          s2 = _mm_add_epi32 (s2, _mm_unpacklo_epi16 (hi, zero));
+          s3 = _mm_add_epi32 (s3, _mm_unpackhi_epi16 (hi, zero));
+        }
+
+      if (sub)
+        {
+          __m128i s = _mm_loadu_si128 ((const __m128i *) (sub + l));
+
+          lo = _mm_unpacklo_epi8 (s, zero);
+          hi = _mm_unpackhi_epi8 (s, zero);
+          s0 = _mm_sub_epi32 (s0, _mm_unpacklo_epi16 (lo, zero));
+          s1 = _mm_sub_epi32 (s1, _mm_unpackhi_epi16 (lo, zero));
+          s2 = _mm_sub_epi32 (s2, _mm_unpacklo_epi16 (hi, zero));
+          s3 = _mm_sub_epi32 (s3, _mm_unpackhi_epi16 (hi, zero));
+        }
+
+      _mm_storeu_si128 ((__m128i *) (sums + l), s0);
+      _mm_storeu_si128 ((__m128i *) (sums + l + 4), s1);
+      _mm_storeu_si128 ((__m128i *) (sums + l + 8), s2);
+      _mm_storeu_si128 ((__m128i *) (sums + l + 12), s3);
+
+      if (store)
+        {
+          /* The results are at most 255, so saturating packs are fine */
+          s0 = divide_sse2 (_mm_add_epi32 (s0, vhalf), vmultiplier);
+          s1 = divide_sse2 (_mm_add_epi32 (s1, vhalf), vmultiplier);
+          s2 = divide_sse2 (_mm_add_epi32 (s2, vhalf), vmultiplier);
+          s3 = divide_sse2 (_mm_add_epi32 (s3, vhalf), vmultiplier);
+
+          _mm_storeu_si128 ((__m128i *) (store + l),
+                            _mm_packus_epi16 (_mm_packs_epi32 (s0, s1),
+                                              _mm_packs_epi32 (s2, s3)));
+        }
+    }
+
+  if (l < lanes)
+    blur_step_portable (sums + l,
+                        add ? add + l : NULL,
+                        sub ? sub + l : NULL,
+                        store ? store + l : NULL,
+                        lanes - l, half, multiplier);
+}
+
+DEFINE_BLUR_LINES (blur_lines_sse2, blur_step_sse2, SSE2_ATTRIBUTES)
+
+/* Transposes 16x16 bytes. Interleaving row i with row i + 8 four times
+ * moves every byte to its transposed position. */
+SSE2_ATTRIBUTES static inline void
+transpose_16x16_sse2 (guchar       *dst,
+                      int           dst_stride,
+                      const guchar *src,
+                      int           src_stride)
+{
+  __m128i a[16], b[16];
+  int i, round;
+
+  for (i = 0; i < 16; i++)
+    a[i] = _mm_loadu_si128 ((const __m128i *) (src + i * src_stride));
+
+  for (round = 0; round < 4; round += 2)
+    {
+      for (i = 0; i < 8; i++)
+        {
+          b[2 * i] = _mm_unpacklo_epi8 (a[i], a[i + 8]);
+          b[2 * i + 1] = _mm_unpackhi_epi8 (a[i], a[i + 8]);
+        }
+      for (i = 0; i < 8; i++)
+        {
+          a[2 * i] = _mm_unpacklo_epi8 (b[i], b[i + 8]);
+          a[2 * i + 1] = _mm_unpackhi_epi8 (b[i], b[i + 8]);
+        }
+    }
+
+  for (i = 0; i < 16; i++)
+    _mm_storeu_si128 ((__m128i *) (dst + i * dst_stride), a[i]);
+}
+
+SSE2_ATTRIBUTES static void
+transpose_sse2 (guchar       *dst,
+                int           dst_stride,
+                const guchar *src,
+                int           src_stride,
+                int           n_rows,
+                int           n_cols)
+{
+  int full_rows = n_rows & ~15;
+  int full_cols = n_cols & ~15;
+  int r0, c0;
+
+  for (r0 = 0; r0 < full_rows; r0 += 16)
+    for (c0 = 0; c0 < full_cols; c0 += 16)
+      transpose_16x16_sse2 (dst + c0 * dst_stride + r0, dst_stride,
+                            src + r0 * src_stride + c0, src_stride);
+
+  /* the ragged right and bottom edges */
+  if (full_cols < n_cols)
+    transpose_portable (dst + full_cols * dst_stride, dst_stride,
+                        src + full_cols, src_stride,
+                        full_rows, n_cols - full_cols);
+  if (full_rows < n_rows)
+    transpose_portable (dst + full_rows, dst_stride,
+                        src + full_rows * src_stride, src_stride,
+                        n_rows - full_rows, n_cols);
+}
+
+static gboolean
+sse2_supported (void)
+{
+  return __builtin_cpu_supports ("sse2");
+}
+
+/* Divides the 8 sums in @x by d, see above */
+AVX2_ATTRIBUTES static inline __m256i
+divide_avx2 (__m256i x,
+             __m256i multiplier)
+{
+  __m256i even, odd;
+
+  even = _mm256_srli_epi64 (_mm256_mul_epu32 (x, multiplier), 32);
+  odd = _mm256_mul_epu32 (_mm256_srli_epi64 (x, 32), multiplier);
+
+  return _mm256_blend_epi32 (even, odd, 0xaa);
+}
+
+AVX2_ATTRIBUTES static inline void
+blur_step_avx2 (guint32      *sums,
+                const guchar *add,
+                const guchar *sub,
+                guchar       *store,
+                int           lanes,
+                guint32       half,
+                guint32       multiplier)
+{
+  const __m256i vhalf = _mm256_set1_epi32 (half);
+  const __m256i vmultiplier = _mm256_set1_epi32 (multiplier);
+  /* undoes the in-lane interleaving of the packs below */
+  const __m256i permutation = _mm256_setr_epi32 (0, 4, 1, 5, 2, 6, 3, 7);
+  int l, k;
+
+  for (l = 0; l + 32 <= lanes; l += 32)
+    {
+      __m256i s[4];
+
+      for (k = 0; k < 4; k++)
+        {
+          s[k] = _mm256_loadu_si256 ((const __m256i *) (sums + l + 8 * k));
+          if (add)
+            s[k] = _mm256_add_epi32 (s[k], _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (add + l + 8 * k))));
+          if (sub)
+            s[k] = _mm256_sub_epi32 (s[k], _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (sub + l + 8 * k))));
+          _mm256_storeu_si256 ((__m256i *) (sums + l + 8 * k), s[k]);
+        }
+
+      if (store)
+        {
+          __m256i packed;
+
+          for (k = 0; k < 4; k++)
+            s[k] = divide_avx2 (_mm256_add_epi32 (s[k], vhalf), vmultiplier);
+
+          packed = _mm256_packus_epi16 (_mm256_packs_epi32 (s[0], s[1]),
+                                        _mm256_packs_epi32 (s[2], s[3]));
+          _mm256_storeu_si256 ((__m256i *) (store + l),
+                               _mm256_permutevar8x32_epi32 (packed, permutation));
+        }
+    }
+
+  if (l < lanes)
+    blur_step_sse2 (sums + l,
+                    add ? add + l : NULL,
+                    sub ? sub + l : NULL,
+                    store ? store + l : NULL,
+                    lanes - l, half, multiplier);
+}
+
+DEFINE_BLUR_LINES (blur_lines_avx2, blur_step_avx2, AVX2_ATTRIBUTES)
+
+static gboolean
+avx2_supported (void)
+{
+  return __builtin_cpu_supports ("avx2");
+}
+
+#endif /* HAVE_X86_BLUR_KERNELS */
+
+/* In order of preference */
+static const BlurKernels blur_kernels[] = {
+#ifdef HAVE_X86_BLUR_KERNELS
+  { "avx2", 32, avx2_supported, blur_lines_avx2, transpose_sse2 },
+  { "sse2", 16, sse2_supported, blur_lines_sse2, transpose_sse2 },
+#endif
+  { "portable", 16, portable_supported, blur_lines_portable, transpose_portable },
+  /* blur_rows() and flip_buffer() */
+  { "scalar", 0, portable_supported, NULL, NULL }
+};
+
+static const BlurKernels *selected_kernels;
+
+static const BlurKernels *
+get_blur_kernels (void)
+{
+  const BlurKernels *kernels = g_atomic_pointer_get (&selected_kernels);
+
+  if (G_UNLIKELY (kernels == NULL))
+    {
+      guint i;
+
+      for (i = 0; i < G_N_ELEMENTS (blur_kernels); i++)
+        {
+          if (blur_kernels[i].supported ())
+            break;
+        }
+
+      kernels = &blur_kernels[i];
+      g_atomic_pointer_set (&selected_kernels, kernels);
+    }
+
+  return kernels;
+}
+
+/*<private>
+ * gsk_cairo_blur_set_implementation:
+ * @name: "avx2", "sse2", "portable" or "scalar"
+ *
+ * Makes all further blurs use the given implementation, if the
+ * CPU supports it. By default, the fastest supported one is used.
+ * This is meant for testing and benchmarking.
+ *
+ * Returns: %TRUE if the implementation is available
+ */
+gboolean
+gsk_cairo_blur_set_implementation (const char *name)
+{
+  guint i;
+
+  g_return_val_if_fail (name != NULL, FALSE);
+
+  for (i = 0; i < G_N_ELEMENTS (blur_kernels); i++)
+    {
+      if (g_str_equal (blur_kernels[i].name, name) &&
+          blur_kernels[i].supported ())
+        {
+          g_atomic_pointer_set (&selected_kernels, &blur_kernels[i]);
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/*<private>
+ * gsk_cairo_blur_get_implementation:
+ *
+ * Returns: the name of the blur implementation in use
+ */
+const char *
+gsk_cairo_blur_get_implementation (void)
+{
+  return get_blur_kernels ()->name;
+}
+
+/* The three passes of blur_rows(), on lines laid out as described
+ * for DEFINE_BLUR_LINES. The result ends up in @tmp_buffer. */
+static void
+blur_lines_triple (const BlurKernels *kernels,
+                   guchar            *buffer,
+                   guchar            *tmp_buffer,
+                   int                length,
+                   int                lanes,
+                   int                stride,
+                   int                d,
+                   guint32           *sums)
+{
+  if (d % 2 == 1)
+    {
+      kernels->blur_lines (tmp_buffer, buffer, length, lanes, stride, d, d / 2, sums);
+      kernels->blur_lines (buffer, tmp_buffer, length, lanes, stride, d, d / 2, sums);
+      kernels->blur_lines (tmp_buffer, buffer, length, lanes, stride, d, d / 2, sums);
+    }
+  else
+    {
+      kernels->blur_lines (tmp_buffer, buffer, length, lanes, stride, d, (d - 1) / 2, sums);
+      kernels->blur_lines (buffer, tmp_buffer, length, lanes, stride, d, (d + 1) / 2, sums);
+      kernels->blur_lines (tmp_buffer, buffer, length, lanes, stride, d + 1, (d + 1) / 2, sums);
+    }
+}
+
+static void
+blur_columns_simd (const BlurKernels *kernels,
+                   guchar            *buffer,
+                   int                width,
+                   int                height,
+                   int                d)
+{
+  guchar *tmp_buffer;
+  guint32 *sums;
+
+  tmp_buffer = g_malloc (width * height);
+  sums = g_new (guint32, width);
+
+  blur_lines_triple (kernels, buffer, tmp_buffer, height, width, width, d, sums);
+  memcpy (buffer, tmp_buffer, width * height);
+
+  g_free (sums);
+  g_free (tmp_buffer);
+}
+
+static void
+blur_rows_simd (const BlurKernels *kernels,
+                guchar            *buffer,
+                int                width,
+                int                height,
+                int                d)
+{
+  guchar *strip, *tmp_strip;
+  guint32 *sums;
+  int y, rows;
+
+  strip = g_malloc (width * kernels->strip_height);
+  tmp_strip = g_malloc (width * kernels->strip_height);
+  sums = g_new (guint32, kernels->strip_height);
+
+  for (y = 0; y < height; y += rows)
+    {
+      rows = MIN (kernels->strip_height, height - y);
+
+      kernels->transpose (strip, rows, buffer + y * width, width, rows, width);
+      blur_lines_triple (kernels, strip, tmp_strip, width, rows, rows, d, sums);
+      kernels->transpose (buffer + y * width, width, tmp_strip, rows, width, rows);
+    }
+
+  g_free (sums);
+  g_free (tmp_strip);
+  g_free (strip);
+}
+
 static void
 _boxblur (guchar      *buffer,
           int          width,
@@ -192,9 +716,21 @@ _boxblur (guchar      *buffer,
           int          radius,
           GskBlurFlags flags)
 {
+  const BlurKernels *kernels = get_blur_kernels ();
   guchar *flipped_buffer;
   int d = get_box_filter_size (radius);
 
+  if (kernels->blur_lines != NULL && d + 1 < BOX_BLUR_MAX_D)
+    {
+      if (flags & GSK_BLUR_Y)
+        blur_columns_simd (kernels, buffer, width, height, d);
+
+      if (flags & GSK_BLUR_X)
+        blur_rows_simd (kernels, buffer, width, height, d);
+
+      return;
+    }
+
   flipped_buffer = g_malloc (width * height);
 
   if (flags & GSK_BLUR_Y)
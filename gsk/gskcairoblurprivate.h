@@ -49,6 +49,9 @@ cairo_t *       gsk_cairo_blur_finish_drawing   (cairo_t         *cr,
                                                  const GdkRGBA   *color,
                                                  GskBlurFlags     blur_flags);
 
+gboolean        gsk_cairo_blur_set_implementation (const char    *name);
+const char *    gsk_cairo_blur_get_implementation (void);
+
 G_END_DECLS
 
 #endif /* _GSK_CAIRO_BLUR_H */
@@ -5,9 +5,22 @@
 #include "gskdebugprivate.h"
 #include "gskrendererprivate.h"
 #include "gskrendernodeprivate.h"
+#include "gskshadowcacheprivate.h"
 #include "gsktextureprivate.h"
 
+#include <math.h>
+
+/* Size of the tiles in tiled mode, in application pixels */
+#define TILE_SIZE 256
+
 #ifdef G_ENABLE_DEBUG
+typedef struct {
+  GQuark tiles;
+  GQuark shadow_cache_hits;
+  GQuark shadow_cache_misses;
+  GQuark shadow_cache_size;
+} ProfileCounters;
+
 typedef struct {
   GQuark cpu_time;
   GQuark gpu_time;
@@ -18,7 +31,10 @@ struct _GskCairoRenderer
 {
   GskRenderer parent_instance;
 
+  gboolean tiled;
+
 #ifdef G_ENABLE_DEBUG
+  ProfileCounters profile_counters;
   ProfileTimers profile_timers;
 #endif
 };
@@ -30,6 +46,205 @@ struct _GskCairoRendererClass
 
 G_DEFINE_TYPE (GskCairoRenderer, gsk_cairo_renderer, GSK_TYPE_RENDERER)
 
+enum {
+  PROP_0,
+  PROP_TILED,
+
+  N_PROPS
+};
+
+static GParamSpec *gsk_cairo_renderer_properties[N_PROPS];
+
+typedef struct {
+  GMutex lock;
+  GCond cond;
+  guint n_pending;
+} TileBatch;
+
+typedef struct {
+  TileBatch *batch;
+  GskRenderNode *root;
+  cairo_rectangle_int_t area;
+  double scale_x;
+  double scale_y;
+  cairo_surface_t *surface;
+} Tile;
+
+static void
+gsk_cairo_renderer_draw_tile (gpointer data,
+                              gpointer user_data)
+{
+  Tile *tile = data;
+  TileBatch *batch = tile->batch;
+  cairo_t *cr;
+
+  tile->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                              ceil (tile->area.width * tile->scale_x),
+                                              ceil (tile->area.height * tile->scale_y));
+  cairo_surface_set_device_scale (tile->surface, tile->scale_x, tile->scale_y);
+
+  cr = cairo_create (tile->surface);
+  cairo_translate (cr, - tile->area.x, - tile->area.y);
+  cairo_rectangle (cr, tile->area.x, tile->area.y, tile->area.width, tile->area.height);
+  cairo_clip (cr);
+
+  gsk_render_node_draw (tile->root, cr);
+
+  cairo_destroy (cr);
+
+  g_mutex_lock (&batch->lock);
+  batch->n_pending--;
+  if (batch->n_pending == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->lock);
+}
+
+static GThreadPool *
+gsk_cairo_renderer_get_tile_pool (void)
+{
+  static GThreadPool *pool;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (gsk_cairo_renderer_draw_tile,
+                                    NULL,
+                                    g_get_num_processors (),
+                                    FALSE,
+                                    NULL);
+
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  return pool;
+}
+
+/* Splits the area of @cr that needs drawing into tiles, draws each of
+ * them into an image surface on the tile pool, and composites the
+ * results. Returns %FALSE if @cr cannot be drawn in tiles, because
+ * tiles would not line up with device pixels.
+ */
+static gboolean
+gsk_cairo_renderer_draw_tiled (GskRenderer   *renderer,
+                               cairo_t       *cr,
+                               GskRenderNode *root)
+{
+  cairo_rectangle_list_t *rects;
+  cairo_region_t *region;
+  cairo_rectangle_int_t extents;
+  cairo_matrix_t ctm;
+  graphene_rect_t clip, bounds;
+  double x1, y1, x2, y2;
+  double scale_x, scale_y;
+  TileBatch batch;
+  GArray *tiles;
+  GThreadPool *pool;
+  int x, y, j;
+  guint i;
+
+  cairo_get_matrix (cr, &ctm);
+  cairo_surface_get_device_scale (cairo_get_target (cr), &scale_x, &scale_y);
+  if (ctm.xx != 1.0 || ctm.yy != 1.0 || ctm.xy != 0.0 || ctm.yx != 0.0 ||
+      ctm.x0 * scale_x != floor (ctm.x0 * scale_x) ||
+      ctm.y0 * scale_y != floor (ctm.y0 * scale_y) ||
+      scale_x != floor (scale_x) || scale_y != floor (scale_y))
+    return FALSE;
+
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  graphene_rect_init (&clip, x1, y1, x2 - x1, y2 - y1);
+  gsk_render_node_get_bounds (root, &bounds);
+  if (!graphene_rect_intersection (&clip, &bounds, &clip))
+    return TRUE;
+
+  gsk_rect_to_cairo_grow (&clip, &extents);
+
+  region = cairo_region_create ();
+  rects = cairo_copy_clip_rectangle_list (cr);
+  if (rects->status == CAIRO_STATUS_SUCCESS)
+    {
+      for (j = 0; j < rects->num_rectangles; j++)
+        {
+          cairo_rectangle_int_t rect;
+
+          gsk_rect_to_cairo_grow (&GRAPHENE_RECT_INIT (rects->rectangles[j].x,
+                                                       rects->rectangles[j].y,
+                                                       rects->rectangles[j].width,
+                                                       rects->rectangles[j].height),
+                                  &rect);
+          cairo_region_union_rectangle (region, &rect);
+        }
+    }
+  else
+    {
+      cairo_region_union_rectangle (region, &extents);
+    }
+  cairo_rectangle_list_destroy (rects);
+
+  tiles = g_array_new (FALSE, FALSE, sizeof (Tile));
+  for (y = extents.y; y < extents.y + extents.height; y += TILE_SIZE)
+    {
+      for (x = extents.x; x < extents.x + extents.width; x += TILE_SIZE)
+        {
+          Tile tile = { &batch, root, { x, y, TILE_SIZE, TILE_SIZE }, scale_x, scale_y, NULL };
+
+          tile.area.width = MIN (TILE_SIZE, extents.x + extents.width - x);
+          tile.area.height = MIN (TILE_SIZE, extents.y + extents.height - y);
+
+          if (cairo_region_contains_rectangle (region, &tile.area) == CAIRO_REGION_OVERLAP_OUT)
+            continue;
+
+          g_array_append_val (tiles, tile);
+        }
+    }
+  cairo_region_destroy (region);
+
+  if (tiles->len < 2)
+    {
+      g_array_free (tiles, TRUE);
+      return FALSE;
+    }
+
+  g_mutex_init (&batch.lock);
+  g_cond_init (&batch.cond);
+  batch.n_pending = tiles->len;
+
+  pool = gsk_cairo_renderer_get_tile_pool ();
+  for (i = 0; i < tiles->len; i++)
+    g_thread_pool_push (pool, &g_array_index (tiles, Tile, i), NULL);
+
+  g_mutex_lock (&batch.lock);
+  while (batch.n_pending > 0)
+    g_cond_wait (&batch.cond, &batch.lock);
+  g_mutex_unlock (&batch.lock);
+
+  g_mutex_clear (&batch.lock);
+  g_cond_clear (&batch.cond);
+
+  for (i = 0; i < tiles->len; i++)
+    {
+      Tile *tile = &g_array_index (tiles, Tile, i);
+
+      cairo_save (cr);
+      cairo_set_source_surface (cr, tile->surface, tile->area.x, tile->area.y);
+      cairo_rectangle (cr, tile->area.x, tile->area.y, tile->area.width, tile->area.height);
+      cairo_fill (cr);
+      cairo_restore (cr);
+
+      cairo_surface_destroy (tile->surface);
+    }
+
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_set (gsk_renderer_get_profiler (renderer),
+                            GSK_CAIRO_RENDERER (renderer)->profile_counters.tiles,
+                            tiles->len);
+#endif
+
+  g_array_free (tiles, TRUE);
+
+  return TRUE;
+}
+
 static gboolean
 gsk_cairo_renderer_realize (GskRenderer  *renderer,
                             GdkWindow    *window,
@@ -53,19 +268,31 @@ gsk_cairo_renderer_do_render (GskRenderer   *renderer,
   GskCairoRenderer *self = GSK_CAIRO_RENDERER (renderer);
   GskProfiler *profiler;
   gint64 cpu_time;
+  guint64 hits, misses, start_hits, start_misses;
+  gsize cache_size;
 #endif
 
 #ifdef G_ENABLE_DEBUG
   profiler = gsk_renderer_get_profiler (renderer);
   gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
+  gsk_shadow_cache_get_statistics (&start_hits, &start_misses, NULL);
 #endif
 
-  gsk_render_node_draw (root, cr);
+  if (!GSK_CAIRO_RENDERER (renderer)->tiled ||
+      !gsk_cairo_renderer_draw_tiled (renderer, cr, root))
+    gsk_render_node_draw (root, cr);
 
 #ifdef G_ENABLE_DEBUG
   cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
   gsk_profiler_timer_set (profiler, self->profile_timers.cpu_time, cpu_time);
 
+  /* The shadow cache is shared with other renderers, so this is only
+   * accurate if they don't draw at the same time */
+  gsk_shadow_cache_get_statistics (&hits, &misses, &cache_size);
+  gsk_profiler_counter_set (profiler, self->profile_counters.shadow_cache_hits, hits - start_hits);
+  gsk_profiler_counter_set (profiler, self->profile_counters.shadow_cache_misses, misses - start_misses);
+  gsk_profiler_counter_set (profiler, self->profile_counters.shadow_cache_size, cache_size);
+
   gsk_profiler_push_samples (profiler);
 #endif
 }
@@ -126,15 +353,80 @@ gsk_cairo_renderer_render (GskRenderer   *renderer,
   gsk_cairo_renderer_do_render (renderer, cr, root);
 }
 
+static void
+gsk_cairo_renderer_set_property (GObject      *gobject,
+                                 guint         prop_id,
+                                 const GValue *value,
+                                 GParamSpec   *pspec)
+{
+  GskCairoRenderer *self = GSK_CAIRO_RENDERER (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_TILED:
+      if (self->tiled != g_value_get_boolean (value))
+        {
+          self->tiled = g_value_get_boolean (value);
+          g_object_notify_by_pspec (gobject, pspec);
+        }
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+    }
+}
+
+static void
+gsk_cairo_renderer_get_property (GObject    *gobject,
+                                 guint       prop_id,
+                                 GValue     *value,
+                                 GParamSpec *pspec)
+{
+  GskCairoRenderer *self = GSK_CAIRO_RENDERER (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_TILED:
+      g_value_set_boolean (value, self->tiled);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+    }
+}
+
 static void
 gsk_cairo_renderer_class_init (GskCairoRendererClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GskRendererClass *renderer_class = GSK_RENDERER_CLASS (klass);
 
+  gobject_class->set_property = gsk_cairo_renderer_set_property;
+  gobject_class->get_property = gsk_cairo_renderer_get_property;
+
   renderer_class->realize = gsk_cairo_renderer_realize;
   renderer_class->unrealize = gsk_cairo_renderer_unrealize;
   renderer_class->render = gsk_cairo_renderer_render;
   renderer_class->render_texture = gsk_cairo_renderer_render_texture;
+
+  /**
+   * GskCairoRenderer:tiled:
+   *
+   * Whether to split the rendering into tiles that are drawn in
+   * parallel on multiple threads.
+   *
+   * The default can be changed with GSK_RENDERING_MODE=tiled.
+   */
+  gsk_cairo_renderer_properties[PROP_TILED] =
+    g_param_spec_boolean ("tiled",
+                          "Tiled",
+                          "Whether to render tiles in parallel",
+                          FALSE,
+                          G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS |
+                          G_PARAM_EXPLICIT_NOTIFY);
+
+  g_object_class_install_properties (gobject_class, N_PROPS, gsk_cairo_renderer_properties);
 }
 
 static void
@@ -143,6 +435,12 @@ gsk_cairo_renderer_init (GskCairoRenderer *self)
 #ifdef G_ENABLE_DEBUG
   GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
 
+  self->profile_counters.tiles = gsk_profiler_add_counter (profiler, "tiles", "Rendered tiles", TRUE);
+  self->profile_counters.shadow_cache_hits = gsk_profiler_add_counter (profiler, "shadow-cache-hits", "Shadow masks found in the cache", TRUE);
+  self->profile_counters.shadow_cache_misses = gsk_profiler_add_counter (profiler, "shadow-cache-misses", "Shadow masks blurred", TRUE);
+  self->profile_counters.shadow_cache_size = gsk_profiler_add_counter (profiler, "shadow-cache-size", "Memory used by cached shadow masks", FALSE);
   self->profile_timers.cpu_time = gsk_profiler_add_timer (profiler, "cpu-time", "CPU time", FALSE, TRUE);
 #endif
+
+  self->tiled = gsk_check_rendering_flags (GSK_RENDERING_MODE_TILED);
 }
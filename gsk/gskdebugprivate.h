@@ -26,7 +26,9 @@ typedef enum {
   GSK_RENDERING_MODE_SYNC           = 1 << 2,
   GSK_RENDERING_MODE_FULL_REDRAW    = 1 << 3,
   GSK_RENDERING_MODE_STAGING_IMAGE  = 1 << 4,
-  GSK_RENDERING_MODE_STAGING_BUFFER = 1 << 5
+  GSK_RENDERING_MODE_STAGING_BUFFER = 1 << 5,
+  GSK_RENDERING_MODE_TILED          = 1 << 6,
+  GSK_RENDERING_MODE_NO_OPTIMIZE    = 1 << 7
 } GskRenderingMode;
 
 gboolean gsk_check_debug_flags (GskDebugFlags flags);
@@ -712,13 +712,20 @@ render_node_needs_render_target (GskRenderNode *node)
   return FALSE;
 }
 
+static void gsk_gl_renderer_add_render_item (GskGLRenderer           *self,
+                                             const graphene_matrix_t *projection,
+                                             const graphene_matrix_t *modelview,
+                                             GArray                  *render_items,
+                                             GskRenderNode           *node,
+                                             RenderItem              *parent);
+
 static void
-gsk_gl_renderer_add_render_item (GskGLRenderer           *self,
-                                 const graphene_matrix_t *projection,
-                                 const graphene_matrix_t *modelview,
-                                 GArray                  *render_items,
-                                 GskRenderNode           *node,
-                                 RenderItem              *parent)
+gsk_gl_renderer_add_render_item_real (GskGLRenderer           *self,
+                                      const graphene_matrix_t *projection,
+                                      const graphene_matrix_t *modelview,
+                                      GArray                  *render_items,
+                                      GskRenderNode           *node,
+                                      RenderItem              *parent)
 {
   RenderItem item;
   RenderItem *ritem = NULL;
@@ -981,6 +988,25 @@ gsk_gl_renderer_add_render_item (GskGLRenderer           *self,
     render_items = item.children;
 }
 
+static void
+gsk_gl_renderer_add_render_item (GskGLRenderer           *self,
+                                 const graphene_matrix_t *projection,
+                                 const graphene_matrix_t *modelview,
+                                 GArray                  *render_items,
+                                 GskRenderNode           *node,
+                                 RenderItem              *parent)
+{
+  GskRenderNodeTiming timing;
+  gboolean timed;
+
+  timed = gsk_render_node_timing_begin (&timing, node);
+
+  gsk_gl_renderer_add_render_item_real (self, projection, modelview, render_items, node, parent);
+
+  if (timed)
+    gsk_render_node_timing_end (&timing);
+}
+
 static gboolean
 gsk_gl_renderer_validate_tree (GskGLRenderer           *self,
                                GskRenderNode           *root,
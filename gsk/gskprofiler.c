@@ -513,3 +513,52 @@ gsk_profiler_append_timers (GskProfiler *profiler,
       g_string_append (buffer, "\n");
     }
 }
+
+/* Appends the "counters" and "timers" members of a JSON object,
+ * with the values of the timers in microseconds */
+void
+gsk_profiler_append_json (GskProfiler *profiler,
+                          GString     *buffer)
+{
+  GHashTableIter iter;
+  gpointer value_p = NULL;
+  gboolean first;
+
+  g_return_if_fail (GSK_IS_PROFILER (profiler));
+  g_return_if_fail (buffer != NULL);
+
+  g_string_append (buffer, "\"counters\": {");
+  first = TRUE;
+  g_hash_table_iter_init (&iter, profiler->counters);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      NamedCounter *counter = value_p;
+
+      g_string_append_printf (buffer, "%s\"%s\": %" G_GINT64_FORMAT,
+                              first ? "" : ", ",
+                              g_quark_to_string (counter->id),
+                              counter->value);
+      first = FALSE;
+    }
+
+  g_string_append (buffer, "}, \"timers\": {");
+  first = TRUE;
+  g_hash_table_iter_init (&iter, profiler->timers);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      NamedTimer *timer = value_p;
+      char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+      if (timer->invert)
+        g_ascii_dtostr (buf, sizeof (buf), timer->value ? 1000000000.0 / (double) timer->value : 0.0);
+      else
+        g_ascii_dtostr (buf, sizeof (buf), (double) timer->value / 1000.0);
+
+      g_string_append_printf (buffer, "%s\"%s\": %s",
+                              first ? "" : ", ",
+                              g_quark_to_string (timer->id),
+                              buf);
+      first = FALSE;
+    }
+  g_string_append_c (buffer, '}');
+}
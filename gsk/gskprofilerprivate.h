@@ -48,6 +48,8 @@ void            gsk_profiler_append_counters    (GskProfiler *profiler,
                                                  GString     *buffer);
 void            gsk_profiler_append_timers      (GskProfiler *profiler,
                                                  GString     *buffer);
+void            gsk_profiler_append_json        (GskProfiler *profiler,
+                                                 GString     *buffer);
 
 G_END_DECLS
 
@@ -60,6 +60,22 @@
 #include "gskvulkanrendererprivate.h"
 #endif
 
+#ifdef G_ENABLE_DEBUG
+typedef struct {
+  GQuark nodes;
+  GQuark node_depth;
+  GQuark node_bytes;
+  GQuark surface_bytes;
+  GQuark texture_bytes;
+  GQuark folded_containers;
+  GQuark folded_opacities;
+  GQuark folded_clips;
+  GQuark folded_transforms;
+  GQuark culled_nodes;
+  GQuark merged_text_nodes;
+} ProfileCounters;
+#endif
+
 typedef struct
 {
   GObject parent_instance;
@@ -72,9 +88,17 @@ typedef struct
   GdkWindow *window;
   GdkDrawingContext *drawing_context;
   GskRenderNode *root_node;
+  /* The last node rendered to the window, used for damage tracking */
+  GskRenderNode *prev_node;
   GdkDisplay *display;
 
   GskProfiler *profiler;
+  /* Set while between gsk_renderer_begin_profile() and _end_profile() */
+  GskRenderNodeTimings *node_timings;
+
+#ifdef G_ENABLE_DEBUG
+  ProfileCounters profile_counters;
+#endif
 
   int scale_factor;
 
@@ -176,6 +200,12 @@ gsk_renderer_dispose (GObject *gobject)
 
   gsk_renderer_unrealize (self);
 
+  if (priv->node_timings)
+    {
+      gsk_render_node_timings_stop (priv->node_timings);
+      g_clear_pointer (&priv->node_timings, g_free);
+    }
+
   g_clear_object (&priv->profiler);
   g_clear_object (&priv->display);
 
@@ -359,9 +389,76 @@ gsk_renderer_init (GskRenderer *self)
 
   priv->profiler = gsk_profiler_new ();
 
+#ifdef G_ENABLE_DEBUG
+  priv->profile_counters.nodes = gsk_profiler_add_counter (priv->profiler, "nodes", "Render nodes", TRUE);
+  priv->profile_counters.node_depth = gsk_profiler_add_counter (priv->profiler, "node-depth", "Depth of the render node tree", TRUE);
+  priv->profile_counters.node_bytes = gsk_profiler_add_counter (priv->profiler, "node-bytes", "Memory used by render nodes", TRUE);
+  priv->profile_counters.surface_bytes = gsk_profiler_add_counter (priv->profiler, "surface-bytes", "Memory used by surfaces in render nodes", TRUE);
+  priv->profile_counters.texture_bytes = gsk_profiler_add_counter (priv->profiler, "texture-bytes", "Memory used by textures in render nodes", TRUE);
+  priv->profile_counters.folded_containers = gsk_profiler_add_counter (priv->profiler, "folded-containers", "Containers removed by the optimizer", TRUE);
+  priv->profile_counters.folded_opacities = gsk_profiler_add_counter (priv->profiler, "folded-opacities", "Opacity nodes removed by the optimizer", TRUE);
+  priv->profile_counters.folded_clips = gsk_profiler_add_counter (priv->profiler, "folded-clips", "Clip nodes removed by the optimizer", TRUE);
+  priv->profile_counters.folded_transforms = gsk_profiler_add_counter (priv->profiler, "folded-transforms", "Translations removed by the optimizer", TRUE);
+  priv->profile_counters.culled_nodes = gsk_profiler_add_counter (priv->profiler, "culled-nodes", "Invisible nodes removed by the optimizer", TRUE);
+  priv->profile_counters.merged_text_nodes = gsk_profiler_add_counter (priv->profiler, "merged-text-nodes", "Text nodes merged by the optimizer", TRUE);
+#endif
+
   priv->scale_factor = 1;
 }
 
+/* Returns the tree to hand to the renderer implementation for @root */
+static GskRenderNode *
+gsk_renderer_optimize (GskRenderer   *renderer,
+                       GskRenderNode *root)
+{
+#ifdef G_ENABLE_DEBUG
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+#endif
+  GskRenderNodeOptimizeStats stats = { 0, };
+  GskRenderNode *result;
+
+  if (gsk_check_rendering_flags (GSK_RENDERING_MODE_NO_OPTIMIZE))
+    return gsk_render_node_ref (root);
+
+  result = gsk_render_node_optimize (root, &stats);
+  if (result == NULL)
+    result = gsk_container_node_new (NULL, 0);
+
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.folded_containers, stats.folded_containers);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.folded_opacities, stats.folded_opacities);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.folded_clips, stats.folded_clips);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.folded_transforms, stats.folded_transforms);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.culled_nodes, stats.culled_nodes);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.merged_text_nodes, stats.merged_text_nodes);
+#endif
+
+  return result;
+}
+
+#ifdef G_ENABLE_DEBUG
+static void
+gsk_renderer_update_node_stats (GskRenderer   *renderer,
+                                GskRenderNode *root)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GskRenderNodeStats stats;
+
+  /* Walking the whole tree for every frame is not free, so only
+   * do it when somebody looks at the counters */
+  if (!GSK_DEBUG_CHECK (RENDERER) && priv->node_timings == NULL)
+    return;
+
+  gsk_render_node_get_stats (root, &stats);
+
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.nodes, stats.n_nodes);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.node_depth, stats.depth);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.node_bytes, stats.node_bytes);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.surface_bytes, stats.surface_bytes);
+  gsk_profiler_counter_set (priv->profiler, priv->profile_counters.texture_bytes, stats.texture_bytes);
+}
+#endif
+
 /**
  * gsk_renderer_set_viewport:
  * @renderer: a #GskRenderer
@@ -383,6 +480,7 @@ gsk_renderer_set_viewport (GskRenderer           *renderer,
   if (viewport == NULL)
     {
       graphene_rect_init (&priv->viewport, 0.f, 0.f, 0.f, 0.f);
+      g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
       g_object_notify_by_pspec (G_OBJECT (renderer), gsk_renderer_properties[PROP_VIEWPORT]);
       return;
     }
@@ -391,6 +489,7 @@ gsk_renderer_set_viewport (GskRenderer           *renderer,
     return;
 
   graphene_rect_init_from_rect (&priv->viewport, viewport);
+  g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
 
   g_object_notify_by_pspec (G_OBJECT (renderer), gsk_renderer_properties[PROP_VIEWPORT]);
 }
@@ -436,6 +535,7 @@ gsk_renderer_set_scale_factor (GskRenderer *renderer,
   if (priv->scale_factor != scale_factor)
     {
       priv->scale_factor = scale_factor;
+      g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
 
       g_object_notify_by_pspec (G_OBJECT (renderer), gsk_renderer_properties[PROP_SCALE_FACTOR]);
     }
@@ -613,6 +713,8 @@ gsk_renderer_unrealize (GskRenderer *renderer)
 
   GSK_RENDERER_GET_CLASS (renderer)->unrealize (renderer);
 
+  g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
+
   priv->is_realized = FALSE;
 }
 
@@ -642,6 +744,7 @@ gsk_renderer_render_texture (GskRenderer           *renderer,
 {
   GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
   graphene_rect_t real_viewport;
+  GskRenderNode *optimized;
   GskTexture *texture;
 
   g_return_val_if_fail (GSK_IS_RENDERER (renderer), NULL);
@@ -657,7 +760,13 @@ gsk_renderer_render_texture (GskRenderer           *renderer,
       viewport = &real_viewport;
     }
 
-  texture = GSK_RENDERER_GET_CLASS (renderer)->render_texture (renderer, root, viewport);
+#ifdef G_ENABLE_DEBUG
+  gsk_renderer_update_node_stats (renderer, root);
+#endif
+
+  optimized = gsk_renderer_optimize (renderer, root);
+  texture = GSK_RENDERER_GET_CLASS (renderer)->render_texture (renderer, optimized, viewport);
+  gsk_render_node_unref (optimized);
 
 #ifdef G_ENABLE_DEBUG
   if (GSK_DEBUG_CHECK (RENDERER))
@@ -701,6 +810,7 @@ gsk_renderer_render (GskRenderer       *renderer,
                      GdkDrawingContext *context)
 {
   GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GskRenderNode *optimized;
 
   g_return_if_fail (GSK_IS_RENDERER (renderer));
   g_return_if_fail (priv->is_realized);
@@ -711,7 +821,13 @@ gsk_renderer_render (GskRenderer       *renderer,
 
   priv->root_node = gsk_render_node_ref (root);
 
-  GSK_RENDERER_GET_CLASS (renderer)->render (renderer, root);
+#ifdef G_ENABLE_DEBUG
+  gsk_renderer_update_node_stats (renderer, root);
+#endif
+
+  optimized = gsk_renderer_optimize (renderer, root);
+  GSK_RENDERER_GET_CLASS (renderer)->render (renderer, optimized);
+  gsk_render_node_unref (optimized);
 
 #ifdef G_ENABLE_DEBUG
   if (GSK_DEBUG_CHECK (RENDERER))
@@ -730,7 +846,48 @@ gsk_renderer_render (GskRenderer       *renderer,
     }
 #endif
 
-  g_clear_pointer (&priv->root_node, gsk_render_node_unref);
+  g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
+  priv->prev_node = priv->root_node;
+  priv->root_node = NULL;
+}
+
+/*< private >
+ * gsk_renderer_compute_damage:
+ * @renderer: a #GskRenderer
+ * @root: the #GskRenderNode that is going to be rendered next
+ * @region: the region to add the damage to
+ *
+ * Adds the area that differs between @root and the node that was last
+ * rendered with gsk_renderer_render() to @region.
+ *
+ * If the previous contents of the window are not known, because
+ * nothing was rendered yet or because the renderer has been
+ * reconfigured since, or if full redraws have been requested by the
+ * debugging flags, %FALSE is returned and @region is not modified.
+ * In that case the whole window must be considered damaged.
+ *
+ * Returns: %TRUE if the damage could be computed
+ */
+gboolean
+gsk_renderer_compute_damage (GskRenderer    *renderer,
+                             GskRenderNode  *root,
+                             cairo_region_t *region)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+
+  g_return_val_if_fail (GSK_IS_RENDERER (renderer), FALSE);
+  g_return_val_if_fail (GSK_IS_RENDER_NODE (root), FALSE);
+  g_return_val_if_fail (region != NULL, FALSE);
+
+  if (priv->prev_node == NULL)
+    return FALSE;
+
+  if (GSK_RENDER_MODE_CHECK (FULL_REDRAW))
+    return FALSE;
+
+  gsk_render_node_diff (priv->prev_node, root, region);
+
+  return TRUE;
 }
 
 /*< private >
@@ -751,6 +908,82 @@ gsk_renderer_get_profiler (GskRenderer *renderer)
   return priv->profiler;
 }
 
+/*< private >
+ * gsk_renderer_begin_profile:
+ * @renderer: a #GskRenderer
+ *
+ * Resets the profiler of @renderer and starts measuring the time
+ * spent on each type of render node. Call gsk_renderer_end_profile()
+ * to get the results.
+ *
+ * Only one renderer can be profiled at a time.
+ */
+void
+gsk_renderer_begin_profile (GskRenderer *renderer)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+
+  g_return_if_fail (GSK_IS_RENDERER (renderer));
+  g_return_if_fail (priv->node_timings == NULL);
+
+  gsk_profiler_reset (priv->profiler);
+
+  priv->node_timings = g_new0 (GskRenderNodeTimings, 1);
+  gsk_render_node_timings_start (priv->node_timings);
+}
+
+/*< private >
+ * gsk_renderer_end_profile:
+ * @renderer: a #GskRenderer
+ * @json: the string to append the results to
+ *
+ * Stops the profiling started with gsk_renderer_begin_profile() and
+ * appends its results to @json, as a JSON object with the members
+ * "renderer", "counters", "timers" and "nodes". The "nodes" member
+ * holds the number of rendered nodes and the time in microseconds
+ * spent on them, not counting their children, for every node type.
+ */
+void
+gsk_renderer_end_profile (GskRenderer *renderer,
+                          GString     *json)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GEnumClass *enum_class;
+  gboolean first = TRUE;
+  guint i;
+
+  g_return_if_fail (GSK_IS_RENDERER (renderer));
+  g_return_if_fail (priv->node_timings != NULL);
+  g_return_if_fail (json != NULL);
+
+  gsk_render_node_timings_stop (priv->node_timings);
+
+  g_string_append_printf (json, "{\"renderer\": \"%s\", ", G_OBJECT_TYPE_NAME (renderer));
+  gsk_profiler_append_json (priv->profiler, json);
+  g_string_append (json, ", \"nodes\": {");
+
+  enum_class = g_type_class_ref (GSK_TYPE_RENDER_NODE_TYPE);
+  for (i = 1; i < G_N_ELEMENTS (priv->node_timings->count); i++)
+    {
+      GEnumValue *value = g_enum_get_value (enum_class, i);
+
+      if (priv->node_timings->count[i] == 0)
+        continue;
+
+      g_string_append_printf (json, "%s\"%s\": {\"count\": %" G_GUINT64_FORMAT ", \"time\": %" G_GINT64_FORMAT "}",
+                              first ? "" : ", ",
+                              value->value_nick,
+                              priv->node_timings->count[i],
+                              priv->node_timings->time[i]);
+      first = FALSE;
+    }
+  g_type_class_unref (enum_class);
+
+  g_string_append (json, "}}");
+
+  g_clear_pointer (&priv->node_timings, g_free);
+}
+
 static GType
 get_renderer_for_name (const char *renderer_name)
 {
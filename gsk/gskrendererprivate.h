@@ -69,6 +69,17 @@ cairo_surface_t *       gsk_renderer_create_cairo_surface       (GskRenderer
 
 GskProfiler *           gsk_renderer_get_profiler               (GskRenderer    *renderer);
 
+gboolean                gsk_renderer_compute_damage             (GskRenderer    *renderer,
+                                                                 GskRenderNode  *root,
+                                                                 cairo_region_t *region);
+
+/* Needs to be exported for tests/rendernode-benchmark */
+GDK_AVAILABLE_IN_ALL
+void                    gsk_renderer_begin_profile              (GskRenderer    *renderer);
+GDK_AVAILABLE_IN_ALL
+void                    gsk_renderer_end_profile                (GskRenderer    *renderer,
+                                                                 GString        *json);
+
 G_END_DECLS
 
 #endif /* __GSK_RENDERER_PRIVATE_H__ */
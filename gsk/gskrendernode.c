@@ -50,6 +50,7 @@
 #include <graphene-gobject.h>
 
 #include <math.h>
+#include <string.h>
 
 #include <gobject/gvaluecollector.h>
 
@@ -67,6 +68,484 @@ G_DEFINE_BOXED_TYPE (GskRenderNode, gsk_render_node,
 
 G_DEFINE_QUARK (gsk-serialization-error-quark, gsk_serialization_error)
 
+/* Nodes created during a frame are bump-allocated from chunks of an
+ * arena. Each node holds a reference on the chunk it was allocated from,
+ * so nodes that outlive the frame keep their chunk alive and the chunk
+ * is freed as soon as all of its nodes are gone.
+ *
+ * Nodes that are kept across frames would pin whole chunks, so they
+ * are moved out of the arena when they are retained, see
+ * gsk_render_node_promote().
+ */
+#define GSK_RENDER_NODE_CHUNK_SIZE      (16 * 1024)
+#define GSK_RENDER_NODE_CHUNK_MAX_NODE  (GSK_RENDER_NODE_CHUNK_SIZE / 8)
+#define GSK_RENDER_NODE_ALIGNMENT       16
+
+struct _GskRenderNodeChunk
+{
+  volatile int ref_count;
+  gsize used;
+};
+
+struct _GskRenderNodeArena
+{
+  GskRenderNodeChunk *chunk;
+
+  /* Statistics, added to arena_stats when the arena ends */
+  guint n_nodes;
+  guint n_promoted;
+};
+
+static GskRenderNodeArenaStats arena_stats;
+G_LOCK_DEFINE_STATIC (arena_stats);
+
+static GPrivate current_arena;
+
+static void
+gsk_render_node_chunk_unref (GskRenderNodeChunk *chunk)
+{
+  if (g_atomic_int_dec_and_test (&chunk->ref_count))
+    g_free (chunk);
+}
+
+static gsize
+gsk_render_node_chunk_align (GskRenderNodeChunk *chunk)
+{
+  gsize start = GPOINTER_TO_SIZE (chunk) + chunk->used;
+
+  return (start + GSK_RENDER_NODE_ALIGNMENT - 1) & ~(gsize) (GSK_RENDER_NODE_ALIGNMENT - 1);
+}
+
+static gpointer
+gsk_render_node_arena_alloc (GskRenderNodeArena  *arena,
+                             gsize                size,
+                             GskRenderNodeChunk **chunk_out)
+{
+  GskRenderNodeChunk *chunk = arena->chunk;
+  gsize start = 0, end = 0;
+
+  arena->n_nodes++;
+
+  /* Large nodes get a chunk of their own, so that they can be told
+   * apart from nodes that were never in an arena */
+  if (size > GSK_RENDER_NODE_CHUNK_MAX_NODE)
+    {
+      chunk = g_malloc (sizeof (GskRenderNodeChunk) + GSK_RENDER_NODE_ALIGNMENT + size);
+      chunk->ref_count = 1;
+      chunk->used = sizeof (GskRenderNodeChunk);
+      start = gsk_render_node_chunk_align (chunk);
+      chunk->used = start + size - GPOINTER_TO_SIZE (chunk);
+      *chunk_out = chunk;
+
+      return memset (GSIZE_TO_POINTER (start), 0, size);
+    }
+
+  if (chunk != NULL)
+    {
+      start = gsk_render_node_chunk_align (chunk);
+      end = start + size;
+    }
+
+  if (chunk == NULL || end > GPOINTER_TO_SIZE (chunk) + GSK_RENDER_NODE_CHUNK_SIZE)
+    {
+      if (chunk != NULL)
+        gsk_render_node_chunk_unref (chunk);
+
+      chunk = g_malloc (GSK_RENDER_NODE_CHUNK_SIZE);
+      chunk->ref_count = 1;
+      chunk->used = sizeof (GskRenderNodeChunk);
+      arena->chunk = chunk;
+
+      start = gsk_render_node_chunk_align (chunk);
+      end = start + size;
+    }
+
+  chunk->used = end - GPOINTER_TO_SIZE (chunk);
+  g_atomic_int_inc (&chunk->ref_count);
+  *chunk_out = chunk;
+
+  return memset (GSIZE_TO_POINTER (start), 0, size);
+}
+
+/*< private >
+ * gsk_render_node_arena_begin:
+ *
+ * Makes render nodes created in the calling thread get allocated
+ * from a new arena, until gsk_render_node_arena_end() is called.
+ *
+ * This avoids allocating and freeing every node of a frame separately.
+ * Nodes allocated from the arena can be used like any other node, and
+ * may outlive the arena.
+ *
+ * If an arena is already in use in this thread, no new arena is
+ * created and %NULL is returned.
+ *
+ * Returns: (transfer full) (nullable): the new arena
+ */
+GskRenderNodeArena *
+gsk_render_node_arena_begin (void)
+{
+  GskRenderNodeArena *arena;
+
+  if (g_private_get (&current_arena) != NULL)
+    return NULL;
+
+  arena = g_slice_new0 (GskRenderNodeArena);
+  g_private_set (&current_arena, arena);
+
+  return arena;
+}
+
+/*< private >
+ * gsk_render_node_arena_end:
+ * @arena: (transfer full) (nullable): the arena returned from
+ *   gsk_render_node_arena_begin()
+ *
+ * Stops allocating nodes from @arena and frees it.
+ */
+void
+gsk_render_node_arena_end (GskRenderNodeArena *arena)
+{
+  if (arena == NULL)
+    return;
+
+  g_return_if_fail (g_private_get (&current_arena) == arena);
+
+  g_private_set (&current_arena, NULL);
+
+  G_LOCK (arena_stats);
+  arena_stats.n_nodes += arena->n_nodes;
+  arena_stats.n_promoted += arena->n_promoted;
+  G_UNLOCK (arena_stats);
+
+  g_clear_pointer (&arena->chunk, gsk_render_node_chunk_unref);
+  g_slice_free (GskRenderNodeArena, arena);
+}
+
+/*< private >
+ * gsk_render_node_get_arena_stats:
+ * @stats: (out caller-allocates): return location for the statistics
+ *
+ * Retrieves how many nodes were allocated from arenas, and how many
+ * of them were moved out again by gsk_render_node_promote(), in all
+ * arenas that have ended so far.
+ */
+void
+gsk_render_node_get_arena_stats (GskRenderNodeArenaStats *stats)
+{
+  G_LOCK (arena_stats);
+  *stats = arena_stats;
+  G_UNLOCK (arena_stats);
+}
+
+/*< private >
+ * gsk_render_node_promote:
+ * @node: (transfer full): a render node
+ *
+ * Moves the nodes in the tree of @node that were allocated from an
+ * arena to memory of their own, so that keeping the tree after the
+ * frame doesn't keep the chunks of the arena alive. This is meant to
+ * be called on trees that are retained across frames.
+ *
+ * Only nodes that nobody else references can be moved; the others
+ * stay where they are. Nodes outside of arenas are not looked into,
+ * because they are either older trees that were promoted before or
+ * were created without an arena.
+ *
+ * Returns: (transfer full): the promoted tree, which may be a
+ *   different node than @node
+ */
+GskRenderNode *
+gsk_render_node_promote (GskRenderNode *node)
+{
+  GskRenderNodeArena *arena;
+  GskRenderNodeChunk *chunk;
+  GskRenderNode *self;
+
+  g_return_val_if_fail (GSK_IS_RENDER_NODE (node), NULL);
+
+  chunk = node->chunk;
+  if (chunk == NULL || g_atomic_int_get (&node->ref_count) != 1)
+    return node;
+
+  /* We hold the only reference, so the node can simply be moved
+   * along with everything it owns */
+  self = g_memdup (node, node->size);
+  self->chunk = NULL;
+  gsk_render_node_chunk_unref (chunk);
+
+  arena = g_private_get (&current_arena);
+  if (arena != NULL)
+    arena->n_promoted++;
+
+  gsk_render_node_promote_children (self);
+
+  return self;
+}
+
+/* Per-node-type timings, collected while a renderer is profiling.
+ * The innermost running GskRenderNodeTiming of each thread is kept
+ * in current_timing, so that the time spent in child nodes can be
+ * subtracted from their parent.
+ */
+static GskRenderNodeTimings *current_timings;
+static GPrivate current_timing;
+G_LOCK_DEFINE_STATIC (timings);
+
+/*< private >
+ * gsk_render_node_timings_start:
+ * @timings: the timings to add to
+ *
+ * Starts adding the time spent rendering nodes to @timings, on
+ * all threads. Only one set of timings can be collected at a time.
+ */
+void
+gsk_render_node_timings_start (GskRenderNodeTimings *timings)
+{
+  G_LOCK (timings);
+
+  if (current_timings == NULL)
+    g_atomic_pointer_set (&current_timings, timings);
+  else
+    g_critical ("Render node timings are already being collected.");
+
+  G_UNLOCK (timings);
+}
+
+/*< private >
+ * gsk_render_node_timings_stop:
+ * @timings: the timings passed to gsk_render_node_timings_start()
+ *
+ * Stops collecting timings.
+ */
+void
+gsk_render_node_timings_stop (GskRenderNodeTimings *timings)
+{
+  G_LOCK (timings);
+
+  if (current_timings == timings)
+    g_atomic_pointer_set (&current_timings, NULL);
+
+  G_UNLOCK (timings);
+}
+
+/*< private >
+ * gsk_render_node_timing_begin:
+ * @timing: (out caller-allocates): the timing to start
+ * @node: the node that is about to be rendered
+ *
+ * Starts measuring the time spent rendering @node, if timings are
+ * being collected. Every call that returns %TRUE must be paired with
+ * a call to gsk_render_node_timing_end() on the same thread.
+ *
+ * Returns: %TRUE if timings are being collected
+ */
+gboolean
+gsk_render_node_timing_begin (GskRenderNodeTiming *timing,
+                              GskRenderNode       *node)
+{
+  if (G_LIKELY (g_atomic_pointer_get (&current_timings) == NULL))
+    return FALSE;
+
+  timing->node = node;
+  timing->child_time = 0;
+  timing->parent = g_private_get (&current_timing);
+  timing->start_time = g_get_monotonic_time ();
+
+  g_private_set (&current_timing, timing);
+
+  return TRUE;
+}
+
+/*< private >
+ * gsk_render_node_timing_end:
+ * @timing: a timing started with gsk_render_node_timing_begin()
+ *
+ * Adds the time spent rendering the node of @timing, without the
+ * time spent in its children, to the timings being collected.
+ */
+void
+gsk_render_node_timing_end (GskRenderNodeTiming *timing)
+{
+  GskRenderNodeType type;
+  gint64 elapsed;
+
+  elapsed = g_get_monotonic_time () - timing->start_time;
+
+  g_private_set (&current_timing, timing->parent);
+  if (timing->parent)
+    timing->parent->child_time += elapsed;
+
+  type = gsk_render_node_get_node_type (timing->node);
+
+  G_LOCK (timings);
+
+  if (current_timings != NULL)
+    {
+      current_timings->time[type] += elapsed - timing->child_time;
+
+      /* Renderers falling back to gsk_render_node_draw() time the
+       * same node twice, only count it once. */
+      if (timing->parent == NULL || timing->parent->node != timing->node)
+        current_timings->count[type] += 1;
+    }
+
+  G_UNLOCK (timings);
+}
+
+struct _GskRenderNodeStatsCollector
+{
+  GskRenderNodeStats *stats;
+  /* Maps nodes to the depth of their subtree */
+  GHashTable *nodes;
+  /* Surfaces and textures that were already counted */
+  GHashTable *resources;
+
+  /* The node whose children are being collected */
+  GskRenderNode *node;
+  guint child_depth;
+};
+
+static guint
+gsk_render_node_collect_stats (GskRenderNodeStatsCollector *collector,
+                               GskRenderNode               *node)
+{
+  GskRenderNodeType type = node->node_class->node_type;
+  GskRenderNode *parent;
+  guint parent_child_depth;
+  gpointer depth;
+
+  if (g_hash_table_lookup_extended (collector->nodes, node, NULL, &depth))
+    return GPOINTER_TO_UINT (depth);
+
+  collector->stats->n_nodes += 1;
+  collector->stats->count[type] += 1;
+
+  parent = collector->node;
+  parent_child_depth = collector->child_depth;
+  collector->node = node;
+  collector->child_depth = 0;
+
+  gsk_render_node_stats_collector_add_bytes (collector, node->node_class->struct_size);
+  if (node->name)
+    gsk_render_node_stats_collector_add_bytes (collector, strlen (node->name) + 1);
+
+  if (node->node_class->collect_stats)
+    node->node_class->collect_stats (node, collector);
+
+  depth = GUINT_TO_POINTER (collector->child_depth + 1);
+  g_hash_table_insert (collector->nodes, node, depth);
+
+  collector->node = parent;
+  collector->child_depth = parent_child_depth;
+
+  return GPOINTER_TO_UINT (depth);
+}
+
+/*< private >
+ * gsk_render_node_get_stats:
+ * @node: the root of a render node tree
+ * @stats: (out caller-allocates): return location for the statistics
+ *
+ * Counts the nodes in the tree below @node and the memory they hold.
+ * Nodes, surfaces and textures that are shared between several parts
+ * of the tree are only counted once.
+ */
+void
+gsk_render_node_get_stats (GskRenderNode      *node,
+                           GskRenderNodeStats *stats)
+{
+  GskRenderNodeStatsCollector collector;
+
+  g_return_if_fail (GSK_IS_RENDER_NODE (node));
+  g_return_if_fail (stats != NULL);
+
+  memset (stats, 0, sizeof (GskRenderNodeStats));
+
+  collector.stats = stats;
+  collector.nodes = g_hash_table_new (NULL, NULL);
+  collector.resources = g_hash_table_new (NULL, NULL);
+  collector.node = NULL;
+  collector.child_depth = 0;
+
+  stats->depth = gsk_render_node_collect_stats (&collector, node);
+
+  g_hash_table_unref (collector.nodes);
+  g_hash_table_unref (collector.resources);
+}
+
+/*< private >
+ * gsk_render_node_stats_collector_add_child:
+ * @collector: the collector passed to the collect_stats vfunc
+ * @child: a child of the node being collected
+ *
+ * Adds @child and its subtree to the statistics.
+ */
+void
+gsk_render_node_stats_collector_add_child (GskRenderNodeStatsCollector *collector,
+                                           GskRenderNode               *child)
+{
+  guint depth;
+
+  depth = gsk_render_node_collect_stats (collector, child);
+  collector->child_depth = MAX (collector->child_depth, depth);
+}
+
+/*< private >
+ * gsk_render_node_stats_collector_add_bytes:
+ * @collector: the collector passed to the collect_stats vfunc
+ * @bytes: the number of bytes
+ *
+ * Adds memory owned by the node being collected, such as its
+ * variable-sized data, to the statistics.
+ */
+void
+gsk_render_node_stats_collector_add_bytes (GskRenderNodeStatsCollector *collector,
+                                           gsize                        bytes)
+{
+  collector->stats->bytes[collector->node->node_class->node_type] += bytes;
+  collector->stats->node_bytes += bytes;
+}
+
+/*< private >
+ * gsk_render_node_stats_collector_add_surface:
+ * @collector: the collector passed to the collect_stats vfunc
+ * @surface: a surface referenced by the node being collected
+ *
+ * Adds the pixels of @surface to the statistics. Only image surfaces
+ * are counted, the size of other surfaces is not known.
+ */
+void
+gsk_render_node_stats_collector_add_surface (GskRenderNodeStatsCollector *collector,
+                                             cairo_surface_t             *surface)
+{
+  if (!g_hash_table_add (collector->resources, surface))
+    return;
+
+  if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE)
+    collector->stats->surface_bytes += cairo_image_surface_get_stride (surface) *
+                                       cairo_image_surface_get_height (surface);
+}
+
+/*< private >
+ * gsk_render_node_stats_collector_add_texture:
+ * @collector: the collector passed to the collect_stats vfunc
+ * @texture: a texture referenced by the node being collected
+ *
+ * Adds the pixels of @texture to the statistics, assuming 4 bytes
+ * per pixel.
+ */
+void
+gsk_render_node_stats_collector_add_texture (GskRenderNodeStatsCollector *collector,
+                                             GskTexture                  *texture)
+{
+  if (!g_hash_table_add (collector->resources, texture))
+    return;
+
+  collector->stats->texture_bytes += (gsize) gsk_texture_get_width (texture) *
+                                     gsk_texture_get_height (texture) * 4;
+}
+
 static void
 gsk_render_node_finalize (GskRenderNode *self)
 {
@@ -74,7 +553,13 @@ gsk_render_node_finalize (GskRenderNode *self)
 
   g_clear_pointer (&self->name, g_free);
 
-  g_free (self);
+  if (self->optimized != self)
+    g_clear_pointer (&self->optimized, gsk_render_node_unref);
+
+  if (self->chunk)
+    gsk_render_node_chunk_unref (self->chunk);
+  else
+    g_free (self);
 }
 
 /*< private >
@@ -86,16 +571,31 @@ gsk_render_node_finalize (GskRenderNode *self)
 GskRenderNode *
 gsk_render_node_new (const GskRenderNodeClass *node_class, gsize extra_size)
 {
+  GskRenderNodeArena *arena;
+  GskRenderNodeChunk *chunk;
   GskRenderNode *self;
+  gsize size;
 
   g_return_val_if_fail (node_class != NULL, NULL);
   g_return_val_if_fail (node_class->node_type != GSK_NOT_A_RENDER_NODE, NULL);
 
-  self = g_malloc0 (node_class->struct_size + extra_size);
+  size = node_class->struct_size + extra_size;
+  arena = g_private_get (&current_arena);
+
+  if (arena != NULL)
+    {
+      self = gsk_render_node_arena_alloc (arena, size, &chunk);
+      self->chunk = chunk;
+    }
+  else
+    {
+      self = g_malloc0 (size);
+    }
 
   self->node_class = node_class;
 
   self->ref_count = 1;
+  self->size = size;
 
   self->min_filter = GSK_SCALING_FILTER_NEAREST;
   self->mag_filter = GSK_SCALING_FILTER_NEAREST;
@@ -264,10 +764,15 @@ void
 gsk_render_node_draw (GskRenderNode *node,
                       cairo_t       *cr)
 {
+  GskRenderNodeTiming timing;
+  gboolean timed;
+
   g_return_if_fail (GSK_IS_RENDER_NODE (node));
   g_return_if_fail (cr != NULL);
   g_return_if_fail (cairo_status (cr) == CAIRO_STATUS_SUCCESS);
 
+  timed = gsk_render_node_timing_begin (&timing, node);
+
   cairo_save (cr);
 
   if (!GSK_RENDER_MODE_CHECK (GEOMETRY))
@@ -298,6 +803,9 @@ gsk_render_node_draw (GskRenderNode *node,
 
   cairo_restore (cr);
 
+  if (timed)
+    gsk_render_node_timing_end (&timing);
+
   if (cairo_status (cr))
     {
       g_warning ("drawing failure for render node %s '%s': %s",
@@ -307,6 +815,79 @@ gsk_render_node_draw (GskRenderNode *node,
     }
 }
 
+/*< private >
+ * gsk_rect_to_cairo_grow:
+ * @graphene: a #graphene_rect_t
+ * @cairo: (out caller-allocates): return location for the integer rectangle
+ *
+ * Computes the smallest integer rectangle containing @graphene.
+ */
+void
+gsk_rect_to_cairo_grow (const graphene_rect_t *graphene,
+                        cairo_rectangle_int_t *cairo)
+{
+  cairo->x = floor (graphene->origin.x);
+  cairo->y = floor (graphene->origin.y);
+  cairo->width = ceil (graphene->origin.x + graphene->size.width) - cairo->x;
+  cairo->height = ceil (graphene->origin.y + graphene->size.height) - cairo->y;
+}
+
+/*< private >
+ * gsk_render_node_diff_impossible:
+ * @node1: a #GskRenderNode
+ * @node2: the #GskRenderNode to compare with
+ * @region: a #cairo_region_t to add the differences to
+ *
+ * Adds the bounds of both nodes to @region. This is the fallback for
+ * nodes that cannot be compared more precisely.
+ */
+void
+gsk_render_node_diff_impossible (GskRenderNode  *node1,
+                                 GskRenderNode  *node2,
+                                 cairo_region_t *region)
+{
+  cairo_rectangle_int_t rect;
+
+  gsk_rect_to_cairo_grow (&node1->bounds, &rect);
+  cairo_region_union_rectangle (region, &rect);
+  gsk_rect_to_cairo_grow (&node2->bounds, &rect);
+  cairo_region_union_rectangle (region, &rect);
+}
+
+/*< private >
+ * gsk_render_node_diff:
+ * @node1: a #GskRenderNode
+ * @node2: the #GskRenderNode to compare with
+ * @region: a #cairo_region_t to add the differences to
+ *
+ * Compares @node1 and @node2 trying to compute the minimal region of changes.
+ * In the worst case, this is the union of the bounds of @node1 and @node2.
+ *
+ * This function is used to compute the area that needs to be redrawn when
+ * the previous contents were drawn by @node1 and the new contents should
+ * correspond to @node2. As such, it is important that this comparison is
+ * faster than the time it takes to actually do the redraw.
+ *
+ * Note that the passed in @region may already contain previous results from
+ * previous node comparisons, so this function call will only add to it.
+ */
+void
+gsk_render_node_diff (GskRenderNode  *node1,
+                      GskRenderNode  *node2,
+                      cairo_region_t *region)
+{
+  if (node1 == node2)
+    return;
+
+  if (node1->node_class != node2->node_class)
+    {
+      gsk_render_node_diff_impossible (node1, node2, region);
+      return;
+    }
+
+  node1->node_class->diff (node1, node2, region);
+}
+
 #define GSK_RENDER_NODE_SERIALIZATION_VERSION 0
 #define GSK_RENDER_NODE_SERIALIZATION_ID "GskRenderNode"
 
@@ -322,28 +903,17 @@ gsk_render_node_draw (GskRenderNode *node,
  * that were created with previous versions of GTK+.
  *
  * The intended use of this functions is testing, benchmarking and debugging.
- * The format is not meant as a permanent storage format.
+ * The format is not meant as a permanent storage format. In particular, it
+ * uses the byte order of the machine that wrote it.
  *
  * Returns: a #GBytes representing the node.
  **/
 GBytes *
 gsk_render_node_serialize (GskRenderNode *node)
 {
-  GVariant *node_variant, *variant;
-  GBytes *result;
-
-  node_variant = gsk_render_node_serialize_node (node);
-
-  variant = g_variant_new ("(suuv)",
-                           GSK_RENDER_NODE_SERIALIZATION_ID,
-                           (guint32) GSK_RENDER_NODE_SERIALIZATION_VERSION,
-                           (guint32) gsk_render_node_get_node_type (node),
-                           node_variant);
-
-  result = g_variant_get_data_as_bytes (variant);
-  g_variant_unref (variant);
+  g_return_val_if_fail (GSK_IS_RENDER_NODE (node), NULL);
 
-  return result;
+  return gsk_render_node_encode (node);
 }
 
 /**
@@ -391,6 +961,9 @@ gsk_render_node_write_to_file (GskRenderNode *node,
  * Loads data previously created via gsk_render_node_serialize(). For a
  * discussion of the supported format, see that function.
  *
+ * Image data in @bytes is referenced instead of copied where possible, so
+ * passing the bytes of a #GMappedFile avoids reading the whole file.
+ *
  * Returns: (nullable) (transfer full): a new #GskRenderNode or %NULL on
  *     error.
  **/
@@ -403,6 +976,13 @@ gsk_render_node_deserialize (GBytes  *bytes,
   GVariant *variant, *node_variant;
   GskRenderNode *node = NULL;
 
+  g_return_val_if_fail (bytes != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (gsk_render_node_is_encoded (bytes))
+    return gsk_render_node_decode (bytes, error);
+
+  /* Files written by older versions of GTK+ */
   variant = g_variant_new_from_bytes (G_VARIANT_TYPE ("(suuv)"), bytes, FALSE);
 
   g_variant_get (variant, "(suuv)", &id_string, &version, &node_type, &node_variant);
@@ -0,0 +1,956 @@
+/* GSK - The GTK Scene Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The binary render node format
+ *
+ * The data starts with the 4 bytes "GSKN" followed by the format version.
+ * After that comes the root node, which is its node type followed by the
+ * node's own data, which in turn contains its child nodes.
+ *
+ * Integers are written as LEB128 varints, signed integers are zigzag
+ * encoded first. Other numbers are written as integers if they are
+ * integral, as floats if they fit into one and as doubles otherwise.
+ * Points and rectangle origins are written relative to the previously
+ * written point, which makes the usual small offsets between siblings
+ * take a byte or two.
+ *
+ * Fonts and surfaces are interned. The first time one is used it is
+ * written inline, later uses refer to it by index. Surfaces are
+ * deduplicated by a hash of their contents, so the same image used by
+ * different textures is only stored once. Pixel data is aligned, so
+ * that surfaces can point directly into mapped files when decoding.
+ *
+ * Like the GVariant format before it, the data is written in host
+ * byte order and is not meant to be kept across GTK versions.
+ */
+
+#include "config.h"
+
+#include "gskrendernodecoderprivate.h"
+
+#include "gskrendernodeprivate.h"
+#include "gsktextureprivate.h"
+
+#include <pango/pangocairo.h>
+
+#include <math.h>
+#include <string.h>
+
+#define GSK_RENDER_NODE_CODER_MAGIC "GSKN"
+#define GSK_RENDER_NODE_CODER_VERSION 1
+
+#define GSK_RENDER_NODE_CODER_ALIGNMENT 16
+#define GSK_RENDER_NODE_CODER_MAX_DEPTH 4096
+
+struct _GskRenderNodeEncoder
+{
+  GByteArray *data;
+
+  double last_x;
+  double last_y;
+
+  GHashTable *fonts;            /* PangoFont => index + 1 */
+  GHashTable *surfaces;         /* cairo_surface_t => index + 1 */
+  GHashTable *surface_hashes;   /* checksum => index + 1 */
+  guint n_fonts;
+  guint n_surfaces;
+};
+
+typedef struct {
+  cairo_surface_t *surface;
+  GskTexture *texture;
+} DecodedSurface;
+
+struct _GskRenderNodeDecoder
+{
+  GBytes *bytes;
+  const guchar *data;
+  gsize size;
+  gsize pos;
+  guint depth;
+
+  GError *error;
+
+  double last_x;
+  double last_y;
+
+  PangoContext *context;
+  GPtrArray *fonts;
+  GArray *surfaces;
+};
+
+static const cairo_user_data_key_t gsk_surface_bytes_key;
+
+/* {{{ Encoding */
+
+static void
+gsk_render_node_encoder_write_data (GskRenderNodeEncoder *encoder,
+                                    gconstpointer         data,
+                                    gsize                 size)
+{
+  g_byte_array_append (encoder->data, data, size);
+}
+
+static void
+gsk_render_node_encoder_align (GskRenderNodeEncoder *encoder)
+{
+  static const guint8 zeroes[GSK_RENDER_NODE_CODER_ALIGNMENT] = { 0, };
+  gsize padding;
+
+  padding = (GSK_RENDER_NODE_CODER_ALIGNMENT - encoder->data->len % GSK_RENDER_NODE_CODER_ALIGNMENT) % GSK_RENDER_NODE_CODER_ALIGNMENT;
+  gsk_render_node_encoder_write_data (encoder, zeroes, padding);
+}
+
+void
+gsk_render_node_encoder_write_uint (GskRenderNodeEncoder *encoder,
+                                    guint64               value)
+{
+  guint8 buf[10];
+  gsize i = 0;
+
+  do
+    {
+      buf[i] = value & 0x7f;
+      value >>= 7;
+      if (value)
+        buf[i] |= 0x80;
+      i++;
+    }
+  while (value);
+
+  gsk_render_node_encoder_write_data (encoder, buf, i);
+}
+
+void
+gsk_render_node_encoder_write_int (GskRenderNodeEncoder *encoder,
+                                   gint64                value)
+{
+  gsk_render_node_encoder_write_uint (encoder, ((guint64) value << 1) ^ (guint64) (value >> 63));
+}
+
+void
+gsk_render_node_encoder_write_number (GskRenderNodeEncoder *encoder,
+                                      double                value)
+{
+  float f = value;
+
+  if (value == floor (value) && fabs (value) < (double) (G_GINT64_CONSTANT (1) << 52) &&
+      !(value == 0 && signbit (value)))
+    {
+      gint64 i = value;
+
+      /* even tags are integers */
+      gsk_render_node_encoder_write_uint (encoder, (((guint64) i << 1) ^ (guint64) (i >> 63)) << 1);
+    }
+  else if (f == value)
+    {
+      gsk_render_node_encoder_write_uint (encoder, 1);
+      gsk_render_node_encoder_write_data (encoder, &f, sizeof (float));
+    }
+  else
+    {
+      gsk_render_node_encoder_write_uint (encoder, 3);
+      gsk_render_node_encoder_write_data (encoder, &value, sizeof (double));
+    }
+}
+
+void
+gsk_render_node_encoder_write_point (GskRenderNodeEncoder   *encoder,
+                                     const graphene_point_t *point)
+{
+  gsk_render_node_encoder_write_number (encoder, point->x - encoder->last_x);
+  gsk_render_node_encoder_write_number (encoder, point->y - encoder->last_y);
+
+  encoder->last_x = point->x;
+  encoder->last_y = point->y;
+}
+
+void
+gsk_render_node_encoder_write_rect (GskRenderNodeEncoder  *encoder,
+                                    const graphene_rect_t *rect)
+{
+  gsk_render_node_encoder_write_point (encoder, &rect->origin);
+  gsk_render_node_encoder_write_number (encoder, rect->size.width);
+  gsk_render_node_encoder_write_number (encoder, rect->size.height);
+}
+
+void
+gsk_render_node_encoder_write_rounded_rect (GskRenderNodeEncoder *encoder,
+                                            const GskRoundedRect *rect)
+{
+  guint i;
+
+  gsk_render_node_encoder_write_rect (encoder, &rect->bounds);
+  for (i = 0; i < 4; i++)
+    {
+      gsk_render_node_encoder_write_number (encoder, rect->corner[i].width);
+      gsk_render_node_encoder_write_number (encoder, rect->corner[i].height);
+    }
+}
+
+static gboolean
+color_component_is_byte (double c)
+{
+  return c >= 0 && c <= 1 && round (c * 255) / 255. == c;
+}
+
+void
+gsk_render_node_encoder_write_rgba (GskRenderNodeEncoder *encoder,
+                                    const GdkRGBA        *rgba)
+{
+  if (color_component_is_byte (rgba->red) &&
+      color_component_is_byte (rgba->green) &&
+      color_component_is_byte (rgba->blue) &&
+      color_component_is_byte (rgba->alpha))
+    {
+      guint8 bytes[4] = {
+        round (rgba->red * 255),
+        round (rgba->green * 255),
+        round (rgba->blue * 255),
+        round (rgba->alpha * 255)
+      };
+
+      gsk_render_node_encoder_write_uint (encoder, 0);
+      gsk_render_node_encoder_write_data (encoder, bytes, sizeof (bytes));
+    }
+  else
+    {
+      gsk_render_node_encoder_write_uint (encoder, 1);
+      gsk_render_node_encoder_write_number (encoder, rgba->red);
+      gsk_render_node_encoder_write_number (encoder, rgba->green);
+      gsk_render_node_encoder_write_number (encoder, rgba->blue);
+      gsk_render_node_encoder_write_number (encoder, rgba->alpha);
+    }
+}
+
+void
+gsk_render_node_encoder_write_matrix (GskRenderNodeEncoder    *encoder,
+                                      const graphene_matrix_t *matrix)
+{
+  double m[6];
+  float f[16];
+  guint i;
+
+  if (graphene_matrix_to_2d (matrix, &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]))
+    {
+      gsk_render_node_encoder_write_uint (encoder, 1);
+      for (i = 0; i < 6; i++)
+        gsk_render_node_encoder_write_number (encoder, m[i]);
+    }
+  else
+    {
+      gsk_render_node_encoder_write_uint (encoder, 0);
+      graphene_matrix_to_float (matrix, f);
+      for (i = 0; i < 16; i++)
+        gsk_render_node_encoder_write_number (encoder, f[i]);
+    }
+}
+
+static void
+gsk_render_node_encoder_write_string (GskRenderNodeEncoder *encoder,
+                                      const char           *string)
+{
+  gsize len = strlen (string);
+
+  gsk_render_node_encoder_write_uint (encoder, len);
+  gsk_render_node_encoder_write_data (encoder, string, len);
+}
+
+void
+gsk_render_node_encoder_write_font (GskRenderNodeEncoder *encoder,
+                                    PangoFont            *font)
+{
+  PangoFontDescription *desc;
+  guint index;
+  char *s;
+
+  index = GPOINTER_TO_UINT (g_hash_table_lookup (encoder->fonts, font));
+  if (index > 0)
+    {
+      gsk_render_node_encoder_write_uint (encoder, index);
+      return;
+    }
+
+  desc = pango_font_describe (font);
+  s = pango_font_description_to_string (desc);
+
+  gsk_render_node_encoder_write_uint (encoder, 0);
+  gsk_render_node_encoder_write_string (encoder, s);
+
+  g_free (s);
+  pango_font_description_free (desc);
+
+  g_hash_table_insert (encoder->fonts, g_object_ref (font), GUINT_TO_POINTER (++encoder->n_fonts));
+}
+
+void
+gsk_render_node_encoder_write_glyphs (GskRenderNodeEncoder *encoder,
+                                      PangoGlyphString     *glyphs)
+{
+  int last_width = 0;
+  int i;
+
+  gsk_render_node_encoder_write_uint (encoder, glyphs->num_glyphs);
+
+  for (i = 0; i < glyphs->num_glyphs; i++)
+    {
+      PangoGlyphInfo *glyph = &glyphs->glyphs[i];
+
+      gsk_render_node_encoder_write_uint (encoder, ((guint64) glyph->glyph << 1) | glyph->attr.is_cluster_start);
+      gsk_render_node_encoder_write_int (encoder, glyph->geometry.width - last_width);
+      gsk_render_node_encoder_write_int (encoder, glyph->geometry.x_offset);
+      gsk_render_node_encoder_write_int (encoder, glyph->geometry.y_offset);
+
+      last_width = glyph->geometry.width;
+    }
+}
+
+void
+gsk_render_node_encoder_write_surface (GskRenderNodeEncoder *encoder,
+                                       cairo_surface_t      *surface,
+                                       int                   width,
+                                       int                   height)
+{
+  cairo_surface_t *image;
+  GChecksum *checksum;
+  double scale_x, scale_y;
+  const guchar *data;
+  gsize stride;
+  guint index;
+  char *hash;
+  int y;
+
+  index = GPOINTER_TO_UINT (g_hash_table_lookup (encoder->surfaces, surface));
+  if (index > 0)
+    {
+      gsk_render_node_encoder_write_uint (encoder, index);
+      return;
+    }
+
+  cairo_surface_get_device_scale (surface, &scale_x, &scale_y);
+
+  if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE &&
+      cairo_image_surface_get_format (surface) == CAIRO_FORMAT_ARGB32 &&
+      cairo_image_surface_get_width (surface) == width &&
+      cairo_image_surface_get_height (surface) == height)
+    {
+      image = cairo_surface_reference (surface);
+      cairo_surface_flush (image);
+    }
+  else
+    {
+      cairo_t *cr;
+
+      image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+      cr = cairo_create (image);
+      cairo_scale (cr, scale_x, scale_y);
+      cairo_set_source_surface (cr, surface, 0, 0);
+      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+      cairo_paint (cr);
+      cairo_destroy (cr);
+    }
+
+  data = cairo_image_surface_get_data (image);
+  stride = cairo_image_surface_get_stride (image);
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) &width, sizeof (int));
+  g_checksum_update (checksum, (const guchar *) &height, sizeof (int));
+  g_checksum_update (checksum, (const guchar *) &scale_x, sizeof (double));
+  g_checksum_update (checksum, (const guchar *) &scale_y, sizeof (double));
+  for (y = 0; y < height; y++)
+    g_checksum_update (checksum, data + y * stride, width * 4);
+  hash = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  index = GPOINTER_TO_UINT (g_hash_table_lookup (encoder->surface_hashes, hash));
+  if (index > 0)
+    {
+      gsk_render_node_encoder_write_uint (encoder, index);
+      g_free (hash);
+    }
+  else
+    {
+      index = ++encoder->n_surfaces;
+      g_hash_table_insert (encoder->surface_hashes, hash, GUINT_TO_POINTER (index));
+
+      gsk_render_node_encoder_write_uint (encoder, 0);
+      gsk_render_node_encoder_write_uint (encoder, width);
+      gsk_render_node_encoder_write_uint (encoder, height);
+      gsk_render_node_encoder_write_number (encoder, scale_x);
+      gsk_render_node_encoder_write_number (encoder, scale_y);
+
+      gsk_render_node_encoder_align (encoder);
+      for (y = 0; y < height; y++)
+        gsk_render_node_encoder_write_data (encoder, data + y * stride, width * 4);
+    }
+
+  g_hash_table_insert (encoder->surfaces, cairo_surface_reference (surface), GUINT_TO_POINTER (index));
+
+  cairo_surface_destroy (image);
+}
+
+void
+gsk_render_node_encoder_write_node (GskRenderNodeEncoder *encoder,
+                                    GskRenderNode        *node)
+{
+  gsk_render_node_encoder_write_uint (encoder, gsk_render_node_get_node_type (node));
+  node->node_class->encode (node, encoder);
+}
+
+/*< private >
+ * gsk_render_node_encode:
+ * @node: a #GskRenderNode
+ *
+ * Writes @node in the binary render node format.
+ *
+ * Returns: (transfer full): the encoded node
+ */
+GBytes *
+gsk_render_node_encode (GskRenderNode *node)
+{
+  GskRenderNodeEncoder encoder = { NULL, };
+
+  encoder.data = g_byte_array_new ();
+  encoder.fonts = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+  encoder.surfaces = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) cairo_surface_destroy, NULL);
+  encoder.surface_hashes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  gsk_render_node_encoder_write_data (&encoder, GSK_RENDER_NODE_CODER_MAGIC, 4);
+  gsk_render_node_encoder_write_uint (&encoder, GSK_RENDER_NODE_CODER_VERSION);
+  gsk_render_node_encoder_write_node (&encoder, node);
+
+  g_hash_table_unref (encoder.fonts);
+  g_hash_table_unref (encoder.surfaces);
+  g_hash_table_unref (encoder.surface_hashes);
+
+  return g_byte_array_free_to_bytes (encoder.data);
+}
+
+/* }}} */
+/* {{{ Decoding */
+
+gboolean
+gsk_render_node_decoder_failed (GskRenderNodeDecoder *decoder)
+{
+  return decoder->error != NULL;
+}
+
+void
+gsk_render_node_decoder_error (GskRenderNodeDecoder *decoder,
+                               const char           *format,
+                               ...)
+{
+  va_list args;
+
+  if (decoder->error)
+    return;
+
+  va_start (args, format);
+  decoder->error = g_error_new_valist (GSK_SERIALIZATION_ERROR, GSK_SERIALIZATION_INVALID_DATA, format, args);
+  va_end (args);
+
+  /* Stop reading */
+  decoder->pos = decoder->size;
+}
+
+static gboolean
+gsk_render_node_decoder_read_data (GskRenderNodeDecoder *decoder,
+                                   gpointer              data,
+                                   gsize                 size)
+{
+  if (decoder->size - decoder->pos < size)
+    {
+      gsk_render_node_decoder_error (decoder, "Unexpected end of data at offset %"G_GSIZE_FORMAT, decoder->pos);
+      memset (data, 0, size);
+      return FALSE;
+    }
+
+  memcpy (data, decoder->data + decoder->pos, size);
+  decoder->pos += size;
+
+  return TRUE;
+}
+
+guint64
+gsk_render_node_decoder_read_uint (GskRenderNodeDecoder *decoder)
+{
+  guint64 value = 0;
+  guint shift;
+
+  for (shift = 0; shift < 64; shift += 7)
+    {
+      guint8 byte;
+
+      if (!gsk_render_node_decoder_read_data (decoder, &byte, 1))
+        return 0;
+
+      value |= (guint64) (byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        return value;
+    }
+
+  gsk_render_node_decoder_error (decoder, "Invalid integer at offset %"G_GSIZE_FORMAT, decoder->pos);
+  return 0;
+}
+
+gint64
+gsk_render_node_decoder_read_int (GskRenderNodeDecoder *decoder)
+{
+  guint64 value = gsk_render_node_decoder_read_uint (decoder);
+
+  return (gint64) (value >> 1) ^ - (gint64) (value & 1);
+}
+
+/* Reads the number of elements in an array, each of which takes
+ * at least one byte.
+ */
+gsize
+gsk_render_node_decoder_read_count (GskRenderNodeDecoder *decoder)
+{
+  guint64 value = gsk_render_node_decoder_read_uint (decoder);
+
+  if (value > decoder->size - decoder->pos)
+    {
+      gsk_render_node_decoder_error (decoder, "Invalid array size %"G_GUINT64_FORMAT, value);
+      return 0;
+    }
+
+  return value;
+}
+
+double
+gsk_render_node_decoder_read_number (GskRenderNodeDecoder *decoder)
+{
+  guint64 tag = gsk_render_node_decoder_read_uint (decoder);
+
+  if ((tag & 1) == 0)
+    {
+      tag >>= 1;
+      return (double) ((gint64) (tag >> 1) ^ - (gint64) (tag & 1));
+    }
+  else if (tag == 1)
+    {
+      float f;
+
+      gsk_render_node_decoder_read_data (decoder, &f, sizeof (float));
+      return f;
+    }
+  else if (tag == 3)
+    {
+      double d;
+
+      gsk_render_node_decoder_read_data (decoder, &d, sizeof (double));
+      return d;
+    }
+
+  gsk_render_node_decoder_error (decoder, "Invalid number at offset %"G_GSIZE_FORMAT, decoder->pos);
+  return 0;
+}
+
+void
+gsk_render_node_decoder_read_point (GskRenderNodeDecoder *decoder,
+                                    graphene_point_t     *point)
+{
+  point->x = decoder->last_x + gsk_render_node_decoder_read_number (decoder);
+  point->y = decoder->last_y + gsk_render_node_decoder_read_number (decoder);
+
+  decoder->last_x = point->x;
+  decoder->last_y = point->y;
+}
+
+void
+gsk_render_node_decoder_read_rect (GskRenderNodeDecoder *decoder,
+                                   graphene_rect_t      *rect)
+{
+  gsk_render_node_decoder_read_point (decoder, &rect->origin);
+  rect->size.width = gsk_render_node_decoder_read_number (decoder);
+  rect->size.height = gsk_render_node_decoder_read_number (decoder);
+}
+
+void
+gsk_render_node_decoder_read_rounded_rect (GskRenderNodeDecoder *decoder,
+                                           GskRoundedRect       *rect)
+{
+  guint i;
+
+  gsk_render_node_decoder_read_rect (decoder, &rect->bounds);
+  for (i = 0; i < 4; i++)
+    {
+      rect->corner[i].width = gsk_render_node_decoder_read_number (decoder);
+      rect->corner[i].height = gsk_render_node_decoder_read_number (decoder);
+    }
+}
+
+void
+gsk_render_node_decoder_read_rgba (GskRenderNodeDecoder *decoder,
+                                   GdkRGBA              *rgba)
+{
+  if (gsk_render_node_decoder_read_uint (decoder) == 0)
+    {
+      guint8 bytes[4];
+
+      gsk_render_node_decoder_read_data (decoder, bytes, sizeof (bytes));
+      rgba->red = bytes[0] / 255.;
+      rgba->green = bytes[1] / 255.;
+      rgba->blue = bytes[2] / 255.;
+      rgba->alpha = bytes[3] / 255.;
+    }
+  else
+    {
+      rgba->red = gsk_render_node_decoder_read_number (decoder);
+      rgba->green = gsk_render_node_decoder_read_number (decoder);
+      rgba->blue = gsk_render_node_decoder_read_number (decoder);
+      rgba->alpha = gsk_render_node_decoder_read_number (decoder);
+    }
+}
+
+void
+gsk_render_node_decoder_read_matrix (GskRenderNodeDecoder *decoder,
+                                     graphene_matrix_t    *matrix)
+{
+  guint i;
+
+  if (gsk_render_node_decoder_read_uint (decoder) == 1)
+    {
+      double m[6];
+
+      for (i = 0; i < 6; i++)
+        m[i] = gsk_render_node_decoder_read_number (decoder);
+
+      graphene_matrix_init_from_2d (matrix, m[0], m[1], m[2], m[3], m[4], m[5]);
+    }
+  else
+    {
+      float f[16];
+
+      for (i = 0; i < 16; i++)
+        f[i] = gsk_render_node_decoder_read_number (decoder);
+
+      graphene_matrix_init_from_float (matrix, f);
+    }
+}
+
+static char *
+gsk_render_node_decoder_read_string (GskRenderNodeDecoder *decoder)
+{
+  gsize len = gsk_render_node_decoder_read_count (decoder);
+  char *s;
+
+  s = g_malloc (len + 1);
+  gsk_render_node_decoder_read_data (decoder, s, len);
+  s[len] = 0;
+
+  return s;
+}
+
+PangoFont *
+gsk_render_node_decoder_read_font (GskRenderNodeDecoder *decoder)
+{
+  PangoFontDescription *desc;
+  PangoFont *font;
+  guint64 index;
+  char *s;
+
+  index = gsk_render_node_decoder_read_uint (decoder);
+  if (index > 0)
+    {
+      if (index > decoder->fonts->len)
+        {
+          gsk_render_node_decoder_error (decoder, "Invalid font %"G_GUINT64_FORMAT, index);
+          return NULL;
+        }
+
+      return g_object_ref (g_ptr_array_index (decoder->fonts, index - 1));
+    }
+
+  s = gsk_render_node_decoder_read_string (decoder);
+  if (gsk_render_node_decoder_failed (decoder))
+    {
+      g_free (s);
+      return NULL;
+    }
+
+  if (decoder->context == NULL)
+    decoder->context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+
+  desc = pango_font_description_from_string (s);
+  font = pango_font_map_load_font (pango_context_get_font_map (decoder->context), decoder->context, desc);
+  pango_font_description_free (desc);
+
+  if (font == NULL)
+    {
+      gsk_render_node_decoder_error (decoder, "Could not load font \"%s\"", s);
+      g_free (s);
+      return NULL;
+    }
+  g_free (s);
+
+  g_ptr_array_add (decoder->fonts, g_object_ref (font));
+
+  return font;
+}
+
+PangoGlyphString *
+gsk_render_node_decoder_read_glyphs (GskRenderNodeDecoder *decoder)
+{
+  PangoGlyphString *glyphs;
+  int last_width = 0;
+  gsize i, n_glyphs;
+
+  n_glyphs = gsk_render_node_decoder_read_count (decoder);
+  if (n_glyphs > G_MAXINT)
+    {
+      gsk_render_node_decoder_error (decoder, "Too many glyphs");
+      return NULL;
+    }
+
+  glyphs = pango_glyph_string_new ();
+  pango_glyph_string_set_size (glyphs, n_glyphs);
+
+  for (i = 0; i < n_glyphs; i++)
+    {
+      PangoGlyphInfo *glyph = &glyphs->glyphs[i];
+      guint64 value;
+
+      value = gsk_render_node_decoder_read_uint (decoder);
+      glyph->glyph = value >> 1;
+      glyph->attr.is_cluster_start = value & 1;
+      glyph->geometry.width = last_width + gsk_render_node_decoder_read_int (decoder);
+      glyph->geometry.x_offset = gsk_render_node_decoder_read_int (decoder);
+      glyph->geometry.y_offset = gsk_render_node_decoder_read_int (decoder);
+
+      last_width = glyph->geometry.width;
+    }
+
+  return glyphs;
+}
+
+static DecodedSurface *
+gsk_render_node_decoder_read_surface_entry (GskRenderNodeDecoder *decoder)
+{
+  DecodedSurface entry = { NULL, NULL };
+  cairo_surface_t *surface;
+  guint64 index, width, height;
+  double scale_x, scale_y;
+  const guchar *data;
+  gsize padding;
+
+  index = gsk_render_node_decoder_read_uint (decoder);
+  if (index > 0)
+    {
+      if (index > decoder->surfaces->len)
+        {
+          gsk_render_node_decoder_error (decoder, "Invalid surface %"G_GUINT64_FORMAT, index);
+          return NULL;
+        }
+
+      return &g_array_index (decoder->surfaces, DecodedSurface, index - 1);
+    }
+
+  width = gsk_render_node_decoder_read_uint (decoder);
+  height = gsk_render_node_decoder_read_uint (decoder);
+  scale_x = gsk_render_node_decoder_read_number (decoder);
+  scale_y = gsk_render_node_decoder_read_number (decoder);
+
+  padding = (GSK_RENDER_NODE_CODER_ALIGNMENT - decoder->pos % GSK_RENDER_NODE_CODER_ALIGNMENT) % GSK_RENDER_NODE_CODER_ALIGNMENT;
+  if (gsk_render_node_decoder_failed (decoder) ||
+      width == 0 || width > 32767 || height == 0 || height > 32767 ||
+      !(scale_x > 0) || !(scale_y > 0) ||
+      decoder->size - decoder->pos < padding ||
+      (decoder->size - decoder->pos - padding) / 4 / width < height)
+    {
+      gsk_render_node_decoder_error (decoder, "Invalid surface at offset %"G_GSIZE_FORMAT, decoder->pos);
+      return NULL;
+    }
+
+  decoder->pos += padding;
+  data = decoder->data + decoder->pos;
+  decoder->pos += width * height * 4;
+
+  if (GPOINTER_TO_SIZE (data) % 4 == 0)
+    {
+      /* Point into the data, and keep it alive as long as the surface */
+      surface = cairo_image_surface_create_for_data ((guchar *) data,
+                                                     CAIRO_FORMAT_ARGB32,
+                                                     width, height,
+                                                     width * 4);
+      cairo_surface_set_user_data (surface,
+                                   &gsk_surface_bytes_key,
+                                   g_bytes_ref (decoder->bytes),
+                                   (cairo_destroy_func_t) g_bytes_unref);
+    }
+  else
+    {
+      guint64 y;
+
+      surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+      for (y = 0; y < height; y++)
+        memcpy (cairo_image_surface_get_data (surface) + y * cairo_image_surface_get_stride (surface),
+                data + y * width * 4,
+                width * 4);
+      cairo_surface_mark_dirty (surface);
+    }
+
+  cairo_surface_set_device_scale (surface, scale_x, scale_y);
+
+  entry.surface = surface;
+  g_array_append_val (decoder->surfaces, entry);
+
+  return &g_array_index (decoder->surfaces, DecodedSurface, decoder->surfaces->len - 1);
+}
+
+cairo_surface_t *
+gsk_render_node_decoder_read_surface (GskRenderNodeDecoder *decoder)
+{
+  DecodedSurface *entry = gsk_render_node_decoder_read_surface_entry (decoder);
+
+  if (entry == NULL)
+    return NULL;
+
+  return cairo_surface_reference (entry->surface);
+}
+
+GskTexture *
+gsk_render_node_decoder_read_texture (GskRenderNodeDecoder *decoder)
+{
+  DecodedSurface *entry = gsk_render_node_decoder_read_surface_entry (decoder);
+
+  if (entry == NULL)
+    return NULL;
+
+  if (entry->texture == NULL)
+    entry->texture = gsk_texture_new_for_surface (entry->surface);
+
+  return g_object_ref (entry->texture);
+}
+
+GskRenderNode *
+gsk_render_node_decoder_read_node (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *node;
+  guint64 type;
+
+  if (decoder->depth >= GSK_RENDER_NODE_CODER_MAX_DEPTH)
+    {
+      gsk_render_node_decoder_error (decoder, "Nodes are nested too deeply");
+      return NULL;
+    }
+
+  type = gsk_render_node_decoder_read_uint (decoder);
+  if (gsk_render_node_decoder_failed (decoder))
+    return NULL;
+
+  decoder->depth++;
+  node = gsk_render_node_decode_node (type, decoder);
+  decoder->depth--;
+
+  if (node == NULL)
+    gsk_render_node_decoder_error (decoder, "Invalid node of type %"G_GUINT64_FORMAT, type);
+
+  return node;
+}
+
+static void
+decoded_surface_clear (gpointer data)
+{
+  DecodedSurface *entry = data;
+
+  cairo_surface_destroy (entry->surface);
+  g_clear_object (&entry->texture);
+}
+
+/*< private >
+ * gsk_render_node_is_encoded:
+ * @bytes: data
+ *
+ * Checks if @bytes starts like data created with gsk_render_node_encode().
+ *
+ * Returns: %TRUE if @bytes is in the binary render node format
+ */
+gboolean
+gsk_render_node_is_encoded (GBytes *bytes)
+{
+  gsize size;
+  const guchar *data = g_bytes_get_data (bytes, &size);
+
+  return size >= 4 && memcmp (data, GSK_RENDER_NODE_CODER_MAGIC, 4) == 0;
+}
+
+/*< private >
+ * gsk_render_node_decode:
+ * @bytes: data created with gsk_render_node_encode()
+ * @error: return location for an error
+ *
+ * Reads a render node in the binary render node format.
+ *
+ * Surfaces in the node refer to the memory of @bytes where possible,
+ * so decoding data from a mapped file does not copy the pixels.
+ *
+ * Returns: (transfer full) (nullable): the decoded node
+ */
+GskRenderNode *
+gsk_render_node_decode (GBytes  *bytes,
+                        GError **error)
+{
+  GskRenderNodeDecoder decoder = { NULL, };
+  GskRenderNode *node = NULL;
+  guint64 version;
+
+  if (!gsk_render_node_is_encoded (bytes))
+    {
+      g_set_error (error, GSK_SERIALIZATION_ERROR, GSK_SERIALIZATION_UNSUPPORTED_FORMAT,
+                   "Data not in GskRenderNode serialization format.");
+      return NULL;
+    }
+
+  decoder.bytes = bytes;
+  decoder.data = g_bytes_get_data (bytes, &decoder.size);
+  decoder.pos = 4;
+  decoder.fonts = g_ptr_array_new_with_free_func (g_object_unref);
+  decoder.surfaces = g_array_new (FALSE, FALSE, sizeof (DecodedSurface));
+  g_array_set_clear_func (decoder.surfaces, decoded_surface_clear);
+
+  version = gsk_render_node_decoder_read_uint (&decoder);
+  if (version != GSK_RENDER_NODE_CODER_VERSION)
+    {
+      g_set_error (error, GSK_SERIALIZATION_ERROR, GSK_SERIALIZATION_UNSUPPORTED_VERSION,
+                   "Format version %"G_GUINT64_FORMAT" not supported.", version);
+      goto out;
+    }
+
+  node = gsk_render_node_decoder_read_node (&decoder);
+
+  if (decoder.error == NULL && decoder.pos != decoder.size)
+    gsk_render_node_decoder_error (&decoder, "Unexpected data after the node");
+
+  if (decoder.error)
+    {
+      g_clear_pointer (&node, gsk_render_node_unref);
+      g_propagate_error (error, decoder.error);
+      decoder.error = NULL;
+    }
+
+out:
+  g_clear_error (&decoder.error);
+  g_clear_object (&decoder.context);
+  g_ptr_array_unref (decoder.fonts);
+  g_array_unref (decoder.surfaces);
+
+  return node;
+}
+
+/* }}} */
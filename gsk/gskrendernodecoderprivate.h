@@ -0,0 +1,72 @@
+#ifndef __GSK_RENDER_NODE_CODER_PRIVATE_H__
+#define __GSK_RENDER_NODE_CODER_PRIVATE_H__
+
+#include "gskrendernode.h"
+#include "gsktexture.h"
+
+#include <cairo.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GskRenderNodeEncoder GskRenderNodeEncoder;
+typedef struct _GskRenderNodeDecoder GskRenderNodeDecoder;
+
+gboolean                gsk_render_node_is_encoded              (GBytes                 *bytes);
+GBytes *                gsk_render_node_encode                  (GskRenderNode          *node);
+GskRenderNode *         gsk_render_node_decode                  (GBytes                 *bytes,
+                                                                 GError                **error);
+
+void                    gsk_render_node_encoder_write_node      (GskRenderNodeEncoder   *encoder,
+                                                                 GskRenderNode          *node);
+void                    gsk_render_node_encoder_write_uint      (GskRenderNodeEncoder   *encoder,
+                                                                 guint64                 value);
+void                    gsk_render_node_encoder_write_int       (GskRenderNodeEncoder   *encoder,
+                                                                 gint64                  value);
+void                    gsk_render_node_encoder_write_number    (GskRenderNodeEncoder   *encoder,
+                                                                 double                  value);
+void                    gsk_render_node_encoder_write_point     (GskRenderNodeEncoder   *encoder,
+                                                                 const graphene_point_t *point);
+void                    gsk_render_node_encoder_write_rect      (GskRenderNodeEncoder   *encoder,
+                                                                 const graphene_rect_t  *rect);
+void                    gsk_render_node_encoder_write_rounded_rect (GskRenderNodeEncoder *encoder,
+                                                                 const GskRoundedRect   *rect);
+void                    gsk_render_node_encoder_write_rgba      (GskRenderNodeEncoder   *encoder,
+                                                                 const GdkRGBA          *rgba);
+void                    gsk_render_node_encoder_write_matrix    (GskRenderNodeEncoder   *encoder,
+                                                                 const graphene_matrix_t *matrix);
+void                    gsk_render_node_encoder_write_font      (GskRenderNodeEncoder   *encoder,
+                                                                 PangoFont              *font);
+void                    gsk_render_node_encoder_write_glyphs    (GskRenderNodeEncoder   *encoder,
+                                                                 PangoGlyphString       *glyphs);
+void                    gsk_render_node_encoder_write_surface   (GskRenderNodeEncoder   *encoder,
+                                                                 cairo_surface_t        *surface,
+                                                                 int                     width,
+                                                                 int                     height);
+
+gboolean                gsk_render_node_decoder_failed          (GskRenderNodeDecoder   *decoder);
+void                    gsk_render_node_decoder_error           (GskRenderNodeDecoder   *decoder,
+                                                                 const char             *format,
+                                                                 ...) G_GNUC_PRINTF (2, 3);
+GskRenderNode *         gsk_render_node_decoder_read_node       (GskRenderNodeDecoder   *decoder);
+guint64                 gsk_render_node_decoder_read_uint       (GskRenderNodeDecoder   *decoder);
+gint64                  gsk_render_node_decoder_read_int        (GskRenderNodeDecoder   *decoder);
+gsize                   gsk_render_node_decoder_read_count      (GskRenderNodeDecoder   *decoder);
+double                  gsk_render_node_decoder_read_number     (GskRenderNodeDecoder   *decoder);
+void                    gsk_render_node_decoder_read_point      (GskRenderNodeDecoder   *decoder,
+                                                                 graphene_point_t       *point);
+void                    gsk_render_node_decoder_read_rect       (GskRenderNodeDecoder   *decoder,
+                                                                 graphene_rect_t        *rect);
+void                    gsk_render_node_decoder_read_rounded_rect (GskRenderNodeDecoder *decoder,
+                                                                 GskRoundedRect         *rect);
+void                    gsk_render_node_decoder_read_rgba       (GskRenderNodeDecoder   *decoder,
+                                                                 GdkRGBA                *rgba);
+void                    gsk_render_node_decoder_read_matrix     (GskRenderNodeDecoder   *decoder,
+                                                                 graphene_matrix_t      *matrix);
+PangoFont *             gsk_render_node_decoder_read_font       (GskRenderNodeDecoder   *decoder);
+PangoGlyphString *      gsk_render_node_decoder_read_glyphs     (GskRenderNodeDecoder   *decoder);
+cairo_surface_t *       gsk_render_node_decoder_read_surface    (GskRenderNodeDecoder   *decoder);
+GskTexture *            gsk_render_node_decoder_read_texture    (GskRenderNodeDecoder   *decoder);
+
+G_END_DECLS
+
+#endif /* __GSK_RENDER_NODE_CODER_PRIVATE_H__ */
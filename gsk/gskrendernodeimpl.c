@@ -22,8 +22,10 @@
 
 #include "gskcairoblurprivate.h"
 #include "gskdebugprivate.h"
+#include "gskrendernodecoderprivate.h"
 #include "gskrendererprivate.h"
 #include "gskroundedrectprivate.h"
+#include "gskshadowcacheprivate.h"
 #include "gsktextureprivate.h"
 
 static gboolean
@@ -103,6 +105,46 @@ gsk_color_node_deserialize (GVariant  *variant,
   return gsk_color_node_new (&color, &GRAPHENE_RECT_INIT (x, y, w, h));
 }
 
+static void
+gsk_color_node_diff (GskRenderNode  *node1,
+                     GskRenderNode  *node2,
+                     cairo_region_t *region)
+{
+  GskColorNode *self1 = (GskColorNode *) node1;
+  GskColorNode *self2 = (GskColorNode *) node2;
+
+  if (graphene_rect_equal (&node1->bounds, &node2->bounds) &&
+      gdk_rgba_equal (&self1->color, &self2->color))
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_color_node_encode (GskRenderNode        *node,
+                       GskRenderNodeEncoder *encoder)
+{
+  GskColorNode *self = (GskColorNode *) node;
+
+  gsk_render_node_encoder_write_rect (encoder, &node->bounds);
+  gsk_render_node_encoder_write_rgba (encoder, &self->color);
+}
+
+static GskRenderNode *
+gsk_color_node_decode (GskRenderNodeDecoder *decoder)
+{
+  graphene_rect_t bounds;
+  GdkRGBA color;
+
+  gsk_render_node_decoder_read_rect (decoder, &bounds);
+  gsk_render_node_decoder_read_rgba (decoder, &color);
+
+  if (gsk_render_node_decoder_failed (decoder))
+    return NULL;
+
+  return gsk_color_node_new (&color, &bounds);
+}
+
 static const GskRenderNodeClass GSK_COLOR_NODE_CLASS = {
   GSK_COLOR_NODE,
   sizeof (GskColorNode),
@@ -111,6 +153,10 @@ static const GskRenderNodeClass GSK_COLOR_NODE_CLASS = {
   gsk_color_node_draw,
   gsk_color_node_serialize,
   gsk_color_node_deserialize,
+  gsk_color_node_diff,
+  gsk_color_node_encode,
+  gsk_color_node_decode,
+  NULL
 };
 
 const GdkRGBA *
@@ -281,6 +327,97 @@ gsk_repeating_linear_gradient_node_deserialize (GVariant  *variant,
   return gsk_linear_gradient_node_real_deserialize (variant, TRUE, error);
 }
 
+static void
+gsk_linear_gradient_node_diff (GskRenderNode  *node1,
+                               GskRenderNode  *node2,
+                               cairo_region_t *region)
+{
+  GskLinearGradientNode *self1 = (GskLinearGradientNode *) node1;
+  GskLinearGradientNode *self2 = (GskLinearGradientNode *) node2;
+
+  if (graphene_rect_equal (&node1->bounds, &node2->bounds) &&
+      graphene_point_equal (&self1->start, &self2->start) &&
+      graphene_point_equal (&self1->end, &self2->end) &&
+      self1->n_stops == self2->n_stops &&
+      memcmp (self1->stops, self2->stops, sizeof (GskColorStop) * self1->n_stops) == 0)
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_linear_gradient_node_encode (GskRenderNode        *node,
+                                 GskRenderNodeEncoder *encoder)
+{
+  GskLinearGradientNode *self = (GskLinearGradientNode *) node;
+  gsize i;
+
+  gsk_render_node_encoder_write_rect (encoder, &node->bounds);
+  gsk_render_node_encoder_write_point (encoder, &self->start);
+  gsk_render_node_encoder_write_point (encoder, &self->end);
+  gsk_render_node_encoder_write_uint (encoder, self->n_stops);
+  for (i = 0; i < self->n_stops; i++)
+    {
+      gsk_render_node_encoder_write_number (encoder, self->stops[i].offset);
+      gsk_render_node_encoder_write_rgba (encoder, &self->stops[i].color);
+    }
+}
+
+static GskRenderNode *
+gsk_linear_gradient_node_decode_common (GskRenderNodeDecoder *decoder,
+                                        gboolean              repeating)
+{
+  graphene_rect_t bounds;
+  graphene_point_t start, end;
+  GskColorStop *stops;
+  GskRenderNode *result;
+  gsize i, n_stops;
+
+  gsk_render_node_decoder_read_rect (decoder, &bounds);
+  gsk_render_node_decoder_read_point (decoder, &start);
+  gsk_render_node_decoder_read_point (decoder, &end);
+  n_stops = gsk_render_node_decoder_read_count (decoder);
+
+  stops = g_new (GskColorStop, n_stops);
+  for (i = 0; i < n_stops; i++)
+    {
+      stops[i].offset = gsk_render_node_decoder_read_number (decoder);
+      gsk_render_node_decoder_read_rgba (decoder, &stops[i].color);
+    }
+
+  if (gsk_render_node_decoder_failed (decoder))
+    result = NULL;
+  else if (repeating)
+    result = gsk_repeating_linear_gradient_node_new (&bounds, &start, &end, stops, n_stops);
+  else
+    result = gsk_linear_gradient_node_new (&bounds, &start, &end, stops, n_stops);
+
+  g_free (stops);
+
+  return result;
+}
+
+static GskRenderNode *
+gsk_linear_gradient_node_decode (GskRenderNodeDecoder *decoder)
+{
+  return gsk_linear_gradient_node_decode_common (decoder, FALSE);
+}
+
+static GskRenderNode *
+gsk_repeating_linear_gradient_node_decode (GskRenderNodeDecoder *decoder)
+{
+  return gsk_linear_gradient_node_decode_common (decoder, TRUE);
+}
+
+static void
+gsk_linear_gradient_node_collect_stats (GskRenderNode               *node,
+                                        GskRenderNodeStatsCollector *collector)
+{
+  GskLinearGradientNode *self = (GskLinearGradientNode *) node;
+
+  gsk_render_node_stats_collector_add_bytes (collector, sizeof (GskColorStop) * self->n_stops);
+}
+
 static const GskRenderNodeClass GSK_LINEAR_GRADIENT_NODE_CLASS = {
   GSK_LINEAR_GRADIENT_NODE,
   sizeof (GskLinearGradientNode),
@@ -289,6 +426,10 @@ static const GskRenderNodeClass GSK_LINEAR_GRADIENT_NODE_CLASS = {
   gsk_linear_gradient_node_draw,
   gsk_linear_gradient_node_serialize,
   gsk_linear_gradient_node_deserialize,
+  gsk_linear_gradient_node_diff,
+  gsk_linear_gradient_node_encode,
+  gsk_linear_gradient_node_decode,
+  gsk_linear_gradient_node_collect_stats
 };
 
 static const GskRenderNodeClass GSK_REPEATING_LINEAR_GRADIENT_NODE_CLASS = {
@@ -299,6 +440,10 @@ static const GskRenderNodeClass GSK_REPEATING_LINEAR_GRADIENT_NODE_CLASS = {
   gsk_linear_gradient_node_draw,
   gsk_linear_gradient_node_serialize,
   gsk_repeating_linear_gradient_node_deserialize,
+  gsk_linear_gradient_node_diff,
+  gsk_linear_gradient_node_encode,
+  gsk_repeating_linear_gradient_node_decode,
+  gsk_linear_gradient_node_collect_stats
 };
 
 /**
@@ -584,6 +729,58 @@ gsk_border_node_deserialize (GVariant  *variant,
                               colors);
 }
 
+static void
+gsk_border_node_diff (GskRenderNode  *node1,
+                      GskRenderNode  *node2,
+                      cairo_region_t *region)
+{
+  GskBorderNode *self1 = (GskBorderNode *) node1;
+  GskBorderNode *self2 = (GskBorderNode *) node2;
+
+  if (gsk_rounded_rect_equal (&self1->outline, &self2->outline) &&
+      memcmp (self1->border_width, self2->border_width, sizeof (self1->border_width)) == 0 &&
+      memcmp (self1->border_color, self2->border_color, sizeof (self1->border_color)) == 0)
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_border_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskBorderNode *self = (GskBorderNode *) node;
+  guint i;
+
+  gsk_render_node_encoder_write_rounded_rect (encoder, &self->outline);
+  for (i = 0; i < 4; i++)
+    {
+      gsk_render_node_encoder_write_number (encoder, self->border_width[i]);
+      gsk_render_node_encoder_write_rgba (encoder, &self->border_color[i]);
+    }
+}
+
+static GskRenderNode *
+gsk_border_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRoundedRect outline;
+  float border_width[4];
+  GdkRGBA border_color[4];
+  guint i;
+
+  gsk_render_node_decoder_read_rounded_rect (decoder, &outline);
+  for (i = 0; i < 4; i++)
+    {
+      border_width[i] = gsk_render_node_decoder_read_number (decoder);
+      gsk_render_node_decoder_read_rgba (decoder, &border_color[i]);
+    }
+
+  if (gsk_render_node_decoder_failed (decoder))
+    return NULL;
+
+  return gsk_border_node_new (&outline, border_width, border_color);
+}
+
 static const GskRenderNodeClass GSK_BORDER_NODE_CLASS = {
   GSK_BORDER_NODE,
   sizeof (GskBorderNode),
@@ -591,7 +788,11 @@ static const GskRenderNodeClass GSK_BORDER_NODE_CLASS = {
   gsk_border_node_finalize,
   gsk_border_node_draw,
   gsk_border_node_serialize,
-  gsk_border_node_deserialize
+  gsk_border_node_deserialize,
+  gsk_border_node_diff,
+  gsk_border_node_encode,
+  gsk_border_node_decode,
+  NULL
 };
 
 const GskRoundedRect *
@@ -757,6 +958,67 @@ gsk_texture_node_deserialize (GVariant  *variant,
   return node;
 }
 
+static void
+gsk_texture_node_diff (GskRenderNode  *node1,
+                       GskRenderNode  *node2,
+                       cairo_region_t *region)
+{
+  GskTextureNode *self1 = (GskTextureNode *) node1;
+  GskTextureNode *self2 = (GskTextureNode *) node2;
+
+  if (graphene_rect_equal (&node1->bounds, &node2->bounds) &&
+      self1->texture == self2->texture)
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_texture_node_encode (GskRenderNode        *node,
+                         GskRenderNodeEncoder *encoder)
+{
+  GskTextureNode *self = (GskTextureNode *) node;
+  cairo_surface_t *surface;
+
+  surface = gsk_texture_download_surface (self->texture);
+
+  gsk_render_node_encoder_write_rect (encoder, &node->bounds);
+  gsk_render_node_encoder_write_surface (encoder,
+                                         surface,
+                                         gsk_texture_get_width (self->texture),
+                                         gsk_texture_get_height (self->texture));
+
+  cairo_surface_destroy (surface);
+}
+
+static GskRenderNode *
+gsk_texture_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result;
+  graphene_rect_t bounds;
+  GskTexture *texture;
+
+  gsk_render_node_decoder_read_rect (decoder, &bounds);
+  texture = gsk_render_node_decoder_read_texture (decoder);
+
+  if (texture == NULL)
+    return NULL;
+
+  result = gsk_texture_node_new (texture, &bounds);
+  g_object_unref (texture);
+
+  return result;
+}
+
+static void
+gsk_texture_node_collect_stats (GskRenderNode               *node,
+                                GskRenderNodeStatsCollector *collector)
+{
+  GskTextureNode *self = (GskTextureNode *) node;
+
+  gsk_render_node_stats_collector_add_texture (collector, self->texture);
+}
+
 static const GskRenderNodeClass GSK_TEXTURE_NODE_CLASS = {
   GSK_TEXTURE_NODE,
   sizeof (GskTextureNode),
@@ -764,7 +1026,11 @@ static const GskRenderNodeClass GSK_TEXTURE_NODE_CLASS = {
   gsk_texture_node_finalize,
   gsk_texture_node_draw,
   gsk_texture_node_serialize,
-  gsk_texture_node_deserialize
+  gsk_texture_node_deserialize,
+  gsk_texture_node_diff,
+  gsk_texture_node_encode,
+  gsk_texture_node_decode,
+  gsk_texture_node_collect_stats
 };
 
 GskTexture *
@@ -901,6 +1167,11 @@ corner_mask_equal (CornerMask *mask1,
     mask1->corner.height == mask2->corner.height;
 }
 
+/* Only used for shadows that gsk_shadow_cache_draw() can't handle.
+ * The tiled Cairo renderer draws from several threads. */
+G_LOCK_DEFINE_STATIC (corner_mask_cache);
+static GHashTable *corner_mask_cache = NULL;
+
 static void
 draw_shadow_corner (cairo_t               *cr,
                     gboolean               inset,
@@ -919,7 +1190,6 @@ draw_shadow_corner (cairo_t               *cr,
   cairo_pattern_t *pattern;
   cairo_matrix_t matrix;
   float sx, sy;
-  static GHashTable *corner_mask_cache = NULL;
   float max_other;
   CornerMask key;
   gboolean overlapped;
@@ -1007,6 +1277,8 @@ draw_shadow_corner (cairo_t               *cr,
    * mask, so we cache rendered masks based on the blur radius and the
    * corner radius.
    */
+  G_LOCK (corner_mask_cache);
+
   if (corner_mask_cache == NULL)
     corner_mask_cache = g_hash_table_new_full ((GHashFunc)corner_mask_hash,
                                                (GEqualFunc)corner_mask_equal,
@@ -1031,6 +1303,8 @@ draw_shadow_corner (cairo_t               *cr,
       g_hash_table_insert (corner_mask_cache, g_memdup (&key, sizeof (key)), mask);
     }
 
+  G_UNLOCK (corner_mask_cache);
+
   gdk_cairo_set_source_rgba (cr, color);
   pattern = cairo_pattern_create_for_surface (mask);
   cairo_matrix_init_identity (&matrix);
@@ -1145,7 +1419,7 @@ gsk_inset_shadow_node_draw (GskRenderNode *node,
 
   if (!needs_blur (self->blur_radius))
     draw_shadow (cr, TRUE, &box, &clip_box, self->blur_radius, &self->color, GSK_BLUR_NONE);
-  else
+  else if (!gsk_shadow_cache_draw (cr, TRUE, &box, self->blur_radius, &self->color))
     {
       cairo_region_t *remaining;
       cairo_rectangle_int_t r;
@@ -1259,6 +1533,59 @@ gsk_inset_shadow_node_deserialize (GVariant  *variant,
                                     &color, dx, dy, spread, radius);
 }
 
+static void
+gsk_inset_shadow_node_diff (GskRenderNode  *node1,
+                            GskRenderNode  *node2,
+                            cairo_region_t *region)
+{
+  GskInsetShadowNode *self1 = (GskInsetShadowNode *) node1;
+  GskInsetShadowNode *self2 = (GskInsetShadowNode *) node2;
+
+  if (gsk_rounded_rect_equal (&self1->outline, &self2->outline) &&
+      gdk_rgba_equal (&self1->color, &self2->color) &&
+      self1->dx == self2->dx &&
+      self1->dy == self2->dy &&
+      self1->spread == self2->spread &&
+      self1->blur_radius == self2->blur_radius)
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_inset_shadow_node_encode (GskRenderNode        *node,
+                              GskRenderNodeEncoder *encoder)
+{
+  GskInsetShadowNode *self = (GskInsetShadowNode *) node;
+
+  gsk_render_node_encoder_write_rounded_rect (encoder, &self->outline);
+  gsk_render_node_encoder_write_rgba (encoder, &self->color);
+  gsk_render_node_encoder_write_number (encoder, self->dx);
+  gsk_render_node_encoder_write_number (encoder, self->dy);
+  gsk_render_node_encoder_write_number (encoder, self->spread);
+  gsk_render_node_encoder_write_number (encoder, self->blur_radius);
+}
+
+static GskRenderNode *
+gsk_inset_shadow_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRoundedRect outline;
+  GdkRGBA color;
+  float dx, dy, spread, blur_radius;
+
+  gsk_render_node_decoder_read_rounded_rect (decoder, &outline);
+  gsk_render_node_decoder_read_rgba (decoder, &color);
+  dx = gsk_render_node_decoder_read_number (decoder);
+  dy = gsk_render_node_decoder_read_number (decoder);
+  spread = gsk_render_node_decoder_read_number (decoder);
+  blur_radius = gsk_render_node_decoder_read_number (decoder);
+
+  if (gsk_render_node_decoder_failed (decoder))
+    return NULL;
+
+  return gsk_inset_shadow_node_new (&outline, &color, dx, dy, spread, blur_radius);
+}
+
 static const GskRenderNodeClass GSK_INSET_SHADOW_NODE_CLASS = {
   GSK_INSET_SHADOW_NODE,
   sizeof (GskInsetShadowNode),
@@ -1266,7 +1593,11 @@ static const GskRenderNodeClass GSK_INSET_SHADOW_NODE_CLASS = {
   gsk_inset_shadow_node_finalize,
   gsk_inset_shadow_node_draw,
   gsk_inset_shadow_node_serialize,
-  gsk_inset_shadow_node_deserialize
+  gsk_inset_shadow_node_deserialize,
+  gsk_inset_shadow_node_diff,
+  gsk_inset_shadow_node_encode,
+  gsk_inset_shadow_node_decode,
+  NULL
 };
 
 /**
@@ -1449,7 +1780,7 @@ gsk_outset_shadow_node_draw (GskRenderNode *node,
 
   if (!needs_blur (self->blur_radius))
     draw_shadow (cr, FALSE, &box, &clip_box, self->blur_radius, &self->color, GSK_BLUR_NONE);
-  else
+  else if (!gsk_shadow_cache_draw (cr, FALSE, &box, self->blur_radius, &self->color))
     {
       int i;
       cairo_region_t *remaining;
@@ -1562,6 +1893,59 @@ gsk_outset_shadow_node_deserialize (GVariant  *variant,
                                      &color, dx, dy, spread, radius);
 }
 
+static void
+gsk_outset_shadow_node_diff (GskRenderNode  *node1,
+                            GskRenderNode  *node2,
+                            cairo_region_t *region)
+{
+  GskOutsetShadowNode *self1 = (GskOutsetShadowNode *) node1;
+  GskOutsetShadowNode *self2 = (GskOutsetShadowNode *) node2;
+
+  if (gsk_rounded_rect_equal (&self1->outline, &self2->outline) &&
+      gdk_rgba_equal (&self1->color, &self2->color) &&
+      self1->dx == self2->dx &&
+      self1->dy == self2->dy &&
+      self1->spread == self2->spread &&
+      self1->blur_radius == self2->blur_radius)
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_outset_shadow_node_encode (GskRenderNode        *node,
+                              GskRenderNodeEncoder *encoder)
+{
+  GskOutsetShadowNode *self = (GskOutsetShadowNode *) node;
+
+  gsk_render_node_encoder_write_rounded_rect (encoder, &self->outline);
+  gsk_render_node_encoder_write_rgba (encoder, &self->color);
+  gsk_render_node_encoder_write_number (encoder, self->dx);
+  gsk_render_node_encoder_write_number (encoder, self->dy);
+  gsk_render_node_encoder_write_number (encoder, self->spread);
+  gsk_render_node_encoder_write_number (encoder, self->blur_radius);
+}
+
+static GskRenderNode *
+gsk_outset_shadow_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRoundedRect outline;
+  GdkRGBA color;
+  float dx, dy, spread, blur_radius;
+
+  gsk_render_node_decoder_read_rounded_rect (decoder, &outline);
+  gsk_render_node_decoder_read_rgba (decoder, &color);
+  dx = gsk_render_node_decoder_read_number (decoder);
+  dy = gsk_render_node_decoder_read_number (decoder);
+  spread = gsk_render_node_decoder_read_number (decoder);
+  blur_radius = gsk_render_node_decoder_read_number (decoder);
+
+  if (gsk_render_node_decoder_failed (decoder))
+    return NULL;
+
+  return gsk_outset_shadow_node_new (&outline, &color, dx, dy, spread, blur_radius);
+}
+
 static const GskRenderNodeClass GSK_OUTSET_SHADOW_NODE_CLASS = {
   GSK_OUTSET_SHADOW_NODE,
   sizeof (GskOutsetShadowNode),
@@ -1569,7 +1953,11 @@ static const GskRenderNodeClass GSK_OUTSET_SHADOW_NODE_CLASS = {
   gsk_outset_shadow_node_finalize,
   gsk_outset_shadow_node_draw,
   gsk_outset_shadow_node_serialize,
-  gsk_outset_shadow_node_deserialize
+  gsk_outset_shadow_node_deserialize,
+  gsk_outset_shadow_node_diff,
+  gsk_outset_shadow_node_encode,
+  gsk_outset_shadow_node_decode,
+  NULL
 };
 
 /**
@@ -1795,6 +2183,90 @@ gsk_cairo_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_cairo_node_diff (GskRenderNode  *node1,
+                     GskRenderNode  *node2,
+                     cairo_region_t *region)
+{
+  GskCairoNode *self1 = (GskCairoNode *) node1;
+  GskCairoNode *self2 = (GskCairoNode *) node2;
+
+  if (graphene_rect_equal (&node1->bounds, &node2->bounds) &&
+      self1->surface == self2->surface)
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_cairo_node_encode (GskRenderNode        *node,
+                       GskRenderNodeEncoder *encoder)
+{
+  GskCairoNode *self = (GskCairoNode *) node;
+
+  gsk_render_node_encoder_write_rect (encoder, &node->bounds);
+
+  if (self->surface == NULL)
+    {
+      gsk_render_node_encoder_write_uint (encoder, 0);
+    }
+  else
+    {
+      double scale_x, scale_y;
+
+      cairo_surface_get_device_scale (self->surface, &scale_x, &scale_y);
+
+      gsk_render_node_encoder_write_uint (encoder, 1);
+      if (cairo_surface_get_type (self->surface) == CAIRO_SURFACE_TYPE_IMAGE)
+        gsk_render_node_encoder_write_surface (encoder,
+                                               self->surface,
+                                               cairo_image_surface_get_width (self->surface),
+                                               cairo_image_surface_get_height (self->surface));
+      else
+        gsk_render_node_encoder_write_surface (encoder,
+                                               self->surface,
+                                               ceil (node->bounds.size.width * scale_x),
+                                               ceil (node->bounds.size.height * scale_y));
+    }
+}
+
+static GskRenderNode *
+gsk_cairo_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result;
+  cairo_surface_t *surface;
+  graphene_rect_t bounds;
+
+  gsk_render_node_decoder_read_rect (decoder, &bounds);
+
+  if (gsk_render_node_decoder_read_uint (decoder) == 0)
+    {
+      if (gsk_render_node_decoder_failed (decoder))
+        return NULL;
+
+      return gsk_cairo_node_new (&bounds);
+    }
+
+  surface = gsk_render_node_decoder_read_surface (decoder);
+  if (surface == NULL)
+    return NULL;
+
+  result = gsk_cairo_node_new_for_surface (&bounds, surface);
+  cairo_surface_destroy (surface);
+
+  return result;
+}
+
+static void
+gsk_cairo_node_collect_stats (GskRenderNode               *node,
+                              GskRenderNodeStatsCollector *collector)
+{
+  GskCairoNode *self = (GskCairoNode *) node;
+
+  if (self->surface)
+    gsk_render_node_stats_collector_add_surface (collector, self->surface);
+}
+
 static const GskRenderNodeClass GSK_CAIRO_NODE_CLASS = {
   GSK_CAIRO_NODE,
   sizeof (GskCairoNode),
@@ -1802,7 +2274,11 @@ static const GskRenderNodeClass GSK_CAIRO_NODE_CLASS = {
   gsk_cairo_node_finalize,
   gsk_cairo_node_draw,
   gsk_cairo_node_serialize,
-  gsk_cairo_node_deserialize
+  gsk_cairo_node_deserialize,
+  gsk_cairo_node_diff,
+  gsk_cairo_node_encode,
+  gsk_cairo_node_decode,
+  gsk_cairo_node_collect_stats
 };
 
 /*< private >
@@ -1976,10 +2452,19 @@ gsk_container_node_draw (GskRenderNode *node,
                          cairo_t       *cr)
 {
   GskContainerNode *container = (GskContainerNode *) node;
+  graphene_rect_t clip, unused;
+  double x1, y1, x2, y2;
   guint i;
 
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  graphene_rect_init (&clip, x1, y1, x2 - x1, y2 - y1);
+
   for (i = 0; i < container->n_children; i++)
     {
+      /* Skip children that are clipped out entirely */
+      if (!graphene_rect_intersection (&container->children[i]->bounds, &clip, &unused))
+        continue;
+
       gsk_render_node_draw (container->children[i], cr);
     }
 }
@@ -2061,29 +2546,137 @@ gsk_container_node_deserialize (GVariant  *variant,
   return result;
 }
 
-static const GskRenderNodeClass GSK_CONTAINER_NODE_CLASS = {
-  GSK_CONTAINER_NODE,
-  sizeof (GskContainerNode),
-  "GskContainerNode",
-  gsk_container_node_finalize,
-  gsk_container_node_draw,
-  gsk_container_node_serialize,
-  gsk_container_node_deserialize
-};
+static void
+gsk_container_node_diff (GskRenderNode  *node1,
+                         GskRenderNode  *node2,
+                         cairo_region_t *region)
+{
+  GskContainerNode *self1 = (GskContainerNode *) node1;
+  GskContainerNode *self2 = (GskContainerNode *) node2;
+  guint start, end1, end2, i;
 
-/**
- * gsk_container_node_new:
- * @children: (array length=n_children) (transfer none): The children of the node
- * @n_children: Number of children in the @children array
- *
- * Creates a new #GskRenderNode instance for holding the given @children.
- * The new node will acquire a reference to each of the children.
- *
- * Returns: (transfer full): the new #GskRenderNode
- *
- * Since: 3.90
- */
-GskRenderNode *
+  /* Skip the children that are shared at the start and at the end,
+   * which is what happens when nodes are reused between frames.
+   */
+  for (start = 0; start < MIN (self1->n_children, self2->n_children); start++)
+    {
+      if (self1->children[start] != self2->children[start])
+        break;
+    }
+
+  end1 = self1->n_children;
+  end2 = self2->n_children;
+  while (end1 > start && end2 > start &&
+         self1->children[end1 - 1] == self2->children[end2 - 1])
+    {
+      end1--;
+      end2--;
+    }
+
+  if (end1 - start == end2 - start)
+    {
+      /* Same number of changed children, compare them pairwise */
+      for (i = start; i < end1; i++)
+        gsk_render_node_diff (self1->children[i], self2->children[i], region);
+    }
+  else
+    {
+      cairo_rectangle_int_t rect;
+
+      for (i = start; i < end1; i++)
+        {
+          gsk_rect_to_cairo_grow (&self1->children[i]->bounds, &rect);
+          cairo_region_union_rectangle (region, &rect);
+        }
+      for (i = start; i < end2; i++)
+        {
+          gsk_rect_to_cairo_grow (&self2->children[i]->bounds, &rect);
+          cairo_region_union_rectangle (region, &rect);
+        }
+    }
+}
+
+static void
+gsk_container_node_encode (GskRenderNode        *node,
+                           GskRenderNodeEncoder *encoder)
+{
+  GskContainerNode *self = (GskContainerNode *) node;
+  guint i;
+
+  gsk_render_node_encoder_write_uint (encoder, self->n_children);
+  for (i = 0; i < self->n_children; i++)
+    gsk_render_node_encoder_write_node (encoder, self->children[i]);
+}
+
+static GskRenderNode *
+gsk_container_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result;
+  GskRenderNode **children;
+  gsize i, n_children;
+
+  n_children = gsk_render_node_decoder_read_count (decoder);
+
+  children = g_new0 (GskRenderNode *, n_children);
+  for (i = 0; i < n_children; i++)
+    {
+      children[i] = gsk_render_node_decoder_read_node (decoder);
+      if (children[i] == NULL)
+        break;
+    }
+
+  if (gsk_render_node_decoder_failed (decoder))
+    result = NULL;
+  else
+    result = gsk_container_node_new (children, n_children);
+
+  for (i = 0; i < n_children && children[i] != NULL; i++)
+    gsk_render_node_unref (children[i]);
+  g_free (children);
+
+  return result;
+}
+
+static void
+gsk_container_node_collect_stats (GskRenderNode               *node,
+                                  GskRenderNodeStatsCollector *collector)
+{
+  GskContainerNode *self = (GskContainerNode *) node;
+  guint i;
+
+  gsk_render_node_stats_collector_add_bytes (collector, sizeof (GskRenderNode *) * self->n_children);
+
+  for (i = 0; i < self->n_children; i++)
+    gsk_render_node_stats_collector_add_child (collector, self->children[i]);
+}
+
+static const GskRenderNodeClass GSK_CONTAINER_NODE_CLASS = {
+  GSK_CONTAINER_NODE,
+  sizeof (GskContainerNode),
+  "GskContainerNode",
+  gsk_container_node_finalize,
+  gsk_container_node_draw,
+  gsk_container_node_serialize,
+  gsk_container_node_deserialize,
+  gsk_container_node_diff,
+  gsk_container_node_encode,
+  gsk_container_node_decode,
+  gsk_container_node_collect_stats
+};
+
+/**
+ * gsk_container_node_new:
+ * @children: (array length=n_children) (transfer none): The children of the node
+ * @n_children: Number of children in the @children array
+ *
+ * Creates a new #GskRenderNode instance for holding the given @children.
+ * The new node will acquire a reference to each of the children.
+ *
+ * Returns: (transfer full): the new #GskRenderNode
+ *
+ * Since: 3.90
+ */
+GskRenderNode *
 gsk_container_node_new (GskRenderNode **children,
                         guint           n_children)
 {
@@ -2250,6 +2843,82 @@ gsk_transform_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_transform_node_diff (GskRenderNode  *node1,
+                         GskRenderNode  *node2,
+                         cairo_region_t *region)
+{
+  GskTransformNode *self1 = (GskTransformNode *) node1;
+  GskTransformNode *self2 = (GskTransformNode *) node2;
+  float mat1[16], mat2[16];
+  cairo_matrix_t ctm;
+  cairo_region_t *sub;
+
+  graphene_matrix_to_float (&self1->transform, mat1);
+  graphene_matrix_to_float (&self2->transform, mat2);
+
+  if (memcmp (mat1, mat2, sizeof (mat1)) != 0)
+    {
+      gsk_render_node_diff_impossible (node1, node2, region);
+      return;
+    }
+
+  if (self1->child == self2->child)
+    return;
+
+  /* Only integer translations map the child's damage to a region exactly */
+  if (!graphene_matrix_to_2d (&self1->transform, &ctm.xx, &ctm.yx, &ctm.xy, &ctm.yy, &ctm.x0, &ctm.y0) ||
+      ctm.xx != 1.0 || ctm.yy != 1.0 || ctm.xy != 0.0 || ctm.yx != 0.0 ||
+      ctm.x0 != floor (ctm.x0) || ctm.y0 != floor (ctm.y0))
+    {
+      gsk_render_node_diff_impossible (node1, node2, region);
+      return;
+    }
+
+  sub = cairo_region_create ();
+  gsk_render_node_diff (self1->child, self2->child, sub);
+  cairo_region_translate (sub, ctm.x0, ctm.y0);
+  cairo_region_union (region, sub);
+  cairo_region_destroy (sub);
+}
+
+static void
+gsk_transform_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskTransformNode *self = (GskTransformNode *) node;
+
+  gsk_render_node_encoder_write_matrix (encoder, &self->transform);
+  gsk_render_node_encoder_write_node (encoder, self->child);
+}
+
+static GskRenderNode *
+gsk_transform_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *child;
+  graphene_matrix_t transform;
+
+  gsk_render_node_decoder_read_matrix (decoder, &transform);
+  child = gsk_render_node_decoder_read_node (decoder);
+
+  if (child == NULL)
+    return NULL;
+
+  result = gsk_transform_node_new (child, &transform);
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static void
+gsk_transform_node_collect_stats (GskRenderNode               *node,
+                                  GskRenderNodeStatsCollector *collector)
+{
+  GskTransformNode *self = (GskTransformNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->child);
+}
+
 static const GskRenderNodeClass GSK_TRANSFORM_NODE_CLASS = {
   GSK_TRANSFORM_NODE,
   sizeof (GskTransformNode),
@@ -2257,7 +2926,11 @@ static const GskRenderNodeClass GSK_TRANSFORM_NODE_CLASS = {
   gsk_transform_node_finalize,
   gsk_transform_node_draw,
   gsk_transform_node_serialize,
-  gsk_transform_node_deserialize
+  gsk_transform_node_deserialize,
+  gsk_transform_node_diff,
+  gsk_transform_node_encode,
+  gsk_transform_node_decode,
+  gsk_transform_node_collect_stats
 };
 
 /**
@@ -2406,6 +3079,57 @@ gsk_opacity_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_opacity_node_diff (GskRenderNode  *node1,
+                       GskRenderNode  *node2,
+                       cairo_region_t *region)
+{
+  GskOpacityNode *self1 = (GskOpacityNode *) node1;
+  GskOpacityNode *self2 = (GskOpacityNode *) node2;
+
+  if (self1->opacity == self2->opacity)
+    gsk_render_node_diff (self1->child, self2->child, region);
+  else
+    gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_opacity_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskOpacityNode *self = (GskOpacityNode *) node;
+
+  gsk_render_node_encoder_write_number (encoder, self->opacity);
+  gsk_render_node_encoder_write_node (encoder, self->child);
+}
+
+static GskRenderNode *
+gsk_opacity_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *child;
+  double opacity;
+
+  opacity = gsk_render_node_decoder_read_number (decoder);
+  child = gsk_render_node_decoder_read_node (decoder);
+
+  if (child == NULL)
+    return NULL;
+
+  result = gsk_opacity_node_new (child, opacity);
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static void
+gsk_opacity_node_collect_stats (GskRenderNode               *node,
+                                GskRenderNodeStatsCollector *collector)
+{
+  GskOpacityNode *self = (GskOpacityNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->child);
+}
+
 static const GskRenderNodeClass GSK_OPACITY_NODE_CLASS = {
   GSK_OPACITY_NODE,
   sizeof (GskOpacityNode),
@@ -2413,7 +3137,11 @@ static const GskRenderNodeClass GSK_OPACITY_NODE_CLASS = {
   gsk_opacity_node_finalize,
   gsk_opacity_node_draw,
   gsk_opacity_node_serialize,
-  gsk_opacity_node_deserialize
+  gsk_opacity_node_deserialize,
+  gsk_opacity_node_diff,
+  gsk_opacity_node_encode,
+  gsk_opacity_node_decode,
+  gsk_opacity_node_collect_stats
 };
 
 /**
@@ -2643,6 +3371,76 @@ gsk_color_matrix_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_color_matrix_node_diff (GskRenderNode  *node1,
+                            GskRenderNode  *node2,
+                            cairo_region_t *region)
+{
+  GskColorMatrixNode *self1 = (GskColorMatrixNode *) node1;
+  GskColorMatrixNode *self2 = (GskColorMatrixNode *) node2;
+  float mat1[16], mat2[16];
+  float vec1[4], vec2[4];
+
+  graphene_matrix_to_float (&self1->color_matrix, mat1);
+  graphene_matrix_to_float (&self2->color_matrix, mat2);
+  graphene_vec4_to_float (&self1->color_offset, vec1);
+  graphene_vec4_to_float (&self2->color_offset, vec2);
+
+  if (memcmp (mat1, mat2, sizeof (mat1)) == 0 &&
+      memcmp (vec1, vec2, sizeof (vec1)) == 0)
+    gsk_render_node_diff (self1->child, self2->child, region);
+  else
+    gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_color_matrix_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskColorMatrixNode *self = (GskColorMatrixNode *) node;
+  float offset[4];
+  guint i;
+
+  gsk_render_node_encoder_write_matrix (encoder, &self->color_matrix);
+  graphene_vec4_to_float (&self->color_offset, offset);
+  for (i = 0; i < 4; i++)
+    gsk_render_node_encoder_write_number (encoder, offset[i]);
+  gsk_render_node_encoder_write_node (encoder, self->child);
+}
+
+static GskRenderNode *
+gsk_color_matrix_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *child;
+  graphene_matrix_t color_matrix;
+  graphene_vec4_t color_offset;
+  float offset[4];
+  guint i;
+
+  gsk_render_node_decoder_read_matrix (decoder, &color_matrix);
+  for (i = 0; i < 4; i++)
+    offset[i] = gsk_render_node_decoder_read_number (decoder);
+  graphene_vec4_init_from_float (&color_offset, offset);
+  child = gsk_render_node_decoder_read_node (decoder);
+
+  if (child == NULL)
+    return NULL;
+
+  result = gsk_color_matrix_node_new (child, &color_matrix, &color_offset);
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static void
+gsk_color_matrix_node_collect_stats (GskRenderNode               *node,
+                                     GskRenderNodeStatsCollector *collector)
+{
+  GskColorMatrixNode *self = (GskColorMatrixNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->child);
+}
+
 static const GskRenderNodeClass GSK_COLOR_MATRIX_NODE_CLASS = {
   GSK_COLOR_MATRIX_NODE,
   sizeof (GskColorMatrixNode),
@@ -2650,7 +3448,11 @@ static const GskRenderNodeClass GSK_COLOR_MATRIX_NODE_CLASS = {
   gsk_color_matrix_node_finalize,
   gsk_color_matrix_node_draw,
   gsk_color_matrix_node_serialize,
-  gsk_color_matrix_node_deserialize
+  gsk_color_matrix_node_deserialize,
+  gsk_color_matrix_node_diff,
+  gsk_color_matrix_node_encode,
+  gsk_color_matrix_node_decode,
+  gsk_color_matrix_node_collect_stats
 };
 
 /**
@@ -2833,6 +3635,61 @@ gsk_repeat_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_repeat_node_diff (GskRenderNode  *node1,
+                      GskRenderNode  *node2,
+                      cairo_region_t *region)
+{
+  GskRepeatNode *self1 = (GskRepeatNode *) node1;
+  GskRepeatNode *self2 = (GskRepeatNode *) node2;
+
+  if (graphene_rect_equal (&node1->bounds, &node2->bounds) &&
+      graphene_rect_equal (&self1->child_bounds, &self2->child_bounds) &&
+      self1->child == self2->child)
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_repeat_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskRepeatNode *self = (GskRepeatNode *) node;
+
+  gsk_render_node_encoder_write_rect (encoder, &node->bounds);
+  gsk_render_node_encoder_write_rect (encoder, &self->child_bounds);
+  gsk_render_node_encoder_write_node (encoder, self->child);
+}
+
+static GskRenderNode *
+gsk_repeat_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *child;
+  graphene_rect_t bounds, child_bounds;
+
+  gsk_render_node_decoder_read_rect (decoder, &bounds);
+  gsk_render_node_decoder_read_rect (decoder, &child_bounds);
+  child = gsk_render_node_decoder_read_node (decoder);
+
+  if (child == NULL)
+    return NULL;
+
+  result = gsk_repeat_node_new (&bounds, child, &child_bounds);
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static void
+gsk_repeat_node_collect_stats (GskRenderNode               *node,
+                               GskRenderNodeStatsCollector *collector)
+{
+  GskRepeatNode *self = (GskRepeatNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->child);
+}
+
 static const GskRenderNodeClass GSK_REPEAT_NODE_CLASS = {
   GSK_REPEAT_NODE,
   sizeof (GskRepeatNode),
@@ -2840,7 +3697,11 @@ static const GskRenderNodeClass GSK_REPEAT_NODE_CLASS = {
   gsk_repeat_node_finalize,
   gsk_repeat_node_draw,
   gsk_repeat_node_serialize,
-  gsk_repeat_node_deserialize
+  gsk_repeat_node_deserialize,
+  gsk_repeat_node_diff,
+  gsk_repeat_node_encode,
+  gsk_repeat_node_decode,
+  gsk_repeat_node_collect_stats
 };
 
 /**
@@ -2980,6 +3841,69 @@ gsk_clip_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_clip_node_diff (GskRenderNode  *node1,
+                    GskRenderNode  *node2,
+                    cairo_region_t *region)
+{
+  GskClipNode *self1 = (GskClipNode *) node1;
+  GskClipNode *self2 = (GskClipNode *) node2;
+
+  if (graphene_rect_equal (&self1->clip, &self2->clip))
+    {
+      cairo_region_t *sub;
+      cairo_rectangle_int_t clip_rect;
+
+      sub = cairo_region_create ();
+      gsk_render_node_diff (self1->child, self2->child, sub);
+      gsk_rect_to_cairo_grow (&self1->clip, &clip_rect);
+      cairo_region_intersect_rectangle (sub, &clip_rect);
+      cairo_region_union (region, sub);
+      cairo_region_destroy (sub);
+    }
+  else
+    {
+      gsk_render_node_diff_impossible (node1, node2, region);
+    }
+}
+
+static void
+gsk_clip_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskClipNode *self = (GskClipNode *) node;
+
+  gsk_render_node_encoder_write_rect (encoder, &self->clip);
+  gsk_render_node_encoder_write_node (encoder, self->child);
+}
+
+static GskRenderNode *
+gsk_clip_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *child;
+  graphene_rect_t clip;
+
+  gsk_render_node_decoder_read_rect (decoder, &clip);
+  child = gsk_render_node_decoder_read_node (decoder);
+
+  if (child == NULL)
+    return NULL;
+
+  result = gsk_clip_node_new (child, &clip);
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static void
+gsk_clip_node_collect_stats (GskRenderNode               *node,
+                             GskRenderNodeStatsCollector *collector)
+{
+  GskClipNode *self = (GskClipNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->child);
+}
+
 static const GskRenderNodeClass GSK_CLIP_NODE_CLASS = {
   GSK_CLIP_NODE,
   sizeof (GskClipNode),
@@ -2987,7 +3911,11 @@ static const GskRenderNodeClass GSK_CLIP_NODE_CLASS = {
   gsk_clip_node_finalize,
   gsk_clip_node_draw,
   gsk_clip_node_serialize,
-  gsk_clip_node_deserialize
+  gsk_clip_node_deserialize,
+  gsk_clip_node_diff,
+  gsk_clip_node_encode,
+  gsk_clip_node_decode,
+  gsk_clip_node_collect_stats
 };
 
 /**
@@ -3143,6 +4071,69 @@ gsk_rounded_clip_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_rounded_clip_node_diff (GskRenderNode  *node1,
+                            GskRenderNode  *node2,
+                            cairo_region_t *region)
+{
+  GskRoundedClipNode *self1 = (GskRoundedClipNode *) node1;
+  GskRoundedClipNode *self2 = (GskRoundedClipNode *) node2;
+
+  if (gsk_rounded_rect_equal (&self1->clip, &self2->clip))
+    {
+      cairo_region_t *sub;
+      cairo_rectangle_int_t clip_rect;
+
+      sub = cairo_region_create ();
+      gsk_render_node_diff (self1->child, self2->child, sub);
+      gsk_rect_to_cairo_grow (&self1->clip.bounds, &clip_rect);
+      cairo_region_intersect_rectangle (sub, &clip_rect);
+      cairo_region_union (region, sub);
+      cairo_region_destroy (sub);
+    }
+  else
+    {
+      gsk_render_node_diff_impossible (node1, node2, region);
+    }
+}
+
+static void
+gsk_rounded_clip_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskRoundedClipNode *self = (GskRoundedClipNode *) node;
+
+  gsk_render_node_encoder_write_rounded_rect (encoder, &self->clip);
+  gsk_render_node_encoder_write_node (encoder, self->child);
+}
+
+static GskRenderNode *
+gsk_rounded_clip_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *child;
+  GskRoundedRect clip;
+
+  gsk_render_node_decoder_read_rounded_rect (decoder, &clip);
+  child = gsk_render_node_decoder_read_node (decoder);
+
+  if (child == NULL)
+    return NULL;
+
+  result = gsk_rounded_clip_node_new (child, &clip);
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static void
+gsk_rounded_clip_node_collect_stats (GskRenderNode               *node,
+                                     GskRenderNodeStatsCollector *collector)
+{
+  GskRoundedClipNode *self = (GskRoundedClipNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->child);
+}
+
 static const GskRenderNodeClass GSK_ROUNDED_CLIP_NODE_CLASS = {
   GSK_ROUNDED_CLIP_NODE,
   sizeof (GskRoundedClipNode),
@@ -3150,7 +4141,11 @@ static const GskRenderNodeClass GSK_ROUNDED_CLIP_NODE_CLASS = {
   gsk_rounded_clip_node_finalize,
   gsk_rounded_clip_node_draw,
   gsk_rounded_clip_node_serialize,
-  gsk_rounded_clip_node_deserialize
+  gsk_rounded_clip_node_deserialize,
+  gsk_rounded_clip_node_diff,
+  gsk_rounded_clip_node_encode,
+  gsk_rounded_clip_node_decode,
+  gsk_rounded_clip_node_collect_stats
 };
 
 /**
@@ -3368,6 +4363,93 @@ gsk_shadow_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_shadow_node_diff (GskRenderNode  *node1,
+                      GskRenderNode  *node2,
+                      cairo_region_t *region)
+{
+  GskShadowNode *self1 = (GskShadowNode *) node1;
+  GskShadowNode *self2 = (GskShadowNode *) node2;
+  cairo_region_t *sub;
+
+  if (self1->n_shadows != self2->n_shadows ||
+      memcmp (self1->shadows, self2->shadows, sizeof (GskShadow) * self1->n_shadows) != 0)
+    {
+      gsk_render_node_diff_impossible (node1, node2, region);
+      return;
+    }
+
+  /* Changes to the child move its shadows, too */
+  sub = cairo_region_create ();
+  gsk_render_node_diff (self1->child, self2->child, sub);
+  if (!cairo_region_is_empty (sub))
+    gsk_render_node_diff_impossible (node1, node2, region);
+  cairo_region_destroy (sub);
+}
+
+static void
+gsk_shadow_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskShadowNode *self = (GskShadowNode *) node;
+  gsize i;
+
+  gsk_render_node_encoder_write_uint (encoder, self->n_shadows);
+  for (i = 0; i < self->n_shadows; i++)
+    {
+      gsk_render_node_encoder_write_rgba (encoder, &self->shadows[i].color);
+      gsk_render_node_encoder_write_number (encoder, self->shadows[i].dx);
+      gsk_render_node_encoder_write_number (encoder, self->shadows[i].dy);
+      gsk_render_node_encoder_write_number (encoder, self->shadows[i].radius);
+    }
+  gsk_render_node_encoder_write_node (encoder, self->child);
+}
+
+static GskRenderNode *
+gsk_shadow_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *child;
+  GskShadow *shadows;
+  gsize i, n_shadows;
+
+  n_shadows = gsk_render_node_decoder_read_count (decoder);
+  if (n_shadows == 0)
+    return NULL;
+
+  shadows = g_new (GskShadow, n_shadows);
+  for (i = 0; i < n_shadows; i++)
+    {
+      gsk_render_node_decoder_read_rgba (decoder, &shadows[i].color);
+      shadows[i].dx = gsk_render_node_decoder_read_number (decoder);
+      shadows[i].dy = gsk_render_node_decoder_read_number (decoder);
+      shadows[i].radius = gsk_render_node_decoder_read_number (decoder);
+    }
+  child = gsk_render_node_decoder_read_node (decoder);
+
+  if (child == NULL)
+    {
+      g_free (shadows);
+      return NULL;
+    }
+
+  result = gsk_shadow_node_new (child, shadows, n_shadows);
+
+  gsk_render_node_unref (child);
+  g_free (shadows);
+
+  return result;
+}
+
+static void
+gsk_shadow_node_collect_stats (GskRenderNode               *node,
+                               GskRenderNodeStatsCollector *collector)
+{
+  GskShadowNode *self = (GskShadowNode *) node;
+
+  gsk_render_node_stats_collector_add_bytes (collector, sizeof (GskShadow) * self->n_shadows);
+  gsk_render_node_stats_collector_add_child (collector, self->child);
+}
+
 static const GskRenderNodeClass GSK_SHADOW_NODE_CLASS = {
   GSK_SHADOW_NODE,
   sizeof (GskShadowNode),
@@ -3375,7 +4457,11 @@ static const GskRenderNodeClass GSK_SHADOW_NODE_CLASS = {
   gsk_shadow_node_finalize,
   gsk_shadow_node_draw,
   gsk_shadow_node_serialize,
-  gsk_shadow_node_deserialize
+  gsk_shadow_node_deserialize,
+  gsk_shadow_node_diff,
+  gsk_shadow_node_encode,
+  gsk_shadow_node_decode,
+  gsk_shadow_node_collect_stats
 };
 
 /**
@@ -3584,6 +4670,78 @@ gsk_blend_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_blend_node_diff (GskRenderNode  *node1,
+                     GskRenderNode  *node2,
+                     cairo_region_t *region)
+{
+  GskBlendNode *self1 = (GskBlendNode *) node1;
+  GskBlendNode *self2 = (GskBlendNode *) node2;
+
+  if (self1->blend_mode == self2->blend_mode)
+    {
+      gsk_render_node_diff (self1->top, self2->top, region);
+      gsk_render_node_diff (self1->bottom, self2->bottom, region);
+    }
+  else
+    {
+      gsk_render_node_diff_impossible (node1, node2, region);
+    }
+}
+
+static void
+gsk_blend_node_encode (GskRenderNode        *node,
+                       GskRenderNodeEncoder *encoder)
+{
+  GskBlendNode *self = (GskBlendNode *) node;
+
+  gsk_render_node_encoder_write_uint (encoder, self->blend_mode);
+  gsk_render_node_encoder_write_node (encoder, self->bottom);
+  gsk_render_node_encoder_write_node (encoder, self->top);
+}
+
+static GskRenderNode *
+gsk_blend_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *bottom, *top;
+  guint64 blend_mode;
+
+  blend_mode = gsk_render_node_decoder_read_uint (decoder);
+  if (blend_mode > GSK_BLEND_MODE_LUMINOSITY)
+    {
+      gsk_render_node_decoder_error (decoder, "Invalid blend mode %"G_GUINT64_FORMAT, blend_mode);
+      return NULL;
+    }
+
+  bottom = gsk_render_node_decoder_read_node (decoder);
+  if (bottom == NULL)
+    return NULL;
+
+  top = gsk_render_node_decoder_read_node (decoder);
+  if (top == NULL)
+    {
+      gsk_render_node_unref (bottom);
+      return NULL;
+    }
+
+  result = gsk_blend_node_new (bottom, top, blend_mode);
+
+  gsk_render_node_unref (bottom);
+  gsk_render_node_unref (top);
+
+  return result;
+}
+
+static void
+gsk_blend_node_collect_stats (GskRenderNode               *node,
+                              GskRenderNodeStatsCollector *collector)
+{
+  GskBlendNode *self = (GskBlendNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->bottom);
+  gsk_render_node_stats_collector_add_child (collector, self->top);
+}
+
 static const GskRenderNodeClass GSK_BLEND_NODE_CLASS = {
   GSK_BLEND_NODE,
   sizeof (GskBlendNode),
@@ -3591,7 +4749,11 @@ static const GskRenderNodeClass GSK_BLEND_NODE_CLASS = {
   gsk_blend_node_finalize,
   gsk_blend_node_draw,
   gsk_blend_node_serialize,
-  gsk_blend_node_deserialize
+  gsk_blend_node_deserialize,
+  gsk_blend_node_diff,
+  gsk_blend_node_encode,
+  gsk_blend_node_decode,
+  gsk_blend_node_collect_stats
 };
 
 /**
@@ -3756,6 +4918,72 @@ gsk_cross_fade_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_cross_fade_node_diff (GskRenderNode  *node1,
+                          GskRenderNode  *node2,
+                          cairo_region_t *region)
+{
+  GskCrossFadeNode *self1 = (GskCrossFadeNode *) node1;
+  GskCrossFadeNode *self2 = (GskCrossFadeNode *) node2;
+
+  if (self1->progress == self2->progress)
+    {
+      gsk_render_node_diff (self1->start, self2->start, region);
+      gsk_render_node_diff (self1->end, self2->end, region);
+      return;
+    }
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_cross_fade_node_encode (GskRenderNode        *node,
+                            GskRenderNodeEncoder *encoder)
+{
+  GskCrossFadeNode *self = (GskCrossFadeNode *) node;
+
+  gsk_render_node_encoder_write_number (encoder, self->progress);
+  gsk_render_node_encoder_write_node (encoder, self->start);
+  gsk_render_node_encoder_write_node (encoder, self->end);
+}
+
+static GskRenderNode *
+gsk_cross_fade_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *start, *end;
+  double progress;
+
+  progress = gsk_render_node_decoder_read_number (decoder);
+
+  start = gsk_render_node_decoder_read_node (decoder);
+  if (start == NULL)
+    return NULL;
+
+  end = gsk_render_node_decoder_read_node (decoder);
+  if (end == NULL)
+    {
+      gsk_render_node_unref (start);
+      return NULL;
+    }
+
+  result = gsk_cross_fade_node_new (start, end, progress);
+
+  gsk_render_node_unref (start);
+  gsk_render_node_unref (end);
+
+  return result;
+}
+
+static void
+gsk_cross_fade_node_collect_stats (GskRenderNode               *node,
+                                   GskRenderNodeStatsCollector *collector)
+{
+  GskCrossFadeNode *self = (GskCrossFadeNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->start);
+  gsk_render_node_stats_collector_add_child (collector, self->end);
+}
+
 static const GskRenderNodeClass GSK_CROSS_FADE_NODE_CLASS = {
   GSK_CROSS_FADE_NODE,
   sizeof (GskCrossFadeNode),
@@ -3763,7 +4991,11 @@ static const GskRenderNodeClass GSK_CROSS_FADE_NODE_CLASS = {
   gsk_cross_fade_node_finalize,
   gsk_cross_fade_node_draw,
   gsk_cross_fade_node_serialize,
-  gsk_cross_fade_node_deserialize
+  gsk_cross_fade_node_deserialize,
+  gsk_cross_fade_node_diff,
+  gsk_cross_fade_node_encode,
+  gsk_cross_fade_node_decode,
+  gsk_cross_fade_node_collect_stats
 };
 
 /**
@@ -4013,6 +5245,78 @@ gsk_text_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_text_node_diff (GskRenderNode  *node1,
+                    GskRenderNode  *node2,
+                    cairo_region_t *region)
+{
+  GskTextNode *self1 = (GskTextNode *) node1;
+  GskTextNode *self2 = (GskTextNode *) node2;
+
+  if (self1->font == self2->font &&
+      gdk_rgba_equal (&self1->color, &self2->color) &&
+      self1->x == self2->x &&
+      self1->y == self2->y &&
+      self1->glyphs->num_glyphs == self2->glyphs->num_glyphs &&
+      memcmp (self1->glyphs->glyphs, self2->glyphs->glyphs,
+              sizeof (PangoGlyphInfo) * self1->glyphs->num_glyphs) == 0)
+    return;
+
+  gsk_render_node_diff_impossible (node1, node2, region);
+}
+
+static void
+gsk_text_node_encode (GskRenderNode        *node,
+                      GskRenderNodeEncoder *encoder)
+{
+  GskTextNode *self = (GskTextNode *) node;
+
+  gsk_render_node_encoder_write_font (encoder, self->font);
+  gsk_render_node_encoder_write_rgba (encoder, &self->color);
+  gsk_render_node_encoder_write_point (encoder, &GRAPHENE_POINT_INIT (self->x, self->y));
+  gsk_render_node_encoder_write_glyphs (encoder, self->glyphs);
+}
+
+static GskRenderNode *
+gsk_text_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result;
+  PangoGlyphString *glyphs;
+  graphene_point_t offset;
+  PangoFont *font;
+  GdkRGBA color;
+
+  font = gsk_render_node_decoder_read_font (decoder);
+  if (font == NULL)
+    return NULL;
+
+  gsk_render_node_decoder_read_rgba (decoder, &color);
+  gsk_render_node_decoder_read_point (decoder, &offset);
+  glyphs = gsk_render_node_decoder_read_glyphs (decoder);
+
+  if (glyphs == NULL || gsk_render_node_decoder_failed (decoder))
+    result = NULL;
+  else
+    result = gsk_text_node_new (font, glyphs, &color, offset.x, offset.y);
+
+  if (glyphs)
+    pango_glyph_string_free (glyphs);
+  g_object_unref (font);
+
+  return result;
+}
+
+static void
+gsk_text_node_collect_stats (GskRenderNode               *node,
+                             GskRenderNodeStatsCollector *collector)
+{
+  GskTextNode *self = (GskTextNode *) node;
+
+  gsk_render_node_stats_collector_add_bytes (collector,
+                                             sizeof (PangoGlyphString) +
+                                             self->glyphs->num_glyphs * (sizeof (PangoGlyphInfo) + sizeof (int)));
+}
+
 static const GskRenderNodeClass GSK_TEXT_NODE_CLASS = {
   GSK_TEXT_NODE,
   sizeof (GskTextNode),
@@ -4020,7 +5324,11 @@ static const GskRenderNodeClass GSK_TEXT_NODE_CLASS = {
   gsk_text_node_finalize,
   gsk_text_node_draw,
   gsk_text_node_serialize,
-  gsk_text_node_deserialize
+  gsk_text_node_deserialize,
+  gsk_text_node_diff,
+  gsk_text_node_encode,
+  gsk_text_node_decode,
+  gsk_text_node_collect_stats
 };
 
 /**
@@ -4058,6 +5366,11 @@ gsk_text_node_new (PangoFont        *font,
 
   self = (GskTextNode *) gsk_render_node_new (&GSK_TEXT_NODE_CLASS, 0);
 
+  /* Create the scaled font now, so that the node can be drawn from
+   * other threads without racing on its lazy initialization.
+   */
+  pango_cairo_font_get_scaled_font ((PangoCairoFont *) font);
+
   self->font = g_object_ref (font);
   self->glyphs = pango_glyph_string_copy (glyphs);
   self->color = *color;
@@ -4357,6 +5670,66 @@ gsk_blur_node_deserialize (GVariant  *variant,
   return result;
 }
 
+static void
+gsk_blur_node_diff (GskRenderNode  *node1,
+                    GskRenderNode  *node2,
+                    cairo_region_t *region)
+{
+  GskBlurNode *self1 = (GskBlurNode *) node1;
+  GskBlurNode *self2 = (GskBlurNode *) node2;
+  cairo_region_t *sub;
+
+  if (self1->radius != self2->radius)
+    {
+      gsk_render_node_diff_impossible (node1, node2, region);
+      return;
+    }
+
+  /* Blurring spreads the child's changes over the whole node */
+  sub = cairo_region_create ();
+  gsk_render_node_diff (self1->child, self2->child, sub);
+  if (!cairo_region_is_empty (sub))
+    gsk_render_node_diff_impossible (node1, node2, region);
+  cairo_region_destroy (sub);
+}
+
+static void
+gsk_blur_node_encode (GskRenderNode        *node,
+                        GskRenderNodeEncoder *encoder)
+{
+  GskBlurNode *self = (GskBlurNode *) node;
+
+  gsk_render_node_encoder_write_number (encoder, self->radius);
+  gsk_render_node_encoder_write_node (encoder, self->child);
+}
+
+static GskRenderNode *
+gsk_blur_node_decode (GskRenderNodeDecoder *decoder)
+{
+  GskRenderNode *result, *child;
+  double radius;
+
+  radius = gsk_render_node_decoder_read_number (decoder);
+  child = gsk_render_node_decoder_read_node (decoder);
+
+  if (child == NULL)
+    return NULL;
+
+  result = gsk_blur_node_new (child, radius);
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static void
+gsk_blur_node_collect_stats (GskRenderNode               *node,
+                             GskRenderNodeStatsCollector *collector)
+{
+  GskBlurNode *self = (GskBlurNode *) node;
+
+  gsk_render_node_stats_collector_add_child (collector, self->child);
+}
+
 static const GskRenderNodeClass GSK_BLUR_NODE_CLASS = {
   GSK_BLUR_NODE,
   sizeof (GskBlurNode),
@@ -4364,7 +5737,11 @@ static const GskRenderNodeClass GSK_BLUR_NODE_CLASS = {
   gsk_blur_node_finalize,
   gsk_blur_node_draw,
   gsk_blur_node_serialize,
-  gsk_blur_node_deserialize
+  gsk_blur_node_deserialize,
+  gsk_blur_node_diff,
+  gsk_blur_node_encode,
+  gsk_blur_node_decode,
+  gsk_blur_node_collect_stats
 };
 
 /**
@@ -4468,3 +5845,141 @@ gsk_render_node_serialize_node (GskRenderNode *node)
   return node->node_class->serialize (node);
 }
 
+GskRenderNode *
+gsk_render_node_decode_node (guint64               type,
+                             GskRenderNodeDecoder *decoder)
+{
+  const GskRenderNodeClass *klass;
+
+  if (type < G_N_ELEMENTS (klasses))
+    klass = klasses[type];
+  else
+    klass = NULL;
+
+  if (klass == NULL)
+    return NULL;
+
+  return klass->decode (decoder);
+}
+
+
+/*< private >
+ * gsk_render_node_promote_children:
+ * @node: a render node that was just moved out of an arena
+ *
+ * Calls gsk_render_node_promote() on the children of @node and
+ * replaces them with the result.
+ */
+void
+gsk_render_node_promote_children (GskRenderNode *node)
+{
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        GskContainerNode *self = (GskContainerNode *) node;
+        guint i;
+
+        for (i = 0; i < self->n_children; i++)
+          self->children[i] = gsk_render_node_promote (self->children[i]);
+      }
+      break;
+
+    case GSK_TRANSFORM_NODE:
+      {
+        GskTransformNode *self = (GskTransformNode *) node;
+
+        self->child = gsk_render_node_promote (self->child);
+      }
+      break;
+
+    case GSK_OPACITY_NODE:
+      {
+        GskOpacityNode *self = (GskOpacityNode *) node;
+
+        self->child = gsk_render_node_promote (self->child);
+      }
+      break;
+
+    case GSK_COLOR_MATRIX_NODE:
+      {
+        GskColorMatrixNode *self = (GskColorMatrixNode *) node;
+
+        self->child = gsk_render_node_promote (self->child);
+      }
+      break;
+
+    case GSK_REPEAT_NODE:
+      {
+        GskRepeatNode *self = (GskRepeatNode *) node;
+
+        self->child = gsk_render_node_promote (self->child);
+      }
+      break;
+
+    case GSK_CLIP_NODE:
+      {
+        GskClipNode *self = (GskClipNode *) node;
+
+        self->child = gsk_render_node_promote (self->child);
+      }
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      {
+        GskRoundedClipNode *self = (GskRoundedClipNode *) node;
+
+        self->child = gsk_render_node_promote (self->child);
+      }
+      break;
+
+    case GSK_SHADOW_NODE:
+      {
+        GskShadowNode *self = (GskShadowNode *) node;
+
+        self->child = gsk_render_node_promote (self->child);
+      }
+      break;
+
+    case GSK_BLEND_NODE:
+      {
+        GskBlendNode *self = (GskBlendNode *) node;
+
+        self->bottom = gsk_render_node_promote (self->bottom);
+        self->top = gsk_render_node_promote (self->top);
+      }
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      {
+        GskCrossFadeNode *self = (GskCrossFadeNode *) node;
+
+        self->start = gsk_render_node_promote (self->start);
+        self->end = gsk_render_node_promote (self->end);
+      }
+      break;
+
+    case GSK_BLUR_NODE:
+      {
+        GskBlurNode *self = (GskBlurNode *) node;
+
+        self->child = gsk_render_node_promote (self->child);
+      }
+      break;
+
+    case GSK_COLOR_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_TEXTURE_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+    case GSK_CAIRO_NODE:
+    case GSK_TEXT_NODE:
+      break;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      g_assert_not_reached ();
+    }
+}
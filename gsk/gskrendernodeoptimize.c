@@ -0,0 +1,671 @@
+/* GSK - The GTK Scene Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gskrendernodeprivate.h"
+
+#include "gskroundedrectprivate.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Number of opaque nodes that are remembered while looking for
+ * earlier siblings that they cover */
+#define MAX_OCCLUDERS 8
+
+static GskRenderNode *optimize_node (GskRenderNode              *node,
+                                     GskRenderNodeOptimizeStats *stats);
+
+/* Returns the part of @node that is guaranteed to be fully covered by
+ * it, in whole pixels so that antialiased edges are not included. */
+static gboolean
+get_opaque_rect (GskRenderNode   *node,
+                 graphene_rect_t *rect)
+{
+  float x1, y1, x2, y2;
+
+  if (gsk_render_node_get_node_type (node) != GSK_COLOR_NODE ||
+      gsk_color_node_peek_color (node)->alpha < 1.0)
+    return FALSE;
+
+  x1 = ceilf (node->bounds.origin.x);
+  y1 = ceilf (node->bounds.origin.y);
+  x2 = floorf (node->bounds.origin.x + node->bounds.size.width);
+  y2 = floorf (node->bounds.origin.y + node->bounds.size.height);
+
+  if (x2 <= x1 || y2 <= y1)
+    return FALSE;
+
+  graphene_rect_init (rect, x1, y1, x2 - x1, y2 - y1);
+
+  return TRUE;
+}
+
+/* Removes the children that are completely covered by opaque
+ * siblings drawn after them */
+static void
+remove_occluded_children (GPtrArray                  *children,
+                          GskRenderNodeOptimizeStats *stats)
+{
+  graphene_rect_t occluders[MAX_OCCLUDERS];
+  guint n_occluders = 0;
+  guint i, j;
+
+  for (i = children->len; i-- > 0; )
+    {
+      GskRenderNode *child = g_ptr_array_index (children, i);
+      graphene_rect_t rect;
+
+      for (j = 0; j < n_occluders; j++)
+        {
+          if (graphene_rect_contains_rect (&occluders[j], &child->bounds))
+            break;
+        }
+
+      if (j < n_occluders)
+        {
+          g_ptr_array_remove_index (children, i);
+          stats->culled_nodes++;
+          continue;
+        }
+
+      if (!get_opaque_rect (child, &rect))
+        continue;
+
+      if (n_occluders < MAX_OCCLUDERS)
+        {
+          occluders[n_occluders++] = rect;
+        }
+      else
+        {
+          guint smallest = 0;
+
+          for (j = 1; j < n_occluders; j++)
+            {
+              if (graphene_rect_get_area (&occluders[j]) < graphene_rect_get_area (&occluders[smallest]))
+                smallest = j;
+            }
+
+          if (graphene_rect_get_area (&rect) > graphene_rect_get_area (&occluders[smallest]))
+            occluders[smallest] = rect;
+        }
+    }
+}
+
+/* Creates a text node that draws the glyphs of @first and @second, or
+ * returns %NULL if they can't be drawn by a single node */
+static GskRenderNode *
+merge_text_nodes (GskRenderNode *first,
+                  GskRenderNode *second)
+{
+  PangoGlyphString *glyphs1, *glyphs2, *glyphs;
+  GskRenderNode *result;
+  double gap;
+
+  if (gsk_text_node_get_font (first) != gsk_text_node_get_font (second) ||
+      !gdk_rgba_equal (gsk_text_node_get_color (first), gsk_text_node_get_color (second)) ||
+      gsk_text_node_get_y (first) != gsk_text_node_get_y (second))
+    return NULL;
+
+  glyphs1 = gsk_text_node_get_glyphs (first);
+  glyphs2 = gsk_text_node_get_glyphs (second);
+  if (glyphs1->num_glyphs == 0)
+    return NULL;
+
+  /* The space between the two runs is added to the advance of the
+   * last glyph of the first one, which only works if it is a whole
+   * number of Pango units */
+  gap = (gsk_text_node_get_x (second) - gsk_text_node_get_x (first)) * PANGO_SCALE
+        - pango_glyph_string_get_width (glyphs1);
+  if (gap < 0 || gap > G_MAXINT / 2 || fabs (gap - round (gap)) > 0.01)
+    return NULL;
+
+  glyphs = pango_glyph_string_new ();
+  pango_glyph_string_set_size (glyphs, glyphs1->num_glyphs + glyphs2->num_glyphs);
+  memcpy (glyphs->glyphs, glyphs1->glyphs, sizeof (PangoGlyphInfo) * glyphs1->num_glyphs);
+  memcpy (glyphs->glyphs + glyphs1->num_glyphs, glyphs2->glyphs, sizeof (PangoGlyphInfo) * glyphs2->num_glyphs);
+  memcpy (glyphs->log_clusters, glyphs1->log_clusters, sizeof (int) * glyphs1->num_glyphs);
+  memcpy (glyphs->log_clusters + glyphs1->num_glyphs, glyphs2->log_clusters, sizeof (int) * glyphs2->num_glyphs);
+  glyphs->glyphs[glyphs1->num_glyphs - 1].geometry.width += round (gap);
+
+  result = gsk_text_node_new (gsk_text_node_get_font (first),
+                              glyphs,
+                              gsk_text_node_get_color (first),
+                              gsk_text_node_get_x (first),
+                              gsk_text_node_get_y (first));
+
+  pango_glyph_string_free (glyphs);
+
+  return result;
+}
+
+static void
+merge_adjacent_text_nodes (GPtrArray                  *children,
+                           GskRenderNodeOptimizeStats *stats)
+{
+  guint i;
+
+  for (i = 1; i < children->len; )
+    {
+      GskRenderNode *prev = g_ptr_array_index (children, i - 1);
+      GskRenderNode *child = g_ptr_array_index (children, i);
+      GskRenderNode *merged = NULL;
+
+      if (gsk_render_node_get_node_type (prev) == GSK_TEXT_NODE &&
+          gsk_render_node_get_node_type (child) == GSK_TEXT_NODE)
+        merged = merge_text_nodes (prev, child);
+
+      if (merged == NULL)
+        {
+          i++;
+          continue;
+        }
+
+      g_ptr_array_index (children, i - 1) = merged;
+      gsk_render_node_unref (prev);
+      g_ptr_array_remove_index (children, i);
+      stats->merged_text_nodes++;
+    }
+}
+
+static GskRenderNode *
+optimize_container_node (GskRenderNode              *node,
+                         GskRenderNodeOptimizeStats *stats)
+{
+  guint n_children = gsk_container_node_get_n_children (node);
+  GskRenderNode *result;
+  GPtrArray *children;
+  gboolean changed;
+  guint i, j;
+
+  children = g_ptr_array_new_with_free_func ((GDestroyNotify) gsk_render_node_unref);
+
+  for (i = 0; i < n_children; i++)
+    {
+      GskRenderNode *child = optimize_node (gsk_container_node_get_child (node, i), stats);
+
+      if (child == NULL)
+        continue;
+
+      /* Optimized containers always have several children, splice
+       * them into this one */
+      if (gsk_render_node_get_node_type (child) == GSK_CONTAINER_NODE)
+        {
+          for (j = 0; j < gsk_container_node_get_n_children (child); j++)
+            g_ptr_array_add (children, gsk_render_node_ref (gsk_container_node_get_child (child, j)));
+          gsk_render_node_unref (child);
+          stats->folded_containers++;
+        }
+      else
+        {
+          g_ptr_array_add (children, child);
+        }
+    }
+
+  remove_occluded_children (children, stats);
+  merge_adjacent_text_nodes (children, stats);
+
+  if (children->len == 0)
+    {
+      stats->folded_containers++;
+      result = NULL;
+    }
+  else if (children->len == 1)
+    {
+      stats->folded_containers++;
+      result = gsk_render_node_ref (g_ptr_array_index (children, 0));
+    }
+  else
+    {
+      changed = children->len != n_children;
+      for (i = 0; i < children->len && !changed; i++)
+        changed = g_ptr_array_index (children, i) != gsk_container_node_get_child (node, i);
+
+      if (changed)
+        result = gsk_container_node_new ((GskRenderNode **) children->pdata, children->len);
+      else
+        result = gsk_render_node_ref (node);
+    }
+
+  g_ptr_array_unref (children);
+
+  return result;
+}
+
+static gboolean
+get_translation (GskRenderNode *node,
+                 double        *dx,
+                 double        *dy)
+{
+  graphene_matrix_t transform;
+  double xx, yx, xy, yy;
+
+  gsk_transform_node_get_transform (node, &transform);
+
+  if (!graphene_matrix_to_2d (&transform, &xx, &yx, &xy, &yy, dx, dy))
+    return FALSE;
+
+  return xx == 1 && yx == 0 && xy == 0 && yy == 1;
+}
+
+/* Returns @node moved by @dx, @dy, or %NULL if that needs a
+ * transform node */
+static GskRenderNode *
+translate_node (GskRenderNode *node,
+                double         dx,
+                double         dy)
+{
+  GskRenderNode *result;
+  graphene_rect_t bounds;
+  graphene_matrix_t transform;
+  double child_dx, child_dy;
+
+  if (dx == 0 && dy == 0)
+    return gsk_render_node_ref (node);
+
+  graphene_rect_offset_r (&node->bounds, dx, dy, &bounds);
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_NODE:
+      return gsk_color_node_new (gsk_color_node_peek_color (node), &bounds);
+
+    case GSK_TEXTURE_NODE:
+      result = gsk_texture_node_new (gsk_texture_node_get_texture (node), &bounds);
+      gsk_render_node_set_scaling_filters (result, node->min_filter, node->mag_filter);
+      return result;
+
+    case GSK_TRANSFORM_NODE:
+      if (!get_translation (node, &child_dx, &child_dy))
+        return NULL;
+
+      result = translate_node (gsk_transform_node_get_child (node), dx + child_dx, dy + child_dy);
+      if (result)
+        return result;
+
+      graphene_matrix_init_translate (&transform, &GRAPHENE_POINT3D_INIT (dx + child_dx, dy + child_dy, 0));
+      return gsk_transform_node_new (gsk_transform_node_get_child (node), &transform);
+
+    default:
+      return NULL;
+    }
+}
+
+static GskRenderNode *
+optimize_transform_node (GskRenderNode              *node,
+                         GskRenderNodeOptimizeStats *stats)
+{
+  GskRenderNode *child, *result;
+  graphene_matrix_t transform;
+  double dx, dy;
+
+  child = optimize_node (gsk_transform_node_get_child (node), stats);
+  if (child == NULL)
+    return NULL;
+
+  if (get_translation (node, &dx, &dy))
+    {
+      result = translate_node (child, dx, dy);
+      if (result)
+        {
+          stats->folded_transforms++;
+          gsk_render_node_unref (child);
+          return result;
+        }
+    }
+
+  if (child == gsk_transform_node_get_child (node))
+    {
+      result = gsk_render_node_ref (node);
+    }
+  else
+    {
+      gsk_transform_node_get_transform (node, &transform);
+      result = gsk_transform_node_new (child, &transform);
+    }
+
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_opacity_node (GskRenderNode              *node,
+                       GskRenderNodeOptimizeStats *stats)
+{
+  double opacity = gsk_opacity_node_get_opacity (node);
+  GskRenderNode *child, *result;
+
+  if (opacity <= 0)
+    {
+      stats->culled_nodes++;
+      return NULL;
+    }
+
+  child = optimize_node (gsk_opacity_node_get_child (node), stats);
+  if (child == NULL)
+    return NULL;
+
+  if (opacity >= 1)
+    {
+      stats->folded_opacities++;
+      return child;
+    }
+
+  if (child == gsk_opacity_node_get_child (node))
+    result = gsk_render_node_ref (node);
+  else
+    result = gsk_opacity_node_new (child, opacity);
+
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_clip_node (GskRenderNode              *node,
+                    GskRenderNodeOptimizeStats *stats)
+{
+  const graphene_rect_t *clip = gsk_clip_node_peek_clip (node);
+  GskRenderNode *child, *result;
+
+  child = optimize_node (gsk_clip_node_get_child (node), stats);
+  if (child == NULL)
+    return NULL;
+
+  if (graphene_rect_contains_rect (clip, &child->bounds))
+    {
+      stats->folded_clips++;
+      return child;
+    }
+
+  if (!graphene_rect_intersection (clip, &child->bounds, NULL))
+    {
+      stats->culled_nodes++;
+      gsk_render_node_unref (child);
+      return NULL;
+    }
+
+  if (child == gsk_clip_node_get_child (node))
+    result = gsk_render_node_ref (node);
+  else
+    result = gsk_clip_node_new (child, clip);
+
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_rounded_clip_node (GskRenderNode              *node,
+                            GskRenderNodeOptimizeStats *stats)
+{
+  const GskRoundedRect *clip = gsk_rounded_clip_node_peek_clip (node);
+  GskRenderNode *child, *result;
+
+  child = optimize_node (gsk_rounded_clip_node_get_child (node), stats);
+  if (child == NULL)
+    return NULL;
+
+  if (gsk_rounded_rect_contains_rect (clip, &child->bounds))
+    {
+      stats->folded_clips++;
+      return child;
+    }
+
+  if (!graphene_rect_intersection (&clip->bounds, &child->bounds, NULL))
+    {
+      stats->culled_nodes++;
+      gsk_render_node_unref (child);
+      return NULL;
+    }
+
+  if (child == gsk_rounded_clip_node_get_child (node))
+    result = gsk_render_node_ref (node);
+  else
+    result = gsk_rounded_clip_node_new (child, clip);
+
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+/* Effects that draw nothing when their child draws nothing */
+static GskRenderNode *
+optimize_effect_node (GskRenderNode              *node,
+                      GskRenderNodeOptimizeStats *stats)
+{
+  GskRenderNode *child, *old_child, *result;
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_REPEAT_NODE:
+      old_child = gsk_repeat_node_get_child (node);
+      break;
+    case GSK_SHADOW_NODE:
+      old_child = gsk_shadow_node_get_child (node);
+      break;
+    case GSK_BLUR_NODE:
+      old_child = gsk_blur_node_get_child (node);
+      break;
+    default:
+      g_assert_not_reached ();
+      return NULL;
+    }
+
+  child = optimize_node (old_child, stats);
+  if (child == NULL)
+    return NULL;
+
+  if (child == old_child)
+    {
+      gsk_render_node_unref (child);
+      return gsk_render_node_ref (node);
+    }
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_REPEAT_NODE:
+      result = gsk_repeat_node_new (&node->bounds, child, gsk_repeat_node_peek_child_bounds (node));
+      break;
+    case GSK_SHADOW_NODE:
+      result = gsk_shadow_node_new (child,
+                                    gsk_shadow_node_peek_shadow (node, 0),
+                                    gsk_shadow_node_get_n_shadows (node));
+      break;
+    case GSK_BLUR_NODE:
+      result = gsk_blur_node_new (child, gsk_blur_node_get_radius (node));
+      break;
+    default:
+      g_assert_not_reached ();
+      result = NULL;
+    }
+
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+/* Nodes that need all of their children to be drawn correctly.
+ * They are kept unchanged if one of them optimizes away. */
+static GskRenderNode *
+optimize_compound_node (GskRenderNode              *node,
+                        GskRenderNodeOptimizeStats *stats)
+{
+  GskRenderNode *old1, *old2, *child1, *child2, *result;
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_MATRIX_NODE:
+      old1 = gsk_color_matrix_node_get_child (node);
+      old2 = NULL;
+      break;
+    case GSK_BLEND_NODE:
+      old1 = gsk_blend_node_get_bottom_child (node);
+      old2 = gsk_blend_node_get_top_child (node);
+      break;
+    case GSK_CROSS_FADE_NODE:
+      old1 = gsk_cross_fade_node_get_start_child (node);
+      old2 = gsk_cross_fade_node_get_end_child (node);
+      break;
+    default:
+      g_assert_not_reached ();
+      return NULL;
+    }
+
+  child1 = optimize_node (old1, stats);
+  child2 = old2 ? optimize_node (old2, stats) : NULL;
+
+  if (child1 == NULL || (old2 != NULL && child2 == NULL) ||
+      (child1 == old1 && child2 == old2))
+    {
+      result = gsk_render_node_ref (node);
+    }
+  else
+    {
+      switch (gsk_render_node_get_node_type (node))
+        {
+        case GSK_COLOR_MATRIX_NODE:
+          result = gsk_color_matrix_node_new (child1,
+                                              gsk_color_matrix_node_peek_color_matrix (node),
+                                              gsk_color_matrix_node_peek_color_offset (node));
+          break;
+        case GSK_BLEND_NODE:
+          result = gsk_blend_node_new (child1, child2, gsk_blend_node_get_blend_mode (node));
+          break;
+        case GSK_CROSS_FADE_NODE:
+          result = gsk_cross_fade_node_new (child1, child2, gsk_cross_fade_node_get_progress (node));
+          break;
+        default:
+          g_assert_not_reached ();
+          result = NULL;
+        }
+    }
+
+  g_clear_pointer (&child1, gsk_render_node_unref);
+  g_clear_pointer (&child2, gsk_render_node_unref);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_node_uncached (GskRenderNode              *node,
+                        GskRenderNodeOptimizeStats *stats)
+{
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      return optimize_container_node (node, stats);
+
+    case GSK_TRANSFORM_NODE:
+      return optimize_transform_node (node, stats);
+
+    case GSK_OPACITY_NODE:
+      return optimize_opacity_node (node, stats);
+
+    case GSK_CLIP_NODE:
+      return optimize_clip_node (node, stats);
+
+    case GSK_ROUNDED_CLIP_NODE:
+      return optimize_rounded_clip_node (node, stats);
+
+    case GSK_REPEAT_NODE:
+    case GSK_SHADOW_NODE:
+    case GSK_BLUR_NODE:
+      return optimize_effect_node (node, stats);
+
+    case GSK_COLOR_MATRIX_NODE:
+    case GSK_BLEND_NODE:
+    case GSK_CROSS_FADE_NODE:
+      return optimize_compound_node (node, stats);
+
+    case GSK_COLOR_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_TEXTURE_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+    case GSK_CAIRO_NODE:
+    case GSK_TEXT_NODE:
+      return gsk_render_node_ref (node);
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      g_assert_not_reached ();
+      return NULL;
+    }
+}
+
+/* Nodes outside of arenas are the ones that widgets retain across
+ * frames. Optimizing them again every frame would not only walk the
+ * whole tree, but also create new nodes for them each time, so that
+ * they could never be recognized as unchanged. As nodes are immutable,
+ * their result can be remembered instead. */
+static GskRenderNode *
+optimize_node (GskRenderNode              *node,
+               GskRenderNodeOptimizeStats *stats)
+{
+  GskRenderNode *result;
+
+  if (node->optimized_valid)
+    return node->optimized ? gsk_render_node_ref (node->optimized) : NULL;
+
+  result = optimize_node_uncached (node, stats);
+
+  if (node->chunk == NULL)
+    {
+      if (result == NULL || result == node)
+        node->optimized = result;
+      else
+        node->optimized = gsk_render_node_ref (result);
+      node->optimized_valid = TRUE;
+    }
+
+  return result;
+}
+
+/*< private >
+ * gsk_render_node_optimize:
+ * @node: the root of a render node tree
+ * @stats: (inout): statistics to add the changes made to
+ *
+ * Creates a render node tree that draws the same as @node, but
+ * with less nodes. This removes nodes that make no difference, like
+ * containers with a single child, opacity nodes with an opacity of
+ * 1 and clips that contain their child. Nodes covered by opaque
+ * siblings are culled, translations are folded into the nodes they
+ * move where possible, and adjacent text nodes with the same font
+ * and color are merged.
+ *
+ * Subtrees that don't change are shared with @node. The result is
+ * remembered on nodes that don't belong to an arena, so optimizing
+ * a retained tree again returns the same nodes, and @stats only
+ * counts the changes that were not known yet.
+ *
+ * Returns: (transfer full) (nullable): the optimized tree, or %NULL
+ *   if @node does not draw anything
+ */
+GskRenderNode *
+gsk_render_node_optimize (GskRenderNode              *node,
+                          GskRenderNodeOptimizeStats *stats)
+{
+  g_return_val_if_fail (GSK_IS_RENDER_NODE (node), NULL);
+  g_return_val_if_fail (stats != NULL, NULL);
+
+  return optimize_node (node, stats);
+}
@@ -2,11 +2,20 @@
 #define __GSK_RENDER_NODE_PRIVATE_H__
 
 #include "gskrendernode.h"
+#include "gskrendernodecoderprivate.h"
 #include <cairo.h>
 
 G_BEGIN_DECLS
 
 typedef struct _GskRenderNodeClass GskRenderNodeClass;
+typedef struct _GskRenderNodeArena GskRenderNodeArena;
+typedef struct _GskRenderNodeChunk GskRenderNodeChunk;
+typedef struct _GskRenderNodeArenaStats GskRenderNodeArenaStats;
+typedef struct _GskRenderNodeTimings GskRenderNodeTimings;
+typedef struct _GskRenderNodeTiming GskRenderNodeTiming;
+typedef struct _GskRenderNodeStats GskRenderNodeStats;
+typedef struct _GskRenderNodeStatsCollector GskRenderNodeStatsCollector;
+typedef struct _GskRenderNodeOptimizeStats GskRenderNodeOptimizeStats;
 
 #define GSK_IS_RENDER_NODE_TYPE(node,type) (GSK_IS_RENDER_NODE (node) && (node)->node_class->node_type == (type))
 
@@ -16,6 +25,12 @@ struct _GskRenderNode
 
   volatile int ref_count;
 
+  /* Size of the node including variable-sized data */
+  guint size;
+
+  /* The arena chunk holding the node, or %NULL if it was malloc()ed */
+  GskRenderNodeChunk *chunk;
+
   /* Use for debugging */
   char *name;
 
@@ -24,6 +39,11 @@ struct _GskRenderNode
   GskScalingFilter mag_filter;
 
   graphene_rect_t bounds;
+
+  /* The result of gsk_render_node_optimize(), kept for nodes outside
+   * of arenas. Not a reference if it is the node itself. */
+  GskRenderNode *optimized;
+  guint optimized_valid : 1;
 };
 
 struct _GskRenderNodeClass
@@ -37,12 +57,98 @@ struct _GskRenderNodeClass
   GVariant * (* serialize) (GskRenderNode *node);
   GskRenderNode * (* deserialize) (GVariant  *variant,
                                    GError   **error);
+  void (* diff) (GskRenderNode  *node1,
+                 GskRenderNode  *node2,
+                 cairo_region_t *region);
+  void (* encode) (GskRenderNode        *node,
+                   GskRenderNodeEncoder *encoder);
+  GskRenderNode * (* decode) (GskRenderNodeDecoder *decoder);
+  void (* collect_stats) (GskRenderNode               *node,
+                          GskRenderNodeStatsCollector *collector);
+};
+
+struct _GskRenderNodeArenaStats
+{
+  guint64 n_nodes;
+  guint64 n_promoted;
+};
+
+struct _GskRenderNodeTimings
+{
+  /* Indexed by GskRenderNodeType, times are in microseconds and don't
+   * include the time spent in child nodes */
+  gint64 time[GSK_BLUR_NODE + 1];
+  guint64 count[GSK_BLUR_NODE + 1];
+};
+
+struct _GskRenderNodeTiming
+{
+  GskRenderNode *node;
+  GskRenderNodeTiming *parent;
+  gint64 start_time;
+  gint64 child_time;
+};
+
+struct _GskRenderNodeStats
+{
+  /* Nodes that appear several times in the tree are only counted once */
+  guint n_nodes;
+  guint depth;
+
+  /* Indexed by GskRenderNodeType */
+  guint count[GSK_BLUR_NODE + 1];
+  gsize bytes[GSK_BLUR_NODE + 1];
+
+  /* Memory held by the nodes themselves, including variable-sized data */
+  gsize node_bytes;
+  /* Memory held by the pixels of the surfaces and textures in the tree */
+  gsize surface_bytes;
+  gsize texture_bytes;
+};
+
+struct _GskRenderNodeOptimizeStats
+{
+  guint folded_containers;
+  guint folded_opacities;
+  guint folded_clips;
+  guint folded_transforms;
+  guint culled_nodes;
+  guint merged_text_nodes;
 };
 
 GskRenderNode *gsk_render_node_new (const GskRenderNodeClass *node_class, gsize extra_size);
 
+/* Needs to be exported for testsuite/gsk/test-optimize */
+GDK_AVAILABLE_IN_ALL
+GskRenderNode *gsk_render_node_optimize (GskRenderNode *node, GskRenderNodeOptimizeStats *stats);
+
+void gsk_render_node_get_stats (GskRenderNode *node, GskRenderNodeStats *stats);
+void gsk_render_node_stats_collector_add_child (GskRenderNodeStatsCollector *collector, GskRenderNode *child);
+void gsk_render_node_stats_collector_add_bytes (GskRenderNodeStatsCollector *collector, gsize bytes);
+void gsk_render_node_stats_collector_add_surface (GskRenderNodeStatsCollector *collector, cairo_surface_t *surface);
+void gsk_render_node_stats_collector_add_texture (GskRenderNodeStatsCollector *collector, GskTexture *texture);
+
+GskRenderNodeArena * gsk_render_node_arena_begin (void);
+void gsk_render_node_arena_end (GskRenderNodeArena *arena);
+GskRenderNode * gsk_render_node_promote (GskRenderNode *node);
+void gsk_render_node_promote_children (GskRenderNode *node);
+
+/* Needs to be exported for testsuite/gsk/test-arena */
+GDK_AVAILABLE_IN_ALL
+void gsk_render_node_get_arena_stats (GskRenderNodeArenaStats *stats);
+
+void gsk_render_node_timings_start (GskRenderNodeTimings *timings);
+void gsk_render_node_timings_stop (GskRenderNodeTimings *timings);
+gboolean gsk_render_node_timing_begin (GskRenderNodeTiming *timing, GskRenderNode *node);
+void gsk_render_node_timing_end (GskRenderNodeTiming *timing);
+
+void gsk_render_node_diff (GskRenderNode *node1, GskRenderNode *node2, cairo_region_t *region);
+void gsk_render_node_diff_impossible (GskRenderNode *node1, GskRenderNode *node2, cairo_region_t *region);
+void gsk_rect_to_cairo_grow (const graphene_rect_t *graphene, cairo_rectangle_int_t *cairo);
+
 GVariant * gsk_render_node_serialize_node (GskRenderNode *node);
 GskRenderNode * gsk_render_node_deserialize_node (GskRenderNodeType type, GVariant *variant, GError **error);
+GskRenderNode * gsk_render_node_decode_node (guint64 type, GskRenderNodeDecoder *decoder);
 
 double gsk_opacity_node_get_opacity (GskRenderNode *node);
 
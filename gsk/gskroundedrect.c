@@ -291,6 +291,24 @@ gsk_rounded_rect_is_circular (const GskRoundedRect *self)
   return TRUE;
 }
 
+gboolean
+gsk_rounded_rect_equal (const GskRoundedRect *rect1,
+                        const GskRoundedRect *rect2)
+{
+  guint i;
+
+  if (!graphene_rect_equal (&rect1->bounds, &rect2->bounds))
+    return FALSE;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (!graphene_size_equal (&rect1->corner[i], &rect2->corner[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /**
  * gsk_rounded_rect_is_rectilinear:
  * @self: the #GskRoundedRect to check
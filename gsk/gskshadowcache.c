@@ -0,0 +1,451 @@
+#include "config.h"
+
+#include "gskshadowcacheprivate.h"
+
+#include "gskcairoblurprivate.h"
+#include "gskroundedrectprivate.h"
+
+#include <math.h>
+
+/* Upper bound for the memory used by the cached masks, in bytes */
+#define MAX_CACHE_SIZE (4 * 1024 * 1024)
+
+/* Masks bigger than this are used once and not cached */
+#define MAX_ENTRY_SIZE (MAX_CACHE_SIZE / 4)
+
+typedef struct {
+  /* Corner radii of the shadow box, with the spread already applied */
+  graphene_size_t corner[4];
+  float radius;
+  int scale;
+  /* Size of the box in device pixels, or 0 if the mask is drawn as a
+   * nine-slice and can be stretched to any box size */
+  int width;
+  int height;
+  gboolean inset;
+} ShadowKey;
+
+typedef struct {
+  ShadowKey key;
+  cairo_surface_t *mask;
+  gsize size;
+  GList link;
+} ShadowEntry;
+
+/* The Cairo renderer can draw from several threads in tiled mode */
+G_LOCK_DEFINE_STATIC (cache);
+static GHashTable *cache_entries = NULL;
+/* Most recently used entries first */
+static GQueue cache_lru = G_QUEUE_INIT;
+static gsize cache_size = 0;
+static guint64 cache_hits = 0;
+static guint64 cache_misses = 0;
+
+static guint
+shadow_key_hash (gconstpointer data)
+{
+  const ShadowKey *key = data;
+  guint hash;
+  int i;
+
+  hash = (guint) (key->radius * 4);
+  for (i = 0; i < 4; i++)
+    {
+      hash = hash * 31 + (guint) (key->corner[i].width * 4);
+      hash = hash * 31 + (guint) (key->corner[i].height * 4);
+    }
+  hash = hash * 31 + key->width;
+  hash = hash * 31 + key->height;
+  hash = hash * 31 + key->scale;
+
+  return hash ^ key->inset;
+}
+
+static gboolean
+shadow_key_equal (gconstpointer a,
+                  gconstpointer b)
+{
+  const ShadowKey *key1 = a;
+  const ShadowKey *key2 = b;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (key1->corner[i].width != key2->corner[i].width ||
+          key1->corner[i].height != key2->corner[i].height)
+        return FALSE;
+    }
+
+  return
+    key1->radius == key2->radius &&
+    key1->scale == key2->scale &&
+    key1->width == key2->width &&
+    key1->height == key2->height &&
+    key1->inset == key2->inset;
+}
+
+static void
+shadow_entry_free (ShadowEntry *entry)
+{
+  cairo_surface_destroy (entry->mask);
+  g_slice_free (ShadowEntry, entry);
+}
+
+/* Draws the blurred shadow of a box that is @pad pixels smaller than
+ * @width x @height on each side. Inset masks get an additional @margin
+ * of filled pixels around them, so that the blur does not fade out
+ * towards the edges of the surface.
+ */
+static cairo_surface_t *
+create_mask (const ShadowKey *key,
+             int              width,
+             int              height,
+             int              pad,
+             int              margin)
+{
+  cairo_surface_t *mask;
+  GskRoundedRect box;
+  cairo_t *cr;
+  int i;
+
+  mask = cairo_image_surface_create (CAIRO_FORMAT_A8, width + 2 * margin, height + 2 * margin);
+
+  cr = cairo_create (mask);
+  cairo_scale (cr, key->scale, key->scale);
+  cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+
+  gsk_rounded_rect_init_from_rect (&box,
+                                   &GRAPHENE_RECT_INIT ((float) (margin + pad) / key->scale,
+                                                        (float) (margin + pad) / key->scale,
+                                                        (float) (width - 2 * pad) / key->scale,
+                                                        (float) (height - 2 * pad) / key->scale),
+                                   0);
+  for (i = 0; i < 4; i++)
+    box.corner[i] = key->corner[i];
+  gsk_rounded_rect_path (&box, cr);
+
+  if (key->inset)
+    cairo_rectangle (cr,
+                     0, 0,
+                     (double) (width + 2 * margin) / key->scale,
+                     (double) (height + 2 * margin) / key->scale);
+
+  cairo_fill (cr);
+  cairo_destroy (cr);
+
+  gsk_cairo_blur_surface (mask, key->radius * key->scale, GSK_BLUR_X | GSK_BLUR_Y);
+  cairo_surface_set_device_scale (mask, key->scale, key->scale);
+
+  return mask;
+}
+
+static void
+trim_cache (void)
+{
+  while (cache_size > MAX_CACHE_SIZE)
+    {
+      ShadowEntry *entry = g_queue_peek_tail (&cache_lru);
+
+      g_queue_unlink (&cache_lru, &entry->link);
+      cache_size -= entry->size;
+      g_hash_table_remove (cache_entries, &entry->key);
+    }
+}
+
+/* Returns a new reference to the mask for @key, creating it if needed */
+static cairo_surface_t *
+lookup_mask (const ShadowKey *key,
+             int              width,
+             int              height,
+             int              pad,
+             int              margin)
+{
+  ShadowEntry *entry;
+  cairo_surface_t *mask;
+  gsize size;
+
+  G_LOCK (cache);
+
+  if (cache_entries == NULL)
+    cache_entries = g_hash_table_new_full (shadow_key_hash, shadow_key_equal,
+                                           NULL, (GDestroyNotify) shadow_entry_free);
+
+  entry = g_hash_table_lookup (cache_entries, key);
+  if (entry)
+    {
+      cache_hits++;
+      g_queue_unlink (&cache_lru, &entry->link);
+      g_queue_push_head_link (&cache_lru, &entry->link);
+      mask = cairo_surface_reference (entry->mask);
+
+      G_UNLOCK (cache);
+
+      return mask;
+    }
+
+  cache_misses++;
+
+  G_UNLOCK (cache);
+
+  /* Blurring is slow, so don't hold the lock while doing it. Two
+   * threads may end up creating the same mask, in which case the
+   * second one wins.
+   */
+  mask = create_mask (key, width, height, pad, margin);
+  size = cairo_image_surface_get_stride (mask) * cairo_image_surface_get_height (mask);
+  if (size > MAX_ENTRY_SIZE)
+    return mask;
+
+  entry = g_slice_new0 (ShadowEntry);
+  entry->key = *key;
+  entry->mask = cairo_surface_reference (mask);
+  entry->size = size;
+  entry->link.data = entry;
+
+  G_LOCK (cache);
+
+  if (g_hash_table_lookup (cache_entries, key))
+    {
+      ShadowEntry *old = g_hash_table_lookup (cache_entries, key);
+
+      g_queue_unlink (&cache_lru, &old->link);
+      cache_size -= old->size;
+    }
+  g_hash_table_replace (cache_entries, &entry->key, entry);
+  g_queue_push_head_link (&cache_lru, &entry->link);
+  cache_size += entry->size;
+  trim_cache ();
+
+  G_UNLOCK (cache);
+
+  return mask;
+}
+
+static void
+mask_area (cairo_t              *cr,
+           cairo_surface_t      *mask,
+           const cairo_matrix_t *matrix,
+           double                x1,
+           double                y1,
+           double                x2,
+           double                y2)
+{
+  cairo_pattern_t *pattern;
+
+  if (x2 <= x1 || y2 <= y1)
+    return;
+
+  cairo_save (cr);
+
+  cairo_rectangle (cr, x1, y1, x2 - x1, y2 - y1);
+  cairo_clip (cr);
+
+  pattern = cairo_pattern_create_for_surface (mask);
+  cairo_pattern_set_matrix (pattern, matrix);
+  /* Edges are stretched from a single row or column of pixels */
+  cairo_pattern_set_filter (pattern, CAIRO_FILTER_NEAREST);
+  cairo_mask (cr, pattern);
+  cairo_pattern_destroy (pattern);
+
+  cairo_restore (cr);
+}
+
+static gboolean
+is_device_aligned (double value,
+                   int    scale)
+{
+  return value * scale == floor (value * scale);
+}
+
+/*<private>
+ * gsk_shadow_cache_draw:
+ * @cr: the cairo context to draw to
+ * @inset: %TRUE to draw the inside of @box, %FALSE for the outside
+ * @box: the box casting the shadow, with offset and spread applied
+ * @radius: the blur radius
+ * @color: the shadow color
+ *
+ * Draws a blurred box shadow using a cached mask. The mask only
+ * depends on the corner radii of @box and the blur radius, so that
+ * it can be shared between all boxes with the same style. The sides
+ * and the center of the mask are stretched to the size of @box.
+ *
+ * Only pixel-aligned boxes in an untransformed context are handled,
+ * as the slices would show seams otherwise.
+ *
+ * Returns: %TRUE if the shadow was drawn, %FALSE if the caller
+ *   needs to draw it in some other way
+ */
+gboolean
+gsk_shadow_cache_draw (cairo_t              *cr,
+                       gboolean              inset,
+                       const GskRoundedRect *box,
+                       float                 radius,
+                       const GdkRGBA        *color)
+{
+  double x_scale, y_scale;
+  cairo_matrix_t ctm, matrix;
+  cairo_surface_t *mask;
+  ShadowKey key;
+  int scale, clip_radius, pad, margin;
+  int box_width, box_height, left, right, top, bottom, width, height;
+  double x0, y0, x1, y1, x2, y2, x3, y3, m, sx, sy;
+  gboolean sliced;
+  int i;
+
+  x_scale = y_scale = 1;
+  cairo_surface_get_device_scale (cairo_get_target (cr), &x_scale, &y_scale);
+  if (x_scale != y_scale || x_scale < 1 || x_scale != floor (x_scale))
+    return FALSE;
+  scale = x_scale;
+
+  cairo_get_matrix (cr, &ctm);
+  if (ctm.xx != 1 || ctm.yy != 1 || ctm.xy != 0 || ctm.yx != 0)
+    return FALSE;
+
+  if (!is_device_aligned (box->bounds.origin.x + ctm.x0, scale) ||
+      !is_device_aligned (box->bounds.origin.y + ctm.y0, scale) ||
+      !is_device_aligned (box->bounds.size.width, scale) ||
+      !is_device_aligned (box->bounds.size.height, scale))
+    return FALSE;
+
+  clip_radius = gsk_cairo_blur_compute_pixels (radius);
+  pad = MAX (scale * clip_radius, gsk_cairo_blur_compute_pixels (radius * scale));
+  margin = inset ? pad : 0;
+
+  box_width = box->bounds.size.width * scale;
+  box_height = box->bounds.size.height * scale;
+
+  /* Each slice covers the blur on both sides of the box edge and the
+   * largest corner on its side, so the pixel row or column in between
+   * is not affected by any corner.
+   */
+  left = 2 * pad + ceil (MAX (box->corner[GSK_CORNER_TOP_LEFT].width, box->corner[GSK_CORNER_BOTTOM_LEFT].width) * scale);
+  right = 2 * pad + ceil (MAX (box->corner[GSK_CORNER_TOP_RIGHT].width, box->corner[GSK_CORNER_BOTTOM_RIGHT].width) * scale);
+  top = 2 * pad + ceil (MAX (box->corner[GSK_CORNER_TOP_LEFT].height, box->corner[GSK_CORNER_TOP_RIGHT].height) * scale);
+  bottom = 2 * pad + ceil (MAX (box->corner[GSK_CORNER_BOTTOM_LEFT].height, box->corner[GSK_CORNER_BOTTOM_RIGHT].height) * scale);
+
+  sliced = left + 1 + right <= box_width + 2 * pad &&
+           top + 1 + bottom <= box_height + 2 * pad;
+
+  for (i = 0; i < 4; i++)
+    key.corner[i] = box->corner[i];
+  key.radius = radius;
+  key.scale = scale;
+  key.inset = inset;
+
+  if (sliced)
+    {
+      key.width = 0;
+      key.height = 0;
+      width = left + 1 + right;
+      height = top + 1 + bottom;
+    }
+  else
+    {
+      /* Small boxes are not worth slicing, cache them whole */
+      key.width = box_width;
+      key.height = box_height;
+      width = box_width + 2 * pad;
+      height = box_height + 2 * pad;
+    }
+
+  mask = lookup_mask (&key, width, height, pad, margin);
+
+  /* The area covered by the mask, and the inner edges of the slices,
+   * all in user space */
+  x0 = box->bounds.origin.x - (double) pad / scale;
+  y0 = box->bounds.origin.y - (double) pad / scale;
+  x3 = box->bounds.origin.x + box->bounds.size.width + (double) pad / scale;
+  y3 = box->bounds.origin.y + box->bounds.size.height + (double) pad / scale;
+  m = (double) margin / scale;
+
+  cairo_save (cr);
+  gdk_cairo_set_source_rgba (cr, color);
+
+  if (inset)
+    {
+      double cx1, cy1, cx2, cy2;
+
+      /* Everything outside of the mask is fully shadowed */
+      cairo_clip_extents (cr, &cx1, &cy1, &cx2, &cy2);
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+      cairo_rectangle (cr, cx1, cy1, cx2 - cx1, cy2 - cy1);
+      cairo_rectangle (cr, x0, y0, x3 - x0, y3 - y0);
+      cairo_fill (cr);
+    }
+
+  if (!sliced)
+    {
+      cairo_matrix_init_translate (&matrix, m - x0, m - y0);
+      mask_area (cr, mask, &matrix, x0, y0, x3, y3);
+    }
+  else
+    {
+      x1 = x0 + (double) left / scale;
+      y1 = y0 + (double) top / scale;
+      x2 = x3 - (double) right / scale;
+      y2 = y3 - (double) bottom / scale;
+
+      /* Corners */
+      cairo_matrix_init_translate (&matrix, m - x0, m - y0);
+      mask_area (cr, mask, &matrix, x0, y0, x1, y1);
+      cairo_matrix_init_translate (&matrix, m - x0, m + (double) height / scale - y3);
+      mask_area (cr, mask, &matrix, x0, y2, x1, y3);
+      cairo_matrix_init_translate (&matrix, m + (double) width / scale - x3, m - y0);
+      mask_area (cr, mask, &matrix, x2, y0, x3, y1);
+      cairo_matrix_init_translate (&matrix, m + (double) width / scale - x3, m + (double) height / scale - y3);
+      mask_area (cr, mask, &matrix, x2, y2, x3, y3);
+
+      /* Sides, stretching the pixel row or column between the slices */
+      sx = 1.0 / scale / (x2 - x1);
+      cairo_matrix_init (&matrix, sx, 0, 0, 1, (double) (margin + left) / scale - x1 * sx, m - y0);
+      mask_area (cr, mask, &matrix, x1, y0, x2, y1);
+      cairo_matrix_init (&matrix, sx, 0, 0, 1, (double) (margin + left) / scale - x1 * sx, m + (double) height / scale - y3);
+      mask_area (cr, mask, &matrix, x1, y2, x2, y3);
+
+      sy = 1.0 / scale / (y2 - y1);
+      cairo_matrix_init (&matrix, 1, 0, 0, sy, m - x0, (double) (margin + top) / scale - y1 * sy);
+      mask_area (cr, mask, &matrix, x0, y1, x1, y2);
+      cairo_matrix_init (&matrix, 1, 0, 0, sy, m + (double) width / scale - x3, (double) (margin + top) / scale - y1 * sy);
+      mask_area (cr, mask, &matrix, x2, y1, x3, y2);
+
+      /* The center is either fully covered or not covered at all */
+      if (!inset)
+        {
+          cairo_rectangle (cr, x1, y1, x2 - x1, y2 - y1);
+          cairo_fill (cr);
+        }
+    }
+
+  cairo_restore (cr);
+  cairo_surface_destroy (mask);
+
+  return TRUE;
+}
+
+/*<private>
+ * gsk_shadow_cache_get_statistics:
+ * @hits: (out) (optional): return location for the number of cache hits
+ * @misses: (out) (optional): return location for the number of cache misses
+ * @size: (out) (optional): return location for the memory used by the cache
+ *
+ * Queries the shadow mask cache statistics. @hits and @misses count up
+ * from the start of the process.
+ */
+void
+gsk_shadow_cache_get_statistics (guint64 *hits,
+                                 guint64 *misses,
+                                 gsize   *size)
+{
+  G_LOCK (cache);
+
+  if (hits)
+    *hits = cache_hits;
+  if (misses)
+    *misses = cache_misses;
+  if (size)
+    *size = cache_size;
+
+  G_UNLOCK (cache);
+}
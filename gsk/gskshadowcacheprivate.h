@@ -0,0 +1,22 @@
+#ifndef __GSK_SHADOW_CACHE_PRIVATE_H__
+#define __GSK_SHADOW_CACHE_PRIVATE_H__
+
+#include "gskroundedrect.h"
+
+#include <cairo.h>
+
+G_BEGIN_DECLS
+
+gboolean        gsk_shadow_cache_draw           (cairo_t              *cr,
+                                                 gboolean              inset,
+                                                 const GskRoundedRect *box,
+                                                 float                 radius,
+                                                 const GdkRGBA        *color);
+
+void            gsk_shadow_cache_get_statistics (guint64              *hits,
+                                                 guint64              *misses,
+                                                 gsize                *size);
+
+G_END_DECLS
+
+#endif /* __GSK_SHADOW_CACHE_PRIVATE_H__ */
@@ -257,11 +257,16 @@ font_has_color_glyphs (PangoFont *font)
   goto fallback; \
 }G_STMT_END
 
+static void gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
+                                             GskVulkanRender               *render,
+                                             const GskVulkanPushConstants  *constants,
+                                             GskRenderNode                 *node);
+
 static void
-gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
-                                 GskVulkanRender               *render,
-                                 const GskVulkanPushConstants  *constants,
-                                 GskRenderNode                 *node)
+gsk_vulkan_render_pass_add_node_real (GskVulkanRenderPass           *self,
+                                      GskVulkanRender               *render,
+                                      const GskVulkanPushConstants  *constants,
+                                      GskRenderNode                 *node)
 {
   GskVulkanOp op = {
     .type = GSK_VULKAN_OP_FALLBACK,
@@ -645,6 +650,23 @@ fallback:
 }
 #undef FALLBACK
 
+static void
+gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
+                                 GskVulkanRender               *render,
+                                 const GskVulkanPushConstants  *constants,
+                                 GskRenderNode                 *node)
+{
+  GskRenderNodeTiming timing;
+  gboolean timed;
+
+  timed = gsk_render_node_timing_begin (&timing, node);
+
+  gsk_vulkan_render_pass_add_node_real (self, render, constants, node);
+
+  if (timed)
+    gsk_render_node_timing_end (&timing);
+}
+
 void
 gsk_vulkan_render_pass_add (GskVulkanRenderPass     *self,
                             GskVulkanRender         *render,
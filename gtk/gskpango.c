@@ -38,23 +38,6 @@
  * to text nodes, all other draw calls fall back to cairo nodes.
  */
 
-struct _GskPangoRenderer
-{
-  PangoRenderer parent_instance;
-
-  GtkSnapshot *snapshot;
-  GdkRGBA fg_color;
-  graphene_rect_t bounds;
-
-  /* house-keeping options */
-  gboolean is_cached_renderer;
-};
-
-struct _GskPangoRendererClass
-{
-  PangoRendererClass parent_class;
-};
-
 G_DEFINE_TYPE (GskPangoRenderer, gsk_pango_renderer, PANGO_TYPE_RENDERER)
 
 static void
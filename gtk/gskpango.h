@@ -32,6 +32,26 @@ G_BEGIN_DECLS
 typedef struct _GskPangoRenderer        GskPangoRenderer;
 typedef struct _GskPangoRendererClass   GskPangoRendererClass;
 
+/* The instance is visible so that GtkTextView can derive a renderer
+ * that handles its own attributes, see gtktextdisplay.c.
+ */
+struct _GskPangoRenderer
+{
+  PangoRenderer parent_instance;
+
+  GtkSnapshot *snapshot;
+  GdkRGBA fg_color;
+  graphene_rect_t bounds;
+
+  /* house-keeping options */
+  gboolean is_cached_renderer;
+};
+
+struct _GskPangoRendererClass
+{
+  PangoRendererClass parent_class;
+};
+
 GDK_AVAILABLE_IN_3_92
 GType gsk_pango_renderer_get_type (void) G_GNUC_CONST;
 
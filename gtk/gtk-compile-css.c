@@ -0,0 +1,159 @@
+/*  Copyright 2017 Red Hat, Inc.
+ *
+ * GTK+ is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * GLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GTK+; see the file COPYING.  If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+#include "gtkcsscompiledprivate.h"
+#include "gtkcssproviderprivate.h"
+
+static char *output = NULL;
+static char **resources = NULL;
+static char **filenames = NULL;
+
+static const GOptionEntry entries[] = {
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, N_("Write the compiled style sheet to FILE"), N_("FILE") },
+  { "resources", 'r', 0, G_OPTION_ARG_FILENAME_ARRAY, &resources, N_("Register the resources in FILE, to compile resource:// URIs"), N_("FILE") },
+  { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL, N_("FILE…") },
+  { NULL, }
+};
+
+static gboolean
+compile_file (const char *filename)
+{
+  GFile *file;
+  GBytes *bytes;
+  GError *error = NULL;
+  char *output_path;
+  gboolean result;
+
+  file = g_file_new_for_commandline_arg (filename);
+
+  bytes = gtk_css_provider_compile (file, &error);
+  if (bytes == NULL)
+    {
+      g_printerr (_("Failed to compile %s: %s\n"), filename, error->message);
+      g_error_free (error);
+      g_object_unref (file);
+      return FALSE;
+    }
+
+  if (output)
+    {
+      output_path = g_strdup (output);
+    }
+  else
+    {
+      char *path = g_file_get_path (file);
+
+      if (path == NULL)
+        {
+          g_printerr (_("Can't write next to %s, use --output\n"), filename);
+          g_bytes_unref (bytes);
+          g_object_unref (file);
+          return FALSE;
+        }
+
+      output_path = g_strconcat (path, GTK_CSS_COMPILED_SUFFIX, NULL);
+      g_free (path);
+    }
+
+  result = g_file_set_contents (output_path,
+                                g_bytes_get_data (bytes, NULL),
+                                g_bytes_get_size (bytes),
+                                &error);
+  if (!result)
+    {
+      g_printerr (_("Failed to write %s: %s\n"), output_path, error->message);
+      g_error_free (error);
+    }
+
+  g_free (output_path);
+  g_bytes_unref (bytes);
+  g_object_unref (file);
+
+  return result;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  int status = 0;
+  guint i;
+
+  g_set_prgname ("gtk4-compile-css");
+
+  context = g_option_context_new (NULL);
+  g_option_context_set_summary (context,
+                                _("Compiles CSS files, so GTK+ can load them without parsing.\n"
+                                  "The result is written next to each FILE, with \"" GTK_CSS_COMPILED_SUFFIX "\" appended to its name."));
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      exit (1);
+    }
+
+  g_option_context_free (context);
+
+  if (filenames == NULL)
+    {
+      g_printerr (_("No CSS file specified\n"));
+      exit (1);
+    }
+
+  if (output && g_strv_length (filenames) > 1)
+    {
+      g_printerr (_("Can only use --output with a single CSS file\n"));
+      exit (1);
+    }
+
+  /* Compiling does not need a display, so don't fail without one */
+  gtk_init_check ();
+
+  for (i = 0; resources && resources[i]; i++)
+    {
+      GResource *resource = g_resource_load (resources[i], &error);
+
+      if (resource == NULL)
+        {
+          g_printerr (_("Failed to load resources from %s: %s\n"), resources[i], error->message);
+          g_error_free (error);
+          exit (1);
+        }
+
+      g_resources_register (resource);
+      g_resource_unref (resource);
+    }
+
+  for (i = 0; filenames[i]; i++)
+    {
+      if (!compile_file (filenames[i]))
+        status = 1;
+    }
+
+  g_strfreev (filenames);
+  g_strfreev (resources);
+  g_free (output);
+
+  return status;
+}
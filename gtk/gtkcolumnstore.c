@@ -0,0 +1,1678 @@
+/* gtkcolumnstore.c
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <gobject/gvaluecollector.h>
+#include "gtktreemodel.h"
+#include "gtkcolumnstore.h"
+#include "gtktreedatalist.h"
+#include "gtkintl.h"
+
+
+/**
+ * SECTION:gtkcolumnstore
+ * @Short_description: A list model that stores its data column by column
+ * @Title: GtkColumnStore
+ * @See_also: #GtkTreeModel, #GtkListStore
+ *
+ * The #GtkColumnStore object is a list model for use with a #GtkTreeView
+ * widget, like #GtkListStore. It implements the #GtkTreeModel and
+ * #GtkTreeSortable interfaces.
+ *
+ * Instead of allocating every row separately, it keeps one packed
+ * array per column: numbers are stored with their natural size,
+ * and objects, boxed types and pointers as a single pointer. Strings
+ * are interned, so a string that appears in many rows is only stored
+ * once. This makes the store a lot smaller than a #GtkListStore with
+ * the same contents, and sorting by a column only has to go through
+ * one array.
+ *
+ * Memory used by strings is only given back when the store is
+ * cleared or destroyed, so the store is best suited for large tables
+ * that are filled once and then mostly read.
+ *
+ * The #GtkColumnStore doesn't set the #GTK_TREE_MODEL_ITERS_PERSIST
+ * flag: iters are invalidated whenever rows are inserted, removed or
+ * reordered. gtk_column_store_set() and similar functions update the
+ * iter they are given when the row moves because the store is sorted.
+ *
+ * An example for creating a column store:
+ * |[<!-- language="C" -->
+ * GtkColumnStore *store;
+ *
+ * store = gtk_column_store_new (2, G_TYPE_STRING, G_TYPE_INT);
+ *
+ * for (i = 0; i < n_people; i++)
+ *   gtk_column_store_insert_with_values (store, NULL, -1,
+ *                                        0, people[i].name,
+ *                                        1, people[i].age,
+ *                                        -1);
+ * ]|
+ *
+ * gtk_column_store_insert_rows() fills many rows at once and is
+ * cheaper for views than inserting the rows one by one.
+ */
+
+
+typedef struct _GtkColumnStoreColumn GtkColumnStoreColumn;
+
+struct _GtkColumnStoreColumn
+{
+  GType type;
+  GType fundamental;
+  gsize cell_size;
+  guint8 *cells;
+};
+
+struct _GtkColumnStorePrivate
+{
+  GtkTreeIterCompareFunc default_sort_func;
+
+  GDestroyNotify default_sort_destroy;
+  GList *sort_list;
+
+  GtkColumnStoreColumn *columns;
+  GStringChunk *strings;
+
+  GArray *rows;          /* the physical row at every position */
+  GArray *free_rows;     /* physical rows that can be reused */
+  guint n_physical;      /* physical rows in use or free */
+  guint n_allocated;     /* physical rows that fit into the columns */
+
+  gint stamp;
+  gint n_columns;
+  gint sort_column_id;
+
+  GtkSortType order;
+
+  gpointer default_sort_data;
+};
+
+#define GTK_COLUMN_STORE_IS_SORTED(store) (((GtkColumnStore*)(store))->priv->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+
+#define ITER_POSITION(iter) (GPOINTER_TO_UINT ((iter)->user_data))
+#define ROW_AT(priv, position) (g_array_index ((priv)->rows, guint, (position)))
+#define CELL(column, row, type) (((type *) (column)->cells)[(row)])
+
+static void         gtk_column_store_tree_model_init (GtkTreeModelIface    *iface);
+static void         gtk_column_store_sortable_init   (GtkTreeSortableIface *iface);
+static void         gtk_column_store_finalize        (GObject              *object);
+static GtkTreeModelFlags gtk_column_store_get_flags  (GtkTreeModel         *tree_model);
+static gint         gtk_column_store_get_n_columns   (GtkTreeModel         *tree_model);
+static GType        gtk_column_store_get_column_type (GtkTreeModel         *tree_model,
+                                                      gint                  index);
+static gboolean     gtk_column_store_get_iter        (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter,
+                                                      GtkTreePath          *path);
+static GtkTreePath *gtk_column_store_get_path        (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter);
+static void         gtk_column_store_get_value       (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter,
+                                                      gint                  column,
+                                                      GValue               *value);
+static gboolean     gtk_column_store_iter_next       (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter);
+static gboolean     gtk_column_store_iter_previous   (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter);
+static gboolean     gtk_column_store_iter_children   (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter,
+                                                      GtkTreeIter          *parent);
+static gboolean     gtk_column_store_iter_has_child  (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter);
+static gint         gtk_column_store_iter_n_children (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter);
+static gboolean     gtk_column_store_iter_nth_child  (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter,
+                                                      GtkTreeIter          *parent,
+                                                      gint                  n);
+static gboolean     gtk_column_store_iter_parent     (GtkTreeModel         *tree_model,
+                                                      GtkTreeIter          *iter,
+                                                      GtkTreeIter          *child);
+
+/* sortable */
+static void     gtk_column_store_sort                  (GtkColumnStore         *column_store);
+static gboolean gtk_column_store_get_sort_column_id    (GtkTreeSortable        *sortable,
+                                                        gint                   *sort_column_id,
+                                                        GtkSortType            *order);
+static void     gtk_column_store_set_sort_column_id    (GtkTreeSortable        *sortable,
+                                                        gint                    sort_column_id,
+                                                        GtkSortType             order);
+static void     gtk_column_store_set_sort_func         (GtkTreeSortable        *sortable,
+                                                        gint                    sort_column_id,
+                                                        GtkTreeIterCompareFunc  func,
+                                                        gpointer                data,
+                                                        GDestroyNotify          destroy);
+static void     gtk_column_store_set_default_sort_func (GtkTreeSortable        *sortable,
+                                                        GtkTreeIterCompareFunc  func,
+                                                        gpointer                data,
+                                                        GDestroyNotify          destroy);
+static gboolean gtk_column_store_has_default_sort_func (GtkTreeSortable        *sortable);
+
+G_DEFINE_TYPE_WITH_CODE (GtkColumnStore, gtk_column_store, G_TYPE_OBJECT,
+                         G_ADD_PRIVATE (GtkColumnStore)
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+                                                gtk_column_store_tree_model_init)
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_SORTABLE,
+                                                gtk_column_store_sortable_init))
+
+
+static void
+gtk_column_store_class_init (GtkColumnStoreClass *class)
+{
+  GObjectClass *object_class;
+
+  object_class = (GObjectClass*) class;
+
+  object_class->finalize = gtk_column_store_finalize;
+}
+
+static void
+gtk_column_store_tree_model_init (GtkTreeModelIface *iface)
+{
+  iface->get_flags = gtk_column_store_get_flags;
+  iface->get_n_columns = gtk_column_store_get_n_columns;
+  iface->get_column_type = gtk_column_store_get_column_type;
+  iface->get_iter = gtk_column_store_get_iter;
+  iface->get_path = gtk_column_store_get_path;
+  iface->get_value = gtk_column_store_get_value;
+  iface->iter_next = gtk_column_store_iter_next;
+  iface->iter_previous = gtk_column_store_iter_previous;
+  iface->iter_children = gtk_column_store_iter_children;
+  iface->iter_has_child = gtk_column_store_iter_has_child;
+  iface->iter_n_children = gtk_column_store_iter_n_children;
+  iface->iter_nth_child = gtk_column_store_iter_nth_child;
+  iface->iter_parent = gtk_column_store_iter_parent;
+}
+
+static void
+gtk_column_store_sortable_init (GtkTreeSortableIface *iface)
+{
+  iface->get_sort_column_id = gtk_column_store_get_sort_column_id;
+  iface->set_sort_column_id = gtk_column_store_set_sort_column_id;
+  iface->set_sort_func = gtk_column_store_set_sort_func;
+  iface->set_default_sort_func = gtk_column_store_set_default_sort_func;
+  iface->has_default_sort_func = gtk_column_store_has_default_sort_func;
+}
+
+static void
+gtk_column_store_init (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv;
+
+  column_store->priv = gtk_column_store_get_instance_private (column_store);
+  priv = column_store->priv;
+
+  priv->rows = g_array_new (FALSE, FALSE, sizeof (guint));
+  priv->free_rows = g_array_new (FALSE, FALSE, sizeof (guint));
+  priv->strings = g_string_chunk_new (4096);
+  priv->stamp = g_random_int ();
+  priv->sort_column_id = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+}
+
+static inline gboolean
+iter_is_valid (GtkTreeIter    *iter,
+               GtkColumnStore *column_store)
+{
+  return iter != NULL &&
+         column_store->priv->stamp == iter->stamp &&
+         ITER_POSITION (iter) < column_store->priv->rows->len;
+}
+
+static GType
+get_fundamental_type (GType type)
+{
+  GType result;
+
+  result = G_TYPE_FUNDAMENTAL (type);
+
+  if (result == G_TYPE_INTERFACE)
+    {
+      if (g_type_is_a (type, G_TYPE_OBJECT))
+        result = G_TYPE_OBJECT;
+    }
+
+  return result;
+}
+
+static gsize
+get_cell_size (GType fundamental)
+{
+  switch (fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+      return 1;
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+    case G_TYPE_FLOAT:
+      return 4;
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+      return sizeof (glong);
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+    case G_TYPE_DOUBLE:
+      return 8;
+    default:
+      return sizeof (gpointer);
+    }
+}
+
+/* The cells are moved in and out of GtkTreeDataList nodes, so the
+ * conversions from and to GValues can be shared with GtkListStore */
+static void
+gtk_column_store_cell_to_node (GtkColumnStoreColumn *column,
+                               guint                 row,
+                               GtkTreeDataList      *node)
+{
+  switch (column->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      node->data.v_int = CELL (column, row, guint8);
+      break;
+    case G_TYPE_CHAR:
+      node->data.v_char = CELL (column, row, gint8);
+      break;
+    case G_TYPE_UCHAR:
+      node->data.v_uchar = CELL (column, row, guint8);
+      break;
+    case G_TYPE_INT:
+    case G_TYPE_ENUM:
+      node->data.v_int = CELL (column, row, gint);
+      break;
+    case G_TYPE_UINT:
+    case G_TYPE_FLAGS:
+      node->data.v_uint = CELL (column, row, guint);
+      break;
+    case G_TYPE_LONG:
+      node->data.v_long = CELL (column, row, glong);
+      break;
+    case G_TYPE_ULONG:
+      node->data.v_ulong = CELL (column, row, gulong);
+      break;
+    case G_TYPE_INT64:
+      node->data.v_int64 = CELL (column, row, gint64);
+      break;
+    case G_TYPE_UINT64:
+      node->data.v_uint64 = CELL (column, row, guint64);
+      break;
+    case G_TYPE_FLOAT:
+      node->data.v_float = CELL (column, row, gfloat);
+      break;
+    case G_TYPE_DOUBLE:
+      node->data.v_double = CELL (column, row, gdouble);
+      break;
+    default:
+      node->data.v_pointer = CELL (column, row, gpointer);
+      break;
+    }
+}
+
+static void
+gtk_column_store_node_to_cell (GtkColumnStoreColumn *column,
+                               guint                 row,
+                               GtkTreeDataList      *node)
+{
+  switch (column->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      CELL (column, row, guint8) = node->data.v_int ? TRUE : FALSE;
+      break;
+    case G_TYPE_CHAR:
+      CELL (column, row, gint8) = node->data.v_char;
+      break;
+    case G_TYPE_UCHAR:
+      CELL (column, row, guint8) = node->data.v_uchar;
+      break;
+    case G_TYPE_INT:
+    case G_TYPE_ENUM:
+      CELL (column, row, gint) = node->data.v_int;
+      break;
+    case G_TYPE_UINT:
+    case G_TYPE_FLAGS:
+      CELL (column, row, guint) = node->data.v_uint;
+      break;
+    case G_TYPE_LONG:
+      CELL (column, row, glong) = node->data.v_long;
+      break;
+    case G_TYPE_ULONG:
+      CELL (column, row, gulong) = node->data.v_ulong;
+      break;
+    case G_TYPE_INT64:
+      CELL (column, row, gint64) = node->data.v_int64;
+      break;
+    case G_TYPE_UINT64:
+      CELL (column, row, guint64) = node->data.v_uint64;
+      break;
+    case G_TYPE_FLOAT:
+      CELL (column, row, gfloat) = node->data.v_float;
+      break;
+    case G_TYPE_DOUBLE:
+      CELL (column, row, gdouble) = node->data.v_double;
+      break;
+    default:
+      CELL (column, row, gpointer) = node->data.v_pointer;
+      break;
+    }
+}
+
+/* Releases the values of a physical row and zeroes its cells */
+static void
+gtk_column_store_clear_row (GtkColumnStore *column_store,
+                            guint           row)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &priv->columns[i];
+      gpointer pointer;
+
+      switch (column->fundamental)
+        {
+        case G_TYPE_OBJECT:
+          pointer = CELL (column, row, gpointer);
+          if (pointer)
+            g_object_unref (pointer);
+          break;
+        case G_TYPE_BOXED:
+          pointer = CELL (column, row, gpointer);
+          if (pointer)
+            g_boxed_free (column->type, pointer);
+          break;
+        case G_TYPE_VARIANT:
+          pointer = CELL (column, row, gpointer);
+          if (pointer)
+            g_variant_unref (pointer);
+          break;
+        default:
+          /* strings live in priv->strings */
+          break;
+        }
+
+      memset (column->cells + row * column->cell_size, 0, column->cell_size);
+    }
+}
+
+/* Returns an empty physical row */
+static guint
+gtk_column_store_alloc_row (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  guint row;
+  gint i;
+
+  if (priv->free_rows->len > 0)
+    {
+      row = g_array_index (priv->free_rows, guint, priv->free_rows->len - 1);
+      g_array_set_size (priv->free_rows, priv->free_rows->len - 1);
+      return row;
+    }
+
+  if (priv->n_physical == priv->n_allocated)
+    {
+      priv->n_allocated = MAX (64, priv->n_allocated * 2);
+      for (i = 0; i < priv->n_columns; i++)
+        priv->columns[i].cells = g_realloc_n (priv->columns[i].cells,
+                                              priv->n_allocated,
+                                              priv->columns[i].cell_size);
+    }
+
+  row = priv->n_physical++;
+
+  for (i = 0; i < priv->n_columns; i++)
+    memset (priv->columns[i].cells + row * priv->columns[i].cell_size,
+            0, priv->columns[i].cell_size);
+
+  return row;
+}
+
+static void
+gtk_column_store_increment_stamp (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  do
+    {
+      priv->stamp++;
+    }
+  while (priv->stamp == 0);
+}
+
+static void
+gtk_column_store_set_column_types (GtkColumnStore *column_store,
+                                   gint            n_columns,
+                                   GType          *types)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  priv->n_columns = n_columns;
+  priv->columns = g_new0 (GtkColumnStoreColumn, n_columns);
+
+  for (i = 0; i < n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &priv->columns[i];
+
+      if (!_gtk_tree_data_list_check_type (types[i]))
+        {
+          g_warning ("%s: Invalid type %s", G_STRLOC, g_type_name (types[i]));
+          column->type = G_TYPE_INT;
+        }
+      else
+        column->type = types[i];
+
+      column->fundamental = get_fundamental_type (column->type);
+      column->cell_size = get_cell_size (column->fundamental);
+    }
+
+  priv->sort_list = _gtk_tree_data_list_header_new (n_columns, types);
+}
+
+/**
+ * gtk_column_store_new:
+ * @n_columns: number of columns in the store
+ * @...: all #GType types for the columns, from first to last
+ *
+ * Creates a new column store with @n_columns columns of the types
+ * passed in. The same types as for #GtkListStore are supported.
+ *
+ * Returns: a new #GtkColumnStore
+ *
+ * Since: 3.92
+ */
+GtkColumnStore *
+gtk_column_store_new (gint n_columns,
+                      ...)
+{
+  GtkColumnStore *retval;
+  GType *types;
+  va_list args;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  types = g_new (GType, n_columns);
+
+  va_start (args, n_columns);
+  for (i = 0; i < n_columns; i++)
+    types[i] = va_arg (args, GType);
+  va_end (args);
+
+  retval = gtk_column_store_newv (n_columns, types);
+  g_free (types);
+
+  return retval;
+}
+
+/**
+ * gtk_column_store_newv: (rename-to gtk_column_store_new)
+ * @n_columns: number of columns in the store
+ * @types: (array length=n_columns): an array of #GType types for the columns, from first to last
+ *
+ * Non-vararg creation function. Used primarily by language bindings.
+ *
+ * Returns: (transfer full): a new #GtkColumnStore
+ *
+ * Since: 3.92
+ */
+GtkColumnStore *
+gtk_column_store_newv (gint   n_columns,
+                       GType *types)
+{
+  GtkColumnStore *retval;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+  g_return_val_if_fail (types != NULL, NULL);
+
+  retval = g_object_new (GTK_TYPE_COLUMN_STORE, NULL);
+  gtk_column_store_set_column_types (retval, n_columns, types);
+
+  return retval;
+}
+
+static void
+gtk_column_store_finalize (GObject *object)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (object);
+  GtkColumnStorePrivate *priv = column_store->priv;
+  guint i;
+
+  for (i = 0; i < priv->rows->len; i++)
+    gtk_column_store_clear_row (column_store, ROW_AT (priv, i));
+
+  for (i = 0; i < priv->n_columns; i++)
+    g_free (priv->columns[i].cells);
+  g_free (priv->columns);
+
+  g_array_free (priv->rows, TRUE);
+  g_array_free (priv->free_rows, TRUE);
+  g_string_chunk_free (priv->strings);
+
+  _gtk_tree_data_list_header_free (priv->sort_list);
+
+  if (priv->default_sort_destroy)
+    {
+      GDestroyNotify d = priv->default_sort_destroy;
+
+      priv->default_sort_destroy = NULL;
+      d (priv->default_sort_data);
+      priv->default_sort_data = NULL;
+    }
+
+  G_OBJECT_CLASS (gtk_column_store_parent_class)->finalize (object);
+}
+
+/* Fulfill the GtkTreeModel requirements */
+static GtkTreeModelFlags
+gtk_column_store_get_flags (GtkTreeModel *tree_model)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+gtk_column_store_get_n_columns (GtkTreeModel *tree_model)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  return column_store->priv->n_columns;
+}
+
+static GType
+gtk_column_store_get_column_type (GtkTreeModel *tree_model,
+                                  gint          index)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  g_return_val_if_fail (index < priv->n_columns, G_TYPE_INVALID);
+
+  return priv->columns[index].type;
+}
+
+static gboolean
+gtk_column_store_get_iter (GtkTreeModel *tree_model,
+                           GtkTreeIter  *iter,
+                           GtkTreePath  *path)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  i = gtk_tree_path_get_indices (path)[0];
+
+  if (i < 0 || i >= priv->rows->len)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->stamp = priv->stamp;
+  iter->user_data = GUINT_TO_POINTER (i);
+
+  return TRUE;
+}
+
+static GtkTreePath *
+gtk_column_store_get_path (GtkTreeModel *tree_model,
+                           GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter_is_valid (iter, column_store), NULL);
+
+  return gtk_tree_path_new_from_indices (ITER_POSITION (iter), -1);
+}
+
+static void
+gtk_column_store_get_value (GtkTreeModel *tree_model,
+                            GtkTreeIter  *iter,
+                            gint          column,
+                            GValue       *value)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreeDataList node;
+
+  g_return_if_fail (column < priv->n_columns);
+  g_return_if_fail (iter_is_valid (iter, column_store));
+
+  gtk_column_store_cell_to_node (&priv->columns[column],
+                                 ROW_AT (priv, ITER_POSITION (iter)),
+                                 &node);
+  _gtk_tree_data_list_node_to_value (&node, priv->columns[column].type, value);
+}
+
+static gboolean
+gtk_column_store_iter_next (GtkTreeModel *tree_model,
+                            GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter_is_valid (iter, column_store), FALSE);
+
+  if (ITER_POSITION (iter) + 1 >= column_store->priv->rows->len)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->user_data = GUINT_TO_POINTER (ITER_POSITION (iter) + 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_previous (GtkTreeModel *tree_model,
+                                GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter_is_valid (iter, column_store), FALSE);
+
+  if (ITER_POSITION (iter) == 0)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->user_data = GUINT_TO_POINTER (ITER_POSITION (iter) - 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_children (GtkTreeModel *tree_model,
+                                GtkTreeIter  *iter,
+                                GtkTreeIter  *parent)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  /* this is a list, nodes have no children */
+  if (parent || priv->rows->len == 0)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->stamp = priv->stamp;
+  iter->user_data = GUINT_TO_POINTER (0);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_has_child (GtkTreeModel *tree_model,
+                                 GtkTreeIter  *iter)
+{
+  return FALSE;
+}
+
+static gint
+gtk_column_store_iter_n_children (GtkTreeModel *tree_model,
+                                  GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  if (iter == NULL)
+    return column_store->priv->rows->len;
+
+  g_return_val_if_fail (iter_is_valid (iter, column_store), -1);
+
+  return 0;
+}
+
+static gboolean
+gtk_column_store_iter_nth_child (GtkTreeModel *tree_model,
+                                 GtkTreeIter  *iter,
+                                 GtkTreeIter  *parent,
+                                 gint          n)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if (parent || n < 0 || n >= priv->rows->len)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->stamp = priv->stamp;
+  iter->user_data = GUINT_TO_POINTER (n);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_parent (GtkTreeModel *tree_model,
+                              GtkTreeIter  *iter,
+                              GtkTreeIter  *child)
+{
+  iter->stamp = 0;
+  return FALSE;
+}
+
+/* Does not emit a signal */
+static gboolean
+gtk_column_store_real_set_value (GtkColumnStore *column_store,
+                                 guint           row,
+                                 gint            column,
+                                 GValue         *value)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkColumnStoreColumn *col;
+  GValue real_value = G_VALUE_INIT;
+  GtkTreeDataList node;
+
+  if (column < 0 || column >= priv->n_columns)
+    {
+      g_warning ("%s: Invalid column number %d", G_STRLOC, column);
+      return FALSE;
+    }
+
+  col = &priv->columns[column];
+
+  if (! g_type_is_a (G_VALUE_TYPE (value), col->type))
+    {
+      if (! (g_value_type_transformable (G_VALUE_TYPE (value), col->type)))
+        {
+          g_warning ("%s: Unable to convert from %s to %s",
+                     G_STRLOC,
+                     g_type_name (G_VALUE_TYPE (value)),
+                     g_type_name (col->type));
+          return FALSE;
+        }
+
+      g_value_init (&real_value, col->type);
+      if (!g_value_transform (value, &real_value))
+        {
+          g_warning ("%s: Unable to make conversion from %s to %s",
+                     G_STRLOC,
+                     g_type_name (G_VALUE_TYPE (value)),
+                     g_type_name (col->type));
+          g_value_unset (&real_value);
+          return FALSE;
+        }
+
+      value = &real_value;
+    }
+
+  if (col->fundamental == G_TYPE_STRING)
+    {
+      const gchar *str = g_value_get_string (value);
+
+      node.data.v_pointer = str ? g_string_chunk_insert_const (priv->strings, str) : NULL;
+    }
+  else
+    {
+      /* The node starts out with the old value, so it gets released */
+      gtk_column_store_cell_to_node (col, row, &node);
+      _gtk_tree_data_list_value_to_node (&node, value);
+    }
+
+  gtk_column_store_node_to_cell (col, row, &node);
+
+  if (value == &real_value)
+    g_value_unset (&real_value);
+
+  return TRUE;
+}
+
+/* sorting */
+
+static gint
+gtk_column_store_compare (GtkColumnStore *column_store,
+                          guint           a,
+                          guint           b)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreeIterCompareFunc func;
+  GtkTreeIter iter_a, iter_b;
+  gpointer data;
+  gint retval;
+
+  if (priv->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    {
+      GtkTreeDataSortHeader *header;
+
+      header = _gtk_tree_data_list_get_header (priv->sort_list,
+                                               priv->sort_column_id);
+      g_return_val_if_fail (header != NULL, 0);
+      g_return_val_if_fail (header->func != NULL, 0);
+
+      func = header->func;
+      data = header->data;
+    }
+  else
+    {
+      g_return_val_if_fail (priv->default_sort_func != NULL, 0);
+      func = priv->default_sort_func;
+      data = priv->default_sort_data;
+    }
+
+  iter_a.stamp = priv->stamp;
+  iter_a.user_data = GUINT_TO_POINTER (a);
+  iter_b.stamp = priv->stamp;
+  iter_b.user_data = GUINT_TO_POINTER (b);
+
+  retval = (* func) (GTK_TREE_MODEL (column_store), &iter_a, &iter_b, data);
+
+  if (priv->order == GTK_SORT_DESCENDING)
+    {
+      if (retval > 0)
+        retval = -1;
+      else if (retval < 0)
+        retval = 1;
+    }
+
+  return retval;
+}
+
+/* Finds where the row at the last position belongs among the rows
+ * before it, after all rows that compare equal to it */
+static guint
+gtk_column_store_find_sorted_position (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  guint last, low, high, middle;
+
+  last = priv->rows->len - 1;
+  low = 0;
+  high = last;
+
+  while (low < high)
+    {
+      middle = low + (high - low) / 2;
+
+      if (gtk_column_store_compare (column_store, last, middle) < 0)
+        high = middle;
+      else
+        low = middle + 1;
+    }
+
+  return low;
+}
+
+/* Moves the row at @position to where it belongs and updates @iter */
+static void
+gtk_column_store_sort_iter_changed (GtkColumnStore *column_store,
+                                    GtkTreeIter    *iter)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreePath *path;
+  guint position, new_position, row, length, i, j;
+  gint *new_order;
+
+  position = ITER_POSITION (iter);
+  length = priv->rows->len;
+
+  if ((position == 0 ||
+       gtk_column_store_compare (column_store, position - 1, position) <= 0) &&
+      (position + 1 == length ||
+       gtk_column_store_compare (column_store, position, position + 1) <= 0))
+    return;
+
+  row = ROW_AT (priv, position);
+  g_array_remove_index (priv->rows, position);
+  g_array_append_val (priv->rows, row);
+
+  new_position = gtk_column_store_find_sorted_position (column_store);
+
+  g_array_set_size (priv->rows, length - 1);
+  g_array_insert_val (priv->rows, new_position, row);
+
+  new_order = g_new (gint, length);
+  for (i = 0, j = 0; i < length; i++)
+    {
+      if (i == new_position)
+        new_order[i] = position;
+      else
+        {
+          if (j == position)
+            j++;
+          new_order[i] = j++;
+        }
+    }
+
+  gtk_column_store_increment_stamp (column_store);
+  iter->stamp = priv->stamp;
+  iter->user_data = GUINT_TO_POINTER (new_position);
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (column_store),
+                                 path, NULL, new_order);
+  gtk_tree_path_free (path);
+  g_free (new_order);
+}
+
+static gint
+gtk_column_store_compare_positions (gconstpointer a,
+                                    gconstpointer b,
+                                    gpointer      user_data)
+{
+  gint pa = *(const gint *) a;
+  gint pb = *(const gint *) b;
+  gint retval;
+
+  retval = gtk_column_store_compare (user_data, pa, pb);
+  if (retval == 0)
+    retval = pa < pb ? -1 : (pa > pb ? 1 : 0);
+
+  return retval;
+}
+
+/* Sorts by the values of the sort column, which are read straight
+ * from the column. Returns %NULL for custom sort functions. */
+static gint *
+gtk_column_store_sort_by_keys (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreeDataSortHeader *header;
+  GtkTreeDataSortKeys *keys;
+  GtkColumnStoreColumn *column;
+  GtkTreeDataList node;
+  guint i;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    return NULL;
+
+  header = _gtk_tree_data_list_get_header (priv->sort_list,
+                                           priv->sort_column_id);
+  if (header == NULL || header->func != _gtk_tree_data_list_compare_func)
+    return NULL;
+
+  column = &priv->columns[GPOINTER_TO_INT (header->data)];
+  if (!_gtk_tree_data_sort_keys_supported (column->type))
+    return NULL;
+
+  keys = _gtk_tree_data_sort_keys_new (column->type, priv->rows->len);
+
+  for (i = 0; i < priv->rows->len; i++)
+    {
+      gtk_column_store_cell_to_node (column, ROW_AT (priv, i), &node);
+      _gtk_tree_data_sort_keys_set_node (keys, i, &node);
+    }
+
+  return _gtk_tree_data_sort_keys_sort (keys, priv->order);
+}
+
+static void
+gtk_column_store_sort (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreePath *path;
+  guint *old_rows;
+  gint *new_order;
+  guint i, length;
+
+  length = priv->rows->len;
+
+  if (!GTK_COLUMN_STORE_IS_SORTED (column_store) || length <= 1)
+    return;
+
+  new_order = gtk_column_store_sort_by_keys (column_store);
+
+  if (new_order == NULL)
+    {
+      new_order = g_new (gint, length);
+      for (i = 0; i < length; i++)
+        new_order[i] = i;
+
+      g_qsort_with_data (new_order, length, sizeof (gint),
+                         gtk_column_store_compare_positions, column_store);
+    }
+
+  old_rows = g_memdup (priv->rows->data, length * sizeof (guint));
+  for (i = 0; i < length; i++)
+    ROW_AT (priv, i) = old_rows[new_order[i]];
+  g_free (old_rows);
+
+  gtk_column_store_increment_stamp (column_store);
+
+  /* Let the world know about our new order */
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (column_store),
+                                 path, NULL, new_order);
+  gtk_tree_path_free (path);
+  g_free (new_order);
+}
+
+static gboolean
+gtk_column_store_get_sort_column_id (GtkTreeSortable  *sortable,
+                                     gint             *sort_column_id,
+                                     GtkSortType      *order)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (sortable);
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if (sort_column_id)
+    * sort_column_id = priv->sort_column_id;
+  if (order)
+    * order = priv->order;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID ||
+      priv->sort_column_id == GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gtk_column_store_set_sort_column_id (GtkTreeSortable  *sortable,
+                                     gint              sort_column_id,
+                                     GtkSortType       order)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (sortable);
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if ((priv->sort_column_id == sort_column_id) &&
+      (priv->order == order))
+    return;
+
+  if (sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    {
+      if (sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+        {
+          GtkTreeDataSortHeader *header = NULL;
+
+          header = _gtk_tree_data_list_get_header (priv->sort_list,
+                                                   sort_column_id);
+
+          /* We want to make sure that we have a function */
+          g_return_if_fail (header != NULL);
+          g_return_if_fail (header->func != NULL);
+        }
+      else
+        {
+          g_return_if_fail (priv->default_sort_func != NULL);
+        }
+    }
+
+  priv->sort_column_id = sort_column_id;
+  priv->order = order;
+
+  gtk_tree_sortable_sort_column_changed (sortable);
+
+  gtk_column_store_sort (column_store);
+}
+
+static void
+gtk_column_store_set_sort_func (GtkTreeSortable        *sortable,
+                                gint                    sort_column_id,
+                                GtkTreeIterCompareFunc  func,
+                                gpointer                data,
+                                GDestroyNotify          destroy)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (sortable);
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  priv->sort_list = _gtk_tree_data_list_set_header (priv->sort_list,
+                                                    sort_column_id,
+                                                    func, data, destroy);
+
+  if (priv->sort_column_id == sort_column_id)
+    gtk_column_store_sort (column_store);
+}
+
+static void
+gtk_column_store_set_default_sort_func (GtkTreeSortable        *sortable,
+                                        GtkTreeIterCompareFunc  func,
+                                        gpointer                data,
+                                        GDestroyNotify          destroy)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (sortable);
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if (priv->default_sort_destroy)
+    {
+      GDestroyNotify d = priv->default_sort_destroy;
+
+      priv->default_sort_destroy = NULL;
+      d (priv->default_sort_data);
+    }
+
+  priv->default_sort_func = func;
+  priv->default_sort_data = data;
+  priv->default_sort_destroy = destroy;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    gtk_column_store_sort (column_store);
+}
+
+static gboolean
+gtk_column_store_has_default_sort_func (GtkTreeSortable *sortable)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (sortable);
+
+  return (column_store->priv->default_sort_func != NULL);
+}
+
+/* Public API */
+
+static void
+gtk_column_store_changed (GtkColumnStore *column_store,
+                          GtkTreeIter    *iter,
+                          gboolean        maybe_need_sort)
+{
+  GtkTreePath *path;
+
+  if (maybe_need_sort && GTK_COLUMN_STORE_IS_SORTED (column_store))
+    gtk_column_store_sort_iter_changed (column_store, iter);
+
+  path = gtk_column_store_get_path (GTK_TREE_MODEL (column_store), iter);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (column_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+static gboolean
+gtk_column_store_column_needs_sort (GtkColumnStore *column_store,
+                                    gint            column)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreeDataSortHeader *header;
+
+  if (!GTK_COLUMN_STORE_IS_SORTED (column_store))
+    return FALSE;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    return TRUE;
+
+  /* Custom sort functions may look at any column */
+  header = _gtk_tree_data_list_get_header (priv->sort_list, priv->sort_column_id);
+  if (header == NULL || header->func != _gtk_tree_data_list_compare_func)
+    return TRUE;
+
+  return column == priv->sort_column_id;
+}
+
+/**
+ * gtk_column_store_set_value:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @column: column number to modify
+ * @value: new value for the cell
+ *
+ * Sets the data in the cell specified by @iter and @column.
+ * The type of @value must be convertible to the type of the
+ * column.
+ *
+ * If the store is sorted and the row moves, @iter is updated to
+ * point to it at its new position.
+ *
+ * Since: 3.92
+ */
+void
+gtk_column_store_set_value (GtkColumnStore *column_store,
+                            GtkTreeIter    *iter,
+                            gint            column,
+                            GValue         *value)
+{
+  GtkColumnStorePrivate *priv;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter_is_valid (iter, column_store));
+  g_return_if_fail (G_IS_VALUE (value));
+
+  priv = column_store->priv;
+
+  if (gtk_column_store_real_set_value (column_store,
+                                       ROW_AT (priv, ITER_POSITION (iter)),
+                                       column, value))
+    gtk_column_store_changed (column_store, iter,
+                              gtk_column_store_column_needs_sort (column_store, column));
+}
+
+/**
+ * gtk_column_store_set_valuesv: (rename-to gtk_column_store_set)
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array length=n_values): an array of GValues
+ * @n_values: the length of the @columns and @values arrays
+ *
+ * A variant of gtk_column_store_set() which takes the columns and
+ * values as two arrays, instead of varargs.
+ *
+ * Since: 3.92
+ */
+void
+gtk_column_store_set_valuesv (GtkColumnStore *column_store,
+                              GtkTreeIter    *iter,
+                              gint           *columns,
+                              GValue         *values,
+                              gint            n_values)
+{
+  GtkColumnStorePrivate *priv;
+  gboolean changed = FALSE;
+  gboolean maybe_need_sort = FALSE;
+  guint row;
+  gint i;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter_is_valid (iter, column_store));
+
+  priv = column_store->priv;
+  row = ROW_AT (priv, ITER_POSITION (iter));
+
+  for (i = 0; i < n_values; i++)
+    {
+      if (gtk_column_store_real_set_value (column_store, row, columns[i], &values[i]))
+        {
+          changed = TRUE;
+          maybe_need_sort |= gtk_column_store_column_needs_sort (column_store, columns[i]);
+        }
+    }
+
+  if (changed)
+    gtk_column_store_changed (column_store, iter, maybe_need_sort);
+}
+
+/* Sets the values of a va_list of column number and value pairs,
+ * terminated with -1. Returns whether anything was set. */
+static gboolean
+gtk_column_store_set_valist_internal (GtkColumnStore *column_store,
+                                      guint           row,
+                                      gboolean       *maybe_need_sort,
+                                      va_list         var_args)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gboolean changed = FALSE;
+  gint column;
+
+  column = va_arg (var_args, gint);
+
+  while (column != -1)
+    {
+      GValue value = G_VALUE_INIT;
+      gchar *error = NULL;
+
+      if (column < 0 || column >= priv->n_columns)
+        {
+          g_warning ("%s: Invalid column number %d added to iter (remember to end your list of columns with a -1)", G_STRLOC, column);
+          break;
+        }
+
+      G_VALUE_COLLECT_INIT (&value, priv->columns[column].type,
+                            var_args, 0, &error);
+      if (error)
+        {
+          g_warning ("%s: %s", G_STRLOC, error);
+          g_free (error);
+
+          /* we purposely leak the value here, it might not be
+           * in a sane state if an error condition occoured
+           */
+          break;
+        }
+
+      if (gtk_column_store_real_set_value (column_store, row, column, &value))
+        {
+          changed = TRUE;
+          *maybe_need_sort |= gtk_column_store_column_needs_sort (column_store, column);
+        }
+
+      g_value_unset (&value);
+
+      column = va_arg (var_args, gint);
+    }
+
+  return changed;
+}
+
+/**
+ * gtk_column_store_set:
+ * @column_store: a #GtkColumnStore
+ * @iter: row iterator
+ * @...: pairs of column number and value, terminated with -1
+ *
+ * Sets the value of one or more cells in the row referenced by @iter.
+ * The variable argument list should contain integer column numbers,
+ * each column number followed by the value to be set, like for
+ * gtk_list_store_set().
+ *
+ * If the store is sorted and the row moves, @iter is updated to
+ * point to it at its new position.
+ *
+ * Since: 3.92
+ */
+void
+gtk_column_store_set (GtkColumnStore *column_store,
+                      GtkTreeIter    *iter,
+                      ...)
+{
+  gboolean maybe_need_sort = FALSE;
+  va_list var_args;
+  gboolean changed;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter_is_valid (iter, column_store));
+
+  va_start (var_args, iter);
+  changed = gtk_column_store_set_valist_internal (column_store,
+                                                  ROW_AT (column_store->priv, ITER_POSITION (iter)),
+                                                  &maybe_need_sort,
+                                                  var_args);
+  va_end (var_args);
+
+  if (changed)
+    gtk_column_store_changed (column_store, iter, maybe_need_sort);
+}
+
+/**
+ * gtk_column_store_remove:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ *
+ * Removes the given row from the column store. After being removed,
+ * @iter is set to the next valid row, or invalidated if it pointed
+ * to the last row in @column_store.
+ *
+ * Returns: %TRUE if @iter is valid, %FALSE if not.
+ *
+ * Since: 3.92
+ */
+gboolean
+gtk_column_store_remove (GtkColumnStore *column_store,
+                         GtkTreeIter    *iter)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+  guint position, row;
+
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (iter_is_valid (iter, column_store), FALSE);
+
+  priv = column_store->priv;
+  position = ITER_POSITION (iter);
+  row = ROW_AT (priv, position);
+
+  gtk_column_store_clear_row (column_store, row);
+  g_array_append_val (priv->free_rows, row);
+  g_array_remove_index (priv->rows, position);
+
+  gtk_column_store_increment_stamp (column_store);
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (column_store), path);
+  gtk_tree_path_free (path);
+
+  if (position < priv->rows->len)
+    {
+      iter->stamp = priv->stamp;
+      return TRUE;
+    }
+
+  iter->stamp = 0;
+  return FALSE;
+}
+
+/**
+ * gtk_column_store_clear:
+ * @column_store: a #GtkColumnStore
+ *
+ * Removes all rows from the column store, and gives back the memory
+ * used by its strings.
+ *
+ * Since: 3.92
+ */
+void
+gtk_column_store_clear (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+  guint position, n_rows;
+  gint i;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  priv = column_store->priv;
+
+  n_rows = priv->rows->len;
+  if (n_rows > 0)
+    {
+      for (position = 0; position < n_rows; position++)
+        gtk_column_store_clear_row (column_store, ROW_AT (priv, position));
+      g_array_set_size (priv->rows, 0);
+
+      gtk_column_store_increment_stamp (column_store);
+
+      path = gtk_tree_path_new_first ();
+      gtk_tree_model_rows_deleted (GTK_TREE_MODEL (column_store), path, n_rows);
+      gtk_tree_path_free (path);
+    }
+
+  for (i = 0; i < priv->n_columns; i++)
+    g_clear_pointer (&priv->columns[i].cells, g_free);
+
+  g_array_set_size (priv->free_rows, 0);
+  priv->n_physical = 0;
+  priv->n_allocated = 0;
+
+  g_string_chunk_clear (priv->strings);
+
+  gtk_column_store_increment_stamp (column_store);
+}
+
+/* Puts @row at @position, or where it belongs if the store is sorted,
+ * and emits ::row-inserted */
+static void
+gtk_column_store_insert_row (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             gint            position,
+                             guint           row)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreePath *path;
+
+  if (GTK_COLUMN_STORE_IS_SORTED (column_store))
+    {
+      g_array_append_val (priv->rows, row);
+      position = gtk_column_store_find_sorted_position (column_store);
+      g_array_set_size (priv->rows, priv->rows->len - 1);
+    }
+  else if (position < 0 || position > priv->rows->len)
+    position = priv->rows->len;
+
+  g_array_insert_val (priv->rows, position, row);
+
+  gtk_column_store_increment_stamp (column_store);
+
+  iter->stamp = priv->stamp;
+  iter->user_data = GUINT_TO_POINTER (position);
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (column_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_insert_with_values:
+ * @column_store: A #GtkColumnStore
+ * @iter: (out) (allow-none): An unset #GtkTreeIter to set to the new row, or %NULL
+ * @position: position to insert the new row, or -1 to append after existing
+ *     rows
+ * @...: pairs of column number and value, terminated with -1
+ *
+ * Creates a new row at @position and fills it with the values given
+ * to this function, in one operation with regard to #GtkTreeModel
+ * signals. If the store is sorted, @position is ignored and the row
+ * is inserted where it belongs.
+ *
+ * Since: 3.92
+ */
+void
+gtk_column_store_insert_with_values (GtkColumnStore *column_store,
+                                     GtkTreeIter    *iter,
+                                     gint            position,
+                                     ...)
+{
+  gboolean maybe_need_sort = FALSE;
+  GtkTreeIter tmp_iter;
+  va_list var_args;
+  guint row;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  if (!iter)
+    iter = &tmp_iter;
+
+  row = gtk_column_store_alloc_row (column_store);
+
+  va_start (var_args, position);
+  gtk_column_store_set_valist_internal (column_store, row,
+                                        &maybe_need_sort, var_args);
+  va_end (var_args);
+
+  gtk_column_store_insert_row (column_store, iter, position, row);
+}
+
+/**
+ * gtk_column_store_insert_with_valuesv:
+ * @column_store: A #GtkColumnStore
+ * @iter: (out) (allow-none): An unset #GtkTreeIter to set to the new row, or %NULL.
+ * @position: position to insert the new row, or -1 for last
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array length=n_values): an array of GValues
+ * @n_values: the length of the @columns and @values arrays
+ *
+ * A variant of gtk_column_store_insert_with_values() which takes
+ * the columns and values as two arrays, instead of varargs.
+ *
+ * Since: 3.92
+ */
+void
+gtk_column_store_insert_with_valuesv (GtkColumnStore *column_store,
+                                      GtkTreeIter    *iter,
+                                      gint            position,
+                                      gint           *columns,
+                                      GValue         *values,
+                                      gint            n_values)
+{
+  GtkTreeIter tmp_iter;
+  guint row;
+  gint i;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  if (!iter)
+    iter = &tmp_iter;
+
+  row = gtk_column_store_alloc_row (column_store);
+
+  for (i = 0; i < n_values; i++)
+    gtk_column_store_real_set_value (column_store, row, columns[i], &values[i]);
+
+  gtk_column_store_insert_row (column_store, iter, position, row);
+}
+
+/**
+ * gtk_column_store_insert_rows:
+ * @column_store: A #GtkColumnStore
+ * @position: position to insert the new rows, or -1 to append them
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_values * @n_rows GValues
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows new rows at @position and fills them in one go,
+ * like gtk_list_store_insert_rows(). The value for column
+ * @columns[i] of the j-th new row is @values[i * @n_rows + j].
+ *
+ * Unless the store is sorted, the new rows are announced with a
+ * single #GtkTreeModel::rows-inserted signal.
+ *
+ * Since: 3.92
+ */
+void
+gtk_column_store_insert_rows (GtkColumnStore *column_store,
+                              gint            position,
+                              gint            n_rows,
+                              gint           *columns,
+                              GValue         *values,
+                              gint            n_values)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  guint *rows;
+  gint i, j;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  priv = column_store->priv;
+
+  if (n_rows == 0)
+    return;
+
+  if (position < 0 || position > priv->rows->len)
+    position = priv->rows->len;
+
+  if (GTK_COLUMN_STORE_IS_SORTED (column_store))
+    {
+      /* The rows end up scattered over the store, so insert them
+       * one at a time */
+      for (j = 0; j < n_rows; j++)
+        {
+          guint row = gtk_column_store_alloc_row (column_store);
+
+          for (i = 0; i < n_values; i++)
+            gtk_column_store_real_set_value (column_store, row,
+                                             columns[i], &values[i * n_rows + j]);
+
+          gtk_column_store_insert_row (column_store, &iter, -1, row);
+        }
+
+      return;
+    }
+
+  rows = g_new (guint, n_rows);
+
+  for (j = 0; j < n_rows; j++)
+    rows[j] = gtk_column_store_alloc_row (column_store);
+
+  /* Column by column, the way the values are laid out */
+  for (i = 0; i < n_values; i++)
+    for (j = 0; j < n_rows; j++)
+      gtk_column_store_real_set_value (column_store, rows[j],
+                                       columns[i], &values[i * n_rows + j]);
+
+  g_array_insert_vals (priv->rows, position, rows, n_rows);
+  g_free (rows);
+
+  gtk_column_store_increment_stamp (column_store);
+
+  iter.stamp = priv->stamp;
+  iter.user_data = GUINT_TO_POINTER (position);
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (column_store), path, &iter, n_rows);
+  gtk_tree_path_free (path);
+}
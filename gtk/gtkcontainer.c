@@ -46,6 +46,7 @@
 #include "gtkwindow.h"
 #include "gtkassistant.h"
 #include "gtkintl.h"
+#include "gtkcssstaticstyleprivate.h"
 #include "gtkstylecontextprivate.h"
 #include "gtkwidgetpath.h"
 #include "a11y/gtkcontaineraccessible.h"
@@ -1706,6 +1707,7 @@ gtk_container_idle_sizer (GdkFrameClock *clock,
     {
       priv->restyle_pending = FALSE;
       gtk_css_node_validate (gtk_widget_get_css_node (GTK_WIDGET (container)));
+      GTK_NOTE (STYLES, gtk_css_static_style_report_memory ());
     }
 
   /* we may be invoked with a container_resize_queue of NULL, because
@@ -0,0 +1,145 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_CSS_ANCESTOR_FILTER_PRIVATE_H__
+#define __GTK_CSS_ANCESTOR_FILTER_PRIVATE_H__
+
+#include <glib.h>
+#include <string.h>
+
+G_BEGIN_DECLS
+
+/* A bloom filter of the names, ids and style classes of all ancestors
+ * of a node. It may claim to contain things that none of the ancestors
+ * have, but never misses one that they do have. So if a selector
+ * requires an ancestor with a name, id or class that isn't in the
+ * filter, the ancestors don't need to be looked at. */
+
+#define GTK_CSS_ANCESTOR_FILTER_BITS 256
+
+typedef struct _GtkCssAncestorFilter GtkCssAncestorFilter;
+
+struct _GtkCssAncestorFilter {
+  guint32 bits[GTK_CSS_ANCESTOR_FILTER_BITS / 32];
+};
+
+/* Names and ids are interned strings and classes are quarks, so their
+ * values are hashed directly. The salt keeps a name from matching an
+ * id or class with the same value. */
+enum {
+  GTK_CSS_ANCESTOR_FILTER_NAME = 0x9e3779b9,
+  GTK_CSS_ANCESTOR_FILTER_ID = 0x85ebca6b,
+  GTK_CSS_ANCESTOR_FILTER_CLASS = 0xc2b2ae35
+};
+
+static inline guint
+gtk_css_ancestor_filter_hash (guint64 value,
+                              guint   salt)
+{
+  guint hash = (guint) (value ^ (value >> 32)) ^ salt;
+
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3b;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+static inline void
+gtk_css_ancestor_filter_init (GtkCssAncestorFilter *filter)
+{
+  memset (filter->bits, 0, sizeof (filter->bits));
+}
+
+/* Makes the filter match everything, for ancestors that can't be
+ * enumerated */
+static inline void
+gtk_css_ancestor_filter_init_full (GtkCssAncestorFilter *filter)
+{
+  memset (filter->bits, 0xff, sizeof (filter->bits));
+}
+
+/* Every hash sets two bits, taken from different parts of the hash */
+static inline void
+gtk_css_ancestor_filter_add_hash (GtkCssAncestorFilter *filter,
+                                  guint                 hash)
+{
+  guint a = hash % GTK_CSS_ANCESTOR_FILTER_BITS;
+  guint b = (hash >> 16) % GTK_CSS_ANCESTOR_FILTER_BITS;
+
+  filter->bits[a / 32] |= 1u << (a % 32);
+  filter->bits[b / 32] |= 1u << (b % 32);
+}
+
+static inline gboolean
+gtk_css_ancestor_filter_may_contain_hash (const GtkCssAncestorFilter *filter,
+                                          guint                       hash)
+{
+  guint a = hash % GTK_CSS_ANCESTOR_FILTER_BITS;
+  guint b = (hash >> 16) % GTK_CSS_ANCESTOR_FILTER_BITS;
+
+  return (filter->bits[a / 32] & (1u << (a % 32))) &&
+         (filter->bits[b / 32] & (1u << (b % 32)));
+}
+
+static inline void
+gtk_css_ancestor_filter_add_name (GtkCssAncestorFilter    *filter,
+                                  /*interned*/ const char *name)
+{
+  if (name)
+    gtk_css_ancestor_filter_add_hash (filter, gtk_css_ancestor_filter_hash (GPOINTER_TO_SIZE (name), GTK_CSS_ANCESTOR_FILTER_NAME));
+}
+
+static inline void
+gtk_css_ancestor_filter_add_id (GtkCssAncestorFilter    *filter,
+                                /*interned*/ const char *id)
+{
+  if (id)
+    gtk_css_ancestor_filter_add_hash (filter, gtk_css_ancestor_filter_hash (GPOINTER_TO_SIZE (id), GTK_CSS_ANCESTOR_FILTER_ID));
+}
+
+static inline void
+gtk_css_ancestor_filter_add_class (GtkCssAncestorFilter *filter,
+                                   GQuark                style_class)
+{
+  gtk_css_ancestor_filter_add_hash (filter, gtk_css_ancestor_filter_hash (style_class, GTK_CSS_ANCESTOR_FILTER_CLASS));
+}
+
+static inline gboolean
+gtk_css_ancestor_filter_may_have_name (const GtkCssAncestorFilter *filter,
+                                       /*interned*/ const char     *name)
+{
+  return gtk_css_ancestor_filter_may_contain_hash (filter, gtk_css_ancestor_filter_hash (GPOINTER_TO_SIZE (name), GTK_CSS_ANCESTOR_FILTER_NAME));
+}
+
+static inline gboolean
+gtk_css_ancestor_filter_may_have_id (const GtkCssAncestorFilter *filter,
+                                     /*interned*/ const char     *id)
+{
+  return gtk_css_ancestor_filter_may_contain_hash (filter, gtk_css_ancestor_filter_hash (GPOINTER_TO_SIZE (id), GTK_CSS_ANCESTOR_FILTER_ID));
+}
+
+static inline gboolean
+gtk_css_ancestor_filter_may_have_class (const GtkCssAncestorFilter *filter,
+                                        GQuark                      style_class)
+{
+  return gtk_css_ancestor_filter_may_contain_hash (filter, gtk_css_ancestor_filter_hash (style_class, GTK_CSS_ANCESTOR_FILTER_CLASS));
+}
+
+G_END_DECLS
+
+#endif /* __GTK_CSS_ANCESTOR_FILTER_PRIVATE_H__ */
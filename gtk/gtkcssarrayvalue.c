@@ -397,3 +397,10 @@ _gtk_css_array_value_get_n_values (const GtkCssValue *value)
   return value->n_values;
 }
 
+gboolean
+_gtk_css_value_is_array (const GtkCssValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  return value->class == &GTK_CSS_VALUE_ARRAY;
+}
@@ -35,6 +35,7 @@ GtkCssValue *       _gtk_css_array_value_parse          (GtkCssParser          *
 GtkCssValue *       _gtk_css_array_value_get_nth        (const GtkCssValue     *value,
                                                          guint                  i);
 guint               _gtk_css_array_value_get_n_values   (const GtkCssValue     *value);
+gboolean            _gtk_css_value_is_array             (const GtkCssValue     *value);
 
 
 G_END_DECLS
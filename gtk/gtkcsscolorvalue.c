@@ -38,6 +38,9 @@ typedef enum {
   COLOR_TYPE_CURRENT_COLOR
 } ColorType;
 
+/* Protects last_value, as styles can be computed on multiple threads */
+G_LOCK_DEFINE_STATIC (last_value);
+
 struct _GtkCssValue
 {
   GTK_CSS_VALUE_BASE
@@ -270,6 +273,8 @@ _gtk_css_color_value_resolve (GtkCssValue             *color,
       g_assert_not_reached ();
     }
 
+  G_LOCK (last_value);
+
   if (color->last_value != NULL &&
       _gtk_css_value_equal (color->last_value, value))
     {
@@ -283,6 +288,8 @@ _gtk_css_color_value_resolve (GtkCssValue             *color,
       color->last_value = _gtk_css_value_ref (value);
     }
 
+  G_UNLOCK (last_value);
+
   return value;
 }
 
@@ -0,0 +1,307 @@
+/*
+ * Copyright © 2017 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkcsscompiledprivate.h"
+
+#include "gtkcssstylepropertyprivate.h"
+#include "gtkstylepropertyprivate.h"
+#include "gtkversion.h"
+
+#include <string.h>
+
+/* The format of compiled style sheets
+ *
+ * A compiled style sheet starts with a header of 32bit words in host byte
+ * order, followed by the body and a table of NUL-terminated strings:
+ *
+ *   magic, format version, GTK major, minor and micro version,
+ *   pointer size, property signature, string table offset and length
+ *
+ * The body is a sequence of 32bit words that is read in order by
+ * GtkCssProvider. Strings in the body are stored as offsets into the
+ * string table, and every string is stored only once.
+ *
+ * Blobs are only valid for the exact GTK version and architecture that
+ * wrote them, as they use the ids of the style properties and the layout
+ * of the selector tree. Anything that does not match is rejected, and the
+ * style sheet is parsed from its text instead.
+ */
+
+#define GTK_CSS_COMPILED_MAGIC 0x53534347 /* "GCSS" */
+#define GTK_CSS_COMPILED_VERSION 1
+
+enum {
+  HEADER_MAGIC,
+  HEADER_VERSION,
+  HEADER_MAJOR,
+  HEADER_MINOR,
+  HEADER_MICRO,
+  HEADER_POINTER_SIZE,
+  HEADER_PROPERTIES,
+  HEADER_STRINGS_OFFSET,
+  HEADER_STRINGS_LENGTH,
+  N_HEADER_FIELDS
+};
+
+#define HEADER_SIZE (N_HEADER_FIELDS * sizeof (guint32))
+
+struct _GtkCssCompiledWriter
+{
+  GByteArray *body;
+  GString *strings;
+  GHashTable *string_offsets;
+};
+
+struct _GtkCssCompiledReader
+{
+  GBytes *bytes;
+  const guint8 *body;
+  gsize body_length;
+  gsize pos;
+  const char *strings;
+  gsize strings_length;
+  gboolean failed;
+};
+
+/* Changes whenever style properties are added, removed or reordered,
+ * which would make the property ids stored in a blob meaningless. */
+static guint32
+gtk_css_compiled_get_property_signature (void)
+{
+  guint32 signature;
+  guint i, n;
+
+  n = _gtk_css_style_property_get_n_properties ();
+  signature = n;
+
+  for (i = 0; i < n; i++)
+    {
+      GtkCssStyleProperty *property = _gtk_css_style_property_lookup_by_id (i);
+
+      signature = signature * 31 + g_str_hash (_gtk_style_property_get_name (GTK_STYLE_PROPERTY (property)));
+    }
+
+  return signature;
+}
+
+GtkCssCompiledWriter *
+gtk_css_compiled_writer_new (void)
+{
+  GtkCssCompiledWriter *writer;
+
+  writer = g_slice_new (GtkCssCompiledWriter);
+  writer->body = g_byte_array_new ();
+  writer->strings = g_string_new (NULL);
+  writer->string_offsets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  return writer;
+}
+
+void
+gtk_css_compiled_writer_free (GtkCssCompiledWriter *writer)
+{
+  g_byte_array_unref (writer->body);
+  g_string_free (writer->strings, TRUE);
+  g_hash_table_unref (writer->string_offsets);
+
+  g_slice_free (GtkCssCompiledWriter, writer);
+}
+
+GBytes *
+gtk_css_compiled_writer_free_to_bytes (GtkCssCompiledWriter *writer)
+{
+  guint32 header[N_HEADER_FIELDS];
+  GByteArray *data;
+
+  header[HEADER_MAGIC] = GTK_CSS_COMPILED_MAGIC;
+  header[HEADER_VERSION] = GTK_CSS_COMPILED_VERSION;
+  header[HEADER_MAJOR] = GTK_MAJOR_VERSION;
+  header[HEADER_MINOR] = GTK_MINOR_VERSION;
+  header[HEADER_MICRO] = GTK_MICRO_VERSION;
+  header[HEADER_POINTER_SIZE] = sizeof (gpointer);
+  header[HEADER_PROPERTIES] = gtk_css_compiled_get_property_signature ();
+  header[HEADER_STRINGS_OFFSET] = HEADER_SIZE + writer->body->len;
+  header[HEADER_STRINGS_LENGTH] = writer->strings->len;
+
+  data = g_byte_array_sized_new (HEADER_SIZE + writer->body->len + writer->strings->len);
+  g_byte_array_append (data, (guint8 *) header, HEADER_SIZE);
+  g_byte_array_append (data, writer->body->data, writer->body->len);
+  g_byte_array_append (data, (guint8 *) writer->strings->str, writer->strings->len);
+
+  gtk_css_compiled_writer_free (writer);
+
+  return g_byte_array_free_to_bytes (data);
+}
+
+void
+gtk_css_compiled_writer_add_uint32 (GtkCssCompiledWriter *writer,
+                                    guint32               value)
+{
+  g_byte_array_append (writer->body, (guint8 *) &value, sizeof (guint32));
+}
+
+void
+gtk_css_compiled_writer_add_string (GtkCssCompiledWriter *writer,
+                                    const char           *string)
+{
+  gpointer offset;
+
+  if (!g_hash_table_lookup_extended (writer->string_offsets, string, NULL, &offset))
+    {
+      offset = GUINT_TO_POINTER (writer->strings->len);
+      /* includes the terminating NUL */
+      g_string_append_len (writer->strings, string, strlen (string) + 1);
+      g_hash_table_insert (writer->string_offsets, g_strdup (string), offset);
+    }
+
+  gtk_css_compiled_writer_add_uint32 (writer, GPOINTER_TO_UINT (offset));
+}
+
+/**
+ * gtk_css_compiled_reader_new:
+ * @bytes: the contents of a compiled style sheet
+ *
+ * Checks that @bytes contains a style sheet compiled by this version
+ * of GTK and prepares to read its body.
+ *
+ * Returns: a new reader or %NULL if @bytes can't be used
+ **/
+GtkCssCompiledReader *
+gtk_css_compiled_reader_new (GBytes *bytes)
+{
+  GtkCssCompiledReader *reader;
+  guint32 header[N_HEADER_FIELDS];
+  const guint8 *data;
+  gsize size;
+
+  data = g_bytes_get_data (bytes, &size);
+  if (size < HEADER_SIZE)
+    return NULL;
+
+  memcpy (header, data, HEADER_SIZE);
+  if (header[HEADER_MAGIC] != GTK_CSS_COMPILED_MAGIC ||
+      header[HEADER_VERSION] != GTK_CSS_COMPILED_VERSION ||
+      header[HEADER_MAJOR] != GTK_MAJOR_VERSION ||
+      header[HEADER_MINOR] != GTK_MINOR_VERSION ||
+      header[HEADER_MICRO] != GTK_MICRO_VERSION ||
+      header[HEADER_POINTER_SIZE] != sizeof (gpointer) ||
+      header[HEADER_PROPERTIES] != gtk_css_compiled_get_property_signature ())
+    return NULL;
+
+  if (header[HEADER_STRINGS_OFFSET] < HEADER_SIZE ||
+      header[HEADER_STRINGS_OFFSET] > size ||
+      header[HEADER_STRINGS_LENGTH] != size - header[HEADER_STRINGS_OFFSET])
+    return NULL;
+
+  /* All strings must be terminated, so that reading them never runs
+   * past the end of the data */
+  if (header[HEADER_STRINGS_LENGTH] > 0 && data[size - 1] != '\0')
+    return NULL;
+
+  reader = g_slice_new0 (GtkCssCompiledReader);
+  reader->bytes = g_bytes_ref (bytes);
+  reader->body = data + HEADER_SIZE;
+  reader->body_length = header[HEADER_STRINGS_OFFSET] - HEADER_SIZE;
+  reader->strings = (const char *) data + header[HEADER_STRINGS_OFFSET];
+  reader->strings_length = header[HEADER_STRINGS_LENGTH];
+
+  return reader;
+}
+
+void
+gtk_css_compiled_reader_free (GtkCssCompiledReader *reader)
+{
+  g_bytes_unref (reader->bytes);
+
+  g_slice_free (GtkCssCompiledReader, reader);
+}
+
+/* Once a read failed, all further reads fail, too. So callers only need
+ * to check this after reading a whole section. */
+gboolean
+gtk_css_compiled_reader_has_failed (GtkCssCompiledReader *reader)
+{
+  return reader->failed;
+}
+
+guint32
+gtk_css_compiled_reader_read_uint32 (GtkCssCompiledReader *reader)
+{
+  guint32 value;
+
+  if (reader->failed ||
+      reader->body_length - reader->pos < sizeof (guint32))
+    {
+      reader->failed = TRUE;
+      return 0;
+    }
+
+  memcpy (&value, reader->body + reader->pos, sizeof (guint32));
+  reader->pos += sizeof (guint32);
+
+  return value;
+}
+
+/* Reads an index into an array of @n_items */
+guint32
+gtk_css_compiled_reader_read_index (GtkCssCompiledReader *reader,
+                                    guint32               n_items)
+{
+  guint32 index;
+
+  index = gtk_css_compiled_reader_read_uint32 (reader);
+  if (index >= n_items)
+    {
+      reader->failed = TRUE;
+      return 0;
+    }
+
+  return index;
+}
+
+/* Reads the number of items in a list. Each item takes up at least
+ * @item_size bytes, so broken files can't trigger huge allocations. */
+guint32
+gtk_css_compiled_reader_read_count (GtkCssCompiledReader *reader,
+                                    gsize                 item_size)
+{
+  guint32 count;
+
+  count = gtk_css_compiled_reader_read_uint32 (reader);
+  if (item_size > 0 &&
+      count > (reader->body_length - reader->pos) / item_size)
+    {
+      reader->failed = TRUE;
+      return 0;
+    }
+
+  return count;
+}
+
+const char *
+gtk_css_compiled_reader_read_string (GtkCssCompiledReader *reader)
+{
+  guint32 offset;
+
+  offset = gtk_css_compiled_reader_read_index (reader, reader->strings_length);
+  if (reader->failed)
+    return "";
+
+  return reader->strings + offset;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2017 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_CSS_COMPILED_PRIVATE_H__
+#define __GTK_CSS_COMPILED_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A compiled style sheet is looked up next to the CSS file it was
+ * compiled from, by appending this suffix to its name. */
+#define GTK_CSS_COMPILED_SUFFIX ".compiled"
+
+/* Marks a missing index, like a tree node without siblings */
+#define GTK_CSS_COMPILED_NONE G_MAXUINT32
+
+typedef struct _GtkCssCompiledWriter GtkCssCompiledWriter;
+typedef struct _GtkCssCompiledReader GtkCssCompiledReader;
+
+GtkCssCompiledWriter *  gtk_css_compiled_writer_new             (void);
+GBytes *                gtk_css_compiled_writer_free_to_bytes   (GtkCssCompiledWriter   *writer);
+void                    gtk_css_compiled_writer_free            (GtkCssCompiledWriter   *writer);
+
+void                    gtk_css_compiled_writer_add_uint32      (GtkCssCompiledWriter   *writer,
+                                                                 guint32                 value);
+void                    gtk_css_compiled_writer_add_string      (GtkCssCompiledWriter   *writer,
+                                                                 const char             *string);
+
+GtkCssCompiledReader *  gtk_css_compiled_reader_new             (GBytes                 *bytes);
+void                    gtk_css_compiled_reader_free            (GtkCssCompiledReader   *reader);
+
+gboolean                gtk_css_compiled_reader_has_failed      (GtkCssCompiledReader   *reader);
+guint32                 gtk_css_compiled_reader_read_uint32     (GtkCssCompiledReader   *reader);
+guint32                 gtk_css_compiled_reader_read_index      (GtkCssCompiledReader   *reader,
+                                                                 guint32                 n_items);
+guint32                 gtk_css_compiled_reader_read_count      (GtkCssCompiledReader   *reader,
+                                                                 gsize                   item_size);
+const char *            gtk_css_compiled_reader_read_string     (GtkCssCompiledReader   *reader);
+
+G_END_DECLS
+
+#endif /* __GTK_CSS_COMPILED_PRIVATE_H__ */
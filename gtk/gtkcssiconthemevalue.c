@@ -39,13 +39,20 @@ struct _GtkCssValue {
   guint changed_id;
 };
 
+/* Values are computed on multiple threads, and there must only ever be
+ * one value per icon theme */
+G_LOCK_DEFINE_STATIC (icon_theme_value);
+
 static void
 gtk_css_value_icon_theme_disconnect_handler (GtkCssValue *value)
 {
   if (value->changed_id == 0)
     return;
 
-  g_object_set_data (G_OBJECT (value->icontheme), "-gtk-css-value", NULL);
+  G_LOCK (icon_theme_value);
+  if (g_object_get_data (G_OBJECT (value->icontheme), "-gtk-css-value") == value)
+    g_object_set_data (G_OBJECT (value->icontheme), "-gtk-css-value", NULL);
+  G_UNLOCK (icon_theme_value);
 
   g_signal_handler_disconnect (value->icontheme, value->changed_id);
   value->changed_id = 0;
@@ -119,6 +126,23 @@ static const GtkCssValueClass GTK_CSS_VALUE_ICON_THEME = {
 
 static GtkCssValue default_icon_theme_value = { &GTK_CSS_VALUE_ICON_THEME, 1, NULL, 0 };
 
+/* Refs @value unless another thread is about to free it */
+static gboolean
+gtk_css_value_icon_theme_try_ref (GtkCssValue *value)
+{
+  int ref_count;
+
+  do
+    {
+      ref_count = g_atomic_int_get (&value->ref_count);
+      if (ref_count == 0)
+        return FALSE;
+    }
+  while (!g_atomic_int_compare_and_exchange (&value->ref_count, ref_count, ref_count + 1));
+
+  return TRUE;
+}
+
 GtkCssValue *
 gtk_css_icon_theme_value_new (GtkIconTheme *icontheme)
 {
@@ -127,15 +151,19 @@ gtk_css_icon_theme_value_new (GtkIconTheme *icontheme)
   if (icontheme == NULL)
     return _gtk_css_value_ref (&default_icon_theme_value);
 
+  G_LOCK (icon_theme_value);
+
   result = g_object_get_data (G_OBJECT (icontheme), "-gtk-css-value");
-  if (result)
-    return _gtk_css_value_ref (result);
+  if (result == NULL || !gtk_css_value_icon_theme_try_ref (result))
+    {
+      result = _gtk_css_value_new (GtkCssValue, &GTK_CSS_VALUE_ICON_THEME);
+      result->icontheme = g_object_ref (icontheme);
 
-  result = _gtk_css_value_new (GtkCssValue, &GTK_CSS_VALUE_ICON_THEME);
-  result->icontheme = g_object_ref (icontheme);
+      g_object_set_data (G_OBJECT (icontheme), "-gtk-css-value", result);
+      result->changed_id = g_signal_connect (icontheme, "changed", G_CALLBACK (gtk_css_value_icon_theme_changed_cb), result);
+    }
 
-  g_object_set_data (G_OBJECT (icontheme), "-gtk-css-value", result);
-  result->changed_id = g_signal_connect (icontheme, "changed", G_CALLBACK (gtk_css_value_icon_theme_changed_cb), result);
+  G_UNLOCK (icon_theme_value);
 
   return result;
 }
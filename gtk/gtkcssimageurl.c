@@ -28,8 +28,8 @@
 G_DEFINE_TYPE (GtkCssImageUrl, _gtk_css_image_url, GTK_TYPE_CSS_IMAGE)
 
 static GtkCssImage *
-gtk_css_image_url_load_image (GtkCssImageUrl  *url,
-                              GError         **error)
+gtk_css_image_url_load_image_unlocked (GtkCssImageUrl  *url,
+                                       GError         **error)
 {
   GdkPixbuf *pixbuf;
   GError *local_error = NULL;
@@ -89,6 +89,23 @@ gtk_css_image_url_load_image (GtkCssImageUrl  *url,
   return url->loaded_image;
 }
 
+/* Images are loaded when styles are computed, which can happen on
+ * multiple threads at once */
+G_LOCK_DEFINE_STATIC (loaded_image);
+
+static GtkCssImage *
+gtk_css_image_url_load_image (GtkCssImageUrl  *url,
+                              GError         **error)
+{
+  GtkCssImage *image;
+
+  G_LOCK (loaded_image);
+  image = gtk_css_image_url_load_image_unlocked (url, error);
+  G_UNLOCK (loaded_image);
+
+  return image;
+}
+
 static int
 gtk_css_image_url_get_width (GtkCssImage *image)
 {
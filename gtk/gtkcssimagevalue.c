@@ -122,3 +122,10 @@ _gtk_css_image_value_get_image (const GtkCssValue *value)
   return value->image;
 }
 
+gboolean
+_gtk_css_value_is_image (const GtkCssValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  return value->class == &GTK_CSS_VALUE_IMAGE;
+}
@@ -28,6 +28,7 @@ G_BEGIN_DECLS
 GtkCssValue *   _gtk_css_image_value_new           (GtkCssImage         *image);
 
 GtkCssImage *   _gtk_css_image_value_get_image     (const GtkCssValue   *image);
+gboolean        _gtk_css_value_is_image            (const GtkCssValue   *value);
 
 
 G_END_DECLS
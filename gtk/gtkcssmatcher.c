@@ -166,6 +166,7 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_WIDGET_PATH = {
   gtk_css_matcher_widget_path_has_class,
   gtk_css_matcher_widget_path_has_id,
   gtk_css_matcher_widget_path_has_position,
+  NULL,
   FALSE
 };
 
@@ -308,6 +309,12 @@ gtk_css_matcher_node_has_position (const GtkCssMatcher *matcher,
                                          a, b);
 }
 
+static const GtkCssAncestorFilter *
+gtk_css_matcher_node_get_ancestor_filter (const GtkCssMatcher *matcher)
+{
+  return gtk_css_node_peek_ancestor_filter (matcher->node.node);
+}
+
 static const GtkCssMatcherClass GTK_CSS_MATCHER_NODE = {
   gtk_css_matcher_node_get_parent,
   gtk_css_matcher_node_get_previous,
@@ -316,6 +323,7 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_NODE = {
   gtk_css_matcher_node_has_class,
   gtk_css_matcher_node_has_id,
   gtk_css_matcher_node_has_position,
+  gtk_css_matcher_node_get_ancestor_filter,
   FALSE
 };
 
@@ -396,6 +404,7 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_ANY = {
   gtk_css_matcher_any_has_class,
   gtk_css_matcher_any_has_id,
   gtk_css_matcher_any_has_position,
+  NULL,
   TRUE
 };
 
@@ -489,6 +498,7 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_SUPERSET = {
   gtk_css_matcher_superset_has_class,
   gtk_css_matcher_superset_has_id,
   gtk_css_matcher_superset_has_position,
+  NULL,
   FALSE
 };
 
@@ -20,6 +20,7 @@
 
 #include <gtk/gtkenums.h>
 #include <gtk/gtktypes.h>
+#include "gtk/gtkcssancestorfilterprivate.h"
 #include "gtk/gtkcsstypesprivate.h"
 
 G_BEGIN_DECLS
@@ -46,6 +47,8 @@ struct _GtkCssMatcherClass {
                                                    gboolean               forward,
                                                    int                    a,
                                                    int                    b);
+  /* NULL if the ancestors can't be pruned with a filter */
+  const GtkCssAncestorFilter *(* get_ancestor_filter) (const GtkCssMatcher   *matcher);
   gboolean is_any;
 };
 
@@ -136,6 +139,15 @@ _gtk_css_matcher_has_position (const GtkCssMatcher *matcher,
   return matcher->klass->has_position (matcher, forward, a, b);
 }
 
+static inline const GtkCssAncestorFilter *
+_gtk_css_matcher_get_ancestor_filter (const GtkCssMatcher *matcher)
+{
+  if (matcher->klass->get_ancestor_filter == NULL)
+    return NULL;
+
+  return matcher->klass->get_ancestor_filter (matcher);
+}
+
 static inline gboolean
 _gtk_css_matcher_matches_any (const GtkCssMatcher *matcher)
 {
@@ -20,11 +20,15 @@
 #include "gtkcssnodeprivate.h"
 
 #include "gtkcssanimatedstyleprivate.h"
+#include "gtkcsspathnodeprivate.h"
 #include "gtkcsssectionprivate.h"
 #include "gtkcssstylepropertyprivate.h"
+#include "gtkdebug.h"
 #include "gtkintl.h"
 #include "gtkmarshalers.h"
+#include "gtkparallelprivate.h"
 #include "gtksettingsprivate.h"
+#include "gtkstyleproviderprivate.h"
 #include "gtktypebuiltins.h"
 
 /*
@@ -238,6 +242,7 @@ gtk_css_node_dispose (GObject *object)
   gtk_css_node_set_invalid (cssnode, FALSE);
   
   g_clear_pointer (&cssnode->cache, gtk_css_node_style_cache_unref);
+  g_clear_object (&cssnode->precomputed_style);
 
   G_OBJECT_CLASS (gtk_css_node_parent_class)->dispose (object);
 }
@@ -352,13 +357,45 @@ store_in_global_parent_cache (GtkCssNode                  *node,
                                                  style);
 }
 
+/* The sibling cache is keyed on the declarations of all ancestors, as
+ * they can all be matched by selectors. Nodes below a path node are
+ * matched with a widget path instead, so they can't use it. Neither can
+ * very deep nodes. */
+#define MAX_SIBLING_CACHE_DEPTH 64
+
+static guint
+gtk_css_node_get_ancestor_declarations (GtkCssNode                   *cssnode,
+                                        const GtkCssNodeDeclaration **ancestors)
+{
+  GtkCssNode *node;
+  guint n_ancestors;
+
+  if (GTK_IS_CSS_PATH_NODE (cssnode))
+    return 0;
+
+  n_ancestors = 0;
+  for (node = cssnode->parent; node; node = node->parent)
+    {
+      if (n_ancestors == MAX_SIBLING_CACHE_DEPTH ||
+          GTK_IS_CSS_PATH_NODE (node))
+        return 0;
+
+      ancestors[n_ancestors++] = node->decl;
+    }
+
+  return n_ancestors;
+}
+
 static GtkCssStyle *
 gtk_css_node_create_style (GtkCssNode *cssnode)
 {
+  const GtkCssNodeDeclaration *ancestors[MAX_SIBLING_CACHE_DEPTH];
   const GtkCssNodeDeclaration *decl;
+  GtkStyleProviderPrivate *provider;
   GtkCssMatcher matcher;
   GtkCssStyle *parent;
   GtkCssStyle *style;
+  guint n_ancestors;
 
   decl = gtk_css_node_get_declaration (cssnode);
   parent = cssnode->parent ? cssnode->parent->style : NULL;
@@ -367,14 +404,49 @@ gtk_css_node_create_style (GtkCssNode *cssnode)
   if (style)
     return g_object_ref (style);
 
+  provider = gtk_css_node_get_style_provider (cssnode);
+
   if (gtk_css_node_init_matcher (cssnode, &matcher))
-    style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
-                                              &matcher,
-                                              parent);
+    {
+      n_ancestors = parent ? gtk_css_node_get_ancestor_declarations (cssnode, ancestors) : 0;
+
+      if (n_ancestors > 0)
+        {
+          style = gtk_css_node_style_cache_lookup_sibling (provider,
+                                                           parent,
+                                                           decl,
+                                                           gtk_css_node_is_first_child (cssnode),
+                                                           gtk_css_node_is_last_child (cssnode),
+                                                           ancestors,
+                                                           n_ancestors);
+          if (style)
+            {
+              g_object_ref (style);
+              store_in_global_parent_cache (cssnode, decl, style);
+              return style;
+            }
+        }
+
+      if (cssnode->precomputed_style)
+        {
+          style = cssnode->precomputed_style;
+          cssnode->precomputed_style = NULL;
+        }
+      else
+        style = gtk_css_static_style_new_compute (provider, &matcher, parent);
+
+      if (n_ancestors > 0)
+        gtk_css_node_style_cache_insert_sibling (provider,
+                                                 parent,
+                                                 decl,
+                                                 gtk_css_node_is_first_child (cssnode),
+                                                 gtk_css_node_is_last_child (cssnode),
+                                                 ancestors,
+                                                 n_ancestors,
+                                                 style);
+    }
   else
-    style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
-                                              NULL,
-                                              parent);
+    style = gtk_css_static_style_new_compute (provider, NULL, parent);
 
   store_in_global_parent_cache (cssnode, decl, style);
 
@@ -729,6 +801,32 @@ gtk_css_node_invalidate_style (GtkCssNode *cssnode)
     gtk_css_node_invalidate_style (cssnode->next_sibling);
 }
 
+static void
+gtk_css_node_invalidate_ancestor_filter (GtkCssNode *cssnode)
+{
+  GtkCssNode *child;
+
+  /* If this node is invalid, all its children are, too */
+  if (!cssnode->ancestor_filter_valid)
+    return;
+
+  cssnode->ancestor_filter_valid = FALSE;
+
+  for (child = cssnode->first_child; child; child = child->next_sibling)
+    gtk_css_node_invalidate_ancestor_filter (child);
+}
+
+/* Call this when the name, id or classes of @cssnode change, as they
+ * are part of the filters of all its descendants */
+static void
+gtk_css_node_invalidate_child_ancestor_filters (GtkCssNode *cssnode)
+{
+  GtkCssNode *child;
+
+  for (child = cssnode->first_child; child; child = child->next_sibling)
+    gtk_css_node_invalidate_ancestor_filter (child);
+}
+
 static void
 gtk_css_node_reposition (GtkCssNode *node,
                          GtkCssNode *new_parent,
@@ -762,6 +860,8 @@ gtk_css_node_reposition (GtkCssNode *node,
 
   if (old_parent != new_parent)
     {
+      gtk_css_node_invalidate_ancestor_filter (node);
+
       if (old_parent == NULL)
         {
           gtk_css_node_parent_will_be_set (node);
@@ -1004,6 +1104,7 @@ gtk_css_node_ensure_style (GtkCssNode *cssnode,
                                                                   cssnode->pending_changes,
                                                                   current_time,
                                                                   cssnode->style);
+      g_clear_object (&cssnode->precomputed_style);
 
       style_changed = gtk_css_node_set_style (cssnode, new_style);
       g_object_unref (new_style);
@@ -1105,6 +1206,7 @@ gtk_css_node_set_name (GtkCssNode              *cssnode,
 {
   if (gtk_css_node_declaration_set_name (&cssnode->decl, name))
     {
+      gtk_css_node_invalidate_child_ancestor_filters (cssnode);
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_NAME);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_NAME]);
     }
@@ -1139,6 +1241,7 @@ gtk_css_node_set_id (GtkCssNode                *cssnode,
 {
   if (gtk_css_node_declaration_set_id (&cssnode->decl, id))
     {
+      gtk_css_node_invalidate_child_ancestor_filters (cssnode);
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_ID);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_ID]);
     }
@@ -1172,6 +1275,7 @@ gtk_css_node_clear_classes (GtkCssNode *cssnode)
 {
   if (gtk_css_node_declaration_clear_classes (&cssnode->decl))
     {
+      gtk_css_node_invalidate_child_ancestor_filters (cssnode);
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1223,6 +1327,7 @@ gtk_css_node_add_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_add_class (&cssnode->decl, style_class))
     {
+      gtk_css_node_invalidate_child_ancestor_filters (cssnode);
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1234,6 +1339,7 @@ gtk_css_node_remove_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_remove_class (&cssnode->decl, style_class))
     {
+      gtk_css_node_invalidate_child_ancestor_filters (cssnode);
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1259,6 +1365,61 @@ gtk_css_node_get_declaration (GtkCssNode *cssnode)
   return cssnode->decl;
 }
 
+/* Returns a filter of the names, ids and classes of all ancestors of
+ * @cssnode. It is computed when needed and kept until the ancestors
+ * change. */
+const GtkCssAncestorFilter *
+gtk_css_node_get_ancestor_filter (GtkCssNode *cssnode)
+{
+  GtkCssNode *parent;
+
+  if (cssnode->ancestor_filter_valid)
+    return &cssnode->ancestor_filter;
+
+  parent = cssnode->parent;
+  if (parent == NULL)
+    {
+      gtk_css_ancestor_filter_init (&cssnode->ancestor_filter);
+    }
+  else if (GTK_IS_CSS_PATH_NODE (parent))
+    {
+      /* Path nodes match their ancestors with the widget path, not
+       * with nodes, so nothing can be pruned */
+      gtk_css_ancestor_filter_init_full (&cssnode->ancestor_filter);
+    }
+  else
+    {
+      const GQuark *classes;
+      guint i, n_classes;
+
+      cssnode->ancestor_filter = *gtk_css_node_get_ancestor_filter (parent);
+
+      gtk_css_ancestor_filter_add_name (&cssnode->ancestor_filter, gtk_css_node_get_name (parent));
+      gtk_css_ancestor_filter_add_id (&cssnode->ancestor_filter, gtk_css_node_get_id (parent));
+      classes = gtk_css_node_list_classes (parent, &n_classes);
+      for (i = 0; i < n_classes; i++)
+        gtk_css_ancestor_filter_add_class (&cssnode->ancestor_filter, classes[i]);
+    }
+
+  cssnode->ancestor_filter_valid = TRUE;
+
+  return &cssnode->ancestor_filter;
+}
+
+/* Like gtk_css_node_get_ancestor_filter(), but returns %NULL instead of
+ * computing the filter. Matching uses this, because it can run on worker
+ * threads, which must not update nodes. Selectors like "a + b c" can
+ * reach nodes whose filter wasn't needed yet, those are just matched
+ * without pruning. */
+const GtkCssAncestorFilter *
+gtk_css_node_peek_ancestor_filter (GtkCssNode *cssnode)
+{
+  if (!cssnode->ancestor_filter_valid)
+    return NULL;
+
+  return &cssnode->ancestor_filter;
+}
+
 void
 gtk_css_node_invalidate_style_provider (GtkCssNode *cssnode)
 {
@@ -1317,6 +1478,7 @@ gtk_css_node_invalidate (GtkCssNode   *cssnode,
     return;
 
   cssnode->pending_changes |= change;
+  g_clear_object (&cssnode->precomputed_style);
 
   GTK_CSS_NODE_GET_CLASS (cssnode)->invalidate (cssnode);
 
@@ -1325,6 +1487,199 @@ gtk_css_node_invalidate (GtkCssNode   *cssnode,
   gtk_css_node_invalidate_style (cssnode);
 }
 
+/* PARALLEL VALIDATION
+ *
+ * Once the style of a node is known, the styles of its children can be
+ * computed independently. So if many children need new styles, they are
+ * computed on worker threads first, and validating the children picks
+ * them up. Everything else, like animations and emitting signals, still
+ * happens on the main thread.
+ *
+ * Children with the same declaration and position will most likely end
+ * up with the same style and find it in the parent's cache. So only one
+ * of them is computed ahead, unless its style depends on its siblings or
+ * its position.
+ *
+ * Any invalidation of a child drops its precomputed style, so a style
+ * that doesn't match the tree anymore is never used.
+ *
+ * Errors while computing, like images that fail to load, are collected
+ * in the job and emitted on the main thread once the jobs are done.
+ */
+
+#define MIN_PARALLEL_STYLES 16
+
+typedef struct _GtkCssStyleJob GtkCssStyleJob;
+
+struct _GtkCssStyleJob {
+  GtkCssNode              *node;
+  const GtkCssNodeDeclaration *decl;
+  GtkStyleProviderPrivate *provider;
+  gboolean                 is_first;
+  gboolean                 is_last;
+  GtkCssMatcher            matcher;
+  GtkCssStyle             *parent_style;
+  GtkCssStyle             *result;
+  GPtrArray               *errors;
+};
+
+static guint
+gtk_css_style_job_hash (gconstpointer item)
+{
+  const GtkCssStyleJob *job = item;
+
+  return g_direct_hash (job->provider)
+         ^ (gtk_css_node_declaration_hash (job->decl) << 2 | (job->is_first ? 0x2 : 0) | (job->is_last ? 0x1 : 0));
+}
+
+static gboolean
+gtk_css_style_job_equal (gconstpointer item1,
+                         gconstpointer item2)
+{
+  const GtkCssStyleJob *job1 = item1;
+  const GtkCssStyleJob *job2 = item2;
+
+  return job1->provider == job2->provider &&
+         job1->is_first == job2->is_first &&
+         job1->is_last == job2->is_last &&
+         gtk_css_node_declaration_equal (job1->decl, job2->decl);
+}
+
+/* Runs on worker threads */
+static void
+gtk_css_style_jobs_run (guint    start,
+                        guint    end,
+                        gpointer data)
+{
+  GtkCssStyleJob *jobs = data;
+  guint i;
+
+  for (i = start; i < end; i++)
+    {
+      _gtk_style_provider_private_defer_errors (&jobs[i].errors);
+      jobs[i].result = gtk_css_static_style_new_compute (jobs[i].provider,
+                                                         &jobs[i].matcher,
+                                                         jobs[i].parent_style);
+      _gtk_style_provider_private_defer_errors (NULL);
+    }
+}
+
+static gboolean
+gtk_css_node_init_style_job (GtkCssNode     *cssnode,
+                             GtkCssStyleJob *job)
+{
+  job->node = cssnode;
+  job->decl = cssnode->decl;
+  job->provider = gtk_css_node_get_style_provider (cssnode);
+  job->is_first = gtk_css_node_is_first_child (cssnode);
+  job->is_last = gtk_css_node_is_last_child (cssnode);
+  job->parent_style = cssnode->parent->style;
+  job->result = NULL;
+  job->errors = NULL;
+
+  return gtk_css_node_init_matcher (cssnode, &job->matcher);
+}
+
+static void
+gtk_css_style_jobs_finish (GtkCssStyleJob *jobs,
+                           guint           n_jobs)
+{
+  guint i;
+
+  gtk_parallel_for (n_jobs, 1, gtk_css_style_jobs_run, jobs);
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      jobs[i].node->precomputed_style = jobs[i].result;
+      _gtk_style_provider_private_emit_deferred_errors (jobs[i].errors);
+      jobs[i].errors = NULL;
+    }
+}
+
+static gboolean
+gtk_css_node_needs_precomputed_style (GtkCssNode *cssnode)
+{
+  if (!cssnode->visible ||
+      !cssnode->style_is_invalid ||
+      cssnode->precomputed_style != NULL ||
+      GTK_IS_CSS_PATH_NODE (cssnode))
+    return FALSE;
+
+  return gtk_css_style_needs_recreation (cssnode->style, cssnode->pending_changes);
+}
+
+static void
+gtk_css_node_precompute_child_styles (GtkCssNode *cssnode)
+{
+  GtkCssStyleJob *jobs, *duplicates;
+  GHashTable *computed;
+  GtkCssNode *child;
+  guint n_children, n_jobs, n_duplicates, i;
+
+  if (GTK_DEBUG_CHECK (NO_CSS_THREADS) ||
+      gtk_parallel_get_n_threads () <= 1)
+    return;
+
+  n_children = 0;
+  for (child = cssnode->first_child; child; child = child->next_sibling)
+    {
+      if (gtk_css_node_needs_precomputed_style (child))
+        n_children++;
+    }
+
+  if (n_children < MIN_PARALLEL_STYLES)
+    return;
+
+  jobs = g_new (GtkCssStyleJob, n_children);
+  duplicates = g_new (GtkCssStyleJob, n_children);
+  computed = g_hash_table_new (gtk_css_style_job_hash, gtk_css_style_job_equal);
+  n_jobs = 0;
+  n_duplicates = 0;
+
+  for (child = cssnode->first_child; child; child = child->next_sibling)
+    {
+      GtkCssStyleJob *job;
+
+      if (!child->visible)
+        continue;
+
+      if (!gtk_css_node_needs_precomputed_style (child))
+        continue;
+
+      job = &jobs[n_jobs];
+      if (!gtk_css_node_init_style_job (child, job))
+        continue;
+
+      if (g_hash_table_contains (computed, job))
+        duplicates[n_duplicates++] = *job;
+      else
+        {
+          g_hash_table_add (computed, job);
+          n_jobs++;
+        }
+    }
+
+  gtk_css_style_jobs_finish (jobs, n_jobs);
+
+  /* Duplicates will find the style of the first node in the parent's
+   * cache, unless it can't be shared */
+  n_jobs = 0;
+  for (i = 0; i < n_duplicates; i++)
+    {
+      GtkCssStyleJob *first = g_hash_table_lookup (computed, &duplicates[i]);
+      GtkCssChange change = gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (first->result));
+
+      if (change & (GTK_CSS_CHANGE_ANY_SIBLING | GTK_CSS_CHANGE_NTH_CHILD | GTK_CSS_CHANGE_NTH_LAST_CHILD))
+        jobs[n_jobs++] = duplicates[i];
+    }
+
+  gtk_css_style_jobs_finish (jobs, n_jobs);
+
+  g_hash_table_unref (computed);
+  g_free (duplicates);
+  g_free (jobs);
+}
+
 static void
 gtk_css_node_validate_internal (GtkCssNode *cssnode,
                                 gint64      timestamp)
@@ -1343,6 +1698,8 @@ gtk_css_node_validate_internal (GtkCssNode *cssnode,
 
   GTK_CSS_NODE_GET_CLASS (cssnode)->validate (cssnode);
 
+  gtk_css_node_precompute_child_styles (cssnode);
+
   for (child = gtk_css_node_get_first_child (cssnode);
        child;
        child = gtk_css_node_get_next_sibling (child))
@@ -1366,6 +1723,10 @@ gboolean
 gtk_css_node_init_matcher (GtkCssNode     *cssnode,
                            GtkCssMatcher  *matcher)
 {
+  /* Matchers may be used on worker threads, which only look at filters
+   * that exist already, so make sure the one of @cssnode does */
+  gtk_css_node_get_ancestor_filter (cssnode);
+
   return GTK_CSS_NODE_GET_CLASS (cssnode)->init_matcher (cssnode, matcher);
 }
 
@@ -18,6 +18,7 @@
 #ifndef __GTK_CSS_NODE_PRIVATE_H__
 #define __GTK_CSS_NODE_PRIVATE_H__
 
+#include "gtkcssancestorfilterprivate.h"
 #include "gtkcssnodedeclarationprivate.h"
 #include "gtkcssnodestylecacheprivate.h"
 #include "gtkcssstylechangeprivate.h"
@@ -48,9 +49,12 @@ struct _GtkCssNode
   GtkCssNodeDeclaration *decl;
   GtkCssStyle           *style;
   GtkCssNodeStyleCache  *cache;                 /* cache for children to look up styles */
+  GtkCssStyle           *precomputed_style;     /* static style computed on a worker thread, or NULL */
 
   GtkCssChange           pending_changes;       /* changes that accumulated since the style was last computed */
 
+  GtkCssAncestorFilter   ancestor_filter;       /* names, ids and classes of all ancestors */
+
   guint                  visible :1;            /* node will be skipped when validating or computing styles */
   guint                  invalid :1;            /* node or a child needs to be validated (even if just for animation) */
   guint                  needs_propagation :1;  /* children have state changes that need to be propagated to their siblings */
@@ -60,6 +64,9 @@ struct _GtkCssNode
    * So if a valid style is computed, one has to previously ensure that the parent's and the previous sibling's style
    * are valid. This allows both validation and invalidation to run in O(nodes-in-tree) */
   guint                  style_is_invalid :1;   /* the style needs to be recomputed */
+  /* ancestor_filter_valid == TRUE  =>  parent->ancestor_filter_valid == TRUE
+   * So invalidating can stop at nodes that are already invalid. */
+  guint                  ancestor_filter_valid :1; /* ancestor_filter is up to date */
 };
 
 struct _GtkCssNodeClass
@@ -143,6 +150,10 @@ const GQuark *          gtk_css_node_list_classes       (GtkCssNode            *
 
 const GtkCssNodeDeclaration *
                         gtk_css_node_get_declaration    (GtkCssNode            *cssnode);
+const GtkCssAncestorFilter *
+                        gtk_css_node_get_ancestor_filter (GtkCssNode           *cssnode);
+const GtkCssAncestorFilter *
+                        gtk_css_node_peek_ancestor_filter (GtkCssNode          *cssnode);
 GtkCssStyle *           gtk_css_node_get_style          (GtkCssNode            *cssnode);
 
 
@@ -28,6 +28,8 @@ struct _GtkCssNodeStyleCache {
   GHashTable  *children;
 };
 
+static guint64 parent_cache_hits;
+
 #define UNPACK_DECLARATION(packed) ((GtkCssNodeDeclaration *) (GPOINTER_TO_SIZE (packed) & ~0x3))
 #define UNPACK_FLAGS(packed) (GPOINTER_TO_SIZE (packed) & 0x3)
 #define PACK(decl, first_child, last_child) GSIZE_TO_POINTER (GPOINTER_TO_SIZE (decl) | ((first_child) ? 0x2 : 0) | ((last_child) ? 0x1 : 0))
@@ -177,6 +179,274 @@ gtk_css_node_style_cache_lookup (GtkCssNodeStyleCache        *parent,
   if (result == NULL)
     return NULL;
 
+  parent_cache_hits++;
+
   return gtk_css_node_style_cache_ref (result);
 }
 
+
+/* SIBLING CACHE */
+
+/* The cache above only helps children of the same parent, or of parents
+ * that got their style from the same cache. Nodes in different
+ * containers, like the labels in the rows of a long list, don't share
+ * that. So styles are also kept in a global cache, keyed on everything a
+ * style can depend on: the provider, the parent style, the node's
+ * declaration and position and the declarations of all its ancestors.
+ *
+ * Styles that depend on siblings or on the position of ancestors are not
+ * stored, as that isn't part of the key. The cache is emptied whenever a
+ * style provider changes. */
+
+#define SIBLING_CACHE_SIZE 1024
+
+typedef struct _GtkCssNodeSiblingCacheEntry GtkCssNodeSiblingCacheEntry;
+
+struct _GtkCssNodeSiblingCacheEntry {
+  GtkStyleProviderPrivate      *provider;
+  GtkCssStyle                  *parent_style;
+  const GtkCssNodeDeclaration  *decl;
+  const GtkCssNodeDeclaration **ancestors;
+  guint                         n_ancestors;
+  guint                         is_first :1;
+  guint                         is_last :1;
+  guint                         hash;
+
+  GtkCssStyle                  *style;
+  GList                         link;           /* in sibling_cache_lru */
+};
+
+static GHashTable *sibling_cache;
+static GQueue sibling_cache_lru = G_QUEUE_INIT;
+static guint sibling_cache_generation;
+static guint64 sibling_cache_hits;
+static guint64 sibling_cache_misses;
+
+static guint
+gtk_css_node_sibling_cache_entry_hash (gconstpointer item)
+{
+  const GtkCssNodeSiblingCacheEntry *entry = item;
+
+  return entry->hash;
+}
+
+static gboolean
+gtk_css_node_sibling_cache_entry_equal (gconstpointer item1,
+                                        gconstpointer item2)
+{
+  const GtkCssNodeSiblingCacheEntry *entry1 = item1;
+  const GtkCssNodeSiblingCacheEntry *entry2 = item2;
+  guint i;
+
+  if (entry1->hash != entry2->hash ||
+      entry1->provider != entry2->provider ||
+      entry1->parent_style != entry2->parent_style ||
+      entry1->is_first != entry2->is_first ||
+      entry1->is_last != entry2->is_last ||
+      entry1->n_ancestors != entry2->n_ancestors)
+    return FALSE;
+
+  if (!gtk_css_node_declaration_equal (entry1->decl, entry2->decl))
+    return FALSE;
+
+  for (i = 0; i < entry1->n_ancestors; i++)
+    {
+      if (!gtk_css_node_declaration_equal (entry1->ancestors[i], entry2->ancestors[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_css_node_sibling_cache_entry_free (gpointer item)
+{
+  GtkCssNodeSiblingCacheEntry *entry = item;
+  guint i;
+
+  g_object_unref (entry->provider);
+  g_object_unref (entry->parent_style);
+  gtk_css_node_declaration_unref ((GtkCssNodeDeclaration *) entry->decl);
+  for (i = 0; i < entry->n_ancestors; i++)
+    gtk_css_node_declaration_unref ((GtkCssNodeDeclaration *) entry->ancestors[i]);
+  g_free (entry->ancestors);
+  g_object_unref (entry->style);
+
+  g_slice_free (GtkCssNodeSiblingCacheEntry, entry);
+}
+
+static void
+gtk_css_node_sibling_cache_entry_init_key (GtkCssNodeSiblingCacheEntry  *entry,
+                                           GtkStyleProviderPrivate      *provider,
+                                           GtkCssStyle                  *parent_style,
+                                           const GtkCssNodeDeclaration  *decl,
+                                           gboolean                      is_first,
+                                           gboolean                      is_last,
+                                           const GtkCssNodeDeclaration **ancestors,
+                                           guint                         n_ancestors)
+{
+  guint i;
+
+  entry->provider = provider;
+  entry->parent_style = parent_style;
+  entry->decl = decl;
+  entry->ancestors = ancestors;
+  entry->n_ancestors = n_ancestors;
+  entry->is_first = is_first;
+  entry->is_last = is_last;
+
+  entry->hash = g_direct_hash (provider) ^ g_direct_hash (parent_style);
+  entry->hash = entry->hash * 31 + (gtk_css_node_declaration_hash (decl) << 2
+                                    | (is_first ? 0x2 : 0) | (is_last ? 0x1 : 0));
+  for (i = 0; i < n_ancestors; i++)
+    entry->hash = entry->hash * 31 + gtk_css_node_declaration_hash (ancestors[i]);
+}
+
+/* Empties the cache when a provider changed, because the styles in it
+ * may be out of date */
+static void
+gtk_css_node_sibling_cache_check_generation (void)
+{
+  if (sibling_cache == NULL)
+    {
+      sibling_cache = g_hash_table_new_full (gtk_css_node_sibling_cache_entry_hash,
+                                             gtk_css_node_sibling_cache_entry_equal,
+                                             gtk_css_node_sibling_cache_entry_free,
+                                             NULL);
+      sibling_cache_generation = _gtk_style_provider_private_get_generation ();
+    }
+  else if (sibling_cache_generation != _gtk_style_provider_private_get_generation ())
+    {
+      /* The links are part of the entries, so they must not be freed */
+      g_queue_init (&sibling_cache_lru);
+      g_hash_table_remove_all (sibling_cache);
+      sibling_cache_generation = _gtk_style_provider_private_get_generation ();
+    }
+}
+
+static gboolean
+may_be_stored_in_sibling_cache (GtkCssStyle *style)
+{
+  GtkCssChange change;
+
+  if (!may_be_stored_in_cache (style))
+    return FALSE;
+
+  change = gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (style));
+
+  /* Only the declarations of the ancestors are part of the key, not
+   * where they are or what's next to them */
+  if (change & (GTK_CSS_CHANGE_PARENT_POSITION |
+                GTK_CSS_CHANGE_PARENT_SIBLING_CLASS |
+                GTK_CSS_CHANGE_PARENT_SIBLING_ID |
+                GTK_CSS_CHANGE_PARENT_SIBLING_NAME |
+                GTK_CSS_CHANGE_PARENT_SIBLING_POSITION |
+                GTK_CSS_CHANGE_PARENT_SIBLING_STATE))
+    return FALSE;
+
+  return TRUE;
+}
+
+/**
+ * gtk_css_node_style_cache_lookup_sibling:
+ * @provider: the style provider of the node
+ * @parent_style: the style of the node's parent
+ * @decl: the declaration of the node
+ * @is_first: if the node is the first child
+ * @is_last: if the node is the last child
+ * @ancestors: the declarations of all ancestors, starting with the parent
+ * @n_ancestors: number of @ancestors
+ *
+ * Looks for a style that was computed for a node in the same situation.
+ *
+ * Returns: (nullable) (transfer none): the style or %NULL
+ **/
+GtkCssStyle *
+gtk_css_node_style_cache_lookup_sibling (GtkStyleProviderPrivate      *provider,
+                                         GtkCssStyle                  *parent_style,
+                                         const GtkCssNodeDeclaration  *decl,
+                                         gboolean                      is_first,
+                                         gboolean                      is_last,
+                                         const GtkCssNodeDeclaration **ancestors,
+                                         guint                         n_ancestors)
+{
+  GtkCssNodeSiblingCacheEntry key, *entry;
+
+  gtk_css_node_sibling_cache_check_generation ();
+
+  gtk_css_node_sibling_cache_entry_init_key (&key, provider, parent_style, decl,
+                                             is_first, is_last, ancestors, n_ancestors);
+
+  entry = g_hash_table_lookup (sibling_cache, &key);
+  if (entry == NULL)
+    {
+      sibling_cache_misses++;
+      return NULL;
+    }
+
+  sibling_cache_hits++;
+
+  g_queue_unlink (&sibling_cache_lru, &entry->link);
+  g_queue_push_head_link (&sibling_cache_lru, &entry->link);
+
+  return entry->style;
+}
+
+void
+gtk_css_node_style_cache_insert_sibling (GtkStyleProviderPrivate      *provider,
+                                         GtkCssStyle                  *parent_style,
+                                         const GtkCssNodeDeclaration  *decl,
+                                         gboolean                      is_first,
+                                         gboolean                      is_last,
+                                         const GtkCssNodeDeclaration **ancestors,
+                                         guint                         n_ancestors,
+                                         GtkCssStyle                  *style)
+{
+  GtkCssNodeSiblingCacheEntry *entry;
+  guint i;
+
+  if (!may_be_stored_in_sibling_cache (style))
+    return;
+
+  gtk_css_node_sibling_cache_check_generation ();
+
+  entry = g_slice_new0 (GtkCssNodeSiblingCacheEntry);
+  gtk_css_node_sibling_cache_entry_init_key (entry,
+                                             g_object_ref (provider),
+                                             g_object_ref (parent_style),
+                                             gtk_css_node_declaration_ref ((GtkCssNodeDeclaration *) decl),
+                                             is_first,
+                                             is_last,
+                                             g_new (const GtkCssNodeDeclaration *, MAX (n_ancestors, 1)),
+                                             n_ancestors);
+  for (i = 0; i < n_ancestors; i++)
+    entry->ancestors[i] = gtk_css_node_declaration_ref ((GtkCssNodeDeclaration *) ancestors[i]);
+  entry->style = g_object_ref (style);
+  entry->link.data = entry;
+
+  if (g_hash_table_contains (sibling_cache, entry))
+    {
+      gtk_css_node_sibling_cache_entry_free (entry);
+      return;
+    }
+
+  if (sibling_cache_lru.length >= SIBLING_CACHE_SIZE)
+    {
+      GList *oldest = g_queue_pop_tail_link (&sibling_cache_lru);
+
+      g_hash_table_remove (sibling_cache, oldest->data);
+    }
+
+  g_hash_table_add (sibling_cache, entry);
+  g_queue_push_head_link (&sibling_cache_lru, &entry->link);
+}
+
+void
+gtk_css_node_style_cache_get_stats (GtkCssNodeStyleCacheStats *stats)
+{
+  stats->parent_hits = parent_cache_hits;
+  stats->sibling_hits = sibling_cache_hits;
+  stats->sibling_misses = sibling_cache_misses;
+  stats->n_sibling_entries = sibling_cache_lru.length;
+  stats->max_sibling_entries = SIBLING_CACHE_SIZE;
+}
@@ -20,10 +20,20 @@
 
 #include "gtkcssnodedeclarationprivate.h"
 #include "gtkcssstyleprivate.h"
+#include "gtkstyleproviderprivate.h"
 
 G_BEGIN_DECLS
 
 typedef struct _GtkCssNodeStyleCache GtkCssNodeStyleCache;
+typedef struct _GtkCssNodeStyleCacheStats GtkCssNodeStyleCacheStats;
+
+struct _GtkCssNodeStyleCacheStats {
+  guint64 parent_hits;          /* styles found in the cache of the parent */
+  guint64 sibling_hits;         /* styles found in the sibling cache */
+  guint64 sibling_misses;       /* styles that had to be computed */
+  guint   n_sibling_entries;
+  guint   max_sibling_entries;
+};
 
 GtkCssNodeStyleCache *  gtk_css_node_style_cache_new            (GtkCssStyle            *style);
 GtkCssNodeStyleCache *  gtk_css_node_style_cache_ref            (GtkCssNodeStyleCache   *cache);
@@ -41,6 +51,24 @@ GtkCssNodeStyleCache *  gtk_css_node_style_cache_lookup         (GtkCssNodeStyle
                                                                  gboolean                     is_first,
                                                                  gboolean                     is_last);
 
+GtkCssStyle *           gtk_css_node_style_cache_lookup_sibling (GtkStyleProviderPrivate      *provider,
+                                                                 GtkCssStyle                  *parent_style,
+                                                                 const GtkCssNodeDeclaration  *decl,
+                                                                 gboolean                      is_first,
+                                                                 gboolean                      is_last,
+                                                                 const GtkCssNodeDeclaration **ancestors,
+                                                                 guint                         n_ancestors);
+void                    gtk_css_node_style_cache_insert_sibling (GtkStyleProviderPrivate      *provider,
+                                                                 GtkCssStyle                  *parent_style,
+                                                                 const GtkCssNodeDeclaration  *decl,
+                                                                 gboolean                      is_first,
+                                                                 gboolean                      is_last,
+                                                                 const GtkCssNodeDeclaration **ancestors,
+                                                                 guint                         n_ancestors,
+                                                                 GtkCssStyle                  *style);
+
+void                    gtk_css_node_style_cache_get_stats      (GtkCssNodeStyleCacheStats    *stats);
+
 G_END_DECLS
 
 #endif /* __GTK_CSS_NODE_STYLE_CACHE_PRIVATE_H__ */
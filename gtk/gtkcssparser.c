@@ -124,6 +124,16 @@ _gtk_css_parser_get_position (GtkCssParser *parser)
   return parser->data - parser->line_start;
 }
 
+/* Returns the text that has not been parsed yet. GtkCssProvider uses
+ * this to record the text of values when compiling style sheets. */
+const char *
+_gtk_css_parser_get_data (GtkCssParser *parser)
+{
+  g_return_val_if_fail (GTK_IS_CSS_PARSER (parser), NULL);
+
+  return parser->data;
+}
+
 static GFile *
 gtk_css_parser_get_base_file (GtkCssParser *parser)
 {
@@ -47,6 +47,7 @@ void            _gtk_css_parser_error_full        (GtkCssParser          *parser
 
 guint           _gtk_css_parser_get_line          (GtkCssParser          *parser);
 guint           _gtk_css_parser_get_position      (GtkCssParser          *parser);
+const char *    _gtk_css_parser_get_data          (GtkCssParser          *parser);
 GFile *         _gtk_css_parser_get_file          (GtkCssParser          *parser);
 GFile *         _gtk_css_parser_get_file_for_path (GtkCssParser          *parser,
                                                    const char            *path);
@@ -28,6 +28,7 @@
 #include "gtkbitmaskprivate.h"
 #include "gtkcssarrayvalueprivate.h"
 #include "gtkcsscolorvalueprivate.h"
+#include "gtkcsscompiledprivate.h"
 #include "gtkcsskeyframesprivate.h"
 #include "gtkcssparserprivate.h"
 #include "gtkcsssectionprivate.h"
@@ -81,6 +82,9 @@
 typedef struct GtkCssRuleset GtkCssRuleset;
 typedef struct _GtkCssScanner GtkCssScanner;
 typedef struct _PropertyValue PropertyValue;
+typedef struct _GtkCssCompileState GtkCssCompileState;
+typedef struct _RecordedText RecordedText;
+typedef struct _RecordedValue RecordedValue;
 typedef enum ParserScope ParserScope;
 typedef enum ParserSymbol ParserSymbol;
 
@@ -109,6 +113,40 @@ struct _GtkCssScanner
   GSList *state;
 };
 
+/* Text of a declaration, color or keyframes as it was parsed, so it can
+ * be parsed again when loading a compiled style sheet */
+struct _RecordedText
+{
+  GtkStyleProperty *property;   /* only for declarations */
+  guint source;
+  char *text;
+};
+
+/* Which declaration the value of a property was parsed from. For
+ * shorthands, @sub is the index of the value in the shorthand, otherwise
+ * it is GTK_CSS_COMPILED_NONE. */
+struct _RecordedValue
+{
+  GtkCssStyleProperty *property;
+  GtkCssValue *value;
+  guint declaration;
+  guint sub;
+};
+
+/* What gtk_css_provider_compile() records while parsing, in addition to
+ * the rulesets of the provider */
+struct _GtkCssCompileState
+{
+  GPtrArray *sources;           /* GFile, in the order they were loaded */
+  GPtrArray *checksums;         /* char *, checksum of each source */
+  GHashTable *colors;           /* name => RecordedText */
+  GHashTable *keyframes;        /* name => RecordedText */
+  GPtrArray *declarations;      /* RecordedText */
+  GHashTable *declaration_ids;  /* "name source text" => index + 1 */
+  GHashTable *values;           /* set of RecordedValue */
+  GPtrArray *bindings;          /* binding set name and entry, in turns */
+};
+
 struct _GtkCssProviderPrivate
 {
   GScanner *scanner;
@@ -120,6 +158,9 @@ struct _GtkCssProviderPrivate
   GtkCssSelectorTree *tree;
   GResource *resource;
   gchar *path;
+
+  GtkCssCompileState *compile;
+  guint loaded_compiled : 1;
 };
 
 enum {
@@ -762,13 +803,31 @@ css_provider_commit (GtkCssProvider *css_provider,
 }
 
 static void
-gtk_css_provider_reset (GtkCssProvider *css_provider)
+gtk_css_provider_clear (GtkCssProvider *css_provider)
 {
   GtkCssProviderPrivate *priv;
   guint i;
 
   priv = css_provider->priv;
 
+  g_hash_table_remove_all (priv->symbolic_colors);
+  g_hash_table_remove_all (priv->keyframes);
+
+  for (i = 0; i < priv->rulesets->len; i++)
+    gtk_css_ruleset_clear (&g_array_index (priv->rulesets, GtkCssRuleset, i));
+  g_array_set_size (priv->rulesets, 0);
+  _gtk_css_selector_tree_free (priv->tree);
+  priv->tree = NULL;
+  priv->loaded_compiled = FALSE;
+}
+
+static void
+gtk_css_provider_reset (GtkCssProvider *css_provider)
+{
+  GtkCssProviderPrivate *priv;
+
+  priv = css_provider->priv;
+
   if (priv->resource)
     {
       g_resources_unregister (priv->resource);
@@ -782,15 +841,199 @@ gtk_css_provider_reset (GtkCssProvider *css_provider)
       priv->path = NULL;
     }
 
-  g_hash_table_remove_all (priv->symbolic_colors);
-  g_hash_table_remove_all (priv->keyframes);
+  gtk_css_provider_clear (css_provider);
+}
 
-  for (i = 0; i < priv->rulesets->len; i++)
-    gtk_css_ruleset_clear (&g_array_index (priv->rulesets, GtkCssRuleset, i));
-  g_array_set_size (priv->rulesets, 0);
-  _gtk_css_selector_tree_free (priv->tree);
-  priv->tree = NULL;
+static void
+recorded_text_free (gpointer data)
+{
+  RecordedText *recorded = data;
+
+  g_free (recorded->text);
+  g_slice_free (RecordedText, recorded);
+}
+
+static guint
+recorded_value_hash (gconstpointer data)
+{
+  const RecordedValue *recorded = data;
 
+  return g_direct_hash (recorded->property) ^ g_direct_hash (recorded->value);
+}
+
+static gboolean
+recorded_value_equal (gconstpointer a,
+                      gconstpointer b)
+{
+  const RecordedValue *recorded_a = a;
+  const RecordedValue *recorded_b = b;
+
+  return recorded_a->property == recorded_b->property &&
+         recorded_a->value == recorded_b->value;
+}
+
+static void
+recorded_value_free (gpointer data)
+{
+  RecordedValue *recorded = data;
+
+  _gtk_css_value_unref (recorded->value);
+  g_slice_free (RecordedValue, recorded);
+}
+
+static GtkCssCompileState *
+gtk_css_compile_state_new (void)
+{
+  GtkCssCompileState *compile;
+
+  compile = g_slice_new (GtkCssCompileState);
+  compile->sources = g_ptr_array_new_with_free_func (g_object_unref);
+  compile->checksums = g_ptr_array_new_with_free_func (g_free);
+  compile->colors = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, recorded_text_free);
+  compile->keyframes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, recorded_text_free);
+  compile->declarations = g_ptr_array_new_with_free_func (recorded_text_free);
+  compile->declaration_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  compile->values = g_hash_table_new_full (recorded_value_hash, recorded_value_equal,
+                                           recorded_value_free, NULL);
+  compile->bindings = g_ptr_array_new_with_free_func (g_free);
+
+  return compile;
+}
+
+static void
+gtk_css_compile_state_free (GtkCssCompileState *compile)
+{
+  g_ptr_array_unref (compile->sources);
+  g_ptr_array_unref (compile->checksums);
+  g_hash_table_unref (compile->colors);
+  g_hash_table_unref (compile->keyframes);
+  g_ptr_array_unref (compile->declarations);
+  g_hash_table_unref (compile->declaration_ids);
+  g_hash_table_unref (compile->values);
+  g_ptr_array_unref (compile->bindings);
+
+  g_slice_free (GtkCssCompileState, compile);
+}
+
+static void
+gtk_css_compile_state_add_source (GtkCssCompileState *compile,
+                                  GFile              *file,
+                                  const char         *text)
+{
+  g_ptr_array_add (compile->sources, g_object_ref (file));
+  g_ptr_array_add (compile->checksums, g_compute_checksum_for_string (G_CHECKSUM_SHA256, text, -1));
+}
+
+static guint
+gtk_css_compile_state_find_source (GtkCssCompileState *compile,
+                                   GtkCssScanner      *scanner)
+{
+  GFile *file;
+  guint i;
+
+  file = _gtk_css_parser_get_file (scanner->parser);
+
+  for (i = 0; i < compile->sources->len; i++)
+    {
+      if (g_file_equal (g_ptr_array_index (compile->sources, i), file))
+        return i;
+    }
+
+  g_assert_not_reached ();
+  return 0;
+}
+
+static RecordedText *
+gtk_css_compile_state_record_text (GtkCssCompileState *compile,
+                                   GtkCssScanner      *scanner,
+                                   GtkStyleProperty   *property,
+                                   const char         *start,
+                                   const char         *end)
+{
+  RecordedText *recorded;
+
+  recorded = g_slice_new (RecordedText);
+  recorded->property = property;
+  recorded->source = gtk_css_compile_state_find_source (compile, scanner);
+  recorded->text = g_strndup (start, end - start);
+  g_strstrip (recorded->text);
+
+  return recorded;
+}
+
+static void
+gtk_css_compile_state_add_value (GtkCssCompileState  *compile,
+                                 GtkCssStyleProperty *property,
+                                 GtkCssValue         *value,
+                                 guint                declaration,
+                                 guint                sub)
+{
+  RecordedValue key = { property, value, };
+  RecordedValue *recorded;
+
+  /* The same value may be returned by different declarations, for
+   * example for "initial". Any of them gives back an equal value. */
+  if (g_hash_table_contains (compile->values, &key))
+    return;
+
+  recorded = g_slice_new (RecordedValue);
+  recorded->property = property;
+  /* Keep the value alive, so its address is not reused */
+  recorded->value = _gtk_css_value_ref (value);
+  recorded->declaration = declaration;
+  recorded->sub = sub;
+
+  g_hash_table_add (compile->values, recorded);
+}
+
+static void
+gtk_css_compile_state_add_declaration (GtkCssCompileState *compile,
+                                       GtkCssScanner      *scanner,
+                                       GtkStyleProperty   *property,
+                                       GtkCssValue        *value,
+                                       const char         *start,
+                                       const char         *end)
+{
+  RecordedText *recorded;
+  char *id;
+  guint index;
+
+  recorded = gtk_css_compile_state_record_text (compile, scanner, property, start, end);
+
+  /* Identical declarations are only stored and parsed once */
+  id = g_strdup_printf ("%s %u %s", property->name, recorded->source, recorded->text);
+  index = GPOINTER_TO_UINT (g_hash_table_lookup (compile->declaration_ids, id));
+  if (index == 0)
+    {
+      g_ptr_array_add (compile->declarations, recorded);
+      index = compile->declarations->len;
+      g_hash_table_insert (compile->declaration_ids, id, GUINT_TO_POINTER (index));
+    }
+  else
+    {
+      recorded_text_free (recorded);
+      g_free (id);
+    }
+  index--;
+
+  if (GTK_IS_CSS_SHORTHAND_PROPERTY (property))
+    {
+      GtkCssShorthandProperty *shorthand = GTK_CSS_SHORTHAND_PROPERTY (property);
+      guint i;
+
+      for (i = 0; i < _gtk_css_shorthand_property_get_n_subproperties (shorthand); i++)
+        gtk_css_compile_state_add_value (compile,
+                                         _gtk_css_shorthand_property_get_subproperty (shorthand, i),
+                                         _gtk_css_array_value_get_nth (value, i),
+                                         index, i);
+    }
+  else
+    {
+      gtk_css_compile_state_add_value (compile,
+                                       GTK_CSS_STYLE_PROPERTY (property),
+                                       value,
+                                       index, GTK_CSS_COMPILED_NONE);
+    }
 }
 
 static gboolean
@@ -861,7 +1104,9 @@ parse_import (GtkCssScanner *scanner)
 static gboolean
 parse_color_definition (GtkCssScanner *scanner)
 {
+  GtkCssCompileState *compile = scanner->provider->priv->compile;
   GtkCssValue *color;
+  const char *start, *end;
   char *name;
 
   gtk_css_scanner_push_section (scanner, GTK_CSS_SECTION_COLOR_DEFINITION);
@@ -885,6 +1130,7 @@ parse_color_definition (GtkCssScanner *scanner)
       return TRUE;
     }
 
+  start = _gtk_css_parser_get_data (scanner->parser);
   color = _gtk_css_color_value_parse (scanner->parser);
   if (color == NULL)
     {
@@ -893,6 +1139,7 @@ parse_color_definition (GtkCssScanner *scanner)
       gtk_css_scanner_pop_section (scanner, GTK_CSS_SECTION_COLOR_DEFINITION);
       return TRUE;
     }
+  end = _gtk_css_parser_get_data (scanner->parser);
 
   if (!_gtk_css_parser_try (scanner->parser, ";", TRUE))
     {
@@ -909,6 +1156,11 @@ parse_color_definition (GtkCssScanner *scanner)
       return TRUE;
     }
 
+  if (compile)
+    g_hash_table_insert (compile->colors,
+                         g_strdup (name),
+                         gtk_css_compile_state_record_text (compile, scanner, NULL, start, end));
+
   g_hash_table_insert (scanner->provider->priv->symbolic_colors, name, color);
 
   gtk_css_scanner_pop_section (scanner, GTK_CSS_SECTION_COLOR_DEFINITION);
@@ -978,6 +1230,13 @@ parse_binding_set (GtkCssScanner *scanner)
                                           GTK_CSS_PROVIDER_ERROR_SYNTAX,
                                           "Failed to parse binding set.");
         }
+      else if (scanner->provider->priv->compile)
+        {
+          GtkCssCompileState *compile = scanner->provider->priv->compile;
+
+          g_ptr_array_add (compile->bindings, g_strdup (binding_set->set_name));
+          g_ptr_array_add (compile->bindings, g_strdup (name));
+        }
 
       g_free (name);
 
@@ -1026,7 +1285,9 @@ skip_semicolon:
 static gboolean
 parse_keyframes (GtkCssScanner *scanner)
 {
+  GtkCssCompileState *compile = scanner->provider->priv->compile;
   GtkCssKeyframes *keyframes;
+  const char *start;
   char *name;
 
   gtk_css_scanner_push_section (scanner, GTK_CSS_SECTION_KEYFRAMES);
@@ -1061,6 +1322,7 @@ parse_keyframes (GtkCssScanner *scanner)
       goto exit;
     }
 
+  start = _gtk_css_parser_get_data (scanner->parser);
   keyframes = _gtk_css_keyframes_parse (scanner->parser);
   if (keyframes == NULL)
     {
@@ -1069,7 +1331,8 @@ parse_keyframes (GtkCssScanner *scanner)
       goto exit;
     }
 
-  g_hash_table_insert (scanner->provider->priv->keyframes, name, keyframes);
+  /* Replacing keeps @name alive for recording it below */
+  g_hash_table_replace (scanner->provider->priv->keyframes, name, keyframes);
 
   if (!_gtk_css_parser_try (scanner->parser, "}", TRUE))
     {
@@ -1081,6 +1344,14 @@ parse_keyframes (GtkCssScanner *scanner)
       if (!_gtk_css_parser_is_eof (scanner->parser))
         _gtk_css_parser_resync (scanner->parser, FALSE, 0);
     }
+  else if (compile)
+    {
+      /* The closing brace is part of what _gtk_css_keyframes_parse() reads */
+      g_hash_table_insert (compile->keyframes,
+                           g_strdup (name),
+                           gtk_css_compile_state_record_text (compile, scanner, NULL, start,
+                                                              _gtk_css_parser_get_data (scanner->parser)));
+    }
 
 exit:
   gtk_css_scanner_pop_section (scanner, GTK_CSS_SECTION_KEYFRAMES);
@@ -1165,11 +1436,13 @@ parse_declaration (GtkCssScanner *scanner,
   if (property)
     {
       GtkCssValue *value;
+      const char *start;
 
       g_free (name);
 
       gtk_css_scanner_push_section (scanner, GTK_CSS_SECTION_VALUE);
 
+      start = _gtk_css_parser_get_data (scanner->parser);
       value = _gtk_style_property_parse_value (property,
                                                scanner->parser);
 
@@ -1196,6 +1469,14 @@ parse_declaration (GtkCssScanner *scanner,
           return;
         }
 
+      if (scanner->provider->priv->compile)
+        gtk_css_compile_state_add_declaration (scanner->provider->priv->compile,
+                                               scanner,
+                                               property,
+                                               value,
+                                               start,
+                                               _gtk_css_parser_get_data (scanner->parser));
+
       if (GTK_IS_CSS_SHORTHAND_PROPERTY (property))
         {
           GtkCssShorthandProperty *shorthand = GTK_CSS_SHORTHAND_PROPERTY (property);
@@ -1406,6 +1687,9 @@ gtk_css_provider_load_internal (GtkCssProvider *css_provider,
                                 NULL, &load_error))
         {
           text = free_data;
+
+          if (css_provider->priv->compile)
+            gtk_css_compile_state_add_source (css_provider->priv->compile, file, text);
         }
       else
         {
@@ -1457,6 +1741,737 @@ gtk_css_provider_load_internal (GtkCssProvider *css_provider,
   g_free (free_data);
 }
 
+static void
+save_recorded_texts (GtkCssCompiledWriter *writer,
+                     GHashTable           *texts)
+{
+  GList *keys, *l;
+
+  keys = g_hash_table_get_keys (texts);
+  /* so the output is identical for identical style sheets */
+  keys = g_list_sort (keys, (GCompareFunc) strcmp);
+
+  gtk_css_compiled_writer_add_uint32 (writer, g_hash_table_size (texts));
+  for (l = keys; l; l = l->next)
+    {
+      RecordedText *recorded = g_hash_table_lookup (texts, l->data);
+
+      gtk_css_compiled_writer_add_string (writer, l->data);
+      gtk_css_compiled_writer_add_uint32 (writer, recorded->source);
+      gtk_css_compiled_writer_add_string (writer, recorded->text);
+    }
+
+  g_list_free (keys);
+}
+
+static guint32
+gtk_css_provider_get_ruleset_index (gpointer match,
+                                    gpointer data)
+{
+  GArray *rulesets = data;
+
+  return (GtkCssRuleset *) match - (GtkCssRuleset *) rulesets->data;
+}
+
+static gboolean
+gtk_css_provider_save (GtkCssProvider        *css_provider,
+                       GtkCssCompiledWriter  *writer,
+                       GError               **error)
+{
+  GtkCssProviderPrivate *priv = css_provider->priv;
+  GtkCssCompileState *compile = priv->compile;
+  GHashTable *block_ids;
+  GPtrArray *blocks;
+  guint i, j;
+
+  gtk_css_compiled_writer_add_uint32 (writer, compile->sources->len);
+  for (i = 0; i < compile->sources->len; i++)
+    {
+      char *uri = g_file_get_uri (g_ptr_array_index (compile->sources, i));
+
+      gtk_css_compiled_writer_add_string (writer, uri);
+      gtk_css_compiled_writer_add_string (writer, g_ptr_array_index (compile->checksums, i));
+      g_free (uri);
+    }
+
+  save_recorded_texts (writer, compile->colors);
+  save_recorded_texts (writer, compile->keyframes);
+
+  gtk_css_compiled_writer_add_uint32 (writer, compile->declarations->len);
+  for (i = 0; i < compile->declarations->len; i++)
+    {
+      RecordedText *recorded = g_ptr_array_index (compile->declarations, i);
+
+      gtk_css_compiled_writer_add_string (writer, recorded->property->name);
+      gtk_css_compiled_writer_add_uint32 (writer, recorded->source);
+      gtk_css_compiled_writer_add_string (writer, recorded->text);
+    }
+
+  /* Rulesets that were declared with a selector list share their styles.
+   * Each list of styles is stored once as a block. */
+  blocks = g_ptr_array_new ();
+  block_ids = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < priv->rulesets->len; i++)
+    {
+      GtkCssRuleset *ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+
+      if (!g_hash_table_contains (block_ids, ruleset->styles))
+        {
+          g_hash_table_insert (block_ids, ruleset->styles, GUINT_TO_POINTER (blocks->len));
+          g_ptr_array_add (blocks, ruleset);
+        }
+    }
+
+  gtk_css_compiled_writer_add_uint32 (writer, blocks->len);
+  for (i = 0; i < blocks->len; i++)
+    {
+      GtkCssRuleset *ruleset = g_ptr_array_index (blocks, i);
+
+      gtk_css_compiled_writer_add_uint32 (writer, ruleset->n_styles);
+      for (j = 0; j < ruleset->n_styles; j++)
+        {
+          PropertyValue *style = &ruleset->styles[j];
+          RecordedValue key = { style->property, style->value, };
+          RecordedValue *recorded;
+
+          recorded = g_hash_table_lookup (compile->values, &key);
+          if (recorded == NULL)
+            {
+              g_set_error (error,
+                           GTK_CSS_PROVIDER_ERROR, GTK_CSS_PROVIDER_ERROR_FAILED,
+                           "Value of %s was not parsed from a declaration",
+                           _gtk_style_property_get_name (GTK_STYLE_PROPERTY (style->property)));
+              g_hash_table_unref (block_ids);
+              g_ptr_array_free (blocks, TRUE);
+              return FALSE;
+            }
+
+          gtk_css_compiled_writer_add_uint32 (writer, _gtk_css_style_property_get_id (style->property));
+          gtk_css_compiled_writer_add_uint32 (writer, recorded->declaration);
+          gtk_css_compiled_writer_add_uint32 (writer, recorded->sub);
+        }
+    }
+
+  gtk_css_compiled_writer_add_uint32 (writer, priv->rulesets->len);
+  for (i = 0; i < priv->rulesets->len; i++)
+    {
+      GtkCssRuleset *ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+
+      gtk_css_compiled_writer_add_uint32 (writer, GPOINTER_TO_UINT (g_hash_table_lookup (block_ids, ruleset->styles)));
+    }
+
+  g_hash_table_unref (block_ids);
+  g_ptr_array_free (blocks, TRUE);
+
+  _gtk_css_selector_tree_save (priv->tree, writer, gtk_css_provider_get_ruleset_index, priv->rulesets);
+
+  /* Binding sets come last, as they can't be undone when loading fails */
+  gtk_css_compiled_writer_add_uint32 (writer, compile->bindings->len / 2);
+  for (i = 0; i < compile->bindings->len; i++)
+    gtk_css_compiled_writer_add_string (writer, g_ptr_array_index (compile->bindings, i));
+
+  return TRUE;
+}
+
+static void
+gtk_css_provider_compile_error (GtkCssProvider  *css_provider,
+                                GtkCssSection   *section,
+                                const GError    *error,
+                                GError         **first_error)
+{
+  char *location;
+
+  if (*first_error)
+    return;
+
+  location = _gtk_css_section_to_string (section);
+  *first_error = g_error_copy (error);
+  g_prefix_error (first_error, "%s: ", location);
+  g_free (location);
+}
+
+/**
+ * gtk_css_provider_compile:
+ * @file: the CSS file to compile
+ * @error: return location for an error
+ *
+ * Parses @file and everything it imports into a compiled style sheet.
+ * When the result is saved next to @file, with %GTK_CSS_COMPILED_SUFFIX
+ * appended to its name, loading @file into a #GtkCssProvider uses it
+ * instead of parsing the text again, as long as none of the files has
+ * changed.
+ *
+ * Style sheets with parsing errors are not compiled, as the errors
+ * would no longer be reported.
+ *
+ * Returns: (nullable): the compiled style sheet
+ **/
+GBytes *
+gtk_css_provider_compile (GFile   *file,
+                          GError **error)
+{
+  GtkCssProvider *css_provider;
+  GtkCssCompiledWriter *writer;
+  GError *first_error = NULL;
+  GBytes *bytes = NULL;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  css_provider = gtk_css_provider_new ();
+  css_provider->priv->compile = gtk_css_compile_state_new ();
+  g_signal_connect (css_provider, "parsing-error",
+                    G_CALLBACK (gtk_css_provider_compile_error), &first_error);
+
+  gtk_css_provider_load_internal (css_provider, NULL, file, NULL);
+
+  if (first_error)
+    {
+      g_propagate_error (error, first_error);
+    }
+  else
+    {
+      writer = gtk_css_compiled_writer_new ();
+      if (gtk_css_provider_save (css_provider, writer, error))
+        bytes = gtk_css_compiled_writer_free_to_bytes (writer);
+      else
+        gtk_css_compiled_writer_free (writer);
+    }
+
+  gtk_css_compile_state_free (css_provider->priv->compile);
+  css_provider->priv->compile = NULL;
+  g_object_unref (css_provider);
+
+  return bytes;
+}
+
+static GBytes *
+gtk_css_provider_lookup_compiled (GFile *file)
+{
+  GBytes *bytes = NULL;
+  char *path;
+
+  if (g_file_has_uri_scheme (file, "resource"))
+    {
+      char *uri, *resource_path;
+
+      uri = g_file_get_uri (file);
+      path = g_uri_unescape_string (uri + strlen ("resource://"), NULL);
+      resource_path = g_strconcat (path, GTK_CSS_COMPILED_SUFFIX, NULL);
+
+      bytes = g_resources_lookup_data (resource_path, 0, NULL);
+
+      g_free (resource_path);
+      g_free (path);
+      g_free (uri);
+    }
+  else
+    {
+      path = g_file_get_path (file);
+      if (path)
+        {
+          char *compiled_path;
+          GMappedFile *mapped_file;
+
+          compiled_path = g_strconcat (path, GTK_CSS_COMPILED_SUFFIX, NULL);
+          mapped_file = g_mapped_file_new (compiled_path, FALSE, NULL);
+          if (mapped_file)
+            {
+              bytes = g_mapped_file_get_bytes (mapped_file);
+              g_mapped_file_unref (mapped_file);
+            }
+
+          g_free (compiled_path);
+          g_free (path);
+        }
+    }
+
+  return bytes;
+}
+
+static void
+gtk_css_provider_load_compiled_error (GtkCssParser *parser,
+                                      const GError *error,
+                                      gpointer      user_data)
+{
+  gboolean *failed = user_data;
+
+  *failed = TRUE;
+}
+
+/* Parses text recorded by gtk_css_compile_state_record_text(). The text
+ * parsed without errors when it was compiled, so errors mean that the
+ * compiled style sheet does not match the files anymore. */
+static GtkCssParser *
+load_recorded_text (GtkCssCompiledReader *reader,
+                    GPtrArray            *sources,
+                    gboolean             *failed)
+{
+  guint source;
+  const char *text;
+
+  source = gtk_css_compiled_reader_read_index (reader, sources->len);
+  text = gtk_css_compiled_reader_read_string (reader);
+  if (gtk_css_compiled_reader_has_failed (reader))
+    return NULL;
+
+  return _gtk_css_parser_new (text,
+                              g_ptr_array_index (sources, source),
+                              gtk_css_provider_load_compiled_error,
+                              failed);
+}
+
+static gboolean
+finish_recorded_text (GtkCssParser *parser,
+                      gboolean      failed)
+{
+  _gtk_css_parser_skip_whitespace (parser);
+  failed |= !_gtk_css_parser_is_eof (parser);
+  _gtk_css_parser_free (parser);
+
+  return !failed;
+}
+
+static GPtrArray *
+load_sources (GtkCssCompiledReader *reader,
+              GFile                *file)
+{
+  GPtrArray *sources;
+  guint i, n;
+
+  n = gtk_css_compiled_reader_read_count (reader, 2 * sizeof (guint32));
+  if (n == 0)
+    return NULL;
+
+  sources = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (i = 0; i < n; i++)
+    {
+      const char *uri, *checksum;
+      char *contents, *current;
+      GFile *source;
+      gboolean valid;
+
+      uri = gtk_css_compiled_reader_read_string (reader);
+      checksum = gtk_css_compiled_reader_read_string (reader);
+      if (gtk_css_compiled_reader_has_failed (reader))
+        break;
+
+      source = g_file_new_for_uri (uri);
+      g_ptr_array_add (sources, source);
+
+      /* The compiled style sheet might have been copied along with a
+       * file that imports others by relative paths */
+      if (i == 0 && !g_file_equal (source, file))
+        break;
+
+      if (!g_file_load_contents (source, NULL, &contents, NULL, NULL, NULL))
+        break;
+
+      current = g_compute_checksum_for_string (G_CHECKSUM_SHA256, contents, -1);
+      valid = g_str_equal (current, checksum);
+      g_free (current);
+      g_free (contents);
+
+      if (!valid)
+        break;
+    }
+
+  if (i < n)
+    {
+      g_ptr_array_unref (sources);
+      return NULL;
+    }
+
+  return sources;
+}
+
+static gboolean
+load_colors (GtkCssProvider       *css_provider,
+             GtkCssCompiledReader *reader,
+             GPtrArray            *sources)
+{
+  guint i, n;
+
+  n = gtk_css_compiled_reader_read_count (reader, 3 * sizeof (guint32));
+
+  for (i = 0; i < n; i++)
+    {
+      const char *name = gtk_css_compiled_reader_read_string (reader);
+      GtkCssParser *parser;
+      GtkCssValue *color;
+      gboolean failed = FALSE;
+
+      parser = load_recorded_text (reader, sources, &failed);
+      if (parser == NULL)
+        return FALSE;
+
+      color = _gtk_css_color_value_parse (parser);
+      if (!finish_recorded_text (parser, failed || color == NULL))
+        {
+          if (color)
+            _gtk_css_value_unref (color);
+          return FALSE;
+        }
+
+      g_hash_table_insert (css_provider->priv->symbolic_colors, g_strdup (name), color);
+    }
+
+  return !gtk_css_compiled_reader_has_failed (reader);
+}
+
+static gboolean
+load_keyframes (GtkCssProvider       *css_provider,
+                GtkCssCompiledReader *reader,
+                GPtrArray            *sources)
+{
+  guint i, n;
+
+  n = gtk_css_compiled_reader_read_count (reader, 3 * sizeof (guint32));
+
+  for (i = 0; i < n; i++)
+    {
+      const char *name = gtk_css_compiled_reader_read_string (reader);
+      GtkCssKeyframes *keyframes;
+      GtkCssParser *parser;
+      gboolean failed = FALSE;
+
+      parser = load_recorded_text (reader, sources, &failed);
+      if (parser == NULL)
+        return FALSE;
+
+      keyframes = _gtk_css_keyframes_parse (parser);
+      if (keyframes && !_gtk_css_parser_try (parser, "}", TRUE))
+        failed = TRUE;
+
+      if (!finish_recorded_text (parser, failed || keyframes == NULL))
+        {
+          if (keyframes)
+            _gtk_css_keyframes_unref (keyframes);
+          return FALSE;
+        }
+
+      g_hash_table_insert (css_provider->priv->keyframes, g_strdup (name), keyframes);
+    }
+
+  return !gtk_css_compiled_reader_has_failed (reader);
+}
+
+typedef struct {
+  GtkStyleProperty *property;
+  GtkCssValue *value;
+} LoadedDeclaration;
+
+static void
+loaded_declaration_clear (gpointer data)
+{
+  LoadedDeclaration *declaration = data;
+
+  if (declaration->value)
+    _gtk_css_value_unref (declaration->value);
+}
+
+static GArray *
+load_declarations (GtkCssCompiledReader *reader,
+                   GPtrArray            *sources)
+{
+  GArray *declarations;
+  guint i, n;
+
+  n = gtk_css_compiled_reader_read_count (reader, 3 * sizeof (guint32));
+
+  declarations = g_array_sized_new (FALSE, TRUE, sizeof (LoadedDeclaration), n);
+  g_array_set_clear_func (declarations, loaded_declaration_clear);
+
+  for (i = 0; i < n; i++)
+    {
+      LoadedDeclaration declaration;
+      GtkCssParser *parser;
+      gboolean failed = FALSE;
+
+      declaration.property = _gtk_style_property_lookup (gtk_css_compiled_reader_read_string (reader));
+      parser = load_recorded_text (reader, sources, &failed);
+      if (parser == NULL)
+        break;
+
+      if (declaration.property)
+        declaration.value = _gtk_style_property_parse_value (declaration.property, parser);
+      else
+        declaration.value = NULL;
+
+      if (!finish_recorded_text (parser, failed || declaration.value == NULL))
+        {
+          if (declaration.value)
+            _gtk_css_value_unref (declaration.value);
+          break;
+        }
+
+      g_array_append_val (declarations, declaration);
+    }
+
+  if (i < n || gtk_css_compiled_reader_has_failed (reader))
+    {
+      g_array_unref (declarations);
+      return NULL;
+    }
+
+  return declarations;
+}
+
+/* Looks up the value of @property as it was set by a declaration */
+static GtkCssValue *
+get_declared_value (GArray              *declarations,
+                    guint                index,
+                    guint                sub,
+                    GtkCssStyleProperty *property)
+{
+  LoadedDeclaration *declaration = &g_array_index (declarations, LoadedDeclaration, index);
+
+  if (sub == GTK_CSS_COMPILED_NONE)
+    {
+      if (declaration->property != GTK_STYLE_PROPERTY (property))
+        return NULL;
+
+      return declaration->value;
+    }
+  else
+    {
+      GtkCssShorthandProperty *shorthand;
+
+      if (!GTK_IS_CSS_SHORTHAND_PROPERTY (declaration->property))
+        return NULL;
+
+      shorthand = GTK_CSS_SHORTHAND_PROPERTY (declaration->property);
+      if (sub >= _gtk_css_shorthand_property_get_n_subproperties (shorthand) ||
+          _gtk_css_shorthand_property_get_subproperty (shorthand, sub) != property)
+        return NULL;
+
+      return _gtk_css_array_value_get_nth (declaration->value, sub);
+    }
+}
+
+static gboolean
+load_rulesets (GtkCssProvider       *css_provider,
+               GtkCssCompiledReader *reader,
+               GArray               *declarations)
+{
+  GtkCssProviderPrivate *priv = css_provider->priv;
+  PropertyValue **blocks;
+  guint *block_sizes;
+  gboolean *block_owned;
+  guint n_properties;
+  guint i, j, n_blocks, n_rulesets;
+  gboolean valid = TRUE;
+
+  n_properties = _gtk_css_style_property_get_n_properties ();
+  n_blocks = gtk_css_compiled_reader_read_count (reader, sizeof (guint32));
+  blocks = g_new0 (PropertyValue *, n_blocks);
+  block_sizes = g_new0 (guint, n_blocks);
+  block_owned = g_new0 (gboolean, n_blocks);
+
+  for (i = 0; i < n_blocks && valid; i++)
+    {
+      block_sizes[i] = gtk_css_compiled_reader_read_count (reader, 3 * sizeof (guint32));
+      blocks[i] = g_new0 (PropertyValue, block_sizes[i]);
+
+      for (j = 0; j < block_sizes[i]; j++)
+        {
+          GtkCssStyleProperty *property;
+          GtkCssValue *value;
+          guint index, sub;
+
+          property = _gtk_css_style_property_lookup_by_id (gtk_css_compiled_reader_read_index (reader, n_properties));
+          index = gtk_css_compiled_reader_read_index (reader, declarations->len);
+          sub = gtk_css_compiled_reader_read_uint32 (reader);
+          if (gtk_css_compiled_reader_has_failed (reader))
+            {
+              valid = FALSE;
+              break;
+            }
+
+          value = get_declared_value (declarations, index, sub, property);
+          if (value == NULL)
+            {
+              valid = FALSE;
+              break;
+            }
+
+          blocks[i][j].property = property;
+          blocks[i][j].value = _gtk_css_value_ref (value);
+        }
+    }
+
+  n_rulesets = valid ? gtk_css_compiled_reader_read_count (reader, sizeof (guint32)) : 0;
+  for (i = 0; i < n_rulesets; i++)
+    {
+      GtkCssRuleset ruleset = { 0, };
+      guint block;
+
+      block = gtk_css_compiled_reader_read_index (reader, n_blocks);
+      if (gtk_css_compiled_reader_has_failed (reader))
+        break;
+
+      ruleset.styles = blocks[block];
+      ruleset.n_styles = block_sizes[block];
+      /* The first ruleset using a block frees it, just like for parsed
+       * selector lists */
+      ruleset.owns_styles = !block_owned[block];
+      block_owned[block] = TRUE;
+
+      if (ruleset.n_styles > 0)
+        {
+          ruleset.set_styles = _gtk_bitmask_new ();
+          for (j = 0; j < ruleset.n_styles; j++)
+            ruleset.set_styles = _gtk_bitmask_set (ruleset.set_styles,
+                                                   _gtk_css_style_property_get_id (ruleset.styles[j].property),
+                                                   TRUE);
+        }
+
+      g_array_append_val (priv->rulesets, ruleset);
+    }
+
+  for (i = 0; i < n_blocks; i++)
+    {
+      if (block_owned[i])
+        continue;
+
+      for (j = 0; j < block_sizes[i]; j++)
+        {
+          if (blocks[i][j].value)
+            _gtk_css_value_unref (blocks[i][j].value);
+        }
+      g_free (blocks[i]);
+    }
+
+  g_free (blocks);
+  g_free (block_sizes);
+  g_free (block_owned);
+
+  return valid && !gtk_css_compiled_reader_has_failed (reader);
+}
+
+static gpointer
+gtk_css_provider_get_ruleset (guint32             index,
+                              GtkCssSelectorTree *node,
+                              gpointer            data)
+{
+  GArray *rulesets = data;
+  GtkCssRuleset *ruleset;
+
+  if (index >= rulesets->len)
+    return NULL;
+
+  ruleset = &g_array_index (rulesets, GtkCssRuleset, index);
+  ruleset->selector_match = node;
+
+  return ruleset;
+}
+
+static gboolean
+load_binding_sets (GtkCssCompiledReader *reader)
+{
+  guint i, n;
+
+  n = gtk_css_compiled_reader_read_count (reader, 2 * sizeof (guint32));
+
+  for (i = 0; i < n; i++)
+    {
+      GtkBindingSet *binding_set;
+      const char *name, *entry;
+
+      name = gtk_css_compiled_reader_read_string (reader);
+      entry = gtk_css_compiled_reader_read_string (reader);
+      if (gtk_css_compiled_reader_has_failed (reader))
+        return FALSE;
+
+      binding_set = gtk_binding_set_find (name);
+      if (!binding_set)
+        {
+          binding_set = gtk_binding_set_new (name);
+          binding_set->parsed = TRUE;
+        }
+
+      gtk_binding_entry_add_signal_from_string (binding_set, entry);
+    }
+
+  return !gtk_css_compiled_reader_has_failed (reader);
+}
+
+/* Loads the compiled style sheet for @file if there is one and it is
+ * still up to date. Otherwise returns %FALSE and @file needs to be
+ * parsed. */
+static gboolean
+gtk_css_provider_load_compiled (GtkCssProvider *css_provider,
+                                GFile          *file)
+{
+  GtkCssProviderPrivate *priv = css_provider->priv;
+  GtkCssCompiledReader *reader;
+  GPtrArray *sources;
+  GArray *declarations;
+  GBytes *bytes;
+  gboolean result;
+
+  /* Compiled style sheets don't have sections and selectors */
+  if (gtk_keep_css_sections)
+    return FALSE;
+#ifdef VERIFY_TREE
+  return FALSE;
+#endif
+
+  bytes = gtk_css_provider_lookup_compiled (file);
+  if (bytes == NULL)
+    return FALSE;
+
+  reader = gtk_css_compiled_reader_new (bytes);
+  g_bytes_unref (bytes);
+  if (reader == NULL)
+    return FALSE;
+
+  result = FALSE;
+  sources = load_sources (reader, file);
+  if (sources)
+    {
+      if (load_colors (css_provider, reader, sources) &&
+          load_keyframes (css_provider, reader, sources))
+        {
+          declarations = load_declarations (reader, sources);
+          if (declarations)
+            {
+              result = load_rulesets (css_provider, reader, declarations) &&
+                       _gtk_css_selector_tree_load (reader,
+                                                    gtk_css_provider_get_ruleset,
+                                                    priv->rulesets,
+                                                    &priv->tree);
+              g_array_unref (declarations);
+            }
+        }
+
+      g_ptr_array_unref (sources);
+    }
+
+  if (result)
+    result = load_binding_sets (reader);
+
+  if (result)
+    priv->loaded_compiled = TRUE;
+  else
+    gtk_css_provider_clear (css_provider);
+
+  gtk_css_compiled_reader_free (reader);
+
+  return result;
+}
+
+/* Whether the style sheet was loaded from a compiled style sheet
+ * instead of being parsed */
+gboolean
+gtk_css_provider_loaded_compiled (GtkCssProvider *css_provider)
+{
+  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
+
+  return css_provider->priv->loaded_compiled;
+}
+
 /**
  * gtk_css_provider_load_from_data:
  * @css_provider: a #GtkCssProvider
@@ -1515,7 +2530,8 @@ gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
 
   gtk_css_provider_reset (css_provider);
 
-  gtk_css_provider_load_internal (css_provider, NULL, file, NULL);
+  if (!gtk_css_provider_load_compiled (css_provider, file))
+    gtk_css_provider_load_internal (css_provider, NULL, file, NULL);
 
   _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (css_provider));
 }
@@ -32,6 +32,15 @@ void   _gtk_css_provider_load_named    (GtkCssProvider *provider,
 
 void   gtk_css_provider_set_keep_css_sections (void);
 
+/* Needs to be exported API for gtk4-compile-css */
+GDK_AVAILABLE_IN_ALL
+GBytes *gtk_css_provider_compile       (GFile          *file,
+                                        GError        **error);
+
+/* Needs to be exported for testsuite/css/compiled */
+GDK_AVAILABLE_IN_ALL
+gboolean gtk_css_provider_loaded_compiled (GtkCssProvider *css_provider);
+
 G_END_DECLS
 
 #endif /* __GTK_CSS_PROVIDER_PRIVATE_H__ */
@@ -105,7 +105,7 @@ gtk_css_section_ref (GtkCssSection *section)
 {
   gtk_internal_return_val_if_fail (section != NULL, NULL);
 
-  section->ref_count += 1;
+  g_atomic_int_inc (&section->ref_count);
 
   return section;
 }
@@ -124,8 +124,7 @@ gtk_css_section_unref (GtkCssSection *section)
 {
   gtk_internal_return_if_fail (section != NULL);
 
-  section->ref_count -= 1;
-  if (section->ref_count > 0)
+  if (!g_atomic_int_dec_and_test (&section->ref_count))
     return;
 
   if (section->parent)
@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include "gtkcssprovider.h"
+#include "gtkdebug.h"
 #include "gtkstylecontextprivate.h"
 
 #if defined(_MSC_VER) && _MSC_VER >= 1500
@@ -1474,6 +1475,77 @@ gtk_css_selectors_skip_initial_selector (GtkCssSelector *selector, const GtkCssS
   return (GtkCssSelector *)gtk_css_selector_previous (selector);
 }
 
+/* Checks if any ancestor in @filter could match @selector */
+static gboolean
+gtk_css_selector_may_match_ancestor (const GtkCssSelector       *selector,
+                                     const GtkCssAncestorFilter *filter)
+{
+  if (selector->class == &GTK_CSS_SELECTOR_NAME)
+    return gtk_css_ancestor_filter_may_have_name (filter, selector->name.name);
+  else if (selector->class == &GTK_CSS_SELECTOR_CLASS)
+    return gtk_css_ancestor_filter_may_have_class (filter, selector->style_class.style_class);
+  else if (selector->class == &GTK_CSS_SELECTOR_ID)
+    return gtk_css_ancestor_filter_may_have_id (filter, selector->id.name);
+  else
+    return TRUE;
+}
+
+static gboolean gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
+                                                     const GtkCssMatcher  *matcher,
+                                                     gpointer              res);
+
+/* Matches the selectors following a descendant combinator against all
+ * ancestors of @matcher. Branches of the tree that require a name, class
+ * or id none of the ancestors has are skipped without walking the
+ * ancestors at all. */
+static void
+gtk_css_selector_tree_match_descendant (const GtkCssSelectorTree *tree,
+                                        const GtkCssMatcher      *matcher,
+                                        gpointer                  res)
+{
+  const GtkCssAncestorFilter *filter;
+  const GtkCssSelectorTree *prev;
+  GtkCssMatcher ancestor;
+
+  filter = _gtk_css_matcher_get_ancestor_filter (matcher);
+  if (filter == NULL || GTK_DEBUG_CHECK (NO_CSS_BLOOM))
+    {
+      gtk_css_selector_foreach (&tree->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+      return;
+    }
+
+  for (prev = gtk_css_selector_tree_get_previous (tree);
+       prev != NULL;
+       prev = gtk_css_selector_tree_get_sibling (prev))
+    {
+      if (gtk_css_selector_may_match_ancestor (&prev->selector, filter))
+        break;
+    }
+
+  if (prev == NULL)
+    return;
+
+  /* Like gtk_css_selector_descendant_foreach_matcher(), but only with
+   * the branches that may match */
+  while (_gtk_css_matcher_get_parent (&ancestor, matcher))
+    {
+      matcher = &ancestor;
+
+      for (prev = gtk_css_selector_tree_get_previous (tree);
+           prev != NULL;
+           prev = gtk_css_selector_tree_get_sibling (prev))
+        {
+          if (gtk_css_selector_may_match_ancestor (&prev->selector, filter))
+            gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+        }
+
+      /* any matchers are dangerous here, as we may loop forever, but
+	 we can terminate now as all possible matches have already been added */
+      if (_gtk_css_matcher_matches_any (matcher))
+	break;
+    }
+}
+
 static gboolean
 gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
                                      const GtkCssMatcher  *matcher,
@@ -1490,7 +1562,12 @@ gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
   for (prev = gtk_css_selector_tree_get_previous (tree);
        prev != NULL;
        prev = gtk_css_selector_tree_get_sibling (prev))
-    gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+    {
+      if (prev->selector.class == &GTK_CSS_SELECTOR_DESCENDANT)
+        gtk_css_selector_tree_match_descendant (prev, matcher, res);
+      else
+        gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+    }
 
   return FALSE;
 }
@@ -1901,3 +1978,323 @@ _gtk_css_selector_tree_builder_build (GtkCssSelectorTreeBuilder *builder)
 
   return tree;
 }
+
+/* COMPILED STYLE SHEETS */
+
+/* The order of this list is part of the compiled format */
+static const GtkCssSelectorClass *compiled_selector_classes[] = {
+  &GTK_CSS_SELECTOR_DESCENDANT,
+  &GTK_CSS_SELECTOR_CHILD,
+  &GTK_CSS_SELECTOR_SIBLING,
+  &GTK_CSS_SELECTOR_ADJACENT,
+  &GTK_CSS_SELECTOR_ANY,
+  &GTK_CSS_SELECTOR_NOT_ANY,
+  &GTK_CSS_SELECTOR_NAME,
+  &GTK_CSS_SELECTOR_NOT_NAME,
+  &GTK_CSS_SELECTOR_CLASS,
+  &GTK_CSS_SELECTOR_NOT_CLASS,
+  &GTK_CSS_SELECTOR_ID,
+  &GTK_CSS_SELECTOR_NOT_ID,
+  &GTK_CSS_SELECTOR_PSEUDOCLASS_STATE,
+  &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_STATE,
+  &GTK_CSS_SELECTOR_PSEUDOCLASS_POSITION,
+  &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_POSITION,
+};
+
+static void
+collect_tree_nodes (const GtkCssSelectorTree *tree,
+                    GPtrArray                *nodes,
+                    GHashTable               *node_indexes)
+{
+  for (; tree != NULL; tree = gtk_css_selector_tree_get_sibling (tree))
+    {
+      g_hash_table_insert (node_indexes, (gpointer) tree, GUINT_TO_POINTER (nodes->len));
+      g_ptr_array_add (nodes, (gpointer) tree);
+
+      collect_tree_nodes (gtk_css_selector_tree_get_previous (tree), nodes, node_indexes);
+    }
+}
+
+static guint32
+get_node_index (GHashTable               *node_indexes,
+                const GtkCssSelectorTree *tree)
+{
+  if (tree == NULL)
+    return GTK_CSS_COMPILED_NONE;
+
+  return GPOINTER_TO_UINT (g_hash_table_lookup (node_indexes, tree));
+}
+
+static guint
+get_selector_class_index (const GtkCssSelectorClass *class)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (compiled_selector_classes); i++)
+    {
+      if (compiled_selector_classes[i] == class)
+        return i;
+    }
+
+  g_assert_not_reached ();
+  return 0;
+}
+
+static void
+gtk_css_selector_save (const GtkCssSelector *selector,
+                       GtkCssCompiledWriter *writer)
+{
+  gtk_css_compiled_writer_add_uint32 (writer, get_selector_class_index (selector->class));
+
+  if (selector->class == &GTK_CSS_SELECTOR_NAME ||
+      selector->class == &GTK_CSS_SELECTOR_NOT_NAME)
+    {
+      gtk_css_compiled_writer_add_string (writer, selector->name.name);
+    }
+  else if (selector->class == &GTK_CSS_SELECTOR_ID ||
+           selector->class == &GTK_CSS_SELECTOR_NOT_ID)
+    {
+      gtk_css_compiled_writer_add_string (writer, selector->id.name);
+    }
+  else if (selector->class == &GTK_CSS_SELECTOR_CLASS ||
+           selector->class == &GTK_CSS_SELECTOR_NOT_CLASS)
+    {
+      gtk_css_compiled_writer_add_string (writer, g_quark_to_string (selector->style_class.style_class));
+    }
+  else if (selector->class == &GTK_CSS_SELECTOR_PSEUDOCLASS_STATE ||
+           selector->class == &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_STATE)
+    {
+      gtk_css_compiled_writer_add_uint32 (writer, selector->state.state);
+    }
+  else if (selector->class == &GTK_CSS_SELECTOR_PSEUDOCLASS_POSITION ||
+           selector->class == &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_POSITION)
+    {
+      gtk_css_compiled_writer_add_uint32 (writer, selector->position.type);
+      gtk_css_compiled_writer_add_uint32 (writer, (gint32) selector->position.a);
+      gtk_css_compiled_writer_add_uint32 (writer, (gint32) selector->position.b);
+    }
+}
+
+static gboolean
+gtk_css_selector_load (GtkCssSelector       *selector,
+                       GtkCssCompiledReader *reader)
+{
+  const GtkCssSelectorClass *class;
+
+  class = compiled_selector_classes[gtk_css_compiled_reader_read_index (reader, G_N_ELEMENTS (compiled_selector_classes))];
+  selector->class = class;
+
+  if (class == &GTK_CSS_SELECTOR_NAME ||
+      class == &GTK_CSS_SELECTOR_NOT_NAME)
+    {
+      selector->name.name = g_intern_string (gtk_css_compiled_reader_read_string (reader));
+    }
+  else if (class == &GTK_CSS_SELECTOR_ID ||
+           class == &GTK_CSS_SELECTOR_NOT_ID)
+    {
+      selector->id.name = g_intern_string (gtk_css_compiled_reader_read_string (reader));
+    }
+  else if (class == &GTK_CSS_SELECTOR_CLASS ||
+           class == &GTK_CSS_SELECTOR_NOT_CLASS)
+    {
+      selector->style_class.style_class = g_quark_from_string (gtk_css_compiled_reader_read_string (reader));
+    }
+  else if (class == &GTK_CSS_SELECTOR_PSEUDOCLASS_STATE ||
+           class == &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_STATE)
+    {
+      selector->state.state = gtk_css_compiled_reader_read_uint32 (reader);
+    }
+  else if (class == &GTK_CSS_SELECTOR_PSEUDOCLASS_POSITION ||
+           class == &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_POSITION)
+    {
+      guint32 type = gtk_css_compiled_reader_read_uint32 (reader);
+
+      if (type > POSITION_ONLY)
+        return FALSE;
+
+      selector->position.type = type;
+      selector->position.a = (gint32) gtk_css_compiled_reader_read_uint32 (reader);
+      selector->position.b = (gint32) gtk_css_compiled_reader_read_uint32 (reader);
+    }
+
+  return !gtk_css_compiled_reader_has_failed (reader);
+}
+
+/**
+ * _gtk_css_selector_tree_save:
+ * @tree: (nullable): the tree to save
+ * @writer: the writer of the compiled style sheet
+ * @get_match_index: returns the index that a match is stored as
+ * @data: data passed to @get_match_index
+ *
+ * Writes the finished @tree, so it can be loaded again with
+ * _gtk_css_selector_tree_load() without rebuilding it from selectors.
+ **/
+void
+_gtk_css_selector_tree_save (const GtkCssSelectorTree      *tree,
+                             GtkCssCompiledWriter          *writer,
+                             GtkCssSelectorTreeSaveMatchFunc get_match_index,
+                             gpointer                       data)
+{
+  GHashTable *node_indexes;
+  GPtrArray *nodes;
+  guint32 n_match_slots;
+  guint i, j;
+
+  nodes = g_ptr_array_new ();
+  node_indexes = g_hash_table_new (NULL, NULL);
+  collect_tree_nodes (tree, nodes, node_indexes);
+
+  n_match_slots = 0;
+  for (i = 0; i < nodes->len; i++)
+    {
+      gpointer *matches = gtk_css_selector_tree_get_matches (g_ptr_array_index (nodes, i));
+
+      if (matches == NULL)
+        continue;
+
+      for (j = 0; matches[j] != NULL; j++)
+        n_match_slots++;
+      /* the terminating NULL */
+      n_match_slots++;
+    }
+
+  gtk_css_compiled_writer_add_uint32 (writer, nodes->len);
+  gtk_css_compiled_writer_add_uint32 (writer, n_match_slots);
+
+  for (i = 0; i < nodes->len; i++)
+    {
+      const GtkCssSelectorTree *node = g_ptr_array_index (nodes, i);
+      gpointer *matches;
+      guint n_matches;
+
+      gtk_css_selector_save (&node->selector, writer);
+      gtk_css_compiled_writer_add_uint32 (writer, get_node_index (node_indexes, gtk_css_selector_tree_get_parent (node)));
+      gtk_css_compiled_writer_add_uint32 (writer, get_node_index (node_indexes, gtk_css_selector_tree_get_previous (node)));
+      gtk_css_compiled_writer_add_uint32 (writer, get_node_index (node_indexes, gtk_css_selector_tree_get_sibling (node)));
+
+      matches = gtk_css_selector_tree_get_matches (node);
+      n_matches = 0;
+      if (matches)
+        {
+          while (matches[n_matches] != NULL)
+            n_matches++;
+        }
+
+      gtk_css_compiled_writer_add_uint32 (writer, n_matches);
+      for (j = 0; j < n_matches; j++)
+        gtk_css_compiled_writer_add_uint32 (writer, get_match_index (matches[j], data));
+    }
+
+  g_hash_table_unref (node_indexes);
+  g_ptr_array_free (nodes, TRUE);
+}
+
+static gint32
+get_node_offset (guint32 from,
+                 guint32 to,
+                 guint32 n_nodes,
+                 gboolean *valid)
+{
+  if (to == GTK_CSS_COMPILED_NONE)
+    return GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+
+  if (to >= n_nodes)
+    {
+      *valid = FALSE;
+      return GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+    }
+
+  return ((gint32) to - (gint32) from) * (gint32) sizeof (GtkCssSelectorTree);
+}
+
+/**
+ * _gtk_css_selector_tree_load:
+ * @reader: the reader of the compiled style sheet
+ * @get_match: returns the match for an index written by
+ *     _gtk_css_selector_tree_save()
+ * @data: data passed to @get_match
+ * @out_tree: (out): return location for the loaded tree
+ *
+ * Loads a tree written by _gtk_css_selector_tree_save(). The nodes are
+ * laid out in a single allocation just like the ones built by
+ * _gtk_css_selector_tree_builder_build(), so only the links and the
+ * selector data need to be relocated.
+ *
+ * Returns: %TRUE if the tree was loaded
+ **/
+gboolean
+_gtk_css_selector_tree_load (GtkCssCompiledReader           *reader,
+                             GtkCssSelectorTreeLoadMatchFunc get_match,
+                             gpointer                        data,
+                             GtkCssSelectorTree            **out_tree)
+{
+  GtkCssSelectorTree *tree;
+  gpointer *match_slots;
+  guint32 n_nodes, n_match_slots, slot;
+  gboolean valid = TRUE;
+  guint32 i, j;
+
+  *out_tree = NULL;
+
+  n_nodes = gtk_css_compiled_reader_read_count (reader, 5 * sizeof (guint32));
+  n_match_slots = gtk_css_compiled_reader_read_count (reader, sizeof (guint32));
+  if (gtk_css_compiled_reader_has_failed (reader) ||
+      n_nodes > G_MAXINT32 / sizeof (GtkCssSelectorTree) / 2)
+    return FALSE;
+
+  /* An empty style sheet has no tree */
+  if (n_nodes == 0)
+    return n_match_slots == 0;
+
+  tree = g_malloc0 (n_nodes * sizeof (GtkCssSelectorTree) + n_match_slots * sizeof (gpointer));
+  match_slots = (gpointer *) (tree + n_nodes);
+  slot = 0;
+
+  for (i = 0; i < n_nodes && valid; i++)
+    {
+      GtkCssSelectorTree *node = &tree[i];
+      guint32 n_matches;
+
+      if (!gtk_css_selector_load (&node->selector, reader))
+        break;
+
+      node->parent_offset = get_node_offset (i, gtk_css_compiled_reader_read_uint32 (reader), n_nodes, &valid);
+      node->previous_offset = get_node_offset (i, gtk_css_compiled_reader_read_uint32 (reader), n_nodes, &valid);
+      node->sibling_offset = get_node_offset (i, gtk_css_compiled_reader_read_uint32 (reader), n_nodes, &valid);
+
+      n_matches = gtk_css_compiled_reader_read_uint32 (reader);
+      if (n_matches == 0)
+        {
+          node->matches_offset = GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+          continue;
+        }
+
+      /* Leave room for the terminating NULL */
+      if (n_matches >= n_match_slots - slot)
+        {
+          valid = FALSE;
+          break;
+        }
+
+      node->matches_offset = (guint8 *) &match_slots[slot] - (guint8 *) node;
+      for (j = 0; j < n_matches; j++)
+        {
+          match_slots[slot] = get_match (gtk_css_compiled_reader_read_uint32 (reader), node, data);
+          if (match_slots[slot] == NULL)
+            valid = FALSE;
+          slot++;
+        }
+      slot++;
+    }
+
+  if (!valid || i < n_nodes || slot != n_match_slots ||
+      gtk_css_compiled_reader_has_failed (reader))
+    {
+      g_free (tree);
+      return FALSE;
+    }
+
+  *out_tree = tree;
+  return TRUE;
+}
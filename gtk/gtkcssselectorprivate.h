@@ -18,6 +18,7 @@
 #ifndef __GTK_CSS_SELECTOR_PRIVATE_H__
 #define __GTK_CSS_SELECTOR_PRIVATE_H__
 
+#include "gtk/gtkcsscompiledprivate.h"
 #include "gtk/gtkcssmatcherprivate.h"
 #include "gtk/gtkcssparserprivate.h"
 
@@ -27,6 +28,12 @@ typedef union _GtkCssSelector GtkCssSelector;
 typedef struct _GtkCssSelectorTree GtkCssSelectorTree;
 typedef struct _GtkCssSelectorTreeBuilder GtkCssSelectorTreeBuilder;
 
+typedef guint32  (* GtkCssSelectorTreeSaveMatchFunc) (gpointer            match,
+                                                      gpointer            data);
+typedef gpointer (* GtkCssSelectorTreeLoadMatchFunc) (guint32             index,
+                                                      GtkCssSelectorTree *node,
+                                                      gpointer            data);
+
 GtkCssSelector *  _gtk_css_selector_parse           (GtkCssParser           *parser);
 void              _gtk_css_selector_free            (GtkCssSelector         *selector);
 
@@ -57,6 +64,15 @@ void                       _gtk_css_selector_tree_builder_add   (GtkCssSelectorT
 GtkCssSelectorTree *       _gtk_css_selector_tree_builder_build (GtkCssSelectorTreeBuilder *builder);
 void                       _gtk_css_selector_tree_builder_free  (GtkCssSelectorTreeBuilder *builder);
 
+void         _gtk_css_selector_tree_save             (const GtkCssSelectorTree        *tree,
+                                                      GtkCssCompiledWriter            *writer,
+                                                      GtkCssSelectorTreeSaveMatchFunc  get_match_index,
+                                                      gpointer                         data);
+gboolean     _gtk_css_selector_tree_load             (GtkCssCompiledReader            *reader,
+                                                      GtkCssSelectorTreeLoadMatchFunc  get_match,
+                                                      gpointer                         data,
+                                                      GtkCssSelectorTree             **out_tree);
+
 const char *gtk_css_pseudoclass_name (GtkStateFlags flags);
 
 G_END_DECLS
@@ -21,9 +21,11 @@
 
 #include "gtkcssstaticstyleprivate.h"
 
+#include "gtkcssanimatedstyleprivate.h"
 #include "gtkcssanimationprivate.h"
 #include "gtkcssarrayvalueprivate.h"
 #include "gtkcssenumvalueprivate.h"
+#include "gtkcssimagevalueprivate.h"
 #include "gtkcssinheritvalueprivate.h"
 #include "gtkcssinitialvalueprivate.h"
 #include "gtkcssnumbervalueprivate.h"
@@ -40,6 +42,278 @@
 
 G_DEFINE_TYPE (GtkCssStaticStyle, gtk_css_static_style, GTK_TYPE_CSS_STYLE)
 
+/* VALUE GROUPS */
+
+struct _GtkCssValueGroup
+{
+  guint                 ref_count;      /* protected by the value_groups lock */
+  GtkCssValueGroupKind  kind;
+  guint                 hash;
+  GtkCssValue          *values[1];      /* n_properties of the kind */
+};
+
+static const guint core_properties[] = {
+  GTK_CSS_PROPERTY_COLOR,
+  GTK_CSS_PROPERTY_DPI,
+  GTK_CSS_PROPERTY_FONT_SIZE,
+  GTK_CSS_PROPERTY_ICON_THEME,
+  GTK_CSS_PROPERTY_ICON_PALETTE,
+  GTK_CSS_PROPERTY_CARET_COLOR,
+  GTK_CSS_PROPERTY_SECONDARY_CARET_COLOR
+};
+
+static const guint font_properties[] = {
+  GTK_CSS_PROPERTY_FONT_FAMILY,
+  GTK_CSS_PROPERTY_FONT_STYLE,
+  GTK_CSS_PROPERTY_FONT_WEIGHT,
+  GTK_CSS_PROPERTY_FONT_STRETCH,
+  GTK_CSS_PROPERTY_LETTER_SPACING,
+  GTK_CSS_PROPERTY_FONT_KERNING,
+  GTK_CSS_PROPERTY_FONT_VARIANT_LIGATURES,
+  GTK_CSS_PROPERTY_FONT_VARIANT_POSITION,
+  GTK_CSS_PROPERTY_FONT_VARIANT_CAPS,
+  GTK_CSS_PROPERTY_FONT_VARIANT_NUMERIC,
+  GTK_CSS_PROPERTY_FONT_VARIANT_ALTERNATES,
+  GTK_CSS_PROPERTY_FONT_VARIANT_EAST_ASIAN,
+  GTK_CSS_PROPERTY_TEXT_SHADOW
+};
+
+static const guint text_decoration_properties[] = {
+  GTK_CSS_PROPERTY_TEXT_DECORATION_LINE,
+  GTK_CSS_PROPERTY_TEXT_DECORATION_COLOR,
+  GTK_CSS_PROPERTY_TEXT_DECORATION_STYLE
+};
+
+static const guint background_properties[] = {
+  GTK_CSS_PROPERTY_BACKGROUND_COLOR,
+  GTK_CSS_PROPERTY_BACKGROUND_CLIP,
+  GTK_CSS_PROPERTY_BACKGROUND_ORIGIN,
+  GTK_CSS_PROPERTY_BACKGROUND_SIZE,
+  GTK_CSS_PROPERTY_BACKGROUND_POSITION,
+  GTK_CSS_PROPERTY_BACKGROUND_REPEAT,
+  GTK_CSS_PROPERTY_BACKGROUND_IMAGE,
+  GTK_CSS_PROPERTY_BACKGROUND_BLEND_MODE,
+  GTK_CSS_PROPERTY_BOX_SHADOW
+};
+
+static const guint size_properties[] = {
+  GTK_CSS_PROPERTY_MARGIN_TOP,
+  GTK_CSS_PROPERTY_MARGIN_LEFT,
+  GTK_CSS_PROPERTY_MARGIN_BOTTOM,
+  GTK_CSS_PROPERTY_MARGIN_RIGHT,
+  GTK_CSS_PROPERTY_PADDING_TOP,
+  GTK_CSS_PROPERTY_PADDING_LEFT,
+  GTK_CSS_PROPERTY_PADDING_BOTTOM,
+  GTK_CSS_PROPERTY_PADDING_RIGHT,
+  GTK_CSS_PROPERTY_BORDER_SPACING,
+  GTK_CSS_PROPERTY_MIN_WIDTH,
+  GTK_CSS_PROPERTY_MIN_HEIGHT
+};
+
+static const guint border_properties[] = {
+  GTK_CSS_PROPERTY_BORDER_TOP_STYLE,
+  GTK_CSS_PROPERTY_BORDER_TOP_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_LEFT_STYLE,
+  GTK_CSS_PROPERTY_BORDER_LEFT_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_STYLE,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_STYLE,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_TOP_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_TOP_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_TOP_COLOR,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_COLOR,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_COLOR,
+  GTK_CSS_PROPERTY_BORDER_LEFT_COLOR,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_SOURCE,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_REPEAT,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_SLICE,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_WIDTH
+};
+
+static const guint outline_properties[] = {
+  GTK_CSS_PROPERTY_OUTLINE_STYLE,
+  GTK_CSS_PROPERTY_OUTLINE_WIDTH,
+  GTK_CSS_PROPERTY_OUTLINE_OFFSET,
+  GTK_CSS_PROPERTY_OUTLINE_TOP_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_TOP_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_BOTTOM_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_BOTTOM_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_COLOR
+};
+
+static const guint icon_properties[] = {
+  GTK_CSS_PROPERTY_ICON_SOURCE,
+  GTK_CSS_PROPERTY_ICON_SHADOW,
+  GTK_CSS_PROPERTY_ICON_STYLE,
+  GTK_CSS_PROPERTY_ICON_TRANSFORM,
+  GTK_CSS_PROPERTY_ICON_FILTER
+};
+
+static const guint transition_properties[] = {
+  GTK_CSS_PROPERTY_TRANSITION_PROPERTY,
+  GTK_CSS_PROPERTY_TRANSITION_DURATION,
+  GTK_CSS_PROPERTY_TRANSITION_TIMING_FUNCTION,
+  GTK_CSS_PROPERTY_TRANSITION_DELAY
+};
+
+static const guint animation_properties[] = {
+  GTK_CSS_PROPERTY_ANIMATION_NAME,
+  GTK_CSS_PROPERTY_ANIMATION_DURATION,
+  GTK_CSS_PROPERTY_ANIMATION_TIMING_FUNCTION,
+  GTK_CSS_PROPERTY_ANIMATION_ITERATION_COUNT,
+  GTK_CSS_PROPERTY_ANIMATION_DIRECTION,
+  GTK_CSS_PROPERTY_ANIMATION_PLAY_STATE,
+  GTK_CSS_PROPERTY_ANIMATION_DELAY,
+  GTK_CSS_PROPERTY_ANIMATION_FILL_MODE
+};
+
+static const guint other_properties[] = {
+  GTK_CSS_PROPERTY_OPACITY,
+  GTK_CSS_PROPERTY_FILTER,
+  GTK_CSS_PROPERTY_GTK_KEY_BINDINGS
+};
+
+static const struct {
+  const char  *name;
+  const guint *properties;
+  guint        n_properties;
+} value_group_kinds[GTK_CSS_VALUE_GROUP_N_GROUPS] = {
+  { "core", core_properties, G_N_ELEMENTS (core_properties) },
+  { "font", font_properties, G_N_ELEMENTS (font_properties) },
+  { "text-decoration", text_decoration_properties, G_N_ELEMENTS (text_decoration_properties) },
+  { "background", background_properties, G_N_ELEMENTS (background_properties) },
+  { "size", size_properties, G_N_ELEMENTS (size_properties) },
+  { "border", border_properties, G_N_ELEMENTS (border_properties) },
+  { "outline", outline_properties, G_N_ELEMENTS (outline_properties) },
+  { "icon", icon_properties, G_N_ELEMENTS (icon_properties) },
+  { "transition", transition_properties, G_N_ELEMENTS (transition_properties) },
+  { "animation", animation_properties, G_N_ELEMENTS (animation_properties) },
+  { "other", other_properties, G_N_ELEMENTS (other_properties) }
+};
+
+/* The group of each property and its index in the group */
+static guint8 property_groups[GTK_CSS_PROPERTY_N_PROPERTIES];
+static guint8 property_indexes[GTK_CSS_PROPERTY_N_PROPERTIES];
+
+/* All live groups, so equal groups are only kept once. Groups are
+ * equal if they hold the same values. Styles computed for siblings and
+ * children usually do, because values that don't depend on the node are
+ * shared and inherited values come from the parent. */
+G_LOCK_DEFINE_STATIC (value_groups);
+static GHashTable *value_groups;
+static guint n_static_styles;
+static guint n_value_groups[GTK_CSS_VALUE_GROUP_N_GROUPS];
+
+static gsize
+gtk_css_value_group_size (GtkCssValueGroupKind kind)
+{
+  return G_STRUCT_OFFSET (GtkCssValueGroup, values) + value_group_kinds[kind].n_properties * sizeof (GtkCssValue *);
+}
+
+static guint
+gtk_css_value_group_hash (gconstpointer data)
+{
+  const GtkCssValueGroup *group = data;
+
+  return group->hash;
+}
+
+static gboolean
+gtk_css_value_group_equal (gconstpointer a,
+                           gconstpointer b)
+{
+  const GtkCssValueGroup *group_a = a;
+  const GtkCssValueGroup *group_b = b;
+  guint i;
+
+  if (group_a->kind != group_b->kind ||
+      group_a->hash != group_b->hash)
+    return FALSE;
+
+  for (i = 0; i < value_group_kinds[group_a->kind].n_properties; i++)
+    {
+      if (group_a->values[i] != group_b->values[i])
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Takes over the references to @values */
+static GtkCssValueGroup *
+gtk_css_value_group_new (GtkCssValueGroupKind   kind,
+                         GtkCssValue          **values)
+{
+  GtkCssValueGroup *group, *existing;
+  guint i, n_properties;
+
+  n_properties = value_group_kinds[kind].n_properties;
+
+  group = g_malloc (gtk_css_value_group_size (kind));
+  group->ref_count = 1;
+  group->kind = kind;
+  group->hash = kind;
+  for (i = 0; i < n_properties; i++)
+    {
+      group->values[i] = values[i];
+      group->hash = (group->hash << 5) - group->hash + g_direct_hash (values[i]);
+    }
+
+  G_LOCK (value_groups);
+
+  existing = g_hash_table_lookup (value_groups, group);
+  if (existing)
+    {
+      existing->ref_count++;
+    }
+  else
+    {
+      g_hash_table_add (value_groups, group);
+      n_value_groups[kind]++;
+    }
+
+  G_UNLOCK (value_groups);
+
+  if (existing)
+    {
+      for (i = 0; i < n_properties; i++)
+        _gtk_css_value_unref (values[i]);
+      g_free (group);
+      group = existing;
+    }
+
+  return group;
+}
+
+static void
+gtk_css_value_group_unref (GtkCssValueGroup *group)
+{
+  guint i;
+
+  /* Dropping the last reference must happen with the lock held, or a
+   * lookup could find the group while it is being freed */
+  G_LOCK (value_groups);
+
+  group->ref_count--;
+  if (group->ref_count > 0)
+    {
+      G_UNLOCK (value_groups);
+      return;
+    }
+
+  g_hash_table_remove (value_groups, group);
+  n_value_groups[group->kind]--;
+
+  G_UNLOCK (value_groups);
+
+  for (i = 0; i < value_group_kinds[group->kind].n_properties; i++)
+    _gtk_css_value_unref (group->values[i]);
+  g_free (group);
+}
+
 static GtkCssValue *
 gtk_css_static_style_get_value (GtkCssStyle *style,
                                 guint        id)
@@ -47,7 +321,10 @@ gtk_css_static_style_get_value (GtkCssStyle *style,
   /* This is called a lot, so we avoid a dynamic type check here */
   GtkCssStaticStyle *sstyle = (GtkCssStaticStyle *) style;
 
-  return sstyle->values[id];
+  if (G_UNLIKELY (sstyle->values))
+    return sstyle->values[id];
+
+  return sstyle->groups[property_groups[id]]->values[property_indexes[id]];
 }
 
 static GtkCssSection *
@@ -69,10 +346,23 @@ gtk_css_static_style_dispose (GObject *object)
   GtkCssStaticStyle *style = GTK_CSS_STATIC_STYLE (object);
   guint i;
 
-  for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+  if (style->values)
+    {
+      for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+        {
+          if (style->values[i])
+            _gtk_css_value_unref (style->values[i]);
+        }
+      g_free (style->values);
+      style->values = NULL;
+    }
+  for (i = 0; i < GTK_CSS_VALUE_GROUP_N_GROUPS; i++)
     {
-      if (style->values[i])
-        _gtk_css_value_unref (style->values[i]);
+      if (style->groups[i])
+        {
+          gtk_css_value_group_unref (style->groups[i]);
+          style->groups[i] = NULL;
+        }
     }
   if (style->sections)
     {
@@ -83,21 +373,57 @@ gtk_css_static_style_dispose (GObject *object)
   G_OBJECT_CLASS (gtk_css_static_style_parent_class)->dispose (object);
 }
 
+static void
+gtk_css_static_style_finalize (GObject *object)
+{
+  G_LOCK (value_groups);
+  n_static_styles--;
+  G_UNLOCK (value_groups);
+
+  G_OBJECT_CLASS (gtk_css_static_style_parent_class)->finalize (object);
+}
+
 static void
 gtk_css_static_style_class_init (GtkCssStaticStyleClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkCssStyleClass *style_class = GTK_CSS_STYLE_CLASS (klass);
 
+  GtkBitmask *assigned;
+  guint i, j;
+
   object_class->dispose = gtk_css_static_style_dispose;
+  object_class->finalize = gtk_css_static_style_finalize;
 
   style_class->get_value = gtk_css_static_style_get_value;
   style_class->get_section = gtk_css_static_style_get_section;
+
+  assigned = _gtk_bitmask_new ();
+  for (i = 0; i < GTK_CSS_VALUE_GROUP_N_GROUPS; i++)
+    {
+      for (j = 0; j < value_group_kinds[i].n_properties; j++)
+        {
+          guint id = value_group_kinds[i].properties[j];
+
+          g_assert (!_gtk_bitmask_get (assigned, id));
+          assigned = _gtk_bitmask_set (assigned, id, TRUE);
+          property_groups[id] = i;
+          property_indexes[id] = j;
+        }
+    }
+  /* every property must be in exactly one group */
+  g_assert (_gtk_bitmask_equals (assigned, _gtk_bitmask_invert_range (_gtk_bitmask_new (), 0, GTK_CSS_PROPERTY_N_PROPERTIES)));
+  _gtk_bitmask_free (assigned);
+
+  value_groups = g_hash_table_new (gtk_css_value_group_hash, gtk_css_value_group_equal);
 }
 
 static void
 gtk_css_static_style_init (GtkCssStaticStyle *style)
 {
+  G_LOCK (value_groups);
+  n_static_styles++;
+  G_UNLOCK (value_groups);
 }
 
 static void
@@ -134,6 +460,123 @@ gtk_css_static_style_set_value (GtkCssStaticStyle *style,
     }
 }
 
+/* Whether a computed value may be replaced by any value it compares
+ * equal to. Images don't qualify: their equality only looks at what
+ * they load, not at the icon theme, scale or palette they were
+ * computed for, so only identical image values are interchangeable. */
+static gboolean
+gtk_css_value_is_shareable (const GtkCssValue *value)
+{
+  guint i;
+
+  if (_gtk_css_value_is_image (value))
+    return FALSE;
+
+  if (_gtk_css_value_is_array (value))
+    {
+      for (i = 0; i < _gtk_css_array_value_get_n_values (value); i++)
+        {
+          if (!gtk_css_value_is_shareable (_gtk_css_array_value_get_nth (value, i)))
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Moves the computed values into shared groups. Values that are equal
+ * to the parent's are replaced by the parent's, so that the groups of
+ * children match the groups of their parents whenever they can. */
+static void
+gtk_css_static_style_seal (GtkCssStaticStyle *style,
+                           GtkCssStyle       *parent)
+{
+  GtkCssValue *values[G_N_ELEMENTS (border_properties)];
+  guint i, j;
+
+  if (GTK_IS_CSS_ANIMATED_STYLE (parent))
+    parent = GTK_CSS_ANIMATED_STYLE (parent)->style;
+
+  if (parent)
+    {
+      for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+        {
+          GtkCssValue *parent_value = gtk_css_style_get_value (parent, i);
+
+          if (style->values[i] != parent_value &&
+              gtk_css_value_is_shareable (style->values[i]) &&
+              _gtk_css_value_equal (style->values[i], parent_value))
+            {
+              _gtk_css_value_unref (style->values[i]);
+              style->values[i] = _gtk_css_value_ref (parent_value);
+            }
+        }
+    }
+
+  for (i = 0; i < GTK_CSS_VALUE_GROUP_N_GROUPS; i++)
+    {
+      g_assert (value_group_kinds[i].n_properties <= G_N_ELEMENTS (values));
+
+      for (j = 0; j < value_group_kinds[i].n_properties; j++)
+        values[j] = style->values[value_group_kinds[i].properties[j]];
+
+      style->groups[i] = gtk_css_value_group_new (i, values);
+    }
+
+  g_free (style->values);
+  style->values = NULL;
+}
+
+/**
+ * gtk_css_static_style_report_memory:
+ *
+ * Prints how many styles and value groups exist and how much memory
+ * they use, compared to storing all values in every style. Nothing is
+ * printed if the numbers didn't change since the last report.
+ */
+void
+gtk_css_static_style_report_memory (void)
+{
+  static guint last_n_styles, last_n_groups;
+  static gsize last_group_bytes;
+  GString *kinds;
+  gsize group_bytes;
+  guint i, n_styles, n_groups;
+
+  kinds = g_string_new (NULL);
+  group_bytes = 0;
+  n_groups = 0;
+
+  G_LOCK (value_groups);
+
+  n_styles = n_static_styles;
+  for (i = 0; i < GTK_CSS_VALUE_GROUP_N_GROUPS; i++)
+    {
+      n_groups += n_value_groups[i];
+      group_bytes += n_value_groups[i] * gtk_css_value_group_size (i);
+      g_string_append_printf (kinds, " %s %u", value_group_kinds[i].name, n_value_groups[i]);
+    }
+
+  G_UNLOCK (value_groups);
+
+  if (n_styles != last_n_styles ||
+      n_groups != last_n_groups ||
+      group_bytes != last_group_bytes)
+    {
+      g_message ("CSS styles: %u styles, %u value groups, %" G_GSIZE_FORMAT " bytes "
+                 "(%" G_GSIZE_FORMAT " bytes without sharing); groups:%s",
+                 n_styles, n_groups, group_bytes,
+                 (gsize) n_styles * GTK_CSS_PROPERTY_N_PROPERTIES * sizeof (GtkCssValue *),
+                 kinds->str);
+
+      last_n_styles = n_styles;
+      last_n_groups = n_groups;
+      last_group_bytes = group_bytes;
+    }
+
+  g_string_free (kinds, TRUE);
+}
+
 static GtkCssStyle *default_style;
 
 static void
@@ -185,6 +628,7 @@ gtk_css_static_style_new_compute (GtkStyleProviderPrivate *provider,
   result = g_object_new (GTK_TYPE_CSS_STATIC_STYLE, NULL);
 
   result->change = change;
+  result->values = g_new0 (GtkCssValue *, GTK_CSS_PROPERTY_N_PROPERTIES);
 
   _gtk_css_lookup_resolve (lookup,
                            provider,
@@ -193,6 +637,8 @@ gtk_css_static_style_new_compute (GtkStyleProviderPrivate *provider,
 
   _gtk_css_lookup_free (lookup);
 
+  gtk_css_static_style_seal (result, parent);
+
   return GTK_CSS_STYLE (result);
 }
 
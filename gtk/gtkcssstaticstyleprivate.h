@@ -34,12 +34,31 @@ G_BEGIN_DECLS
 
 typedef struct _GtkCssStaticStyle           GtkCssStaticStyle;
 typedef struct _GtkCssStaticStyleClass      GtkCssStaticStyleClass;
+typedef struct _GtkCssValueGroup            GtkCssValueGroup;
+
+/* Properties that usually change together. The values of each group are
+ * shared between all styles that have the same values for it. */
+typedef enum {
+  GTK_CSS_VALUE_GROUP_CORE,
+  GTK_CSS_VALUE_GROUP_FONT,
+  GTK_CSS_VALUE_GROUP_TEXT_DECORATION,
+  GTK_CSS_VALUE_GROUP_BACKGROUND,
+  GTK_CSS_VALUE_GROUP_SIZE,
+  GTK_CSS_VALUE_GROUP_BORDER,
+  GTK_CSS_VALUE_GROUP_OUTLINE,
+  GTK_CSS_VALUE_GROUP_ICON,
+  GTK_CSS_VALUE_GROUP_TRANSITION,
+  GTK_CSS_VALUE_GROUP_ANIMATION,
+  GTK_CSS_VALUE_GROUP_OTHER,
+  GTK_CSS_VALUE_GROUP_N_GROUPS
+} GtkCssValueGroupKind;
 
 struct _GtkCssStaticStyle
 {
   GtkCssStyle parent;
 
-  GtkCssValue           *values[GTK_CSS_PROPERTY_N_PROPERTIES]; /* the values */
+  GtkCssValueGroup      *groups[GTK_CSS_VALUE_GROUP_N_GROUPS]; /* the values, shared with other styles */
+  GtkCssValue          **values;               /* the values while they are computed, NULL afterwards */
   GPtrArray             *sections;             /* sections the values are defined in */
 
   GtkCssChange           change;               /* change as returned by value lookup */
@@ -66,6 +85,8 @@ void                    gtk_css_static_style_compute_value      (GtkCssStaticSty
 
 GtkCssChange            gtk_css_static_style_get_change         (GtkCssStaticStyle      *style);
 
+void                    gtk_css_static_style_report_memory      (void);
+
 G_END_DECLS
 
 #endif /* __GTK_CSS_STATIC_STYLE_PRIVATE_H__ */
@@ -48,7 +48,8 @@ _gtk_css_value_ref (GtkCssValue *value)
 {
   gtk_internal_return_val_if_fail (value != NULL, NULL);
 
-  value->ref_count += 1;
+  /* Styles can be computed on multiple threads at once */
+  g_atomic_int_inc (&value->ref_count);
 
   return value;
 }
@@ -59,8 +60,7 @@ _gtk_css_value_unref (GtkCssValue *value)
   if (value == NULL)
     return;
 
-  value->ref_count -= 1;
-  if (value->ref_count > 0)
+  if (!g_atomic_int_dec_and_test (&value->ref_count))
     return;
 
   value->class->free (value);
@@ -54,7 +54,12 @@ typedef enum {
   GTK_DEBUG_ACTIONS         = 1 << 16,
   GTK_DEBUG_RESIZE          = 1 << 17,
   GTK_DEBUG_LAYOUT          = 1 << 18,
-  GTK_DEBUG_SNAPSHOT        = 1 << 19
+  GTK_DEBUG_SNAPSHOT        = 1 << 19,
+  GTK_DEBUG_NO_NODE_CACHE   = 1 << 20,
+  GTK_DEBUG_NO_NODE_ARENA   = 1 << 21,
+  GTK_DEBUG_NO_CSS_BLOOM    = 1 << 22,
+  GTK_DEBUG_STYLES          = 1 << 23,
+  GTK_DEBUG_NO_CSS_THREADS  = 1 << 24
 } GtkDebugFlag;
 
 #ifdef G_ENABLE_DEBUG
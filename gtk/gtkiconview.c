@@ -131,6 +131,7 @@ enum
 /* GObject vfuncs */
 static void             gtk_icon_view_cell_layout_init          (GtkCellLayoutIface *iface);
 static void             gtk_icon_view_dispose                   (GObject            *object);
+static void             gtk_icon_view_finalize                  (GObject            *object);
 static void             gtk_icon_view_constructed               (GObject            *object);
 static void             gtk_icon_view_set_property              (GObject            *object,
 								 guint               prop_id,
@@ -351,6 +352,7 @@ gtk_icon_view_class_init (GtkIconViewClass *klass)
 
   gobject_class->constructed = gtk_icon_view_constructed;
   gobject_class->dispose = gtk_icon_view_dispose;
+  gobject_class->finalize = gtk_icon_view_finalize;
   gobject_class->set_property = gtk_icon_view_set_property;
   gobject_class->get_property = gtk_icon_view_get_property;
 
@@ -935,6 +937,14 @@ gtk_icon_view_cell_layout_init (GtkCellLayoutIface *iface)
   iface->get_area = gtk_icon_view_cell_layout_get_area;
 }
 
+static void
+gtk_icon_view_row_clear (gpointer data)
+{
+  GtkIconViewRow *row = data;
+
+  g_clear_object (&row->context);
+}
+
 static void
 gtk_icon_view_init (GtkIconView *icon_view)
 {
@@ -971,8 +981,10 @@ gtk_icon_view_init (GtkIconView *icon_view)
 
   icon_view->priv->draw_focus = TRUE;
 
-  icon_view->priv->row_contexts = 
-    g_ptr_array_new_with_free_func ((GDestroyNotify)g_object_unref);
+  icon_view->priv->rows = g_array_new (FALSE, TRUE, sizeof (GtkIconViewRow));
+  g_array_set_clear_func (icon_view->priv->rows, gtk_icon_view_row_clear);
+  icon_view->priv->estimated_min_height = -1;
+  icon_view->priv->estimated_nat_height = -1;
 
   gtk_style_context_add_class (gtk_widget_get_style_context (GTK_WIDGET (icon_view)),
                                GTK_STYLE_CLASS_VIEW);
@@ -1011,10 +1023,12 @@ gtk_icon_view_dispose (GObject *object)
       priv->cell_area_context = NULL;
     }
 
-  if (priv->row_contexts)
+  g_array_set_size (priv->rows, 0);
+
+  if (priv->relayout_id)
     {
-      g_ptr_array_free (priv->row_contexts, TRUE);
-      priv->row_contexts = NULL;
+      g_source_remove (priv->relayout_id);
+      priv->relayout_id = 0;
     }
 
   if (priv->cell_area)
@@ -1035,6 +1049,16 @@ gtk_icon_view_dispose (GObject *object)
   G_OBJECT_CLASS (gtk_icon_view_parent_class)->dispose (object);
 }
 
+static void
+gtk_icon_view_finalize (GObject *object)
+{
+  GtkIconView *icon_view = GTK_ICON_VIEW (object);
+
+  g_array_free (icon_view->priv->rows, TRUE);
+
+  G_OBJECT_CLASS (gtk_icon_view_parent_class)->finalize (object);
+}
+
 static void
 gtk_icon_view_set_property (GObject      *object,
 			    guint         prop_id,
@@ -1273,12 +1297,13 @@ gtk_icon_view_get_n_items (GtkIconView *icon_view)
   return gtk_tree_model_iter_n_children (priv->model, NULL);
 }
 
-static void
+/* Returns whether the wrap width changed */
+static gboolean
 adjust_wrap_width (GtkIconView *icon_view)
 {
   if (icon_view->priv->text_cell)
     {
-      gint pixbuf_width, wrap_width;
+      gint pixbuf_width, wrap_width, old_wrap_width;
 
       if (icon_view->priv->items && icon_view->priv->pixbuf_cell)
         {
@@ -1318,9 +1343,14 @@ adjust_wrap_width (GtkIconView *icon_view)
 	  wrap_width = MAX (wrap_width * 2, 50);
 	}
       
+      g_object_get (icon_view->priv->text_cell, "wrap-width", &old_wrap_width, NULL);
       g_object_set (icon_view->priv->text_cell, "wrap-width", wrap_width, NULL);
       g_object_set (icon_view->priv->text_cell, "width", wrap_width, NULL);
+
+      return wrap_width != old_wrap_width;
     }
+
+  return FALSE;
 }
 
 /* General notes about layout
@@ -1392,6 +1422,158 @@ gtk_icon_view_is_empty (GtkIconView *icon_view)
   return icon_view->priv->items == NULL;
 }
 
+/* Item sizes are cached, so that a relayout only measures the items
+ * that changed and the rows around the visible area:
+ *
+ * The widths of all items are collected in priv->cell_area_context.
+ * Items are added to it when they are created or changed. It can't
+ * shrink, so like with tree view columns, it is reset and all items
+ * are measured again when an item that may be the widest one is
+ * removed or changed.
+ *
+ * Every item remembers its height for the width it was last laid out
+ * with. The layout measures the rows near the visible area and uses
+ * the remembered heights, or the average height of the measured items,
+ * for all other rows.
+ */
+static void
+gtk_icon_view_ensure_item_widths (GtkIconView *icon_view)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  GtkIconViewItem *item;
+  GList *items;
+
+  if (priv->widths_valid)
+    return;
+
+  /* The wrap width is guessed from the first item, and all sizes
+   * depend on it */
+  item = priv->items->data;
+  if (!item->width_measured)
+    {
+      _gtk_icon_view_set_cell_data (icon_view, item);
+      if (adjust_wrap_width (icon_view))
+        {
+          gtk_cell_area_context_reset (priv->cell_area_context);
+          g_list_foreach (priv->items, (GFunc) gtk_icon_view_item_invalidate_size, NULL);
+        }
+    }
+
+  for (items = priv->items; items; items = items->next)
+    {
+      gint old_min, old_nat, min, nat;
+
+      item = items->data;
+
+      if (item->width_measured)
+        continue;
+
+      gtk_cell_area_context_get_preferred_width (priv->cell_area_context, &old_min, &old_nat);
+
+      _gtk_icon_view_set_cell_data (icon_view, item);
+      gtk_cell_area_get_preferred_width (priv->cell_area,
+                                         priv->cell_area_context,
+                                         GTK_WIDGET (icon_view),
+                                         NULL, NULL);
+      item->width_measured = TRUE;
+
+      gtk_cell_area_context_get_preferred_width (priv->cell_area_context, &min, &nat);
+      item->min_width = min > old_min ? min : 0;
+      item->nat_width = nat > old_nat ? nat : 0;
+    }
+
+  priv->widths_valid = TRUE;
+}
+
+/* Whether the width context may be as wide as it is because of @item.
+ * This is the case if the item made it grow and it didn't grow since.
+ */
+static gboolean
+gtk_icon_view_item_may_be_widest (GtkIconView     *icon_view,
+                                  GtkIconViewItem *item)
+{
+  gint min, nat;
+
+  if (!item->width_measured)
+    return FALSE;
+
+  gtk_cell_area_context_get_preferred_width (icon_view->priv->cell_area_context, &min, &nat);
+
+  return (item->min_width > 0 && item->min_width >= min) ||
+         (item->nat_width > 0 && item->nat_width >= nat);
+}
+
+/* Makes the next size request measure the widths of all items again,
+ * so that the width context can shrink */
+static void
+gtk_icon_view_invalidate_item_widths (GtkIconView *icon_view)
+{
+  GList *items;
+
+  gtk_cell_area_context_reset (icon_view->priv->cell_area_context);
+
+  for (items = icon_view->priv->items; items; items = items->next)
+    {
+      GtkIconViewItem *item = items->data;
+
+      item->width_measured = FALSE;
+    }
+
+  icon_view->priv->widths_valid = FALSE;
+}
+
+/* Returns the largest height of all items, using the estimate for the
+ * items that haven't been measured yet. The heights were measured for
+ * the width the items were laid out with, not for @for_size. */
+static void
+gtk_icon_view_get_cached_item_height (GtkIconView *icon_view,
+                                      gint         for_size,
+                                      gint        *minimum,
+                                      gint        *natural)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  gboolean unmeasured = FALSE;
+  GList *items;
+  gint min = 0, nat = 0;
+
+  for (items = priv->items; items; items = items->next)
+    {
+      GtkIconViewItem *item = items->data;
+
+      if (item->min_height < 0)
+        {
+          unmeasured = TRUE;
+          continue;
+        }
+
+      min = MAX (min, item->min_height);
+      nat = MAX (nat, item->nat_height);
+    }
+
+  if (unmeasured)
+    {
+      if (priv->estimated_min_height < 0)
+        {
+          GtkCellAreaContext *context;
+
+          context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
+          _gtk_icon_view_set_cell_data (icon_view, priv->items->data);
+          cell_area_get_preferred_size (icon_view, context, GTK_ORIENTATION_VERTICAL, for_size,
+                                        &priv->estimated_min_height,
+                                        &priv->estimated_nat_height);
+          g_object_unref (context);
+        }
+
+      min = MAX (min, priv->estimated_min_height);
+      nat = MAX (nat, priv->estimated_nat_height);
+    }
+
+  if (minimum)
+    *minimum = min;
+  if (natural)
+    *natural = nat;
+}
+
 static void
 gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
                                        GtkOrientation  orientation,
@@ -1405,51 +1587,42 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
 
   g_assert (!gtk_icon_view_is_empty (icon_view));
 
-  context = gtk_cell_area_create_context (priv->cell_area);
+  gtk_icon_view_ensure_item_widths (icon_view);
 
   for_size -= 2 * priv->item_padding;
 
-  if (for_size > 0)
+  if (orientation == GTK_ORIENTATION_VERTICAL)
     {
+      gtk_icon_view_get_cached_item_height (icon_view, for_size, minimum, natural);
+    }
+  else if (for_size <= 0)
+    {
+      gtk_cell_area_context_get_preferred_width (priv->cell_area_context,
+                                                 minimum, natural);
+    }
+  else
+    {
+      /* Widths for a given height aren't cached, icon views are
+       * laid out height-for-width */
+      context = gtk_cell_area_create_context (priv->cell_area);
+
       /* This is necessary for the context to work properly */
       for (items = priv->items; items; items = items->next)
         {
-          GtkIconViewItem *item = items->data;
-
-          _gtk_icon_view_set_cell_data (icon_view, item);
-          cell_area_get_preferred_size (icon_view, context, 1 - orientation, -1, NULL, NULL);
+          _gtk_icon_view_set_cell_data (icon_view, items->data);
+          cell_area_get_preferred_size (icon_view, context, GTK_ORIENTATION_VERTICAL, -1, NULL, NULL);
         }
-    }
 
-  for (items = priv->items; items; items = items->next)
-    {
-      GtkIconViewItem *item = items->data;
+      for (items = priv->items; items; items = items->next)
+        {
+          _gtk_icon_view_set_cell_data (icon_view, items->data);
+          cell_area_get_preferred_size (icon_view, context, orientation, for_size, NULL, NULL);
+        }
 
-      _gtk_icon_view_set_cell_data (icon_view, item);
-      if (items == priv->items)
-        adjust_wrap_width (icon_view);
-      cell_area_get_preferred_size (icon_view, context, orientation, for_size, NULL, NULL);
-    }
-
-  if (orientation == GTK_ORIENTATION_HORIZONTAL)
-    {
-      if (for_size > 0)
-        gtk_cell_area_context_get_preferred_width_for_height (context,
-                                                              for_size,
-                                                              minimum, natural);
-      else
-        gtk_cell_area_context_get_preferred_width (context,
-                                                   minimum, natural);
-    }
-  else
-    {
-      if (for_size > 0)
-        gtk_cell_area_context_get_preferred_height_for_width (context,
-                                                              for_size,
-                                                              minimum, natural);
-      else
-        gtk_cell_area_context_get_preferred_height (context,
-                                                    minimum, natural);
+      gtk_cell_area_context_get_preferred_width_for_height (context,
+                                                            for_size,
+                                                            minimum, natural);
+      g_object_unref (context);
     }
 
   if (orientation == GTK_ORIENTATION_HORIZONTAL && priv->item_width >= 0)
@@ -1464,8 +1637,6 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
     *minimum = MAX (1, *minimum + 2 * priv->item_padding);
   if (natural)
     *natural = MAX (1, *natural + 2 * priv->item_padding);
-
-  g_object_unref (context);
 }
 
 static void
@@ -2057,7 +2228,7 @@ gtk_icon_view_set_cursor (GtkIconView     *icon_view,
     {
       GtkCellAreaContext *context;
 
-      context = g_ptr_array_index (icon_view->priv->row_contexts, item->row);
+      context = _gtk_icon_view_get_item_context (icon_view, item);
       _gtk_icon_view_set_cell_data (icon_view, item);
       gtk_cell_area_activate (icon_view->priv->cell_area, context, 
 			      GTK_WIDGET (icon_view), &item->cell_area, 
@@ -2217,7 +2388,7 @@ gtk_icon_view_button_press (GtkGestureMultiPress *gesture,
 	    {
 	      GtkCellAreaContext *context;
 
-	      context = g_ptr_array_index (icon_view->priv->row_contexts, item->row);
+	      context = _gtk_icon_view_get_item_context (icon_view, item);
 
 	      _gtk_icon_view_set_cell_data (icon_view, item);
 	      gtk_cell_area_activate (icon_view->priv->cell_area, context,
@@ -2497,7 +2668,7 @@ gtk_icon_view_item_hit_test (GtkIconView      *icon_view,
       MIN (y + height, item_area->y + item_area->height) - MAX (y, item_area->y) <= 0)
     return FALSE;
 
-  context = g_ptr_array_index (icon_view->priv->row_contexts, item->row);
+  context = _gtk_icon_view_get_item_context (icon_view, item);
 
   _gtk_icon_view_set_cell_data (icon_view, item);
   gtk_cell_area_foreach_alloc (icon_view->priv->cell_area, context,
@@ -2565,7 +2736,7 @@ gtk_icon_view_real_activate_cursor_item (GtkIconView *icon_view)
   if (!icon_view->priv->cursor_item)
     return FALSE;
 
-  context = g_ptr_array_index (icon_view->priv->row_contexts, icon_view->priv->cursor_item->row);
+  context = _gtk_icon_view_get_item_context (icon_view, icon_view->priv->cursor_item);
 
   _gtk_icon_view_set_cell_data (icon_view, icon_view->priv->cursor_item);
   gtk_cell_area_activate (icon_view->priv->cell_area, context,
@@ -2731,18 +2902,54 @@ gtk_icon_view_set_vadjustment (GtkIconView   *icon_view,
   g_object_notify (G_OBJECT (icon_view), "vadjustment");
 }
 
+static gboolean
+gtk_icon_view_relayout_idle (gpointer data)
+{
+  GtkIconView *icon_view = data;
+
+  icon_view->priv->relayout_id = 0;
+  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Lays out the icon view again with the sizes measured during the
+ * last layout. This can't queue a resize directly, because it happens
+ * during size allocation. */
+static void
+gtk_icon_view_queue_relayout (GtkIconView *icon_view)
+{
+  if (icon_view->priv->relayout_id != 0)
+    return;
+
+  icon_view->priv->relayout_id = gdk_threads_add_idle (gtk_icon_view_relayout_idle, icon_view);
+  g_source_set_name_by_id (icon_view->priv->relayout_id, "[gtk+] gtk_icon_view_relayout_idle");
+}
+
 static void
 gtk_icon_view_adjustment_changed (GtkAdjustment *adjustment,
                                   GtkIconView   *icon_view)
 {
+  GtkIconViewPrivate *priv = icon_view->priv;
+
   if (gtk_widget_get_realized (GTK_WIDGET (icon_view)))
     {
-      if (icon_view->priv->doing_rubberband)
+      if (priv->doing_rubberband)
         gtk_icon_view_update_rubberband (icon_view);
 
       _gtk_icon_view_accessible_adjustment_changed (icon_view);
     }
 
+  /* Rows that scroll into view may only have estimated heights */
+  if (priv->estimated_rows)
+    {
+      gdouble value = gtk_adjustment_get_value (priv->vadjustment);
+
+      if (value < priv->measured_y1 ||
+          value + gtk_adjustment_get_page_size (priv->vadjustment) > priv->measured_y2)
+        gtk_icon_view_queue_relayout (icon_view);
+    }
+
   gtk_widget_queue_draw (GTK_WIDGET (icon_view));
 }
 
@@ -2760,12 +2967,14 @@ gtk_icon_view_layout (GtkIconView *icon_view)
 {
   GtkIconViewPrivate *priv = icon_view->priv;
   GtkWidget *widget = GTK_WIDGET (icon_view);
-  GList *items;
+  GList *items, *row_items;
   gint item_width; /* this doesn't include item_padding */
   gint n_columns, n_rows, n_items;
   gint col, row;
+  gint n_measured, measured_min, measured_nat;
   GtkRequestedSize *sizes;
-  gboolean rtl;
+  gboolean rtl, estimated, replaced_estimates;
+  gdouble value;
   int width, height;
 
   if (gtk_icon_view_is_empty (icon_view))
@@ -2776,60 +2985,113 @@ gtk_icon_view_layout (GtkIconView *icon_view)
 
   gtk_widget_get_content_size (widget, &width, &height);
 
+  /* This measures the widths of new and changed items */
   gtk_icon_view_compute_n_items_for_size (icon_view, 
                                           GTK_ORIENTATION_HORIZONTAL,
                                           width,
                                           NULL, NULL,
                                           &n_columns, &item_width);
   n_rows = (n_items + n_columns - 1) / n_columns;
+  priv->n_columns = n_columns;
 
   priv->width = n_columns * (item_width + 2 * priv->item_padding + priv->column_spacing) - priv->column_spacing;
   priv->width += 2 * priv->margin;
   priv->width = MAX (priv->width, width);
 
   /* Clear the per row contexts */
-  g_ptr_array_set_size (icon_view->priv->row_contexts, 0);
+  g_array_set_size (priv->rows, 0);
+  g_array_set_size (priv->rows, n_rows);
 
-  gtk_cell_area_context_reset (priv->cell_area_context);
-  /* because layouting is complicated. We designed an API
-   * that is O(N²) and nonsensical.
-   * And we're proud of it. */
-  for (items = priv->items; items; items = items->next)
-    {
-      _gtk_icon_view_set_cell_data (icon_view, items->data);
-      gtk_cell_area_get_preferred_width (priv->cell_area,
-                                         priv->cell_area_context,
-                                         widget,
-                                         NULL, NULL);
-    }
+  /* Rows within a page of the visible area are measured, the others
+   * get their heights from the cache */
+  value = gtk_adjustment_get_value (priv->vadjustment);
+  priv->measured_y1 = value - height;
+  priv->measured_y2 = value + 2 * height;
+  priv->estimated_rows = FALSE;
 
-  sizes = g_newa (GtkRequestedSize, n_rows);
+  sizes = g_new (GtkRequestedSize, n_rows);
   items = priv->items;
   priv->height = priv->margin;
+  n_measured = measured_min = measured_nat = 0;
+  replaced_estimates = FALSE;
 
   /* Collect the heights for all rows */
   for (row = 0; row < n_rows; row++)
     {
-      GtkCellAreaContext *context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
-      g_ptr_array_add (priv->row_contexts, context);
+      GtkIconViewRow *icon_row = &g_array_index (priv->rows, GtkIconViewRow, row);
+      gboolean unmeasured = FALSE;
+
+      icon_row->items = row_items = items;
+      estimated = FALSE;
+
+      sizes[row].data = GINT_TO_POINTER (row);
+      sizes[row].minimum_size = 0;
+      sizes[row].natural_size = 0;
 
       for (col = 0; col < n_columns && items; col++, items = items->next)
         {
           GtkIconViewItem *item = items->data;
 
-          _gtk_icon_view_set_cell_data (icon_view, item);
-          gtk_cell_area_get_preferred_height_for_width (priv->cell_area,
-                                                        context,
-                                                        widget,
-                                                        item_width, 
-                                                        NULL, NULL);
+          if (item->height_for_width != item_width)
+            estimated = TRUE;
+
+          if (item->min_height >= 0)
+            {
+              sizes[row].minimum_size = MAX (sizes[row].minimum_size, item->min_height);
+              sizes[row].natural_size = MAX (sizes[row].natural_size, item->nat_height);
+            }
+          else if (priv->estimated_min_height >= 0)
+            {
+              sizes[row].minimum_size = MAX (sizes[row].minimum_size, priv->estimated_min_height);
+              sizes[row].natural_size = MAX (sizes[row].natural_size, priv->estimated_nat_height);
+              unmeasured = TRUE;
+            }
+          else
+            unmeasured = TRUE;
         }
-      
-      sizes[row].data = GINT_TO_POINTER (row);
-      gtk_cell_area_context_get_preferred_height_for_width (context,
-                                                            item_width,
-                                                            &sizes[row].minimum_size,
-                                                            &sizes[row].natural_size);
+
+      if ((unmeasured && priv->estimated_min_height < 0) ||
+          (priv->height <= priv->measured_y2 &&
+           priv->height + sizes[row].minimum_size + 2 * priv->item_padding >= priv->measured_y1))
+        {
+          GtkCellAreaContext *context;
+
+          context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
+          icon_row->context = context;
+
+          for (items = row_items, col = 0; col < n_columns && items; col++, items = items->next)
+            {
+              GtkIconViewItem *item = items->data;
+
+              _gtk_icon_view_set_cell_data (icon_view, item);
+              gtk_cell_area_get_preferred_height_for_width (priv->cell_area,
+                                                            context,
+                                                            widget,
+                                                            item_width, 
+                                                            &item->min_height,
+                                                            &item->nat_height);
+              item->height_for_width = item_width;
+
+              n_measured++;
+              measured_min += item->min_height;
+              measured_nat += item->nat_height;
+            }
+
+          gtk_cell_area_context_get_preferred_height_for_width (context,
+                                                                item_width,
+                                                                &sizes[row].minimum_size,
+                                                                &sizes[row].natural_size);
+
+          /* The size request was made with estimated heights */
+          if (estimated)
+            replaced_estimates = TRUE;
+
+          priv->estimated_min_height = measured_min / n_measured;
+          priv->estimated_nat_height = measured_nat / n_measured;
+        }
+      else if (estimated)
+        priv->estimated_rows = TRUE;
+
       priv->height += sizes[row].minimum_size + 2 * priv->item_padding + priv->row_spacing;
     }
 
@@ -2849,8 +3111,11 @@ gtk_icon_view_layout (GtkIconView *icon_view)
 
   for (row = 0; row < n_rows; row++)
     {
-      GtkCellAreaContext *context = g_ptr_array_index (priv->row_contexts, row);
-      gtk_cell_area_context_allocate (context, item_width, sizes[row].minimum_size);
+      GtkIconViewRow *icon_row = &g_array_index (priv->rows, GtkIconViewRow, row);
+
+      /* Rows that weren't measured get their context when it's needed */
+      if (icon_row->context)
+        gtk_cell_area_context_allocate (icon_row->context, item_width, sizes[row].minimum_size);
 
       priv->height += priv->item_padding;
 
@@ -2877,14 +3142,59 @@ gtk_icon_view_layout (GtkIconView *icon_view)
   priv->height -= priv->row_spacing;
   priv->height += priv->margin;
   priv->height = MAX (priv->height, height);
+
+  g_free (sizes);
+
+  if (replaced_estimates)
+    gtk_icon_view_queue_relayout (icon_view);
+}
+
+/* Returns the context of the row that @item is in. Rows that were only
+ * estimated during the layout are measured now, which changes the cell
+ * data, so callers set the cell data of @item afterwards. */
+GtkCellAreaContext *
+_gtk_icon_view_get_item_context (GtkIconView     *icon_view,
+                                 GtkIconViewItem *item)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  GtkIconViewRow *row;
+  GList *items;
+  gint col;
+
+  /* The rows are cleared when the model changes, until the next layout */
+  if (item->row >= priv->rows->len || item->cell_area.width < 0)
+    return priv->cell_area_context;
+
+  row = &g_array_index (priv->rows, GtkIconViewRow, item->row);
+  if (row->context == NULL)
+    {
+      row->context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
+
+      for (items = row->items, col = 0; col < priv->n_columns && items; col++, items = items->next)
+        {
+          _gtk_icon_view_set_cell_data (icon_view, items->data);
+          gtk_cell_area_get_preferred_height_for_width (priv->cell_area,
+                                                        row->context,
+                                                        GTK_WIDGET (icon_view),
+                                                        item->cell_area.width,
+                                                        NULL, NULL);
+        }
+
+      gtk_cell_area_context_allocate (row->context, item->cell_area.width, item->cell_area.height);
+    }
+
+  return row->context;
 }
 
 static void
 gtk_icon_view_invalidate_sizes (GtkIconView *icon_view)
 {
   /* Clear all item sizes */
+  if (icon_view->priv->cell_area_context)
+    gtk_cell_area_context_reset (icon_view->priv->cell_area_context);
   g_list_foreach (icon_view->priv->items,
 		  (GFunc)gtk_icon_view_item_invalidate_size, NULL);
+  icon_view->priv->widths_valid = FALSE;
 
   /* Re-layout the items */
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
@@ -2895,6 +3205,8 @@ gtk_icon_view_item_invalidate_size (GtkIconViewItem *item)
 {
   item->cell_area.width = -1;
   item->cell_area.height = -1;
+  item->width_measured = FALSE;
+  item->height_for_width = -1;
 }
 
 static void
@@ -2916,6 +3228,7 @@ gtk_icon_view_snapshot_item (GtkIconView     *icon_view,
   if (priv->model == NULL || item->cell_area.width <= 0 || item->cell_area.height <= 0)
     return;
 
+  context = _gtk_icon_view_get_item_context (icon_view, item);
   _gtk_icon_view_set_cell_data (icon_view, item);
 
   style_context = gtk_widget_get_style_context (widget);
@@ -2960,7 +3273,6 @@ gtk_icon_view_snapshot_item (GtkIconView     *icon_view,
   cell_area.width  = item->cell_area.width;
   cell_area.height = item->cell_area.height;
 
-  context = g_ptr_array_index (priv->row_contexts, item->row);
   gtk_cell_area_snapshot (priv->cell_area, context,
                           widget, snapshot, &cell_area, &cell_area, flags,
                           draw_focus);
@@ -3091,6 +3403,8 @@ gtk_icon_view_item_new (void)
 
   item->cell_area.width  = -1;
   item->cell_area.height = -1;
+  item->min_height = -1;
+  item->height_for_width = -1;
   
   return item;
 }
@@ -3130,7 +3444,7 @@ _gtk_icon_view_get_item_at_coords (GtkIconView          *icon_view,
 	      GtkCellRenderer *cell = NULL;
 	      GtkCellAreaContext *context;
 
-	      context = g_ptr_array_index (icon_view->priv->row_contexts, item->row);
+	      context = _gtk_icon_view_get_item_context (icon_view, item);
 	      _gtk_icon_view_set_cell_data (icon_view, item);
 
 	      if (x >= item_area->x && x <= item_area->x + item_area->width &&
@@ -3218,6 +3532,16 @@ verify_items (GtkIconView *icon_view)
     }
 }
 
+/* Makes the next size request guess the wrap width again */
+static void
+gtk_icon_view_first_item_changed (GtkIconView *icon_view)
+{
+  GtkIconViewItem *item = icon_view->priv->items->data;
+
+  item->width_measured = FALSE;
+  icon_view->priv->widths_valid = FALSE;
+}
+
 static void
 gtk_icon_view_row_changed (GtkTreeModel *model,
                            GtkTreePath  *path,
@@ -3225,6 +3549,7 @@ gtk_icon_view_row_changed (GtkTreeModel *model,
                            gpointer      data)
 {
   GtkIconView *icon_view = GTK_ICON_VIEW (data);
+  GtkIconViewItem *item;
 
   /* ignore changes in branches */
   if (gtk_tree_path_get_depth (path) > 1)
@@ -3237,15 +3562,15 @@ gtk_icon_view_row_changed (GtkTreeModel *model,
   if (icon_view->priv->cell_area)
     gtk_cell_area_stop_editing (icon_view->priv->cell_area, TRUE);
 
-  /* Here we can use a "grow-only" strategy for optimization
-   * and only invalidate a single item and queue a relayout
-   * instead of invalidating the whole thing.
-   *
-   * For now GtkIconView still cant deal with huge models
-   * so just invalidate the whole thing when the model
-   * changes.
-   */
-  gtk_icon_view_invalidate_sizes (icon_view);
+  /* The width context is "grow-only", so only the changed item
+   * needs to be measured again, unless it was the widest one */
+  item = g_list_nth_data (icon_view->priv->items, gtk_tree_path_get_indices (path)[0]);
+  if (gtk_icon_view_item_may_be_widest (icon_view, item))
+    gtk_icon_view_invalidate_item_widths (icon_view);
+  gtk_icon_view_item_invalidate_size (item);
+  icon_view->priv->widths_valid = FALSE;
+
+  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 
   verify_items (icon_view);
 }
@@ -3288,6 +3613,10 @@ gtk_icon_view_row_inserted (GtkTreeModel *model,
     
   verify_items (icon_view);
 
+  /* The rows point into the item list */
+  g_array_set_size (icon_view->priv->rows, 0);
+  icon_view->priv->widths_valid = FALSE;
+
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 }
 
@@ -3325,6 +3654,9 @@ gtk_icon_view_row_deleted (GtkTreeModel *model,
 
   if (item->selected)
     emit = TRUE;
+
+  if (gtk_icon_view_item_may_be_widest (icon_view, item))
+    gtk_icon_view_invalidate_item_widths (icon_view);
   
   gtk_icon_view_item_free (item);
 
@@ -3338,6 +3670,12 @@ gtk_icon_view_row_deleted (GtkTreeModel *model,
   icon_view->priv->items = g_list_delete_link (icon_view->priv->items, list);
 
   verify_items (icon_view);  
+
+  g_array_set_size (icon_view->priv->rows, 0);
+
+  /* The wrap width is guessed from the first item */
+  if (index == 0 && icon_view->priv->items)
+    gtk_icon_view_first_item_changed (icon_view);
   
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 
@@ -3387,6 +3725,10 @@ gtk_icon_view_rows_reordered (GtkTreeModel *model,
   g_list_free (icon_view->priv->items);
   icon_view->priv->items = items;
 
+  g_array_set_size (icon_view->priv->rows, 0);
+  if (items)
+    gtk_icon_view_first_item_changed (icon_view);
+
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 
   verify_items (icon_view);  
@@ -3418,6 +3760,7 @@ gtk_icon_view_build_items (GtkIconView *icon_view)
     } while (gtk_tree_model_iter_next (icon_view->priv->model, &iter));
 
   icon_view->priv->items = g_list_reverse (items);
+  icon_view->priv->widths_valid = FALSE;
 }
 
 static void
@@ -4306,7 +4649,7 @@ gtk_icon_view_get_cell_rect (GtkIconView     *icon_view,
     {
       GtkCellAreaContext *context;
 
-      context = g_ptr_array_index (icon_view->priv->row_contexts, item->row);
+      context = _gtk_icon_view_get_item_context (icon_view, item);
       _gtk_icon_view_set_cell_data (icon_view, item);
       gtk_cell_area_get_cell_allocation (icon_view->priv->cell_area, context,
 					 GTK_WIDGET (icon_view),
@@ -4782,6 +5125,12 @@ gtk_icon_view_set_model (GtkIconView *icon_view,
       icon_view->priv->last_prelight = NULL;
       icon_view->priv->width = 0;
       icon_view->priv->height = 0;
+
+      g_array_set_size (icon_view->priv->rows, 0);
+      if (icon_view->priv->cell_area_context)
+        gtk_cell_area_context_reset (icon_view->priv->cell_area_context);
+      icon_view->priv->estimated_min_height = -1;
+      icon_view->priv->estimated_nat_height = -1;
     }
 
   icon_view->priv->model = model;
@@ -31,9 +31,29 @@ struct _GtkIconViewItem
 
   gint row, col;
 
+  /* The height last measured for the item and the width it was
+   * measured for, see gtk_icon_view_layout(). min_height is -1 if
+   * the item hasn't been measured yet.
+   */
+  gint min_height, nat_height;
+  gint height_for_width;
+
+  /* The widths of the width context after measuring the item, if the
+   * item made them grow, or 0. See gtk_icon_view_item_may_be_widest().
+   */
+  gint min_width, nat_width;
+
   guint selected : 1;
   guint selected_before_rubberbanding : 1;
+  guint width_measured : 1;
+
+};
 
+typedef struct _GtkIconViewRow GtkIconViewRow;
+struct _GtkIconViewRow
+{
+  GList *items;                 /* the first item in the row */
+  GtkCellAreaContext *context;  /* created when the row is measured or drawn */
 };
 
 struct _GtkIconViewPrivate
@@ -45,7 +65,18 @@ struct _GtkIconViewPrivate
   gulong              remove_editable_id;
   gulong              context_changed_id;
 
-  GPtrArray          *row_contexts;
+  GArray             *rows;             /* GtkIconViewRow */
+  gint                n_columns;
+
+  /* Average height of the measured items, for the others */
+  gint                estimated_min_height;
+  gint                estimated_nat_height;
+
+  /* The range of rows that was measured in the last layout */
+  gint                measured_y1, measured_y2;
+  guint               estimated_rows : 1;
+  guint               widths_valid : 1;
+  guint               relayout_id;
 
   gint width, height;
   double mouse_x;
@@ -137,6 +168,8 @@ struct _GtkIconViewPrivate
 
 void                 _gtk_icon_view_set_cell_data                  (GtkIconView            *icon_view,
                                                                     GtkIconViewItem        *item);
+GtkCellAreaContext * _gtk_icon_view_get_item_context                (GtkIconView            *icon_view,
+                                                                    GtkIconViewItem        *item);
 void                 _gtk_icon_view_set_cursor_item                (GtkIconView            *icon_view,
                                                                     GtkIconViewItem        *item,
                                                                     GtkCellRenderer        *cursor_cell);
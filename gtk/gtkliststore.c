@@ -1954,6 +1954,62 @@ gtk_list_store_compare_func (GSequenceIter *a,
   return retval;
 }
 
+/* Sorts the store by extracting the sort column of every row once,
+ * when it is sorted with the default compare function. Returns the
+ * new order, or %NULL if that isn't the case. */
+static gint *
+gtk_list_store_sort_by_keys (GtkListStore *list_store)
+{
+  GtkListStorePrivate *priv = list_store->priv;
+  GtkTreeDataSortHeader *header;
+  GtkTreeDataSortKeys *keys;
+  GSequenceIter **siters, *siter, *end_siter;
+  gint column, n_rows, i, j;
+  gint *new_order;
+
+  if (priv->sort_column_id == -1)
+    return NULL;
+
+  header = _gtk_tree_data_list_get_header (priv->sort_list,
+                                           priv->sort_column_id);
+  if (header == NULL || header->func != _gtk_tree_data_list_compare_func)
+    return NULL;
+
+  column = GPOINTER_TO_INT (header->data);
+  if (!_gtk_tree_data_sort_keys_supported (priv->column_headers[column]))
+    return NULL;
+
+  n_rows = g_sequence_get_length (priv->seq);
+  keys = _gtk_tree_data_sort_keys_new (priv->column_headers[column], n_rows);
+  siters = g_new (GSequenceIter *, n_rows);
+
+  i = 0;
+  end_siter = g_sequence_get_end_iter (priv->seq);
+  for (siter = g_sequence_get_begin_iter (priv->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      GtkTreeDataList *list = g_sequence_get (siter);
+
+      for (j = 0; j < column && list; j++)
+        list = list->next;
+
+      _gtk_tree_data_sort_keys_set_node (keys, i, list);
+      siters[i++] = siter;
+    }
+
+  new_order = _gtk_tree_data_sort_keys_sort (keys, priv->order);
+
+  /* Moving every row to the end in the new order sorts the sequence
+   * without comparing anything */
+  for (i = 0; i < n_rows; i++)
+    g_sequence_move (siters[new_order[i]], end_siter);
+
+  g_free (siters);
+
+  return new_order;
+}
+
 static void
 gtk_list_store_sort (GtkListStore *list_store)
 {
@@ -1966,12 +2022,18 @@ gtk_list_store_sort (GtkListStore *list_store)
       g_sequence_get_length (priv->seq) <= 1)
     return;
 
-  old_positions = save_positions (priv->seq);
+  new_order = gtk_list_store_sort_by_keys (list_store);
+
+  if (new_order == NULL)
+    {
+      old_positions = save_positions (priv->seq);
+
+      g_sequence_sort_iter (priv->seq, gtk_list_store_compare_func, list_store);
 
-  g_sequence_sort_iter (priv->seq, gtk_list_store_compare_func, list_store);
+      new_order = generate_order (priv->seq, old_positions);
+    }
 
   /* Let the world know about our new order */
-  new_order = generate_order (priv->seq, old_positions);
 
   path = gtk_tree_path_new ();
   gtk_tree_model_rows_reordered (GTK_TREE_MODEL (list_store),
@@ -2314,6 +2376,153 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/**
+ * gtk_list_store_insert_rows:
+ * @list_store: A #GtkListStore
+ * @position: position to insert the new rows, or -1 to append them
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_values * @n_rows GValues
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows new rows at @position and fills them in one go.
+ * The values are stored column by column: the value for column
+ * @columns[i] of the j-th new row is @values[i * @n_rows + j].
+ *
+ * Unless the store is sorted, the new rows are announced with a
+ * single #GtkTreeModel::rows-inserted signal, which is a lot cheaper
+ * for views and filter or sort models than inserting the rows one by
+ * one with gtk_list_store_insert_with_valuesv().
+ *
+ * Since: 3.92
+ */
+void
+gtk_list_store_insert_rows (GtkListStore *list_store,
+                            gint          position,
+                            gint          n_rows,
+                            gint         *columns,
+                            GValue       *values,
+                            gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GtkTreePath *path;
+  GSequenceIter *ptr;
+  GtkTreeIter iter, first;
+  gint length, i, j;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  priv = list_store->priv;
+
+  if (n_rows == 0)
+    return;
+
+  length = g_sequence_get_length (priv->seq);
+  if (position > length || position < 0)
+    position = length;
+
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    {
+      GValue *row_values;
+
+      /* The rows end up scattered over the store, so insert them
+       * one at a time */
+      row_values = g_new (GValue, MAX (n_values, 1));
+
+      for (j = 0; j < n_rows; j++)
+        {
+          for (i = 0; i < n_values; i++)
+            row_values[i] = values[i * n_rows + j];
+
+          gtk_list_store_insert_with_valuesv (list_store, NULL, position + j,
+                                              columns, row_values, n_values);
+        }
+
+      g_free (row_values);
+      return;
+    }
+
+  priv->columns_dirty = TRUE;
+
+  ptr = g_sequence_get_iter_at_pos (priv->seq, position);
+
+  for (j = 0; j < n_rows; j++)
+    {
+      iter.stamp = priv->stamp;
+      iter.user_data = g_sequence_insert_before (ptr, NULL);
+
+      if (j == 0)
+        first = iter;
+
+      for (i = 0; i < n_values; i++)
+        gtk_list_store_real_set_value (list_store, &iter,
+                                       columns[i], &values[i * n_rows + j],
+                                       FALSE);
+    }
+
+  priv->length += n_rows;
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (list_store), path, &first, n_rows);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_list_store_replace_rows:
+ * @list_store: A #GtkListStore
+ * @n_rows: the number of rows the store should have
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_values * @n_rows GValues
+ * @n_values: the length of the @columns array
+ *
+ * Replaces all rows of @list_store with @n_rows new rows. This has
+ * the same result as calling gtk_list_store_clear() followed by
+ * gtk_list_store_insert_rows(), see there for the layout of @values,
+ * but the old rows are removed with a single #GtkTreeModel::rows-deleted
+ * emission.
+ *
+ * Since: 3.92
+ */
+void
+gtk_list_store_replace_rows (GtkListStore *list_store,
+                             gint          n_rows,
+                             gint         *columns,
+                             GValue       *values,
+                             gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GSequenceIter *ptr, *end_ptr;
+  GtkTreePath *path;
+  gint n_old_rows;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+
+  priv = list_store->priv;
+
+  n_old_rows = g_sequence_get_length (priv->seq);
+  if (n_old_rows > 0)
+    {
+      end_ptr = g_sequence_get_end_iter (priv->seq);
+      for (ptr = g_sequence_get_begin_iter (priv->seq);
+           ptr != end_ptr;
+           ptr = g_sequence_iter_next (ptr))
+        _gtk_tree_data_list_free (g_sequence_get (ptr), priv->column_headers);
+
+      g_sequence_remove_range (g_sequence_get_begin_iter (priv->seq), end_ptr);
+      priv->length = 0;
+
+      path = gtk_tree_path_new_first ();
+      gtk_tree_model_rows_deleted (GTK_TREE_MODEL (list_store), path, n_old_rows);
+      gtk_tree_path_free (path);
+    }
+
+  gtk_list_store_increment_stamp (list_store);
+
+  gtk_list_store_insert_rows (list_store, 0, n_rows, columns, values, n_values);
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
@@ -122,6 +122,19 @@ void          gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
 						  gint         *columns,
 						  GValue       *values,
 						  gint          n_values);
+GDK_AVAILABLE_IN_3_92
+void          gtk_list_store_insert_rows      (GtkListStore *list_store,
+                                               gint          position,
+                                               gint          n_rows,
+                                               gint         *columns,
+                                               GValue       *values,
+                                               gint          n_values);
+GDK_AVAILABLE_IN_3_92
+void          gtk_list_store_replace_rows     (GtkListStore *list_store,
+                                               gint          n_rows,
+                                               gint         *columns,
+                                               GValue       *values,
+                                               gint          n_values);
 GDK_AVAILABLE_IN_ALL
 void          gtk_list_store_prepend          (GtkListStore *list_store,
 					       GtkTreeIter  *iter);
@@ -173,7 +173,12 @@ static const GDebugKey gtk_debug_keys[] = {
   { "actions", GTK_DEBUG_ACTIONS },
   { "resize", GTK_DEBUG_RESIZE },
   { "layout", GTK_DEBUG_LAYOUT },
-  { "snapshot", GTK_DEBUG_SNAPSHOT }
+  { "snapshot", GTK_DEBUG_SNAPSHOT },
+  { "no-node-cache", GTK_DEBUG_NO_NODE_CACHE },
+  { "no-node-arena", GTK_DEBUG_NO_NODE_ARENA },
+  { "no-css-bloom", GTK_DEBUG_NO_CSS_BLOOM },
+  { "styles", GTK_DEBUG_STYLES },
+  { "no-css-threads", GTK_DEBUG_NO_CSS_THREADS }
 };
 #endif /* G_ENABLE_DEBUG */
 
@@ -0,0 +1,283 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkparallelprivate.h"
+
+#include <stdlib.h>
+
+/* Runs loops on a pool of worker threads, together with the calling
+ * thread.
+ *
+ * Every thread starts out with an equal share of the items. Threads
+ * that are done with their share steal half of the remaining items of
+ * another thread, so uneven work still keeps all threads busy.
+ *
+ * The caller has to make sure that the work done by @func is safe to
+ * run in parallel. Usually that means GTK must not be used from it,
+ * except for the parts that are documented to be safe.
+ */
+
+#define MAX_THREADS 16
+
+typedef struct _GtkParallelRange GtkParallelRange;
+typedef struct _GtkParallelLoop GtkParallelLoop;
+typedef struct _GtkParallelTask GtkParallelTask;
+
+struct _GtkParallelRange
+{
+  GMutex mutex;
+  guint  start;
+  guint  end;
+};
+
+struct _GtkParallelLoop
+{
+  GtkParallelFunc   func;
+  gpointer          user_data;
+  guint             grain;
+
+  GtkParallelRange  ranges[MAX_THREADS];
+  guint             n_ranges;
+
+  GMutex            mutex;
+  GCond             cond;
+  guint             n_running;          /* tasks that didn't finish yet */
+};
+
+struct _GtkParallelTask
+{
+  GtkParallelLoop *loop;
+  guint            index;
+};
+
+static GThreadPool *pool;
+static GPrivate in_worker;
+
+/**
+ * gtk_parallel_get_n_threads:
+ *
+ * Gets the number of threads that work on a loop, including the thread
+ * that runs it. This is the number of processors, up to a limit, or the
+ * value of the GTK_THREADS environment variable if it is set. A value
+ * of 1 means loops are not run in parallel.
+ *
+ * Returns: the number of threads
+ **/
+guint
+gtk_parallel_get_n_threads (void)
+{
+  static gsize initialized = 0;
+  static guint n_threads;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *env = g_getenv ("GTK_THREADS");
+      int n;
+
+      if (env)
+        n = atoi (env);
+      else
+        n = g_get_num_processors ();
+
+      n_threads = CLAMP (n, 1, MAX_THREADS);
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return n_threads;
+}
+
+/* Takes the next items of @range */
+static gboolean
+gtk_parallel_range_take (GtkParallelRange *range,
+                         guint             grain,
+                         guint            *start,
+                         guint            *end)
+{
+  gboolean result;
+
+  g_mutex_lock (&range->mutex);
+
+  result = range->start < range->end;
+  if (result)
+    {
+      *start = range->start;
+      *end = MIN (range->start + grain, range->end);
+      range->start = *end;
+    }
+
+  g_mutex_unlock (&range->mutex);
+
+  return result;
+}
+
+/* Moves half the remaining items of another range to the range of
+ * @index. Returns %FALSE if no work is left anywhere. */
+static gboolean
+gtk_parallel_loop_steal (GtkParallelLoop *loop,
+                         guint            index)
+{
+  guint i;
+
+  for (i = 1; i < loop->n_ranges; i++)
+    {
+      GtkParallelRange *victim = &loop->ranges[(index + i) % loop->n_ranges];
+      GtkParallelRange *own = &loop->ranges[index];
+      guint start, end;
+
+      g_mutex_lock (&victim->mutex);
+      if (victim->start >= victim->end)
+        {
+          g_mutex_unlock (&victim->mutex);
+          continue;
+        }
+      start = victim->start + (victim->end - victim->start) / 2;
+      end = victim->end;
+      victim->end = start;
+      g_mutex_unlock (&victim->mutex);
+
+      g_mutex_lock (&own->mutex);
+      own->start = start;
+      own->end = end;
+      g_mutex_unlock (&own->mutex);
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+gtk_parallel_loop_run (GtkParallelLoop *loop,
+                       guint            index)
+{
+  guint start, end;
+
+  do
+    {
+      while (gtk_parallel_range_take (&loop->ranges[index], loop->grain, &start, &end))
+        loop->func (start, end, loop->user_data);
+    }
+  while (gtk_parallel_loop_steal (loop, index));
+}
+
+static void
+gtk_parallel_worker (gpointer data,
+                     gpointer unused)
+{
+  GtkParallelTask *task = data;
+  GtkParallelLoop *loop = task->loop;
+
+  g_private_set (&in_worker, GINT_TO_POINTER (TRUE));
+
+  gtk_parallel_loop_run (loop, task->index);
+
+  g_mutex_lock (&loop->mutex);
+  loop->n_running--;
+  if (loop->n_running == 0)
+    g_cond_signal (&loop->cond);
+  g_mutex_unlock (&loop->mutex);
+
+  g_slice_free (GtkParallelTask, task);
+}
+
+/**
+ * gtk_parallel_for:
+ * @n_items: the number of items
+ * @grain: how many items to hand to @func at once
+ * @func: function to call
+ * @user_data: data to pass to @func
+ *
+ * Calls @func for all items from 0 to @n_items, in parallel. This only
+ * returns when all items have been handled.
+ *
+ * Loops started from inside @func run on the calling thread only.
+ **/
+void
+gtk_parallel_for (guint           n_items,
+                  guint           grain,
+                  GtkParallelFunc func,
+                  gpointer        user_data)
+{
+  GtkParallelLoop loop;
+  guint i, n_threads;
+
+  g_return_if_fail (func != NULL);
+
+  if (n_items == 0)
+    return;
+
+  grain = MAX (grain, 1);
+  n_threads = MIN (gtk_parallel_get_n_threads (), (n_items + grain - 1) / grain);
+
+  if (n_threads <= 1 || g_private_get (&in_worker))
+    {
+      func (0, n_items, user_data);
+      return;
+    }
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (gtk_parallel_worker,
+                                    NULL,
+                                    gtk_parallel_get_n_threads () - 1,
+                                    FALSE,
+                                    NULL);
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  loop.func = func;
+  loop.user_data = user_data;
+  loop.grain = grain;
+  loop.n_ranges = n_threads;
+  for (i = 0; i < n_threads; i++)
+    {
+      g_mutex_init (&loop.ranges[i].mutex);
+      loop.ranges[i].start = (guint64) n_items * i / n_threads;
+      loop.ranges[i].end = (guint64) n_items * (i + 1) / n_threads;
+    }
+  g_mutex_init (&loop.mutex);
+  g_cond_init (&loop.cond);
+  loop.n_running = n_threads - 1;
+
+  for (i = 1; i < n_threads; i++)
+    {
+      GtkParallelTask *task = g_slice_new (GtkParallelTask);
+
+      task->loop = &loop;
+      task->index = i;
+      g_thread_pool_push (pool, task, NULL);
+    }
+
+  g_private_set (&in_worker, GINT_TO_POINTER (TRUE));
+  gtk_parallel_loop_run (&loop, 0);
+  g_private_set (&in_worker, GINT_TO_POINTER (FALSE));
+
+  g_mutex_lock (&loop.mutex);
+  while (loop.n_running > 0)
+    g_cond_wait (&loop.cond, &loop.mutex);
+  g_mutex_unlock (&loop.mutex);
+
+  for (i = 0; i < n_threads; i++)
+    g_mutex_clear (&loop.ranges[i].mutex);
+  g_mutex_clear (&loop.mutex);
+  g_cond_clear (&loop.cond);
+}
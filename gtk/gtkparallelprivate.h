@@ -0,0 +1,39 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_PARALLEL_PRIVATE_H__
+#define __GTK_PARALLEL_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Handles the items from @start up to, but not including, @end */
+typedef void (* GtkParallelFunc) (guint    start,
+                                  guint    end,
+                                  gpointer user_data);
+
+guint                   gtk_parallel_get_n_threads              (void);
+
+void                    gtk_parallel_for                        (guint           n_items,
+                                                                 guint           grain,
+                                                                 GtkParallelFunc func,
+                                                                 gpointer        user_data);
+
+G_END_DECLS
+
+#endif /* __GTK_PARALLEL_PRIVATE_H__ */
@@ -256,7 +256,21 @@ _gtk_translate_keyboard_accel_state (GdkKeymap       *keymap,
 static gpointer
 register_resources (gpointer data)
 {
+  GResource *resource;
+  char *path;
+
   _gtk_register_resource ();
+
+  /* The compiled style sheets of the built-in theme, if installed */
+  path = g_build_filename (_gtk_get_datadir (), "gtk-4.0", "gtk-compiled-css.gresource", NULL);
+  resource = g_resource_load (path, NULL);
+  if (resource)
+    {
+      g_resources_register (resource);
+      g_resource_unref (resource);
+    }
+  g_free (path);
+
   return NULL;
 }
 
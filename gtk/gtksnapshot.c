@@ -21,6 +21,7 @@
 #include "gtksnapshotprivate.h"
 
 #include "gtkcssrgbavalueprivate.h"
+#include "gtkdebug.h"
 #include "gtkcssshadowsvalueprivate.h"
 #include "gtkrenderbackgroundprivate.h"
 #include "gtkrenderborderprivate.h"
@@ -140,6 +141,13 @@ gtk_snapshot_init (GtkSnapshot          *snapshot,
   snapshot->state_stack = g_array_new (FALSE, TRUE, sizeof (GtkSnapshotState));
   g_array_set_clear_func (snapshot->state_stack, (GDestroyNotify)gtk_snapshot_state_clear);
   snapshot->nodes = g_ptr_array_new_with_free_func ((GDestroyNotify)gsk_render_node_unref);
+  snapshot->n_reused_nodes = 0;
+  snapshot->n_snapshot_nodes = 0;
+
+  if (GTK_DEBUG_CHECK (NO_NODE_ARENA))
+    snapshot->arena = NULL;
+  else
+    snapshot->arena = gsk_render_node_arena_begin ();
 
   if (name && record_names)
     {
@@ -197,7 +205,7 @@ gtk_snapshot_push (GtkSnapshot           *snapshot,
       GtkSnapshotState *state = gtk_snapshot_get_current_state (snapshot);
 
       gtk_snapshot_push_state (snapshot,
-                               g_strdup (str),
+                               str,
                                state->clip_region,
                                state->translate_x,
                                state->translate_y,
@@ -207,7 +215,7 @@ gtk_snapshot_push (GtkSnapshot           *snapshot,
   else
     {
       gtk_snapshot_push_state (snapshot,
-                               g_strdup (str),
+                               str,
                                NULL, 0, 0,
                                gtk_snapshot_collect_default);
     }
@@ -1018,6 +1026,8 @@ gtk_snapshot_finish (GtkSnapshot *snapshot)
 
   g_array_free (snapshot->state_stack, TRUE);
   g_ptr_array_free (snapshot->nodes, TRUE);
+  g_clear_pointer (&snapshot->arena, gsk_render_node_arena_end);
+
   return result;
 }
 
@@ -1043,6 +1053,24 @@ gtk_snapshot_pop (GtkSnapshot *snapshot)
     }
 }
 
+/*< private >
+ * gtk_snapshot_pop_collect:
+ * @snapshot: a #GtkSnapshot
+ *
+ * Removes the top element from the stack of render nodes like
+ * gtk_snapshot_pop(), but returns the resulting node instead of
+ * appending it to the node underneath it.
+ *
+ * This is used by #GtkWidget to retain the nodes it produced.
+ *
+ * Returns: (transfer full) (nullable): the collected render node
+ */
+GskRenderNode *
+gtk_snapshot_pop_collect (GtkSnapshot *snapshot)
+{
+  return gtk_snapshot_pop_internal (snapshot);
+}
+
 /**
  * gtk_snapshot_get_renderer:
  * @snapshot: a #GtkSnapshot
@@ -1325,6 +1353,34 @@ gtk_snapshot_clips_rect (GtkSnapshot                 *snapshot,
   return cairo_region_contains_rectangle (current_state->clip_region, &offset_rect) == CAIRO_REGION_OVERLAP_OUT;
 }
 
+/*< private >
+ * gtk_snapshot_contains_rect:
+ * @snapshot: a #GtkSnapshot
+ * @rect: a rectangle
+ *
+ * Tests whether the rectangle is entirely inside the clip region of @snapshot,
+ * so that nothing drawn inside it will be culled.
+ *
+ * Returns: %TRUE if @rect is entirely inside the clip region
+ */
+gboolean
+gtk_snapshot_contains_rect (GtkSnapshot                 *snapshot,
+                            const cairo_rectangle_int_t *rect)
+{
+  const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
+  cairo_rectangle_int_t offset_rect;
+
+  if (current_state->clip_region == NULL)
+    return TRUE;
+
+  offset_rect.x = rect->x + current_state->translate_x;
+  offset_rect.y = rect->y + current_state->translate_y;
+  offset_rect.width = rect->width;
+  offset_rect.height = rect->height;
+
+  return cairo_region_contains_rectangle (current_state->clip_region, &offset_rect) == CAIRO_REGION_OVERLAP_IN;
+}
+
 /**
  * gtk_snapshot_render_background:
  * @snapshot: a #GtkSnapshot
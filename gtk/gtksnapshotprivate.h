@@ -20,6 +20,8 @@
 
 #include "gtksnapshot.h"
 
+#include "gsk/gskrendernodeprivate.h"
+
 G_BEGIN_DECLS
 
 typedef struct _GtkSnapshotState GtkSnapshotState;
@@ -85,6 +87,11 @@ struct _GtkSnapshot {
   GskRenderer           *renderer;
   GArray                *state_stack;
   GPtrArray             *nodes;
+  GskRenderNodeArena    *arena;
+
+  /* Widget render node cache statistics */
+  guint                  n_reused_nodes;
+  guint                  n_snapshot_nodes;
 };
 
 void            gtk_snapshot_init               (GtkSnapshot             *state,
@@ -97,6 +104,10 @@ GskRenderNode * gtk_snapshot_finish             (GtkSnapshot             *state)
 
 GskRenderer *   gtk_snapshot_get_renderer       (const GtkSnapshot       *snapshot);
 
+GskRenderNode * gtk_snapshot_pop_collect        (GtkSnapshot             *snapshot);
+gboolean        gtk_snapshot_contains_rect      (GtkSnapshot             *snapshot,
+                                                 const cairo_rectangle_int_t *rect);
+
 G_END_DECLS
 
 #endif /* __GTK_SNAPSHOT_PRIVATE_H__ */
@@ -19,6 +19,7 @@
 
 #include "gtkstyleproviderprivate.h"
 
+#include "gtkcsssectionprivate.h"
 #include "gtkintl.h"
 #include "gtkstyleprovider.h"
 #include "gtkprivate.h"
@@ -28,6 +29,18 @@ enum {
   LAST_SIGNAL
 };
 
+typedef struct _GtkStyleProviderError GtkStyleProviderError;
+
+struct _GtkStyleProviderError {
+  GtkStyleProviderPrivate *provider;
+  GtkCssSection           *section;
+  GError                  *error;
+};
+
+/* The array that errors of the calling thread are added to, see
+ * _gtk_style_provider_private_defer_errors() */
+static GPrivate deferred_errors;
+
 G_DEFINE_INTERFACE (GtkStyleProviderPrivate, _gtk_style_provider_private, GTK_TYPE_STYLE_PROVIDER)
 
 static guint signals[LAST_SIGNAL];
@@ -105,14 +118,26 @@ _gtk_style_provider_private_lookup (GtkStyleProviderPrivate *provider,
   iface->lookup (provider, matcher, lookup, out_change);
 }
 
+/* Counts changes of all providers, so caches of computed styles can
+ * tell when they are out of date */
+static guint generation;
+
 void
 _gtk_style_provider_private_changed (GtkStyleProviderPrivate *provider)
 {
   gtk_internal_return_if_fail (GTK_IS_STYLE_PROVIDER_PRIVATE (provider));
 
+  generation++;
+
   g_signal_emit (provider, signals[CHANGED], 0);
 }
 
+guint
+_gtk_style_provider_private_get_generation (void)
+{
+  return generation;
+}
+
 GtkSettings *
 _gtk_style_provider_private_get_settings (GtkStyleProviderPrivate *provider)
 {
@@ -143,15 +168,89 @@ _gtk_style_provider_private_get_scale (GtkStyleProviderPrivate *provider)
   return iface->get_scale (provider);
 }
 
+static void
+gtk_style_provider_error_free (gpointer data)
+{
+  GtkStyleProviderError *item = data;
+
+  g_object_unref (item->provider);
+  if (item->section)
+    gtk_css_section_unref (item->section);
+  g_error_free (item->error);
+  g_slice_free (GtkStyleProviderError, item);
+}
+
 void
 _gtk_style_provider_private_emit_error (GtkStyleProviderPrivate *provider,
                                         GtkCssSection           *section,
                                         GError                  *error)
 {
   GtkStyleProviderPrivateInterface *iface;
+  GPtrArray **deferred;
+
+  deferred = g_private_get (&deferred_errors);
+  if (deferred != NULL)
+    {
+      GtkStyleProviderError *item;
+
+      if (*deferred == NULL)
+        *deferred = g_ptr_array_new_with_free_func (gtk_style_provider_error_free);
+
+      item = g_slice_new (GtkStyleProviderError);
+      item->provider = g_object_ref (provider);
+      item->section = section ? gtk_css_section_ref (section) : NULL;
+      item->error = g_error_copy (error);
+      g_ptr_array_add (*deferred, item);
+      return;
+    }
 
   iface = GTK_STYLE_PROVIDER_PRIVATE_GET_INTERFACE (provider);
 
   if (iface->emit_error)
     iface->emit_error (provider, section, error);
 }
+
+/**
+ * _gtk_style_provider_private_defer_errors:
+ * @errors: (nullable): location of the array to add errors to, or
+ *   %NULL to emit errors right away again
+ *
+ * Makes _gtk_style_provider_private_emit_error() add the errors of the
+ * calling thread to *@errors instead of emitting them. The array is
+ * created when the first error is added.
+ *
+ * This is used when styles are computed on worker threads, because the
+ * error signals must only be emitted on the main thread. The errors are
+ * emitted later with _gtk_style_provider_private_emit_deferred_errors().
+ */
+void
+_gtk_style_provider_private_defer_errors (GPtrArray **errors)
+{
+  g_private_set (&deferred_errors, errors);
+}
+
+/**
+ * _gtk_style_provider_private_emit_deferred_errors:
+ * @errors: (transfer full) (nullable): errors collected while
+ *   _gtk_style_provider_private_defer_errors() was in effect
+ *
+ * Emits the errors in @errors in the order they happened, and frees
+ * the array.
+ */
+void
+_gtk_style_provider_private_emit_deferred_errors (GPtrArray *errors)
+{
+  guint i;
+
+  if (errors == NULL)
+    return;
+
+  for (i = 0; i < errors->len; i++)
+    {
+      GtkStyleProviderError *item = g_ptr_array_index (errors, i);
+
+      _gtk_style_provider_private_emit_error (item->provider, item->section, item->error);
+    }
+
+  g_ptr_array_unref (errors);
+}
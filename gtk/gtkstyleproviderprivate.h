@@ -70,10 +70,14 @@ void                    _gtk_style_provider_private_lookup       (GtkStyleProvid
                                                                   GtkCssChange            *out_change);
 
 void                    _gtk_style_provider_private_changed      (GtkStyleProviderPrivate *provider);
+guint                   _gtk_style_provider_private_get_generation (void);
 
 void                    _gtk_style_provider_private_emit_error   (GtkStyleProviderPrivate *provider,
                                                                   GtkCssSection           *section,
                                                                   GError                  *error);
+void                    _gtk_style_provider_private_defer_errors (GPtrArray              **errors);
+void                    _gtk_style_provider_private_emit_deferred_errors
+                                                                 (GPtrArray               *errors);
 
 G_END_DECLS
 
@@ -67,6 +67,7 @@
 #include "gtkdebug.h"
 #include "gtktextmarkprivate.h"
 #include "gtktextsegment.h"
+#include "gtktextsearchindexprivate.h"
 
 /*
  * Types
@@ -215,6 +216,18 @@ struct _GtkTextBTree {
   guint end_iter_segment_stamp;
   
   GHashTable *child_anchor_table;
+
+  /* Optional, see _gtk_text_btree_set_search_index_enabled() */
+  GtkTextSearchIndex *search_index;
+
+  /* The last line looked up by line number or char index, and where
+   * it is; -1 if unknown. Tags and marks don't move any characters,
+   * so this stays valid until the chars_changed_stamp changes.
+   */
+  GtkTextLine *position_cache_line;
+  gint position_cache_line_number;
+  gint position_cache_char_index;
+  guint position_cache_stamp;
 };
 
 
@@ -359,6 +372,28 @@ chars_changed (GtkTextBTree *tree)
   tree->chars_changed_stamp += 1;
 }
 
+/* Must be called whenever segments of @line are split, linked or
+ * unlinked, since its table of segment offsets points into them.
+ */
+void
+_gtk_text_line_segments_changed (GtkTextLine *line)
+{
+  g_clear_pointer (&line->offsets, g_free);
+}
+
+/* Must be called after the characters in @line changed. */
+static inline void
+line_chars_changed (GtkTextBTree *tree,
+                    GtkTextLine  *line)
+{
+  line->char_count = -1;
+  line->byte_count = -1;
+  _gtk_text_line_segments_changed (line);
+
+  if (tree->search_index)
+    _gtk_text_search_index_invalidate_line (tree->search_index, line);
+}
+
 /*
  * BTree operations
  */
@@ -428,6 +463,9 @@ _gtk_text_btree_new (GtkTextTagTable *table,
   tree->end_iter_line = NULL;
   tree->end_iter_segment_byte_index = 0;
   tree->end_iter_segment_char_offset = 0;
+
+  tree->position_cache_stamp = tree->chars_changed_stamp - 1;
+  tree->position_cache_line = NULL;
   
   g_object_ref (tree->table);
 
@@ -509,6 +547,8 @@ _gtk_text_btree_unref (GtkTextBTree *tree)
       g_object_unref (tree->table);
       tree->table = NULL;
       
+      g_clear_pointer (&tree->search_index, _gtk_text_search_index_free);
+
       gtk_text_btree_node_destroy (tree, tree->root_node);
       tree->root_node = NULL;
       
@@ -536,6 +576,22 @@ _gtk_text_btree_get_buffer (GtkTextBTree *tree)
   return tree->buffer;
 }
 
+void
+_gtk_text_btree_set_search_index_enabled (GtkTextBTree *tree,
+                                          gboolean      enabled)
+{
+  if (enabled && tree->search_index == NULL)
+    tree->search_index = _gtk_text_search_index_new ();
+  else if (!enabled)
+    g_clear_pointer (&tree->search_index, _gtk_text_search_index_free);
+}
+
+GtkTextSearchIndex *
+_gtk_text_btree_get_search_index (GtkTextBTree *tree)
+{
+  return tree->search_index;
+}
+
 guint
 _gtk_text_btree_get_chars_changed_stamp (GtkTextBTree *tree)
 {
@@ -1066,6 +1122,7 @@ _gtk_text_btree_delete (GtkTextIter *start,
    */
 
   cleanup_line (start_line);
+  line_chars_changed (tree, start_line);
 
   /*
    * Lastly, rebalance the first GtkTextBTreeNode of the range.
@@ -1227,6 +1284,10 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       cleanup_line (line);
     }
 
+  line_chars_changed (tree, start_line);
+  if (line != start_line)
+    line_chars_changed (tree, line);
+
   post_insert_fixup (tree, line, line_count_delta, char_count_delta);
 
   /* Invalidate our region, and reset the iterator the user
@@ -1285,6 +1346,8 @@ insert_pixbuf_or_widget_segment (GtkTextIter        *iter,
       prevPtr->next = seg;
     }
 
+  line_chars_changed (tree, line);
+
   post_insert_fixup (tree, line, 0, seg->char_count);
 
   chars_changed (tree);
@@ -1859,6 +1922,7 @@ _gtk_text_btree_tag (const GtkTextIter *start_orig,
           seg->next = prev->next;
           prev->next = seg;
         }
+      _gtk_text_line_segments_changed (start_line);
 
       /* cleanup_line adds the new toggle to the node counts. */
 #if 0
@@ -1941,6 +2005,7 @@ _gtk_text_btree_tag (const GtkTextIter *start_orig,
             }
           prev->next = seg->next;
         }
+      _gtk_text_line_segments_changed (line);
 
       /* Inform iterators we've hosed them. This actually reflects a
          bit of inefficiency; if you have the same tag toggled on and
@@ -1994,6 +2059,7 @@ _gtk_text_btree_tag (const GtkTextIter *start_orig,
           seg->next = prev->next;
           prev->next = seg;
         }
+      _gtk_text_line_segments_changed (end_line);
       /* cleanup_line adds the new toggle to the node counts. */
       g_assert (seg->body.toggle.inNodeCounts == FALSE);
 #if 0
@@ -2027,6 +2093,94 @@ _gtk_text_btree_tag (const GtkTextIter *start_orig,
  * "Getters"
  */
 
+static void
+position_cache_set (GtkTextBTree *tree,
+                    GtkTextLine  *line,
+                    gint          line_number,
+                    gint          char_index)
+{
+  tree->position_cache_line = line;
+  tree->position_cache_line_number = line_number;
+  tree->position_cache_char_index = char_index;
+  tree->position_cache_stamp = tree->chars_changed_stamp;
+}
+
+/* Code walking through the buffer usually asks for the same line
+ * again or for the next one, which the position cache can answer
+ * without going through the tree.
+ */
+static GtkTextLine *
+position_cache_get_line (GtkTextBTree *tree,
+                         gint          line_number)
+{
+  GtkTextLine *line, *next;
+  gint char_index;
+
+  if (tree->position_cache_stamp != tree->chars_changed_stamp ||
+      tree->position_cache_line_number < 0)
+    return NULL;
+
+  line = tree->position_cache_line;
+
+  if (line_number == tree->position_cache_line_number)
+    return line;
+
+  if (line_number != tree->position_cache_line_number + 1)
+    return NULL;
+
+  next = _gtk_text_line_next (line);
+  if (next == NULL)
+    return NULL;
+
+  char_index = tree->position_cache_char_index;
+  if (char_index >= 0)
+    char_index += _gtk_text_line_char_count (line);
+
+  position_cache_set (tree, next, line_number, char_index);
+
+  return next;
+}
+
+static GtkTextLine *
+position_cache_get_line_at_char (GtkTextBTree *tree,
+                                 gint          char_index,
+                                 gint         *line_start_index)
+{
+  GtkTextLine *line, *next;
+  gint line_start, line_number;
+
+  if (tree->position_cache_stamp != tree->chars_changed_stamp ||
+      tree->position_cache_char_index < 0 ||
+      char_index < tree->position_cache_char_index)
+    return NULL;
+
+  line = tree->position_cache_line;
+  line_start = tree->position_cache_char_index;
+
+  if (char_index < line_start + _gtk_text_line_char_count (line))
+    {
+      *line_start_index = line_start;
+      return line;
+    }
+
+  next = _gtk_text_line_next (line);
+  if (next == NULL)
+    return NULL;
+
+  line_start += _gtk_text_line_char_count (line);
+  if (char_index >= line_start + _gtk_text_line_char_count (next))
+    return NULL;
+
+  line_number = tree->position_cache_line_number;
+  if (line_number >= 0)
+    line_number += 1;
+
+  position_cache_set (tree, next, line_number, line_start);
+
+  *line_start_index = line_start;
+  return next;
+}
+
 static GtkTextLine*
 get_line_internal (GtkTextBTree *tree,
                    gint          line_number,
@@ -2054,6 +2208,10 @@ get_line_internal (GtkTextBTree *tree,
   if (real_line_number)
     *real_line_number = line_number;
 
+  line = position_cache_get_line (tree, line_number);
+  if (line)
+    return line;
+
   node = tree->root_node;
   lines_left = line_number;
 
@@ -2093,6 +2251,9 @@ get_line_internal (GtkTextBTree *tree,
 #endif
       lines_left -= 1;
     }
+
+  position_cache_set (tree, line, line_number, -1);
+
   return line;
 }
 
@@ -2129,7 +2290,6 @@ _gtk_text_btree_get_line_at_char (GtkTextBTree      *tree,
 {
   GtkTextBTreeNode *node;
   GtkTextLine *line;
-  GtkTextLineSegment *seg;
   int chars_left;
   int chars_in_line;
 
@@ -2146,6 +2306,10 @@ _gtk_text_btree_get_line_at_char (GtkTextBTree      *tree,
 
   *real_char_index = char_index;
 
+  line = position_cache_get_line_at_char (tree, char_index, line_start_index);
+  if (line)
+    return line;
+
   /*
    * Work down through levels of the tree until a GtkTextBTreeNode is found at
    * level 0.
@@ -2164,45 +2328,25 @@ _gtk_text_btree_get_line_at_char (GtkTextBTree      *tree,
         }
     }
 
-  if (chars_left == 0)
-    {
-      /* Start of a line */
-
-      *line_start_index = char_index;
-      return node->children.line;
-    }
-
   /*
    * Work through the lines attached to the level-0 GtkTextBTreeNode.
    */
 
-  chars_in_line = 0;
-  seg = NULL;
   for (line = node->children.line; line != NULL; line = line->next)
     {
-      seg = line->segments;
-      while (seg != NULL)
-        {
-          if (chars_in_line + seg->char_count > chars_left)
-            goto found; /* found our line/segment */
-
-          chars_in_line += seg->char_count;
-
-          seg = seg->next;
-        }
+      chars_in_line = _gtk_text_line_char_count (line);
+      if (chars_left < chars_in_line)
+        break; /* found our line */
 
       chars_left -= chars_in_line;
-
-      chars_in_line = 0;
-      seg = NULL;
     }
 
- found:
-
   g_assert (line != NULL); /* hosage, ran out of lines */
-  g_assert (seg != NULL);
 
   *line_start_index = char_index - chars_left;
+
+  position_cache_set (tree, line, -1, *line_start_index);
+
   return line;
 }
 
@@ -3714,121 +3858,74 @@ _gtk_text_line_invalidate_wrap (GtkTextLine *line,
   gtk_text_btree_node_invalidate_upward (line->parent, ld->view_id);
 }
 
-gint
-_gtk_text_line_char_count (GtkTextLine *line)
+/* Tags and marks split segments, but don't change how many chars
+ * and bytes a line has, so the sizes are kept until line_chars_changed()
+ */
+static void
+line_update_sizes (GtkTextLine *line)
 {
   GtkTextLineSegment *seg;
-  gint size;
 
-  size = 0;
-  seg = line->segments;
-  while (seg != NULL)
+  line->char_count = 0;
+  line->byte_count = 0;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
     {
-      size += seg->char_count;
-      seg = seg->next;
+      line->char_count += seg->char_count;
+      line->byte_count += seg->byte_count;
     }
-  return size;
 }
 
 gint
-_gtk_text_line_byte_count (GtkTextLine *line)
+_gtk_text_line_char_count (GtkTextLine *line)
 {
-  GtkTextLineSegment *seg;
-  gint size;
+  if (line->char_count < 0)
+    line_update_sizes (line);
 
-  size = 0;
-  seg = line->segments;
-  while (seg != NULL)
-    {
-      size += seg->byte_count;
-      seg = seg->next;
-    }
+  return line->char_count;
+}
 
-  return size;
+gint
+_gtk_text_line_byte_count (GtkTextLine *line)
+{
+  if (line->byte_count < 0)
+    line_update_sizes (line);
+
+  return line->byte_count;
 }
 
 gint
 _gtk_text_line_char_index (GtkTextLine *target_line)
 {
-  GSList *node_stack = NULL;
-  GtkTextBTreeNode *iter;
+  GtkTextBTreeNode *node, *parent, *node2;
   GtkTextLine *line;
   gint num_chars;
 
-  /* Push all our parent nodes onto a stack */
-  iter = target_line->parent;
-
-  g_assert (iter != NULL);
+  /* Count the chars in the lines preceding this one in its level-0
+   * node, then work up through the levels of the tree, like
+   * _gtk_text_line_get_number() does for lines.
+   */
+  node = target_line->parent;
+  num_chars = 0;
 
-  while (iter != NULL)
+  for (line = node->children.line; line != target_line; line = line->next)
     {
-      node_stack = g_slist_prepend (node_stack, iter);
+      g_assert (line != NULL);
 
-      iter = iter->parent;
+      num_chars += _gtk_text_line_char_count (line);
     }
 
-  /* Check that we have the root node on top of the stack. */
-  g_assert (node_stack != NULL &&
-            node_stack->data != NULL &&
-            ((GtkTextBTreeNode*)node_stack->data)->parent == NULL);
-
-  /* Add up chars in all nodes before the nodes in our stack.
-   */
-
-  num_chars = 0;
-  iter = node_stack->data;
-  while (iter != NULL)
+  for (parent = node->parent; parent != NULL;
+       node = parent, parent = parent->parent)
     {
-      GtkTextBTreeNode *child_iter;
-      GtkTextBTreeNode *next_node;
-
-      next_node = node_stack->next ?
-        node_stack->next->data : NULL;
-      node_stack = g_slist_remove (node_stack, node_stack->data);
-
-      if (iter->level == 0)
-        {
-          /* stack should be empty when we're on the last node */
-          g_assert (node_stack == NULL);
-          break; /* Our children are now lines */
-        }
-
-      g_assert (next_node != NULL);
-      g_assert (iter != NULL);
-      g_assert (next_node->parent == iter);
-
-      /* Add up chars before us in the tree */
-      child_iter = iter->children.node;
-      while (child_iter != next_node)
+      for (node2 = parent->children.node; node2 != node; node2 = node2->next)
         {
-          g_assert (child_iter != NULL);
-
-          num_chars += child_iter->num_chars;
+          g_assert (node2 != NULL);
 
-          child_iter = child_iter->next;
+          num_chars += node2->num_chars;
         }
-
-      iter = next_node;
     }
 
-  g_assert (iter != NULL);
-  g_assert (iter == target_line->parent);
-
-  /* Since we don't store char counts in lines, only in segments, we
-     have to iterate over the lines adding up segment char counts
-     until we find our line.  */
-  line = iter->children.line;
-  while (line != target_line)
-    {
-      g_assert (line != NULL);
-
-      num_chars += _gtk_text_line_char_count (line);
-
-      line = line->next;
-    }
-
-  g_assert (line == target_line);
-
   return num_chars;
 }
 
@@ -3987,28 +4084,183 @@ _gtk_text_line_char_to_byte (GtkTextLine *line,
   return 0;
 }
 
+/* Lines with at least this many segments, usually because many tags
+ * are applied to them, get a table of where their indexable segments
+ * start, so positions in them can be found with a binary search.
+ */
+#define LINE_OFFSETS_MIN_SEGMENTS 16
+
+typedef struct _GtkTextLineOffset GtkTextLineOffset;
+
+struct _GtkTextLineOffset {
+  GtkTextLineSegment *segment;          /* indexable */
+  GtkTextLineSegment *any_segment;      /* after the previous indexable one */
+  gint byte_offset;
+  gint char_offset;
+};
+
+struct _GtkTextLineOffsets {
+  guint n_offsets;
+  GtkTextLineOffset offsets[1];
+};
+
+static GtkTextLineOffsets *
+line_get_offsets (GtkTextLine  *line,
+                  GtkTextBTree *tree)
+{
+  if (tree == NULL)
+    return NULL;
+
+  return line->offsets;
+}
+
+static void
+line_update_offsets (GtkTextLine  *line,
+                     GtkTextBTree *tree)
+{
+  GtkTextLineOffsets *offsets;
+  GtkTextLineOffset *offset;
+  GtkTextLineSegment *seg, *any_segment;
+  gint byte_offset, char_offset;
+  guint n_offsets;
+
+  if (tree == NULL)
+    return;
+
+  n_offsets = 0;
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->char_count > 0)
+        n_offsets++;
+    }
+
+  if (n_offsets < LINE_OFFSETS_MIN_SEGMENTS)
+    {
+      g_clear_pointer (&line->offsets, g_free);
+      return;
+    }
+
+  offsets = g_realloc (line->offsets,
+                       sizeof (GtkTextLineOffsets) + (n_offsets - 1) * sizeof (GtkTextLineOffset));
+  offsets->n_offsets = n_offsets;
+
+  offset = offsets->offsets;
+  any_segment = line->segments;
+  byte_offset = 0;
+  char_offset = 0;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->char_count == 0)
+        continue;
+
+      offset->segment = seg;
+      offset->any_segment = any_segment;
+      offset->byte_offset = byte_offset;
+      offset->char_offset = char_offset;
+      offset++;
+
+      byte_offset += seg->byte_count;
+      char_offset += seg->char_count;
+      any_segment = seg->next;
+    }
+
+  line->offsets = offsets;
+}
+
+/* Like the linear search in _gtk_text_line_byte_locate() and
+ * _gtk_text_line_char_locate(), using the table of @line
+ */
+static gboolean
+line_offsets_locate (GtkTextLineOffsets  *offsets,
+                     gboolean             chars,
+                     gint                 offset,
+                     GtkTextLineSegment **segment,
+                     GtkTextLineSegment **any_segment,
+                     gint                *seg_offset)
+{
+  GtkTextLineOffset *found;
+  guint lo, hi, mid;
+  gint start, size;
+
+  /* Find the last segment starting at or before @offset */
+  lo = 0;
+  hi = offsets->n_offsets;
+  while (hi - lo > 1)
+    {
+      mid = (lo + hi) / 2;
+      start = chars ? offsets->offsets[mid].char_offset : offsets->offsets[mid].byte_offset;
+
+      if (start <= offset)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  found = &offsets->offsets[lo];
+  start = chars ? found->char_offset : found->byte_offset;
+  size = chars ? found->segment->char_count : found->segment->byte_count;
+
+  if (offset >= start + size)
+    {
+      /* We went off the end of the line */
+      if (offset != start + size)
+        g_warning ("%s: %s off the end of the line",
+                   G_STRLOC, chars ? "char offset" : "byte index");
+
+      return FALSE;
+    }
+
+  *segment = found->segment;
+  *seg_offset = offset - start;
+
+  /* any_segment is the segment itself if we're in the middle of it */
+  if (*seg_offset > 0)
+    *any_segment = found->segment;
+  else
+    *any_segment = found->any_segment;
+
+  return TRUE;
+}
+
 /* FIXME sync with char_locate (or figure out a clean
    way to merge the two functions) */
 gboolean
 _gtk_text_line_byte_locate (GtkTextLine *line,
+                            GtkTextBTree *tree,
                             gint byte_offset,
                             GtkTextLineSegment **segment,
                             GtkTextLineSegment **any_segment,
                             gint *seg_byte_offset,
                             gint *line_byte_offset)
 {
+  GtkTextLineOffsets *offsets;
   GtkTextLineSegment *seg;
   GtkTextLineSegment *after_last_indexable;
   GtkTextLineSegment *last_indexable;
   gint offset;
   gint bytes_in_line;
+  guint n_segments;
 
   g_return_val_if_fail (line != NULL, FALSE);
   g_return_val_if_fail (byte_offset >= 0, FALSE);
 
   *segment = NULL;
   *any_segment = NULL;
+
+  offsets = line_get_offsets (line, tree);
+  if (offsets)
+    {
+      if (!line_offsets_locate (offsets, FALSE, byte_offset,
+                                segment, any_segment, seg_byte_offset))
+        return FALSE;
+
+      *line_byte_offset = byte_offset;
+      return TRUE;
+    }
+
   bytes_in_line = 0;
+  n_segments = 0;
 
   offset = byte_offset;
 
@@ -4027,11 +4279,16 @@ _gtk_text_line_byte_locate (GtkTextLine *line,
           bytes_in_line += seg->byte_count;
           last_indexable = seg;
           after_last_indexable = last_indexable->next;
+          n_segments++;
         }
 
       seg = seg->next;
     }
 
+  /* Don't walk that far again */
+  if (n_segments >= LINE_OFFSETS_MIN_SEGMENTS)
+    line_update_offsets (line, tree);
+
   if (seg == NULL)
     {
       /* We went off the end of the line */
@@ -4068,24 +4325,40 @@ _gtk_text_line_byte_locate (GtkTextLine *line,
    way to merge the two functions) */
 gboolean
 _gtk_text_line_char_locate     (GtkTextLine     *line,
+                                GtkTextBTree    *tree,
                                 gint              char_offset,
                                 GtkTextLineSegment **segment,
                                 GtkTextLineSegment **any_segment,
                                 gint             *seg_char_offset,
                                 gint             *line_char_offset)
 {
+  GtkTextLineOffsets *offsets;
   GtkTextLineSegment *seg;
   GtkTextLineSegment *after_last_indexable;
   GtkTextLineSegment *last_indexable;
   gint offset;
   gint chars_in_line;
+  guint n_segments;
 
   g_return_val_if_fail (line != NULL, FALSE);
   g_return_val_if_fail (char_offset >= 0, FALSE);
   
   *segment = NULL;
   *any_segment = NULL;
+
+  offsets = line_get_offsets (line, tree);
+  if (offsets)
+    {
+      if (!line_offsets_locate (offsets, TRUE, char_offset,
+                                segment, any_segment, seg_char_offset))
+        return FALSE;
+
+      *line_char_offset = char_offset;
+      return TRUE;
+    }
+
   chars_in_line = 0;
+  n_segments = 0;
 
   offset = char_offset;
 
@@ -4104,11 +4377,16 @@ _gtk_text_line_char_locate     (GtkTextLine     *line,
           chars_in_line += seg->char_count;
           last_indexable = seg;
           after_last_indexable = last_indexable->next;
+          n_segments++;
         }
 
       seg = seg->next;
     }
 
+  /* Don't walk that far again */
+  if (n_segments >= LINE_OFFSETS_MIN_SEGMENTS)
+    line_update_offsets (line, tree);
+
   if (seg == NULL)
     {
       /* end of the line */
@@ -4745,6 +5023,8 @@ gtk_text_line_new (void)
   GtkTextLine *line;
 
   line = g_slice_new0 (GtkTextLine);
+  line->char_count = -1;
+  line->byte_count = -1;
   line->dir_strong = PANGO_DIRECTION_NEUTRAL;
   line->dir_propagated_forward = PANGO_DIRECTION_NEUTRAL;
   line->dir_propagated_back = PANGO_DIRECTION_NEUTRAL;
@@ -4775,6 +5055,14 @@ gtk_text_line_destroy (GtkTextBTree *tree, GtkTextLine *line)
       ld = next;
     }
 
+  if (tree->search_index)
+    _gtk_text_search_index_invalidate_line (tree->search_index, line);
+
+  if (tree->position_cache_line == line)
+    tree->position_cache_stamp = tree->chars_changed_stamp - 1;
+
+  g_free (line->offsets);
+
   g_slice_free (GtkTextLine, line);
 }
 
@@ -4794,6 +5082,8 @@ cleanup_line (GtkTextLine *line)
   GtkTextLineSegment *seg, **prev_p;
   gboolean changed;
 
+  _gtk_text_line_segments_changed (line);
+
   /*
    * Make a pass over all of the segments in the line, giving each
    * a chance to clean itself up.  This could potentially change
@@ -5060,6 +5350,59 @@ _gtk_text_btree_is_valid (GtkTextBTree *tree,
   return (nd && nd->valid);
 }
 
+/**
+ * _gtk_text_btree_get_first_invalid_line:
+ * @tree: a #GtkTextBTree
+ * @view_id: view id
+ *
+ * Finds the line that _gtk_text_btree_validate() wraps first.
+ *
+ * Returns: the first invalid line, or %NULL if the entire tree
+ * is valid
+ **/
+GtkTextLine *
+_gtk_text_btree_get_first_invalid_line (GtkTextBTree *tree,
+                                        gpointer      view_id)
+{
+  GtkTextBTreeNode *node;
+  GtkTextLine *line;
+  NodeData *nd;
+
+  g_return_val_if_fail (tree != NULL, NULL);
+
+  node = tree->root_node;
+  nd = node_data_find (node->node_data, view_id);
+  if (nd && nd->valid)
+    return NULL;
+
+  while (node->level > 0)
+    {
+      GtkTextBTreeNode *child;
+
+      for (child = node->children.node; child != NULL; child = child->next)
+        {
+          nd = node_data_find (child->node_data, view_id);
+          if (!nd || !nd->valid)
+            break;
+        }
+
+      if (child == NULL)
+        return NULL;
+
+      node = child;
+    }
+
+  for (line = node->children.line; line != NULL; line = line->next)
+    {
+      GtkTextLineData *ld = _gtk_text_line_get_data (line, view_id);
+
+      if (!ld || !ld->valid)
+        return line;
+    }
+
+  return NULL;
+}
+
 typedef struct _ValidateState ValidateState;
 
 struct _ValidateState
@@ -6746,6 +7089,9 @@ gtk_text_btree_node_check_consistency (GtkTextBTree     *tree,
       for (line = node->children.line; line != NULL;
            line = line->next)
         {
+          gint line_chars = 0;
+          gint line_bytes = 0;
+
           if (line->parent != node)
             {
               g_error ("gtk_text_btree_node_check_consistency: line doesn't point to parent");
@@ -6783,6 +7129,15 @@ gtk_text_btree_node_check_consistency (GtkTextBTree     *tree,
                 }
 
               num_chars += segPtr->char_count;
+              line_chars += segPtr->char_count;
+              line_bytes += segPtr->byte_count;
+            }
+
+          if ((line->char_count >= 0 && line->char_count != line_chars) ||
+              (line->byte_count >= 0 && line->byte_count != line_bytes))
+            {
+              g_error ("gtk_text_btree_node_check_consistency: cached line size is %d chars, %d bytes instead of %d chars, %d bytes",
+                       line->char_count, line->byte_count, line_chars, line_bytes);
             }
 
           num_children++;
@@ -6931,6 +7286,14 @@ list_of_tags (GtkTextTagTable *table)
   return list;
 }
 
+/* The segment offsets of the line that @iter is on, or %NULL if
+ * they were not computed */
+GtkTextLineOffsets *
+_gtk_text_btree_get_line_offsets (const GtkTextIter *iter)
+{
+  return _gtk_text_iter_get_text_line (iter)->offsets;
+}
+
 void
 _gtk_text_btree_check (GtkTextBTree *tree)
 {
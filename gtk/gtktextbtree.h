@@ -44,12 +44,19 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GtkTextSearchIndex GtkTextSearchIndex;
+
 GtkTextBTree  *_gtk_text_btree_new        (GtkTextTagTable *table,
                                            GtkTextBuffer   *buffer);
 void           _gtk_text_btree_ref        (GtkTextBTree    *tree);
 void           _gtk_text_btree_unref      (GtkTextBTree    *tree);
 GtkTextBuffer *_gtk_text_btree_get_buffer (GtkTextBTree    *tree);
 
+/* Search index, see gtktextsearchindexprivate.h */
+void                _gtk_text_btree_set_search_index_enabled (GtkTextBTree *tree,
+                                                              gboolean      enabled);
+GtkTextSearchIndex *_gtk_text_btree_get_search_index         (GtkTextBTree *tree);
+
 
 guint _gtk_text_btree_get_chars_changed_stamp    (GtkTextBTree *tree);
 guint _gtk_text_btree_get_segments_changed_stamp (GtkTextBTree *tree);
@@ -107,6 +114,8 @@ gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
 void         _gtk_text_btree_validate_line     (GtkTextBTree      *tree,
                                                 GtkTextLine       *line,
                                                 gpointer           view_id);
+GtkTextLine *_gtk_text_btree_get_first_invalid_line (GtkTextBTree *tree,
+                                                     gpointer      view_id);
 
 /* Tag */
 
@@ -233,6 +242,8 @@ struct _GtkTextLineData {
  * You can consider this line a "paragraph" also
  */
 
+typedef struct _GtkTextLineOffsets GtkTextLineOffsets;
+
 struct _GtkTextLine {
   GtkTextBTreeNode *parent;             /* Pointer to parent node containing
                                          * line. */
@@ -242,6 +253,11 @@ struct _GtkTextLine {
   GtkTextLineSegment *segments; /* First in ordered list of segments
                                  * that make up the line. */
   GtkTextLineData *views;      /* data stored here by views */
+  GtkTextLineOffsets *offsets;  /* Where the segments start, for lines
+                                 * with many segments, or NULL. Dropped
+                                 * when the segments of the line change */
+  gint char_count;              /* Sum of the segment sizes, or -1 if */
+  gint byte_count;              /* they need to be computed again */
   guchar dir_strong;                /* BiDi algo dir of line */
   guchar dir_propagated_back;       /* BiDi algo dir of next line */
   guchar dir_propagated_forward;    /* BiDi algo dir of prev line */
@@ -272,6 +288,7 @@ gpointer            _gtk_text_line_get_data                   (GtkTextLine
                                                                gpointer             view_id);
 void                _gtk_text_line_invalidate_wrap            (GtkTextLine         *line,
                                                                GtkTextLineData     *ld);
+void                _gtk_text_line_segments_changed           (GtkTextLine         *line);
 gint                _gtk_text_line_char_count                 (GtkTextLine         *line);
 gint                _gtk_text_line_byte_count                 (GtkTextLine         *line);
 gint                _gtk_text_line_char_index                 (GtkTextLine         *line);
@@ -282,12 +299,14 @@ GtkTextLineSegment *_gtk_text_line_char_to_segment            (GtkTextLine
                                                                gint                 char_offset,
                                                                gint                *seg_offset);
 gboolean            _gtk_text_line_byte_locate                (GtkTextLine         *line,
+                                                               GtkTextBTree        *tree,
                                                                gint                 byte_offset,
                                                                GtkTextLineSegment **segment,
                                                                GtkTextLineSegment **any_segment,
                                                                gint                *seg_byte_offset,
                                                                gint                *line_byte_offset);
 gboolean            _gtk_text_line_char_locate                (GtkTextLine         *line,
+                                                               GtkTextBTree        *tree,
                                                                gint                 char_offset,
                                                                GtkTextLineSegment **segment,
                                                                GtkTextLineSegment **any_segment,
@@ -326,6 +345,10 @@ void _gtk_text_btree_check (GtkTextBTree *tree);
 void _gtk_text_btree_spew (GtkTextBTree *tree);
 extern gboolean _gtk_text_view_debug_btree;
 
+/* Needs to be exported for testsuite/gtk/textbuffer */
+GDK_AVAILABLE_IN_ALL
+GtkTextLineOffsets *_gtk_text_btree_get_line_offsets (const GtkTextIter *iter);
+
 /* ignore, exported only for gtktextsegment.c */
 void _gtk_toggle_segment_check_func (GtkTextLineSegment *segPtr,
                                      GtkTextLine        *line);
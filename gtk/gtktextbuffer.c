@@ -119,6 +119,7 @@ enum {
   PROP_CURSOR_POSITION,
   PROP_COPY_TARGET_LIST,
   PROP_PASTE_TARGET_LIST,
+  PROP_ENABLE_SEARCH_INDEX,
   LAST_PROP
 };
 
@@ -281,6 +282,25 @@ gtk_text_buffer_class_init (GtkTextBufferClass *klass)
                           GTK_TYPE_TARGET_LIST,
                           GTK_PARAM_READABLE);
 
+  /**
+   * GtkTextBuffer:enable-search-index:
+   *
+   * Whether the buffer keeps an index of its text, which lets
+   * gtk_text_iter_forward_search() and gtk_text_buffer_find_all()
+   * skip the lines that can't contain the search string.
+   *
+   * The index is kept up to date as the text changes, and costs some
+   * memory for every line that has been searched.
+   *
+   * Since: 3.92
+   */
+  text_buffer_props[PROP_ENABLE_SEARCH_INDEX] =
+      g_param_spec_boolean ("enable-search-index",
+                            P_("Enable search index"),
+                            P_("Whether the buffer keeps an index of its text to speed up searches"),
+                            FALSE,
+                            GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (object_class, LAST_PROP, text_buffer_props);
 
   /**
@@ -705,6 +725,10 @@ gtk_text_buffer_set_property (GObject         *object,
 				g_value_get_string (value), -1);
       break;
 
+    case PROP_ENABLE_SEARCH_INDEX:
+      gtk_text_buffer_set_enable_search_index (text_buffer, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -759,6 +783,10 @@ gtk_text_buffer_get_property (GObject         *object,
       g_value_set_boxed (value, gtk_text_buffer_get_paste_target_list (text_buffer));
       break;
 
+    case PROP_ENABLE_SEARCH_INDEX:
+      g_value_set_boolean (value, gtk_text_buffer_get_enable_search_index (text_buffer));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3141,6 +3169,115 @@ gtk_text_buffer_get_has_selection (GtkTextBuffer *buffer)
   return buffer->priv->has_selection;
 }
 
+/**
+ * gtk_text_buffer_set_enable_search_index:
+ * @buffer: a #GtkTextBuffer
+ * @enable: whether to keep a search index
+ *
+ * Sets whether @buffer keeps an index of its text, to speed up
+ * repeated searches in large buffers. See
+ * #GtkTextBuffer:enable-search-index.
+ *
+ * Since: 3.92
+ **/
+void
+gtk_text_buffer_set_enable_search_index (GtkTextBuffer *buffer,
+                                         gboolean       enable)
+{
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+
+  enable = enable != FALSE;
+
+  if (gtk_text_buffer_get_enable_search_index (buffer) == enable)
+    return;
+
+  _gtk_text_btree_set_search_index_enabled (get_btree (buffer), enable);
+
+  g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_ENABLE_SEARCH_INDEX]);
+}
+
+/**
+ * gtk_text_buffer_get_enable_search_index:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Returns whether @buffer keeps a search index. See
+ * gtk_text_buffer_set_enable_search_index().
+ *
+ * Returns: %TRUE if @buffer keeps a search index
+ *
+ * Since: 3.92
+ **/
+gboolean
+gtk_text_buffer_get_enable_search_index (GtkTextBuffer *buffer)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), FALSE);
+
+  return _gtk_text_btree_get_search_index (get_btree (buffer)) != NULL;
+}
+
+/**
+ * gtk_text_buffer_find_all:
+ * @buffer: a #GtkTextBuffer
+ * @str: a search string
+ * @flags: flags affecting how the search is done
+ * @start: (allow-none): where to start searching, or %NULL for the
+ *     start of the buffer
+ * @end: (allow-none): where to stop searching, or %NULL for the end
+ *     of the buffer
+ *
+ * Finds all the places between @start and @end where @str occurs,
+ * like calling gtk_text_iter_forward_search() repeatedly. Matches
+ * don't overlap.
+ *
+ * With #GtkTextBuffer:enable-search-index set, this only looks at
+ * the text of lines that may contain @str.
+ *
+ * Returns: (transfer full) (element-type GtkTextIter): an array
+ *     with the start and end of every match, one after the other.
+ *     Free it with g_array_unref().
+ *
+ * Since: 3.92
+ **/
+GArray *
+gtk_text_buffer_find_all (GtkTextBuffer     *buffer,
+                          const gchar       *str,
+                          GtkTextSearchFlags flags,
+                          const GtkTextIter *start,
+                          const GtkTextIter *end)
+{
+  GtkTextIter iter, limit, match_start, match_end;
+  GArray *matches;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+  g_return_val_if_fail (str != NULL, NULL);
+  g_return_val_if_fail (start == NULL || gtk_text_iter_get_buffer (start) == buffer, NULL);
+  g_return_val_if_fail (end == NULL || gtk_text_iter_get_buffer (end) == buffer, NULL);
+
+  matches = g_array_new (FALSE, FALSE, sizeof (GtkTextIter));
+
+  if (start)
+    iter = *start;
+  else
+    gtk_text_buffer_get_start_iter (buffer, &iter);
+
+  if (end)
+    limit = *end;
+  else
+    gtk_text_buffer_get_end_iter (buffer, &limit);
+
+  while (gtk_text_iter_forward_search (&iter, str, flags,
+                                       &match_start, &match_end, &limit))
+    {
+      g_array_append_val (matches, match_start);
+      g_array_append_val (matches, match_end);
+
+      /* An empty @str is found after @iter, so this always advances */
+      iter = match_end;
+    }
+
+  return matches;
+}
+
 
 /*
  * Assorted other stuff
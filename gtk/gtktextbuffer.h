@@ -428,6 +428,18 @@ void            gtk_text_buffer_set_modified            (GtkTextBuffer *buffer,
 GDK_AVAILABLE_IN_ALL
 gboolean        gtk_text_buffer_get_has_selection       (GtkTextBuffer *buffer);
 
+GDK_AVAILABLE_IN_3_92
+void            gtk_text_buffer_set_enable_search_index (GtkTextBuffer *buffer,
+                                                         gboolean       enable);
+GDK_AVAILABLE_IN_3_92
+gboolean        gtk_text_buffer_get_enable_search_index (GtkTextBuffer *buffer);
+GDK_AVAILABLE_IN_3_92
+GArray *        gtk_text_buffer_find_all                (GtkTextBuffer     *buffer,
+                                                         const gchar       *str,
+                                                         GtkTextSearchFlags flags,
+                                                         const GtkTextIter *start,
+                                                         const GtkTextIter *end);
+
 GDK_AVAILABLE_IN_ALL
 void gtk_text_buffer_add_selection_clipboard    (GtkTextBuffer     *buffer,
 						 GtkClipboard      *clipboard);
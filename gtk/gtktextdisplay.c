@@ -79,6 +79,8 @@
 #include "gtktextviewprivate.h"
 #include "gtkwidgetprivate.h"
 #include "gtkstylecontextprivate.h"
+#include "gtksnapshotprivate.h"
+#include "gskpango.h"
 #include "gtkintl.h"
 
 /* DO NOT go putting private headers in here. This file should only
@@ -101,12 +103,16 @@ enum {
   CURSOR
 };
 
+/* Glyphs, underlines and strikethroughs are turned into render nodes
+ * by the GskPangoRenderer. This class only picks the colors for the
+ * attributes of the text buffer and handles the shapes of child
+ * anchors.
+ */
 struct _GtkTextRenderer
 {
-  PangoRenderer parent_instance;
+  GskPangoRenderer parent_instance;
 
   GtkWidget *widget;
-  cairo_t *cr;
 
   GdkRGBA *error_color;	/* Error underline color for this widget */
   GList *widgets;      	/* widgets encountered when drawing */
@@ -116,12 +122,18 @@ struct _GtkTextRenderer
 
 struct _GtkTextRendererClass
 {
-  PangoRendererClass parent_class;
+  GskPangoRendererClass parent_class;
 };
 
 GType _gtk_text_renderer_get_type (void);
 
-G_DEFINE_TYPE (GtkTextRenderer, _gtk_text_renderer, PANGO_TYPE_RENDERER)
+G_DEFINE_TYPE (GtkTextRenderer, _gtk_text_renderer, GSK_TYPE_PANGO_RENDERER)
+
+static GtkSnapshot *
+text_renderer_get_snapshot (GtkTextRenderer *text_renderer)
+{
+  return text_renderer->parent_instance.snapshot;
+}
 
 static void
 text_renderer_set_rgba (GtkTextRenderer *text_renderer,
@@ -137,7 +149,8 @@ text_renderer_set_rgba (GtkTextRenderer *text_renderer,
       color.red = (guint16)(rgba->red * 65535);
       color.green = (guint16)(rgba->green * 65535);
       color.blue = (guint16)(rgba->blue * 65535);
-      alpha = (guint16)(rgba->alpha * 65535);
+      /* An alpha of 0 means "unset" to Pango */
+      alpha = MAX ((guint16)(rgba->alpha * 65535), 1);
       pango_renderer_set_color (renderer, part, &color);
       pango_renderer_set_alpha (renderer, part, alpha);
     }
@@ -239,137 +252,24 @@ gtk_text_renderer_prepare_run (PangoRenderer  *renderer,
 }
 
 static void
-set_color (GtkTextRenderer *text_renderer,
-           PangoRenderPart  part)
+get_color (GtkTextRenderer *text_renderer,
+           PangoRenderPart  part,
+           GdkRGBA         *rgba)
 {
   PangoColor *color;
-  GdkRGBA rgba;
   guint16 alpha;
 
-  cairo_save (text_renderer->cr);
-
   color = pango_renderer_get_color (PANGO_RENDERER (text_renderer), part);
   alpha = pango_renderer_get_alpha (PANGO_RENDERER (text_renderer), part);
   if (color)
     {
-      rgba.red = color->red / 65535.;
-      rgba.green = color->green / 65535.;
-      rgba.blue = color->blue / 65535.;
-      rgba.alpha = alpha / 65535.;
-      gdk_cairo_set_source_rgba (text_renderer->cr, &rgba);
+      rgba->red = color->red / 65535.;
+      rgba->green = color->green / 65535.;
+      rgba->blue = color->blue / 65535.;
+      rgba->alpha = alpha / 65535.;
     }
-}
-
-static void
-unset_color (GtkTextRenderer *text_renderer)
-{
-  cairo_restore (text_renderer->cr);
-}
-
-static void
-gtk_text_renderer_draw_glyphs (PangoRenderer     *renderer,
-                               PangoFont         *font,
-                               PangoGlyphString  *glyphs,
-                               int                x,
-                               int                y)
-{
-  GtkTextRenderer *text_renderer = GTK_TEXT_RENDERER (renderer);
-
-  set_color (text_renderer, PANGO_RENDER_PART_FOREGROUND);
-
-  cairo_move_to (text_renderer->cr, (double)x / PANGO_SCALE, (double)y / PANGO_SCALE);
-  pango_cairo_show_glyph_string (text_renderer->cr, font, glyphs);
-
-  unset_color (text_renderer);
-}
-
-static void
-gtk_text_renderer_draw_glyph_item (PangoRenderer     *renderer,
-                                   const char        *text,
-                                   PangoGlyphItem    *glyph_item,
-                                   int                x,
-                                   int                y)
-{
-  GtkTextRenderer *text_renderer = GTK_TEXT_RENDERER (renderer);
-
-  set_color (text_renderer, PANGO_RENDER_PART_FOREGROUND);
-
-  cairo_move_to (text_renderer->cr, (double)x / PANGO_SCALE, (double)y / PANGO_SCALE);
-  pango_cairo_show_glyph_item (text_renderer->cr, text, glyph_item);
-
-  unset_color (text_renderer);
-}
-
-static void
-gtk_text_renderer_draw_rectangle (PangoRenderer     *renderer,
-				  PangoRenderPart    part,
-				  int                x,
-				  int                y,
-				  int                width,
-				  int                height)
-{
-  GtkTextRenderer *text_renderer = GTK_TEXT_RENDERER (renderer);
-
-  set_color (text_renderer, part);
-
-  cairo_rectangle (text_renderer->cr,
-                   (double)x / PANGO_SCALE, (double)y / PANGO_SCALE,
-		   (double)width / PANGO_SCALE, (double)height / PANGO_SCALE);
-  cairo_fill (text_renderer->cr);
-
-  unset_color (text_renderer);
-}
-
-static void
-gtk_text_renderer_draw_trapezoid (PangoRenderer     *renderer,
-				  PangoRenderPart    part,
-				  double             y1_,
-				  double             x11,
-				  double             x21,
-				  double             y2,
-				  double             x12,
-				  double             x22)
-{
-  GtkTextRenderer *text_renderer = GTK_TEXT_RENDERER (renderer);
-  cairo_t *cr;
-  cairo_matrix_t matrix;
-
-  set_color (text_renderer, part);
-
-  cr = text_renderer->cr;
-
-  cairo_get_matrix (cr, &matrix);
-  matrix.xx = matrix.yy = 1.0;
-  matrix.xy = matrix.yx = 0.0;
-  cairo_set_matrix (cr, &matrix);
-
-  cairo_move_to (cr, x11, y1_);
-  cairo_line_to (cr, x21, y1_);
-  cairo_line_to (cr, x22, y2);
-  cairo_line_to (cr, x12, y2);
-  cairo_close_path (cr);
-
-  cairo_fill (cr);
-
-  unset_color (text_renderer);
-}
-
-static void
-gtk_text_renderer_draw_error_underline (PangoRenderer *renderer,
-					int            x,
-					int            y,
-					int            width,
-					int            height)
-{
-  GtkTextRenderer *text_renderer = GTK_TEXT_RENDERER (renderer);
-
-  set_color (text_renderer, PANGO_RENDER_PART_UNDERLINE);
-
-  pango_cairo_show_error_underline (text_renderer->cr,
-                                    (double)x / PANGO_SCALE, (double)y / PANGO_SCALE,
-                                    (double)width / PANGO_SCALE, (double)height / PANGO_SCALE);
-
-  unset_color (text_renderer);
+  else
+    *rgba = text_renderer->parent_instance.fg_color;
 }
 
 static void
@@ -379,6 +279,7 @@ gtk_text_renderer_draw_shape (PangoRenderer   *renderer,
 			      int              y)
 {
   GtkTextRenderer *text_renderer = GTK_TEXT_RENDERER (renderer);
+  GtkSnapshot *snapshot = text_renderer_get_snapshot (text_renderer);
 
   if (attr->data == NULL)
     {
@@ -386,6 +287,8 @@ gtk_text_renderer_draw_shape (PangoRenderer   *renderer,
        * something empty-looking.
        */
       GdkRectangle shape_rect;
+      graphene_rect_t bounds;
+      GdkRGBA color;
       cairo_t *cr;
 
       shape_rect.x = PANGO_PIXELS (x);
@@ -393,9 +296,13 @@ gtk_text_renderer_draw_shape (PangoRenderer   *renderer,
       shape_rect.width = PANGO_PIXELS (x + attr->logical_rect.width) - shape_rect.x;
       shape_rect.height = PANGO_PIXELS (y + attr->logical_rect.y + attr->logical_rect.height) - shape_rect.y;
 
-      set_color (text_renderer, PANGO_RENDER_PART_FOREGROUND);
+      graphene_rect_init (&bounds,
+                          shape_rect.x, shape_rect.y,
+                          shape_rect.width, shape_rect.height);
+      cr = gtk_snapshot_append_cairo (snapshot, &bounds, "EmptyAnchor");
 
-      cr = text_renderer->cr;
+      get_color (text_renderer, PANGO_RENDER_PART_FOREGROUND, &color);
+      gdk_cairo_set_source_rgba (cr, &color);
 
       cairo_set_line_width (cr, 1.0);
 
@@ -413,21 +320,23 @@ gtk_text_renderer_draw_shape (PangoRenderer   *renderer,
 
       cairo_stroke (cr);
 
-      unset_color (text_renderer);
+      cairo_destroy (cr);
     }
   else if (GDK_IS_PIXBUF (attr->data))
     {
-      cairo_t *cr = text_renderer->cr;
       GdkPixbuf *pixbuf = GDK_PIXBUF (attr->data);
-      
-      cairo_save (cr);
-
-      gdk_cairo_set_source_pixbuf (cr, pixbuf,
-                                   PANGO_PIXELS (x),
-                                   PANGO_PIXELS (y) -  gdk_pixbuf_get_height (pixbuf));
-      cairo_paint (cr);
-
-      cairo_restore (cr);
+      GskTexture *texture;
+      graphene_rect_t bounds;
+
+      graphene_rect_init (&bounds,
+                          PANGO_PIXELS (x),
+                          PANGO_PIXELS (y) - gdk_pixbuf_get_height (pixbuf),
+                          gdk_pixbuf_get_width (pixbuf),
+                          gdk_pixbuf_get_height (pixbuf));
+
+      texture = gsk_texture_new_for_pixbuf (pixbuf);
+      gtk_snapshot_append_texture (snapshot, texture, &bounds, "TextPixbuf");
+      g_object_unref (texture);
     }
   else if (GTK_IS_WIDGET (attr->data))
     {
@@ -461,11 +370,6 @@ _gtk_text_renderer_class_init (GtkTextRendererClass *klass)
   PangoRendererClass *renderer_class = PANGO_RENDERER_CLASS (klass);
   
   renderer_class->prepare_run = gtk_text_renderer_prepare_run;
-  renderer_class->draw_glyphs = gtk_text_renderer_draw_glyphs;
-  renderer_class->draw_glyph_item = gtk_text_renderer_draw_glyph_item;
-  renderer_class->draw_rectangle = gtk_text_renderer_draw_rectangle;
-  renderer_class->draw_trapezoid = gtk_text_renderer_draw_trapezoid;
-  renderer_class->draw_error_underline = gtk_text_renderer_draw_error_underline;
   renderer_class->draw_shape = gtk_text_renderer_draw_shape;
 
   object_class->finalize = gtk_text_renderer_finalize;
@@ -481,25 +385,20 @@ text_renderer_set_state (GtkTextRenderer *text_renderer,
 static void
 text_renderer_begin (GtkTextRenderer *text_renderer,
                      GtkWidget       *widget,
-                     cairo_t         *cr)
+                     GtkSnapshot     *snapshot)
 {
   GtkStyleContext *context;
-  GdkRGBA color;
   GtkCssNode *text_node;
 
   text_renderer->widget = widget;
-  text_renderer->cr = cr;
+  text_renderer->parent_instance.snapshot = snapshot;
 
   context = gtk_widget_get_style_context (widget);
 
   text_node = gtk_text_view_get_text_node ((GtkTextView *)widget);
   gtk_style_context_save_to_node (context, text_node);
 
-  gtk_style_context_get_color (context, &color);
-
-  cairo_save (cr);
-
-  gdk_cairo_set_source_rgba (cr, &color);
+  gtk_style_context_get_color (context, &text_renderer->parent_instance.fg_color);
 }
 
 /* Returns a GSList of (referenced) widgets encountered while drawing.
@@ -510,14 +409,12 @@ text_renderer_end (GtkTextRenderer *text_renderer)
   GtkStyleContext *context;
   GList *widgets = text_renderer->widgets;
 
-  cairo_restore (text_renderer->cr);
-
   context = gtk_widget_get_style_context (text_renderer->widget);
 
   gtk_style_context_restore (context);
 
   text_renderer->widget = NULL;
-  text_renderer->cr = NULL;
+  text_renderer->parent_instance.snapshot = NULL;
 
   text_renderer->widgets = NULL;
 
@@ -569,6 +466,7 @@ render_para (GtkTextRenderer    *text_renderer,
              int                 selection_end_index)
 {
   GtkStyleContext *context;
+  GtkSnapshot *snapshot = text_renderer_get_snapshot (text_renderer);
   PangoLayout *layout = line_display->layout;
   int byte_offset = 0;
   PangoLayoutIter *iter;
@@ -580,6 +478,12 @@ render_para (GtkTextRenderer    *text_renderer,
   iter = pango_layout_get_iter (layout);
   screen_width = line_display->total_width;
 
+  /* Bounds of the cairo nodes for error underlines */
+  graphene_rect_init (&text_renderer->parent_instance.bounds,
+                      0, 0,
+                      line_display->x_offset + line_display->width,
+                      line_display->height);
+
   context = gtk_widget_get_style_context (text_renderer->widget);
   selection_node = gtk_text_view_get_selection_node ((GtkTextView*)text_renderer->widget);
   gtk_style_context_save_to_node (context, selection_node);
@@ -630,15 +534,10 @@ G_GNUC_END_IGNORE_DEPRECATIONS
       if (selection_start_index < byte_offset &&
           selection_end_index > line->length + byte_offset) /* All selected */
         {
-          cairo_t *cr = text_renderer->cr;
-
-          cairo_save (cr);
-          gdk_cairo_set_source_rgba (cr, &selection);
-          cairo_rectangle (cr, 
-                           line_display->left_margin, selection_y,
-                           screen_width, selection_height);
-          cairo_fill (cr);
-          cairo_restore(cr);
+          gtk_snapshot_append_color (snapshot, &selection,
+                                     &GRAPHENE_RECT_INIT (line_display->left_margin, selection_y,
+                                                          screen_width, selection_height),
+                                     "TextSelection");
 
 	  text_renderer_set_state (text_renderer, SELECTED);
 	  pango_renderer_draw_layout_line (PANGO_RENDERER (text_renderer),
@@ -650,17 +549,10 @@ G_GNUC_END_IGNORE_DEPRECATIONS
         {
           if (line_display->pg_bg_rgba)
             {
-              cairo_t *cr = text_renderer->cr;
-
-              cairo_save (cr);
- 
-	      gdk_cairo_set_source_rgba (text_renderer->cr, line_display->pg_bg_rgba);
-              cairo_rectangle (cr, 
-                               line_display->left_margin, selection_y,
-                               screen_width, selection_height);
-              cairo_fill (cr);
-
-              cairo_restore (cr);
+              gtk_snapshot_append_color (snapshot, line_display->pg_bg_rgba,
+                                         &GRAPHENE_RECT_INIT (line_display->left_margin, selection_y,
+                                                              screen_width, selection_height),
+                                         "ParagraphBackground");
             }
         
 	  text_renderer_set_state (text_renderer, NORMAL);
@@ -677,50 +569,56 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 	       (selection_start_index == byte_offset + line->length && pango_layout_iter_at_last_line (iter))) &&
 	      selection_end_index > byte_offset)
             {
-              cairo_t *cr = text_renderer->cr;
               cairo_region_t *clip_region = get_selected_clip (text_renderer, layout, line,
                                                           line_display->x_offset,
                                                           selection_y,
                                                           selection_height,
                                                           selection_start_index, selection_end_index);
+              int i;
 
-              cairo_save (cr);
-              gdk_cairo_region (cr, clip_region);
-              cairo_clip (cr);
-              cairo_region_destroy (clip_region);
+              /* The selected text is drawn again on top, clipped to
+               * each range of the selection
+               */
+              for (i = 0; i < cairo_region_num_rectangles (clip_region); i++)
+                {
+                  cairo_rectangle_int_t clip_rect;
 
-              gdk_cairo_set_source_rgba (cr, &selection);
-              cairo_rectangle (cr,
-                               PANGO_PIXELS (line_rect.x),
-                               selection_y,
-                               PANGO_PIXELS (line_rect.width),
-                               selection_height);
-              cairo_fill (cr);
+                  cairo_region_get_rectangle (clip_region, i, &clip_rect);
 
-	      text_renderer_set_state (text_renderer, SELECTED);
-	      pango_renderer_draw_layout_line (PANGO_RENDERER (text_renderer),
-					       line, 
-					       line_rect.x,
-					       baseline);
+                  gtk_snapshot_push_clip (snapshot,
+                                          &GRAPHENE_RECT_INIT (clip_rect.x, clip_rect.y,
+                                                               clip_rect.width, clip_rect.height),
+                                          "TextSelectionClip");
+
+                  gtk_snapshot_append_color (snapshot, &selection,
+                                             &GRAPHENE_RECT_INIT (PANGO_PIXELS (line_rect.x),
+                                                                  selection_y,
+                                                                  PANGO_PIXELS (line_rect.width),
+                                                                  selection_height),
+                                             "TextSelection");
+
+                  text_renderer_set_state (text_renderer, SELECTED);
+                  pango_renderer_draw_layout_line (PANGO_RENDERER (text_renderer),
+                                                   line, 
+                                                   line_rect.x,
+                                                   baseline);
+
+                  gtk_snapshot_pop (snapshot);
+                }
 
-              cairo_restore (cr);
+              cairo_region_destroy (clip_region);
 
               /* Paint in the ends of the line */
               if (line_rect.x > line_display->left_margin * PANGO_SCALE &&
                   ((line_display->direction == GTK_TEXT_DIR_LTR && selection_start_index < byte_offset) ||
                    (line_display->direction == GTK_TEXT_DIR_RTL && selection_end_index > byte_offset + line->length)))
                 {
-                  cairo_save (cr);
-
-                  gdk_cairo_set_source_rgba (cr, &selection);
-                  cairo_rectangle (cr,
-                                   line_display->left_margin,
-                                   selection_y,
-                                   PANGO_PIXELS (line_rect.x) - line_display->left_margin,
-                                   selection_height);
-                  cairo_fill (cr);
-
-                  cairo_restore (cr);
+                  gtk_snapshot_append_color (snapshot, &selection,
+                                             &GRAPHENE_RECT_INIT (line_display->left_margin,
+                                                                  selection_y,
+                                                                  PANGO_PIXELS (line_rect.x) - line_display->left_margin,
+                                                                  selection_height),
+                                             "TextSelection");
                 }
 
               if (line_rect.x + line_rect.width <
@@ -734,17 +632,12 @@ G_GNUC_END_IGNORE_DEPRECATIONS
                     line_display->left_margin + screen_width -
                     PANGO_PIXELS (line_rect.x) - PANGO_PIXELS (line_rect.width);
 
-                  cairo_save (cr);
-
-                  gdk_cairo_set_source_rgba (cr, &selection);
-                  cairo_rectangle (cr,
-                                   PANGO_PIXELS (line_rect.x) + PANGO_PIXELS (line_rect.width),
-                                   selection_y,
-                                   nonlayout_width,
-                                   selection_height);
-                  cairo_fill (cr);
-
-                  cairo_restore (cr);
+                  gtk_snapshot_append_color (snapshot, &selection,
+                                             &GRAPHENE_RECT_INIT (PANGO_PIXELS (line_rect.x) + PANGO_PIXELS (line_rect.width),
+                                                                  selection_y,
+                                                                  nonlayout_width,
+                                                                  selection_height),
+                                             "TextSelection");
                 }
             }
 	  else if (line_display->has_block_cursor &&
@@ -753,38 +646,26 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 		   (line_display->insert_index < byte_offset + line->length ||
 		    (at_last_line && line_display->insert_index == byte_offset + line->length)))
 	    {
-	      GdkRectangle cursor_rect;
+	      graphene_rect_t cursor_rect;
               GdkRGBA cursor_color;
-              cairo_t *cr = text_renderer->cr;
 
               /* we draw text using base color on filled cursor rectangle of cursor color
                * (normally white on black) */
               _gtk_style_context_get_cursor_color (context, &cursor_color, NULL);
 
-	      cursor_rect.x = line_display->x_offset + line_display->block_cursor.x;
-	      cursor_rect.y = line_display->block_cursor.y + line_display->top_margin;
-	      cursor_rect.width = line_display->block_cursor.width;
-	      cursor_rect.height = line_display->block_cursor.height;
+              graphene_rect_init (&cursor_rect,
+                                  line_display->x_offset + line_display->block_cursor.x,
+                                  line_display->block_cursor.y + line_display->top_margin,
+                                  line_display->block_cursor.width,
+                                  line_display->block_cursor.height);
 
-              cairo_save (cr);
+              gtk_snapshot_push_clip (snapshot, &cursor_rect, "BlockCursorClip");
 
-              gdk_cairo_rectangle (cr, &cursor_rect);
-              cairo_clip (cr);
-
-              gdk_cairo_set_source_rgba (cr, &cursor_color);
-              cairo_paint (cr);
+              gtk_snapshot_append_color (snapshot, &cursor_color, &cursor_rect, "BlockCursor");
 
               /* draw text under the cursor if any */
               if (!line_display->cursor_at_line_end)
                 {
-                  GdkRGBA color;
-
-G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-                  gtk_style_context_get_background_color (context, &color);
-G_GNUC_END_IGNORE_DEPRECATIONS
-
-                  gdk_cairo_set_source_rgba (cr, &color);
-
 		  text_renderer_set_state (text_renderer, CURSOR);
 
 		  pango_renderer_draw_layout_line (PANGO_RENDERER (text_renderer),
@@ -793,7 +674,7 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 						   baseline);
                 }
 
-              cairo_restore (cr);
+              gtk_snapshot_pop (snapshot);
 	    }
         }
 
@@ -804,6 +685,56 @@ G_GNUC_END_IGNORE_DEPRECATIONS
   pango_layout_iter_free (iter);
 }
 
+/* Lines that stay in the line display cache of the layout keep the
+ * render node they were drawn with, in the coordinates of the line.
+ * Drawing them again, which mostly happens when scrolling, only
+ * appends a transform node that moves the old node to its new place.
+ * Changing the text or the attributes of a line drops its display,
+ * and the node with it; gtk_text_layout_invalidate_line_nodes() drops
+ * the nodes of all lines when the colors of the text view change.
+ */
+static void
+snapshot_line_node (GtkTextRenderer    *text_renderer,
+                    GtkTextLineDisplay *line_display,
+                    int                 selection_start_index,
+                    int                 selection_end_index)
+{
+  GtkSnapshot *snapshot = text_renderer_get_snapshot (text_renderer);
+  graphene_matrix_t transform;
+  GskRenderNode *node;
+  int x, y;
+
+  if (!line_display->node_valid ||
+      line_display->node_selection_start != selection_start_index ||
+      line_display->node_selection_end != selection_end_index ||
+      line_display->node_named != !!snapshot->record_names)
+    {
+      g_clear_pointer (&line_display->node, gsk_render_node_unref);
+
+      gtk_snapshot_push (snapshot, FALSE, "TextLine");
+      render_para (text_renderer, line_display,
+                   selection_start_index, selection_end_index);
+      line_display->node = gtk_snapshot_pop_collect (snapshot);
+
+      line_display->node_valid = TRUE;
+      line_display->node_named = !!snapshot->record_names;
+      line_display->node_selection_start = selection_start_index;
+      line_display->node_selection_end = selection_end_index;
+    }
+
+  if (line_display->node == NULL)
+    return;
+
+  gtk_snapshot_get_offset (snapshot, &x, &y);
+  graphene_matrix_init_translate (&transform, &GRAPHENE_POINT3D_INIT (x, y, 0));
+
+  node = gsk_transform_node_new (line_display->node, &transform);
+  if (snapshot->record_names)
+    gsk_render_node_set_name (node, "TextLineOffset");
+  gtk_snapshot_append_node (snapshot, node);
+  gsk_render_node_unref (node);
+}
+
 static GtkTextRenderer *
 get_text_renderer (void)
 {
@@ -815,11 +746,13 @@ get_text_renderer (void)
   return text_renderer;
 }
 
-void
-gtk_text_layout_draw (GtkTextLayout *layout,
-                      GtkWidget *widget,
-                      cairo_t *cr,
-                      GList **widgets)
+static void
+gtk_text_layout_snapshot_internal (GtkTextLayout      *layout,
+                                   GtkWidget          *widget,
+                                   GtkSnapshot        *snapshot,
+                                   const GdkRectangle *clip,
+                                   gboolean            use_line_nodes,
+                                   GList             **widgets)
 {
   GtkStyleContext *context;
   gint offset_y;
@@ -829,28 +762,18 @@ gtk_text_layout_draw (GtkTextLayout *layout,
   GSList *line_list;
   GSList *tmp_list;
   GList *tmp_widgets;
-  GdkRectangle clip;
-
-  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
-  g_return_if_fail (layout->default_style != NULL);
-  g_return_if_fail (layout->buffer != NULL);
-  g_return_if_fail (cr != NULL);
-
-  if (!gdk_cairo_get_clip_rectangle (cr, &clip))
-    return;
 
   context = gtk_widget_get_style_context (widget);
 
-  line_list = gtk_text_layout_get_lines (layout, clip.y, clip.y + clip.height, &offset_y);
+  line_list = gtk_text_layout_get_lines (layout, clip->y, clip->y + clip->height, &offset_y);
 
   if (line_list == NULL)
     return; /* nothing on the screen */
 
   text_renderer = get_text_renderer ();
-  text_renderer_begin (text_renderer, widget, cr);
+  text_renderer_begin (text_renderer, widget, snapshot);
 
-  /* text_renderer_begin/end does cairo_save/restore */
-  cairo_translate (cr, 0, offset_y);
+  gtk_snapshot_offset (snapshot, 0, offset_y);
 
   gtk_text_layout_wrap_loop_start (layout);
 
@@ -901,8 +824,17 @@ gtk_text_layout_draw (GtkTextLayout *layout,
                 }
             }
 
-          render_para (text_renderer, line_display,
-                       selection_start_index, selection_end_index);
+          /* A block cursor is only drawn while the widget has the
+           * focus, so its line is not kept as a node.
+           */
+          if (use_line_nodes &&
+              line_display->cached &&
+              !line_display->has_block_cursor)
+            snapshot_line_node (text_renderer, line_display,
+                                selection_start_index, selection_end_index);
+          else
+            render_para (text_renderer, line_display,
+                         selection_start_index, selection_end_index);
 
           /* We paint the cursors last, because they overlap another chunk
            * and need to appear on top.
@@ -918,14 +850,15 @@ gtk_text_layout_draw (GtkTextLayout *layout,
 
                   index = g_array_index(line_display->cursors, int, i);
                   dir = (line_display->direction == GTK_TEXT_DIR_RTL) ? PANGO_DIRECTION_RTL : PANGO_DIRECTION_LTR;
-                  gtk_render_insertion_cursor (context, cr,
-                                               line_display->x_offset, line_display->top_margin,
-                                               line_display->layout, index, dir);
+                  gtk_snapshot_render_insertion_cursor (snapshot, context,
+                                                        line_display->x_offset, line_display->top_margin,
+                                                        line_display->layout, index, dir);
                 }
             }
         } /* line_display->height > 0 */
 
-      cairo_translate (cr, 0, line_display->height);
+      gtk_snapshot_offset (snapshot, 0, line_display->height);
+      offset_y += line_display->height;
       gtk_text_layout_free_line_display (layout, line_display);
       
       tmp_list = tmp_list->next;
@@ -933,6 +866,8 @@ gtk_text_layout_draw (GtkTextLayout *layout,
 
   gtk_text_layout_wrap_loop_end (layout);
 
+  gtk_snapshot_offset (snapshot, 0, - offset_y);
+
   tmp_widgets = text_renderer_end (text_renderer);
   if (widgets)
     *widgets = tmp_widgets;
@@ -941,3 +876,50 @@ gtk_text_layout_draw (GtkTextLayout *layout,
 
   g_slist_free (line_list);
 }
+
+void
+gtk_text_layout_snapshot (GtkTextLayout      *layout,
+                          GtkWidget          *widget,
+                          GtkSnapshot        *snapshot,
+                          const GdkRectangle *clip)
+{
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+  g_return_if_fail (layout->default_style != NULL);
+  g_return_if_fail (layout->buffer != NULL);
+  g_return_if_fail (snapshot != NULL);
+  g_return_if_fail (clip != NULL);
+
+  gtk_text_layout_snapshot_internal (layout, widget, snapshot, clip, TRUE, NULL);
+}
+
+void
+gtk_text_layout_draw (GtkTextLayout *layout,
+                      GtkWidget *widget,
+                      cairo_t *cr,
+                      GList **widgets)
+{
+  GtkSnapshot snapshot;
+  GskRenderNode *node;
+  GdkRectangle clip;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+  g_return_if_fail (layout->default_style != NULL);
+  g_return_if_fail (layout->buffer != NULL);
+  g_return_if_fail (cr != NULL);
+
+  if (!gdk_cairo_get_clip_rectangle (cr, &clip))
+    return;
+
+  /* The nodes of cached lines are not used here, as they don't
+   * report the child widgets of the lines.
+   */
+  gtk_snapshot_init (&snapshot, NULL, FALSE, NULL, "GtkTextLayout");
+  gtk_text_layout_snapshot_internal (layout, widget, &snapshot, &clip, FALSE, widgets);
+  node = gtk_snapshot_finish (&snapshot);
+
+  if (node != NULL)
+    {
+      gsk_render_node_draw (node, cr);
+      gsk_render_node_unref (node);
+    }
+}
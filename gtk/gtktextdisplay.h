@@ -96,6 +96,15 @@ void gtk_text_layout_draw (GtkTextLayout        *layout,
                            cairo_t              *cr,
                            GList               **widgets);
 
+/* Like gtk_text_layout_draw(), but appends render nodes to @snapshot.
+ * clip              - Area of the layout to draw, in layout coordinates
+ */
+GDK_AVAILABLE_IN_3_92
+void gtk_text_layout_snapshot (GtkTextLayout        *layout,
+                               GtkWidget            *widget,
+                               GtkSnapshot          *snapshot,
+                               const GdkRectangle   *clip);
+
 
 G_END_DECLS
 
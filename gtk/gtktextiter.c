@@ -28,6 +28,7 @@
 #include "gtktextbtree.h"
 #include "gtktextbufferprivate.h"
 #include "gtktextiterprivate.h"
+#include "gtktextsearchindexprivate.h"
 #include "gtkintl.h"
 #include "gtkdebug.h"
 
@@ -114,6 +115,7 @@ iter_set_from_byte_offset (GtkTextRealIter *iter,
   iter_set_common (iter, line);
 
   if (!_gtk_text_line_byte_locate (iter->line,
+                                   iter->tree,
                                    byte_offset,
                                    &iter->segment,
                                    &iter->any_segment,
@@ -131,6 +133,7 @@ iter_set_from_char_offset (GtkTextRealIter *iter,
   iter_set_common (iter, line);
 
   if (!_gtk_text_line_char_locate (iter->line,
+                                   iter->tree,
                                    char_offset,
                                    &iter->segment,
                                    &iter->any_segment,
@@ -214,6 +217,12 @@ gtk_text_iter_make_real (const GtkTextIter *_iter)
   if (iter->segments_changed_stamp !=
       _gtk_text_btree_get_segments_changed_stamp (iter->tree))
     {
+      /* Only segments changed, not characters, so the iterator is
+       * still at the same char index and line number.
+       */
+      gint cached_char_index = iter->cached_char_index;
+      gint cached_line_number = iter->cached_line_number;
+
       if (iter->line_byte_offset >= 0)
         {
           iter_set_from_byte_offset (iter,
@@ -228,6 +237,9 @@ gtk_text_iter_make_real (const GtkTextIter *_iter)
                                      iter->line,
                                      iter->line_char_offset);
         }
+
+      iter->cached_char_index = cached_char_index;
+      iter->cached_line_number = cached_line_number;
     }
 
   g_assert (iter->segment != NULL);
@@ -4902,6 +4914,8 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
   gboolean visible_only;
   gboolean slice;
   gboolean case_insensitive;
+  GtkTextSearchIndex *index;
+  GtkTextSearchKey *key;
 
   g_return_val_if_fail (iter != NULL, FALSE);
   g_return_val_if_fail (str != NULL, FALSE);
@@ -4939,6 +4953,13 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
 
   lines = strbreakup (str, "\n", -1, NULL, case_insensitive);
 
+  /* The index knows nothing about invisible text */
+  index = _gtk_text_btree_get_search_index (_gtk_text_iter_get_btree (iter));
+  if (index && !visible_only)
+    key = _gtk_text_search_key_new (str, case_insensitive);
+  else
+    key = NULL;
+
   search = *iter;
 
   do
@@ -4952,6 +4973,16 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
       if (limit &&
           gtk_text_iter_compare (&search, limit) >= 0)
         break;
+
+      /* The filter covers whole lines, so a search starting in the
+       * middle of one always looks at its text.
+       */
+      if (key &&
+          gtk_text_iter_starts_line (&search) &&
+          !_gtk_text_search_index_line_may_match (index,
+                                                  _gtk_text_iter_get_text_line (&search),
+                                                  key))
+        continue;
       
       if (lines_match (&search, (const gchar**)lines,
                        visible_only, slice, case_insensitive, &match, &end))
@@ -4974,6 +5005,8 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
     }
   while (gtk_text_iter_forward_line (&search));
 
+  if (key)
+    _gtk_text_search_key_free (key);
   g_strfreev ((gchar**)lines);
 
   return retval;
@@ -5784,7 +5817,7 @@ _gtk_text_iter_check (const GtkTextIter *iter)
 
   if (real->line_byte_offset >= 0)
     {
-      _gtk_text_line_byte_locate (real->line, real->line_byte_offset,
+      _gtk_text_line_byte_locate (real->line, real->tree, real->line_byte_offset,
                                   &byte_segment, &byte_any_segment,
                                   &seg_byte_offset, &line_byte_offset);
 
@@ -5815,7 +5848,7 @@ _gtk_text_iter_check (const GtkTextIter *iter)
 
   if (real->line_char_offset >= 0)
     {
-      _gtk_text_line_char_locate (real->line, real->line_char_offset,
+      _gtk_text_line_char_locate (real->line, real->tree, real->line_char_offset,
                                   &char_segment, &char_any_segment,
                                   &seg_char_offset, &line_char_offset);
 
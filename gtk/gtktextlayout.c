@@ -78,6 +78,7 @@
 #define GTK_TEXT_USE_INTERNAL_UNSUPPORTED_API
 #include "config.h"
 #include "gtkmarshalers.h"
+#include "gtkparallelprivate.h"
 #include "gtktextlayout.h"
 #include "gtktextbtree.h"
 #include "gtktextbufferprivate.h"
@@ -88,6 +89,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined (GDK_WINDOWING_X11) || defined (GDK_WINDOWING_WAYLAND)
+#include <pango/pangofc-fontmap.h>
+#endif
+
 #define GTK_TEXT_LAYOUT_GET_PRIVATE(o)  ((GtkTextLayoutPrivate *) gtk_text_layout_get_instance_private ((o)))
 
 typedef struct _GtkTextLayoutPrivate GtkTextLayoutPrivate;
@@ -98,8 +103,37 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* A cache of the most recently used line displays. Drawing,
+   * moving the cursor and looking up positions keep asking for
+   * the same lines, and creating a display means laying out the
+   * whole paragraph. Displays that are only used for their size
+   * come from validating lines and are rarely needed again, so
+   * only the last one of those is kept.
+   */
+  GHashTable *line_displays;            /* GtkTextLine => GtkTextLineDisplay */
+  GQueue line_display_lru;
+  GtkTextLineDisplay *size_only_display;
+
+  /* Sizes of invalid lines that were measured on worker threads,
+   * see gtk_text_layout_measure_invalid_lines(). Wrapping a line
+   * takes its size from here.
+   */
+  GHashTable *line_sizes;               /* GtkTextLine => GtkTextLineSize */
+};
+
+typedef struct _GtkTextLineSize GtkTextLineSize;
+
+struct _GtkTextLineSize
+{
+  gint width;
+  gint height;
+  gint top_ink;
+  gint bottom_ink;
 };
 
+#define LINE_DISPLAY_CACHE_SIZE 128
+
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
                                                    GtkTextLine *line,
                                                    /* may be NULL */
@@ -127,6 +161,9 @@ static void gtk_text_layout_emit_changed           (GtkTextLayout     *layout,
 						    gint               new_height);
 
 static void gtk_text_layout_invalidate_all (GtkTextLayout *layout);
+static void gtk_text_layout_clear_line_display_cache (GtkTextLayout *layout);
+static gboolean gtk_text_layout_can_measure_in_parallel (GtkTextLayout *layout);
+static gint gtk_text_layout_measure_invalid_lines (GtkTextLayout *layout);
 
 static PangoAttribute *gtk_text_attr_appearance_new (const GtkTextAppearance *appearance);
 
@@ -194,12 +231,7 @@ gtk_text_layout_dispose (GObject *object)
   g_clear_object (&layout->ltr_context);
   g_clear_object (&layout->rtl_context);
 
-  if (layout->one_display_cache)
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  gtk_text_layout_clear_line_display_cache (layout);
 
   if (layout->preedit_attrs != NULL)
     {
@@ -218,6 +250,8 @@ gtk_text_layout_finalize (GObject *object)
   layout = GTK_TEXT_LAYOUT (object);
 
   g_free (layout->preedit_string);
+  g_hash_table_unref (GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->line_displays);
+  g_hash_table_unref (GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->line_sizes);
 
   G_OBJECT_CLASS (gtk_text_layout_parent_class)->finalize (object);
 }
@@ -274,10 +308,22 @@ gtk_text_layout_class_init (GtkTextLayoutClass *klass)
                   G_TYPE_INT);
 }
 
+static void
+line_size_free (gpointer data)
+{
+  g_slice_free (GtkTextLineSize, data);
+}
+
 static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+
   text_layout->cursor_visible = TRUE;
+
+  priv->line_displays = g_hash_table_new (NULL, NULL);
+  priv->line_sizes = g_hash_table_new_full (NULL, NULL, NULL, line_size_free);
+  g_queue_init (&priv->line_display_lru);
 }
 
 GtkTextLayout*
@@ -311,6 +357,7 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  gtk_text_layout_clear_line_display_cache (layout);
 
   if (layout->buffer)
     {
@@ -636,15 +683,21 @@ text_layout_changed (GtkTextLayout *layout,
                      gint           new_height,
                      gboolean       cursors_only)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *l, *next;
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
-  if (layout->one_display_cache)
+  for (l = priv->line_display_lru.head; l != NULL; l = next)
     {
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLineDisplay *display = l->data;
+      GtkTextLine *line = display->line;
       gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
 						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+      gint cache_height = display->height;
+
+      next = l->next;
 
       if (cache_y + cache_height > y && cache_y < y + old_height)
 	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
@@ -814,15 +867,84 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   gtk_text_layout_invalidate (layout, &start, &end);
 }
 
+static GtkTextLineDisplay *
+gtk_text_layout_lookup_line_display (GtkTextLayout *layout,
+                                     GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineDisplay *display;
+
+  display = g_hash_table_lookup (priv->line_displays, line);
+  if (display)
+    {
+      g_queue_unlink (&priv->line_display_lru, &display->cache_link);
+      g_queue_push_head_link (&priv->line_display_lru, &display->cache_link);
+    }
+
+  return display;
+}
+
+static void
+gtk_text_layout_remove_line_display (GtkTextLayout      *layout,
+                                     GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  g_hash_table_remove (priv->line_displays, display->line);
+  g_queue_unlink (&priv->line_display_lru, &display->cache_link);
+  if (priv->size_only_display == display)
+    priv->size_only_display = NULL;
+
+  display->cached = FALSE;
+  gtk_text_layout_free_line_display (layout, display);
+}
+
+static void
+gtk_text_layout_cache_line_display (GtkTextLayout      *layout,
+                                    GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (display->size_only && priv->size_only_display)
+    gtk_text_layout_remove_line_display (layout, priv->size_only_display);
+
+  while (priv->line_display_lru.length >= LINE_DISPLAY_CACHE_SIZE)
+    gtk_text_layout_remove_line_display (layout, priv->line_display_lru.tail->data);
+
+  display->cached = TRUE;
+  display->cache_link.data = display;
+  g_queue_push_head_link (&priv->line_display_lru, &display->cache_link);
+  g_hash_table_insert (priv->line_displays, display->line, display);
+
+  if (display->size_only)
+    priv->size_only_display = display;
+}
+
+static void
+gtk_text_layout_clear_line_display_cache (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->line_display_lru.head)
+    gtk_text_layout_remove_line_display (layout, priv->line_display_lru.head->data);
+
+  g_hash_table_remove_all (priv->line_sizes);
+}
+
 static void
 gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
-  if (layout->one_display_cache && line == layout->one_display_cache->line)
-    {
-      GtkTextLineDisplay *display = layout->one_display_cache;
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineDisplay *display;
 
+  if (!cursors_only)
+    g_hash_table_remove (priv->line_sizes, line);
+
+  display = g_hash_table_lookup (priv->line_displays, line);
+  if (display)
+    {
       if (cursors_only)
 	{
           if (display->cursors)
@@ -833,8 +955,7 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
 	}
       else
 	{
-	  layout->one_display_cache = NULL;
-	  gtk_text_layout_free_line_display (layout, display);
+	  gtk_text_layout_remove_line_display (layout, display);
 	}
     }
 }
@@ -866,16 +987,45 @@ gtk_text_layout_invalidate_cursor_line (GtkTextLayout *layout,
     }
 }
 
+/* The old cursor line may have been deleted already, but then its
+ * display and size have been removed from the caches, too.
+ */
+static void
+gtk_text_layout_invalidate_cursor_dependent (GtkTextLayout *layout,
+                                             GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (line == NULL ||
+      (!g_hash_table_contains (priv->line_displays, line) &&
+       !g_hash_table_contains (priv->line_sizes, line)))
+    return;
+
+  if (layout->preedit_len > 0 ||
+      line->dir_strong == PANGO_DIRECTION_NEUTRAL)
+    gtk_text_layout_invalidate_cache (layout, line, FALSE);
+}
+
 static void
 gtk_text_layout_update_cursor_line(GtkTextLayout *layout)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextIter iter;
+  GtkTextLine *line;
 
   gtk_text_buffer_get_iter_at_mark (layout->buffer, &iter,
                                     gtk_text_buffer_get_insert (layout->buffer));
 
-  priv->cursor_line = _gtk_text_iter_get_text_line (&iter);
+  line = _gtk_text_iter_get_text_line (&iter);
+  if (line == priv->cursor_line)
+    return;
+
+  /* The base direction of lines without strong characters and the
+   * preedit string depend on which line has the cursor.
+   */
+  gtk_text_layout_invalidate_cursor_dependent (layout, priv->cursor_line);
+  priv->cursor_line = line;
+  gtk_text_layout_invalidate_cursor_dependent (layout, priv->cursor_line);
 }
 
 static void
@@ -927,32 +1077,29 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
-   */
-  if (layout->one_display_cache)
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLine *line, *last_line;
+
+  if (gtk_text_iter_compare (start, end) > 0)
     {
-      GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+    }
 
-      gtk_text_layout_get_iter_at_line (layout, &line_start, line, 0);
+  /* Invalidate the cursors of the cached lines in the range
+   */
+  last_line = _gtk_text_iter_get_text_line (end);
+  line = _gtk_text_iter_get_text_line (start);
 
-      line_end = line_start;
-      if (!gtk_text_iter_ends_line (&line_end))
-	gtk_text_iter_forward_to_line_end (&line_end);
+  while (line != NULL && g_hash_table_size (priv->line_displays) > 0)
+    {
+      gtk_text_layout_invalidate_cache (layout, line, TRUE);
 
-      if (gtk_text_iter_compare (start, end) > 0)
-	{
-	  const GtkTextIter *tmp = start;
-	  start = end;
-	  end = tmp;
-	}
+      if (line == last_line)
+        break;
 
-      if (gtk_text_iter_compare (&line_start, end) <= 0 &&
-	  gtk_text_iter_compare (start, &line_end) <= 0)
-	{
-	  gtk_text_layout_invalidate_cache (layout, line, TRUE);
-	}
+      line = _gtk_text_line_next_excluding_last (line);
     }
 
   gtk_text_layout_invalidated (layout);
@@ -1148,11 +1295,26 @@ gtk_text_layout_validate (GtkTextLayout *layout,
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
 
-  while (max_pixels > 0 &&
-         _gtk_text_btree_validate (_gtk_text_buffer_get_btree (layout->buffer),
-                                   layout,  max_pixels,
-                                   &y, &old_height, &new_height))
+  while (max_pixels > 0)
     {
+      gint pixels = max_pixels;
+
+      /* Stop validating where the measured lines end, so the
+       * next lines are measured in parallel, too.
+       */
+      if (gtk_text_layout_can_measure_in_parallel (layout))
+        {
+          gint measured = gtk_text_layout_measure_invalid_lines (layout);
+
+          if (measured > 0)
+            pixels = MIN (pixels, measured);
+        }
+
+      if (!_gtk_text_btree_validate (_gtk_text_buffer_get_btree (layout->buffer),
+                                     layout, pixels,
+                                     &y, &old_height, &new_height))
+        break;
+
       max_pixels -= new_height;
 
       update_layout_size (layout);
@@ -1160,14 +1322,29 @@ gtk_text_layout_validate (GtkTextLayout *layout,
     }
 }
 
+static void
+get_line_display_size (GtkTextLineDisplay *display,
+                       GtkTextLineSize    *size)
+{
+  PangoRectangle ink_rect, logical_rect;
+
+  size->width = display->width;
+  size->height = display->height;
+  pango_layout_get_pixel_extents (display->layout, &ink_rect, &logical_rect);
+  size->top_ink = MAX (0, logical_rect.x - ink_rect.x);
+  size->bottom_ink = MAX (0, logical_rect.x + logical_rect.width - ink_rect.x - ink_rect.width);
+}
+
 static GtkTextLineData*
 gtk_text_layout_real_wrap (GtkTextLayout   *layout,
                            GtkTextLine     *line,
                            /* may be NULL */
                            GtkTextLineData *line_data)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
-  PangoRectangle ink_rect, logical_rect;
+  GtkTextLineSize *measured;
+  GtkTextLineSize size;
 
   g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), NULL);
   g_return_val_if_fail (line != NULL, NULL);
@@ -1178,14 +1355,24 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
       _gtk_text_line_add_data (line, line_data);
     }
 
-  display = gtk_text_layout_get_line_display (layout, line, TRUE);
-  line_data->width = display->width;
-  line_data->height = display->height;
+  measured = g_hash_table_lookup (priv->line_sizes, line);
+  if (measured)
+    {
+      size = *measured;
+      g_hash_table_remove (priv->line_sizes, line);
+    }
+  else
+    {
+      display = gtk_text_layout_get_line_display (layout, line, TRUE);
+      get_line_display_size (display, &size);
+      gtk_text_layout_free_line_display (layout, display);
+    }
+
+  line_data->width = size.width;
+  line_data->height = size.height;
+  line_data->top_ink = size.top_ink;
+  line_data->bottom_ink = size.bottom_ink;
   line_data->valid = TRUE;
-  pango_layout_get_pixel_extents (display->layout, &ink_rect, &logical_rect);
-  line_data->top_ink = MAX (0, logical_rect.x - ink_rect.x);
-  line_data->bottom_ink = MAX (0, logical_rect.x + logical_rect.width - ink_rect.x - ink_rect.width);
-  gtk_text_layout_free_line_display (layout, display);
 
   return line_data;
 }
@@ -1324,6 +1511,8 @@ totally_invisible_line (GtkTextLayout *layout,
 
 static void
 set_para_values (GtkTextLayout      *layout,
+                 PangoContext       *ltr_context,
+                 PangoContext       *rtl_context,
                  PangoDirection      base_dir,
                  GtkTextAttributes  *style,
                  GtkTextLineDisplay *display)
@@ -1355,9 +1544,9 @@ set_para_values (GtkTextLayout      *layout,
     }
   
   if (display->direction == GTK_TEXT_DIR_RTL)
-    display->layout = pango_layout_new (layout->rtl_context);
+    display->layout = pango_layout_new (rtl_context);
   else
-    display->layout = pango_layout_new (layout->ltr_context);
+    display->layout = pango_layout_new (ltr_context);
 
   switch (style->justification)
     {
@@ -2232,10 +2421,18 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
-GtkTextLineDisplay *
-gtk_text_layout_get_line_display (GtkTextLayout *layout,
-                                  GtkTextLine   *line,
-                                  gboolean       size_only)
+/* Creates the display of @line, with the text and attributes set on its
+ * PangoLayout, but doesn't lay it out yet. The layout is created in
+ * @ltr_context or @rtl_context. Returns %NULL if the whole line is
+ * invisible.
+ */
+static GtkTextLineDisplay *
+gtk_text_layout_create_line_display (GtkTextLayout *layout,
+                                     GtkTextLine   *line,
+                                     gboolean       size_only,
+                                     PangoContext  *ltr_context,
+                                     PangoContext  *rtl_context,
+                                     gboolean      *saw_widget)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
@@ -2243,41 +2440,24 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   GtkTextIter iter;
   GtkTextAttributes *style;
   gchar *text;
-  gint text_pixel_width;
   PangoAttrList *attrs;
   gint text_allocated, layout_byte_offset, buffer_byte_offset;
-  PangoRectangle extents;
   gboolean para_values_set = FALSE;
   GSList *cursor_byte_offsets = NULL;
   GSList *cursor_segs = NULL;
   GSList *tmp_list1, *tmp_list2;
-  gboolean saw_widget = FALSE;
   PangoDirection base_dir;
   GPtrArray *tags;
   gboolean initial_toggle_segments;
-  gint h_margin;
-  gint h_padding;
-  
-  g_return_val_if_fail (line != NULL, NULL);
 
-  if (layout->one_display_cache)
-    {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
-	{
-	  if (!size_only)
-            update_text_display_cursors (layout, line, layout->one_display_cache);
-	  return layout->one_display_cache;
-	}
-      else
-        {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
-        }
-    }
+  *saw_widget = FALSE;
 
-  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
+  /* Special-case optimization for completely
+   * invisible lines; makes it faster to deal
+   * with sequences of invisible lines.
+   */
+  if (totally_invisible_line (layout, line, &iter))
+    return NULL;
 
   display = g_slice_new0 (GtkTextLineDisplay);
 
@@ -2285,20 +2465,6 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   display->line = line;
   display->insert_index = -1;
 
-  /* Special-case optimization for completely
-   * invisible lines; makes it faster to deal
-   * with sequences of invisible lines.
-   */
-  if (totally_invisible_line (layout, line, &iter))
-    {
-      if (display->direction == GTK_TEXT_DIR_RTL)
-	display->layout = pango_layout_new (layout->rtl_context);
-      else
-	display->layout = pango_layout_new (layout->ltr_context);
-      
-      return display;
-    }
-
   /* Find the bidi base direction */
   base_dir = line->dir_propagated_forward;
   if (base_dir == PANGO_DIRECTION_NEUTRAL)
@@ -2341,7 +2507,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
            */
           if (!para_values_set)
             {
-              set_para_values (layout, base_dir, style, display);
+              set_para_values (layout, ltr_context, rtl_context, base_dir, style, display);
               para_values_set = TRUE;
             }
 
@@ -2425,7 +2591,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
                 }
               else if (seg->type == &gtk_text_child_type)
                 {
-                  saw_widget = TRUE;
+                  *saw_widget = TRUE;
                   
                   add_generic_attrs (layout, &style->appearance,
                                      seg->byte_count,
@@ -2517,7 +2683,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   if (!para_values_set)
     {
       style = get_style (layout, tags);
-      set_para_values (layout, base_dir, style, display);
+      set_para_values (layout, ltr_context, rtl_context, base_dir, style, display);
       release_style (layout, style);
     }
   
@@ -2562,13 +2728,35 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   g_slist_free (cursor_byte_offsets);
   g_slist_free (cursor_segs);
 
+  /* Free this if we aren't in a loop */
+  if (layout->wrap_loop_count == 0)
+    invalidate_cached_style (layout);
+
+  g_free (text);
+  pango_attr_list_unref (attrs);
+  if (tags != NULL)
+    g_ptr_array_free (tags, TRUE);
+
+  return display;
+}
+
+/* Lays out the PangoLayout of @display and sets its size. This is
+ * where most of the time for creating a display goes, and it doesn't
+ * touch the buffer or the layout, so it can be done on another thread.
+ */
+static void
+measure_line_display (GtkTextLineDisplay *display,
+                      gint                h_padding)
+{
+  PangoRectangle extents;
+  gint text_pixel_width;
+  gint h_margin;
+
   pango_layout_get_extents (display->layout, NULL, &extents);
 
   text_pixel_width = PIXEL_BOUND (extents.width);
-  display->width = text_pixel_width + display->left_margin + display->right_margin;
 
   h_margin = display->left_margin + display->right_margin;
-  h_padding = layout->left_padding + layout->right_padding;
 
   display->width = text_pixel_width + h_margin + h_padding;
   display->height += PANGO_PIXELS (extents.height);
@@ -2592,17 +2780,51 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
 	  break;
 	}
     }
-  
-  /* Free this if we aren't in a loop */
-  if (layout->wrap_loop_count == 0)
-    invalidate_cached_style (layout);
+}
 
-  g_free (text);
-  pango_attr_list_unref (attrs);
-  if (tags != NULL)
-    g_ptr_array_free (tags, TRUE);
+GtkTextLineDisplay *
+gtk_text_layout_get_line_display (GtkTextLayout *layout,
+                                  GtkTextLine   *line,
+                                  gboolean       size_only)
+{
+  GtkTextLineDisplay *display;
+  gboolean saw_widget;
+
+  g_return_val_if_fail (line != NULL, NULL);
+
+  display = gtk_text_layout_lookup_line_display (layout, line);
+  if (display)
+    {
+      if (size_only || !display->size_only)
+	{
+	  if (!size_only)
+            update_text_display_cursors (layout, line, display);
+	  return display;
+	}
+      else
+        gtk_text_layout_remove_line_display (layout, display);
+    }
 
-  layout->one_display_cache = display;
+  DV (g_print ("creating line display (%s)\n", G_STRLOC));
+
+  display = gtk_text_layout_create_line_display (layout, line, size_only,
+                                                 layout->ltr_context,
+                                                 layout->rtl_context,
+                                                 &saw_widget);
+  if (display == NULL)
+    {
+      display = g_slice_new0 (GtkTextLineDisplay);
+      display->size_only = size_only;
+      display->line = line;
+      display->insert_index = -1;
+      display->layout = pango_layout_new (layout->ltr_context);
+
+      return display;
+    }
+
+  measure_line_display (display, layout->left_padding + layout->right_padding);
+
+  gtk_text_layout_cache_line_display (layout, display);
 
   if (saw_widget)
     allocate_child_widgets (layout, display);
@@ -2610,11 +2832,195 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   return display;
 }
 
+/* MEASURING LINES IN PARALLEL
+ *
+ * Validating a large buffer spends most of its time laying out lines
+ * with Pango. So the lines that are going to be validated next are
+ * measured ahead on worker threads: their displays are created on the
+ * main thread, which needs the buffer, and laid out on the workers.
+ * Wrapping the lines then takes the sizes from priv->line_sizes, so the
+ * btree and the ::changed signal are updated on the main thread as
+ * before. Invalidating a line drops its size.
+ *
+ * Layouts from the same PangoContext can't be laid out on different
+ * threads at the same time, so every chunk of lines gets a copy of the
+ * contexts. The line with the cursor and lines with child widgets are
+ * left to the main thread.
+ *
+ * Only the fontconfig font maps can be used from several threads, so
+ * with other font maps all lines are measured on the main thread.
+ */
+
+#define MEASURE_CHUNK_LINES 16
+#define MEASURE_MAX_CHUNKS 16
+
+typedef struct _GtkTextMeasureJob GtkTextMeasureJob;
+
+struct _GtkTextMeasureJob
+{
+  GtkTextLineDisplay *displays[MEASURE_MAX_CHUNKS * MEASURE_CHUNK_LINES];
+  GtkTextLineSize sizes[MEASURE_MAX_CHUNKS * MEASURE_CHUNK_LINES];
+  PangoContext *contexts[MEASURE_MAX_CHUNKS][2];
+  guint n_displays;
+  gint h_padding;
+};
+
+static PangoContext *
+copy_pango_context (PangoContext *context)
+{
+  PangoContext *copy;
+
+  copy = pango_font_map_create_context (pango_context_get_font_map (context));
+  pango_context_set_font_description (copy, pango_context_get_font_description (context));
+  pango_context_set_language (copy, pango_context_get_language (context));
+  pango_context_set_base_dir (copy, pango_context_get_base_dir (context));
+  pango_context_set_base_gravity (copy, pango_context_get_base_gravity (context));
+  pango_context_set_gravity_hint (copy, pango_context_get_gravity_hint (context));
+  pango_context_set_matrix (copy, pango_context_get_matrix (context));
+  pango_cairo_context_set_font_options (copy, pango_cairo_context_get_font_options (context));
+  pango_cairo_context_set_resolution (copy, pango_cairo_context_get_resolution (context));
+
+  return copy;
+}
+
+/* Runs on worker threads */
+static void
+measure_line_chunks (guint    start,
+                     guint    end,
+                     gpointer data)
+{
+  GtkTextMeasureJob *job = data;
+  guint i;
+
+  for (i = start * MEASURE_CHUNK_LINES;
+       i < MIN (end * MEASURE_CHUNK_LINES, job->n_displays);
+       i++)
+    {
+      measure_line_display (job->displays[i], job->h_padding);
+      get_line_display_size (job->displays[i], &job->sizes[i]);
+    }
+}
+
+static gboolean
+gtk_text_layout_can_measure_in_parallel (GtkTextLayout *layout)
+{
+#if defined (GDK_WINDOWING_X11) || defined (GDK_WINDOWING_WAYLAND)
+  if (gtk_parallel_get_n_threads () <= 1 || layout->ltr_context == NULL)
+    return FALSE;
+
+  return PANGO_IS_FC_FONT_MAP (pango_context_get_font_map (layout->ltr_context));
+#else
+  return FALSE;
+#endif
+}
+
+/* Measures the invalid lines that _gtk_text_btree_validate() is going
+ * to wrap next. Returns the height of the lines at the start of the
+ * invalid region that have a size now.
+ */
+static gint
+gtk_text_layout_measure_invalid_lines (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLine *first_line, *line;
+  GtkTextMeasureJob *job;
+  GtkTextLineSize *size;
+  guint i, n_chunks, n_lines;
+  gint height;
+
+  first_line = _gtk_text_btree_get_first_invalid_line (_gtk_text_buffer_get_btree (layout->buffer),
+                                                       layout);
+  if (first_line == NULL)
+    return 0;
+
+  job = g_slice_new0 (GtkTextMeasureJob);
+  job->h_padding = layout->left_padding + layout->right_padding;
+  n_chunks = 0;
+
+  gtk_text_layout_wrap_loop_start (layout);
+
+  for (line = first_line, n_lines = 0;
+       line != NULL && n_lines < G_N_ELEMENTS (job->displays) * 2;
+       line = _gtk_text_line_next_excluding_last (line), n_lines++)
+    {
+      GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
+      GtkTextLineDisplay *display;
+      gboolean saw_widget;
+
+      if (line_data && line_data->valid)
+        break;
+
+      if (line == priv->cursor_line ||
+          g_hash_table_contains (priv->line_sizes, line))
+        continue;
+
+      if (job->n_displays == n_chunks * MEASURE_CHUNK_LINES)
+        {
+          if (n_chunks == MEASURE_MAX_CHUNKS)
+            break;
+
+          job->contexts[n_chunks][0] = copy_pango_context (layout->ltr_context);
+          job->contexts[n_chunks][1] = copy_pango_context (layout->rtl_context);
+          n_chunks++;
+        }
+
+      display = gtk_text_layout_create_line_display (layout, line, TRUE,
+                                                     job->contexts[n_chunks - 1][0],
+                                                     job->contexts[n_chunks - 1][1],
+                                                     &saw_widget);
+      if (display == NULL)
+        {
+          /* Completely invisible lines have no size */
+          g_hash_table_insert (priv->line_sizes, line, g_slice_new0 (GtkTextLineSize));
+        }
+      else if (saw_widget)
+        {
+          gtk_text_layout_free_line_display (layout, display);
+        }
+      else
+        {
+          job->displays[job->n_displays++] = display;
+        }
+    }
+
+  gtk_text_layout_wrap_loop_end (layout);
+
+  gtk_parallel_for (n_chunks, 1, measure_line_chunks, job);
+
+  for (i = 0; i < job->n_displays; i++)
+    {
+      g_hash_table_insert (priv->line_sizes,
+                           job->displays[i]->line,
+                           g_slice_dup (GtkTextLineSize, &job->sizes[i]));
+      gtk_text_layout_free_line_display (layout, job->displays[i]);
+    }
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      g_object_unref (job->contexts[i][0]);
+      g_object_unref (job->contexts[i][1]);
+    }
+
+  g_slice_free (GtkTextMeasureJob, job);
+
+  height = 0;
+  for (line = first_line; line != NULL; line = _gtk_text_line_next_excluding_last (line))
+    {
+      size = g_hash_table_lookup (priv->line_sizes, line);
+      if (size == NULL)
+        break;
+
+      height += size->height;
+    }
+
+  return height;
+}
+
 void
 gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                    GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
+  if (!display->cached)
     {
       if (display->layout)
         g_object_unref (display->layout);
@@ -2625,10 +3031,35 @@ gtk_text_layout_free_line_display (GtkTextLayout      *layout,
       if (display->pg_bg_rgba)
         gdk_rgba_free (display->pg_bg_rgba);
 
+      if (display->node)
+        gsk_render_node_unref (display->node);
+
       g_slice_free (GtkTextLineDisplay, display);
     }
 }
 
+/* Drops the render nodes of all cached line displays, for when the
+ * colors that the lines are drawn with change.
+ */
+void
+gtk_text_layout_invalidate_line_nodes (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv;
+  GList *l;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  for (l = priv->line_display_lru.head; l != NULL; l = l->next)
+    {
+      GtkTextLineDisplay *display = l->data;
+
+      g_clear_pointer (&display->node, gsk_render_node_unref);
+      display->node_valid = FALSE;
+    }
+}
+
 /* Functions to convert iter <=> index for the line of a GtkTextLineDisplay
  * taking into account the preedit string and invisible text if necessary.
  */
@@ -148,11 +148,6 @@ struct _GtkTextLayout
    * over long runs with the same style. */
   GtkTextAttributes *one_style_cache;
 
-  /* A cache of one line display. Getting the same line
-   * many times in a row is the most common case.
-   */
-  GtkTextLineDisplay *one_display_cache;
-
   /* Whether we are allowed to wrap right now */
   gint wrap_loop_count;
   
@@ -255,8 +250,20 @@ struct _GtkTextLineDisplay
   guint has_block_cursor : 1;
   guint cursor_at_line_end : 1;
   guint size_only : 1;
+  guint cached : 1;             /* owned by the line display cache */
 
   GdkRGBA *pg_bg_rgba;
+
+  GList cache_link;             /* in the line display cache, most recently used first */
+
+  /* The render node of a cached display and the selection it was
+   * drawn with, see gtk_text_layout_snapshot()
+   */
+  GskRenderNode *node;          /* in the coordinates of the line, may be NULL */
+  gint node_selection_start;
+  gint node_selection_end;
+  guint node_valid : 1;
+  guint node_named : 1;
 };
 
 #ifdef GTK_COMPILATION
@@ -337,6 +344,8 @@ GtkTextLineDisplay* gtk_text_layout_get_line_display  (GtkTextLayout      *layou
 GDK_AVAILABLE_IN_ALL
 void                gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                                        GtkTextLineDisplay *display);
+GDK_AVAILABLE_IN_ALL
+void                gtk_text_layout_invalidate_line_nodes (GtkTextLayout  *layout);
 
 GDK_AVAILABLE_IN_ALL
 void gtk_text_layout_get_line_at_y     (GtkTextLayout     *layout,
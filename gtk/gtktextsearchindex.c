@@ -0,0 +1,325 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtktextsearchindexprivate.h"
+
+#include <string.h>
+
+/* Every line gets a bloom filter of the trigrams in its text. Filters
+ * are built when a line is first searched and dropped when its text
+ * changes, so editing a buffer only costs the lines that were edited.
+ *
+ * Case sensitive searches look for the trigrams of the text as it is,
+ * and case insensitive ones for the trigrams of the case folded and
+ * normalized text, like gtk_text_iter_forward_search() compares them.
+ * Both kinds go into the same filter, with a different salt.
+ *
+ * Pixbufs and child anchors are left out of the trigrams, so both the
+ * text with and without the U+FFFC they stand for is covered. Search
+ * strings don't use trigrams that contain U+FFFC.
+ */
+
+#define MIN_FILTER_BITS 64
+#define MAX_FILTER_BITS 16384
+#define BITS_PER_TRIGRAM 4
+
+#define OBJECT_CHAR 0xFFFC
+
+enum {
+  SALT_RAW = 0x9e3779b9,
+  SALT_FOLDED = 0x85ebca6b
+};
+
+typedef struct _GtkTextLineFilter GtkTextLineFilter;
+
+struct _GtkTextLineFilter {
+  guint n_bits;                 /* a power of two */
+  guint32 bits[1];
+};
+
+struct _GtkTextSearchIndex {
+  GHashTable *filters;          /* GtkTextLine => GtkTextLineFilter */
+};
+
+struct _GtkTextSearchKey {
+  guint n_hashes;
+  guint hashes[1];
+};
+
+static inline guint
+trigram_hash (gunichar a,
+              gunichar b,
+              gunichar c,
+              guint    salt)
+{
+  guint hash = (a * 0x1b873593u) ^ (b * 0xcc9e2d51u) ^ (c * 0xe6546b64u) ^ salt;
+
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3b;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+/* Every hash sets two bits, taken from different parts of the hash */
+static inline void
+filter_add_hash (GtkTextLineFilter *filter,
+                 guint              hash)
+{
+  guint a = hash & (filter->n_bits - 1);
+  guint b = (hash >> 16) & (filter->n_bits - 1);
+
+  filter->bits[a / 32] |= 1u << (a % 32);
+  filter->bits[b / 32] |= 1u << (b % 32);
+}
+
+static inline gboolean
+filter_may_contain_hash (const GtkTextLineFilter *filter,
+                         guint                    hash)
+{
+  guint a = hash & (filter->n_bits - 1);
+  guint b = (hash >> 16) & (filter->n_bits - 1);
+
+  return (filter->bits[a / 32] & (1u << (a % 32))) &&
+         (filter->bits[b / 32] & (1u << (b % 32)));
+}
+
+typedef void (* TrigramFunc) (guint    hash,
+                              gpointer data);
+
+/* Calls @func for the trigrams of @text that don't contain U+FFFC */
+static void
+foreach_trigram (const gchar *text,
+                 gsize        len,
+                 guint        salt,
+                 TrigramFunc  func,
+                 gpointer     data)
+{
+  const gchar *p, *end;
+  gunichar a, b, c;
+  guint n;
+
+  end = text + len;
+  a = b = 0;
+  n = 0;
+
+  for (p = text; p < end; p = g_utf8_next_char (p))
+    {
+      c = g_utf8_get_char (p);
+
+      if (c == OBJECT_CHAR)
+        {
+          n = 0;
+          continue;
+        }
+
+      if (++n >= 3)
+        func (trigram_hash (a, b, c, salt), data);
+
+      a = b;
+      b = c;
+    }
+}
+
+static gchar *
+fold_text (const gchar *text,
+           gssize       len)
+{
+  gchar *casefold, *normal;
+
+  casefold = g_utf8_casefold (text, len);
+  normal = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
+  g_free (casefold);
+
+  return normal;
+}
+
+static void
+add_to_filter (guint    hash,
+               gpointer data)
+{
+  filter_add_hash (data, hash);
+}
+
+static GtkTextLineFilter *
+line_filter_new (GtkTextLine *line)
+{
+  GtkTextLineSegment *seg;
+  GtkTextLineFilter *filter;
+  GString *text, *slice;
+  gchar *folded, *folded_slice;
+  gboolean has_objects;
+  guint n_bits;
+  gsize n_chars;
+
+  text = g_string_new (NULL);
+  slice = g_string_new (NULL);
+  has_objects = FALSE;
+  n_chars = 0;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_char_type)
+        {
+          g_string_append_len (text, seg->body.chars, seg->byte_count);
+          g_string_append_len (slice, seg->body.chars, seg->byte_count);
+          n_chars += seg->char_count;
+        }
+      else if (seg->type == &gtk_text_pixbuf_type ||
+               seg->type == &gtk_text_child_type)
+        {
+          g_string_append_unichar (slice, OBJECT_CHAR);
+          has_objects = TRUE;
+        }
+    }
+
+  /* Folding rarely changes the number of characters by much */
+  n_bits = MIN_FILTER_BITS;
+  while (n_bits < 2 * n_chars * BITS_PER_TRIGRAM && n_bits < MAX_FILTER_BITS)
+    n_bits *= 2;
+
+  filter = g_malloc0 (sizeof (GtkTextLineFilter) + (n_bits / 32 - 1) * sizeof (guint32));
+  filter->n_bits = n_bits;
+
+  foreach_trigram (text->str, text->len, SALT_RAW, add_to_filter, filter);
+
+  folded = fold_text (text->str, text->len);
+  foreach_trigram (folded, strlen (folded), SALT_FOLDED, add_to_filter, filter);
+  g_free (folded);
+
+  /* Normalizing the text around a U+FFFC differs from normalizing it
+   * with the U+FFFC left out, so index both.
+   */
+  if (has_objects)
+    {
+      folded_slice = fold_text (slice->str, slice->len);
+      foreach_trigram (folded_slice, strlen (folded_slice), SALT_FOLDED, add_to_filter, filter);
+      g_free (folded_slice);
+    }
+
+  g_string_free (text, TRUE);
+  g_string_free (slice, TRUE);
+
+  return filter;
+}
+
+GtkTextSearchIndex *
+_gtk_text_search_index_new (void)
+{
+  GtkTextSearchIndex *index;
+
+  index = g_slice_new (GtkTextSearchIndex);
+  index->filters = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  return index;
+}
+
+void
+_gtk_text_search_index_free (GtkTextSearchIndex *index)
+{
+  g_hash_table_unref (index->filters);
+  g_slice_free (GtkTextSearchIndex, index);
+}
+
+void
+_gtk_text_search_index_invalidate_line (GtkTextSearchIndex *index,
+                                        GtkTextLine        *line)
+{
+  g_hash_table_remove (index->filters, line);
+}
+
+static void
+add_to_key (guint    hash,
+            gpointer data)
+{
+  GArray *hashes = data;
+
+  g_array_append_val (hashes, hash);
+}
+
+GtkTextSearchKey *
+_gtk_text_search_key_new (const gchar *str,
+                          gboolean     case_insensitive)
+{
+  GtkTextSearchKey *key;
+  const gchar *newline;
+  GArray *hashes;
+  gsize len;
+
+  /* Lines are matched one at a time, and the first line of the
+   * search string has to be in a single line of the buffer.
+   */
+  newline = strchr (str, '\n');
+  len = newline ? newline - str + 1 : strlen (str);
+
+  hashes = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  if (case_insensitive)
+    {
+      gchar *folded = fold_text (str, len);
+      foreach_trigram (folded, strlen (folded), SALT_FOLDED, add_to_key, hashes);
+      g_free (folded);
+    }
+  else
+    foreach_trigram (str, len, SALT_RAW, add_to_key, hashes);
+
+  if (hashes->len == 0)
+    {
+      g_array_free (hashes, TRUE);
+      return NULL;
+    }
+
+  key = g_malloc (sizeof (GtkTextSearchKey) + (hashes->len - 1) * sizeof (guint));
+  key->n_hashes = hashes->len;
+  memcpy (key->hashes, hashes->data, hashes->len * sizeof (guint));
+
+  g_array_free (hashes, TRUE);
+
+  return key;
+}
+
+void
+_gtk_text_search_key_free (GtkTextSearchKey *key)
+{
+  g_free (key);
+}
+
+gboolean
+_gtk_text_search_index_line_may_match (GtkTextSearchIndex     *index,
+                                       GtkTextLine            *line,
+                                       const GtkTextSearchKey *key)
+{
+  GtkTextLineFilter *filter;
+  guint i;
+
+  filter = g_hash_table_lookup (index->filters, line);
+  if (filter == NULL)
+    {
+      filter = line_filter_new (line);
+      g_hash_table_insert (index->filters, line, filter);
+    }
+
+  for (i = 0; i < key->n_hashes; i++)
+    {
+      if (!filter_may_contain_hash (filter, key->hashes[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
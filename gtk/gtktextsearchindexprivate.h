@@ -0,0 +1,55 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_TEXT_SEARCH_INDEX_PRIVATE_H__
+#define __GTK_TEXT_SEARCH_INDEX_PRIVATE_H__
+
+#include "gtktextbtree.h"
+
+G_BEGIN_DECLS
+
+/* An index of the trigrams in the lines of a GtkTextBTree, to skip
+ * lines that can't contain a search string without looking at their
+ * text. It may claim that a line contains trigrams it doesn't have,
+ * but never misses one that it does have.
+ */
+
+typedef struct _GtkTextSearchKey GtkTextSearchKey;
+
+GtkTextSearchIndex *    _gtk_text_search_index_new              (void);
+void                    _gtk_text_search_index_free             (GtkTextSearchIndex *index);
+
+/* Must be called whenever the text of @line changes, and before
+ * @line is destroyed
+ */
+void                    _gtk_text_search_index_invalidate_line  (GtkTextSearchIndex *index,
+                                                                 GtkTextLine        *line);
+
+/* The trigrams of the first line of a search string. Returns %NULL
+ * if @str is too short to be looked up in the index.
+ */
+GtkTextSearchKey *      _gtk_text_search_key_new                (const gchar        *str,
+                                                                 gboolean            case_insensitive);
+void                    _gtk_text_search_key_free               (GtkTextSearchKey   *key);
+
+gboolean                _gtk_text_search_index_line_may_match   (GtkTextSearchIndex *index,
+                                                                 GtkTextLine        *line,
+                                                                 const GtkTextSearchKey *key);
+
+G_END_DECLS
+
+#endif /* __GTK_TEXT_SEARCH_INDEX_PRIVATE_H__ */
@@ -123,6 +123,7 @@ gtk_text_line_segment_split (const GtkTextIter *iter)
               g_assert (seg->byte_count > 0);
 
               _gtk_text_btree_segments_changed (tree);
+              _gtk_text_line_segments_changed (line);
 
               seg = (*seg->type->splitFunc)(seg, count);
 
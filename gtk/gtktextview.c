@@ -1653,6 +1653,20 @@ gtk_text_view_class_init (GtkTextViewClass *klass)
   quark_text_view_child = g_quark_from_static_string ("gtk-text-view-child");
 }
 
+static void
+selection_node_style_changed_cb (GtkCssNode        *node,
+                                 GtkCssStyleChange *change,
+                                 GtkTextView       *text_view)
+{
+  GtkTextViewPrivate *priv = text_view->priv;
+
+  /* Selected text is kept in the render nodes of the lines */
+  if (priv->layout)
+    gtk_text_layout_invalidate_line_nodes (priv->layout);
+
+  gtk_widget_queue_draw (GTK_WIDGET (text_view));
+}
+
 static void
 gtk_text_view_init (GtkTextView *text_view)
 {
@@ -1733,6 +1747,8 @@ gtk_text_view_init (GtkTextView *text_view)
   gtk_css_node_set_state (priv->selection_node,
                           gtk_css_node_get_state (priv->text_window->css_node) & ~GTK_STATE_FLAG_DROP_ACTIVE);
   gtk_css_node_set_visible (priv->selection_node, FALSE);
+  g_signal_connect_object (priv->selection_node, "style-changed",
+                           G_CALLBACK (selection_node_style_changed_cb), text_view, 0);
   g_object_unref (priv->selection_node);
 }
 
@@ -5767,11 +5783,12 @@ gtk_text_view_motion_event (GtkWidget *widget, GdkEventMotion *event)
 }
 
 static void
-gtk_text_view_paint (GtkWidget      *widget,
-                     cairo_t        *cr)
+gtk_text_view_paint (GtkWidget   *widget,
+                     GtkSnapshot *snapshot)
 {
   GtkTextView *text_view;
   GtkTextViewPrivate *priv;
+  GdkRectangle clip;
   
   text_view = GTK_TEXT_VIEW (widget);
   priv = text_view->priv;
@@ -5793,26 +5810,53 @@ gtk_text_view_paint (GtkWidget      *widget,
       g_assert_not_reached ();
     }
   
+  clip.x = priv->xoffset;
+  clip.y = priv->yoffset;
+  gtk_widget_get_content_size (widget, &clip.width, &clip.height);
+
 #if 0
   printf ("painting %d,%d  %d x %d\n",
-          area->x, area->y,
-          area->width, area->height);
+          clip.x, clip.y,
+          clip.width, clip.height);
 #endif
 
-  cairo_save (cr);
-  cairo_translate (cr, -priv->xoffset, -priv->yoffset);
+  gtk_snapshot_offset (snapshot, -priv->xoffset, -priv->yoffset);
+
+  gtk_text_layout_snapshot (priv->layout,
+                            widget,
+                            snapshot,
+                            &clip);
+
+  gtk_snapshot_offset (snapshot, priv->xoffset, priv->yoffset);
+}
+
+/* The draw_layer vfunc draws with cairo, so every layer of a
+ * subclass gets a cairo node covering the widget.
+ */
+static void
+draw_layer (GtkTextView          *text_view,
+            GtkSnapshot          *snapshot,
+            GtkTextViewLayer      layer,
+            const graphene_rect_t *bounds)
+{
+  GtkTextViewPrivate *priv = text_view->priv;
+  cairo_t *cr;
+
+  cr = gtk_snapshot_append_cairo (snapshot, bounds, "TextViewLayer");
 
-  gtk_text_layout_draw (priv->layout,
-                        widget,
-                        cr,
-                        NULL);
+  if (layer == GTK_TEXT_VIEW_LAYER_BELOW_TEXT ||
+      layer == GTK_TEXT_VIEW_LAYER_ABOVE_TEXT)
+    cairo_translate (cr, -priv->xoffset, -priv->yoffset);
 
-  cairo_restore (cr);
+  GTK_TEXT_VIEW_GET_CLASS (text_view)->draw_layer (text_view, layer, cr);
+
+  cairo_destroy (cr);
 }
 
 static void
-draw_text (GtkWidget *widget,
-           cairo_t   *cr)
+draw_text (GtkWidget             *widget,
+           GtkSnapshot           *snapshot,
+           const graphene_rect_t *bounds)
 {
   GtkTextView *text_view = GTK_TEXT_VIEW (widget);
   GtkTextViewPrivate *priv = text_view->priv;
@@ -5820,46 +5864,34 @@ draw_text (GtkWidget *widget,
 
   context = gtk_widget_get_style_context (widget);
   gtk_style_context_save_to_node (context, text_view->priv->text_window->css_node);
-  gtk_render_background (context, cr,
-                         -priv->xoffset, -priv->yoffset - priv->top_border,
-                         MAX (SCREEN_WIDTH (text_view), priv->width),
-                         MAX (SCREEN_HEIGHT (text_view), priv->height));
-  gtk_render_frame (context, cr,
-                    -priv->xoffset, -priv->yoffset - priv->top_border,
-                    MAX (SCREEN_WIDTH (text_view), priv->width),
-                    MAX (SCREEN_HEIGHT (text_view), priv->height));
+  gtk_snapshot_render_background (snapshot, context,
+                                  -priv->xoffset, -priv->yoffset - priv->top_border,
+                                  MAX (SCREEN_WIDTH (text_view), priv->width),
+                                  MAX (SCREEN_HEIGHT (text_view), priv->height));
+  gtk_snapshot_render_frame (snapshot, context,
+                             -priv->xoffset, -priv->yoffset - priv->top_border,
+                             MAX (SCREEN_WIDTH (text_view), priv->width),
+                             MAX (SCREEN_HEIGHT (text_view), priv->height));
   gtk_style_context_restore (context);
 
   if (GTK_TEXT_VIEW_GET_CLASS (text_view)->draw_layer != NULL)
     {
-      cairo_save (cr);
-      GTK_TEXT_VIEW_GET_CLASS (text_view)->draw_layer (text_view, GTK_TEXT_VIEW_LAYER_BELOW, cr);
-      cairo_restore (cr);
-
-      cairo_save (cr);
-      cairo_translate (cr, -priv->xoffset, -priv->yoffset);
-      GTK_TEXT_VIEW_GET_CLASS (text_view)->draw_layer (text_view, GTK_TEXT_VIEW_LAYER_BELOW_TEXT, cr);
-      cairo_restore (cr);
+      draw_layer (text_view, snapshot, GTK_TEXT_VIEW_LAYER_BELOW, bounds);
+      draw_layer (text_view, snapshot, GTK_TEXT_VIEW_LAYER_BELOW_TEXT, bounds);
     }
 
-  gtk_text_view_paint (widget, cr);
+  gtk_text_view_paint (widget, snapshot);
 
   if (GTK_TEXT_VIEW_GET_CLASS (text_view)->draw_layer != NULL)
     {
-      cairo_save (cr);
-      GTK_TEXT_VIEW_GET_CLASS (text_view)->draw_layer (text_view, GTK_TEXT_VIEW_LAYER_ABOVE, cr);
-      cairo_restore (cr);
-
-      cairo_save (cr);
-      cairo_translate (cr, -priv->xoffset, -priv->yoffset);
-      GTK_TEXT_VIEW_GET_CLASS (text_view)->draw_layer (text_view, GTK_TEXT_VIEW_LAYER_ABOVE_TEXT, cr);
-      cairo_restore (cr);
+      draw_layer (text_view, snapshot, GTK_TEXT_VIEW_LAYER_ABOVE, bounds);
+      draw_layer (text_view, snapshot, GTK_TEXT_VIEW_LAYER_ABOVE_TEXT, bounds);
     }
 }
 
 static void
 paint_border_window (GtkTextView     *text_view,
-                     cairo_t         *cr,
+                     GtkSnapshot     *snapshot,
                      GtkTextWindow   *text_window,
                      GtkStyleContext *context)
 {
@@ -5876,9 +5908,7 @@ paint_border_window (GtkTextView     *text_view,
 
   gtk_style_context_save_to_node (context, text_window->css_node);
 
-  cairo_save (cr);
-  gtk_render_background (context, cr, 0, 0, w, h);
-  cairo_restore (cr);
+  gtk_snapshot_render_background (snapshot, context, 0, 0, w, h);
 
   gtk_style_context_restore (context);
 }
@@ -5891,7 +5921,6 @@ gtk_text_view_snapshot (GtkWidget   *widget,
   GSList *tmp_list;
   GtkStyleContext *context;
   graphene_rect_t bounds;
-  cairo_t *cr;
   int width, height;
 
   gtk_widget_get_content_size (widget, &width, &height);
@@ -5902,24 +5931,18 @@ gtk_text_view_snapshot (GtkWidget   *widget,
 
   gtk_snapshot_push_clip (snapshot, &bounds, "Textview Clip");
 
-  cr = gtk_snapshot_append_cairo (snapshot, &bounds, "GtkTextView");
-
   context = gtk_widget_get_style_context (widget);
 
   text_window_set_padding (GTK_TEXT_VIEW (widget), context);
 
   DV(g_print (">Exposed ("G_STRLOC")\n"));
 
-  cairo_save (cr);
-  draw_text (widget, cr); 
-  cairo_restore (cr);
+  draw_text (widget, snapshot, &bounds);
 
-  paint_border_window (GTK_TEXT_VIEW (widget), cr, priv->left_window, context);
-  paint_border_window (GTK_TEXT_VIEW (widget), cr, priv->right_window, context);
-  paint_border_window (GTK_TEXT_VIEW (widget), cr, priv->top_window, context);
-  paint_border_window (GTK_TEXT_VIEW (widget), cr, priv->bottom_window, context);
-
-  cairo_destroy (cr);
+  paint_border_window (GTK_TEXT_VIEW (widget), snapshot, priv->left_window, context);
+  paint_border_window (GTK_TEXT_VIEW (widget), snapshot, priv->right_window, context);
+  paint_border_window (GTK_TEXT_VIEW (widget), snapshot, priv->top_window, context);
+  paint_border_window (GTK_TEXT_VIEW (widget), snapshot, priv->bottom_window, context);
 
   /* Propagate exposes to all unanchored children. 
    * Anchored children are handled in gtk_text_view_paint(). 
@@ -9612,6 +9635,12 @@ node_style_changed_cb (GtkCssNode        *node,
                        GtkCssStyleChange *change,
                        GtkWidget         *widget)
 {
+  GtkTextViewPrivate *priv = GTK_TEXT_VIEW (widget)->priv;
+
+  /* The text is drawn in the colors of the text window */
+  if (priv->layout)
+    gtk_text_layout_invalidate_line_nodes (priv->layout);
+
   if (gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_SIZE | GTK_CSS_AFFECTS_CLIP))
     gtk_widget_queue_resize (widget);
   else
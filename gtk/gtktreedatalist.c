@@ -20,6 +20,7 @@
 
 #include "config.h"
 #include "gtktreedatalist.h"
+#include "gtkparallelprivate.h"
 #include <string.h>
 
 /* node allocation
@@ -570,3 +571,382 @@ _gtk_tree_data_list_set_header (GList                  *header_list,
 
   return header_list;
 }
+
+/* Sort keys
+ *
+ * Sorting with _gtk_tree_data_list_compare_func() fetches two values
+ * for every comparison, and collates strings every time. Sort keys
+ * hold the value of every row once, with strings turned into collation
+ * keys, so sorting only compares plain values. Rows that compare equal
+ * keep their old order.
+ */
+
+/* Below this, sorting isn't worth handing to other threads */
+#define SORT_KEYS_MIN_PARALLEL 4096
+
+typedef struct _GtkTreeDataSortKey GtkTreeDataSortKey;
+
+struct _GtkTreeDataSortKey
+{
+  union {
+    gint64   v_int;
+    guint64  v_uint;
+    gdouble  v_double;
+    gchar   *v_string;
+  } key;
+  gint index;
+};
+
+struct _GtkTreeDataSortKeys
+{
+  GType type;
+  GtkSortType order;
+  gint n_keys;
+  GtkTreeDataSortKey *keys;
+  GtkTreeDataSortKey *merged;
+  gint run_length;
+};
+
+gboolean
+_gtk_tree_data_sort_keys_supported (GType type)
+{
+  switch (get_fundamental_type (type))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+    case G_TYPE_STRING:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+GtkTreeDataSortKeys *
+_gtk_tree_data_sort_keys_new (GType type,
+                              gint  n_keys)
+{
+  GtkTreeDataSortKeys *keys;
+
+  g_return_val_if_fail (_gtk_tree_data_sort_keys_supported (type), NULL);
+
+  keys = g_slice_new0 (GtkTreeDataSortKeys);
+  keys->type = get_fundamental_type (type);
+  keys->n_keys = n_keys;
+  keys->keys = g_new0 (GtkTreeDataSortKey, n_keys);
+
+  return keys;
+}
+
+void
+_gtk_tree_data_sort_keys_set_value (GtkTreeDataSortKeys *keys,
+                                    gint                 index,
+                                    const GValue        *value)
+{
+  GtkTreeDataSortKey *key = &keys->keys[index];
+  const gchar *str;
+
+  key->index = index;
+
+  switch (keys->type)
+    {
+    case G_TYPE_BOOLEAN:
+      key->key.v_int = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      key->key.v_int = g_value_get_schar (value);
+      break;
+    case G_TYPE_UCHAR:
+      key->key.v_uint = g_value_get_uchar (value);
+      break;
+    case G_TYPE_INT:
+      key->key.v_int = g_value_get_int (value);
+      break;
+    case G_TYPE_UINT:
+      key->key.v_uint = g_value_get_uint (value);
+      break;
+    case G_TYPE_LONG:
+      key->key.v_int = g_value_get_long (value);
+      break;
+    case G_TYPE_ULONG:
+      key->key.v_uint = g_value_get_ulong (value);
+      break;
+    case G_TYPE_INT64:
+      key->key.v_int = g_value_get_int64 (value);
+      break;
+    case G_TYPE_UINT64:
+      key->key.v_uint = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_ENUM:
+      key->key.v_int = g_value_get_enum (value);
+      break;
+    case G_TYPE_FLAGS:
+      key->key.v_uint = g_value_get_flags (value);
+      break;
+    case G_TYPE_FLOAT:
+      key->key.v_double = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      key->key.v_double = g_value_get_double (value);
+      break;
+    case G_TYPE_STRING:
+      /* Collated when sorting, so it can happen in parallel */
+      str = g_value_get_string (value);
+      key->key.v_string = g_strdup (str ? str : "");
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+/* @list is the node of the sort column, or %NULL if the row doesn't
+ * have one yet */
+void
+_gtk_tree_data_sort_keys_set_node (GtkTreeDataSortKeys *keys,
+                                   gint                 index,
+                                   GtkTreeDataList     *list)
+{
+  GtkTreeDataSortKey *key = &keys->keys[index];
+  const gchar *str;
+
+  key->index = index;
+
+  if (list == NULL)
+    {
+      if (keys->type == G_TYPE_STRING)
+        key->key.v_string = g_strdup ("");
+      else
+        memset (&key->key, 0, sizeof (key->key));
+      return;
+    }
+
+  switch (keys->type)
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_INT:
+    case G_TYPE_ENUM:
+      key->key.v_int = list->data.v_int;
+      break;
+    case G_TYPE_CHAR:
+      key->key.v_int = list->data.v_char;
+      break;
+    case G_TYPE_UCHAR:
+      key->key.v_uint = list->data.v_uchar;
+      break;
+    case G_TYPE_UINT:
+    case G_TYPE_FLAGS:
+      key->key.v_uint = list->data.v_uint;
+      break;
+    case G_TYPE_LONG:
+      key->key.v_int = list->data.v_long;
+      break;
+    case G_TYPE_ULONG:
+      key->key.v_uint = list->data.v_ulong;
+      break;
+    case G_TYPE_INT64:
+      key->key.v_int = list->data.v_int64;
+      break;
+    case G_TYPE_UINT64:
+      key->key.v_uint = list->data.v_uint64;
+      break;
+    case G_TYPE_FLOAT:
+      key->key.v_double = list->data.v_float;
+      break;
+    case G_TYPE_DOUBLE:
+      key->key.v_double = list->data.v_double;
+      break;
+    case G_TYPE_STRING:
+      str = list->data.v_pointer;
+      key->key.v_string = g_strdup (str ? str : "");
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gint
+gtk_tree_data_sort_key_compare (gconstpointer a,
+                                gconstpointer b,
+                                gpointer      user_data)
+{
+  const GtkTreeDataSortKeys *keys = user_data;
+  const GtkTreeDataSortKey *ka = a;
+  const GtkTreeDataSortKey *kb = b;
+  gint retval;
+
+  switch (keys->type)
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_INT:
+    case G_TYPE_LONG:
+    case G_TYPE_INT64:
+    case G_TYPE_ENUM:
+      retval = ka->key.v_int < kb->key.v_int ? -1 : (ka->key.v_int == kb->key.v_int ? 0 : 1);
+      break;
+    case G_TYPE_UCHAR:
+    case G_TYPE_UINT:
+    case G_TYPE_ULONG:
+    case G_TYPE_UINT64:
+    case G_TYPE_FLAGS:
+      retval = ka->key.v_uint < kb->key.v_uint ? -1 : (ka->key.v_uint == kb->key.v_uint ? 0 : 1);
+      break;
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      retval = ka->key.v_double < kb->key.v_double ? -1 : (ka->key.v_double == kb->key.v_double ? 0 : 1);
+      break;
+    case G_TYPE_STRING:
+      retval = strcmp (ka->key.v_string, kb->key.v_string);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  if (keys->order == GTK_SORT_DESCENDING)
+    retval = -retval;
+
+  if (retval == 0)
+    retval = ka->index < kb->index ? -1 : (ka->index == kb->index ? 0 : 1);
+
+  return retval;
+}
+
+static void
+gtk_tree_data_sort_keys_collate (guint    start,
+                                 guint    end,
+                                 gpointer user_data)
+{
+  GtkTreeDataSortKeys *keys = user_data;
+  guint i;
+
+  for (i = start; i < end; i++)
+    {
+      gchar *str = keys->keys[i].key.v_string;
+
+      keys->keys[i].key.v_string = g_utf8_collate_key (str, -1);
+      g_free (str);
+    }
+}
+
+static void
+gtk_tree_data_sort_keys_sort_runs (guint    start,
+                                   guint    end,
+                                   gpointer user_data)
+{
+  GtkTreeDataSortKeys *keys = user_data;
+  guint run;
+
+  for (run = start; run < end; run++)
+    {
+      gint first = run * keys->run_length;
+
+      g_qsort_with_data (keys->keys + first,
+                         MIN (keys->run_length, keys->n_keys - first),
+                         sizeof (GtkTreeDataSortKey),
+                         gtk_tree_data_sort_key_compare,
+                         keys);
+    }
+}
+
+static void
+gtk_tree_data_sort_keys_merge_runs (guint    start,
+                                    guint    end,
+                                    gpointer user_data)
+{
+  GtkTreeDataSortKeys *keys = user_data;
+  const GtkTreeDataSortKey *src = keys->keys;
+  GtkTreeDataSortKey *dest = keys->merged;
+  guint pair;
+
+  for (pair = start; pair < end; pair++)
+    {
+      gint first = 2 * pair * keys->run_length;
+      gint middle = MIN (first + keys->run_length, keys->n_keys);
+      gint last = MIN (middle + keys->run_length, keys->n_keys);
+      gint i = first, j = middle, k = first;
+
+      while (i < middle && j < last)
+        {
+          if (gtk_tree_data_sort_key_compare (&src[j], &src[i], keys) < 0)
+            dest[k++] = src[j++];
+          else
+            dest[k++] = src[i++];
+        }
+
+      memcpy (dest + k, src + i, (middle - i) * sizeof (GtkTreeDataSortKey));
+      k += middle - i;
+      memcpy (dest + k, src + j, (last - j) * sizeof (GtkTreeDataSortKey));
+    }
+}
+
+/* Sorts @keys and frees them. Returns the new order of the rows,
+ * as needed for gtk_tree_model_rows_reordered(), free it with g_free() */
+gint *
+_gtk_tree_data_sort_keys_sort (GtkTreeDataSortKeys *keys,
+                               GtkSortType          order)
+{
+  GtkTreeDataSortKey *tmp;
+  guint n_threads;
+  gint *new_order;
+  gint i;
+
+  keys->order = order;
+
+  if (keys->type == G_TYPE_STRING)
+    gtk_parallel_for (keys->n_keys, 256, gtk_tree_data_sort_keys_collate, keys);
+
+  n_threads = gtk_parallel_get_n_threads ();
+
+  if (n_threads <= 1 || keys->n_keys < SORT_KEYS_MIN_PARALLEL)
+    {
+      g_qsort_with_data (keys->keys, keys->n_keys, sizeof (GtkTreeDataSortKey),
+                         gtk_tree_data_sort_key_compare, keys);
+    }
+  else
+    {
+      /* Sort one run per thread, then merge pairs of runs */
+      keys->run_length = (keys->n_keys + n_threads - 1) / n_threads;
+      gtk_parallel_for ((keys->n_keys + keys->run_length - 1) / keys->run_length, 1,
+                        gtk_tree_data_sort_keys_sort_runs, keys);
+
+      keys->merged = g_new (GtkTreeDataSortKey, keys->n_keys);
+
+      while (keys->run_length < keys->n_keys)
+        {
+          gint pair_length = 2 * keys->run_length;
+
+          gtk_parallel_for ((keys->n_keys + pair_length - 1) / pair_length, 1,
+                            gtk_tree_data_sort_keys_merge_runs, keys);
+
+          tmp = keys->keys;
+          keys->keys = keys->merged;
+          keys->merged = tmp;
+          keys->run_length = pair_length;
+        }
+
+      g_free (keys->merged);
+    }
+
+  new_order = g_new (gint, keys->n_keys);
+  for (i = 0; i < keys->n_keys; i++)
+    {
+      new_order[i] = keys->keys[i].index;
+      if (keys->type == G_TYPE_STRING)
+        g_free (keys->keys[i].key.v_string);
+    }
+
+  g_free (keys->keys);
+  g_slice_free (GtkTreeDataSortKeys, keys);
+
+  return new_order;
+}
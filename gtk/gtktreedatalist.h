@@ -78,4 +78,19 @@ GList                 *_gtk_tree_data_list_set_header  (GList                  *
 							gpointer                data,
 							GDestroyNotify          destroy);
 
+/* Sort keys, to sort with _gtk_tree_data_list_compare_func() quickly */
+typedef struct _GtkTreeDataSortKeys GtkTreeDataSortKeys;
+
+gboolean             _gtk_tree_data_sort_keys_supported (GType                type);
+GtkTreeDataSortKeys *_gtk_tree_data_sort_keys_new       (GType                type,
+                                                         gint                 n_keys);
+void                 _gtk_tree_data_sort_keys_set_value (GtkTreeDataSortKeys *keys,
+                                                         gint                 index,
+                                                         const GValue        *value);
+void                 _gtk_tree_data_sort_keys_set_node  (GtkTreeDataSortKeys *keys,
+                                                         gint                 index,
+                                                         GtkTreeDataList     *list);
+gint                *_gtk_tree_data_sort_keys_sort      (GtkTreeDataSortKeys *keys,
+                                                         GtkSortType          order);
+
 #endif /* __GTK_TREE_DATA_LIST_H__ */
@@ -240,6 +240,8 @@
     }G_STMT_END
 
 #define ROW_REF_DATA_STRING "gtk-tree-row-refs"
+#define REPLAY_PATH_DATA_STRING "gtk-tree-model-replay-path"
+#define DELETED_REPLAY_PATH_DATA_STRING "gtk-tree-model-deleted-replay-path"
 
 enum {
   ROW_CHANGED,
@@ -247,6 +249,8 @@ enum {
   ROW_HAS_CHILD_TOGGLED,
   ROW_DELETED,
   ROWS_REORDERED,
+  ROWS_INSERTED,
+  ROWS_DELETED,
   LAST_SIGNAL
 };
 
@@ -273,12 +277,24 @@ static void      row_inserted_marshal       (GClosure          *closure,
                                              const GValue      *param_values,
                                              gpointer           invocation_hint,
                                              gpointer           marshal_data);
+static void      rows_inserted_marshal      (GClosure          *closure,
+                                             GValue /* out */  *return_value,
+                                             guint              n_param_value,
+                                             const GValue      *param_values,
+                                             gpointer           invocation_hint,
+                                             gpointer           marshal_data);
 static void      row_deleted_marshal        (GClosure          *closure,
                                              GValue /* out */  *return_value,
                                              guint              n_param_value,
                                              const GValue      *param_values,
                                              gpointer           invocation_hint,
                                              gpointer           marshal_data);
+static void      rows_deleted_marshal       (GClosure          *closure,
+                                             GValue /* out */  *return_value,
+                                             guint              n_param_value,
+                                             const GValue      *param_values,
+                                             gpointer           invocation_hint,
+                                             gpointer           marshal_data);
 static void      rows_reordered_marshal     (GClosure          *closure,
                                              GValue /* out */  *return_value,
                                              guint              n_param_value,
@@ -288,9 +304,10 @@ static void      rows_reordered_marshal     (GClosure          *closure,
 
 static void      gtk_tree_row_ref_inserted  (RowRefList        *refs,
                                              GtkTreePath       *path,
-                                             GtkTreeIter       *iter);
+                                             gint               n_rows);
 static void      gtk_tree_row_ref_deleted   (RowRefList        *refs,
-                                             GtkTreePath       *path);
+                                             GtkTreePath       *path,
+                                             gint               n_rows);
 static void      gtk_tree_row_ref_reordered (RowRefList        *refs,
                                              GtkTreePath       *path,
                                              GtkTreeIter       *iter,
@@ -337,6 +354,8 @@ gtk_tree_model_base_init (gpointer g_class)
       GType row_inserted_params[2];
       GType row_deleted_params[1];
       GType rows_reordered_params[3];
+      GType rows_inserted_params[3];
+      GType rows_deleted_params[2];
 
       row_inserted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
       row_inserted_params[1] = GTK_TYPE_TREE_ITER;
@@ -347,6 +366,13 @@ gtk_tree_model_base_init (gpointer g_class)
       rows_reordered_params[1] = GTK_TYPE_TREE_ITER;
       rows_reordered_params[2] = G_TYPE_POINTER;
 
+      rows_deleted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
+      rows_deleted_params[1] = G_TYPE_INT;
+
+      rows_inserted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
+      rows_inserted_params[1] = GTK_TYPE_TREE_ITER;
+      rows_inserted_params[2] = G_TYPE_INT;
+
       /**
        * GtkTreeModel::row-changed:
        * @tree_model: the #GtkTreeModel on which the signal is emitted
@@ -479,6 +505,64 @@ gtk_tree_model_base_init (gpointer g_class)
                        _gtk_marshal_VOID__BOXED_BOXED_POINTER,
                        G_TYPE_NONE, 3,
                        rows_reordered_params);
+
+      /**
+       * GtkTreeModel::rows-inserted:
+       * @tree_model: the #GtkTreeModel on which the signal is emitted
+       * @path: a #GtkTreePath-struct identifying the first new row
+       * @iter: a valid #GtkTreeIter-struct pointing to the first new row
+       * @n_rows: the number of new rows
+       *
+       * This signal is emitted when @n_rows consecutive rows have been
+       * inserted in the model at once, see gtk_tree_model_rows_inserted().
+       *
+       * #GtkTreeModel::row-inserted is emitted for each of the rows
+       * afterwards, for code that only handles single rows. Handlers
+       * of this signal should ignore those emissions, they can tell
+       * them apart with gtk_tree_model_row_inserted_is_replay().
+       *
+       * Since: 3.92
+       */
+      closure = g_closure_new_simple (sizeof (GClosure), NULL);
+      g_closure_set_marshal (closure, rows_inserted_marshal);
+      tree_model_signals[ROWS_INSERTED] =
+        g_signal_newv (I_("rows-inserted"),
+                       GTK_TYPE_TREE_MODEL,
+                       G_SIGNAL_RUN_FIRST,
+                       closure,
+                       NULL, NULL,
+                       NULL,
+                       G_TYPE_NONE, 3,
+                       rows_inserted_params);
+
+      /**
+       * GtkTreeModel::rows-deleted:
+       * @tree_model: the #GtkTreeModel on which the signal is emitted
+       * @path: a #GtkTreePath-struct identifying the first deleted row
+       * @n_rows: the number of deleted rows
+       *
+       * This signal is emitted when @n_rows consecutive rows have been
+       * deleted from the model at once, see gtk_tree_model_rows_deleted().
+       * @path is the location the first of the rows previously was at.
+       *
+       * #GtkTreeModel::row-deleted is emitted @n_rows times with that
+       * path afterwards, for code that only handles single rows. Handlers
+       * of this signal should ignore those emissions, they can tell
+       * them apart with gtk_tree_model_row_deleted_is_replay().
+       *
+       * Since: 3.92
+       */
+      closure = g_closure_new_simple (sizeof (GClosure), NULL);
+      g_closure_set_marshal (closure, rows_deleted_marshal);
+      tree_model_signals[ROWS_DELETED] =
+        g_signal_newv (I_("rows-deleted"),
+                       GTK_TYPE_TREE_MODEL,
+                       G_SIGNAL_RUN_FIRST,
+                       closure,
+                       NULL, NULL,
+                       NULL,
+                       G_TYPE_NONE, 2,
+                       rows_deleted_params);
       initialized = TRUE;
     }
 }
@@ -501,9 +585,11 @@ row_inserted_marshal (GClosure          *closure,
   GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
   GtkTreeIter *iter = (GtkTreeIter *)g_value_get_boxed (param_values + 2);
 
-  /* first, we need to update internal row references */
-  gtk_tree_row_ref_inserted ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
-                             path, iter);
+  /* first, we need to update internal row references, unless
+   * ::rows-inserted already did that */
+  if (!gtk_tree_model_row_inserted_is_replay (GTK_TREE_MODEL (model), path))
+    gtk_tree_row_ref_inserted ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
+                               path, 1);
 
   /* fetch the interface ->row_inserted implementation */
   iface = GTK_TREE_MODEL_GET_IFACE (model);
@@ -516,6 +602,22 @@ row_inserted_marshal (GClosure          *closure,
     row_inserted_callback (GTK_TREE_MODEL (model), path, iter);
 }
 
+static void
+rows_inserted_marshal (GClosure          *closure,
+                       GValue /* out */  *return_value,
+                       guint              n_param_values,
+                       const GValue      *param_values,
+                       gpointer           invocation_hint,
+                       gpointer           marshal_data)
+{
+  GObject *model = g_value_get_object (param_values + 0);
+  GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
+  gint n_rows = g_value_get_int (param_values + 3);
+
+  gtk_tree_row_ref_inserted ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
+                             path, n_rows);
+}
+
 static void
 row_deleted_marshal (GClosure          *closure,
                      GValue /* out */  *return_value,
@@ -530,9 +632,11 @@ row_deleted_marshal (GClosure          *closure,
   GObject *model = g_value_get_object (param_values + 0);
   GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
 
-  /* first, we need to update internal row references */
-  gtk_tree_row_ref_deleted ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
-                            path);
+  /* first, we need to update internal row references, unless
+   * ::rows-deleted already did that */
+  if (!gtk_tree_model_row_deleted_is_replay (GTK_TREE_MODEL (model), path))
+    gtk_tree_row_ref_deleted ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
+                              path, 1);
 
   /* fetch the interface ->row_deleted implementation */
   iface = GTK_TREE_MODEL_GET_IFACE (model);
@@ -545,6 +649,22 @@ row_deleted_marshal (GClosure          *closure,
     row_deleted_callback (GTK_TREE_MODEL (model), path);
 }
 
+static void
+rows_deleted_marshal (GClosure          *closure,
+                      GValue /* out */  *return_value,
+                      guint              n_param_values,
+                      const GValue      *param_values,
+                      gpointer           invocation_hint,
+                      gpointer           marshal_data)
+{
+  GObject *model = g_value_get_object (param_values + 0);
+  GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
+  gint n_rows = g_value_get_int (param_values + 2);
+
+  gtk_tree_row_ref_deleted ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
+                            path, n_rows);
+}
+
 static void
 rows_reordered_marshal (GClosure          *closure,
                         GValue /* out */  *return_value,
@@ -1855,6 +1975,83 @@ gtk_tree_model_row_inserted (GtkTreeModel *tree_model,
   g_signal_emit (tree_model, tree_model_signals[ROW_INSERTED], 0, path, iter);
 }
 
+/**
+ * gtk_tree_model_rows_inserted:
+ * @tree_model: a #GtkTreeModel
+ * @path: a #GtkTreePath-struct pointing to the first inserted row
+ * @iter: a valid #GtkTreeIter-struct pointing to the first inserted row
+ * @n_rows: the number of consecutive rows that were inserted
+ *
+ * Emits the #GtkTreeModel::rows-inserted signal on @tree_model, and
+ * then #GtkTreeModel::row-inserted for each of the rows. Models call
+ * this after inserting many rows at once, so views can add them in
+ * one go.
+ *
+ * Since: 3.92
+ */
+void
+gtk_tree_model_rows_inserted (GtkTreeModel *tree_model,
+                              GtkTreePath  *path,
+                              GtkTreeIter  *iter,
+                              gint          n_rows)
+{
+  GtkTreePath *row_path, *old_replay_path;
+  GtkTreeIter row_iter;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (n_rows >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  g_signal_emit (tree_model, tree_model_signals[ROWS_INSERTED], 0, path, iter, n_rows);
+
+  /* Tell everybody else about the rows one by one */
+  old_replay_path = g_object_get_data (G_OBJECT (tree_model), REPLAY_PATH_DATA_STRING);
+  row_path = gtk_tree_path_copy (path);
+  g_object_set_data (G_OBJECT (tree_model), REPLAY_PATH_DATA_STRING, row_path);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      if (i > 0)
+        gtk_tree_path_next (row_path);
+
+      if (!gtk_tree_model_get_iter (tree_model, &row_iter, row_path))
+        break;
+
+      g_signal_emit (tree_model, tree_model_signals[ROW_INSERTED], 0, row_path, &row_iter);
+    }
+
+  g_object_set_data (G_OBJECT (tree_model), REPLAY_PATH_DATA_STRING, old_replay_path);
+  gtk_tree_path_free (row_path);
+}
+
+/**
+ * gtk_tree_model_row_inserted_is_replay:
+ * @tree_model: a #GtkTreeModel
+ * @path: the path passed to a #GtkTreeModel::row-inserted handler
+ *
+ * Checks whether a #GtkTreeModel::row-inserted emission is for one of
+ * the rows that were just announced with #GtkTreeModel::rows-inserted.
+ * Code that handles both signals ignores these emissions.
+ *
+ * Returns: %TRUE if the row was already announced
+ *
+ * Since: 3.92
+ */
+gboolean
+gtk_tree_model_row_inserted_is_replay (GtkTreeModel *tree_model,
+                                       GtkTreePath  *path)
+{
+  g_return_val_if_fail (GTK_IS_TREE_MODEL (tree_model), FALSE);
+
+  return path != NULL &&
+         g_object_get_data (G_OBJECT (tree_model), REPLAY_PATH_DATA_STRING) == path;
+}
+
 /**
  * gtk_tree_model_row_has_child_toggled:
  * @tree_model: a #GtkTreeModel
@@ -1902,6 +2099,75 @@ gtk_tree_model_row_deleted (GtkTreeModel *tree_model,
   g_signal_emit (tree_model, tree_model_signals[ROW_DELETED], 0, path);
 }
 
+/**
+ * gtk_tree_model_rows_deleted:
+ * @tree_model: a #GtkTreeModel
+ * @path: a #GtkTreePath-struct pointing to the previous location of
+ *     the first deleted row
+ * @n_rows: the number of consecutive rows that were deleted
+ *
+ * Emits the #GtkTreeModel::rows-deleted signal on @tree_model, and
+ * then #GtkTreeModel::row-deleted @n_rows times. Models call this
+ * after removing many rows at once, so views can drop them in one go.
+ *
+ * As with gtk_tree_model_row_deleted(), the location pointed to by
+ * @path should be the location that the first row previously was at.
+ *
+ * Since: 3.92
+ */
+void
+gtk_tree_model_rows_deleted (GtkTreeModel *tree_model,
+                             GtkTreePath  *path,
+                             gint          n_rows)
+{
+  GtkTreePath *row_path, *old_replay_path;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (n_rows >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  g_signal_emit (tree_model, tree_model_signals[ROWS_DELETED], 0, path, n_rows);
+
+  /* Tell everybody else about the rows one by one, each of them
+   * was at @path once the previous ones were gone */
+  old_replay_path = g_object_get_data (G_OBJECT (tree_model), DELETED_REPLAY_PATH_DATA_STRING);
+  row_path = gtk_tree_path_copy (path);
+  g_object_set_data (G_OBJECT (tree_model), DELETED_REPLAY_PATH_DATA_STRING, row_path);
+
+  for (i = 0; i < n_rows; i++)
+    g_signal_emit (tree_model, tree_model_signals[ROW_DELETED], 0, row_path);
+
+  g_object_set_data (G_OBJECT (tree_model), DELETED_REPLAY_PATH_DATA_STRING, old_replay_path);
+  gtk_tree_path_free (row_path);
+}
+
+/**
+ * gtk_tree_model_row_deleted_is_replay:
+ * @tree_model: a #GtkTreeModel
+ * @path: the path passed to a #GtkTreeModel::row-deleted handler
+ *
+ * Checks whether a #GtkTreeModel::row-deleted emission is for one of
+ * the rows that were just announced with #GtkTreeModel::rows-deleted.
+ * Code that handles both signals ignores these emissions.
+ *
+ * Returns: %TRUE if the row was already announced
+ *
+ * Since: 3.92
+ */
+gboolean
+gtk_tree_model_row_deleted_is_replay (GtkTreeModel *tree_model,
+                                      GtkTreePath  *path)
+{
+  g_return_val_if_fail (GTK_IS_TREE_MODEL (tree_model), FALSE);
+
+  return path != NULL &&
+         g_object_get_data (G_OBJECT (tree_model), DELETED_REPLAY_PATH_DATA_STRING) == path;
+}
+
 /**
  * gtk_tree_model_rows_reordered: (skip)
  * @tree_model: a #GtkTreeModel
@@ -2086,7 +2352,7 @@ release_row_references (gpointer data)
 static void
 gtk_tree_row_ref_inserted (RowRefList  *refs,
                            GtkTreePath *path,
-                           GtkTreeIter *iter)
+                           gint         n_rows)
 {
   GSList *tmp_list;
 
@@ -2099,7 +2365,8 @@ gtk_tree_row_ref_inserted (RowRefList  *refs,
    * that the inserted path is in a different "coordinate system" than
    * the old path (e.g. if the inserted path was just before the old
    * path, then inserted path and old path will be the same, and old
-   * path must be moved down one).
+   * path must be moved down one). @n_rows rows were inserted at
+   * @path.
    */
 
   tmp_list = refs->list;
@@ -2128,7 +2395,7 @@ gtk_tree_row_ref_inserted (RowRefList  *refs,
             goto done;
 
           if (path->indices[path->depth-1] <= reference->path->indices[path->depth-1])
-            reference->path->indices[path->depth-1] += 1;
+            reference->path->indices[path->depth-1] += n_rows;
         }
     done:
       tmp_list = tmp_list->next;
@@ -2137,7 +2404,8 @@ gtk_tree_row_ref_inserted (RowRefList  *refs,
 
 static void
 gtk_tree_row_ref_deleted (RowRefList  *refs,
-                          GtkTreePath *path)
+                          GtkTreePath *path,
+                          gint         n_rows)
 {
   GSList *tmp_list;
 
@@ -2149,6 +2417,7 @@ gtk_tree_row_ref_deleted (RowRefList  *refs,
    * deletion with the old path of the just-deleted row. Which means
    * that the deleted path is the same now-defunct "coordinate system"
    * as the path saved in the reference, which is what we want to fix.
+   * @n_rows rows starting at @path were deleted.
    */
 
   tmp_list = refs->list;
@@ -2170,7 +2439,8 @@ gtk_tree_row_ref_deleted (RowRefList  *refs,
             }
 
           /* We know it affects us. */
-          if (path->indices[i] == reference->path->indices[i])
+          if (path->indices[i] <= reference->path->indices[i] &&
+              reference->path->indices[i] < path->indices[i] + n_rows)
             {
               if (reference->path->depth > path->depth)
                 /* some parent was deleted, trying to unref any node
@@ -2185,7 +2455,7 @@ gtk_tree_row_ref_deleted (RowRefList  *refs,
             }
           else if (path->indices[i] < reference->path->indices[i])
             {
-              reference->path->indices[path->depth-1]-=1;
+              reference->path->indices[path->depth-1]-=n_rows;
             }
         }
 
@@ -2531,7 +2801,7 @@ gtk_tree_row_reference_inserted (GObject     *proxy,
 {
   g_return_if_fail (G_IS_OBJECT (proxy));
 
-  gtk_tree_row_ref_inserted ((RowRefList *)g_object_get_data (proxy, ROW_REF_DATA_STRING), path, NULL);
+  gtk_tree_row_ref_inserted ((RowRefList *)g_object_get_data (proxy, ROW_REF_DATA_STRING), path, 1);
 }
 
 /**
@@ -2549,7 +2819,7 @@ gtk_tree_row_reference_deleted (GObject     *proxy,
 {
   g_return_if_fail (G_IS_OBJECT (proxy));
 
-  gtk_tree_row_ref_deleted ((RowRefList *)g_object_get_data (proxy, ROW_REF_DATA_STRING), path);
+  gtk_tree_row_ref_deleted ((RowRefList *)g_object_get_data (proxy, ROW_REF_DATA_STRING), path, 1);
 }
 
 /**
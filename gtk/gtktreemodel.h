@@ -384,6 +384,14 @@ GDK_AVAILABLE_IN_ALL
 void gtk_tree_model_row_inserted          (GtkTreeModel *tree_model,
 					   GtkTreePath  *path,
 					   GtkTreeIter  *iter);
+GDK_AVAILABLE_IN_3_92
+void gtk_tree_model_rows_inserted         (GtkTreeModel *tree_model,
+					   GtkTreePath  *path,
+					   GtkTreeIter  *iter,
+					   gint          n_rows);
+GDK_AVAILABLE_IN_3_92
+gboolean gtk_tree_model_row_inserted_is_replay (GtkTreeModel *tree_model,
+                                                GtkTreePath  *path);
 GDK_AVAILABLE_IN_ALL
 void gtk_tree_model_row_has_child_toggled (GtkTreeModel *tree_model,
 					   GtkTreePath  *path,
@@ -391,6 +399,13 @@ void gtk_tree_model_row_has_child_toggled (GtkTreeModel *tree_model,
 GDK_AVAILABLE_IN_ALL
 void gtk_tree_model_row_deleted           (GtkTreeModel *tree_model,
 					   GtkTreePath  *path);
+GDK_AVAILABLE_IN_3_92
+void gtk_tree_model_rows_deleted          (GtkTreeModel *tree_model,
+					   GtkTreePath  *path,
+					   gint          n_rows);
+GDK_AVAILABLE_IN_3_92
+gboolean gtk_tree_model_row_deleted_is_replay (GtkTreeModel *tree_model,
+                                               GtkTreePath  *path);
 GDK_AVAILABLE_IN_ALL
 void gtk_tree_model_rows_reordered        (GtkTreeModel *tree_model,
 					   GtkTreePath  *path,
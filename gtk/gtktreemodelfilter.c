@@ -21,6 +21,7 @@
 #include "gtkintl.h"
 #include "gtktreednd.h"
 #include "gtkprivate.h"
+#include "gtkparallelprivate.h"
 #include <string.h>
 
 
@@ -283,6 +284,7 @@ struct _GtkTreeModelFilterPrivate
   gint modify_n_columns;
 
   guint visible_method_set   : 1;
+  guint visible_func_threaded : 1;
   guint modify_func_set      : 1;
 
   guint in_row_deleted       : 1;
@@ -291,8 +293,10 @@ struct _GtkTreeModelFilterPrivate
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
+  gulong rows_inserted_id;
   gulong has_child_toggled_id;
   gulong deleted_id;
+  gulong rows_deleted_id;
   gulong reordered_id;
 };
 
@@ -347,6 +351,11 @@ static void         gtk_tree_model_filter_row_inserted                    (GtkTr
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_rows_inserted                   (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gint                    n_rows,
+                                                                           gpointer                data);
 static void         gtk_tree_model_filter_row_has_child_toggled           (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
@@ -354,6 +363,10 @@ static void         gtk_tree_model_filter_row_has_child_toggled           (GtkTr
 static void         gtk_tree_model_filter_row_deleted                     (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_rows_deleted                    (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           gint                    n_rows,
+                                                                           gpointer                data);
 static void         gtk_tree_model_filter_rows_reordered                  (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
@@ -482,7 +495,8 @@ static FilterElt   *gtk_tree_model_filter_fetch_child                     (GtkTr
                                                                            gint                   *index);
 static void         gtk_tree_model_filter_remove_elt_from_level           (GtkTreeModelFilter     *filter,
                                                                            FilterLevel            *level,
-                                                                           FilterElt              *elt);
+                                                                           FilterElt              *elt,
+                                                                           gboolean                emit_row_deleted);
 static void         gtk_tree_model_filter_update_children                 (GtkTreeModelFilter     *filter,
                                                                            FilterLevel            *level,
                                                                            FilterElt              *elt);
@@ -1428,7 +1442,7 @@ gtk_tree_model_filter_check_ancestors (GtkTreeModelFilter *filter,
                * chain.
                */
               gtk_tree_model_filter_remove_elt_from_level (filter,
-                                                           level, elt);
+                                                           level, elt, TRUE);
               return;
             }
 
@@ -1617,11 +1631,14 @@ gtk_tree_model_filter_fetch_child (GtkTreeModelFilter *filter,
  * which are still present in the child model.  As a result, we must
  * take care to properly release the references the filter model has
  * on the child model nodes.
+ *
+ * If @emit_row_deleted is %FALSE, the caller announces the removal.
  */
 static void
 gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
                                              FilterLevel        *level,
-                                             FilterElt          *elt)
+                                             FilterElt          *elt,
+                                             gboolean            emit_row_deleted)
 {
   FilterElt *parent;
   FilterLevel *parent_level;
@@ -1643,7 +1660,7 @@ gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
   parent = level->parent_elt;
   parent_level = level->parent_level;
 
-  if (!parent || orig_level_ext_ref_count > 0)
+  if (emit_row_deleted && (!parent || orig_level_ext_ref_count > 0))
     path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
   else
     /* If the level is not visible, the parent is potentially invisible
@@ -1718,7 +1735,7 @@ gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
       /* Only if the node is in the root level (parent == NULL) or
        * the level is visible, a row-deleted signal is necessary.
        */
-      if (!parent || orig_level_ext_ref_count > 0)
+      if (path)
         gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), path);
     }
   else
@@ -1777,11 +1794,12 @@ gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
             }
         }
 
-      if (!parent || orig_level_ext_ref_count > 0)
+      if (path)
         gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), path);
     }
 
-  gtk_tree_path_free (path);
+  if (path)
+    gtk_tree_path_free (path);
 
   if (emit_child_toggled && parent->ext_ref_count > 0)
     {
@@ -2048,7 +2066,8 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
     {
       gtk_tree_model_filter_remove_elt_from_level (filter,
                                                    FILTER_LEVEL (iter.user_data),
-                                                   FILTER_ELT (iter.user_data2));
+                                                   FILTER_ELT (iter.user_data2),
+                                                   TRUE);
 
       if (real_path)
         gtk_tree_model_filter_check_ancestors (filter, real_path);
@@ -2129,6 +2148,10 @@ gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
 
   g_return_if_fail (c_path != NULL || c_iter != NULL);
 
+  /* Already handled by gtk_tree_model_filter_rows_inserted() */
+  if (gtk_tree_model_row_inserted_is_replay (c_model, c_path))
+    return;
+
   if (!c_path)
     {
       c_path = gtk_tree_model_get_path (c_model, c_iter);
@@ -2290,6 +2313,238 @@ done:
     gtk_tree_path_free (c_path);
 }
 
+/* Like gtk_tree_model_filter_row_inserted(), but the offsets in the
+ * level are updated only once and the visible rows, which are next to
+ * each other in the level, are announced with a single signal.
+ */
+static void
+gtk_tree_model_filter_rows_inserted (GtkTreeModel *c_model,
+                                     GtkTreePath  *c_path,
+                                     GtkTreeIter  *c_iter,
+                                     gint          n_rows,
+                                     gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *real_path = NULL;
+  GtkTreePath *first_c_path;
+  GtkTreePath *path;
+  GtkTreeIter real_c_iter;
+  GtkTreeIter iter;
+
+  FilterElt *elt = NULL;
+  FilterLevel *level = NULL;
+  FilterLevel *parent_level = NULL;
+  GSequenceIter *siter, *end_siter;
+  FilterElt dummy;
+
+  gint i, j, offset, depth;
+  gint first_visible = -1;
+  gint n_visible = 0;
+
+  /* the rows have already been inserted. so we need to fixup the
+   * virtual root here first
+   */
+  if (filter->priv->virtual_root)
+    {
+      if (gtk_tree_path_get_depth (filter->priv->virtual_root) >=
+          gtk_tree_path_get_depth (c_path))
+        {
+          gint *v_indices, *c_indices;
+          gboolean common_prefix = TRUE;
+
+          depth = gtk_tree_path_get_depth (c_path) - 1;
+          v_indices = gtk_tree_path_get_indices (filter->priv->virtual_root);
+          c_indices = gtk_tree_path_get_indices (c_path);
+
+          for (i = 0; i < depth; i++)
+            if (v_indices[i] != c_indices[i])
+              {
+                common_prefix = FALSE;
+                break;
+              }
+
+          if (common_prefix && v_indices[depth] >= c_indices[depth])
+            v_indices[depth] += n_rows;
+        }
+    }
+
+  /* subtract virtual root if necessary */
+  if (filter->priv->virtual_root)
+    {
+      real_path = gtk_tree_model_filter_remove_root (c_path,
+                                                     filter->priv->virtual_root);
+      /* not our children */
+      if (!real_path)
+        return;
+    }
+  else
+    real_path = gtk_tree_path_copy (c_path);
+
+  if (!filter->priv->root)
+    {
+      /* See gtk_tree_model_filter_row_inserted(), building the root
+       * level emits the signals for the new rows already.
+       */
+      gtk_tree_model_filter_build_level (filter, NULL, NULL, TRUE);
+
+      if (filter->priv->root)
+        goto done;
+    }
+
+  depth = gtk_tree_path_get_depth (real_path);
+
+  if (depth - 1 >= 1)
+    {
+      gboolean found = FALSE;
+      GtkTreePath *parent = gtk_tree_path_copy (real_path);
+      gtk_tree_path_up (parent);
+
+      found = find_elt_with_offset (filter, parent, &parent_level, &elt);
+
+      gtk_tree_path_free (parent);
+
+      if (!found)
+        /* Parent is not in the cache and probably being filtered out */
+        goto done;
+
+      level = elt->children;
+    }
+  else
+    level = FILTER_LEVEL (filter->priv->root);
+
+  if (!level)
+    {
+      if (elt && elt->visible_siter)
+        {
+          /* The level in which the new nodes should be inserted does
+           * not exist, but the visible parent does.
+           */
+          GtkTreePath *tmppath;
+          GtkTreeIter  tmpiter;
+
+          tmpiter.stamp = filter->priv->stamp;
+          tmpiter.user_data = parent_level;
+          tmpiter.user_data2 = elt;
+
+          tmppath = gtk_tree_model_get_path (GTK_TREE_MODEL (filter),
+                                             &tmpiter);
+
+          if (tmppath)
+            {
+              gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (filter),
+                                                    tmppath, &tmpiter);
+              gtk_tree_path_free (tmppath);
+            }
+        }
+      goto done;
+    }
+
+  offset = gtk_tree_path_get_indices (real_path)[depth - 1];
+
+  /* update the offsets of the following rows once */
+  dummy.offset = offset;
+  siter = g_sequence_search (level->seq, &dummy, filter_elt_cmp, NULL);
+  siter = g_sequence_iter_prev (siter);
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (; siter != end_siter; siter = g_sequence_iter_next (siter))
+    {
+      FilterElt *e = g_sequence_get (siter);
+
+      if (e->offset >= offset)
+        e->offset += n_rows;
+    }
+
+  /* only insert the visible rows */
+  real_c_iter = *c_iter;
+  for (j = 0; j < n_rows; j++)
+    {
+      FilterElt *felt;
+
+      if (j > 0 && !gtk_tree_model_iter_next (c_model, &real_c_iter))
+        break;
+
+      if (!gtk_tree_model_filter_visible (filter, &real_c_iter))
+        continue;
+
+      felt = gtk_tree_model_filter_insert_elt_in_level (filter,
+                                                        &real_c_iter,
+                                                        level, offset + j,
+                                                        &i);
+
+      /* insert_elt_in_level defaults to FALSE */
+      felt->visible_siter = g_sequence_insert_sorted (level->visible_seq,
+                                                      felt,
+                                                      filter_elt_cmp, NULL);
+
+      if (first_visible < 0)
+        first_visible = j;
+      n_visible++;
+    }
+
+done:
+  gtk_tree_model_filter_check_ancestors (filter, real_path);
+  gtk_tree_path_free (real_path);
+
+  if (n_visible == 0)
+    return;
+
+  gtk_tree_model_filter_increment_stamp (filter);
+
+  first_c_path = gtk_tree_path_copy (c_path);
+  gtk_tree_path_get_indices (first_c_path)[gtk_tree_path_get_depth (first_c_path) - 1] += first_visible;
+
+  path = gtk_real_tree_model_filter_convert_child_path_to_path (filter,
+                                                                first_c_path,
+                                                                FALSE,
+                                                                TRUE);
+  gtk_tree_path_free (first_c_path);
+
+  if (!path)
+    /* parent is probably being filtered out */
+    return;
+
+  gtk_tree_model_filter_get_iter_full (GTK_TREE_MODEL (filter), &iter, path);
+
+  level = FILTER_LEVEL (iter.user_data);
+  elt = FILTER_ELT (iter.user_data2);
+
+  /* Check whether the nodes and all of their parents are visible */
+  if (elt->visible_siter &&
+      gtk_tree_model_filter_elt_is_visible_in_target (level, elt))
+    {
+      gtk_tree_path_free (path);
+      path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
+
+      if (!level->parent_level || level->ext_ref_count > 0)
+        gtk_tree_model_rows_inserted (GTK_TREE_MODEL (filter), path, &iter, n_visible);
+
+      if (level->parent_level && level->parent_elt->ext_ref_count > 0 &&
+          g_sequence_get_length (level->visible_seq) == n_visible)
+        {
+          GtkTreePath *parent_path = gtk_tree_path_copy (path);
+          GtkTreeIter parent_iter;
+
+          /* These are the first visible nodes in this level */
+          gtk_tree_path_up (parent_path);
+          gtk_tree_model_get_iter (GTK_TREE_MODEL (filter), &parent_iter, parent_path);
+
+          gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (filter),
+                                                parent_path,
+                                                &parent_iter);
+          gtk_tree_path_free (parent_path);
+        }
+
+      siter = elt->visible_siter;
+      for (i = 0; i < n_visible; i++)
+        {
+          gtk_tree_model_filter_update_children (filter, level, g_sequence_get (siter));
+          siter = g_sequence_iter_next (siter);
+        }
+    }
+
+  gtk_tree_path_free (path);
+}
+
 static void
 gtk_tree_model_filter_row_has_child_toggled (GtkTreeModel *c_model,
                                              GtkTreePath  *c_path,
@@ -2348,7 +2603,7 @@ gtk_tree_model_filter_row_has_child_toggled (GtkTreeModel *c_model,
        * _remove_elt_from_level() takes care of emitting row-has-child-toggled
        * when required.
        */
-      gtk_tree_model_filter_remove_elt_from_level (filter, level, elt);
+      gtk_tree_model_filter_remove_elt_from_level (filter, level, elt, TRUE);
 
       return;
     }
@@ -2522,32 +2777,30 @@ gtk_tree_model_filter_row_deleted_invisible_node (GtkTreeModelFilter *filter,
                             decrease_offset_iter, GINT_TO_POINTER (offset));
 }
 
-static void
-gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
-                                   GtkTreePath  *c_path,
-                                   gpointer      data)
+/* Removes the row at @c_path, which was just deleted from the child
+ * model, from the cache.  Returns %FALSE if the row was not in the
+ * cache.  Otherwise *@path is set to the path of the row in the filter
+ * model if its deletion needs to be announced, and *@parent_level and
+ * *@parent_elt to the parent if it lost its last visible child.
+ */
+static gboolean
+gtk_tree_model_filter_remove_deleted_row (GtkTreeModelFilter  *filter,
+                                          GtkTreePath         *c_path,
+                                          GtkTreePath        **path,
+                                          FilterLevel        **parent_level,
+                                          FilterElt          **parent_elt)
 {
-  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
-  GtkTreePath *path;
+  GtkTreeModel *model = GTK_TREE_MODEL (filter);
+  GtkTreePath *f_path;
   GtkTreeIter iter;
-  FilterElt *elt, *parent_elt = NULL;
-  FilterLevel *level, *parent_level = NULL;
+  FilterElt *elt, *toggled_elt = NULL;
+  FilterLevel *level, *toggled_level = NULL;
   GSequenceIter *siter;
-  gboolean emit_child_toggled = FALSE;
   gboolean emit_row_deleted = FALSE;
   gint offset;
   gint orig_level_ext_ref_count;
 
-  g_return_if_fail (c_path != NULL);
-
-  /* special case the deletion of an ancestor of the virtual root */
-  if (filter->priv->virtual_root &&
-      (gtk_tree_path_is_ancestor (c_path, filter->priv->virtual_root) ||
-       !gtk_tree_path_compare (c_path, filter->priv->virtual_root)))
-    {
-      gtk_tree_model_filter_virtual_root_deleted (filter, c_path);
-      return;
-    }
+  *path = NULL;
 
   /* adjust the virtual root for the deleted row */
   if (filter->priv->virtual_root &&
@@ -2555,19 +2808,19 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
       gtk_tree_path_get_depth (c_path))
     gtk_tree_model_filter_adjust_virtual_root (filter, c_path);
 
-  path = gtk_real_tree_model_filter_convert_child_path_to_path (filter,
-                                                                c_path,
-                                                                FALSE,
-                                                                FALSE);
+  f_path = gtk_real_tree_model_filter_convert_child_path_to_path (filter,
+                                                                  c_path,
+                                                                  FALSE,
+                                                                  FALSE);
 
-  if (!path)
+  if (!f_path)
     {
       gtk_tree_model_filter_row_deleted_invisible_node (filter, c_path);
-      return;
+      return FALSE;
     }
 
   /* a node was deleted, which was in our cache */
-  gtk_tree_model_filter_get_iter_full (GTK_TREE_MODEL (data), &iter, path);
+  gtk_tree_model_filter_get_iter_full (model, &iter, f_path);
 
   level = FILTER_LEVEL (iter.user_data);
   elt = FILTER_ELT (iter.user_data2);
@@ -2577,14 +2830,13 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
   if (elt->visible_siter)
     {
       /* get a path taking only visible nodes into account */
-      gtk_tree_path_free (path);
-      path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
+      gtk_tree_path_free (f_path);
+      f_path = gtk_tree_model_get_path (model, &iter);
 
       if (g_sequence_get_length (level->visible_seq) == 1)
         {
-          emit_child_toggled = TRUE;
-          parent_level = level->parent_level;
-          parent_elt = level->parent_elt;
+          toggled_level = level->parent_level;
+          toggled_elt = level->parent_elt;
         }
 
       emit_row_deleted = TRUE;
@@ -2596,7 +2848,7 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
    * of a virtual root are automatically destroyed by the child model.
    */
   while (elt->ext_ref_count > 0)
-    gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (data), &iter,
+    gtk_tree_model_filter_real_unref_node (model, &iter,
                                            TRUE, FALSE);
 
   if (elt->children)
@@ -2604,11 +2856,11 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
      * will release this reference.
      */
     while (elt->ref_count > 1)
-      gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (data), &iter,
+      gtk_tree_model_filter_real_unref_node (model, &iter,
                                              FALSE, FALSE);
   else
     while (elt->ref_count > 0)
-      gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (data), &iter,
+      gtk_tree_model_filter_real_unref_node (model, &iter,
                                              FALSE, FALSE);
 
 
@@ -2648,21 +2900,51 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
           f_iter.user_data = level;
           f_iter.user_data2 = g_sequence_get (g_sequence_get_begin_iter (level->seq));
 
-          gtk_tree_model_filter_real_ref_node (GTK_TREE_MODEL (filter),
-                                               &f_iter, FALSE);
+          gtk_tree_model_filter_real_ref_node (model, &f_iter, FALSE);
         }
     }
 
   if (emit_row_deleted)
     {
-      /* emit row_deleted */
       gtk_tree_model_filter_increment_stamp (filter);
 
-      if (!parent_elt || orig_level_ext_ref_count > 0)
-        gtk_tree_model_row_deleted (GTK_TREE_MODEL (data), path);
+      if (!toggled_elt || orig_level_ext_ref_count > 0)
+        {
+          *path = f_path;
+          f_path = NULL;
+        }
+    }
+
+  if (toggled_level)
+    {
+      *parent_level = toggled_level;
+      *parent_elt = toggled_elt;
     }
 
-  if (emit_child_toggled && parent_level)
+  if (f_path)
+    gtk_tree_path_free (f_path);
+
+  return TRUE;
+}
+
+/* Announces the deletion of @n_rows rows at @path, if any, and of the
+ * last visible child of @parent_elt, once the rows deleted at @c_path
+ * in the child model have been removed from the cache.
+ */
+static void
+gtk_tree_model_filter_finish_row_deleted (GtkTreeModelFilter *filter,
+                                          GtkTreePath        *c_path,
+                                          GtkTreePath        *path,
+                                          gint                n_rows,
+                                          FilterLevel        *parent_level,
+                                          FilterElt          *parent_elt)
+{
+  if (n_rows == 1)
+    gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), path);
+  else if (n_rows > 1)
+    gtk_tree_model_rows_deleted (GTK_TREE_MODEL (filter), path, n_rows);
+
+  if (parent_level)
     {
       GtkTreeIter iter2;
       GtkTreePath *path2;
@@ -2697,8 +2979,107 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
     }
   else
     gtk_tree_model_filter_check_ancestors (filter, c_path);
+}
 
-  gtk_tree_path_free (path);
+static void
+gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
+                                   GtkTreePath  *c_path,
+                                   gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *path;
+  FilterElt *parent_elt = NULL;
+  FilterLevel *parent_level = NULL;
+
+  g_return_if_fail (c_path != NULL);
+
+  /* Already handled by gtk_tree_model_filter_rows_deleted() */
+  if (gtk_tree_model_row_deleted_is_replay (c_model, c_path))
+    return;
+
+  /* special case the deletion of an ancestor of the virtual root */
+  if (filter->priv->virtual_root &&
+      (gtk_tree_path_is_ancestor (c_path, filter->priv->virtual_root) ||
+       !gtk_tree_path_compare (c_path, filter->priv->virtual_root)))
+    {
+      gtk_tree_model_filter_virtual_root_deleted (filter, c_path);
+      return;
+    }
+
+  if (!gtk_tree_model_filter_remove_deleted_row (filter, c_path, &path,
+                                                 &parent_level, &parent_elt))
+    return;
+
+  gtk_tree_model_filter_finish_row_deleted (filter, c_path, path, path ? 1 : 0,
+                                            parent_level, parent_elt);
+
+  if (path)
+    gtk_tree_path_free (path);
+}
+
+/* Like gtk_tree_model_filter_row_deleted() for each of the rows, but
+ * the visible ones, which were next to each other in the level, are
+ * announced with a single signal.
+ */
+static void
+gtk_tree_model_filter_rows_deleted (GtkTreeModel *c_model,
+                                    GtkTreePath  *c_path,
+                                    gint          n_rows,
+                                    gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *path = NULL;
+  GtkTreePath *row_path;
+  FilterElt *parent_elt = NULL;
+  FilterLevel *parent_level = NULL;
+  gboolean in_cache = FALSE;
+  gint n_visible = 0;
+  gint i;
+
+  g_return_if_fail (c_path != NULL);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      /* special case the deletion of an ancestor of the virtual root,
+       * which takes all of our rows with it */
+      if (filter->priv->virtual_root &&
+          (gtk_tree_path_is_ancestor (c_path, filter->priv->virtual_root) ||
+           !gtk_tree_path_compare (c_path, filter->priv->virtual_root)))
+        {
+          if (in_cache)
+            gtk_tree_model_filter_finish_row_deleted (filter, c_path, path, n_visible,
+                                                      parent_level, parent_elt);
+          g_clear_pointer (&path, gtk_tree_path_free);
+
+          gtk_tree_model_filter_virtual_root_deleted (filter, c_path);
+          return;
+        }
+
+      /* Each row is at @c_path once the previous ones are gone, and
+       * the visible ones end up at the same place in the filter model */
+      if (!gtk_tree_model_filter_remove_deleted_row (filter, c_path, &row_path,
+                                                     &parent_level, &parent_elt))
+        continue;
+
+      in_cache = TRUE;
+
+      if (row_path)
+        {
+          if (path)
+            gtk_tree_path_free (row_path);
+          else
+            path = row_path;
+
+          n_visible++;
+        }
+    }
+
+  if (in_cache)
+    gtk_tree_model_filter_finish_row_deleted (filter, c_path, path, n_visible,
+                                              parent_level, parent_elt);
+
+  if (path)
+    gtk_tree_path_free (path);
 }
 
 static void
@@ -3639,10 +4020,14 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
                                    filter->priv->changed_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->inserted_id);
+      g_signal_handler_disconnect (filter->priv->child_model,
+                                   filter->priv->rows_inserted_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->has_child_toggled_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->deleted_id);
+      g_signal_handler_disconnect (filter->priv->child_model,
+                                   filter->priv->rows_deleted_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->reordered_id);
 
@@ -3671,6 +4056,10 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
         g_signal_connect (child_model, "row-inserted",
                           G_CALLBACK (gtk_tree_model_filter_row_inserted),
                           filter);
+      filter->priv->rows_inserted_id =
+        g_signal_connect (child_model, "rows-inserted",
+                          G_CALLBACK (gtk_tree_model_filter_rows_inserted),
+                          filter);
       filter->priv->has_child_toggled_id =
         g_signal_connect (child_model, "row-has-child-toggled",
                           G_CALLBACK (gtk_tree_model_filter_row_has_child_toggled),
@@ -3679,6 +4068,10 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
         g_signal_connect (child_model, "row-deleted",
                           G_CALLBACK (gtk_tree_model_filter_row_deleted),
                           filter);
+      filter->priv->rows_deleted_id =
+        g_signal_connect (child_model, "rows-deleted",
+                          G_CALLBACK (gtk_tree_model_filter_rows_deleted),
+                          filter);
       filter->priv->reordered_id =
         g_signal_connect (child_model, "rows-reordered",
                           G_CALLBACK (gtk_tree_model_filter_rows_reordered),
@@ -3858,6 +4251,47 @@ gtk_tree_model_filter_set_visible_func (GtkTreeModelFilter            *filter,
   filter->priv->visible_method_set = TRUE;
 }
 
+/**
+ * gtk_tree_model_filter_set_threaded_visible_func:
+ * @filter: A #GtkTreeModelFilter
+ * @func: A #GtkTreeModelFilterVisibleFunc, the visible function
+ * @data: (allow-none): User data to pass to the visible function, or %NULL
+ * @destroy: (allow-none): Destroy notifier of @data, or %NULL
+ *
+ * Like gtk_tree_model_filter_set_visible_func(), but promises that @func
+ * can be called from several threads at the same time. This allows
+ * gtk_tree_model_filter_refilter() to evaluate the visible function
+ * for many rows in parallel, when the child model is a list.
+ *
+ * While refiltering, @func is called from worker threads, while the
+ * main thread waits for it. Besides being careful with @data, @func
+ * must therefore only read from the child model in ways that are
+ * safe from several threads at once. Reading values from a
+ * #GtkListStore or a #GtkColumnStore is safe, reading from models
+ * that build caches on access, like #GtkTreeModelSort, is not.
+ *
+ * Note that gtk_tree_model_filter_set_visible_func(),
+ * gtk_tree_model_filter_set_threaded_visible_func() or
+ * gtk_tree_model_filter_set_visible_column() can only be called
+ * once for a given filter model.
+ *
+ * Since: 3.92
+ */
+void
+gtk_tree_model_filter_set_threaded_visible_func (GtkTreeModelFilter            *filter,
+                                                 GtkTreeModelFilterVisibleFunc  func,
+                                                 gpointer                       data,
+                                                 GDestroyNotify                 destroy)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+  g_return_if_fail (func != NULL);
+  g_return_if_fail (filter->priv->visible_method_set == FALSE);
+
+  gtk_tree_model_filter_set_visible_func (filter, func, data, destroy);
+
+  filter->priv->visible_func_threaded = TRUE;
+}
+
 /**
  * gtk_tree_model_filter_set_modify_func:
  * @filter: A #GtkTreeModelFilter.
@@ -4246,6 +4680,188 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
   return FALSE;
 }
 
+typedef struct
+{
+  GtkTreeModelFilter *filter;
+  GtkTreeIter *c_iters;
+  guint8 *visible;
+} RefilterJob;
+
+/* Runs on worker threads, so it must not touch the filter's levels */
+static void
+gtk_tree_model_filter_refilter_chunk (guint    start,
+                                      guint    end,
+                                      gpointer user_data)
+{
+  RefilterJob *job = user_data;
+  GtkTreeModelFilterPrivate *priv = job->filter->priv;
+  guint i;
+
+  for (i = start; i < end; i++)
+    job->visible[i] = priv->visible_func (priv->child_model,
+                                          &job->c_iters[i],
+                                          priv->visible_data) ? TRUE : FALSE;
+}
+
+static void
+gtk_tree_model_filter_emit_rows_inserted (GtkTreeModelFilter *filter,
+                                          FilterLevel        *level,
+                                          FilterElt          *first,
+                                          gint                n_rows)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  gtk_tree_model_filter_increment_stamp (filter);
+
+  iter.stamp = filter->priv->stamp;
+  iter.user_data = level;
+  iter.user_data2 = first;
+
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (filter), path, &iter, n_rows);
+  gtk_tree_path_free (path);
+}
+
+static void
+gtk_tree_model_filter_emit_rows_deleted (GtkTreeModelFilter *filter,
+                                         gint                position,
+                                         gint                n_rows)
+{
+  GtkTreePath *path;
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_rows_deleted (GTK_TREE_MODEL (filter), path, n_rows);
+  gtk_tree_path_free (path);
+}
+
+/* Refilters a list with a thread-safe visible function. The visible
+ * function is evaluated for all rows in parallel first, then the
+ * result is compared with the root level: rows that got hidden and
+ * rows that became visible are announced together whenever they are
+ * next to each other. Rows that keep their visibility don't cause
+ * any signals.
+ *
+ * Returns %FALSE if the filter has to be refiltered row by row.
+ */
+static gboolean
+gtk_tree_model_filter_refilter_parallel (GtkTreeModelFilter *filter)
+{
+  GtkTreeModelFilterPrivate *priv = filter->priv;
+  GtkTreeModel *c_model = priv->child_model;
+  GSequenceIter *siter, *prev;
+  FilterLevel *level;
+  FilterElt *elt, *first = NULL;
+  RefilterJob job;
+  gint i, n, index, position = 0, n_run = 0;
+
+  if (!priv->visible_func_threaded ||
+      priv->virtual_root ||
+      GTK_TREE_MODEL_FILTER_GET_CLASS (filter)->visible != gtk_tree_model_filter_real_visible ||
+      !(gtk_tree_model_get_flags (c_model) & GTK_TREE_MODEL_LIST_ONLY))
+    return FALSE;
+
+  if (!priv->root)
+    {
+      /* Nothing was exposed yet; building the level announces the
+       * visible rows */
+      gtk_tree_model_filter_build_level (filter, NULL, NULL, TRUE);
+      return TRUE;
+    }
+
+  level = FILTER_LEVEL (priv->root);
+  n = gtk_tree_model_iter_n_children (c_model, NULL);
+  if (n == 0)
+    return TRUE;
+
+  job.filter = filter;
+  job.c_iters = g_new (GtkTreeIter, n);
+  job.visible = g_new (guint8, n);
+
+  gtk_tree_model_get_iter_first (c_model, &job.c_iters[0]);
+  for (i = 1; i < n; i++)
+    {
+      job.c_iters[i] = job.c_iters[i - 1];
+      gtk_tree_model_iter_next (c_model, &job.c_iters[i]);
+    }
+
+  gtk_parallel_for (n, 1024, gtk_tree_model_filter_refilter_chunk, &job);
+
+  /* Hide rows from the end, so the paths of the remaining rows
+   * don't change while we go, collecting runs of visible rows that
+   * get hidden */
+  siter = g_sequence_get_end_iter (level->visible_seq);
+  prev = g_sequence_iter_is_begin (siter) ? NULL : g_sequence_iter_prev (siter);
+  while (prev)
+    {
+      siter = prev;
+      prev = g_sequence_iter_is_begin (siter) ? NULL : g_sequence_iter_prev (siter);
+
+      elt = g_sequence_get (siter);
+      if (job.visible[elt->offset])
+        {
+          if (n_run > 0)
+            gtk_tree_model_filter_emit_rows_deleted (filter, position, n_run);
+          n_run = 0;
+          continue;
+        }
+
+      position = g_sequence_iter_get_position (siter);
+      gtk_tree_model_filter_remove_elt_from_level (filter, level, elt, FALSE);
+      n_run++;
+    }
+
+  if (n_run > 0)
+    gtk_tree_model_filter_emit_rows_deleted (filter, position, n_run);
+  n_run = 0;
+
+  /* Show rows, collecting runs of rows that become visible without
+   * an already visible row between them */
+  siter = g_sequence_get_begin_iter (level->seq);
+  for (i = 0; i < n; i++)
+    {
+      elt = NULL;
+      if (!g_sequence_iter_is_end (siter))
+        {
+          elt = g_sequence_get (siter);
+          if (elt->offset == i)
+            siter = g_sequence_iter_next (siter);
+          else
+            elt = NULL;
+        }
+
+      if (!job.visible[i])
+        continue;
+
+      if (elt && elt->visible_siter)
+        {
+          if (n_run > 0)
+            gtk_tree_model_filter_emit_rows_inserted (filter, level, first, n_run);
+          n_run = 0;
+          continue;
+        }
+
+      if (!elt)
+        elt = gtk_tree_model_filter_insert_elt_in_level (filter, &job.c_iters[i],
+                                                         level, i, &index);
+
+      elt->visible_siter = g_sequence_insert_sorted (level->visible_seq, elt,
+                                                     filter_elt_cmp, NULL);
+
+      if (n_run == 0)
+        first = elt;
+      n_run++;
+    }
+
+  if (n_run > 0)
+    gtk_tree_model_filter_emit_rows_inserted (filter, level, first, n_run);
+
+  g_free (job.c_iters);
+  g_free (job.visible);
+
+  return TRUE;
+}
+
 /**
  * gtk_tree_model_filter_refilter:
  * @filter: A #GtkTreeModelFilter.
@@ -4253,6 +4869,11 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
  * Emits ::row_changed for each row in the child model, which causes
  * the filter to re-evaluate whether a row is visible or not.
  *
+ * If the visible function was set with
+ * gtk_tree_model_filter_set_threaded_visible_func() and the child
+ * model is a list, the rows are evaluated in parallel instead, and
+ * only rows that change their visibility are announced.
+ *
  * Since: 2.4
  */
 void
@@ -4260,6 +4881,9 @@ gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
+  if (gtk_tree_model_filter_refilter_parallel (filter))
+    return;
+
   /* S L O W */
   gtk_tree_model_foreach (filter->priv->child_model,
                           gtk_tree_model_filter_refilter_helper,
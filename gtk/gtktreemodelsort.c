@@ -18,6 +18,7 @@
 
 #include "config.h"
 #include <string.h>
+#include <stdlib.h>
 
 #include "gtktreemodelsort.h"
 #include "gtktreesortable.h"
@@ -276,8 +277,10 @@ struct _GtkTreeModelSortPrivate
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
+  gulong rows_inserted_id;
   gulong has_child_toggled_id;
   gulong deleted_id;
+  gulong rows_deleted_id;
   gulong reordered_id;
 };
 
@@ -327,6 +330,11 @@ static void gtk_tree_model_sort_row_inserted          (GtkTreeModel          *mo
 						       GtkTreePath           *path,
 						       GtkTreeIter           *iter,
 						       gpointer               data);
+static void gtk_tree_model_sort_rows_inserted         (GtkTreeModel          *model,
+						       GtkTreePath           *path,
+						       GtkTreeIter           *iter,
+						       gint                   n_rows,
+						       gpointer               data);
 static void gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel          *model,
 						       GtkTreePath           *path,
 						       GtkTreeIter           *iter,
@@ -334,6 +342,10 @@ static void gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel          *mo
 static void gtk_tree_model_sort_row_deleted           (GtkTreeModel          *model,
 						       GtkTreePath           *path,
 						       gpointer               data);
+static void gtk_tree_model_sort_rows_deleted          (GtkTreeModel          *model,
+						       GtkTreePath           *path,
+						       gint                   n_rows,
+						       gpointer               data);
 static void gtk_tree_model_sort_rows_reordered        (GtkTreeModel          *s_model,
 						       GtkTreePath           *s_path,
 						       GtkTreeIter           *s_iter,
@@ -903,6 +915,10 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
 
   g_return_if_fail (s_path != NULL || s_iter != NULL);
 
+  /* Already handled by gtk_tree_model_sort_rows_inserted() */
+  if (gtk_tree_model_row_inserted_is_replay (s_model, s_path))
+    return;
+
   if (!s_path)
     {
       s_path = gtk_tree_model_get_path (s_model, s_iter);
@@ -995,6 +1011,203 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
   return;
 }
 
+static gint
+compare_positions (gconstpointer a,
+                   gconstpointer b)
+{
+  gint pa = *(const gint *) a;
+  gint pb = *(const gint *) b;
+
+  return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+/* Emits the rows of @level at @positions, which must be sorted, and
+ * groups neighbouring rows into one ::rows-inserted emission */
+static void
+gtk_tree_model_sort_emit_rows_inserted (GtkTreeModelSort *tree_model_sort,
+                                        GtkTreePath      *parent_path,
+                                        gint             *positions,
+                                        gint              n_positions)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gint i, j;
+
+  for (i = 0; i < n_positions; i = j)
+    {
+      for (j = i + 1; j < n_positions; j++)
+        if (positions[j] != positions[j - 1] + 1)
+          break;
+
+      path = gtk_tree_path_copy (parent_path);
+      gtk_tree_path_append_index (path, positions[i]);
+
+      gtk_tree_model_get_iter (GTK_TREE_MODEL (tree_model_sort), &iter, path);
+      gtk_tree_model_rows_inserted (GTK_TREE_MODEL (tree_model_sort), path, &iter, j - i);
+
+      gtk_tree_path_free (path);
+    }
+}
+
+/* Inserts all @n_rows child rows into the level in one pass, instead
+ * of updating the offsets of the whole level for every row */
+static void
+gtk_tree_model_sort_rows_inserted (GtkTreeModel *s_model,
+                                   GtkTreePath  *s_path,
+                                   GtkTreeIter  *s_iter,
+                                   gint          n_rows,
+                                   gpointer      data)
+{
+  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreePath *parent_path = NULL;
+  GtkTreeIter real_s_iter;
+  GSequenceIter *siter, *end_siter;
+  SortLevel *level;
+  SortElt *elt;
+  SortData sort_data;
+  GSequenceIter **siters;
+  gint *positions;
+  gint n_positions = 0;
+  gint depth, offset;
+  gint i;
+
+  depth = gtk_tree_path_get_depth (s_path);
+  offset = gtk_tree_path_get_indices (s_path)[depth - 1];
+
+  positions = g_new (gint, n_rows);
+
+  if (!priv->root)
+    {
+      gtk_tree_model_sort_build_level (tree_model_sort, NULL, NULL);
+
+      /* the new rows are in the level already, if it is theirs */
+      if (depth > 1 || !priv->root)
+        goto done;
+
+      level = SORT_LEVEL (priv->root);
+      end_siter = g_sequence_get_end_iter (level->seq);
+      for (siter = g_sequence_get_begin_iter (level->seq);
+           siter != end_siter;
+           siter = g_sequence_iter_next (siter))
+        {
+          elt = g_sequence_get (siter);
+          if (elt->offset >= offset && elt->offset < offset + n_rows)
+            positions[n_positions++] = g_sequence_iter_get_position (siter);
+        }
+    }
+  else
+    {
+      level = SORT_LEVEL (priv->root);
+
+      /* find the parent level */
+      for (i = 0; i < depth - 1; i++)
+        {
+          if (g_sequence_get_length (level->seq) < gtk_tree_path_get_indices (s_path)[i])
+            {
+              g_warning ("%s: Nodes were inserted with a parent that's not in the tree.\n"
+                         "This possibly means that a GtkTreeModel inserted child nodes\n"
+                         "before the parent was inserted.",
+                         G_STRLOC);
+              goto done;
+            }
+
+          elt = lookup_elt_with_offset (tree_model_sort, level,
+                                        gtk_tree_path_get_indices (s_path)[i],
+                                        NULL);
+
+          g_return_if_fail (elt != NULL);
+
+          /* level not yet built, we won't cover this signal */
+          if (!elt->children)
+            goto done;
+
+          level = elt->children;
+        }
+
+      if (level->ref_count == 0 && level != priv->root)
+        {
+          gtk_tree_model_sort_free_level (tree_model_sort, level, TRUE);
+          goto done;
+        }
+
+      /* update all larger offsets once */
+      end_siter = g_sequence_get_end_iter (level->seq);
+      for (siter = g_sequence_get_begin_iter (level->seq);
+           siter != end_siter;
+           siter = g_sequence_iter_next (siter))
+        {
+          elt = g_sequence_get (siter);
+          if (elt->offset >= offset)
+            elt->offset += n_rows;
+        }
+
+      fill_sort_data (&sort_data, tree_model_sort, level);
+
+      siters = g_new (GSequenceIter *, n_rows);
+      real_s_iter = *s_iter;
+      for (i = 0; i < n_rows; i++)
+        {
+          if (i > 0 && !gtk_tree_model_iter_next (s_model, &real_s_iter))
+            break;
+
+          elt = sort_elt_new ();
+          if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+            elt->iter = real_s_iter;
+          elt->offset = offset + i;
+          elt->zero_ref_count = 0;
+          elt->ref_count = 0;
+          elt->children = NULL;
+
+          if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
+              priv->default_sort_func == NO_SORT_FUNC)
+            elt->siter = g_sequence_insert_sorted (level->seq, elt,
+                                                   gtk_tree_model_sort_offset_compare_func,
+                                                   &sort_data);
+          else
+            elt->siter = g_sequence_insert_sorted (level->seq, elt,
+                                                   gtk_tree_model_sort_compare_func,
+                                                   &sort_data);
+
+          siters[n_positions++] = elt->siter;
+        }
+
+      free_sort_data (&sort_data);
+
+      /* the positions are only known once all rows are in */
+      for (i = 0; i < n_positions; i++)
+        positions[i] = g_sequence_iter_get_position (siters[i]);
+      g_free (siters);
+    }
+
+  if (depth > 1)
+    {
+      GtkTreePath *s_parent_path = gtk_tree_path_copy (s_path);
+
+      gtk_tree_path_up (s_parent_path);
+      parent_path = gtk_real_tree_model_sort_convert_child_path_to_path (tree_model_sort,
+                                                                          s_parent_path,
+                                                                          FALSE);
+      gtk_tree_path_free (s_parent_path);
+
+      if (!parent_path)
+        goto done;
+    }
+  else
+    parent_path = gtk_tree_path_new ();
+
+  gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
+  qsort (positions, n_positions, sizeof (gint), compare_positions);
+  gtk_tree_model_sort_emit_rows_inserted (tree_model_sort, parent_path,
+                                          positions, n_positions);
+
+  gtk_tree_path_free (parent_path);
+
+ done:
+  g_free (positions);
+}
+
 static void
 gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel *s_model,
 					   GtkTreePath  *s_path,
@@ -1031,6 +1244,10 @@ gtk_tree_model_sort_row_deleted (GtkTreeModel *s_model,
 
   g_return_if_fail (s_path != NULL);
 
+  /* Already handled by gtk_tree_model_sort_rows_deleted() */
+  if (gtk_tree_model_row_deleted_is_replay (s_model, s_path))
+    return;
+
   path = gtk_real_tree_model_sort_convert_child_path_to_path (tree_model_sort, s_path, FALSE);
   if (path == NULL)
     return;
@@ -1085,6 +1302,142 @@ gtk_tree_model_sort_row_deleted (GtkTreeModel *s_model,
   gtk_tree_path_free (path);
 }
 
+/* Emits the deletion of the rows that were at @positions, which must
+ * be sorted, and groups neighbouring rows into one ::rows-deleted
+ * emission.  The last rows go first, so the earlier positions stay
+ * valid.
+ */
+static void
+gtk_tree_model_sort_emit_rows_deleted (GtkTreeModelSort *tree_model_sort,
+                                       GtkTreePath      *parent_path,
+                                       gint             *positions,
+                                       gint              n_positions)
+{
+  GtkTreePath *path;
+  gint i, j;
+
+  for (j = n_positions; j > 0; j = i)
+    {
+      for (i = j - 1; i > 0; i--)
+        if (positions[i - 1] != positions[i] - 1)
+          break;
+
+      path = gtk_tree_path_copy (parent_path);
+      gtk_tree_path_append_index (path, positions[i]);
+
+      gtk_tree_model_rows_deleted (GTK_TREE_MODEL (tree_model_sort), path, j - i);
+
+      gtk_tree_path_free (path);
+    }
+}
+
+/* Removes all @n_rows child rows from the level in one pass, instead
+ * of updating the offsets of the whole level for every row */
+static void
+gtk_tree_model_sort_rows_deleted (GtkTreeModel *s_model,
+                                  GtkTreePath  *s_path,
+                                  gint          n_rows,
+                                  gpointer      data)
+{
+  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreePath *path;
+  GSequenceIter *siter, *end_siter;
+  SortLevel *level;
+  SortElt *elt;
+  SortElt **elts;
+  GtkTreeIter iter;
+  gint *positions;
+  gint n_positions = 0;
+  gint offset;
+  gint i;
+
+  g_return_if_fail (s_path != NULL);
+
+  path = gtk_real_tree_model_sort_convert_child_path_to_path (tree_model_sort, s_path, FALSE);
+  if (path == NULL)
+    return;
+
+  gtk_tree_model_get_iter (GTK_TREE_MODEL (data), &iter, path);
+  gtk_tree_path_up (path);
+
+  level = SORT_LEVEL (iter.user_data);
+  offset = SORT_ELT (iter.user_data2)->offset;
+
+  /* The sequence is not ordered on offset, so we traverse the entire
+   * sequence to find the deleted rows.
+   */
+  elts = g_new (SortElt *, n_rows);
+  positions = g_new (gint, n_rows);
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter && n_positions < n_rows;
+       siter = g_sequence_iter_next (siter))
+    {
+      elt = g_sequence_get (siter);
+      if (elt->offset >= offset && elt->offset < offset + n_rows)
+        {
+          elts[n_positions] = elt;
+          positions[n_positions] = g_sequence_iter_get_position (siter);
+          n_positions++;
+        }
+    }
+
+  for (i = 0; i < n_positions; i++)
+    {
+      elt = elts[i];
+
+      iter.stamp = priv->stamp;
+      iter.user_data = level;
+      iter.user_data2 = elt;
+
+      while (elt->ref_count > 0)
+        gtk_tree_model_sort_real_unref_node (GTK_TREE_MODEL (data), &iter, FALSE);
+
+      /* See gtk_tree_model_sort_row_deleted() */
+      if (elt->children)
+        gtk_tree_model_sort_free_level (tree_model_sort,
+                                        elt->children, FALSE);
+
+      if (level->ref_count == 0 && g_sequence_get_length (level->seq) == 1)
+        {
+          if (level == priv->root)
+            {
+              gtk_tree_model_sort_free_level (tree_model_sort, priv->root, TRUE);
+              priv->root = NULL;
+            }
+          level = NULL;
+          break;
+        }
+
+      g_sequence_remove (elt->siter);
+    }
+
+  /* update all larger offsets once */
+  if (level)
+    {
+      end_siter = g_sequence_get_end_iter (level->seq);
+      for (siter = g_sequence_get_begin_iter (level->seq);
+           siter != end_siter;
+           siter = g_sequence_iter_next (siter))
+        {
+          elt = g_sequence_get (siter);
+          if (elt->offset >= offset + n_rows)
+            elt->offset -= n_rows;
+        }
+    }
+
+  gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
+  qsort (positions, n_positions, sizeof (gint), compare_positions);
+  gtk_tree_model_sort_emit_rows_deleted (tree_model_sort, path,
+                                         positions, n_positions);
+
+  gtk_tree_path_free (path);
+  g_free (positions);
+  g_free (elts);
+}
+
 static void
 gtk_tree_model_sort_rows_reordered (GtkTreeModel *s_model,
 				    GtkTreePath  *s_path,
@@ -1892,6 +2245,71 @@ gtk_tree_model_sort_offset_compare_func (gconstpointer a,
   return retval;
 }
 
+/* Sorts @level by extracting the sort column of every row once, when
+ * the column is sorted with the default compare function. Returns
+ * %FALSE if that isn't the case. */
+static gboolean
+gtk_tree_model_sort_sort_level_by_keys (GtkTreeModelSort *tree_model_sort,
+                                        SortLevel        *level,
+                                        SortData         *data)
+{
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreeDataSortKeys *keys;
+  GSequenceIter **siters, *siter, *end_siter;
+  GValue value = G_VALUE_INIT;
+  GtkTreeIter child_iter;
+  gint column, n_rows, i;
+  gint *order;
+  GType type;
+
+  if (data->sort_func != _gtk_tree_data_list_compare_func)
+    return FALSE;
+
+  column = GPOINTER_TO_INT (data->sort_data);
+  type = gtk_tree_model_get_column_type (priv->child_model, column);
+  if (!_gtk_tree_data_sort_keys_supported (type))
+    return FALSE;
+
+  n_rows = g_sequence_get_length (level->seq);
+  keys = _gtk_tree_data_sort_keys_new (type, n_rows);
+  siters = g_new (GSequenceIter *, n_rows);
+
+  i = 0;
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      SortElt *elt = g_sequence_get (siter);
+
+      if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+        child_iter = elt->iter;
+      else
+        {
+          data->parent_path_indices [data->parent_path_depth-1] = elt->offset;
+          gtk_tree_model_get_iter (priv->child_model, &child_iter, data->parent_path);
+        }
+
+      gtk_tree_model_get_value (priv->child_model, &child_iter, column, &value);
+      _gtk_tree_data_sort_keys_set_value (keys, i, &value);
+      g_value_unset (&value);
+
+      siters[i++] = siter;
+    }
+
+  order = _gtk_tree_data_sort_keys_sort (keys, priv->order);
+
+  /* Moving every row to the end in the new order sorts the sequence
+   * without comparing anything */
+  for (i = 0; i < n_rows; i++)
+    g_sequence_move (siters[order[i]], end_siter);
+
+  g_free (order);
+  g_free (siters);
+
+  return TRUE;
+}
+
 static void
 gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
 				SortLevel        *level,
@@ -1940,7 +2358,7 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
   if (data.sort_func == NO_SORT_FUNC)
     g_sequence_sort (level->seq, gtk_tree_model_sort_offset_compare_func,
                      &data);
-  else
+  else if (!gtk_tree_model_sort_sort_level_by_keys (tree_model_sort, level, &data))
     g_sequence_sort (level->seq, gtk_tree_model_sort_compare_func, &data);
 
   free_sort_data (&data);
@@ -2142,10 +2560,14 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
                                    priv->changed_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->inserted_id);
+      g_signal_handler_disconnect (priv->child_model,
+                                   priv->rows_inserted_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->has_child_toggled_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->deleted_id);
+      g_signal_handler_disconnect (priv->child_model,
+                                   priv->rows_deleted_id);
       g_signal_handler_disconnect (priv->child_model,
 				   priv->reordered_id);
 
@@ -2173,6 +2595,10 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
         g_signal_connect (child_model, "row-inserted",
                           G_CALLBACK (gtk_tree_model_sort_row_inserted),
                           tree_model_sort);
+      priv->rows_inserted_id =
+        g_signal_connect (child_model, "rows-inserted",
+                          G_CALLBACK (gtk_tree_model_sort_rows_inserted),
+                          tree_model_sort);
       priv->has_child_toggled_id =
         g_signal_connect (child_model, "row-has-child-toggled",
                           G_CALLBACK (gtk_tree_model_sort_row_has_child_toggled),
@@ -2181,6 +2607,10 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
         g_signal_connect (child_model, "row-deleted",
                           G_CALLBACK (gtk_tree_model_sort_row_deleted),
                           tree_model_sort);
+      priv->rows_deleted_id =
+        g_signal_connect (child_model, "rows-deleted",
+                          G_CALLBACK (gtk_tree_model_sort_rows_deleted),
+                          tree_model_sort);
       priv->reordered_id =
 	g_signal_connect (child_model, "rows-reordered",
 			  G_CALLBACK (gtk_tree_model_sort_rows_reordered),
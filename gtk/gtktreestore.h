@@ -127,6 +127,14 @@ void          gtk_tree_store_insert_with_valuesv (GtkTreeStore *tree_store,
 						  gint         *columns,
 						  GValue       *values,
 						  gint          n_values);
+GDK_AVAILABLE_IN_3_92
+void          gtk_tree_store_insert_rows      (GtkTreeStore *tree_store,
+                                               GtkTreeIter  *parent,
+                                               gint          position,
+                                               gint          n_rows,
+                                               gint         *columns,
+                                               GValue       *values,
+                                               gint          n_values);
 GDK_AVAILABLE_IN_ALL
 void          gtk_tree_store_prepend          (GtkTreeStore *tree_store,
 					       GtkTreeIter  *iter,
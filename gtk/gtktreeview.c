@@ -685,6 +685,11 @@ static void gtk_tree_view_row_inserted                    (GtkTreeModel    *mode
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
 							   gpointer         data);
+static void gtk_tree_view_rows_inserted                   (GtkTreeModel    *model,
+							   GtkTreePath     *path,
+							   GtkTreeIter     *iter,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_row_has_child_toggled           (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
@@ -692,6 +697,10 @@ static void gtk_tree_view_row_has_child_toggled           (GtkTreeModel    *mode
 static void gtk_tree_view_row_deleted                     (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   gpointer         data);
+static void gtk_tree_view_rows_deleted                    (GtkTreeModel    *model,
+							   GtkTreePath     *path,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_rows_reordered                  (GtkTreeModel    *model,
 							   GtkTreePath     *parent,
 							   GtkTreeIter     *iter,
@@ -8673,6 +8682,10 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
 
   g_return_if_fail (path != NULL || iter != NULL);
 
+  /* Already added by gtk_tree_view_rows_inserted() */
+  if (gtk_tree_model_row_inserted_is_replay (model, path))
+    return;
+
   if (tree_view->priv->fixed_height_mode
       && tree_view->priv->fixed_height >= 0)
     height = tree_view->priv->fixed_height;
@@ -8769,6 +8782,113 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
     gtk_tree_path_free (path);
 }
 
+/* Adds @n_rows consecutive nodes to the rbtree at once, instead of
+ * finding the parent tree and the position again for every row */
+static void
+gtk_tree_view_rows_inserted (GtkTreeModel *model,
+                             GtkTreePath  *path,
+                             GtkTreeIter  *iter,
+                             gint          n_rows,
+                             gpointer      data)
+{
+  GtkTreeView *tree_view = (GtkTreeView *) data;
+  GtkTreeIter child_iter;
+  gint *indices;
+  GtkRBTree *tree;
+  GtkRBNode *tmpnode = NULL;
+  gboolean nodes_visible = FALSE;
+  gint depth;
+  gint i;
+  gint height;
+
+  if (tree_view->priv->fixed_height_mode
+      && tree_view->priv->fixed_height >= 0)
+    height = tree_view->priv->fixed_height;
+  else
+    height = 0;
+
+  if (tree_view->priv->tree == NULL)
+    tree_view->priv->tree = _gtk_rbtree_new ();
+
+  tree = tree_view->priv->tree;
+
+  /* Update all row-references */
+  for (i = 0; i < n_rows; i++)
+    gtk_tree_row_reference_inserted (G_OBJECT (data), path);
+
+  depth = gtk_tree_path_get_depth (path);
+  indices = gtk_tree_path_get_indices (path);
+
+  /* First, find the parent tree */
+  for (i = 0; i < depth - 1; i++)
+    {
+      if (tree == NULL)
+        goto done;
+
+      tmpnode = _gtk_rbtree_find_count (tree, indices[i] + 1);
+      if (tmpnode == NULL)
+        {
+          g_warning ("Nodes were inserted with a parent that's not in the tree.\n" \
+                     "This possibly means that a GtkTreeModel inserted child nodes\n" \
+                     "before the parent was inserted.");
+          goto done;
+        }
+      else if (!GTK_RBNODE_FLAG_SET (tmpnode, GTK_RBNODE_IS_PARENT))
+        {
+          /* See gtk_tree_view_row_inserted() */
+          GtkTreePath *tmppath = _gtk_tree_path_new_from_rbtree (tree, tmpnode);
+          gtk_tree_view_row_has_child_toggled (model, tmppath, NULL, data);
+          gtk_tree_path_free (tmppath);
+          tree = NULL;
+          goto done;
+        }
+
+      tree = tmpnode->children;
+    }
+
+  if (tree == NULL)
+    goto done;
+
+  if (indices[depth - 1] == 0)
+    tmpnode = NULL;
+  else
+    tmpnode = _gtk_rbtree_find_count (tree, indices[depth - 1]);
+
+  child_iter = *iter;
+  for (i = 0; i < n_rows; i++)
+    {
+      if (i > 0 && !gtk_tree_model_iter_next (model, &child_iter))
+        break;
+
+      gtk_tree_model_ref_node (tree_view->priv->model, &child_iter);
+
+      if (tmpnode == NULL)
+        tmpnode = _gtk_rbtree_insert_before (tree, _gtk_rbtree_find_count (tree, 1), height, FALSE);
+      else
+        tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, height, FALSE);
+
+      _gtk_tree_view_accessible_add (tree_view, tree, tmpnode);
+
+      if (height > 0)
+        {
+          _gtk_rbtree_node_mark_valid (tree, tmpnode);
+          if (!nodes_visible)
+            nodes_visible = node_is_visible (tree_view, tree, tmpnode);
+        }
+    }
+
+ done:
+  if (height > 0)
+    {
+      if (nodes_visible)
+        gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+      else
+        gtk_widget_queue_resize_no_redraw (GTK_WIDGET (tree_view));
+    }
+  else
+    install_presize_handler (tree_view);
+}
+
 static void
 gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
 				     GtkTreePath  *path,
@@ -8876,6 +8996,10 @@ gtk_tree_view_row_deleted (GtkTreeModel *model,
 
   g_return_if_fail (path != NULL);
 
+  /* Already removed by gtk_tree_view_rows_deleted() */
+  if (gtk_tree_model_row_deleted_is_replay (model, path))
+    return;
+
   gtk_tree_row_reference_deleted (G_OBJECT (data), path);
 
   if (_gtk_tree_view_find_node (tree_view, path, &tree, &node))
@@ -8988,6 +9112,148 @@ gtk_tree_view_row_deleted (GtkTreeModel *model,
     g_signal_emit_by_name (tree_view->priv->selection, "changed");
 }
 
+/* Removes @n_rows consecutive nodes from the rbtree at once, so the
+ * columns, the cursor and the selection are only updated once */
+static void
+gtk_tree_view_rows_deleted (GtkTreeModel *model,
+                            GtkTreePath  *path,
+                            gint          n_rows,
+                            gpointer      data)
+{
+  GtkTreeView *tree_view = (GtkTreeView *)data;
+  GtkRBTree *tree;
+  GtkRBNode *node, *first, *last, *next;
+  GList *list;
+  gboolean selection_changed = FALSE, cursor_changed = FALSE;
+  GtkRBTree *cursor_tree = NULL;
+  GtkRBNode *cursor_node = NULL;
+  gint i;
+
+  g_return_if_fail (path != NULL);
+
+  for (i = 0; i < n_rows; i++)
+    gtk_tree_row_reference_deleted (G_OBJECT (data), path);
+
+  if (_gtk_tree_view_find_node (tree_view, path, &tree, &first))
+    return;
+
+  if (tree == NULL)
+    return;
+
+  /* check if the selection or the cursor row are going away */
+  last = first;
+  for (node = first, i = 0; node != NULL && i < n_rows; node = _gtk_rbtree_next (tree, node), i++)
+    {
+      if (!selection_changed)
+        check_selection_helper (tree, node, &selection_changed);
+
+      if (tree_view->priv->cursor_node &&
+          (tree_view->priv->cursor_node == node ||
+           (node->children && (tree_view->priv->cursor_tree == node->children ||
+                               _gtk_rbtree_contains (node->children, tree_view->priv->cursor_tree)))))
+        cursor_changed = TRUE;
+
+      last = node;
+    }
+  n_rows = i;
+
+  for (list = tree_view->priv->columns; list; list = list->next)
+    if (gtk_tree_view_column_get_visible (GTK_TREE_VIEW_COLUMN (list->data)) &&
+	gtk_tree_view_column_get_sizing (GTK_TREE_VIEW_COLUMN (list->data)) == GTK_TREE_VIEW_COLUMN_AUTOSIZE)
+      _gtk_tree_view_column_cell_set_dirty ((GtkTreeViewColumn *)list->data, TRUE);
+
+  /* Ensure we don't have a dangling pointer to a dead node */
+  ensure_unprelighted (tree_view);
+
+  /* Cancel editting if we've started */
+  gtk_tree_view_stop_editing (tree_view, TRUE);
+
+  /* If the cursor row got deleted, move the cursor to the row after
+   * the deleted ones, like gtk_tree_view_row_deleted() does */
+  if (cursor_changed)
+    {
+      GtkTreePath *cursor_path;
+
+      cursor_tree = tree;
+      cursor_node = _gtk_rbtree_next (tree, last);
+      while (cursor_node == NULL && cursor_tree->parent_tree)
+        {
+          cursor_node = _gtk_rbtree_next (cursor_tree->parent_tree,
+                                          cursor_tree->parent_node);
+          cursor_tree = cursor_tree->parent_tree;
+        }
+
+      if (cursor_node != NULL)
+        cursor_path = _gtk_tree_path_new_from_rbtree (cursor_tree, cursor_node);
+      else
+        cursor_path = NULL;
+
+      if (cursor_path == NULL ||
+          ! search_first_focusable_path (tree_view, &cursor_path, TRUE,
+                                         &cursor_tree, &cursor_node))
+        {
+          _gtk_rbtree_prev_full (tree, first, &cursor_tree, &cursor_node);
+          if (cursor_node)
+            {
+              cursor_path = _gtk_tree_path_new_from_rbtree (cursor_tree, cursor_node);
+              if (! search_first_focusable_path (tree_view, &cursor_path, FALSE,
+                                                 &cursor_tree, &cursor_node))
+                cursor_node = NULL;
+              gtk_tree_path_free (cursor_path);
+            }
+        }
+      else if (cursor_path)
+        gtk_tree_path_free (cursor_path);
+    }
+
+  if (tree->root->count == n_rows)
+    {
+      if (tree_view->priv->tree == tree)
+	tree_view->priv->tree = NULL;
+
+      _gtk_tree_view_accessible_remove_state (tree_view,
+                                              tree->parent_tree, tree->parent_node,
+                                              GTK_CELL_RENDERER_EXPANDED);
+      _gtk_tree_view_accessible_remove (tree_view, tree, NULL);
+      _gtk_rbtree_remove (tree);
+    }
+  else
+    {
+      /* Removing a node doesn't move the others, so the next one
+       * can be looked up before */
+      for (node = first, i = 0; i < n_rows; node = next, i++)
+        {
+          next = _gtk_rbtree_next (tree, node);
+          _gtk_tree_view_accessible_remove (tree_view, tree, node);
+          _gtk_rbtree_remove_node (tree, node);
+        }
+    }
+
+  if (! gtk_tree_row_reference_valid (tree_view->priv->top_row))
+    {
+      gtk_tree_row_reference_free (tree_view->priv->top_row);
+      tree_view->priv->top_row = NULL;
+    }
+
+  install_scroll_sync_handler (tree_view);
+
+  gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+
+  if (cursor_changed)
+    {
+      if (cursor_node)
+        {
+          GtkTreePath *cursor_path = _gtk_tree_path_new_from_rbtree (cursor_tree, cursor_node);
+          gtk_tree_view_real_set_cursor (tree_view, cursor_path, CLEAR_AND_SELECT | CURSOR_INVALID);
+          gtk_tree_path_free (cursor_path);
+        }
+      else
+        gtk_tree_view_real_set_cursor (tree_view, NULL, CLEAR_AND_SELECT | CURSOR_INVALID);
+    }
+  if (selection_changed)
+    g_signal_emit_by_name (tree_view->priv->selection, "changed");
+}
+
 static void
 gtk_tree_view_rows_reordered (GtkTreeModel *model,
 			      GtkTreePath  *parent,
@@ -11033,12 +11299,18 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_inserted,
 					    tree_view);
+      g_signal_handlers_disconnect_by_func (tree_view->priv->model,
+					    gtk_tree_view_rows_inserted,
+					    tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_has_child_toggled,
 					    tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_deleted,
 					    tree_view);
+      g_signal_handlers_disconnect_by_func (tree_view->priv->model,
+					    gtk_tree_view_rows_deleted,
+					    tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_rows_reordered,
 					    tree_view);
@@ -11101,6 +11373,10 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 			"row-inserted",
 			G_CALLBACK (gtk_tree_view_row_inserted),
 			tree_view);
+      g_signal_connect (tree_view->priv->model,
+			"rows-inserted",
+			G_CALLBACK (gtk_tree_view_rows_inserted),
+			tree_view);
       g_signal_connect (tree_view->priv->model,
 			"row-has-child-toggled",
 			G_CALLBACK (gtk_tree_view_row_has_child_toggled),
@@ -11109,6 +11385,10 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 			"row-deleted",
 			G_CALLBACK (gtk_tree_view_row_deleted),
 			tree_view);
+      g_signal_connect (tree_view->priv->model,
+			"rows-deleted",
+			G_CALLBACK (gtk_tree_view_rows_deleted),
+			tree_view);
       g_signal_connect (tree_view->priv->model,
 			"rows-reordered",
 			G_CALLBACK (gtk_tree_view_rows_reordered),
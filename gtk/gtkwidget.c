@@ -77,6 +77,8 @@
 #include "gtkcssshadowsvalueprivate.h"
 #include "gtkdebugupdatesprivate.h"
 #include "gsk/gskdebugprivate.h"
+#include "gsk/gskrendererprivate.h"
+#include "gdk/gdk-private.h"
 #include "gtkeventcontrollerlegacyprivate.h"
 
 #include "inspector/window.h"
@@ -759,6 +761,9 @@ static void gtk_widget_update_input_shape (GtkWidget *widget);
 static gboolean gtk_widget_class_get_visible_by_default (GtkWidgetClass *widget_class);
 static void gtk_widget_set_clip (GtkWidget *widget, const GtkAllocation *clip);
 
+static void gtk_widget_invalidate_render_node (GtkWidget *widget);
+static void gtk_widget_clear_render_node      (GtkWidget *widget);
+
 
 /* --- variables --- */
 static gint             GtkWidget_private_offset = 0;
@@ -782,6 +787,8 @@ static GQuark           quark_widget_path = 0;
 static GQuark           quark_action_muxer = 0;
 static GQuark           quark_font_options = 0;
 static GQuark           quark_font_map = 0;
+static GQuark           quark_node_cache_counters = 0;
+static GQuark           quark_queued_damage = 0;
 
 GParamSpecPool         *_gtk_widget_child_property_pool = NULL;
 GObjectNotifyContext   *_gtk_widget_child_property_notify_context = NULL;
@@ -999,6 +1006,8 @@ gtk_widget_class_init (GtkWidgetClass *klass)
   quark_action_muxer = g_quark_from_static_string ("gtk-widget-action-muxer");
   quark_font_options = g_quark_from_static_string ("gtk-widget-font-options");
   quark_font_map = g_quark_from_static_string ("gtk-widget-font-map");
+  quark_node_cache_counters = g_quark_from_static_string ("gtk-widget-node-cache-counters");
+  quark_queued_damage = g_quark_from_static_string ("gtk-widget-queued-damage");
 
   _gtk_widget_child_property_pool = g_param_spec_pool_new (TRUE);
   cpn_context.quark_notify_queue = g_quark_from_static_string ("GtkWidget-child-property-notify-queue");
@@ -4438,6 +4447,8 @@ gtk_widget_unmap (GtkWidget *widget)
 
       g_signal_emit (widget, widget_signals[UNMAP], 0);
 
+      gtk_widget_clear_render_node (widget);
+
       update_cursor_on_state_change (widget);
 
       gtk_widget_pop_verify_invariants (widget);
@@ -4970,6 +4981,8 @@ gtk_widget_queue_draw_area (GtkWidget *widget,
   g_return_if_fail (width >= 0);
   g_return_if_fail (height >= 0);
 
+  gtk_widget_invalidate_render_node (widget);
+
   if (width == 0 || height == 0)
     return;
 
@@ -5221,6 +5234,36 @@ get_box_padding (GtkCssStyle *style,
   border->right = get_number (style, GTK_CSS_PROPERTY_PADDING_RIGHT);
 }
 
+/* Remembers the areas of the native window that were invalidated because
+ * widgets changed. gtk_widget_render() replaces them with the area that
+ * actually differs between the render nodes of two frames.
+ */
+static void
+gtk_widget_add_queued_damage (GdkWindow            *window,
+                              const cairo_region_t *region)
+{
+  cairo_region_t *damage, *queued;
+  int x, y;
+
+  damage = cairo_region_copy (region);
+  while (!gdk_window_has_native (window))
+    {
+      gdk_window_get_position (window, &x, &y);
+      cairo_region_translate (damage, x, y);
+      window = gdk_window_get_parent (window);
+    }
+
+  queued = g_object_get_qdata (G_OBJECT (window), quark_queued_damage);
+  if (queued)
+    {
+      cairo_region_union (queued, damage);
+      cairo_region_destroy (damage);
+    }
+  else
+    g_object_set_qdata_full (G_OBJECT (window), quark_queued_damage,
+                             damage, (GDestroyNotify) cairo_region_destroy);
+}
+
 /**
  * gtk_widget_queue_draw_region:
  * @widget: a #GtkWidget
@@ -5254,6 +5297,8 @@ gtk_widget_queue_draw_region (GtkWidget            *widget,
   if (cairo_region_is_empty (region))
     return;
 
+  gtk_widget_invalidate_render_node (widget);
+
   /* Just return if the widget isn't mapped */
   if (!_gtk_widget_get_mapped (widget))
     return;
@@ -5301,6 +5346,7 @@ gtk_widget_queue_draw_region (GtkWidget            *widget,
 
 invalidate:
   gtk_debug_updates_add (parent, region2);
+  gtk_widget_add_queued_damage (_gtk_widget_get_window (widget), region2);
   gdk_window_invalidate_region (_gtk_widget_get_window (widget), region2, TRUE);
 
   cairo_region_destroy (region2);
@@ -5522,6 +5568,9 @@ gtk_widget_size_allocate (GtkWidget           *widget,
       goto check_clip;
     }
 
+  /* The contents depend on the allocation, so any retained nodes are stale */
+  gtk_widget_invalidate_render_node (widget);
+
   /* Since gtk_widget_measure does it for us, we can be sure here that
    * the given alloaction is large enough for the css margin/bordder/padding */
   real_allocation.x = 0;
@@ -10247,6 +10296,8 @@ gtk_widget_finalize (GObject *object)
 
   g_clear_object (&priv->context);
 
+  g_clear_pointer (&priv->render_node, gsk_render_node_unref);
+
   _gtk_size_request_cache_free (&priv->requests);
 
   for (l = priv->event_controllers; l; l = l->next)
@@ -13592,6 +13643,9 @@ gtk_widget_send_focus_change (GtkWidget *widget,
 
   widget->priv->has_focus = event->focus_change.in;
 
+  /* The focus outline is drawn by gtk_widget_snapshot() itself */
+  gtk_widget_queue_draw (widget);
+
   res = gtk_widget_event (widget, event);
 
   g_object_notify_by_pspec (G_OBJECT (widget), widget_props[PROP_HAS_FOCUS]);
@@ -15050,12 +15104,12 @@ gtk_widget_maybe_add_debug_render_nodes (GtkWidget             *widget,
     }
 }
 
-void
-gtk_widget_snapshot (GtkWidget   *widget,
-                     GtkSnapshot *snapshot)
+static void
+gtk_widget_do_snapshot (GtkWidget   *widget,
+                        GtkSnapshot *snapshot)
 {
   GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (widget);
-  GtkWidgetPrivate *priv;
+  GtkWidgetPrivate *priv = widget->priv;
   graphene_rect_t bounds;
   GtkCssValue *filter_value;
   RenderMode mode;
@@ -15065,26 +15119,11 @@ gtk_widget_snapshot (GtkWidget   *widget,
   GtkAllocation allocation;
   GtkBorder margin, border, padding;
 
-  if (!_gtk_widget_is_drawable (widget))
-    return;
-
-  if (_gtk_widget_get_alloc_needed (widget))
-    {
-      g_warning ("Trying to snapshot %s %p without a current allocation", G_OBJECT_TYPE_NAME (widget), widget);
-      return;
-    }
-
-  priv = widget->priv;
   offset_clip = priv->clip;
   offset_clip.x -= priv->allocation.x;
   offset_clip.y -= priv->allocation.y;
 
-  if (gtk_snapshot_clips_rect (snapshot, &offset_clip))
-    return;
-
-  opacity = widget->priv->alpha / 255.0;
-  if (opacity <= 0.0)
-    return;
+  opacity = priv->alpha / 255.0;
 
   /* Compatibility mode: if the widget does not have a render node, we draw
    * using gtk_widget_draw() on a temporary node
@@ -15185,6 +15224,184 @@ gtk_widget_snapshot (GtkWidget   *widget,
     gtk_snapshot_pop (snapshot);
 }
 
+/*
+ * gtk_widget_invalidate_render_node:
+ * @widget: a #GtkWidget
+ *
+ * Marks the render node retained by @widget as stale. The nodes
+ * of all ancestors contain the node of @widget, so they are marked
+ * stale as well. Siblings keep their nodes, and will be reused when
+ * the parent gets snapshot again.
+ */
+static void
+gtk_widget_invalidate_render_node (GtkWidget *widget)
+{
+  for (; widget != NULL; widget = widget->priv->parent)
+    widget->priv->render_node_valid = FALSE;
+}
+
+static void
+gtk_widget_clear_render_node (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+
+  g_clear_pointer (&priv->render_node, gsk_render_node_unref);
+  gtk_widget_invalidate_render_node (widget);
+}
+
+static gboolean
+gtk_widget_should_cache_render_node (GtkWidget                   *widget,
+                                     GtkSnapshot                 *snapshot,
+                                     const cairo_rectangle_int_t *offset_clip)
+{
+  GdkDisplay *display;
+
+  if (GTK_DEBUG_CHECK (NO_NODE_CACHE))
+    return FALSE;
+
+  /* Debug nodes change from frame to frame without queueing a redraw */
+  display = gtk_widget_get_display (widget);
+  if (GTK_DISPLAY_DEBUG_CHECK (display, GEOMETRY) ||
+      GTK_DISPLAY_DEBUG_CHECK (display, BASELINES) ||
+      GTK_DISPLAY_DEBUG_CHECK (display, LAYOUT) ||
+      GTK_DISPLAY_DEBUG_CHECK (display, RESIZE))
+    return FALSE;
+
+  /* If parts of the widget were culled by the clip, the resulting
+   * node is incomplete and cannot be reused for another region.
+   */
+  return gtk_snapshot_contains_rect (snapshot, offset_clip);
+}
+
+static void
+gtk_widget_append_render_node (GtkWidget   *widget,
+                               GtkSnapshot *snapshot,
+                               int          x,
+                               int          y)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+  graphene_matrix_t transform;
+  GskRenderNode *node;
+
+  if (priv->render_node == NULL)
+    return;
+
+  if (x == priv->render_node_x && y == priv->render_node_y)
+    {
+      gtk_snapshot_append_node (snapshot, priv->render_node);
+      return;
+    }
+
+  /* The widget moved since its node was recorded */
+  graphene_matrix_init_translate (&transform,
+                                  &GRAPHENE_POINT3D_INIT (x - priv->render_node_x,
+                                                          y - priv->render_node_y,
+                                                          0));
+  node = gsk_transform_node_new (priv->render_node, &transform);
+  if (snapshot->record_names)
+    gsk_render_node_set_name (node, "Moved");
+  gtk_snapshot_append_node (snapshot, node);
+  gsk_render_node_unref (node);
+}
+
+void
+gtk_widget_snapshot (GtkWidget   *widget,
+                     GtkSnapshot *snapshot)
+{
+  GtkWidgetPrivate *priv;
+  cairo_rectangle_int_t offset_clip;
+  int x, y;
+
+  if (!_gtk_widget_is_drawable (widget))
+    return;
+
+  if (_gtk_widget_get_alloc_needed (widget))
+    {
+      g_warning ("Trying to snapshot %s %p without a current allocation", G_OBJECT_TYPE_NAME (widget), widget);
+      return;
+    }
+
+  priv = widget->priv;
+  offset_clip = priv->clip;
+  offset_clip.x -= priv->allocation.x;
+  offset_clip.y -= priv->allocation.y;
+
+  if (gtk_snapshot_clips_rect (snapshot, &offset_clip))
+    return;
+
+  if (priv->alpha == 0)
+    return;
+
+  gtk_snapshot_get_offset (snapshot, &x, &y);
+
+  if (priv->render_node_valid &&
+      priv->render_node_named == !!snapshot->record_names)
+    {
+      gtk_widget_append_render_node (widget, snapshot, x, y);
+      snapshot->n_reused_nodes++;
+      return;
+    }
+
+  snapshot->n_snapshot_nodes++;
+
+  if (!gtk_widget_should_cache_render_node (widget, snapshot, &offset_clip))
+    {
+      gtk_widget_do_snapshot (widget, snapshot);
+      return;
+    }
+
+  /* Mark the node as valid before snapshotting, so that redraws
+   * queued while snapshotting invalidate it again.
+   */
+  priv->render_node_valid = TRUE;
+  priv->render_node_named = !!snapshot->record_names;
+
+  gtk_snapshot_push (snapshot, TRUE, "Cached<%s>", G_OBJECT_TYPE_NAME (widget));
+  gtk_widget_do_snapshot (widget, snapshot);
+
+  g_clear_pointer (&priv->render_node, gsk_render_node_unref);
+  priv->render_node = gtk_snapshot_pop_collect (snapshot);
+
+  /* The node outlives the frame, so it must not pin the frame's arena */
+  if (priv->render_node)
+    priv->render_node = gsk_render_node_promote (priv->render_node);
+  priv->render_node_x = x;
+  priv->render_node_y = y;
+
+  if (priv->render_node)
+    gtk_snapshot_append_node (snapshot, priv->render_node);
+}
+
+#ifdef G_ENABLE_DEBUG
+static void
+gtk_widget_update_node_cache_counters (GskRenderer       *renderer,
+                                       const GtkSnapshot *snapshot)
+{
+  GskProfiler *profiler = gsk_renderer_get_profiler (renderer);
+  guint total;
+
+  if (g_object_get_qdata (G_OBJECT (profiler), quark_node_cache_counters) == NULL)
+    {
+      gsk_profiler_add_counter (profiler, "widget-nodes-reused", "Reused widget nodes", TRUE);
+      gsk_profiler_add_counter (profiler, "widget-nodes-snapshot", "Snapshot widgets", TRUE);
+      gsk_profiler_add_counter (profiler, "widget-nodes-reuse-ratio", "Widget node reuse (%)", TRUE);
+      g_object_set_qdata (G_OBJECT (profiler), quark_node_cache_counters, GINT_TO_POINTER (TRUE));
+    }
+
+  total = snapshot->n_reused_nodes + snapshot->n_snapshot_nodes;
+
+  gsk_profiler_counter_set (profiler,
+                            g_quark_from_static_string ("widget-nodes-reused"),
+                            snapshot->n_reused_nodes);
+  gsk_profiler_counter_set (profiler,
+                            g_quark_from_static_string ("widget-nodes-snapshot"),
+                            snapshot->n_snapshot_nodes);
+  gsk_profiler_counter_set (profiler,
+                            g_quark_from_static_string ("widget-nodes-reuse-ratio"),
+                            total > 0 ? snapshot->n_reused_nodes * 100 / total : 0);
+}
+#endif
+
 static gboolean
 should_record_names (GtkWidget *widget)
 {
@@ -15201,7 +15418,7 @@ gtk_widget_render (GtkWidget            *widget,
   GtkSnapshot snapshot;
   GskRenderer *renderer;
   GskRenderNode *root;
-  cairo_region_t *clip;
+  cairo_region_t *damage, *queued;
 
   /* We only render double buffered on native windows */
   if (!gdk_window_has_native (window))
@@ -15211,23 +15428,63 @@ gtk_widget_render (GtkWidget            *widget,
   if (renderer == NULL)
     return;
 
-  context = gsk_renderer_begin_draw_frame (renderer, region);
-  clip = gdk_drawing_context_get_clip (context);
+  queued = g_object_steal_qdata (G_OBJECT (window), quark_queued_damage);
 
+  /* The whole tree is snapshot, so that the next frame can be compared
+   * against it. Unchanged widgets reuse their nodes, so this is cheap.
+   */
   gtk_snapshot_init (&snapshot,
                      renderer,
                      should_record_names (widget),
-                     clip,
+                     NULL,
                      "Render<%s>", G_OBJECT_TYPE_NAME (widget));
-  cairo_region_destroy (clip);
   gtk_widget_snapshot (widget, &snapshot);
   root = gtk_snapshot_finish (&snapshot);
+
+#ifdef G_ENABLE_DEBUG
+  gtk_widget_update_node_cache_counters (renderer, &snapshot);
+#endif
+
+  /* Areas invalidated by widgets only need to be redrawn where the
+   * render nodes changed. Everything else, like areas exposed by the
+   * window system, has to be redrawn in full.
+   */
+  damage = cairo_region_copy (region);
+  if (root != NULL && queued != NULL &&
+      !gtk_debug_updates_get_enabled_for_display (gtk_widget_get_display (widget)))
+    {
+      cairo_region_t *exposed = gdk_window_get_expose_area (window);
+      cairo_region_t *changed = cairo_region_create ();
+
+      if (exposed)
+        cairo_region_subtract (queued, exposed);
+
+      if (gsk_renderer_compute_damage (renderer, root, changed))
+        {
+          cairo_region_subtract (damage, queued);
+          cairo_region_intersect (changed, region);
+          cairo_region_union (damage, changed);
+        }
+
+      cairo_region_destroy (changed);
+    }
+  g_clear_pointer (&queued, cairo_region_destroy);
+
+  if (cairo_region_is_empty (damage))
+    {
+      cairo_region_destroy (damage);
+      g_clear_pointer (&root, gsk_render_node_unref);
+      return;
+    }
+
+  context = gsk_renderer_begin_draw_frame (renderer, damage);
+
   if (root != NULL)
     {
       gtk_inspector_record_render (widget,
                                    renderer,
                                    window,
-                                   region,
+                                   damage,
                                    context,
                                    root);
 
@@ -15235,8 +15492,9 @@ gtk_widget_render (GtkWidget            *widget,
       gsk_render_node_unref (root);
     }
 
-
   gsk_renderer_end_draw_frame (renderer, context);
+
+  cairo_region_destroy (damage);
 }
 
 /**
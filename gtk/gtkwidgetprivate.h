@@ -71,6 +71,10 @@ struct _GtkWidgetPrivate
   guint has_shape_mask        : 1;
   guint pass_through          : 1;
 
+  /* Render node caching */
+  guint render_node_valid     : 1; /* render_node is up to date with the widget's content */
+  guint render_node_named     : 1; /* render_node was recorded with node names */
+
   /* Queue-resize related flags */
   guint resize_needed         : 1; /* queue_resize() has been called but no get_preferred_size() yet */
   guint alloc_needed          : 1; /* this widget needs a size_allocate() call */
@@ -164,6 +168,14 @@ struct _GtkWidgetPrivate
 
   /* Pointer cursor */
   GdkCursor *cursor;
+
+  /* The render node produced by the last call to gtk_widget_snapshot(),
+   * and the snapshot offset it was recorded at. It is reused until
+   * the widget or one of its children queues a redraw.
+   */
+  GskRenderNode *render_node;
+  int render_node_x;
+  int render_node_y;
 };
 
 GtkCssNode *  gtk_widget_get_css_node       (GtkWidget *widget);
@@ -35,6 +35,7 @@
 #include "gtkcssstylepropertyprivate.h"
 #include "gtkcsssectionprivate.h"
 #include "gtkcssstyleprivate.h"
+#include "gtkcssnodestylecacheprivate.h"
 #include "gtkcssvalueprivate.h"
 #include "gtkcssselectorprivate.h"
 #include "gtkliststore.h"
@@ -72,6 +73,7 @@ struct _GtkInspectorCssNodeTreePrivate
   GtkListStore *prop_model;
   GtkWidget *prop_tree;
   GtkTreeViewColumn *prop_name_column;
+  GtkWidget *cache_stats;
   GHashTable *prop_iters;
   GtkCssNode *node;
 };
@@ -212,6 +214,7 @@ gtk_inspector_css_node_tree_class_init (GtkInspectorCssNodeTreeClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorCssNodeTree, prop_name_column);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorCssNodeTree, prop_model);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorCssNodeTree, prop_name_column);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorCssNodeTree, cache_stats);
 
   gtk_widget_class_bind_template_callback (widget_class, row_activated);
   gtk_widget_class_bind_template_callback (widget_class, selection_changed);
@@ -385,6 +388,29 @@ gtk_inspector_css_node_tree_set_object (GtkInspectorCssNodeTree *cnt,
   gtk_tree_path_free (path);
 }
 
+static void
+gtk_inspector_css_node_tree_update_cache_stats (GtkInspectorCssNodeTree *cnt)
+{
+  GtkCssNodeStyleCacheStats stats;
+  guint64 lookups;
+  char *text;
+
+  gtk_css_node_style_cache_get_stats (&stats);
+
+  lookups = stats.parent_hits + stats.sibling_hits + stats.sibling_misses;
+  text = g_strdup_printf (_("Style cache: %.1f%% hits, %" G_GUINT64_FORMAT " from parent, "
+                            "%" G_GUINT64_FORMAT " from siblings, %" G_GUINT64_FORMAT " computed, "
+                            "%u/%u sibling entries"),
+                          lookups ? 100.0 * (stats.parent_hits + stats.sibling_hits) / lookups : 0.0,
+                          stats.parent_hits,
+                          stats.sibling_hits,
+                          stats.sibling_misses,
+                          stats.n_sibling_entries,
+                          stats.max_sibling_entries);
+  gtk_label_set_text (GTK_LABEL (cnt->priv->cache_stats), text);
+  g_free (text);
+}
+
 static void
 gtk_inspector_css_node_tree_update_style (GtkInspectorCssNodeTree *cnt,
                                           GtkCssStyle             *new_style)
@@ -392,6 +418,8 @@ gtk_inspector_css_node_tree_update_style (GtkInspectorCssNodeTree *cnt,
   GtkInspectorCssNodeTreePrivate *priv = cnt->priv;
   gint i;
 
+  gtk_inspector_css_node_tree_update_cache_stats (cnt);
+
   for (i = 0; i < _gtk_css_style_property_get_n_properties (); i++)
     {
       GtkCssStyleProperty *prop;
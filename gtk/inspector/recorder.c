@@ -281,6 +281,61 @@ add_float_row (GtkListStore  *store,
   g_free (text);
 }
 
+static void
+add_size_row (GtkListStore *store,
+              const char   *name,
+              gsize         size)
+{
+  char *text;
+
+  text = g_format_size (size);
+  add_text_row (store, name, text);
+  g_free (text);
+}
+
+static void
+add_stats_rows (GtkListStore  *store,
+                GskRenderNode *node)
+{
+  GskRenderNodeStats stats;
+  GString *s;
+  guint i;
+
+  gsk_render_node_get_stats (node, &stats);
+
+  if (stats.n_nodes > 1)
+    {
+      char *tmp;
+
+      tmp = g_strdup_printf ("%u, %u levels deep", stats.n_nodes, stats.depth);
+      add_text_row (store, "Nodes", tmp);
+      g_free (tmp);
+
+      s = g_string_new ("");
+      for (i = 1; i < G_N_ELEMENTS (stats.count); i++)
+        {
+          char *size;
+
+          if (stats.count[i] == 0)
+            continue;
+
+          size = g_format_size (stats.bytes[i]);
+          g_string_append_printf (s, "%s%s: %u, %s",
+                                  s->len ? "\n" : "",
+                                  node_type_name (i), stats.count[i], size);
+          g_free (size);
+        }
+      add_text_row (store, "Node Types", s->str);
+      g_string_free (s, TRUE);
+    }
+
+  add_size_row (store, "Node Memory", stats.node_bytes);
+  if (stats.surface_bytes > 0)
+    add_size_row (store, "Surface Memory", stats.surface_bytes);
+  if (stats.texture_bytes > 0)
+    add_size_row (store, "Texture Memory", stats.texture_bytes);
+}
+
 static void
 populate_render_node_properties (GtkListStore  *store,
                                  GskRenderNode *node)
@@ -302,6 +357,8 @@ populate_render_node_properties (GtkListStore  *store,
   add_text_row (store, "Bounds", tmp);
   g_free (tmp);
 
+  add_stats_rows (store, node);
+
   switch (gsk_render_node_get_node_type (node))
     {
     case GSK_TEXTURE_NODE:
@@ -0,0 +1,177 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+
+#include <stdlib.h>
+
+#include "benchmark.h"
+
+struct _Benchmark
+{
+  gint64 *times;
+  int n_times;
+  gint64 start;
+};
+
+static int runs = 0;
+
+static GOptionEntry benchmark_options[] = {
+  { "runs", 'r', 0, G_OPTION_ARG_INT, &runs, "Repeat every benchmark N times", "N" },
+  { NULL }
+};
+
+/* Parses the options of a benchmark along with --runs. The integer
+ * options of the benchmarks all count things, so they must all be at
+ * least 1. */
+gboolean
+benchmark_parse_options (int                *argc,
+                         char             ***argv,
+                         const char         *parameter_string,
+                         const char         *summary,
+                         const GOptionEntry *entries,
+                         int                 default_runs)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  const GOptionEntry *entry;
+  gboolean retval = TRUE;
+
+  runs = default_runs;
+
+  context = g_option_context_new (parameter_string);
+  g_option_context_set_summary (context, summary);
+  if (entries)
+    g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_main_entries (context, benchmark_options, NULL);
+
+  if (!g_option_context_parse (context, argc, argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      g_error_free (error);
+      retval = FALSE;
+    }
+  else if (runs < 1)
+    {
+      g_printerr ("--runs must be at least 1.\n");
+      retval = FALSE;
+    }
+  else
+    {
+      for (entry = entries; entry && entry->long_name; entry++)
+        {
+          if (entry->arg == G_OPTION_ARG_INT && *(int *) entry->arg_data < 1)
+            {
+              g_printerr ("--%s must be at least 1.\n", entry->long_name);
+              retval = FALSE;
+              break;
+            }
+        }
+    }
+
+  g_option_context_free (context);
+
+  return retval;
+}
+
+int
+benchmark_get_runs (void)
+{
+  return runs;
+}
+
+static int
+compare_times (gconstpointer a,
+               gconstpointer b)
+{
+  gint64 ta = *(const gint64 *) a;
+  gint64 tb = *(const gint64 *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+/* Calls @func once for every run and returns the sorted times, in
+ * microseconds */
+Benchmark *
+benchmark_run (BenchmarkFunc func,
+               gpointer      data)
+{
+  Benchmark *benchmark;
+  int run;
+
+  benchmark = g_new0 (Benchmark, 1);
+  benchmark->times = g_new0 (gint64, runs);
+
+  for (run = 0; run < runs; run++)
+    {
+      func (benchmark, run, data);
+      benchmark->n_times++;
+    }
+
+  qsort (benchmark->times, benchmark->n_times, sizeof (gint64), compare_times);
+
+  return benchmark;
+}
+
+void
+benchmark_start (Benchmark *benchmark)
+{
+  benchmark->start = g_get_monotonic_time ();
+}
+
+void
+benchmark_stop (Benchmark *benchmark)
+{
+  benchmark->times[benchmark->n_times] += g_get_monotonic_time () - benchmark->start;
+}
+
+gint64
+benchmark_get_min (Benchmark *benchmark)
+{
+  return benchmark->times[0];
+}
+
+gint64
+benchmark_get_median (Benchmark *benchmark)
+{
+  return benchmark->times[benchmark->n_times / 2];
+}
+
+gint64
+benchmark_get_max (Benchmark *benchmark)
+{
+  return benchmark->times[benchmark->n_times - 1];
+}
+
+gint64
+benchmark_get_total (Benchmark *benchmark)
+{
+  gint64 total = 0;
+  int i;
+
+  for (i = 0; i < benchmark->n_times; i++)
+    total += benchmark->times[i];
+
+  return total;
+}
+
+void
+benchmark_free (Benchmark *benchmark)
+{
+  g_free (benchmark->times);
+  g_free (benchmark);
+}
+
+/* Returns the median time in microseconds of the runs of @func */
+gint64
+benchmark_median (BenchmarkFunc func,
+                  gpointer      data)
+{
+  Benchmark *benchmark;
+  gint64 median;
+
+  benchmark = benchmark_run (func, data);
+  median = benchmark_get_median (benchmark);
+  benchmark_free (benchmark);
+
+  return median;
+}
@@ -0,0 +1,35 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <gtk/gtk.h>
+
+typedef struct _Benchmark Benchmark;
+
+/* Called once for every run; the part between benchmark_start() and
+ * benchmark_stop() is what gets timed */
+typedef void (* BenchmarkFunc) (Benchmark *benchmark,
+                                int        run,
+                                gpointer   data);
+
+gboolean   benchmark_parse_options (int                *argc,
+                                    char             ***argv,
+                                    const char         *parameter_string,
+                                    const char         *summary,
+                                    const GOptionEntry *entries,
+                                    int                 default_runs);
+int        benchmark_get_runs      (void);
+
+Benchmark *benchmark_run           (BenchmarkFunc       func,
+                                    gpointer            data);
+void       benchmark_start         (Benchmark          *benchmark);
+void       benchmark_stop          (Benchmark          *benchmark);
+gint64     benchmark_get_min       (Benchmark          *benchmark);
+gint64     benchmark_get_median    (Benchmark          *benchmark);
+gint64     benchmark_get_max       (Benchmark          *benchmark);
+gint64     benchmark_get_total     (Benchmark          *benchmark);
+void       benchmark_free          (Benchmark          *benchmark);
+
+gint64     benchmark_median        (BenchmarkFunc       func,
+                                    gpointer            data);
+
+#endif /* __BENCHMARK_H__ */
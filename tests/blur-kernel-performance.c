@@ -0,0 +1,126 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gsk/gskcairoblurprivate.h>
+
+#include <string.h>
+
+static const char *implementations[] = { "scalar", "portable", "sse2", "avx2" };
+
+static void
+init_surface (cairo_surface_t *surface)
+{
+  guchar *data;
+  int x, y, stride, w, h;
+
+  cairo_surface_flush (surface);
+
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+  w = cairo_image_surface_get_width (surface);
+  h = cairo_image_surface_get_height (surface);
+
+  /* Something with hard edges, so all code paths see varying input */
+  for (y = 0; y < h; y++)
+    for (x = 0; x < stride; x++)
+      data[y * stride + x] = ((x / 37 + y / 23) % 3 == 0 || x > w / 2) ? 255 : (x * y) & 0xff;
+
+  cairo_surface_mark_dirty (surface);
+}
+
+static gboolean
+check_implementation (const char   *name,
+                      int           width,
+                      int           height,
+                      int           radius,
+                      GskBlurFlags  flags)
+{
+  cairo_surface_t *expected, *surface;
+  gboolean result;
+
+  expected = cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
+  init_surface (expected);
+  gsk_cairo_blur_set_implementation ("scalar");
+  gsk_cairo_blur_surface (expected, radius, flags);
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
+  init_surface (surface);
+  gsk_cairo_blur_set_implementation (name);
+  gsk_cairo_blur_surface (surface, radius, flags);
+
+  result = memcmp (cairo_image_surface_get_data (surface),
+                   cairo_image_surface_get_data (expected),
+                   cairo_image_surface_get_stride (surface) * height) == 0;
+
+  cairo_surface_destroy (surface);
+  cairo_surface_destroy (expected);
+
+  return result;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const struct {
+    const char *name;
+    GskBlurFlags flags;
+  } directions[] = {
+    { "x", GSK_BLUR_X },
+    { "y", GSK_BLUR_Y },
+    { "xy", GSK_BLUR_X | GSK_BLUR_Y }
+  };
+  cairo_surface_t *surface;
+  GTimer *timer;
+  double msec, scalar_msec[G_N_ELEMENTS (directions)][16];
+  guint i, j;
+  int radius, run;
+  int size = 2000;
+
+  timer = g_timer_new ();
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, size, size);
+
+  for (i = 0; i < G_N_ELEMENTS (implementations); i++)
+    {
+      if (!gsk_cairo_blur_set_implementation (implementations[i]))
+        {
+          g_print ("%s: not supported\n", implementations[i]);
+          continue;
+        }
+
+      /* Odd sizes to hit the edges of the vector code */
+      for (radius = 2; radius < 16; radius++)
+        {
+          if (!check_implementation (implementations[i], 67, 45, radius, GSK_BLUR_X | GSK_BLUR_Y))
+            g_print ("%s: radius %d differs from the scalar implementation\n", implementations[i], radius);
+        }
+
+      gsk_cairo_blur_set_implementation (implementations[i]);
+
+      for (j = 0; j < G_N_ELEMENTS (directions); j++)
+        {
+          for (radius = 2; radius < 16; radius++)
+            {
+              /* First run as warmup */
+              for (run = 0; run < 2; run++)
+                {
+                  init_surface (surface);
+                  g_timer_start (timer);
+                  gsk_cairo_blur_surface (surface, radius, directions[j].flags);
+                  msec = g_timer_elapsed (timer, NULL) * 1000;
+                }
+
+              if (i == 0)
+                scalar_msec[j][radius] = msec;
+
+              g_print ("%-8s %-2s radius %2d: %7.2f msec, %7.2f kpixels/msec, %5.2fx\n",
+                       implementations[i], directions[j].name, radius,
+                       msec, size * size / (msec * 1000),
+                       scalar_msec[j][radius] / msec);
+            }
+        }
+    }
+
+  cairo_surface_destroy (surface);
+  g_timer_destroy (timer);
+
+  return 0;
+}
@@ -0,0 +1,328 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+
+#define N_COLUMNS 10
+
+static int n_rows = 1000000;
+
+static GOptionEntry options[] = {
+  { "rows", 'n', 0, G_OPTION_ARG_INT, &n_rows, "Put N rows into the models", "N" },
+  { NULL }
+};
+
+static const char *words[] = {
+  "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+  "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+  "et", "dolore", "magna", "aliqua"
+};
+
+/* Three ints, three doubles, three strings and a boolean */
+static GType column_types[N_COLUMNS] = {
+  G_TYPE_INT, G_TYPE_INT, G_TYPE_INT,
+  G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_DOUBLE,
+  G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+  G_TYPE_BOOLEAN
+};
+
+enum {
+  STORE_LIST,
+  STORE_COLUMN
+};
+
+/* Resident memory in bytes, or 0 where we can't tell */
+static gsize
+get_resident_size (void)
+{
+  unsigned long size, resident;
+  gsize retval = 0;
+  FILE *file;
+
+  file = fopen ("/proc/self/statm", "r");
+  if (file == NULL)
+    return 0;
+
+  if (fscanf (file, "%lu %lu", &size, &resident) == 2)
+    retval = (gsize) resident * sysconf (_SC_PAGESIZE);
+
+  fclose (file);
+
+  return retval;
+}
+
+static GValue *
+create_values (int *columns)
+{
+  GValue *values;
+  GString *text;
+  int i, j;
+
+  values = g_new0 (GValue, N_COLUMNS * n_rows);
+  text = g_string_new (NULL);
+
+  for (i = 0; i < N_COLUMNS; i++)
+    {
+      columns[i] = i;
+
+      for (j = 0; j < n_rows; j++)
+        {
+          GValue *value = &values[i * n_rows + j];
+
+          g_value_init (value, column_types[i]);
+
+          switch (i)
+            {
+            case 0: case 1: case 2:
+              g_value_set_int (value, g_random_int_range (0, n_rows));
+              break;
+            case 3: case 4: case 5:
+              g_value_set_double (value, g_random_double ());
+              break;
+            case 6: case 7: case 8:
+              /* Few distinct strings, like in a typical table */
+              g_string_printf (text, "%s %s",
+                               words[g_random_int_range (0, G_N_ELEMENTS (words))],
+                               words[(j + i) % G_N_ELEMENTS (words)]);
+              g_value_set_string (value, text->str);
+              break;
+            default:
+              g_value_set_boolean (value, j % 2);
+              break;
+            }
+        }
+    }
+
+  g_string_free (text, TRUE);
+
+  return values;
+}
+
+static void
+free_values (GValue *values)
+{
+  int i;
+
+  for (i = 0; i < N_COLUMNS * n_rows; i++)
+    g_value_unset (&values[i]);
+  g_free (values);
+}
+
+static GtkTreeModel *
+create_model (int     type,
+              int    *columns,
+              GValue *values)
+{
+  if (type == STORE_LIST)
+    {
+      GtkListStore *store = gtk_list_store_newv (N_COLUMNS, column_types);
+
+      gtk_list_store_insert_rows (store, -1, n_rows, columns, values, N_COLUMNS);
+
+      return GTK_TREE_MODEL (store);
+    }
+  else
+    {
+      GtkColumnStore *store = gtk_column_store_newv (N_COLUMNS, column_types);
+
+      gtk_column_store_insert_rows (store, -1, n_rows, columns, values, N_COLUMNS);
+
+      return GTK_TREE_MODEL (store);
+    }
+}
+
+typedef struct {
+  int type;
+  int *columns;
+  GValue *values;
+  gsize before;
+  gsize after;
+} FillData;
+
+static void
+fill_run (Benchmark *benchmark,
+          int        run,
+          gpointer   data)
+{
+  FillData *fill = data;
+  GtkTreeModel *model;
+
+  /* Freed memory is reused by later runs, so only the first
+   * one tells how much the model needs */
+  if (run == 0)
+    fill->before = get_resident_size ();
+  benchmark_start (benchmark);
+  model = create_model (fill->type, fill->columns, fill->values);
+  benchmark_stop (benchmark);
+  if (run == 0)
+    fill->after = get_resident_size ();
+
+  g_object_unref (model);
+}
+
+static void
+benchmark_fill (int     type,
+                int    *columns,
+                GValue *values)
+{
+  FillData fill = { type, columns, values, 0, 0 };
+
+  g_print ("  fill:         %10.3f ms", benchmark_median (fill_run, &fill) / 1000.0);
+  if (fill.after > fill.before)
+    g_print ("  (%.1f MB)", (fill.after - fill.before) / (1024.0 * 1024.0));
+  g_print ("\n");
+}
+
+typedef struct {
+  GtkTreeModel *model;
+  int column;
+} SortData;
+
+static void
+sort_run (Benchmark *benchmark,
+          int        run,
+          gpointer   data)
+{
+  SortData *sort = data;
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort->model),
+                                        GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+                                        GTK_SORT_ASCENDING);
+
+  benchmark_start (benchmark);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort->model),
+                                        sort->column,
+                                        run % 2 ? GTK_SORT_DESCENDING : GTK_SORT_ASCENDING);
+  benchmark_stop (benchmark);
+}
+
+static void
+benchmark_sort (GtkTreeModel *model,
+                int           column,
+                const char   *name)
+{
+  SortData sort = { model, column };
+
+  g_print ("  sort %-8s  %10.3f ms\n", name, benchmark_median (sort_run, &sort) / 1000.0);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model),
+                                        GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+                                        GTK_SORT_ASCENDING);
+}
+
+static void
+allocate (GtkWidget *widget)
+{
+  GtkAllocation allocation = { 0, 0, 800, 600 };
+  GtkAllocation clip;
+  int min, nat;
+
+  gtk_widget_measure (widget, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat, NULL, NULL);
+  gtk_widget_measure (widget, GTK_ORIENTATION_VERTICAL, 800, &min, &nat, NULL, NULL);
+  gtk_widget_size_allocate (widget, &allocation, -1, &clip);
+}
+
+/* Jumps around a tree view and lays it out every time, which fetches
+ * the values of all visible rows */
+static void
+scroll_run (Benchmark *benchmark,
+            int        run,
+            gpointer   scrolled_window)
+{
+  GtkAdjustment *adjustment;
+  gdouble upper;
+  int i;
+
+  adjustment = gtk_scrolled_window_get_vadjustment (scrolled_window);
+  upper = gtk_adjustment_get_upper (adjustment) - gtk_adjustment_get_page_size (adjustment);
+
+  benchmark_start (benchmark);
+  for (i = 0; i < 100; i++)
+    {
+      gtk_adjustment_set_value (adjustment, g_random_double_range (0, upper));
+      allocate (scrolled_window);
+    }
+  benchmark_stop (benchmark);
+}
+
+static void
+benchmark_scroll (GtkTreeModel *model)
+{
+  GtkWidget *window, *scrolled_window, *tree_view;
+  int i;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (window), scrolled_window);
+
+  tree_view = gtk_tree_view_new_with_model (model);
+  gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (tree_view), TRUE);
+  for (i = 0; i < N_COLUMNS; i++)
+    {
+      GtkTreeViewColumn *column;
+
+      column = gtk_tree_view_column_new_with_attributes (NULL,
+                                                         i == N_COLUMNS - 1
+                                                         ? gtk_cell_renderer_toggle_new ()
+                                                         : gtk_cell_renderer_text_new (),
+                                                         i == N_COLUMNS - 1 ? "active" : "text", i,
+                                                         NULL);
+      gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+      gtk_tree_view_column_set_fixed_width (column, 80);
+      gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+    }
+  gtk_container_add (GTK_CONTAINER (scrolled_window), tree_view);
+
+  allocate (scrolled_window);
+
+  g_print ("  scroll:       %10.3f ms\n", benchmark_median (scroll_run, scrolled_window) / 1000.0);
+
+  gtk_widget_destroy (window);
+}
+
+static void
+benchmark (int     type,
+           int    *columns,
+           GValue *values)
+{
+  GtkTreeModel *model;
+
+  g_print ("%s\n", type == STORE_LIST ? "GtkListStore" : "GtkColumnStore");
+
+  benchmark_fill (type, columns, values);
+
+  model = create_model (type, columns, values);
+  benchmark_sort (model, 0, "int:");
+  benchmark_sort (model, 3, "double:");
+  benchmark_sort (model, 6, "string:");
+  benchmark_scroll (model);
+  g_object_unref (model);
+}
+
+int
+main (int argc, char **argv)
+{
+  int columns[N_COLUMNS];
+  GValue *values;
+
+  if (!benchmark_parse_options (&argc, &argv, NULL,
+                                "Compares filling, sorting and scrolling a GtkListStore and a GtkColumnStore.",
+                                options, 5))
+    return 1;
+
+  gtk_init ();
+
+  values = create_values (columns);
+
+  g_print ("%d rows, %d columns\n", n_rows, N_COLUMNS);
+  benchmark (STORE_LIST, columns, values);
+  benchmark (STORE_COLUMN, columns, values);
+
+  free_values (values);
+
+  return 0;
+}
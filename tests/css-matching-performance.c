@@ -0,0 +1,153 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+
+#include "benchmark.h"
+
+static int depth = 60;
+static int width = 4;
+static int n_rules = 200;
+
+static GOptionEntry options[] = {
+  { "depth", 'd', 0, G_OPTION_ARG_INT, &depth, "Nest boxes N levels deep", "N" },
+  { "width", 'w', 0, G_OPTION_ARG_INT, &width, "Put N labels into every box", "N" },
+  { "rules", '\0', 0, G_OPTION_ARG_INT, &n_rules, "Generate N rules of each kind", "N" },
+  { NULL }
+};
+
+/* Mostly descendant selectors, like themes use them. Many of them
+ * require ancestors that don't exist, so they can be rejected without
+ * looking at the ancestors. */
+static char *
+create_style_sheet (void)
+{
+  GString *css;
+  int i;
+
+  css = g_string_new (NULL);
+
+  for (i = 0; i < n_rules; i++)
+    {
+      g_string_append_printf (css, ".missing-%d label { color: rgb(%d, 0, 0); }\n", i, i % 256);
+      g_string_append_printf (css, "window.missing-%d box label.item-%d { margin: %dpx; }\n", i, i % width, i % 7);
+      g_string_append_printf (css, "#box-%d label.item-%d { padding: %dpx; }\n", i % depth, i % width, i % 5);
+      g_string_append_printf (css, "box.level-%d box.depth-%d label { border-width: %dpx; }\n",
+                              i % depth, i % 8, i % 3);
+    }
+
+  return g_string_free (css, FALSE);
+}
+
+static GtkWidget *
+create_tree (GPtrArray *widgets)
+{
+  GtkWidget *root, *parent, *box, *label;
+  char *name;
+  int i, j;
+
+  root = parent = NULL;
+
+  for (i = 0; i < depth; i++)
+    {
+      box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+      name = g_strdup_printf ("box-%d", i);
+      gtk_widget_set_name (box, name);
+      g_free (name);
+      name = g_strdup_printf ("level-%d", i);
+      gtk_style_context_add_class (gtk_widget_get_style_context (box), name);
+      g_free (name);
+      name = g_strdup_printf ("depth-%d", i % 8);
+      gtk_style_context_add_class (gtk_widget_get_style_context (box), name);
+      g_free (name);
+      g_ptr_array_add (widgets, box);
+
+      for (j = 0; j < width; j++)
+        {
+          label = gtk_label_new ("Label");
+          name = g_strdup_printf ("item-%d", j);
+          gtk_style_context_add_class (gtk_widget_get_style_context (label), name);
+          g_free (name);
+          gtk_container_add (GTK_CONTAINER (box), label);
+          g_ptr_array_add (widgets, label);
+        }
+
+      if (parent)
+        gtk_container_add (GTK_CONTAINER (parent), box);
+      else
+        root = box;
+
+      parent = box;
+    }
+
+  return root;
+}
+
+/* Recomputes the styles of all @widgets, as created by create_tree() */
+static void
+restyle_run (Benchmark *benchmark,
+             int        run,
+             gpointer   widgets)
+{
+  GPtrArray *array = widgets;
+  GdkRGBA color;
+  guint i;
+
+  /* The first widget is the root of the tree */
+  gtk_widget_reset_style (g_ptr_array_index (array, 0));
+
+  benchmark_start (benchmark);
+  for (i = 0; i < array->len; i++)
+    gtk_style_context_get_color (gtk_widget_get_style_context (g_ptr_array_index (array, i)), &color);
+  benchmark_stop (benchmark);
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkCssProvider *provider;
+  GtkWidget *window, *root;
+  GPtrArray *widgets;
+  gint64 filtered, unfiltered;
+  char *css;
+
+  if (!benchmark_parse_options (&argc, &argv, NULL,
+                                "Recomputes the styles of a deep tree of boxes and labels, with and\n"
+                                "without filtering descendant selectors by the ancestors of a node.\n"
+                                "Turning the filter off needs GTK+ built with debugging enabled.",
+                                options, 20))
+    return 1;
+
+  gtk_init ();
+
+  css = create_style_sheet ();
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider, css, -1);
+  gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
+                                             GTK_STYLE_PROVIDER (provider),
+                                             GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+  g_free (css);
+
+  widgets = g_ptr_array_new ();
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  root = create_tree (widgets);
+  gtk_container_add (GTK_CONTAINER (window), root);
+
+  /* Warm up, so the first run doesn't pay for creating the styles */
+  benchmark_median (restyle_run, widgets);
+
+  gtk_set_debug_flags (gtk_get_debug_flags () & ~GTK_DEBUG_NO_CSS_BLOOM);
+  filtered = benchmark_median (restyle_run, widgets);
+
+  gtk_set_debug_flags (gtk_get_debug_flags () | GTK_DEBUG_NO_CSS_BLOOM);
+  unfiltered = benchmark_median (restyle_run, widgets);
+
+  g_print ("%u widgets, %d levels deep, %d rules\n", widgets->len, depth, 4 * n_rules);
+  g_print ("with ancestor filter:    %8.3f ms\n", filtered / 1000.0);
+  g_print ("without ancestor filter: %8.3f ms\n", unfiltered / 1000.0);
+
+  gtk_widget_destroy (window);
+  g_ptr_array_free (widgets, TRUE);
+  g_object_unref (provider);
+
+  return 0;
+}
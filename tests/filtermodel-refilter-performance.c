@@ -0,0 +1,141 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+
+#include <string.h>
+
+#include "benchmark.h"
+
+static int n_rows = 300000;
+
+static GOptionEntry options[] = {
+  { "rows", 'n', 0, G_OPTION_ARG_INT, &n_rows, "Put N rows into the model", "N" },
+  { NULL }
+};
+
+static const char *words[] = {
+  "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+  "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+  "et", "dolore", "magna", "aliqua"
+};
+
+/* Only changed on the main thread while no refilter is running */
+static const char *search_text = "";
+
+static gboolean
+visible_func (GtkTreeModel *model,
+              GtkTreeIter  *iter,
+              gpointer      data)
+{
+  gboolean visible;
+  gchar *text;
+
+  gtk_tree_model_get (model, iter, 0, &text, -1);
+  visible = strstr (text, search_text) != NULL;
+  g_free (text);
+
+  return visible;
+}
+
+static GtkListStore *
+create_store (void)
+{
+  GtkListStore *store;
+  GString *text;
+  int i, j;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  text = g_string_new (NULL);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      g_string_printf (text, "%d", i);
+      for (j = 0; j < 4; j++)
+        {
+          g_string_append_c (text, ' ');
+          g_string_append (text, words[(i * 7 + j * 3) % G_N_ELEMENTS (words)]);
+        }
+
+      gtk_list_store_insert_with_values (store, NULL, -1, 0, text->str, -1);
+    }
+
+  g_string_free (text, TRUE);
+
+  return store;
+}
+
+/* Refilters while typing a search */
+static void
+refilter_run (Benchmark *benchmark,
+              int        run,
+              gpointer   filter)
+{
+  static const char *searches[] = { "l", "lo", "lor", "lore", "lorem", "" };
+
+  search_text = searches[run % G_N_ELEMENTS (searches)];
+
+  benchmark_start (benchmark);
+  gtk_tree_model_filter_refilter (filter);
+  benchmark_stop (benchmark);
+}
+
+/* Returns the median time in microseconds to refilter @filter, shown
+ * in a tree view */
+static gint64
+benchmark (GtkTreeModelFilter *filter)
+{
+  GtkWidget *tree_view;
+  gint64 median;
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (filter));
+  g_object_ref_sink (tree_view);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view), -1, NULL,
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+
+  median = benchmark_median (refilter_run, filter);
+
+  search_text = "";
+  gtk_tree_model_filter_refilter (filter);
+  g_object_unref (tree_view);
+
+  return median;
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkListStore *store;
+  GtkTreeModel *filter, *threaded_filter;
+  gint64 serial, threaded;
+
+  if (!benchmark_parse_options (&argc, &argv, NULL,
+                                "Refilters a large list, evaluating the visible function row by row and in parallel.",
+                                options, 10))
+    return 1;
+
+  gtk_init ();
+
+  store = create_store ();
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          visible_func, NULL, NULL);
+  serial = benchmark (GTK_TREE_MODEL_FILTER (filter));
+  g_object_unref (filter);
+
+  threaded_filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_threaded_visible_func (GTK_TREE_MODEL_FILTER (threaded_filter),
+                                                   visible_func, NULL, NULL);
+  threaded = benchmark (GTK_TREE_MODEL_FILTER (threaded_filter));
+  g_object_unref (threaded_filter);
+
+  g_print ("%d rows\n", n_rows);
+  g_print ("refilter:          %8.3f ms\n", serial / 1000.0);
+  g_print ("threaded refilter: %8.3f ms\n", threaded / 1000.0);
+
+  g_object_unref (store);
+
+  return 0;
+}
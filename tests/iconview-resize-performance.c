@@ -0,0 +1,115 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+
+#include "benchmark.h"
+
+static int n_items = 20000;
+
+static GOptionEntry options[] = {
+  { "items", 'i', 0, G_OPTION_ARG_INT, &n_items, "Put N items into the model", "N" },
+  { NULL }
+};
+
+static const char *words[] = {
+  "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+  "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+  "et", "dolore", "magna", "aliqua"
+};
+
+static GtkTreeModel *
+create_model (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  GString *text;
+  int i, j, n_words;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  text = g_string_new (NULL);
+
+  for (i = 0; i < n_items; i++)
+    {
+      /* Names of different lengths, so rows get different heights */
+      g_string_printf (text, "%d", i);
+      n_words = 1 + i % 7;
+      for (j = 0; j < n_words; j++)
+        {
+          g_string_append_c (text, ' ');
+          g_string_append (text, words[(i * 7 + j) % G_N_ELEMENTS (words)]);
+        }
+
+      gtk_list_store_insert_with_values (store, &iter, -1, 0, text->str, -1);
+    }
+
+  g_string_free (text, TRUE);
+
+  return GTK_TREE_MODEL (store);
+}
+
+static void
+resize (GtkWidget *widget,
+        int        width,
+        int        height)
+{
+  GtkAllocation allocation = { 0, 0, width, height };
+  GtkAllocation clip;
+  int min, nat;
+
+  gtk_widget_measure (widget, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat, NULL, NULL);
+  gtk_widget_measure (widget, GTK_ORIENTATION_VERTICAL, width, &min, &nat, NULL, NULL);
+  gtk_widget_size_allocate (widget, &allocation, -1, &clip);
+}
+
+/* Measures and allocates @widget with a different width */
+static void
+resize_run (Benchmark *benchmark,
+            int        run,
+            gpointer   widget)
+{
+  benchmark_start (benchmark);
+  resize (widget, 400 + (run % 10) * 60, 600);
+  benchmark_stop (benchmark);
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkWidget *window, *scrolled_window, *icon_view;
+  GtkTreeModel *model;
+  gint64 start, first, resized;
+
+  if (!benchmark_parse_options (&argc, &argv, NULL,
+                                "Lays out an icon view with many items and resizes it repeatedly.",
+                                options, 20))
+    return 1;
+
+  gtk_init ();
+
+  model = create_model ();
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                  GTK_POLICY_NEVER, GTK_POLICY_ALWAYS);
+  gtk_container_add (GTK_CONTAINER (window), scrolled_window);
+
+  icon_view = gtk_icon_view_new_with_model (model);
+  gtk_icon_view_set_text_column (GTK_ICON_VIEW (icon_view), 0);
+  gtk_container_add (GTK_CONTAINER (scrolled_window), icon_view);
+
+  start = g_get_monotonic_time ();
+  resize (scrolled_window, 800, 600);
+  first = g_get_monotonic_time () - start;
+
+  resized = benchmark_median (resize_run, scrolled_window);
+
+  g_print ("%d items\n", n_items);
+  g_print ("first layout: %8.3f ms\n", first / 1000.0);
+  g_print ("resize:       %8.3f ms\n", resized / 1000.0);
+
+  gtk_widget_destroy (window);
+  g_object_unref (model);
+
+  return 0;
+}
@@ -0,0 +1,274 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+#include <gsk/gskrendererprivate.h>
+
+#include <string.h>
+
+#include "benchmark.h"
+
+static char *renderer_name = NULL;
+static char *output = NULL;
+
+static GOptionEntry options[] = {
+  { "renderer", '\0', 0, G_OPTION_ARG_STRING, &renderer_name, "Renderer to use (cairo, gl or vulkan)", "NAME" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, "Write the results to FILE instead of stdout", "FILE" },
+  { NULL }
+};
+
+static void
+append_json_string (GString    *json,
+                    const char *str)
+{
+  const char *p;
+
+  g_string_append_c (json, '"');
+  for (p = str; *p; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        g_string_append_printf (json, "\\%c", *p);
+      else if ((guchar) *p < 0x20)
+        g_string_append_printf (json, "\\u%04x", (guchar) *p);
+      else
+        g_string_append_c (json, *p);
+    }
+  g_string_append_c (json, '"');
+}
+
+static void
+append_json_number (GString *json,
+                    double   number)
+{
+  char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  g_string_append (json, g_ascii_dtostr (buf, sizeof (buf), number));
+}
+
+static int
+compare_filenames (gconstpointer a,
+                   gconstpointer b)
+{
+  return strcmp (*(const char **) a, *(const char **) b);
+}
+
+static void
+collect_files (const char *path,
+               GPtrArray  *files)
+{
+  GDir *dir;
+  const char *name;
+  GPtrArray *names;
+  guint i;
+
+  if (!g_file_test (path, G_FILE_TEST_IS_DIR))
+    {
+      g_ptr_array_add (files, g_strdup (path));
+      return;
+    }
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir == NULL)
+    return;
+
+  names = g_ptr_array_new ();
+  while ((name = g_dir_read_name (dir)))
+    {
+      if (g_str_has_suffix (name, ".node"))
+        g_ptr_array_add (names, g_build_filename (path, name, NULL));
+    }
+  g_dir_close (dir);
+
+  /* Keep the output stable between runs */
+  g_ptr_array_sort (names, compare_filenames);
+  for (i = 0; i < names->len; i++)
+    g_ptr_array_add (files, g_ptr_array_index (names, i));
+  g_ptr_array_free (names, TRUE);
+}
+
+typedef struct {
+  GskRenderer *renderer;
+  GskRenderNode *node;
+} RenderData;
+
+static void
+render_run (Benchmark *benchmark,
+            int        run,
+            gpointer   data)
+{
+  RenderData *render = data;
+  GskTexture *texture;
+
+  benchmark_start (benchmark);
+  texture = gsk_renderer_render_texture (render->renderer, render->node, NULL);
+  benchmark_stop (benchmark);
+
+  g_object_unref (texture);
+}
+
+static gboolean
+benchmark_file (GskRenderer *renderer,
+                const char  *filename,
+                GString     *json)
+{
+  GMappedFile *mapped_file;
+  GskRenderNode *node;
+  GskTexture *texture;
+  GError *error = NULL;
+  GBytes *bytes;
+  Benchmark *benchmark;
+  RenderData render;
+  gint64 start, load_time, total;
+
+  mapped_file = g_mapped_file_new (filename, FALSE, &error);
+  if (mapped_file == NULL)
+    {
+      g_printerr ("Could not open node file: %s\n", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+  bytes = g_mapped_file_get_bytes (mapped_file);
+  g_mapped_file_unref (mapped_file);
+
+  start = g_get_monotonic_time ();
+  node = gsk_render_node_deserialize (bytes, &error);
+  load_time = g_get_monotonic_time () - start;
+  g_bytes_unref (bytes);
+
+  if (node == NULL)
+    {
+      g_printerr ("Invalid node file %s: %s\n", filename, error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  /* Warm up caches and fonts before measuring */
+  texture = gsk_renderer_render_texture (renderer, node, NULL);
+  g_object_unref (texture);
+
+  render.renderer = renderer;
+  render.node = node;
+
+  gsk_renderer_begin_profile (renderer);
+  benchmark = benchmark_run (render_run, &render);
+  total = benchmark_get_total (benchmark);
+
+  g_string_append (json, "    {\n      \"file\": ");
+  append_json_string (json, filename);
+  g_string_append_printf (json, ",\n      \"load-time\": %" G_GINT64_FORMAT ",\n", load_time);
+
+  g_string_append_printf (json,
+                          "      \"wall-time\": {\"total\": %" G_GINT64_FORMAT
+                          ", \"min\": %" G_GINT64_FORMAT
+                          ", \"median\": %" G_GINT64_FORMAT
+                          ", \"max\": %" G_GINT64_FORMAT
+                          ", \"mean\": ",
+                          total,
+                          benchmark_get_min (benchmark),
+                          benchmark_get_median (benchmark),
+                          benchmark_get_max (benchmark));
+  append_json_number (json, (double) total / benchmark_get_runs ());
+  g_string_append (json, "},\n      \"profile\": ");
+  gsk_renderer_end_profile (renderer, json);
+  g_string_append (json, "\n    }");
+
+  benchmark_free (benchmark);
+  gsk_render_node_unref (node);
+
+  return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  GskRenderer *renderer;
+  GdkWindow *window;
+  GError *error = NULL;
+  GPtrArray *files;
+  GString *json;
+  gboolean first;
+  guint i;
+  int arg;
+  int status = 0;
+
+  if (!benchmark_parse_options (&argc, &argv, "[NODE-FILE|DIRECTORY...]",
+                                "Renders node files repeatedly and prints timings as JSON.\n"
+                                "Without arguments, the node files in testsuite/gsk are used.",
+                                options, 20))
+    return 1;
+
+  /* Must be set before the first renderer is created */
+  if (renderer_name)
+    g_setenv ("GSK_RENDERER", renderer_name, TRUE);
+
+  gtk_init ();
+
+  files = g_ptr_array_new_with_free_func (g_free);
+  if (argc > 1)
+    {
+      for (arg = 1; arg < argc; arg++)
+        collect_files (argv[arg], files);
+    }
+  else
+    {
+      collect_files (GTK_SRCDIR "/../testsuite/gsk", files);
+      collect_files (GTK_SRCDIR "/../testsuite/gsk/benchmark", files);
+    }
+
+  if (files->len == 0)
+    {
+      g_printerr ("No node files given.\n");
+      return 1;
+    }
+
+  window = gdk_window_new_toplevel (gdk_display_get_default (), 0, 10, 10);
+  renderer = gsk_renderer_new_for_window (window);
+
+  json = g_string_new ("{\n");
+  g_string_append_printf (json, "  \"version\": \"%d.%d.%d\",\n",
+                          gtk_get_major_version (), gtk_get_minor_version (), gtk_get_micro_version ());
+  g_string_append (json, "  \"renderer\": ");
+  append_json_string (json, G_OBJECT_TYPE_NAME (renderer));
+  g_string_append_printf (json, ",\n  \"runs\": %d,\n  \"files\": [\n", benchmark_get_runs ());
+
+  first = TRUE;
+  for (i = 0; i < files->len; i++)
+    {
+      gsize len = json->len;
+
+      if (!first)
+        g_string_append (json, ",\n");
+
+      if (benchmark_file (renderer, g_ptr_array_index (files, i), json))
+        {
+          first = FALSE;
+        }
+      else
+        {
+          g_string_truncate (json, len);
+          status = 1;
+        }
+    }
+
+  g_string_append (json, "\n  ]\n}\n");
+
+  if (output)
+    {
+      if (!g_file_set_contents (output, json->str, json->len, &error))
+        {
+          g_printerr ("Could not write results: %s\n", error->message);
+          g_clear_error (&error);
+          status = 1;
+        }
+    }
+  else
+    {
+      g_print ("%s", json->str);
+    }
+
+  g_string_free (json, TRUE);
+  g_ptr_array_free (files, TRUE);
+  g_object_unref (renderer);
+  g_object_unref (window);
+
+  return status;
+}
@@ -4,12 +4,14 @@ static gboolean benchmark = FALSE;
 static gboolean dump_variant = FALSE;
 static gboolean fallback = FALSE;
 static int runs = 1;
+static char *write_file = NULL;
 
 static GOptionEntry options[] = {
   { "benchmark", 'b', 0, G_OPTION_ARG_NONE, &benchmark, "Time operations", NULL },
   { "dump-variant", 'd', 0, G_OPTION_ARG_NONE, &dump_variant, "Dump GVariant structure", NULL },
   { "fallback", '\0', 0, G_OPTION_ARG_NONE, &fallback, "Draw node without a renderer", NULL },
   { "runs", 'r', 0, G_OPTION_ARG_INT, &runs, "Render the test N times", "N" },
+  { "write", 'w', 0, G_OPTION_ARG_FILENAME, &write_file, "Save the node in the current format to FILE", "FILE" },
   { NULL }
 };
 
@@ -19,10 +21,9 @@ main(int argc, char **argv)
   cairo_surface_t *surface;
   GskRenderNode *node;
   GError *error = NULL;
+  GMappedFile *mapped_file;
   GBytes *bytes;
   gint64 start, end;
-  char *contents;
-  gsize len;
   int run;
   GOptionContext *context;
 
@@ -41,27 +42,38 @@ main(int argc, char **argv)
       g_printerr ("Number of runs given with -r/--runs must be at least 1 and not %d.\n", runs);
       return 1;
     }
-  if (!(argc == 3 || (argc == 2 && (dump_variant || benchmark))))
+  if (!(argc == 3 || (argc == 2 && (dump_variant || benchmark || write_file))))
     {
       g_printerr ("Usage: %s [OPTIONS] NODE-FILE PNG-FILE\n", argv[0]);
       return 1;
     }
 
-  if (!g_file_get_contents (argv[1], &contents, &len, &error))
+  mapped_file = g_mapped_file_new (argv[1], FALSE, &error);
+  if (mapped_file == NULL)
     {
       g_printerr ("Could not open node file: %s\n", error->message);
       return 1;
     }
 
-  bytes = g_bytes_new_take (contents, len);
+  /* Image data is referenced from the mapping instead of being copied */
+  bytes = g_mapped_file_get_bytes (mapped_file);
+  g_mapped_file_unref (mapped_file);
+
   if (dump_variant)
     {
       GVariant *variant = g_variant_new_from_bytes (G_VARIANT_TYPE ("(suuv)"), bytes, FALSE);
       char *s;
 
-      s = g_variant_print (variant, FALSE);
-      g_print ("%s\n", s);
-      g_free (s);
+      if (g_variant_is_normal_form (variant))
+        {
+          s = g_variant_print (variant, FALSE);
+          g_print ("%s\n", s);
+          g_free (s);
+        }
+      else
+        {
+          g_printerr ("Node file is not in GVariant format, not dumping it.\n");
+        }
       g_variant_unref (variant);
     }
 
@@ -83,6 +95,22 @@ main(int argc, char **argv)
       return 1;
     }
 
+  if (write_file)
+    {
+      if (!gsk_render_node_write_to_file (node, write_file, &error))
+        {
+          g_printerr ("Could not save node file: %s\n", error->message);
+          g_clear_error (&error);
+          return 1;
+        }
+
+      if (argc == 2 && !benchmark)
+        {
+          gsk_render_node_unref (node);
+          return 0;
+        }
+    }
+
   if (fallback)
     {
       graphene_rect_t bounds;
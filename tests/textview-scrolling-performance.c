@@ -0,0 +1,122 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+
+#include "frame-stats.h"
+
+static int n_lines = 100000;
+static int speed = 8;
+static gboolean wrap = FALSE;
+
+static GOptionEntry options[] = {
+  { "lines", 'l', 0, G_OPTION_ARG_INT, &n_lines, "Put N lines into the buffer", "N" },
+  { "speed", 's', 0, G_OPTION_ARG_INT, &speed, "Scroll by N pixels per frame", "N" },
+  { "wrap", 'w', 0, G_OPTION_ARG_NONE, &wrap, "Wrap lines at word boundaries", NULL },
+  { NULL }
+};
+
+static const char *words[] = {
+  "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+  "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+  "et", "dolore", "magna", "aliqua"
+};
+
+static void
+fill_buffer (GtkTextBuffer *buffer)
+{
+  GtkTextIter iter;
+  GString *text;
+  int i, j, n_words;
+
+  text = g_string_new (NULL);
+
+  for (i = 0; i < n_lines; i++)
+    {
+      g_string_append_printf (text, "%6d ", i);
+
+      n_words = 4 + i % 17;
+      for (j = 0; j < n_words; j++)
+        {
+          g_string_append (text, words[(i * 7 + j) % G_N_ELEMENTS (words)]);
+          g_string_append_c (text, j + 1 < n_words ? ' ' : '\n');
+        }
+    }
+
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, text->str, text->len);
+
+  g_string_free (text, TRUE);
+}
+
+/* Scrolls smoothly back and forth, so most lines that are visible
+ * in one frame are visible in the next one, too. */
+static gboolean
+scroll_text_view (GtkWidget     *text_view,
+                  GdkFrameClock *frame_clock,
+                  gpointer       user_data)
+{
+  static int direction = 1;
+  GtkAdjustment *adjustment;
+  gdouble value, lower, upper;
+
+  adjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (text_view));
+  lower = gtk_adjustment_get_lower (adjustment);
+  upper = gtk_adjustment_get_upper (adjustment) - gtk_adjustment_get_page_size (adjustment);
+
+  value = gtk_adjustment_get_value (adjustment) + direction * speed;
+  if (value >= upper || value <= lower)
+    direction = -direction;
+
+  gtk_adjustment_set_value (adjustment, CLAMP (value, lower, upper));
+
+  return G_SOURCE_CONTINUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkWidget *window;
+  GtkWidget *scrolled_window;
+  GtkWidget *text_view;
+  GOptionContext *context;
+  GError *error = NULL;
+
+  context = g_option_context_new (NULL);
+  g_option_context_set_summary (context,
+                                "Scrolls a text view with a large buffer back and forth.");
+  g_option_context_add_main_entries (context, options, NULL);
+  frame_stats_add_options (g_option_context_get_main_group (context));
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  gtk_init ();
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  frame_stats_ensure (GTK_WINDOW (window));
+  gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (window), scrolled_window);
+
+  text_view = gtk_text_view_new ();
+  if (wrap)
+    gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (text_view), GTK_WRAP_WORD);
+  fill_buffer (gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view)));
+  gtk_container_add (GTK_CONTAINER (scrolled_window), text_view);
+
+  gtk_widget_add_tick_callback (text_view,
+                                scroll_text_view,
+                                NULL,
+                                NULL);
+
+  gtk_widget_show (window);
+  g_signal_connect (window, "destroy",
+                    G_CALLBACK (gtk_main_quit), NULL);
+  gtk_main ();
+
+  return 0;
+}
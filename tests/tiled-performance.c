@@ -0,0 +1,170 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+
+static int runs = 10;
+static int width = 3840;
+static int height = 2160;
+
+static GOptionEntry options[] = {
+  { "runs", 'r', 0, G_OPTION_ARG_INT, &runs, "Render the scene N times", "N" },
+  { "width", '\0', 0, G_OPTION_ARG_INT, &width, "Width of the generated scene", "WIDTH" },
+  { "height", '\0', 0, G_OPTION_ARG_INT, &height, "Height of the generated scene", "HEIGHT" },
+  { NULL }
+};
+
+/* A grid of cards with shadows, borders and gradients, roughly
+ * like a dense dashboard.
+ */
+static GskRenderNode *
+create_scene (void)
+{
+  GskRenderNode *container, *node;
+  GPtrArray *nodes;
+  int x, y;
+
+  nodes = g_ptr_array_new_with_free_func ((GDestroyNotify) gsk_render_node_unref);
+
+  g_ptr_array_add (nodes, gsk_color_node_new (&(GdkRGBA) { 0.9, 0.9, 0.9, 1.0 },
+                                              &GRAPHENE_RECT_INIT (0, 0, width, height)));
+
+  for (y = 0; y + 100 <= height; y += 120)
+    {
+      for (x = 0; x + 180 <= width; x += 200)
+        {
+          GskRoundedRect outline;
+          GskColorStop stops[2] = {
+            { 0.0, { (double) x / width, 0.4, 0.6, 1.0 } },
+            { 1.0, { 0.2, (double) y / height, 0.8, 1.0 } }
+          };
+
+          gsk_rounded_rect_init_from_rect (&outline, &GRAPHENE_RECT_INIT (x + 10, y + 10, 160, 80), 8);
+
+          g_ptr_array_add (nodes, gsk_outset_shadow_node_new (&outline,
+                                                              &(GdkRGBA) { 0, 0, 0, 0.5 },
+                                                              2, 4, 0, 12));
+
+          node = gsk_linear_gradient_node_new (&outline.bounds,
+                                               &GRAPHENE_POINT_INIT (x + 10, y + 10),
+                                               &GRAPHENE_POINT_INIT (x + 170, y + 90),
+                                               stops, G_N_ELEMENTS (stops));
+          g_ptr_array_add (nodes, gsk_rounded_clip_node_new (node, &outline));
+          gsk_render_node_unref (node);
+
+          g_ptr_array_add (nodes, gsk_border_node_new (&outline,
+                                                       (float[4]) { 1, 1, 1, 1 },
+                                                       (GdkRGBA[4]) {
+                                                         { 0, 0, 0, 0.8 }, { 0, 0, 0, 0.8 },
+                                                         { 0, 0, 0, 0.8 }, { 0, 0, 0, 0.8 }
+                                                       }));
+        }
+    }
+
+  container = gsk_container_node_new ((GskRenderNode **) nodes->pdata, nodes->len);
+  g_ptr_array_free (nodes, TRUE);
+
+  return container;
+}
+
+static double
+benchmark (GskRenderer   *renderer,
+           GskRenderNode *node,
+           gboolean       tiled)
+{
+  GskTexture *texture;
+  GTimer *timer;
+  double total;
+  int run;
+
+  g_object_set (renderer, "tiled", tiled, NULL);
+
+  /* Warm up */
+  texture = gsk_renderer_render_texture (renderer, node, NULL);
+  g_object_unref (texture);
+
+  timer = g_timer_new ();
+  for (run = 0; run < runs; run++)
+    {
+      texture = gsk_renderer_render_texture (renderer, node, NULL);
+      g_object_unref (texture);
+    }
+  total = g_timer_elapsed (timer, NULL) * 1000;
+  g_timer_destroy (timer);
+
+  return total / runs;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GskRenderer *renderer;
+  GskRenderNode *node;
+  GdkWindow *window;
+  double single, tiled;
+
+  context = g_option_context_new ("[NODE-FILE]");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (runs < 1)
+    {
+      g_printerr ("Number of runs given with -r/--runs must be at least 1 and not %d.\n", runs);
+      return 1;
+    }
+
+  g_setenv ("GSK_RENDERER", "cairo", TRUE);
+  gtk_init ();
+
+  if (argc > 1)
+    {
+      GBytes *bytes;
+      char *contents;
+      gsize len;
+
+      if (!g_file_get_contents (argv[1], &contents, &len, &error))
+        {
+          g_printerr ("Could not open node file: %s\n", error->message);
+          return 1;
+        }
+
+      bytes = g_bytes_new_take (contents, len);
+      node = gsk_render_node_deserialize (bytes, &error);
+      g_bytes_unref (bytes);
+
+      if (node == NULL)
+        {
+          g_printerr ("Invalid node file: %s\n", error->message);
+          return 1;
+        }
+    }
+  else
+    node = create_scene ();
+
+  window = gdk_window_new_toplevel (gdk_display_get_default (), 0, 10, 10);
+  renderer = gsk_renderer_new_for_window (window);
+
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (renderer), "tiled") == NULL)
+    {
+      g_printerr ("Renderer %s does not support tiled rendering\n", G_OBJECT_TYPE_NAME (renderer));
+      return 1;
+    }
+
+  single = benchmark (renderer, node, FALSE);
+  tiled = benchmark (renderer, node, TRUE);
+
+  g_print ("Single-threaded: %.2f msec\n", single);
+  g_print ("Tiled:           %.2f msec (%u threads, %.2fx)\n", tiled, g_get_num_processors (), single / tiled);
+
+  gsk_render_node_unref (node);
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+  g_object_unref (window);
+
+  return 0;
+}
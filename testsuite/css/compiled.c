@@ -0,0 +1,224 @@
+/*
+ * Copyright © 2017 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "../../gtk/gtkcsscompiledprivate.h"
+#include "../../gtk/gtkcssproviderprivate.h"
+
+static const char *imported_css =
+  "@define-color imported_color #abcdef;\n"
+  "label { color: @imported_color; }\n";
+
+static const char *main_css =
+  "@import url(\"imported.css\");\n"
+  "@define-color fg_color rgb(10, 20, 30);\n"
+  "@define-color bg_color shade(@fg_color, 1.5);\n"
+  "@keyframes spin { from { -gtk-icon-transform: rotate(0deg); } to { -gtk-icon-transform: rotate(360deg); } }\n"
+  "* { color: @fg_color; background-color: @bg_color; }\n"
+  "button, entry.flat:hover, box > label:first-child { border: 1px solid red; padding: 2px 4px; }\n"
+  "row:nth-child(2n+1):not(:backdrop) { background-image: linear-gradient(to bottom, red, blue); }\n"
+  "#name ~ label + image, window .titlebar:dir(ltr) { animation: spin 1s infinite linear; }\n"
+  "image { -gtk-icon-source: -gtk-icontheme(\"edit-find\"); border-radius: initial; }\n"
+  "label { color: inherit; margin: 0 1px 2px 3px; }\n";
+
+static char *
+write_file (const char *dir,
+            const char *name,
+            const char *contents)
+{
+  GError *error = NULL;
+  char *path;
+
+  path = g_build_filename (dir, name, NULL);
+  g_file_set_contents (path, contents, -1, &error);
+  g_assert_no_error (error);
+
+  return path;
+}
+
+static void
+compile_file (const char *path)
+{
+  GError *error = NULL;
+  GBytes *bytes;
+  GFile *file;
+  char *compiled_path;
+
+  file = g_file_new_for_path (path);
+  bytes = gtk_css_provider_compile (file, &error);
+  g_assert_no_error (error);
+  g_assert (bytes != NULL);
+
+  compiled_path = g_strconcat (path, GTK_CSS_COMPILED_SUFFIX, NULL);
+  g_file_set_contents (compiled_path,
+                       g_bytes_get_data (bytes, NULL),
+                       g_bytes_get_size (bytes),
+                       &error);
+  g_assert_no_error (error);
+
+  g_free (compiled_path);
+  g_bytes_unref (bytes);
+  g_object_unref (file);
+}
+
+static char *
+load_to_string (const char *path,
+                gboolean    compiled)
+{
+  GtkCssProvider *provider;
+  char *result;
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_path (provider, path);
+  g_assert (gtk_css_provider_loaded_compiled (provider) == compiled);
+  result = gtk_css_provider_to_string (provider);
+  g_object_unref (provider);
+
+  return result;
+}
+
+static char *
+load_text_to_string (const char *path)
+{
+  char *compiled_path, *hidden_path, *result;
+
+  /* Move the compiled style sheet out of the way to get the parsed one */
+  compiled_path = g_strconcat (path, GTK_CSS_COMPILED_SUFFIX, NULL);
+  hidden_path = g_strconcat (compiled_path, ".hidden", NULL);
+  g_assert_cmpint (g_rename (compiled_path, hidden_path), ==, 0);
+
+  result = load_to_string (path, FALSE);
+
+  g_assert_cmpint (g_rename (hidden_path, compiled_path), ==, 0);
+  g_free (compiled_path);
+  g_free (hidden_path);
+
+  return result;
+}
+
+static void
+cleanup_dir (const char *dir)
+{
+  const char *names[] = {
+    "gtk.css", "gtk.css" GTK_CSS_COMPILED_SUFFIX, "imported.css", "broken.css"
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      char *path = g_build_filename (dir, names[i], NULL);
+      g_remove (path);
+      g_free (path);
+    }
+
+  g_rmdir (dir);
+}
+
+static void
+test_compiled_roundtrip (void)
+{
+  char *dir, *path, *imported_path;
+  char *compiled, *parsed;
+
+  dir = g_dir_make_tmp ("css-compiled-XXXXXX", NULL);
+  g_assert (dir != NULL);
+  imported_path = write_file (dir, "imported.css", imported_css);
+  path = write_file (dir, "gtk.css", main_css);
+
+  compile_file (path);
+
+  compiled = load_to_string (path, TRUE);
+  parsed = load_text_to_string (path);
+  g_assert_cmpstr (compiled, ==, parsed);
+
+  g_free (compiled);
+  g_free (parsed);
+  g_free (imported_path);
+  g_free (path);
+  cleanup_dir (dir);
+  g_free (dir);
+}
+
+static void
+test_compiled_stale (void)
+{
+  char *dir, *path, *imported_path;
+  char *compiled, *parsed;
+
+  dir = g_dir_make_tmp ("css-compiled-XXXXXX", NULL);
+  g_assert (dir != NULL);
+  imported_path = write_file (dir, "imported.css", imported_css);
+  path = write_file (dir, "gtk.css", main_css);
+
+  compile_file (path);
+
+  /* Changing an imported file must make the compiled style sheet unused */
+  g_free (imported_path);
+  imported_path = write_file (dir, "imported.css", "label { color: blue; }\n");
+
+  compiled = load_to_string (path, FALSE);
+  parsed = load_text_to_string (path);
+  g_assert_cmpstr (compiled, ==, parsed);
+  g_assert (strstr (compiled, "imported_color") == NULL);
+
+  g_free (compiled);
+  g_free (parsed);
+  g_free (imported_path);
+  g_free (path);
+  cleanup_dir (dir);
+  g_free (dir);
+}
+
+static void
+test_compiled_errors (void)
+{
+  GError *error = NULL;
+  char *dir, *path;
+  GBytes *bytes;
+  GFile *file;
+
+  dir = g_dir_make_tmp ("css-compiled-XXXXXX", NULL);
+  g_assert (dir != NULL);
+  path = write_file (dir, "broken.css", "label { color: not-a-color; }\n");
+
+  file = g_file_new_for_path (path);
+  bytes = gtk_css_provider_compile (file, &error);
+  g_assert (bytes == NULL);
+  g_assert (error != NULL);
+  g_assert (error->domain == GTK_CSS_PROVIDER_ERROR);
+
+  g_error_free (error);
+  g_object_unref (file);
+  g_free (path);
+  cleanup_dir (dir);
+  g_free (dir);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/css/compiled/roundtrip", test_compiled_roundtrip);
+  g_test_add_func ("/css/compiled/stale", test_compiled_stale);
+  g_test_add_func ("/css/compiled/errors", test_compiled_errors);
+
+  return g_test_run ();
+}
@@ -0,0 +1,73 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <gsk/gskrendernodeprivate.h>
+
+static GtkWidget *
+create_window (GtkWidget **label)
+{
+  GtkWidget *window, *box;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
+  gtk_container_add (GTK_CONTAINER (window), box);
+  gtk_container_add (GTK_CONTAINER (box), gtk_label_new ("First label"));
+  *label = gtk_label_new ("Second label");
+  gtk_container_add (GTK_CONTAINER (box), *label);
+  gtk_container_add (GTK_CONTAINER (box), gtk_button_new_with_label ("Button"));
+
+  return window;
+}
+
+/* The nodes of a normal frame come from the arena, and the nodes that
+ * widgets keep are moved out of it */
+static void
+test_frame (void)
+{
+  GskRenderNodeArenaStats before, after;
+  GtkWidget *window, *label;
+
+  window = create_window (&label);
+
+  gsk_render_node_get_arena_stats (&before);
+  gtk_widget_show (window);
+  gtk_test_widget_wait_for_draw (window);
+  gsk_render_node_get_arena_stats (&after);
+
+  g_assert_cmpuint (after.n_nodes, >, before.n_nodes);
+  g_assert_cmpuint (after.n_promoted, >, before.n_promoted);
+  g_assert_cmpuint (after.n_promoted - before.n_promoted, <=, after.n_nodes - before.n_nodes);
+
+  /* Redrawing a single widget snapshots it and its ancestors again */
+  before = after;
+  gtk_label_set_text (GTK_LABEL (label), "Changed label");
+  gtk_test_widget_wait_for_draw (window);
+  gsk_render_node_get_arena_stats (&after);
+
+  g_assert_cmpuint (after.n_nodes, >, before.n_nodes);
+
+  gtk_widget_destroy (window);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/arena/frame", test_frame);
+
+  return g_test_run ();
+}
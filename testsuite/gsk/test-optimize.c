@@ -0,0 +1,383 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <gtk/gtk.h>
+#include <gsk/gskrendernodeprivate.h>
+#include "reftest-compare.h"
+
+static cairo_surface_t *
+draw_node (GskRenderNode *node)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 100, 100);
+  cr = cairo_create (surface);
+  if (node)
+    gsk_render_node_draw (node, cr);
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+/* Optimizes @node and checks that the result draws the same */
+static GskRenderNode *
+optimize (GskRenderNode              *node,
+          GskRenderNodeOptimizeStats *stats)
+{
+  cairo_surface_t *surface, *ref_surface, *diff_surface;
+  GskRenderNode *result;
+
+  memset (stats, 0, sizeof (GskRenderNodeOptimizeStats));
+  result = gsk_render_node_optimize (node, stats);
+
+  ref_surface = draw_node (node);
+  surface = draw_node (result);
+  diff_surface = reftest_compare_surfaces (surface, ref_surface);
+  if (diff_surface)
+    {
+      cairo_surface_write_to_png (diff_surface, "test-optimize.diff.png");
+      cairo_surface_destroy (diff_surface);
+      g_test_fail ();
+    }
+  cairo_surface_destroy (surface);
+  cairo_surface_destroy (ref_surface);
+
+  return result;
+}
+
+static GskRenderNode *
+color_node (float x,
+            float y,
+            float width,
+            float height,
+            float alpha)
+{
+  GdkRGBA color = { 0.2, 0.4, 0.6, alpha };
+
+  return gsk_color_node_new (&color, &GRAPHENE_RECT_INIT (x, y, width, height));
+}
+
+static void
+test_leaf (void)
+{
+  GskRenderNodeOptimizeStats stats;
+  GskRenderNode *node, *result;
+
+  node = color_node (10, 10, 50, 50, 1.0);
+  result = optimize (node, &stats);
+
+  g_assert (result == node);
+
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+}
+
+static void
+test_container (void)
+{
+  GskRenderNodeOptimizeStats stats;
+  GskRenderNode *children[3];
+  GskRenderNode *inner, *node, *result;
+
+  children[0] = color_node (10, 10, 20, 20, 0.5);
+  children[1] = color_node (20, 20, 20, 20, 0.5);
+  children[2] = color_node (30, 30, 20, 20, 0.5);
+
+  /* A container with a single child is replaced by the child */
+  node = gsk_container_node_new (children, 1);
+  result = optimize (node, &stats);
+  g_assert (result == children[0]);
+  g_assert_cmpuint (stats.folded_containers, ==, 1);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  /* Nested containers are flattened */
+  inner = gsk_container_node_new (children, 2);
+  node = gsk_container_node_new ((GskRenderNode *[]) { inner, children[2] }, 2);
+  result = optimize (node, &stats);
+  g_assert_cmpint (gsk_render_node_get_node_type (result), ==, GSK_CONTAINER_NODE);
+  g_assert_cmpuint (gsk_container_node_get_n_children (result), ==, 3);
+  g_assert (gsk_container_node_get_child (result, 0) == children[0]);
+  g_assert (gsk_container_node_get_child (result, 2) == children[2]);
+  g_assert_cmpuint (stats.folded_containers, ==, 1);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (inner);
+
+  /* Empty containers disappear */
+  node = gsk_container_node_new (NULL, 0);
+  result = optimize (node, &stats);
+  g_assert_null (result);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (children[0]);
+  gsk_render_node_unref (children[1]);
+  gsk_render_node_unref (children[2]);
+}
+
+static void
+test_opacity (void)
+{
+  GskRenderNodeOptimizeStats stats;
+  GskRenderNode *child, *node, *result;
+
+  child = color_node (10, 10, 50, 50, 1.0);
+
+  node = gsk_opacity_node_new (child, 1.0);
+  result = optimize (node, &stats);
+  g_assert (result == child);
+  g_assert_cmpuint (stats.folded_opacities, ==, 1);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  node = gsk_opacity_node_new (child, 0.5);
+  result = optimize (node, &stats);
+  g_assert (result == node);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (child);
+}
+
+static void
+test_clip (void)
+{
+  GskRenderNodeOptimizeStats stats;
+  GskRoundedRect rounded;
+  GskRenderNode *child, *node, *result;
+
+  child = color_node (20, 20, 20, 20, 1.0);
+
+  /* Clips that contain the child do nothing */
+  node = gsk_clip_node_new (child, &GRAPHENE_RECT_INIT (10, 10, 50, 50));
+  result = optimize (node, &stats);
+  g_assert (result == child);
+  g_assert_cmpuint (stats.folded_clips, ==, 1);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  /* Clips that cut the child are kept */
+  node = gsk_clip_node_new (child, &GRAPHENE_RECT_INIT (30, 30, 50, 50));
+  result = optimize (node, &stats);
+  g_assert (result == node);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  /* Clips that don't touch the child hide it */
+  node = gsk_clip_node_new (child, &GRAPHENE_RECT_INIT (60, 60, 10, 10));
+  result = optimize (node, &stats);
+  g_assert_null (result);
+  g_assert_cmpuint (stats.culled_nodes, ==, 1);
+  gsk_render_node_unref (node);
+
+  /* Rounded corners that don't reach the child do nothing */
+  gsk_rounded_rect_init_from_rect (&rounded, &GRAPHENE_RECT_INIT (10, 10, 50, 50), 5);
+  node = gsk_rounded_clip_node_new (child, &rounded);
+  result = optimize (node, &stats);
+  g_assert (result == child);
+  g_assert_cmpuint (stats.folded_clips, ==, 1);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  /* But they do when they cut the child */
+  gsk_rounded_rect_init_from_rect (&rounded, &GRAPHENE_RECT_INIT (20, 20, 20, 20), 5);
+  node = gsk_rounded_clip_node_new (child, &rounded);
+  result = optimize (node, &stats);
+  g_assert (result == node);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (child);
+}
+
+static void
+test_transform (void)
+{
+  GskRenderNodeOptimizeStats stats;
+  GskRenderNode *child, *inner, *node, *result;
+  graphene_matrix_t transform;
+  graphene_rect_t bounds;
+
+  child = color_node (0, 0, 20, 20, 1.0);
+
+  /* Translations are moved into the node */
+  graphene_matrix_init_translate (&transform, &GRAPHENE_POINT3D_INIT (10, 15, 0));
+  inner = gsk_transform_node_new (child, &transform);
+  node = gsk_transform_node_new (inner, &transform);
+  result = optimize (node, &stats);
+  g_assert_cmpint (gsk_render_node_get_node_type (result), ==, GSK_COLOR_NODE);
+  gsk_render_node_get_bounds (result, &bounds);
+  g_assert (graphene_rect_equal (&bounds, &GRAPHENE_RECT_INIT (20, 30, 20, 20)));
+  g_assert_cmpuint (stats.folded_transforms, ==, 2);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (inner);
+
+  /* Other transforms are kept */
+  graphene_matrix_init_scale (&transform, 2, 2, 1);
+  node = gsk_transform_node_new (child, &transform);
+  result = optimize (node, &stats);
+  g_assert (result == node);
+  g_assert_cmpuint (stats.folded_transforms, ==, 0);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (child);
+}
+
+static void
+test_occlusion (void)
+{
+  GskRenderNodeOptimizeStats stats;
+  GskRenderNode *children[3];
+  GskRenderNode *node, *result;
+
+  children[0] = color_node (20, 20, 20, 20, 1.0);
+  children[1] = color_node (30, 30, 40, 40, 0.5);
+  children[2] = color_node (10, 10, 40, 40, 1.0);
+
+  /* The first child is covered by the last one, the second isn't */
+  node = gsk_container_node_new (children, 3);
+  result = optimize (node, &stats);
+  g_assert_cmpint (gsk_render_node_get_node_type (result), ==, GSK_CONTAINER_NODE);
+  g_assert_cmpuint (gsk_container_node_get_n_children (result), ==, 2);
+  g_assert (gsk_container_node_get_child (result, 0) == children[1]);
+  g_assert (gsk_container_node_get_child (result, 1) == children[2]);
+  g_assert_cmpuint (stats.culled_nodes, ==, 1);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (children[0]);
+  gsk_render_node_unref (children[1]);
+  gsk_render_node_unref (children[2]);
+
+  /* Antialiased edges don't cover anything */
+  children[0] = color_node (20, 20, 20, 20, 1.0);
+  children[1] = color_node (19.5, 19.5, 20, 20, 1.0);
+
+  node = gsk_container_node_new (children, 2);
+  result = optimize (node, &stats);
+  g_assert (result == node);
+  g_assert_cmpuint (stats.culled_nodes, ==, 0);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (children[0]);
+  gsk_render_node_unref (children[1]);
+}
+
+static void
+test_text (void)
+{
+  GskRenderNodeOptimizeStats stats;
+  GdkRGBA color = { 0, 0, 0, 1 };
+  PangoContext *context;
+  PangoLayout *layout;
+  PangoLayoutRun *run;
+  GskRenderNode *children[2];
+  GskRenderNode *node, *result;
+  int width;
+
+  context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+  layout = pango_layout_new (context);
+  pango_layout_set_text (layout, "Hello", -1);
+  run = pango_layout_get_line_readonly (layout, 0)->runs->data;
+  width = pango_glyph_string_get_width (run->glyphs);
+
+  children[0] = gsk_text_node_new (run->item->analysis.font, run->glyphs, &color, 5, 30);
+  children[1] = gsk_text_node_new (run->item->analysis.font, run->glyphs, &color,
+                                   5 + (double) (width + 3 * PANGO_SCALE) / PANGO_SCALE, 30);
+
+  node = gsk_container_node_new (children, 2);
+  result = optimize (node, &stats);
+  g_assert_cmpint (gsk_render_node_get_node_type (result), ==, GSK_TEXT_NODE);
+  g_assert_cmpuint (stats.merged_text_nodes, ==, 1);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (children[1]);
+
+  /* Text on another baseline is not merged */
+  children[1] = gsk_text_node_new (run->item->analysis.font, run->glyphs, &color, 5, 60);
+
+  node = gsk_container_node_new (children, 2);
+  result = optimize (node, &stats);
+  g_assert (result == node);
+  g_assert_cmpuint (stats.merged_text_nodes, ==, 0);
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (children[0]);
+  gsk_render_node_unref (children[1]);
+
+  g_object_unref (layout);
+  g_object_unref (context);
+}
+
+/* Trees that are rendered again, like the ones widgets retain between
+ * frames, must optimize to the same nodes every time */
+static void
+test_retained (void)
+{
+  GskRenderNodeOptimizeStats stats;
+  GskRenderNode *child, *retained, *node, *result, *result2;
+  graphene_matrix_t transform;
+
+  child = color_node (10, 10, 20, 20, 0.5);
+  graphene_matrix_init_translate (&transform, &GRAPHENE_POINT3D_INIT (10, 15, 0));
+  node = gsk_container_node_new (&child, 1);
+  retained = gsk_transform_node_new (node, &transform);
+  gsk_render_node_unref (node);
+
+  result = optimize (retained, &stats);
+  g_assert_cmpint (gsk_render_node_get_node_type (result), ==, GSK_COLOR_NODE);
+  g_assert_cmpuint (stats.folded_transforms, ==, 1);
+
+  result2 = optimize (retained, &stats);
+  g_assert (result2 == result);
+  g_assert_cmpuint (stats.folded_transforms, ==, 0);
+  gsk_render_node_unref (result2);
+
+  /* A new frame around the retained tree reuses its result */
+  node = gsk_opacity_node_new (retained, 0.5);
+  result2 = optimize (node, &stats);
+  g_assert (gsk_opacity_node_get_child (result2) == result);
+  g_assert_cmpuint (stats.folded_transforms, ==, 0);
+  gsk_render_node_unref (result2);
+  gsk_render_node_unref (node);
+
+  gsk_render_node_unref (result);
+  gsk_render_node_unref (retained);
+  gsk_render_node_unref (child);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/optimize/leaf", test_leaf);
+  g_test_add_func ("/optimize/container", test_container);
+  g_test_add_func ("/optimize/opacity", test_opacity);
+  g_test_add_func ("/optimize/clip", test_clip);
+  g_test_add_func ("/optimize/transform", test_transform);
+  g_test_add_func ("/optimize/occlusion", test_occlusion);
+  g_test_add_func ("/optimize/text", test_text);
+  g_test_add_func ("/optimize/retained", test_retained);
+
+  return g_test_run ();
+}
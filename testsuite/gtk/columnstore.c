@@ -0,0 +1,375 @@
+/* GtkColumnStore tests.
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "treemodel.h"
+
+enum {
+  COLUMN_INT,
+  COLUMN_STRING,
+  COLUMN_DOUBLE,
+  COLUMN_BOOLEAN,
+  COLUMN_OBJECT,
+  N_COLUMNS
+};
+
+static GtkColumnStore *
+create_store (void)
+{
+  return gtk_column_store_new (N_COLUMNS,
+                               G_TYPE_INT,
+                               G_TYPE_STRING,
+                               G_TYPE_DOUBLE,
+                               G_TYPE_BOOLEAN,
+                               G_TYPE_OBJECT);
+}
+
+static void
+check_int_column (GtkTreeModel *model,
+                  gint         *expected,
+                  gint          n_expected)
+{
+  GtkTreeIter iter;
+  gint i, value;
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, n_expected);
+
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, i));
+      gtk_tree_model_get (model, &iter, COLUMN_INT, &value, -1);
+      g_assert_cmpint (value, ==, expected[i]);
+    }
+}
+
+static void
+column_store_test_values (void)
+{
+  GtkColumnStore *store;
+  GtkTreeModel *model;
+  GObject *object, *value_object;
+  GtkTreeIter iter;
+  gchar *str;
+  gdouble d;
+  gboolean b;
+  gint i;
+
+  store = create_store ();
+  model = GTK_TREE_MODEL (store);
+  object = g_object_new (G_TYPE_OBJECT, NULL);
+
+  g_assert_cmpint (gtk_tree_model_get_n_columns (model), ==, N_COLUMNS);
+  g_assert (gtk_tree_model_get_column_type (model, COLUMN_STRING) == G_TYPE_STRING);
+  g_assert (gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY);
+
+  gtk_column_store_insert_with_values (store, &iter, -1,
+                                       COLUMN_INT, 42,
+                                       COLUMN_STRING, "foo",
+                                       COLUMN_DOUBLE, 0.5,
+                                       COLUMN_BOOLEAN, TRUE,
+                                       COLUMN_OBJECT, object,
+                                       -1);
+
+  /* The store holds a reference */
+  g_object_unref (object);
+
+  gtk_tree_model_get (model, &iter,
+                      COLUMN_INT, &i,
+                      COLUMN_STRING, &str,
+                      COLUMN_DOUBLE, &d,
+                      COLUMN_BOOLEAN, &b,
+                      COLUMN_OBJECT, &value_object,
+                      -1);
+  g_assert_cmpint (i, ==, 42);
+  g_assert_cmpstr (str, ==, "foo");
+  g_assert_cmpfloat (d, ==, 0.5);
+  g_assert (b);
+  g_assert (value_object == object);
+  g_free (str);
+  g_object_unref (value_object);
+
+  /* Values are converted to the column type */
+  {
+    GValue value = G_VALUE_INIT;
+
+    g_value_init (&value, G_TYPE_INT);
+    g_value_set_int (&value, 3);
+    gtk_column_store_set_value (store, &iter, COLUMN_DOUBLE, &value);
+    g_value_unset (&value);
+  }
+
+  gtk_column_store_set (store, &iter,
+                        COLUMN_STRING, NULL,
+                        COLUMN_OBJECT, NULL,
+                        -1);
+  gtk_tree_model_get (model, &iter,
+                      COLUMN_STRING, &str,
+                      COLUMN_DOUBLE, &d,
+                      COLUMN_OBJECT, &value_object,
+                      -1);
+  g_assert_null (str);
+  g_assert_cmpfloat (d, ==, 3.0);
+  g_assert_null (value_object);
+
+  g_object_unref (store);
+}
+
+static void
+column_store_test_insert_remove (void)
+{
+  GtkColumnStore *store;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  gint expected[] = { 2, 0, 3, 1 };
+  gint after_remove[] = { 2, 3, 1 };
+  gint i;
+
+  store = create_store ();
+  model = GTK_TREE_MODEL (store);
+
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, 0, -1);
+  gtk_column_store_insert_with_values (store, NULL, 1, COLUMN_INT, 1, -1);
+  gtk_column_store_insert_with_values (store, NULL, 0, COLUMN_INT, 2, -1);
+  gtk_column_store_insert_with_values (store, NULL, 2, COLUMN_INT, 3, -1);
+  check_int_column (model, expected, G_N_ELEMENTS (expected));
+
+  g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, 1));
+  g_assert (gtk_column_store_remove (store, &iter));
+  gtk_tree_model_get (model, &iter, COLUMN_INT, &i, -1);
+  g_assert_cmpint (i, ==, 3);
+  check_int_column (model, after_remove, G_N_ELEMENTS (after_remove));
+
+  /* The removed row is reused */
+  gtk_column_store_insert_with_values (store, &iter, -1, COLUMN_INT, 4, -1);
+  gtk_tree_model_get (model, &iter, COLUMN_INT, &i, -1);
+  g_assert_cmpint (i, ==, 4);
+
+  g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, 3));
+  g_assert (!gtk_column_store_remove (store, &iter));
+
+  gtk_column_store_clear (store);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, 0);
+  g_assert (!gtk_tree_model_get_iter_first (model, &iter));
+
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_STRING, "bar", -1);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, 1);
+
+  g_object_unref (store);
+}
+
+static void
+count_signal (GtkTreeModel *model,
+              GtkTreePath  *path,
+              GtkTreeIter  *iter,
+              gint         *count)
+{
+  (*count)++;
+}
+
+static void
+count_rows_inserted (GtkTreeModel *model,
+                     GtkTreePath  *path,
+                     GtkTreeIter  *iter,
+                     gint          n_rows,
+                     gint         *count)
+{
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 1);
+  g_assert_cmpint (n_rows, ==, 3);
+  (*count)++;
+}
+
+static void
+column_store_test_insert_rows (void)
+{
+  GtkColumnStore *store;
+  GtkTreeModel *model;
+  GValue values[6] = { G_VALUE_INIT, };
+  gint columns[] = { COLUMN_INT, COLUMN_STRING };
+  gint expected[] = { 0, 10, 11, 12, 1 };
+  gint row_inserted = 0, rows_inserted = 0;
+  GtkTreeIter iter;
+  gchar *str;
+  gint i;
+
+  store = create_store ();
+  model = GTK_TREE_MODEL (store);
+
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, 0, -1);
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, 1, -1);
+
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 10 + i);
+      g_value_init (&values[3 + i], G_TYPE_STRING);
+      g_value_set_string (&values[3 + i], "same");
+    }
+
+  g_signal_connect (model, "row-inserted", G_CALLBACK (count_signal), &row_inserted);
+  g_signal_connect (model, "rows-inserted", G_CALLBACK (count_rows_inserted), &rows_inserted);
+
+  gtk_column_store_insert_rows (store, 1, 3, columns, values, 2);
+
+  for (i = 0; i < 6; i++)
+    g_value_unset (&values[i]);
+
+  g_assert_cmpint (rows_inserted, ==, 1);
+  g_assert_cmpint (row_inserted, ==, 3);
+  check_int_column (model, expected, G_N_ELEMENTS (expected));
+
+  g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, 3));
+  gtk_tree_model_get (model, &iter, COLUMN_STRING, &str, -1);
+  g_assert_cmpstr (str, ==, "same");
+  g_free (str);
+
+  g_object_unref (store);
+}
+
+static void
+count_rows_reordered (GtkTreeModel *model,
+                      GtkTreePath  *path,
+                      GtkTreeIter  *iter,
+                      gint         *new_order,
+                      gint         *count)
+{
+  (*count)++;
+}
+
+static gint
+compare_strings_reversed (GtkTreeModel *model,
+                          GtkTreeIter  *a,
+                          GtkTreeIter  *b,
+                          gpointer      data)
+{
+  gchar *sa, *sb;
+  gint retval;
+
+  gtk_tree_model_get (model, a, COLUMN_STRING, &sa, -1);
+  gtk_tree_model_get (model, b, COLUMN_STRING, &sb, -1);
+  retval = -g_strcmp0 (sa, sb);
+  g_free (sa);
+  g_free (sb);
+
+  return retval;
+}
+
+static void
+column_store_test_sort (void)
+{
+  GtkColumnStore *store;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  gint reordered = 0;
+  gint ascending[] = { 1, 2, 3, 4, 5 };
+  gint descending[] = { 5, 4, 3, 2, 1 };
+  gint by_string[] = { 4, 3, 2, 5, 1 };
+  gint moved[] = { 6, 4, 3, 2, 5 };
+  gint i;
+
+  store = create_store ();
+  model = GTK_TREE_MODEL (store);
+
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, 3, COLUMN_STRING, "c", -1);
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, 1, COLUMN_STRING, "a", -1);
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, 5, COLUMN_STRING, "b", -1);
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, 2, COLUMN_STRING, "c", -1);
+  gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, 4, COLUMN_STRING, "d", -1);
+
+  g_signal_connect (model, "rows-reordered", G_CALLBACK (count_rows_reordered), &reordered);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store),
+                                        COLUMN_INT, GTK_SORT_ASCENDING);
+  g_assert_cmpint (reordered, ==, 1);
+  check_int_column (model, ascending, G_N_ELEMENTS (ascending));
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store),
+                                        COLUMN_INT, GTK_SORT_DESCENDING);
+  check_int_column (model, descending, G_N_ELEMENTS (descending));
+
+  /* A custom function; "c" ties keep their current order */
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (store), COLUMN_STRING,
+                                   compare_strings_reversed, NULL, NULL);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store),
+                                        COLUMN_STRING, GTK_SORT_ASCENDING);
+  check_int_column (model, by_string, G_N_ELEMENTS (by_string));
+
+  /* Changing the sort column moves the row and updates the iter */
+  g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, 4));
+  gtk_column_store_set (store, &iter, COLUMN_INT, 6, COLUMN_STRING, "z", -1);
+  gtk_tree_model_get (model, &iter, COLUMN_INT, &i, -1);
+  g_assert_cmpint (i, ==, 6);
+  check_int_column (model, moved, G_N_ELEMENTS (moved));
+
+  /* Inserted rows end up where they belong */
+  gtk_column_store_insert_with_values (store, &iter, 0, COLUMN_INT, 7, COLUMN_STRING, "bb", -1);
+  gtk_tree_model_get (model, &iter, COLUMN_INT, &i, -1);
+  g_assert_cmpint (i, ==, 7);
+  path = gtk_tree_model_get_path (model, &iter);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 4);
+  gtk_tree_path_free (path);
+
+  g_object_unref (store);
+}
+
+static void
+column_store_test_set_sorted_iter (void)
+{
+  GtkColumnStore *store;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  gint i;
+
+  store = create_store ();
+  model = GTK_TREE_MODEL (store);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store),
+                                        COLUMN_INT, GTK_SORT_ASCENDING);
+
+  for (i = 0; i < 10; i++)
+    gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_INT, i * 10, -1);
+
+  g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, 0));
+  gtk_column_store_set (store, &iter, COLUMN_INT, 55, -1);
+
+  /* The iter follows the row to its new position */
+  path = gtk_tree_model_get_path (model, &iter);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 5);
+  gtk_tree_path_free (path);
+  gtk_tree_model_get (model, &iter, COLUMN_INT, &i, -1);
+  g_assert_cmpint (i, ==, 55);
+
+  /* Other columns don't move anything */
+  gtk_column_store_set (store, &iter, COLUMN_STRING, "x", -1);
+  path = gtk_tree_model_get_path (model, &iter);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 5);
+  gtk_tree_path_free (path);
+
+  g_object_unref (store);
+}
+
+void
+register_column_store_tests (void)
+{
+  g_test_add_func ("/ColumnStore/values", column_store_test_values);
+  g_test_add_func ("/ColumnStore/insert-remove", column_store_test_insert_remove);
+  g_test_add_func ("/ColumnStore/insert-rows", column_store_test_insert_rows);
+  g_test_add_func ("/ColumnStore/sort", column_store_test_sort);
+  g_test_add_func ("/ColumnStore/set-sorted-iter", column_store_test_set_sorted_iter);
+}
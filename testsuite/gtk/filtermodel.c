@@ -6782,6 +6782,171 @@ specific_bug_679910 (void)
   g_object_unref (store);
 }
 
+/* Enough rows for the visible function to be split over several
+ * worker threads */
+#define THREADED_REFILTER_ROWS 4000
+
+static gint threaded_refilter_mode;
+
+static gboolean
+threaded_refilter_visible_func (GtkTreeModel *model,
+                                GtkTreeIter  *iter,
+                                gpointer      data)
+{
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  switch (g_atomic_int_get (&threaded_refilter_mode))
+    {
+    case 1:
+      return value >= THREADED_REFILTER_ROWS / 2;
+    case 2:
+      return value < THREADED_REFILTER_ROWS / 2;
+    case 3:
+      return value % 2 == 0;
+    default:
+      return TRUE;
+    }
+}
+
+static void
+threaded_refilter_count_rows_inserted (GtkTreeModel *model,
+                                       GtkTreePath  *path,
+                                       GtkTreeIter  *iter,
+                                       gint          n_rows,
+                                       gint         *count)
+{
+  (*count)++;
+}
+
+static void
+threaded_refilter_count_rows_deleted (GtkTreeModel *model,
+                                      GtkTreePath  *path,
+                                      gint          n_rows,
+                                      gint         *count)
+{
+  (*count)++;
+}
+
+static void
+threaded_refilter_count_row_signal (GtkTreeModel *model,
+                                    GtkTreePath  *path,
+                                    gint         *count)
+{
+  (*count)++;
+}
+
+static void
+threaded_refilter_check (GtkTreeModel *filter,
+                         GtkTreeModel *reference)
+{
+  GtkTreeIter iter, ref_iter;
+  gboolean valid, ref_valid;
+  gint value, ref_value;
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==,
+                   gtk_tree_model_iter_n_children (reference, NULL));
+
+  valid = gtk_tree_model_get_iter_first (filter, &iter);
+  ref_valid = gtk_tree_model_get_iter_first (reference, &ref_iter);
+  while (valid && ref_valid)
+    {
+      gtk_tree_model_get (filter, &iter, 0, &value, -1);
+      gtk_tree_model_get (reference, &ref_iter, 0, &ref_value, -1);
+      g_assert_cmpint (value, ==, ref_value);
+
+      valid = gtk_tree_model_iter_next (filter, &iter);
+      ref_valid = gtk_tree_model_iter_next (reference, &ref_iter);
+    }
+
+  g_assert (!valid && !ref_valid);
+}
+
+/* Refiltering with a threaded visible function must end up with the
+ * same rows as refiltering row by row, announcing rows that become
+ * visible or hidden next to each other with one signal.
+ */
+static void
+threaded_refilter (void)
+{
+  GtkListStore *store;
+  GtkTreeModel *filter, *reference;
+  GtkWidget *tree_view;
+  gint rows_inserted = 0, row_inserted = 0, rows_deleted = 0, row_deleted = 0;
+  gint n = THREADED_REFILTER_ROWS;
+  gint i;
+
+  threaded_refilter_mode = 0;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < n; i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, i, -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_threaded_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                                   threaded_refilter_visible_func,
+                                                   NULL, NULL);
+  reference = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (reference),
+                                          threaded_refilter_visible_func,
+                                          NULL, NULL);
+
+  tree_view = gtk_tree_view_new_with_model (filter);
+  g_object_ref_sink (tree_view);
+  threaded_refilter_check (filter, reference);
+
+  g_signal_connect (filter, "rows-inserted",
+                    G_CALLBACK (threaded_refilter_count_rows_inserted), &rows_inserted);
+  g_signal_connect (filter, "row-inserted",
+                    G_CALLBACK (threaded_refilter_count_row_signal), &row_inserted);
+  g_signal_connect (filter, "rows-deleted",
+                    G_CALLBACK (threaded_refilter_count_rows_deleted), &rows_deleted);
+  g_signal_connect (filter, "row-deleted",
+                    G_CALLBACK (threaded_refilter_count_row_signal), &row_deleted);
+
+  threaded_refilter_mode = 1;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (reference));
+  threaded_refilter_check (filter, reference);
+  g_assert_cmpint (rows_deleted, ==, 1);
+  g_assert_cmpint (row_deleted, ==, n / 2);
+  g_assert_cmpint (rows_inserted, ==, 0);
+
+  threaded_refilter_mode = 2;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (reference));
+  threaded_refilter_check (filter, reference);
+  g_assert_cmpint (rows_deleted, ==, 2);
+  g_assert_cmpint (row_deleted, ==, n);
+  g_assert_cmpint (rows_inserted, ==, 1);
+  g_assert_cmpint (row_inserted, ==, n / 2);
+
+  /* The odd rows in the lower half go away one by one, as there is
+   * an even row between each of them, but the even rows in the upper
+   * half are next to each other once they are gone */
+  threaded_refilter_mode = 3;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (reference));
+  threaded_refilter_check (filter, reference);
+  g_assert_cmpint (rows_deleted, ==, 2 + n / 4);
+  g_assert_cmpint (row_deleted, ==, n + n / 4);
+  g_assert_cmpint (rows_inserted, ==, 2);
+  g_assert_cmpint (row_inserted, ==, n / 2 + n / 4);
+
+  threaded_refilter_mode = 0;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (reference));
+  threaded_refilter_check (filter, reference);
+  g_assert_cmpint (rows_deleted, ==, 2 + n / 4);
+  g_assert_cmpint (row_deleted, ==, n + n / 4);
+
+  g_object_unref (tree_view);
+  g_object_unref (filter);
+  g_object_unref (reference);
+  g_object_unref (store);
+}
+
 /* main */
 
 void
@@ -7143,4 +7308,7 @@ register_filter_model_tests (void)
                    specific_bug_659022_row_deleted_free_level);
   g_test_add_func ("/TreeModelFilter/specific/bug-679910",
                    specific_bug_679910);
+
+  g_test_add_func ("/TreeModelFilter/threaded-refilter",
+                   threaded_refilter);
 }
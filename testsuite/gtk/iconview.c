@@ -0,0 +1,100 @@
+#include <gtk/gtk.h>
+
+static GtkWidget *
+create_icon_view (GtkListStore *store)
+{
+  GtkWidget *icon_view;
+  GtkCellRenderer *cell;
+
+  icon_view = gtk_icon_view_new_with_model (GTK_TREE_MODEL (store));
+  g_object_ref_sink (icon_view);
+
+  cell = gtk_cell_renderer_text_new ();
+  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (icon_view), cell, TRUE);
+  gtk_cell_layout_add_attribute (GTK_CELL_LAYOUT (icon_view), cell, "text", 0);
+
+  return icon_view;
+}
+
+static int
+get_min_width (GtkWidget *icon_view)
+{
+  int min_width;
+
+  gtk_widget_measure (icon_view, GTK_ORIENTATION_HORIZONTAL, -1,
+                      &min_width, NULL, NULL, NULL);
+
+  return min_width;
+}
+
+/* The items get narrower when the widest one goes away */
+static void
+test_shrink_on_delete (void)
+{
+  GtkListStore *store;
+  GtkWidget *icon_view;
+  GtkTreeIter iter;
+  int narrow, wide;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, "Short", -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, "Short", -1);
+  icon_view = create_icon_view (store);
+
+  narrow = get_min_width (icon_view);
+
+  gtk_list_store_insert_with_values (store, &iter, -1, 0, "A much longer text than the others", -1);
+  wide = get_min_width (icon_view);
+  g_assert_cmpint (wide, >, narrow);
+
+  gtk_list_store_remove (store, &iter);
+  g_assert_cmpint (get_min_width (icon_view), ==, narrow);
+
+  /* Removing an item that isn't the widest keeps the width */
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, "A much longer text than the others", -1);
+  g_assert_cmpint (get_min_width (icon_view), ==, wide);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 1);
+  gtk_list_store_remove (store, &iter);
+  g_assert_cmpint (get_min_width (icon_view), ==, wide);
+
+  g_object_unref (icon_view);
+  g_object_unref (store);
+}
+
+/* The items get narrower when the widest one gets narrower */
+static void
+test_shrink_on_change (void)
+{
+  GtkListStore *store;
+  GtkWidget *icon_view;
+  GtkTreeIter iter;
+  int narrow, wide;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, "Short", -1);
+  gtk_list_store_insert_with_values (store, &iter, -1, 0, "Short", -1);
+  icon_view = create_icon_view (store);
+
+  narrow = get_min_width (icon_view);
+
+  gtk_list_store_set (store, &iter, 0, "A much longer text than the others", -1);
+  wide = get_min_width (icon_view);
+  g_assert_cmpint (wide, >, narrow);
+
+  gtk_list_store_set (store, &iter, 0, "Short", -1);
+  g_assert_cmpint (get_min_width (icon_view), ==, narrow);
+
+  g_object_unref (icon_view);
+  g_object_unref (store);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/iconview/shrink-on-delete", test_shrink_on_delete);
+  g_test_add_func ("/iconview/shrink-on-change", test_shrink_on_change);
+
+  return g_test_run ();
+}
@@ -1013,6 +1013,450 @@ list_store_test_iter_parent_invalid (ListStore     *fixture,
 }
 
 
+/* sorting */
+
+static const gchar *sort_words[] = {
+  "Zebra", "apple", "\303\204pfel", "banana", "Banana", NULL, "cherry", "apple"
+};
+
+/* Checks that the store is sorted by the string in column 0, and that
+ * equal rows are ordered by their index in column 1 */
+static void
+check_sorted_by_string (GtkListStore *store,
+                        GtkSortType   order)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (store);
+  GtkTreeIter iter;
+  gchar *prev_str = NULL, *str;
+  gint prev_index = -1, index, cmp;
+  gboolean valid;
+
+  for (valid = gtk_tree_model_get_iter_first (model, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (model, &iter))
+    {
+      gtk_tree_model_get (model, &iter, 0, &str, 1, &index, -1);
+
+      if (prev_index >= 0)
+        {
+          cmp = g_utf8_collate (prev_str ? prev_str : "", str ? str : "");
+          if (order == GTK_SORT_DESCENDING)
+            cmp = -cmp;
+
+          g_assert_cmpint (cmp, <=, 0);
+          if (cmp == 0)
+            g_assert_cmpint (prev_index, <, index);
+        }
+
+      g_free (prev_str);
+      prev_str = str;
+      prev_index = index;
+    }
+
+  g_free (prev_str);
+}
+
+static void
+list_store_test_sort_large (void)
+{
+  GtkTreeModel *model;
+  GtkListStore *store;
+  GtkTreeIter iter;
+  gdouble prev, value;
+  gboolean valid;
+  gint i;
+
+  store = gtk_list_store_new (3, G_TYPE_STRING, G_TYPE_INT, G_TYPE_DOUBLE);
+  model = GTK_TREE_MODEL (store);
+
+  /* Enough rows to be sorted in parallel */
+  for (i = 0; i < 5000; i++)
+    gtk_list_store_insert_with_values (store, &iter, -1,
+                                       0, sort_words[(i * 5) % G_N_ELEMENTS (sort_words)],
+                                       1, i,
+                                       2, ((i * 37) % 101) / 7.0,
+                                       -1);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0, GTK_SORT_ASCENDING);
+  check_sorted_by_string (store, GTK_SORT_ASCENDING);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0, GTK_SORT_DESCENDING);
+  check_sorted_by_string (store, GTK_SORT_DESCENDING);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 2, GTK_SORT_ASCENDING);
+  prev = -1.0;
+  for (valid = gtk_tree_model_get_iter_first (model, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (model, &iter))
+    {
+      gtk_tree_model_get (model, &iter, 2, &value, -1);
+      g_assert_cmpfloat (prev, <=, value);
+      prev = value;
+    }
+
+  g_object_unref (store);
+}
+
+/* batched insertion */
+
+static void
+count_signal (GtkTreeModel *model,
+              GtkTreePath  *path,
+              GtkTreeIter  *iter,
+              gint         *count)
+{
+  (*count)++;
+}
+
+static void
+count_rows_inserted (GtkTreeModel *model,
+                     GtkTreePath  *path,
+                     GtkTreeIter  *iter,
+                     gint          n_rows,
+                     gint         *count)
+{
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 2);
+  g_assert_cmpint (n_rows, ==, 10);
+  (*count)++;
+}
+
+static void
+count_row_deleted (GtkTreeModel *model,
+                   GtkTreePath  *path,
+                   gint         *count)
+{
+  (*count)++;
+}
+
+/* Counts the emissions in @counts[0] and the rows in @counts[1] */
+static void
+count_rows_deleted (GtkTreeModel *model,
+                    GtkTreePath  *path,
+                    gint          n_rows,
+                    gint         *counts)
+{
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 0);
+  counts[0]++;
+  counts[1] += n_rows;
+}
+
+static GValue *
+create_int_values (gint first,
+                   gint n_rows)
+{
+  GValue *values;
+  gint i;
+
+  values = g_new0 (GValue, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], first + i);
+    }
+
+  return values;
+}
+
+static void
+free_values (GValue *values,
+             gint    n_values)
+{
+  gint i;
+
+  for (i = 0; i < n_values; i++)
+    g_value_unset (&values[i]);
+  g_free (values);
+}
+
+static void
+list_store_test_insert_rows (ListStore     *fixture,
+                             gconstpointer  user_data)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (fixture->store);
+  GtkTreeRowReference *ref;
+  GtkTreePath *path;
+  GValue *values;
+  gint columns[] = { 0 };
+  gint row_inserted = 0, rows_inserted = 0;
+  gint expected[] = { 0, 1, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 2, 3, 4 };
+  gint i, value;
+  GtkTreeIter iter;
+
+  path = gtk_tree_path_new_from_indices (3, -1);
+  ref = gtk_tree_row_reference_new (model, path);
+  gtk_tree_path_free (path);
+
+  g_signal_connect (model, "row-inserted", G_CALLBACK (count_signal), &row_inserted);
+  g_signal_connect (model, "rows-inserted", G_CALLBACK (count_rows_inserted), &rows_inserted);
+
+  values = create_int_values (100, 10);
+  gtk_list_store_insert_rows (fixture->store, 2, 10, columns, values, 1);
+  free_values (values, 10);
+
+  g_assert_cmpint (rows_inserted, ==, 1);
+  g_assert_cmpint (row_inserted, ==, 10);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, G_N_ELEMENTS (expected));
+  for (i = 0; i < G_N_ELEMENTS (expected); i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, i));
+      g_assert (gtk_list_store_iter_is_valid (fixture->store, &iter));
+      gtk_tree_model_get (model, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected[i]);
+    }
+
+  /* The old iters are still valid and the reference moved along */
+  g_assert (iter_position (fixture->store, &fixture->iter[2], 12));
+  path = gtk_tree_row_reference_get_path (ref);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 13);
+  gtk_tree_path_free (path);
+  gtk_tree_row_reference_free (ref);
+}
+
+static void
+list_store_test_replace_rows (ListStore     *fixture,
+                              gconstpointer  user_data)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (fixture->store);
+  GtkTreeRowReference *ref;
+  GtkTreePath *path;
+  GValue *values;
+  gint columns[] = { 0 };
+  gint i, value;
+  gint row_deleted = 0, rows_deleted[2] = { 0, 0 };
+  GtkTreeIter iter;
+
+  path = gtk_tree_path_new_from_indices (2, -1);
+  ref = gtk_tree_row_reference_new (model, path);
+  gtk_tree_path_free (path);
+
+  g_signal_connect (model, "row-deleted", G_CALLBACK (count_row_deleted), &row_deleted);
+  g_signal_connect (model, "rows-deleted", G_CALLBACK (count_rows_deleted), rows_deleted);
+
+  values = create_int_values (10, 3);
+  gtk_list_store_replace_rows (fixture->store, 3, columns, values, 1);
+  free_values (values, 3);
+
+  /* The old rows go away in one emission, and are replayed for
+   * ::row-deleted handlers */
+  g_assert_cmpint (rows_deleted[0], ==, 1);
+  g_assert_cmpint (rows_deleted[1], ==, 5);
+  g_assert_cmpint (row_deleted, ==, 5);
+  g_assert (!gtk_tree_row_reference_valid (ref));
+  gtk_tree_row_reference_free (ref);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, 3);
+  for (i = 0; i < 3; i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, i));
+      gtk_tree_model_get (model, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, 10 + i);
+    }
+}
+
+static void
+list_store_test_rows_deleted_refs (ListStore     *fixture,
+                                   gconstpointer  user_data)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (fixture->store);
+  GtkTreeRowReference *before, *inside, *after;
+  GtkTreePath *path;
+
+  path = gtk_tree_path_new_from_indices (0, -1);
+  before = gtk_tree_row_reference_new (model, path);
+  gtk_tree_path_free (path);
+  path = gtk_tree_path_new_from_indices (2, -1);
+  inside = gtk_tree_row_reference_new (model, path);
+  gtk_tree_path_free (path);
+  path = gtk_tree_path_new_from_indices (4, -1);
+  after = gtk_tree_row_reference_new (model, path);
+  gtk_tree_path_free (path);
+
+  /* Pretend rows 1 to 3 went away */
+  path = gtk_tree_path_new_from_indices (1, -1);
+  gtk_tree_model_rows_deleted (model, path, 3);
+  gtk_tree_path_free (path);
+
+  g_assert (!gtk_tree_row_reference_valid (inside));
+
+  path = gtk_tree_row_reference_get_path (before);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 0);
+  gtk_tree_path_free (path);
+
+  path = gtk_tree_row_reference_get_path (after);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 1);
+  gtk_tree_path_free (path);
+
+  gtk_tree_row_reference_free (before);
+  gtk_tree_row_reference_free (inside);
+  gtk_tree_row_reference_free (after);
+}
+
+static void
+list_store_test_insert_rows_sorted (ListStore     *fixture,
+                                    gconstpointer  user_data)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (fixture->store);
+  GValue *values;
+  gint columns[] = { 0 };
+  gint prev, value;
+  gboolean valid;
+  GtkTreeIter iter;
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        0, GTK_SORT_DESCENDING);
+
+  values = create_int_values (-2, 10);
+  gtk_list_store_insert_rows (fixture->store, 0, 10, columns, values, 1);
+  free_values (values, 10);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, 15);
+
+  prev = G_MAXINT;
+  for (valid = gtk_tree_model_get_iter_first (model, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (model, &iter))
+    {
+      gtk_tree_model_get (model, &iter, 0, &value, -1);
+      g_assert_cmpint (prev, >=, value);
+      prev = value;
+    }
+}
+
+static gboolean
+is_even (GtkTreeModel *model,
+         GtkTreeIter  *iter,
+         gpointer      data)
+{
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  return value % 2 == 0;
+}
+
+/* The filter and sort models handle ::rows-inserted themselves, and
+ * must end up with the same rows as if they had been inserted one by one
+ */
+static void
+list_store_test_insert_rows_proxies (ListStore     *fixture,
+                                     gconstpointer  user_data)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (fixture->store);
+  GtkTreeModel *filter, *sort, *sort_filter;
+  GtkWidget *view;
+  GValue *values;
+  gint columns[] = { 0 };
+  gint expected_filter[] = { 0, 100, 102, 104, 106, 108, 2, 4 };
+  gint expected_sort[] = { 109, 108, 107, 106, 105, 104, 103, 102, 101, 100, 4, 3, 2, 1, 0 };
+  gint expected_sort_filter[] = { 108, 106, 104, 102, 100, 4, 2, 0 };
+  gint i, value;
+  GtkTreeIter iter;
+
+  filter = gtk_tree_model_filter_new (model, NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          is_even, NULL, NULL);
+  sort = gtk_tree_model_sort_new_with_model (model);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort),
+                                        0, GTK_SORT_DESCENDING);
+  sort_filter = gtk_tree_model_sort_new_with_model (filter);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_filter),
+                                        0, GTK_SORT_DESCENDING);
+  view = gtk_tree_view_new_with_model (sort_filter);
+  g_object_ref_sink (view);
+
+  values = create_int_values (100, 10);
+  gtk_list_store_insert_rows (fixture->store, 1, 10, columns, values, 1);
+  free_values (values, 10);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, G_N_ELEMENTS (expected_filter));
+  for (i = 0; i < G_N_ELEMENTS (expected_filter); i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (filter, &iter, NULL, i));
+      gtk_tree_model_get (filter, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected_filter[i]);
+    }
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort, NULL), ==, G_N_ELEMENTS (expected_sort));
+  for (i = 0; i < G_N_ELEMENTS (expected_sort); i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (sort, &iter, NULL, i));
+      gtk_tree_model_get (sort, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected_sort[i]);
+    }
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort_filter, NULL), ==, G_N_ELEMENTS (expected_sort_filter));
+  for (i = 0; i < G_N_ELEMENTS (expected_sort_filter); i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (sort_filter, &iter, NULL, i));
+      gtk_tree_model_get (sort_filter, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected_sort_filter[i]);
+    }
+
+  g_object_unref (view);
+  g_object_unref (sort_filter);
+  g_object_unref (sort);
+  g_object_unref (filter);
+}
+
+static void
+list_store_test_replace_rows_proxies (ListStore     *fixture,
+                                      gconstpointer  user_data)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (fixture->store);
+  GtkTreeModel *filter, *sort, *sort_filter;
+  GtkWidget *view;
+  GValue *values;
+  gint columns[] = { 0 };
+  gint expected_sort_filter[] = { 104, 102, 100 };
+  gint filter_deleted[2] = { 0, 0 }, sort_deleted[2] = { 0, 0 };
+  gint i, value;
+  GtkTreeIter iter;
+
+  filter = gtk_tree_model_filter_new (model, NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          is_even, NULL, NULL);
+  sort = gtk_tree_model_sort_new_with_model (model);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort),
+                                        0, GTK_SORT_DESCENDING);
+  sort_filter = gtk_tree_model_sort_new_with_model (filter);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_filter),
+                                        0, GTK_SORT_DESCENDING);
+  view = gtk_tree_view_new_with_model (sort_filter);
+  g_object_ref_sink (view);
+
+  /* Build the levels */
+  gtk_tree_model_iter_n_children (filter, NULL);
+  gtk_tree_model_iter_n_children (sort, NULL);
+
+  g_signal_connect (filter, "rows-deleted", G_CALLBACK (count_rows_deleted), filter_deleted);
+  g_signal_connect (sort, "rows-deleted", G_CALLBACK (count_rows_deleted), sort_deleted);
+
+  values = create_int_values (100, 5);
+  gtk_list_store_replace_rows (fixture->store, 5, columns, values, 1);
+  free_values (values, 5);
+
+  /* 0, 2 and 4 were visible in the filter */
+  g_assert_cmpint (filter_deleted[0], ==, 1);
+  g_assert_cmpint (filter_deleted[1], ==, 3);
+  g_assert_cmpint (sort_deleted[0], ==, 1);
+  g_assert_cmpint (sort_deleted[1], ==, 5);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort, NULL), ==, 5);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort_filter, NULL), ==, G_N_ELEMENTS (expected_sort_filter));
+  for (i = 0; i < G_N_ELEMENTS (expected_sort_filter); i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (sort_filter, &iter, NULL, i));
+      gtk_tree_model_get (sort_filter, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected_sort_filter[i]);
+    }
+
+  g_object_unref (view);
+  g_object_unref (sort_filter);
+  g_object_unref (sort);
+  g_object_unref (filter);
+}
+
 /* main */
 
 void
@@ -1136,4 +1580,26 @@ register_list_store_tests (void)
   g_test_add ("/ListStore/iter-parent-invalid", ListStore, NULL,
               list_store_setup, list_store_test_iter_parent_invalid,
               list_store_teardown);
+
+  g_test_add_func ("/ListStore/sort-large", list_store_test_sort_large);
+
+  /* batched insertion */
+  g_test_add ("/ListStore/insert-rows", ListStore, NULL,
+              list_store_setup, list_store_test_insert_rows,
+              list_store_teardown);
+  g_test_add ("/ListStore/replace-rows", ListStore, NULL,
+              list_store_setup, list_store_test_replace_rows,
+              list_store_teardown);
+  g_test_add ("/ListStore/insert-rows-sorted", ListStore, NULL,
+              list_store_setup, list_store_test_insert_rows_sorted,
+              list_store_teardown);
+  g_test_add ("/ListStore/insert-rows-proxies", ListStore, NULL,
+              list_store_setup, list_store_test_insert_rows_proxies,
+              list_store_teardown);
+  g_test_add ("/ListStore/rows-deleted-refs", ListStore, NULL,
+              list_store_setup, list_store_test_rows_deleted_refs,
+              list_store_teardown);
+  g_test_add ("/ListStore/replace-rows-proxies", ListStore, NULL,
+              list_store_setup, list_store_test_replace_rows_proxies,
+              list_store_teardown);
 }
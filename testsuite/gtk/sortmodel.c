@@ -1202,6 +1202,53 @@ specific_bug_698846 (void)
   g_assert_cmpuint (count, ==, 2);
 }
 
+static void
+specific_sort_large (void)
+{
+  const gchar *words[] = { "Zebra", "apple", "\303\204pfel", "banana", "Banana", NULL, "cherry" };
+  GtkListStore *store;
+  GtkTreeModel *sorted;
+  GtkTreeIter iter;
+  gchar *prev_str = NULL, *str;
+  gint prev_index = -1, index, cmp;
+  gboolean valid;
+  gint i;
+
+  store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
+  for (i = 0; i < 5000; i++)
+    gtk_list_store_insert_with_values (store, &iter, -1,
+                                       0, words[(i * 3) % G_N_ELEMENTS (words)],
+                                       1, i,
+                                       -1);
+
+  sorted = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sorted), 0, GTK_SORT_ASCENDING);
+
+  /* Equal rows keep the order of the child model */
+  for (valid = gtk_tree_model_get_iter_first (sorted, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (sorted, &iter))
+    {
+      gtk_tree_model_get (sorted, &iter, 0, &str, 1, &index, -1);
+
+      if (prev_index >= 0)
+        {
+          cmp = g_utf8_collate (prev_str ? prev_str : "", str ? str : "");
+          g_assert_cmpint (cmp, <=, 0);
+          if (cmp == 0)
+            g_assert_cmpint (prev_index, <, index);
+        }
+
+      g_free (prev_str);
+      prev_str = str;
+      prev_index = index;
+    }
+
+  g_free (prev_str);
+  g_object_unref (sorted);
+  g_object_unref (store);
+}
+
 /* main */
 
 void
@@ -1239,5 +1286,7 @@ register_sort_model_tests (void)
                    specific_bug_674587);
   g_test_add_func ("/TreeModelSort/specific/bug-698846",
                    specific_bug_698846);
+  g_test_add_func ("/TreeModelSort/specific/sort-large",
+                   specific_sort_large);
 }
 
@@ -310,6 +310,101 @@ test_style_classes (void)
   g_object_unref (context);
 }
 
+/* Returns the sums of the red and blue channels of the background image */
+static void
+get_background_image_color (GtkStyleContext *context,
+                            guint64         *red,
+                            guint64         *blue)
+{
+  cairo_pattern_t *pattern;
+  cairo_surface_t *source, *surface;
+  cairo_t *cr;
+  guchar *data;
+  int x, y, width, height, stride;
+
+  gtk_style_context_get (context, "background-image", &pattern, NULL);
+  g_assert_nonnull (pattern);
+  g_assert_cmpint (cairo_pattern_get_surface (pattern, &source), ==, CAIRO_STATUS_SUCCESS);
+
+  width = cairo_image_surface_get_width (source);
+  height = cairo_image_surface_get_height (source);
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  cr = cairo_create (surface);
+  cairo_set_source_surface (cr, source, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+  cairo_surface_flush (surface);
+
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+  *red = *blue = 0;
+  for (y = 0; y < height; y++)
+    {
+      guint32 *row = (guint32 *) (data + y * stride);
+
+      for (x = 0; x < width; x++)
+        {
+          *red += (row[x] >> 16) & 0xff;
+          *blue += row[x] & 0xff;
+        }
+    }
+
+  cairo_surface_destroy (surface);
+  cairo_pattern_destroy (pattern);
+}
+
+/* Symbolic icons of the same name compare equal, but are recolored
+ * with the color of the style they were computed for, so a child must
+ * not end up with the image of its parent. */
+static void
+test_symbolic_icon_not_shared (void)
+{
+  GtkCssProvider *provider;
+  GtkStyleContext *parent, *context;
+  GtkWidgetPath *path;
+  guint64 red, blue;
+
+  g_object_set (gtk_settings_get_default (), "gtk-icon-theme-name", "icons", NULL);
+  gtk_icon_theme_append_search_path (gtk_icon_theme_get_default (), g_test_get_dir (G_TEST_DIST));
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "* { color: red; background-image: -gtk-icontheme('everything-symbolic'); }\n"
+                                   ".blue { color: blue; }",
+                                   -1);
+  gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
+                                             GTK_STYLE_PROVIDER (provider),
+                                             GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  parent = gtk_style_context_new ();
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_BOX);
+  gtk_style_context_set_path (parent, path);
+  gtk_widget_path_free (path);
+
+  context = gtk_style_context_new ();
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_BOX);
+  gtk_widget_path_append_type (path, GTK_TYPE_IMAGE);
+  gtk_widget_path_iter_add_class (path, -1, "blue");
+  gtk_style_context_set_path (context, path);
+  gtk_widget_path_free (path);
+  gtk_style_context_set_parent (context, parent);
+
+  get_background_image_color (parent, &red, &blue);
+  g_assert_cmpuint (red, >, blue);
+
+  get_background_image_color (context, &red, &blue);
+  g_assert_cmpuint (blue, >, red);
+
+  g_object_unref (context);
+  g_object_unref (parent);
+
+  gtk_style_context_remove_provider_for_screen (gdk_screen_get_default (),
+                                                GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
 static void
 test_style_priorities_setup (PrioritiesFixture *f,
                              gconstpointer      unused)
@@ -516,6 +611,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/style/basic", test_basic_properties);
   g_test_add_func ("/style/widget-path-parent", test_widget_path_parent);
   g_test_add_func ("/style/classes", test_style_classes);
+  g_test_add_func ("/style/symbolic-icon-not-shared", test_symbolic_icon_not_shared);
 
 #define ADD_PRIORITIES_TEST(path, func) \
   g_test_add ("/style/priorities/" path, PrioritiesFixture, NULL, test_style_priorities_setup, \
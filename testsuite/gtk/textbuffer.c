@@ -22,6 +22,7 @@
 
 #include <gtk/gtk.h>
 #include "gtk/gtktexttypes.h" /* Private header, for UNKNOWN_CHAR */
+#include "gtk/gtktextbtree.h" /* Private header, for the segment offsets */
 
 static void
 gtk_text_iter_spew (const GtkTextIter *iter, const gchar *desc)
@@ -1556,6 +1557,150 @@ test_get_iter (void)
   g_object_unref (buffer);
 }
 
+/* Lines with many tag toggles are located through a table of segment
+ * offsets, which has to agree with walking the segments.
+ */
+static void
+test_get_iter_tagged (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextIter start, end, iter;
+  GString *text;
+  gint i, offset;
+
+  buffer = gtk_text_buffer_new (NULL);
+  tag = gtk_text_buffer_create_tag (buffer, "tag", NULL);
+
+  /* ß takes 2 bytes in UTF-8 */
+  text = g_string_new ("first line\n");
+  for (i = 0; i < 100; i++)
+    g_string_append (text, i % 3 ? "a" : "ß");
+  g_string_append (text, "\nlast line");
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+
+  for (i = 0; i < 100; i += 2)
+    {
+      gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 1, i);
+      end = start;
+      gtk_text_iter_forward_char (&end);
+      gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+    }
+
+  /* Applying a tag doesn't move characters */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 1, 50);
+  offset = gtk_text_iter_get_offset (&iter);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 1, 51);
+  end = start;
+  gtk_text_iter_forward_char (&end);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+  g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, offset);
+  g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, 1);
+
+  for (i = 0; i <= 100; i++)
+    {
+      gtk_text_buffer_get_iter_at_offset (buffer, &iter, 11 + i);
+      g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, 1);
+      g_assert_cmpint (gtk_text_iter_get_line_offset (&iter), ==, i);
+      g_assert_cmpint (gtk_text_iter_get_line_index (&iter), ==, i + (i + 2) / 3);
+      g_assert (gtk_text_iter_has_tag (&iter, tag) == (i < 100 && (i % 2 == 0 || i == 51)));
+
+      gtk_text_buffer_get_iter_at_line_index (buffer, &iter, 1, i + (i + 2) / 3);
+      g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 11 + i);
+      g_assert_cmpuint (gtk_text_iter_get_char (&iter), ==,
+                        i == 100 ? '\n' : (i % 3 ? 'a' : 0xdf));
+    }
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 112);
+  g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, 2);
+  g_assert_cmpint (gtk_text_iter_get_line_offset (&iter), ==, 0);
+
+  g_string_free (text, TRUE);
+  g_object_unref (buffer);
+}
+
+/* The table of segment offsets of a line, or NULL */
+static GtkTextLineOffsets *
+get_line_offsets (GtkTextBuffer *buffer,
+                  gint           line_number)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, line_number);
+
+  return _gtk_text_btree_get_line_offsets (&iter);
+}
+
+/* Tagging a line or moving the cursor must not throw away the segment
+ * offsets of other lines.
+ */
+static void
+test_line_offsets (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextIter start, end, iter;
+  GtkTextLineOffsets *offsets;
+  GString *text;
+  gint i, line;
+
+  buffer = gtk_text_buffer_new (NULL);
+  tag = gtk_text_buffer_create_tag (buffer, "tag", NULL);
+
+  text = g_string_new ("first line\n");
+  for (i = 0; i < 100; i++)
+    g_string_append_c (text, 'a');
+  g_string_append_c (text, '\n');
+  for (i = 0; i < 100; i++)
+    g_string_append_c (text, 'b');
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+
+  for (line = 1; line <= 2; line++)
+    for (i = 0; i < 100; i += 2)
+      {
+        gtk_text_buffer_get_iter_at_line_offset (buffer, &start, line, i);
+        end = start;
+        gtk_text_iter_forward_char (&end);
+        gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+      }
+
+  /* Walking to the end of the line builds the table */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 1, 99);
+  offsets = get_line_offsets (buffer, 1);
+  g_assert (offsets != NULL);
+
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 2, 51);
+  end = start;
+  gtk_text_iter_forward_char (&end);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+  gtk_text_buffer_place_cursor (buffer, &end);
+  g_assert (get_line_offsets (buffer, 1) == offsets);
+
+  for (i = 0; i <= 100; i++)
+    {
+      gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 1, i);
+      g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 11 + i);
+      g_assert_cmpuint (gtk_text_iter_get_char (&iter), ==, i == 100 ? '\n' : 'a');
+      g_assert (gtk_text_iter_has_tag (&iter, tag) == (i < 100 && i % 2 == 0));
+    }
+  g_assert (get_line_offsets (buffer, 1) == offsets);
+
+  /* Tagging the line itself changes its segments */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 1, 51);
+  end = start;
+  gtk_text_iter_forward_char (&end);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+  g_assert (get_line_offsets (buffer, 1) == NULL);
+
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 1, 99);
+  g_assert (get_line_offsets (buffer, 1) != NULL);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 1, 51);
+  g_assert (gtk_text_iter_has_tag (&iter, tag));
+
+  g_string_free (text, TRUE);
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1575,6 +1720,8 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Tag", test_tag);
   g_test_add_func ("/TextBuffer/Clipboard", test_clipboard);
   g_test_add_func ("/TextBuffer/Get iter", test_get_iter);
+  g_test_add_func ("/TextBuffer/Get iter in tagged line", test_get_iter_tagged);
+  g_test_add_func ("/TextBuffer/Line offsets", test_line_offsets);
 
   return g_test_run();
 }
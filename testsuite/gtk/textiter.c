@@ -279,6 +279,65 @@ test_search_caseless (void)
   check_found_backward ("aa \303\200", "aa", flags, 0, 2, "aa");
 }
 
+static void
+check_find_all (GtkTextBuffer     *buffer,
+                const gchar       *needle,
+                GtkTextSearchFlags flags,
+                const gint        *expected_starts,
+                guint              n_expected)
+{
+  GArray *matches;
+  guint i;
+
+  matches = gtk_text_buffer_find_all (buffer, needle, flags, NULL, NULL);
+  g_assert_cmpuint (matches->len, ==, 2 * n_expected);
+
+  for (i = 0; i < n_expected; i++)
+    g_assert_cmpint (gtk_text_iter_get_offset (&g_array_index (matches, GtkTextIter, 2 * i)),
+                     ==, expected_starts[i]);
+
+  g_array_unref (matches);
+}
+
+static void
+test_search_index (void)
+{
+  const gint foo_starts[] = { 0, 12, 24 };
+  const gint caseless_starts[] = { 0, 4, 12, 24 };
+  const gint baz_starts[] = { 16 };
+  const gint edited_starts[] = { 0, 12 };
+  const gint inserted_starts[] = { 20 };
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_enable_search_index (buffer, TRUE);
+  g_assert (gtk_text_buffer_get_enable_search_index (buffer));
+
+  gtk_text_buffer_set_text (buffer, "foo FOO bar\nfoo baz\nqux\nfoo\n", -1);
+
+  check_find_all (buffer, "foo", 0, foo_starts, G_N_ELEMENTS (foo_starts));
+  check_find_all (buffer, "foo", GTK_TEXT_SEARCH_CASE_INSENSITIVE,
+                  caseless_starts, G_N_ELEMENTS (caseless_starts));
+  check_find_all (buffer, "foo\nqux", 0, NULL, 0);
+  check_find_all (buffer, "baz\nqux", 0, baz_starts, G_N_ELEMENTS (baz_starts));
+
+  /* Edits must be seen by lines that were searched before */
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 24);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 27);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  check_find_all (buffer, "foo", 0, edited_starts, G_N_ELEMENTS (edited_starts));
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 21);
+  gtk_text_buffer_insert (buffer, &start, "foo", -1);
+  check_find_all (buffer, "qfoo", 0, inserted_starts, G_N_ELEMENTS (inserted_starts));
+
+  gtk_text_buffer_set_enable_search_index (buffer, FALSE);
+  check_find_all (buffer, "qfoo", 0, inserted_starts, G_N_ELEMENTS (inserted_starts));
+
+  g_object_unref (buffer);
+}
+
 static void
 test_forward_to_tag_toggle (void)
 {
@@ -789,6 +848,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextIter/Search Full Buffer", test_search_full_buffer);
   g_test_add_func ("/TextIter/Search", test_search);
   g_test_add_func ("/TextIter/Search Caseless", test_search_caseless);
+  g_test_add_func ("/TextIter/Search Index", test_search_index);
   g_test_add_func ("/TextIter/Forward To Tag Toggle", test_forward_to_tag_toggle);
   g_test_add_func ("/TextIter/Forward To Line End", test_forward_to_line_end);
   g_test_add_func ("/TextIter/Word Boundaries", test_word_boundaries);
@@ -29,6 +29,7 @@ main (int    argc,
 
   register_list_store_tests ();
   register_tree_store_tests ();
+  register_column_store_tests ();
   register_model_ref_count_tests ();
   register_sort_model_tests ();
   register_filter_model_tests ();
@@ -19,6 +19,7 @@
 
 void register_list_store_tests ();
 void register_tree_store_tests ();
+void register_column_store_tests ();
 void register_sort_model_tests ();
 void register_filter_model_tests ();
 void register_model_ref_count_tests ();
@@ -1015,6 +1015,70 @@ tree_store_test_iter_parent_invalid (TreeStore     *fixture,
   g_assert (iter.stamp == 0);
 }
 
+/* batched insertion */
+
+static void
+count_has_child_toggled (GtkTreeModel *model,
+                         GtkTreePath  *path,
+                         GtkTreeIter  *iter,
+                         gint         *count)
+{
+  (*count)++;
+}
+
+static void
+tree_store_test_insert_rows (TreeStore     *fixture,
+                             gconstpointer  user_data)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (fixture->store);
+  GValue values[4] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
+  gint columns[] = { 0 };
+  gint toggled = 0;
+  gint i, value;
+  GtkTreeIter iter;
+
+  for (i = 0; i < 4; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 10 + i);
+    }
+
+  g_signal_connect (model, "row-has-child-toggled",
+                    G_CALLBACK (count_has_child_toggled), &toggled);
+
+  /* First children of a row */
+  gtk_tree_store_insert_rows (fixture->store, &fixture->iter[1], -1, 2,
+                              columns, values, 1);
+  g_assert_cmpint (toggled, ==, 1);
+
+  /* More children in front of them, at the top level */
+  gtk_tree_store_insert_rows (fixture->store, &fixture->iter[1], 0, 2,
+                              columns, values + 2, 1);
+  gtk_tree_store_insert_rows (fixture->store, NULL, 3, 4,
+                              columns, values, 1);
+  g_assert_cmpint (toggled, ==, 1);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, &fixture->iter[1]), ==, 4);
+  for (i = 0; i < 4; i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (model, &iter, &fixture->iter[1], i));
+      gtk_tree_model_get (model, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, 10 + (i + 2) % 4);
+    }
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, 9);
+  for (i = 0; i < 4; i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, 3 + i));
+      gtk_tree_model_get (model, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, 10 + i);
+    }
+  g_assert (iter_position (fixture->store, &fixture->iter[3], 7));
+
+  for (i = 0; i < 4; i++)
+    g_value_unset (&values[i]);
+}
+
 /* specific bugs */
 static void
 specific_bug_77977 (void)
@@ -1199,6 +1263,11 @@ register_tree_store_tests (void)
               tree_store_setup, tree_store_test_iter_parent_invalid,
               tree_store_teardown);
 
+  /* batched insertion */
+  g_test_add ("/TreeStore/insert-rows", TreeStore, NULL,
+              tree_store_setup, tree_store_test_insert_rows,
+              tree_store_teardown);
+
   /* specific bugs */
   g_test_add_func ("/TreeStore/bug-77977", specific_bug_77977);
   g_test_add_func ("/TreeStore/bug-698396", specific_bug_698396);